@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <iostream>
 #include <numeric>
+#include <vector>
 
 extern "C" {
 #include "nonFree/sift/vl/sift.h"
@@ -155,7 +156,6 @@ public:
       vl_sift_set_peak_thresh(filt, 255*_params._peak_threshold/_params._num_scales);
 
     Descriptor<vl_sift_pix, 128> descr;
-    Descriptor<unsigned char, 128> descriptor;
 
     // Process SIFT computation
     vl_sift_process_first_octave(filt, If.data());
@@ -167,6 +167,11 @@ public:
     regions->Features().reserve(2000);
     regions->Descriptors().reserve(2000);
 
+    // Per keypoint results (up to 4 orientations) of the current octave
+    std::vector<int> orientation_counts;
+    std::vector<SIOPointFeature> octave_features;
+    std::vector<Descriptor<unsigned char, 128>> octave_descriptors;
+
     while (true) {
       vl_sift_detect(filt);
 
@@ -176,8 +181,14 @@ public:
       // Update gradient before launching parallel extraction
       vl_sift_update_gradient(filt);
 
+      orientation_counts.assign(nkeys, 0);
+      octave_features.resize(4 * nkeys);
+      octave_descriptors.resize(4 * nkeys);
+
+      // Each keypoint writes to its own slots: the regions order does not
+      // depend on the number of threads
       #ifdef OPENMVG_USE_OPENMP
-      #pragma omp parallel for private(descr, descriptor)
+      #pragma omp parallel for schedule(dynamic, 32) private(descr)
       #endif
       for (int i = 0; i < nkeys; ++i) {
 
@@ -198,17 +209,18 @@ public:
 
         for (int q=0 ; q < nangles ; ++q) {
           vl_sift_calc_keypoint_descriptor(filt, &descr[0], keys+i, angles[q]);
-          const SIOPointFeature fp(keys[i].x, keys[i].y,
+          octave_features[4 * i + q] = SIOPointFeature(keys[i].x, keys[i].y,
             keys[i].sigma, static_cast<float>(angles[q]));
+          siftDescToUChar(&descr[0], octave_descriptors[4 * i + q], _params._root_sift);
+        }
+        orientation_counts[i] = nangles;
+      }
 
-          siftDescToUChar(&descr[0], descriptor, _params._root_sift);
-          #ifdef OPENMVG_USE_OPENMP
-          #pragma omp critical
-          #endif
-          {
-            regions->Descriptors().push_back(descriptor);
-            regions->Features().push_back(fp);
-          }
+      // Collect the regions in the keypoint order
+      for (int i = 0; i < nkeys; ++i) {
+        for (int q = 0; q < orientation_counts[i]; ++q) {
+          regions->Features().push_back(octave_features[4 * i + q]);
+          regions->Descriptors().push_back(octave_descriptors[4 * i + q]);
         }
       }
       if (vl_sift_process_next_octave(filt))
@@ -216,6 +228,10 @@ public:
     }
     vl_sift_delete(filt);
 
+    // The detector response is not available: the budget ranks the regions by scale
+    if (feature_budget_ > 0)
+      regions->SelectSpatiallyUniform(w, h, feature_budget_);
+
     return regions;
   }
 
@@ -0,0 +1,96 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "nonFree/sift/SIFT_describer.hpp"
+#include "openMVG/image/image_io.hpp"
+
+#include "testing/testing.h"
+
+#include <string>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+
+static const std::string png_filename = std::string( THIS_SOURCE_DIR )
+  + "/../../openMVG_Samples/imageData/StanfordMobileVisualSearch/Ace_0.png";
+
+// Describe the image with the given number of threads
+std::unique_ptr<SIFT_Regions> DescribeWithThreads
+(
+  const Image<unsigned char> & image,
+  const Image<unsigned char> * mask,
+  const int nb_threads
+)
+{
+#ifdef OPENMVG_USE_OPENMP
+  const int max_threads = omp_get_max_threads();
+  omp_set_num_threads(nb_threads);
+#endif
+  SIFT_Image_describer describer;
+  std::unique_ptr<SIFT_Regions> regions = describer.DescribeSIFT(image, mask);
+#ifdef OPENMVG_USE_OPENMP
+  omp_set_num_threads(max_threads);
+#endif
+  return regions;
+}
+
+// Return true if two regions have the same features and descriptors, in the same order
+bool SameRegions(const SIFT_Regions & regions, const SIFT_Regions & other)
+{
+  if (regions.RegionCount() != other.RegionCount())
+    return false;
+  for (size_t i = 0; i < regions.RegionCount(); ++i)
+  {
+    const SIOPointFeature & feature = regions.Features()[i];
+    const SIOPointFeature & other_feature = other.Features()[i];
+    if (feature.x() != other_feature.x() || feature.y() != other_feature.y()
+        || feature.scale() != other_feature.scale()
+        || feature.orientation() != other_feature.orientation()
+        || !(regions.Descriptors()[i] == other.Descriptors()[i]))
+      return false;
+  }
+  return true;
+}
+
+TEST(SIFT_Image_describer, SameRegionsWithAnyThreadCount)
+{
+  Image<unsigned char> image;
+  EXPECT_TRUE(ReadImage(png_filename.c_str(), &image));
+
+  const std::unique_ptr<SIFT_Regions> regions = DescribeWithThreads(image, nullptr, 1);
+  EXPECT_TRUE(regions->RegionCount() > 100);
+  for (const int nb_threads : {2, 4, 7})
+  {
+    const std::unique_ptr<SIFT_Regions> regions_mt =
+      DescribeWithThreads(image, nullptr, nb_threads);
+    EXPECT_TRUE(SameRegions(*regions, *regions_mt));
+  }
+}
+
+TEST(SIFT_Image_describer, SameMaskedRegionsWithAnyThreadCount)
+{
+  Image<unsigned char> image;
+  EXPECT_TRUE(ReadImage(png_filename.c_str(), &image));
+
+  // Keep the regions of the left half of the image
+  Image<unsigned char> mask(image.Width(), image.Height(), true, 0);
+  mask.block(0, 0, image.Height(), image.Width() / 2).fill(255);
+
+  const std::unique_ptr<SIFT_Regions> regions = DescribeWithThreads(image, &mask, 1);
+  EXPECT_TRUE(regions->RegionCount() > 0);
+  for (const SIOPointFeature & feature : regions->Features())
+    EXPECT_TRUE(feature.x() < image.Width() / 2);
+  EXPECT_TRUE(SameRegions(*regions, *DescribeWithThreads(image, &mask, 4)));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
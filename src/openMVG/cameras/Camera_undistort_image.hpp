@@ -9,8 +9,10 @@
 #ifndef OPENMVG_CAMERAS_CAMERA_UNDISTORT_IMAGE_HPP
 #define OPENMVG_CAMERAS_CAMERA_UNDISTORT_IMAGE_HPP
 
+#include <cassert>
 #include <limits>
 #include <cmath>
+#include <vector>
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/image/image_container.hpp"
@@ -145,6 +147,99 @@ void UndistortImageResized(
 }
 
 
+/**
+* @brief Lookup table of the distorted position of each undistorted pixel.
+* Computed once per camera, it avoids evaluating the distortion model
+* for every pixel of every image that shares the camera.
+*/
+struct Undistortion_Map
+{
+  int width = 0;
+  int height = 0;
+  /// Distorted position (x, y) of each undistorted pixel (row major order).
+  /// The positions out of the image domain are marked by x = -1.
+  std::vector<Vec2f> disto_pix;
+
+  bool empty() const { return disto_pix.empty(); }
+};
+
+/**
+* @brief Compute the undistortion map of a camera for a given image size
+* @param cam Input intrinsic parameter used to undistort the images
+* @param width Width of the images to undistort
+* @param height Height of the images to undistort
+* @param[out] map The lookup table (empty if the camera has no distortion)
+*/
+inline void ComputeUndistortionMap(
+  const IntrinsicBase * cam,
+  const int width,
+  const int height,
+  Undistortion_Map & map )
+{
+  map.width = width;
+  map.height = height;
+  map.disto_pix.clear();
+  if ( !cam->have_disto() )
+    return;
+
+  map.disto_pix.resize( static_cast<size_t>( width ) * height );
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for ( int j = 0; j < height; ++j )
+    for ( int i = 0; i < width; ++i )
+    {
+      const Vec2 disto_pix = cam->get_d_pixel( Vec2( i, j ) );
+      // Same domain test as UndistortImage (Contains truncates the position),
+      // written to reject the NaN and infinite positions
+      const bool b_inside =
+        disto_pix( 0 ) > -1.0 && disto_pix( 0 ) < width &&
+        disto_pix( 1 ) > -1.0 && disto_pix( 1 ) < height;
+      map.disto_pix[ static_cast<size_t>( j ) * width + i ] =
+        b_inside ? disto_pix.cast<float>() : Vec2f( -1.f, -1.f );
+    }
+}
+
+/**
+* @brief  Undistort an image with a precomputed undistortion map
+* @param imageIn Input image (its size must be the map size)
+* @param map Undistortion map of the camera (see ComputeUndistortionMap)
+* @param[out] image_ud Output undistorted image
+* @param fillcolor color used to fill pixels where no input pixel is found
+* @note An empty map (camera without distortion) performs a direct copy
+*/
+template <typename Image>
+void UndistortImage(
+  const Image& imageIn,
+  const Undistortion_Map & map,
+  Image & image_ud,
+  typename Image::Tpixel fillcolor = typename Image::Tpixel( 0 ) )
+{
+  if ( map.empty() ) // no distortion, perform a direct copy
+  {
+    image_ud = imageIn;
+    return;
+  }
+  assert( imageIn.Width() == map.width && imageIn.Height() == map.height );
+
+  image_ud.resize( map.width, map.height, true, fillcolor );
+  const image::Sampler2d<image::SamplerLinear> sampler;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for ( int j = 0; j < map.height; ++j )
+  {
+    const Vec2f * disto_pix = &map.disto_pix[ static_cast<size_t>( j ) * map.width ];
+    for ( int i = 0; i < map.width; ++i )
+    {
+      if ( disto_pix[ i ]( 0 ) > -1.f )
+      {
+        image_ud( j, i ) = sampler( imageIn, disto_pix[ i ]( 1 ), disto_pix[ i ]( 0 ) );
+      }
+    }
+  }
+}
+
 } // namespace cameras
 } // namespace openMVG
 
@@ -8,7 +8,8 @@
 
 #include "openMVG/exif/exif_IO_EasyExif.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <cstdio>
 #include <limits>
 #include <sstream>
 #include <vector>
@@ -59,27 +60,95 @@ Exif_IO_EasyExif::Exif_IO_EasyExif( const std::string & sFileName ):
   open( sFileName );
 }
 
-bool Exif_IO_EasyExif::open( const std::string & sFileName )
+/**
+* Read the EXIF APP1 segment of a JPEG file.
+* Only the JPEG marker headers and the EXIF segment are read (bounded I/O):
+*  the scan stops at the EXIF segment or at the start of the compressed data.
+* @param fp opened file
+* @param[out] segment EXIF segment content (starting with "Exif\0\0")
+* @return true if an EXIF segment was found
+*/
+static bool ReadJpegExifSegment( FILE * fp, std::vector<unsigned char> & segment )
 {
-  // Read the file into a buffer
-  FILE *fp = fopen( sFileName.c_str(), "rb" );
-  if ( !fp )
+  unsigned char header[4];
+  // All JPEG files start with 0xFFD8
+  if ( fread( header, 1, 2, fp ) != 2 || header[0] != 0xFF || header[1] != 0xD8 )
   {
     return false;
   }
-  fseek( fp, 0, SEEK_END );
-  unsigned long fsize = ftell( fp );
-  rewind( fp );
-  std::vector<unsigned char> buf( fsize );
-  if ( fread( &buf[0], 1, fsize, fp ) != fsize )
+
+  while ( fread( header, 1, 2, fp ) == 2 )
+  {
+    if ( header[0] != 0xFF )
+    {
+      return false; // Not a marker, the stream is corrupted
+    }
+    const unsigned char marker = header[1];
+    if ( marker == 0xFF ) // Fill byte, the marker code is the next byte
+    {
+      fseek( fp, -1, SEEK_CUR );
+      continue;
+    }
+    if ( marker == 0xD8 || ( marker >= 0xD0 && marker <= 0xD7 ) || marker == 0x01 )
+    {
+      continue; // Markers without payload
+    }
+    if ( marker == 0xDA || marker == 0xD9 )
+    {
+      return false; // Start of scan or end of image: no more metadata
+    }
+    if ( fread( header + 2, 1, 2, fp ) != 2 )
+    {
+      return false;
+    }
+    // The segment length is stored in Motorola byte order and counts itself
+    const unsigned int segment_length = ( header[2] << 8 ) | header[3];
+    if ( segment_length < 2 )
+    {
+      return false;
+    }
+    const unsigned int payload_length = segment_length - 2;
+
+    static const unsigned char exif_header[6] = {'E', 'x', 'i', 'f', 0, 0};
+    if ( marker == 0xE1 && payload_length >= 14 ) // APP1 (EXIF or XMP)
+    {
+      segment.resize( payload_length );
+      if ( fread( &segment[0], 1, payload_length, fp ) != payload_length )
+      {
+        return false;
+      }
+      if ( std::equal( exif_header, exif_header + 6, segment.begin() ) )
+      {
+        return true;
+      }
+      continue; // APP1 XMP segment, keep looking for the EXIF one
+    }
+    if ( fseek( fp, payload_length, SEEK_CUR ) != 0 )
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool Exif_IO_EasyExif::open( const std::string & sFileName )
+{
+  bHaveExifInfo_ = false;
+  FILE *fp = fopen( sFileName.c_str(), "rb" );
+  if ( !fp )
   {
-    fclose( fp );
     return false;
   }
+  // Read only the EXIF segment (not the whole image file)
+  std::vector<unsigned char> segment;
+  const bool bHaveExifSegment = ReadJpegExifSegment( fp, segment );
   fclose( fp );
 
   // Parse EXIF
-  bHaveExifInfo_ = ( (*pimpl_).get().parseFrom( &buf[0], fsize ) == PARSE_EXIF_SUCCESS );
+  (*pimpl_).get().clear();
+  bHaveExifInfo_ = bHaveExifSegment &&
+    ( (*pimpl_).get().parseFromEXIFSegment(
+        &segment[0], static_cast<unsigned>( segment.size() ) ) == PARSE_EXIF_SUCCESS );
 
   return bHaveExifInfo_;
 }
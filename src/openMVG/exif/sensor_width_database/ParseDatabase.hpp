@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <fstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "openMVG/exif/sensor_width_database/datasheet.hpp"
@@ -76,4 +77,110 @@ bool getInfo
   return existInDatabase;
 }
 
+// Hashed index over a sensor width database.
+// It retrieves the same 'Datasheet' as getInfo (the first matching entry of the
+//  database) without a linear scan of the database for each query.
+// The database must outlive the index.
+class Datasheet_Index
+{
+public:
+  explicit Datasheet_Index
+  (
+    const std::vector<Datasheet>& vec_database
+  ):
+    vec_database_(vec_database)
+  {
+    for (size_t i = 0; i < vec_database_.size(); ++i)
+    {
+      const std::string db_model = lower_case(vec_database_[i].model_);
+      const std::string db_digit_substring = digit_substring(db_model);
+      // emplace keeps the first entry, as std::find does in getInfo
+      model_index_.emplace(db_model, i);
+      if (db_digit_substring.empty())
+        model_without_digit_index_.emplace(db_model, i);
+      else
+        digit_index_.emplace(maker(db_model) + ' ' + db_digit_substring, i);
+    }
+  }
+
+  // Retrieve camera 'Datasheet' information for the given camera model name
+  //  iff it is found in the database
+  bool getInfo
+  (
+    const std::string & sModel,
+    Datasheet& datasheetContent
+  ) const
+  {
+    const std::string model = lower_case(sModel);
+    const bool has_digit =
+      std::find_if(model.begin(), model.end(), isdigit) != model.end();
+
+    // See Datasheet::operator== for the matching rules
+    size_t best_index = vec_database_.size();
+    const auto update_best_index =
+      [&best_index](const std::unordered_map<std::string, size_t> & index, const std::string & key)
+    {
+      const auto it = index.find(key);
+      if (it != index.end())
+        best_index = std::min(best_index, it->second);
+    };
+    if (!has_digit)
+    {
+      update_best_index(model_index_, model);
+    }
+    else
+    {
+      update_best_index(model_without_digit_index_, model);
+      std::vector<std::string> vec_model;
+      stl::split(model, ' ', vec_model);
+      const std::string model_maker = maker(model);
+      for (const std::string & sub_model : vec_model)
+      {
+        if (std::find_if(sub_model.begin(), sub_model.end(), isdigit) != sub_model.end())
+          update_best_index(digit_index_, model_maker + ' ' + sub_model);
+      }
+    }
+
+    if (best_index == vec_database_.size())
+      return false;
+    datasheetContent = vec_database_[best_index];
+    return true;
+  }
+
+private:
+
+  static std::string lower_case(std::string model)
+  {
+    std::transform(model.begin(), model.end(), model.begin(), ::tolower);
+    return model;
+  }
+
+  // Camera maker substring [0->first space]
+  static std::string maker(const std::string & model)
+  {
+    return model.substr( 0, model.find( ' ' ) );
+  }
+
+  // First space separated substring that contains a digit
+  static std::string digit_substring(const std::string & model)
+  {
+    std::vector<std::string> vec_model;
+    stl::split(model, ' ', vec_model);
+    for (const std::string & sub_model : vec_model)
+    {
+      if ( std::find_if(sub_model.begin(), sub_model.end(), isdigit) != sub_model.end() )
+        return sub_model;
+    }
+    return "";
+  }
+
+  const std::vector<Datasheet>& vec_database_;
+  // lower case model -> first database index
+  std::unordered_map<std::string, size_t> model_index_;
+  // lower case model -> first database index of the entries without digit substring
+  std::unordered_map<std::string, size_t> model_without_digit_index_;
+  // "maker digit_substring" -> first database index
+  std::unordered_map<std::string, size_t> digit_index_;
+};
+
 #endif // OPENMVG_EXIF_SENSOR_WIDTH_PARSE_DATABASE_HPP
@@ -129,6 +129,36 @@ TEST(Matching, ParseDatabaseCanon_EOS_M)
   EXPECT_EQ( 22.3, datasheet.sensorSize_ );
 }
 
+TEST(Matching, ParseDatabaseIndex)
+{
+  std::vector<Datasheet> vec_database;
+  const std::string sfileDatabase = stlplus::create_filespec( std::string(THIS_SOURCE_DIR), sDatabase );
+  EXPECT_TRUE( parseDatabase( sfileDatabase, vec_database ) );
+
+  const Datasheet_Index database_index(vec_database);
+
+  // The hashed lookup must return the same datasheet as the linear lookup
+  std::vector<std::string> vec_model = {
+    "NotExistModel", "Canon EOS M", "Canon DIGITAL IXUS 70", "Canon EOS 1100D",
+    "Canon EOS 5D Mark II", "Canon EOS 550D", "Canon PowerShot A710 IS",
+    "KODAK Z612 ZOOM DIGITAL CAMERA", "Kodak EasyShare Z612", "CANON powershot SD900"};
+  // Sample some database entries (the linear lookup is slow)
+  for (size_t i = 0; i < vec_database.size(); i += 16)
+    vec_model.push_back(vec_database[i].model_);
+
+  for (const std::string & sModel : vec_model)
+  {
+    Datasheet datasheet_linear, datasheet_hashed;
+    const bool found_linear = getInfo( sModel, vec_database, datasheet_linear );
+    EXPECT_EQ( found_linear, database_index.getInfo( sModel, datasheet_hashed ) );
+    if (found_linear)
+    {
+      EXPECT_EQ( datasheet_linear.model_, datasheet_hashed.model_ );
+      EXPECT_EQ( datasheet_linear.sensorSize_, datasheet_hashed.sensorSize_ );
+    }
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
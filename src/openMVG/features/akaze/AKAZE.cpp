@@ -107,6 +107,129 @@ float AKAZE::ComputeAutomaticContrastFactor( const Image<float> & src , const fl
 
 const float fderivative_factor = 1.5f;      // Factor for the multiscale derivatives
 
+// Call functor(j, j_left, j_right) for every column j of a row, with
+// j_left = j - radius and j_right = j + radius mirrored inside the row.
+// The central columns are processed in a branch free loop.
+template <typename Functor>
+static inline void ForEachColumn( const int width , const int radius , Functor && functor )
+{
+  const int begin = std::min( radius , width );
+  const int end = std::max( begin , width - radius );
+  for (int j = 0; j < begin; ++j )
+    functor( j , MirrorIndex( j - radius , width ) , MirrorIndex( j + radius , width ) );
+  for (int j = begin; j < end; ++j )
+    functor( j , j - radius , j + radius );
+  for (int j = end; j < width; ++j )
+    functor( j , MirrorIndex( j - radius , width ) , MirrorIndex( j + radius , width ) );
+}
+
+// Scharr weights of the scaled derivative filters: the side and central
+// weights (1, w, 1) of the smoothing direction, normalized by 2 * scale * (w + 2)
+static inline void ScaledScharrWeights( const int scale , float & side , float & center )
+{
+  const double w = 10.0 / 3.0;
+  side = static_cast<float>( 1.0 / ( 2.0 * scale * ( w + 2.0 ) ) );
+  center = static_cast<float>( w / ( 2.0 * scale * ( w + 2.0 ) ) );
+}
+
+// Compute the first derivatives of an image scaled by the derivative scale:
+// ImageScaledScharrXDerivative and ImageScaledScharrYDerivative multiplied by
+// scale, computed in a single pass (in parallel over the rows) on the non zero
+// taps of the filters only.
+static void ComputeScaledDerivatives
+(
+  const Image<float> & src ,
+  const int scale ,
+  Image<float> & Lx ,
+  Image<float> & Ly
+)
+{
+  const int width = src.Width();
+  const int height = src.Height();
+  const Eigen::Index stride = width; // Row offsets as Eigen::Index
+  Lx.resize( width , height , false );
+  Ly.resize( width , height , false );
+
+  float side, center;
+  ScaledScharrWeights( scale , side , center );
+  side *= scale;
+  center *= scale;
+
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; ++i )
+  {
+    const float * up = src.data() + MirrorIndex( i - scale , height ) * stride;
+    const float * row = src.data() + i * stride;
+    const float * down = src.data() + MirrorIndex( i + scale , height ) * stride;
+    float * lx = Lx.data() + i * stride;
+    float * ly = Ly.data() + i * stride;
+
+    ForEachColumn( width , scale , [&]( const int j , const int j_left , const int j_right )
+    {
+      lx[ j ] = side * ( up[ j_right ] - up[ j_left ] )
+              + center * ( row[ j_right ] - row[ j_left ] )
+              + side * ( down[ j_right ] - down[ j_left ] );
+      ly[ j ] = side * ( down[ j_left ] - up[ j_left ] )
+              + center * ( down[ j ] - up[ j ] )
+              + side * ( down[ j_right ] - up[ j_right ] );
+    } );
+  }
+}
+
+// Compute the scale normalized determinant of the Hessian from the scaled first
+// derivatives (see ComputeScaledDerivatives). The second derivatives are
+// computed on the fly with the scaled Scharr filters, so Lxx, Lxy and Lyy
+// are never stored.
+static void ComputeHessianDeterminant
+(
+  const Image<float> & Lx ,
+  const Image<float> & Ly ,
+  const int scale ,
+  Image<float> & Lhess
+)
+{
+  const int width = Lx.Width();
+  const int height = Lx.Height();
+  const Eigen::Index stride = width; // Row offsets as Eigen::Index
+  Lhess.resize( width , height , false );
+
+  float side, center;
+  ScaledScharrWeights( scale , side , center );
+  // Lx & Ly are already scaled: the scale^4 normalization reduces to scale^2
+  const float sigma_size_quad = static_cast<float>( Square( scale ) );
+
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; ++i )
+  {
+    const Eigen::Index up = MirrorIndex( i - scale , height ) * stride;
+    const Eigen::Index down = MirrorIndex( i + scale , height ) * stride;
+    const float * lx_up = Lx.data() + up;
+    const float * lx_row = Lx.data() + i * stride;
+    const float * lx_down = Lx.data() + down;
+    const float * ly_up = Ly.data() + up;
+    const float * ly_down = Ly.data() + down;
+    float * det = Lhess.data() + i * stride;
+
+    ForEachColumn( width , scale , [&]( const int j , const int j_left , const int j_right )
+    {
+      const float Lxx = side * ( lx_up[ j_right ] - lx_up[ j_left ] )
+                      + center * ( lx_row[ j_right ] - lx_row[ j_left ] )
+                      + side * ( lx_down[ j_right ] - lx_down[ j_left ] );
+      const float Lxy = side * ( lx_down[ j_left ] - lx_up[ j_left ] )
+                      + center * ( lx_down[ j ] - lx_up[ j ] )
+                      + side * ( lx_down[ j_right ] - lx_up[ j_right ] );
+      const float Lyy = side * ( ly_down[ j_left ] - ly_up[ j_left ] )
+                      + center * ( ly_down[ j ] - ly_up[ j ] )
+                      + side * ( ly_down[ j_right ] - ly_up[ j_right ] );
+      det[ j ] = ( Lxx * Lyy - Lxy * Lxy ) * sigma_size_quad;
+    } );
+  }
+}
+
 void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const int q , const int nbSlice ,
                         const float sigma0 , // first octave initial scale
                         const float contrast_factor ,
@@ -119,7 +242,9 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
   const float ratio = 1 << p; //pow(2,p);
   const int sigma_scale = std::round(sigma_cur * fderivative_factor / ratio);
 
-  Image<float> smoothed;
+  // Lx, Ly & Lhess are used as working memory until the computation of the
+  // slice derivatives, so no temporary image is allocated if the slice images
+  // are recycled from a previous scale space.
   if (p == 0 && q == 0 )
   {
     // Compute new image
@@ -128,12 +253,11 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
   else
   {
     // general case
-    Image<float> in;
     if (q == 0 )  {
-      ImageHalfSample( src , in );
+      ImageHalfSample( src , Li );
     }
     else {
-      in = src;
+      Li = src;
     }
 
     const float sigma_prev = ( q == 0 ) ? Sigma( sigma0 , p - 1 , nbSlice - 1 , nbSlice ) : Sigma( sigma0 , p , q - 1 , nbSlice );
@@ -143,51 +267,32 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
     const float t_cur  = 0.5f * ( sigma_cur * sigma_cur );
     const float total_cycle_time = t_cur - t_prev;
 
-    // Compute first derivatives (Scharr scale 1, non normalized) for diffusion coef
-    ImageGaussianFilter( in , 1.f , smoothed, 0, 0 );
-
-    ImageScharrXDerivative( smoothed , Lx , false );
-    ImageScharrYDerivative( smoothed , Ly , false );
-
-    // Compute diffusion coefficient
-    Image<float> & diff = smoothed; // diffusivity image (reuse existing memory)
-    ImagePeronaMalikG2DiffusionCoef( Lx , Ly , contrast_factor , diff );
+    // Compute diffusion coefficient from the first derivatives (Scharr scale 1, non normalized)
+    Image<float> & smoothed = Lhess;
+    Image<float> & diff = Lx;
+    ImageGaussianFilter( Li , 1.f , smoothed, 0, 0 );
+    ImageScharrPeronaMalikG2DiffusionCoef( smoothed , contrast_factor , diff );
 
     // Compute FED cycles
     std::vector<float> tau;
     FEDCycleTimings( total_cycle_time , 0.25f , tau );
-    ImageFEDCycle( in , diff , tau );
-    Li = in; // evolution image
+    ImageFEDCycle( Li , diff , tau , Ly ); // evolution image
   }
 
   // Compute Hessian response
-  if (p == 0 && q == 0 )
-  {
-    smoothed = Li;
-  }
-  else
+  const Image<float> * smoothed = &Li;
+  if (p != 0 || q != 0 )
   {
     // Add a little smooth to image (for robustness of Scharr derivatives)
-    ImageGaussianFilter( Li , 1.f , smoothed, 0, 0 );
+    ImageGaussianFilter( Li , 1.f , Lhess, 0, 0 );
+    smoothed = &Lhess;
   }
 
   // Compute true first derivatives
-  ImageScaledScharrXDerivative( smoothed , Lx , sigma_scale );
-  ImageScaledScharrYDerivative( smoothed , Ly , sigma_scale );
-
-  // Second order spatial derivatives
-  Image<float> Lxx, Lyy, Lxy;
-  ImageScaledScharrXDerivative( Lx , Lxx , sigma_scale );
-  ImageScaledScharrYDerivative( Lx , Lxy , sigma_scale );
-  ImageScaledScharrYDerivative( Ly , Lyy , sigma_scale );
-
-  Lx *= static_cast<float>( sigma_scale );
-  Ly *= static_cast<float>( sigma_scale );
-
-  // Compute Determinant of the Hessian
-  Lhess.resize(Li.Width(), Li.Height());
-  const float sigma_size_quad = Square(sigma_scale) * Square(sigma_scale);
-  Lhess.array() = (Lxx.array()*Lyy.array()-Lxy.array().square())*sigma_size_quad;
+  ComputeScaledDerivatives( *smoothed , sigma_scale , Lx , Ly );
+
+  // Compute Determinant of the Hessian (smoothed is no longer used)
+  ComputeHessianDeterminant( Lx , Ly , sigma_scale , Lhess );
 }
 
 template <typename Image>
@@ -202,8 +307,9 @@ void convert_scale(Image &src)
 AKAZE::AKAZE
 (
   const Image<unsigned char> & in,
-  const AKAZE::Params & options
-):options_(options)
+  const AKAZE::Params & options,
+  std::vector<TEvolution> && evolution
+):options_(options), evolution_(std::move(evolution))
 {
   if (in.size() > 0)
   {
@@ -216,15 +322,38 @@ AKAZE::AKAZE
   }
 }
 
+float AKAZE::ComputeContrastFactor( const Image<unsigned char> & in )
+{
+  if (in.size() == 0)
+    return 0.f;
+  return ComputeAutomaticContrastFactor( Image<float>( in.GetMat().cast<float>() / 255.f ), 0.7f );
+}
+
+float AKAZE::SupportRadius( const Params & options )
+{
+  const float sigma_max = Sigma( options.fSigma0 , options.iNbOctave - 1 ,
+    options.iNbSlicePerOctave - 1 , options.iNbSlicePerOctave );
+  // Descriptor support of the coarsest keypoints (as the detection border),
+  // plus the extent of their diffusion
+  const float desc_factor = std::max( 6.f * sqrtf( 2.f ) , options.fDesc_factor );
+  return desc_factor * sigma_max * fderivative_factor + 3.f * sigma_max;
+}
+
 /// Compute the AKAZE non linear diffusion scale space per slice
 void AKAZE::Compute_AKAZEScaleSpace()
 {
   if (in_.size() == 0)
+  {
+    evolution_.clear();
     return;
+  }
 
-  float contrast_factor = ComputeAutomaticContrastFactor( in_, 0.7f );
+  float contrast_factor = (options_.fContrast_factor > 0.f)
+    ? options_.fContrast_factor
+    : ComputeAutomaticContrastFactor( in_, 0.7f );
 
-  Image<float> input = in_;
+  // Reuse the existing slices (their memory is kept if the image size is unchanged)
+  evolution_.resize(options_.iNbOctave * options_.iNbSlicePerOctave);
 
   // Octave computation
   for (int p = 0; p < options_.iNbOctave; ++p )
@@ -233,15 +362,14 @@ void AKAZE::Compute_AKAZEScaleSpace()
 
     for (int q = 0; q < options_.iNbSlicePerOctave; ++q )
     {
-      evolution_.emplace_back(TEvolution());
-      TEvolution & evo = evolution_.back();
+      const int slice_id = p * options_.iNbSlicePerOctave + q;
+      TEvolution & evo = evolution_[slice_id];
+      // The slice is computed from the previous one
+      const Image<float> & input = (slice_id == 0) ? in_ : evolution_[slice_id - 1].cur;
       // Compute Slice at (p,q) index
       ComputeAKAZESlice( input , p , q , options_.iNbSlicePerOctave , options_.fSigma0 , contrast_factor,
         evo.cur , evo.Lx , evo.Ly , evo.Lhess );
 
-      // Prepare inputs for next slice
-      input = evo.cur;
-
       // DEBUG octave image
 #if DEBUG_OCTAVE
       std::stringstream str;
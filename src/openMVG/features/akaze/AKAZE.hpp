@@ -34,6 +34,7 @@
 //  TrueVision Solutions (2)
 //------
 
+#include <utility>
 #include <vector>
 
 #include "openMVG/image/image_container.hpp"
@@ -80,7 +81,8 @@ public:
       iNbSlicePerOctave(4),
       fSigma0(1.6f),
       fThreshold(0.0008f),
-      fDesc_factor(1.f)
+      fDesc_factor(1.f),
+      fContrast_factor(0.f)
     {
     }
 
@@ -92,6 +94,10 @@ public:
     float fSigma0; ///< Initial sigma offset (used to suppress low level noise)
     float fThreshold;  ///< Hessian determinant threshold
     float fDesc_factor;   ///< Magnifier used to describe an interest point
+    /// Contrast factor of the diffusion (<= 0: computed from the image).
+    /// It is given to describe a part of an image as the whole image
+    /// (not serialized, it depends on the image).
+    float fContrast_factor;
   };
 
 private:
@@ -103,7 +109,12 @@ private:
 public:
 
   /// Constructor
-  AKAZE(const image::Image<unsigned char> & in, const Params & options);
+  /// @param evolution Slices of a previous scale space, recycled to avoid
+  ///  the reallocation of the scale space images (see Release_Slices)
+  AKAZE(
+    const image::Image<unsigned char> & in,
+    const Params & options,
+    std::vector<TEvolution> && evolution = std::vector<TEvolution>());
 
   /// Compute the AKAZE non linear diffusion scale space per slice
   void Compute_AKAZEScaleSpace();
@@ -120,6 +131,16 @@ public:
   /// Scale Space accessor
   const std::vector<TEvolution> & getSlices() const {return evolution_;}
 
+  /// Give back the scale space slices (in order to recycle them for another image)
+  std::vector<TEvolution> Release_Slices() {return std::move(evolution_);}
+
+  /// Contrast factor of the diffusion computed from an image
+  static float ComputeContrastFactor(const image::Image<unsigned char> & in);
+
+  /// Radius (in pixels) of the image area used to detect and describe the
+  /// keypoints of the coarsest slice
+  static float SupportRadius(const Params & options);
+
   /**
    * @brief This method computes the main orientation for a given keypoint
    * @param kpt Input keypoint
@@ -28,6 +28,45 @@ TEST( AKAZE , EmptyImage )
   EXPECT_TRUE(keypoints.empty());
 }
 
+TEST( AKAZE , RecycledScaleSpace )
+{
+  Image<unsigned char> image_in;
+  EXPECT_TRUE( ReadImage( png_filename.c_str(), &image_in ) );
+
+  AKAZE akaze_extractor(image_in, AKAZE::Params());
+  akaze_extractor.Compute_AKAZEScaleSpace();
+  std::vector<AKAZEKeypoint> keypoints;
+  akaze_extractor.Feature_Detection(keypoints);
+  EXPECT_TRUE(!keypoints.empty());
+
+  // Recycle the slices of a smaller image and then of the same image:
+  // the scale space must be the same as the one computed from scratch.
+  const Image<unsigned char> image_crop(image_in.block(0, 0, image_in.Height() / 2, image_in.Width() / 3));
+  AKAZE akaze_crop(image_crop, AKAZE::Params());
+  akaze_crop.Compute_AKAZEScaleSpace();
+  std::vector<TEvolution> recycled = akaze_crop.Release_Slices();
+  for (int i = 0; i < 2; ++i)
+  {
+    AKAZE akaze_recycled(image_in, AKAZE::Params(), std::move(recycled));
+    akaze_recycled.Compute_AKAZEScaleSpace();
+
+    const std::vector<TEvolution> & slices = akaze_extractor.getSlices();
+    const std::vector<TEvolution> & recycled_slices = akaze_recycled.getSlices();
+    EXPECT_EQ(slices.size(), recycled_slices.size());
+    for (size_t k = 0; k < slices.size(); ++k)
+    {
+      EXPECT_TRUE(slices[k].cur == recycled_slices[k].cur);
+      EXPECT_TRUE(slices[k].Lhess == recycled_slices[k].Lhess);
+    }
+
+    std::vector<AKAZEKeypoint> recycled_keypoints;
+    akaze_recycled.Feature_Detection(recycled_keypoints);
+    EXPECT_EQ(keypoints.size(), recycled_keypoints.size());
+
+    recycled = akaze_recycled.Release_Slices();
+  }
+}
+
 TEST( AKAZE , AkazeImageDescriberSurf )
 {
   Image<unsigned char> image_in;
@@ -35,7 +74,13 @@ TEST( AKAZE , AkazeImageDescriberSurf )
 
   AKAZE_Image_describer_SURF extractor;
   EXPECT_TRUE(extractor.Describe(Image<unsigned char>{})->RegionCount() == 0);
-  EXPECT_TRUE(extractor.Describe(image_in)->RegionCount() > 0);
+  const size_t region_count = extractor.Describe(image_in)->RegionCount();
+  EXPECT_TRUE(region_count > 0);
+
+  // Same regions with a recycled and with a freed scale space
+  EXPECT_EQ(region_count, extractor.Describe(image_in)->RegionCount());
+  extractor.Clear_scale_space_pool();
+  EXPECT_EQ(region_count, extractor.Describe(image_in)->RegionCount());
 }
 
 TEST( AKAZE , AkazeImageDescriberLiop )
@@ -10,6 +10,8 @@
 #include "openMVG/features/akaze/msurf_descriptor.hpp"
 #include "openMVG/features/liop/liop_descriptor.hpp"
 
+#include <cmath>
+
 namespace openMVG {
 namespace features {
 
@@ -25,9 +27,7 @@ AKAZE_Image_describer_SURF::Describe_AKAZE_SURF
   if (image.size() == 0)
     return regions;
 
-  params_.options_.fDesc_factor = GetfDescFactor();
-
-  AKAZE akaze(image, params_.options_);
+  AKAZE akaze(image, Describe_options(), scale_space_pool_.Acquire());
   akaze.Compute_AKAZEScaleSpace();
   std::vector<AKAZEKeypoint> kpts;
   kpts.reserve(5000);
@@ -44,6 +44,11 @@ AKAZE_Image_describer_SURF::Describe_AKAZE_SURF
                             }),
              kpts.end());
 
+  // Keep the strongest keypoints spread over the image (if there is a budget)
+  Select_keypoints_within_budget(kpts, image.Width(), image.Height(),
+    [](const AKAZEKeypoint & pt) { return Vec2f(pt.x, pt.y); },
+    [](const AKAZEKeypoint & pt) { return pt.response; });
+
   regions->Features().resize(kpts.size());
   regions->Descriptors().resize(kpts.size());
 
@@ -67,6 +72,7 @@ AKAZE_Image_describer_SURF::Describe_AKAZE_SURF
       regions->Features()[i],
       regions->Descriptors()[i]);
   }
+  scale_space_pool_.Release(akaze.Release_Slices());
   return regions;
 }
 
@@ -82,9 +88,7 @@ AKAZE_Image_describer_LIOP::Describe_AKAZE_LIOP
   if (image.size() == 0)
     return regions;
 
-  params_.options_.fDesc_factor = GetfDescFactor();
-
-  AKAZE akaze(image, params_.options_);
+  AKAZE akaze(image, Describe_options(), scale_space_pool_.Acquire());
   akaze.Compute_AKAZEScaleSpace();
   std::vector<AKAZEKeypoint> kpts;
   kpts.reserve(5000);
@@ -101,6 +105,11 @@ AKAZE_Image_describer_LIOP::Describe_AKAZE_LIOP
                             }),
              kpts.end());
 
+  // Keep the strongest keypoints spread over the image (if there is a budget)
+  Select_keypoints_within_budget(kpts, image.Width(), image.Height(),
+    [](const AKAZEKeypoint & pt) { return Vec2f(pt.x, pt.y); },
+    [](const AKAZEKeypoint & pt) { return pt.response; });
+
   regions->Features().resize(kpts.size());
   regions->Descriptors().resize(kpts.size());
 
@@ -135,6 +144,7 @@ AKAZE_Image_describer_LIOP::Describe_AKAZE_LIOP
       regions->Descriptors()[i][j] =
         static_cast<unsigned char>(desc[j]*255.f+.5f);
   }
+  scale_space_pool_.Release(akaze.Release_Slices());
   return regions;
 }
 
@@ -150,9 +160,7 @@ AKAZE_Image_describer_MLDB::Describe_AKAZE_MLDB
   if (image.size() == 0)
     return regions;
 
-  params_.options_.fDesc_factor = GetfDescFactor();
-
-  AKAZE akaze(image, params_.options_);
+  AKAZE akaze(image, Describe_options(), scale_space_pool_.Acquire());
   akaze.Compute_AKAZEScaleSpace();
   std::vector<AKAZEKeypoint> kpts;
   kpts.reserve(5000);
@@ -169,6 +177,11 @@ AKAZE_Image_describer_MLDB::Describe_AKAZE_MLDB
                             }),
              kpts.end());
 
+  // Keep the strongest keypoints spread over the image (if there is a budget)
+  Select_keypoints_within_budget(kpts, image.Width(), image.Height(),
+    [](const AKAZEKeypoint & pt) { return Vec2f(pt.x, pt.y); },
+    [](const AKAZEKeypoint & pt) { return pt.response; });
+
   regions->Features().resize(kpts.size());
   regions->Descriptors().resize(kpts.size());
 
@@ -205,10 +218,35 @@ AKAZE_Image_describer_MLDB::Describe_AKAZE_MLDB
       }
     }
   }
+  scale_space_pool_.Release(akaze.Release_Slices());
   return regions;
 }
 
 // static
+std::vector<float> AKAZE_Image_describer::Compute_image_statistics
+(
+  const image::Image<unsigned char> & image
+) const
+{
+  return {AKAZE::ComputeContrastFactor(image)};
+}
+
+int AKAZE_Image_describer::Region_support_radius() const
+{
+  return static_cast<int>(std::ceil(AKAZE::SupportRadius(Describe_options())));
+}
+
+AKAZE::Params AKAZE_Image_describer::Describe_options() const
+{
+  AKAZE::Params options = params_.options_;
+  options.fDesc_factor = GetfDescFactor();
+  // A part of an image is described with the contrast of the whole image
+  const std::vector<float> & image_statistics = Current_image_statistics();
+  if (!image_statistics.empty())
+    options.fContrast_factor = image_statistics[0];
+  return options;
+}
+
 std::unique_ptr<AKAZE_Image_describer> AKAZE_Image_describer::create
 (
   const AKAZE_Image_describer::Params& params,
@@ -13,7 +13,10 @@
 #include "openMVG/features/regions_factory.hpp"
 #include "openMVG/system/logger.hpp"
 
+#include <algorithm>
+#include <mutex>
 #include <numeric>
+#include <thread>
 
 namespace openMVG {
 namespace features {
@@ -75,14 +78,79 @@ public:
   template<class Archive>
   void serialize(Archive & ar);
 
+  /// Free the scale spaces kept for the next Describe calls.
+  /// Until then, the describer holds up to one scale space per hardware
+  /// thread, each one taking about 85 bytes per pixel of the largest image
+  /// described with the default parameters (2 GB for a 24 MP image).
+  void Clear_scale_space_pool() { scale_space_pool_.Clear(); }
+
+  /// The contrast factor of the diffusion, computed on the whole image
+  std::vector<float> Compute_image_statistics
+  (
+    const image::Image<unsigned char> & image
+  ) const override;
+
+  /// Support of the coarsest slice keypoints
+  int Region_support_radius() const override;
+
 protected:
   virtual float GetfDescFactor() const
   {
     return 10.f*sqrtf(2.f);
   }
 
+  /// AKAZE options of a Describe call
+  AKAZE::Params Describe_options() const;
+
   Params params_;
   bool bOrientation_;
+
+  /// Scale spaces recycled from one Describe call to the next one: the pyramid
+  /// images are allocated once per concurrent call instead of once per image.
+  /// At most one scale space per hardware thread is kept, the extra ones
+  /// are freed. They are kept for the describer lifetime, unless
+  /// Clear_scale_space_pool is called.
+  class Scale_space_pool
+  {
+  public:
+    Scale_space_pool() = default;
+    // The recycled memory is not shared between describer copies
+    Scale_space_pool(const Scale_space_pool &) {}
+    Scale_space_pool & operator=(const Scale_space_pool &) { return *this; }
+
+    /// Return a free scale space (empty if none is available)
+    std::vector<TEvolution> Acquire()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (free_slices_.empty())
+        return {};
+      std::vector<TEvolution> slices = std::move(free_slices_.back());
+      free_slices_.pop_back();
+      return slices;
+    }
+
+    /// Give back a scale space, to be recycled by a next call
+    void Release(std::vector<TEvolution> && slices)
+    {
+      const size_t max_pool_size =
+        std::max(1u, std::thread::hardware_concurrency());
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (free_slices_.size() < max_pool_size)
+        free_slices_.emplace_back(std::move(slices));
+    }
+
+    /// Free the recycled scale spaces
+    void Clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_slices_.clear();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<std::vector<TEvolution>> free_slices_;
+  };
+  Scale_space_pool scale_space_pool_;
 };
 
 class AKAZE_Image_describer_SURF : public AKAZE_Image_describer
@@ -14,6 +14,7 @@
 #include "openMVG/features/descriptor.hpp"
 #include "openMVG/features/regions.hpp"
 #include "openMVG/features/regions_scale_sort.hpp"
+#include "openMVG/features/regions_spatial_selection.hpp"
 #include "openMVG/matching/metric.hpp"
 
 namespace openMVG {
@@ -127,11 +128,22 @@ public:
     static_cast<Binary_Regions<FeatT, L> *>(region_container)->vec_descs_.push_back(vec_descs_[i]);
   }
 
+  void Translate(const Vec2f & offset) override
+  {
+    for (auto & feat : vec_feats_)
+      feat.coords() += offset;
+  }
+
   bool SortAndSelectByRegionScale(int keep_count = -1) override
   {
     return features::SortAndSelectByRegionScale<FeatT, DescsT>(vec_feats_, vec_descs_, keep_count);
   }
 
+  bool SelectSpatiallyUniform(int width, int height, size_t keep_count) override
+  {
+    return features::SelectSpatiallyUniformRegions(vec_feats_, vec_descs_, width, height, keep_count);
+  }
+
 private:
   //--
   //-- internal data
@@ -39,15 +39,29 @@ void FastCornerDetector::detect
   const image::Image<unsigned char> & ima,
   std::vector<PointFeature> & regions
 )
+{
+  std::vector<int> scores;
+  detect(ima, regions, scores);
+}
+
+void FastCornerDetector::detect
+(
+  const image::Image<unsigned char> & ima,
+  std::vector<PointFeature> & regions,
+  std::vector<int> & scores
+)
 {
   using FastDetectorCall =
     xy* (*) (const unsigned char *, int, int, int, int, int *);
+  using FastScoreCall =
+    int* (*) (const unsigned char *, int, xy *, int, int);
 
   FastDetectorCall detector = nullptr;
-  if (size_ ==  9) detector =  fast9_detect_nonmax;
-  if (size_ == 10) detector = fast10_detect_nonmax;
-  if (size_ == 11) detector = fast11_detect_nonmax;
-  if (size_ == 12) detector = fast12_detect_nonmax;
+  FastScoreCall scorer = nullptr;
+  if (size_ ==  9) { detector =  fast9_detect_nonmax; scorer =  fast9_score; }
+  if (size_ == 10) { detector = fast10_detect_nonmax; scorer = fast10_score; }
+  if (size_ == 11) { detector = fast11_detect_nonmax; scorer = fast11_score; }
+  if (size_ == 12) { detector = fast12_detect_nonmax; scorer = fast12_score; }
   if (!detector)
   {
     OPENMVG_LOG_ERROR << "Invalid size for FAST detector: " << size_;
@@ -64,6 +78,9 @@ void FastCornerDetector::detect
   {
     regions.emplace_back(detections[i].x, detections[i].y);
   }
+  int* corner_scores = scorer(ima.data(), ima.Width(), detections, num_corners, threshold_);
+  scores.assign(corner_scores, corner_scores + num_corners);
+  free( corner_scores );
   free( detections );
 }
 
@@ -52,6 +52,17 @@ public:
     const image::Image<unsigned char> & ima,
     std::vector<PointFeature> & regions
   );
+
+  /**
+   * Detect the corners and return their FAST score
+   * (the highest barrier for which the point is still a corner).
+  **/
+  void detect
+  (
+    const image::Image<unsigned char> & ima,
+    std::vector<PointFeature> & regions,
+    std::vector<int> & scores
+  );
 };
 
 } // namespace features
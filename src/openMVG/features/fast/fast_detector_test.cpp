@@ -0,0 +1,108 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/fast/fast_detector.hpp"
+#include "openMVG/image/image_container.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+
+// Random squares of various intensities on a gray background
+static Image<unsigned char> SquaresImage(const int width, const int height)
+{
+  Image<unsigned char> image(width, height, true, 128);
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> x_dist(0, width - 1), y_dist(0, height - 1);
+  std::uniform_int_distribution<int> size_dist(4, 12), color_dist(0, 255);
+  for (int i = 0; i < 60; ++i)
+  {
+    const int x0 = x_dist(rng), y0 = y_dist(rng), size = size_dist(rng);
+    const unsigned char color = static_cast<unsigned char>(color_dist(rng));
+    for (int y = y0; y < std::min(height, y0 + size); ++y)
+      for (int x = x0; x < std::min(width, x0 + size); ++x)
+        image(y, x) = color;
+  }
+  return image;
+}
+
+// Reference FAST test [1]: are there at least arc_length contiguous pixels
+// of the 16 pixels circle that are all brighter than p + barrier or all
+// darker than p - barrier?
+static bool IsFastCorner
+(
+  const Image<unsigned char> & image,
+  const int x,
+  const int y,
+  const int barrier,
+  const int arc_length
+)
+{
+  static const int circle[16][2] = {
+    {0, 3}, {1, 3}, {2, 2}, {3, 1}, {3, 0}, {3, -1}, {2, -2}, {1, -3},
+    {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3, 1}, {-2, 2}, {-1, 3}};
+  const int p = image(y, x);
+  for (const int sign : {1, -1})
+  {
+    int run = 0;
+    // Go twice around the circle to handle the arcs crossing the start
+    for (int i = 0; i < 32; ++i)
+    {
+      const int value = image(y + circle[i % 16][1], x + circle[i % 16][0]);
+      run = (sign * (value - p) > barrier) ? run + 1 : 0;
+      if (run >= arc_length)
+        return true;
+    }
+  }
+  return false;
+}
+
+TEST(FastCornerDetector, Scores)
+{
+  const Image<unsigned char> image = SquaresImage(160, 120);
+  const int barrier = 20;
+  FastCornerDetector detector(9, barrier);
+
+  std::vector<PointFeature> corners, scored_corners;
+  std::vector<int> scores;
+  detector.detect(image, corners);
+  detector.detect(image, scored_corners, scores);
+  EXPECT_TRUE(!corners.empty());
+
+  // The same corners are returned with a score for each of them
+  CHECK_EQUAL(corners.size(), scored_corners.size());
+  CHECK_EQUAL(corners.size(), scores.size());
+  for (size_t i = 0; i < corners.size(); ++i)
+  {
+    EXPECT_EQ(corners[i].coords(), scored_corners[i].coords());
+
+    // The score is the highest barrier for which the point is a corner
+    const int x = static_cast<int>(corners[i].x()), y = static_cast<int>(corners[i].y());
+    EXPECT_TRUE(scores[i] >= barrier);
+    EXPECT_TRUE(IsFastCorner(image, x, y, scores[i], 9));
+    EXPECT_FALSE(IsFastCorner(image, x, y, scores[i] + 1, 9));
+  }
+}
+
+TEST(FastCornerDetector, Scores_Empty)
+{
+  // A flat image has no corner, and so no score
+  const Image<unsigned char> image(64, 64, true, 100);
+  FastCornerDetector detector(9, 10);
+  std::vector<PointFeature> corners(1);
+  std::vector<int> scores(1);
+  detector.detect(image, corners, scores);
+  EXPECT_TRUE(corners.empty());
+  EXPECT_TRUE(scores.empty());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -9,10 +9,13 @@
 #ifndef OPENMVG_FEATURES_IMAGE_DESCRIBER_HPP
 #define OPENMVG_FEATURES_IMAGE_DESCRIBER_HPP
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "openMVG/features/regions.hpp"
+#include "openMVG/features/regions_spatial_selection.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
 namespace openMVG { namespace image { template<typename Type> class Image; } }
@@ -43,6 +46,134 @@ public:
     EDESCRIBER_PRESET preset
   ) = 0;
 
+  /**
+  @brief Set a per image budget of regions: Describe keeps at most max_count
+    regions, spread uniformly over the image (see SelectSpatiallyUniform).
+    The regions are ranked by their detector response when the describer
+    provides it, else by their scale.
+  @param max_count Maximal number of regions per image (0 means no limit)
+  */
+  void Set_feature_budget(size_t max_count)
+  {
+    feature_budget_ = max_count;
+  }
+
+  /// Return the per image budget of regions (0 means no limit)
+  size_t Feature_budget() const
+  {
+    return feature_budget_;
+  }
+
+  /**
+  @brief Budget of the Describe calls made by the current thread on a part
+    of an image (e.g. a tile, see DescribeTiled): the regions detected
+    outside of the given area are dropped and at most max_count regions are
+    kept in the area. It replaces the per image budget of the describers
+    that rank the keypoints by their detector response, until the object is
+    destroyed. These describers also report the detector response of the
+    kept regions, so that the regions of several areas can be ranked together.
+  */
+  class Scoped_feature_budget
+  {
+  public:
+    /**
+    @param max_count Maximal number of regions in the area (must be > 0)
+    @param x0 Left column of the area (in the described image frame)
+    @param y0 Top row of the area (in the described image frame)
+    @param width Area width
+    @param height Area height
+    @param responses Optional output: detector response of the kept regions
+      (in the regions order, left empty by the describers without response)
+    */
+    Scoped_feature_budget
+    (
+      size_t max_count,
+      int x0,
+      int y0,
+      int width,
+      int height,
+      std::vector<float> * responses = nullptr
+    )
+      : previous_(Current())
+    {
+      Current() = {max_count, x0, y0, width, height, responses};
+    }
+    ~Scoped_feature_budget() { Current() = previous_; }
+    Scoped_feature_budget(const Scoped_feature_budget &) = delete;
+    Scoped_feature_budget & operator=(const Scoped_feature_budget &) = delete;
+
+  private:
+    friend class Image_describer;
+    struct Budget
+    {
+      size_t max_count; // 0: no scoped budget
+      int x0, y0, width, height;
+      std::vector<float> * responses;
+    };
+    static Budget & Current()
+    {
+      thread_local Budget budget = {0, 0, 0, 0, 0, nullptr};
+      return budget;
+    }
+    Budget previous_;
+  };
+
+  /**
+  @brief Compute the values of a whole image that the detection depends on
+    (i.e. the AKAZE contrast factor). DescribeTiled computes them once and
+    describes each tile with them (see Scoped_image_statistics), so that
+    the tiles are described as the whole image.
+  @param image The whole image
+  @return The values (empty if the detection does not depend on them)
+  */
+  virtual std::vector<float> Compute_image_statistics
+  (
+    const image::Image<unsigned char> & image
+  ) const
+  {
+    return {};
+  }
+
+  /**
+  @brief Statistics of the whole image used by the Describe calls made by the
+    current thread on a part of the image (e.g. a tile, see DescribeTiled),
+    until the object is destroyed.
+  */
+  class Scoped_image_statistics
+  {
+  public:
+    /// @param statistics Values computed by Compute_image_statistics
+    ///  (they must outlive the object)
+    explicit Scoped_image_statistics(const std::vector<float> & statistics)
+      : previous_(Current())
+    {
+      Current() = &statistics;
+    }
+    ~Scoped_image_statistics() { Current() = previous_; }
+    Scoped_image_statistics(const Scoped_image_statistics &) = delete;
+    Scoped_image_statistics & operator=(const Scoped_image_statistics &) = delete;
+
+  private:
+    friend class Image_describer;
+    static const std::vector<float> * & Current()
+    {
+      thread_local const std::vector<float> * statistics = nullptr;
+      return statistics;
+    }
+    const std::vector<float> * previous_;
+  };
+
+  /**
+  @brief Radius (in pixels) of the image area used to detect and describe the
+    coarsest regions: the margin needed around a part of an image to describe
+    its regions as on the whole image (see DescribeTiled).
+  @return The radius (0 if unknown)
+  */
+  virtual int Region_support_radius() const
+  {
+    return 0;
+  }
+
   /**
   @brief Detect regions on the image and compute their attributes (description)
   @param image Image.
@@ -107,6 +238,79 @@ public:
   {
     return regions->LoadFeatures(sfileNameFeats);
   }
+
+protected:
+  /// Statistics of the whole image described by parts by the current thread
+  /// (empty if the described image is a whole image, see Scoped_image_statistics)
+  static const std::vector<float> & Current_image_statistics()
+  {
+    static const std::vector<float> no_statistics;
+    const std::vector<float> * statistics = Scoped_image_statistics::Current();
+    return statistics ? *statistics : no_statistics;
+  }
+
+  /**
+  @brief Apply the feature budget to detected keypoints (before their description)
+  @param keypoints The keypoints (the kept ones stay in their original order).
+    The describer must output one region per kept keypoint, in the same order.
+  @param width Image width
+  @param height Image height
+  @param position Functor returning the position (Vec2f) of a keypoint
+  @param response Functor returning the detector response of a keypoint
+  */
+  template <typename KeypointT, typename PositionFunctor, typename ResponseFunctor>
+  void Select_keypoints_within_budget
+  (
+    std::vector<KeypointT> & keypoints,
+    int width,
+    int height,
+    PositionFunctor && position,
+    ResponseFunctor && response
+  ) const
+  {
+    size_t budget = feature_budget_;
+    Vec2f origin(0.f, 0.f);
+    const Scoped_feature_budget::Budget & scoped_budget = Scoped_feature_budget::Current();
+    if (scoped_budget.max_count > 0)
+    {
+      // Keep the keypoints of the budget area only
+      budget = scoped_budget.max_count;
+      origin << scoped_budget.x0, scoped_budget.y0;
+      width = scoped_budget.width;
+      height = scoped_budget.height;
+      keypoints.erase(std::remove_if(keypoints.begin(), keypoints.end(),
+        [&](const KeypointT & keypoint)
+        {
+          const Vec2f p = position(keypoint) - origin;
+          return p.x() < 0.f || p.x() >= width || p.y() < 0.f || p.y() >= height;
+        }),
+        keypoints.end());
+    }
+    if (budget > 0 && keypoints.size() > budget)
+    {
+      std::vector<Vec2f> positions(keypoints.size());
+      std::vector<float> responses(keypoints.size());
+      for (size_t i = 0; i < keypoints.size(); ++i)
+      {
+        positions[i] = position(keypoints[i]) - origin;
+        responses[i] = response(keypoints[i]);
+      }
+      const std::vector<uint32_t> selection =
+        SelectSpatiallyUniform(positions, responses, width, height, budget);
+      for (size_t i = 0; i < selection.size(); ++i)
+        keypoints[i] = keypoints[selection[i]];
+      keypoints.erase(keypoints.begin() + selection.size(), keypoints.end());
+    }
+    // Report the response of the kept keypoints
+    if (scoped_budget.max_count > 0 && scoped_budget.responses)
+    {
+      scoped_budget.responses->resize(keypoints.size());
+      for (size_t i = 0; i < keypoints.size(); ++i)
+        (*scoped_budget.responses)[i] = response(keypoints[i]);
+    }
+  }
+
+  size_t feature_budget_ = 0; ///< Maximal number of regions per image (0: no limit)
 };
 
 } // namespace features
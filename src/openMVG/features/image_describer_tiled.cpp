@@ -0,0 +1,185 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/image_describer_tiled.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace openMVG {
+namespace features {
+
+// Budget of a tile: a few times its share of the budget (in proportion to its
+// area), so that the textured tiles can take the budget left by the others.
+// The budget is enforced once the tiles are merged.
+static size_t TileFeatureBudget
+(
+  const size_t budget,
+  const int w,
+  const int h,
+  const int tile_w,
+  const int tile_h
+)
+{
+  const double oversizing = 4.0;
+  const double share =
+    budget * (static_cast<double>(tile_w) * tile_h) / (static_cast<double>(w) * h);
+  return std::min(budget, static_cast<size_t>(std::ceil(oversizing * share)));
+}
+
+std::unique_ptr<Regions> DescribeTiled
+(
+  Image_describer & image_describer,
+  const image::Image<unsigned char> & image,
+  const image::Image<unsigned char> * mask,
+  const Tiling_Options & options
+)
+{
+  const int w = image.Width(), h = image.Height();
+  if (options.tile_size <= 0 || (w <= options.tile_size && h <= options.tile_size))
+    return image_describer.Describe(image, mask);
+
+  const int tile_size = options.tile_size;
+  int margin = options.margin;
+  if (margin < 0)
+  {
+    margin = image_describer.Region_support_radius();
+    if (margin <= 0)
+      margin = 512;
+  }
+  const int nb_tiles_x = (w + tile_size - 1) / tile_size;
+  const int nb_tiles_y = (h + tile_size - 1) / tile_size;
+  const int nb_tiles = nb_tiles_x * nb_tiles_y;
+
+  const size_t budget = image_describer.Feature_budget();
+
+  // The tiles are described with the statistics of the whole image
+  const std::vector<float> image_statistics =
+    image_describer.Compute_image_statistics(image);
+
+  // Regions of each tile, expressed in the image frame,
+  // and their detector response (if the describer provides it)
+  std::vector<std::unique_ptr<Regions>> tile_regions(nb_tiles);
+  std::vector<std::vector<float>> tile_responses(nb_tiles);
+  std::atomic<bool> b_error(false);
+
+#ifdef OPENMVG_USE_OPENMP
+  const int nb_thread = (options.max_tiles_in_flight > 0)
+    ? static_cast<int>(options.max_tiles_in_flight)
+    : omp_get_max_threads();
+  #pragma omp parallel for schedule(dynamic) num_threads(nb_thread)
+#endif
+  for (int t = 0; t < nb_tiles; ++t)
+  {
+    if (b_error)
+      continue;
+    const int x0 = (t % nb_tiles_x) * tile_size;
+    const int y0 = (t / nb_tiles_x) * tile_size;
+    // Extended tile
+    const int ex0 = std::max(0, x0 - margin);
+    const int ey0 = std::max(0, y0 - margin);
+    const int ex1 = std::min(w, x0 + tile_size + margin);
+    const int ey1 = std::min(h, y0 + tile_size + margin);
+
+    image::Image<unsigned char> tile_mask;
+    if (mask)
+    {
+      tile_mask = mask->GetMat().block(ey0, ex0, ey1 - ey0, ex1 - ex0);
+      // Skip the fully masked tiles
+      if ((tile_mask.GetMat().array() == 0).all())
+        continue;
+    }
+    const image::Image<unsigned char> tile(
+      image.GetMat().block(ey0, ex0, ey1 - ey0, ex1 - ex0));
+
+    const Image_describer::Scoped_image_statistics tile_statistics(image_statistics);
+    std::unique_ptr<Regions> regions;
+    if (budget > 0)
+    {
+      // The tile budget is spread over the tile (its margins are discarded)
+      const int tile_w = std::min(w - x0, tile_size), tile_h = std::min(h - y0, tile_size);
+      const Image_describer::Scoped_feature_budget tile_budget(
+        TileFeatureBudget(budget, w, h, tile_w, tile_h),
+        x0 - ex0, y0 - ey0, tile_w, tile_h, &tile_responses[t]);
+      regions = image_describer.Describe(tile, mask ? &tile_mask : nullptr);
+    }
+    else
+    {
+      regions = image_describer.Describe(tile, mask ? &tile_mask : nullptr);
+    }
+    if (!regions)
+    {
+      b_error = true;
+      continue;
+    }
+    regions->Translate(Vec2f(ex0, ey0));
+    tile_regions[t] = std::move(regions);
+  }
+  if (b_error)
+  {
+    OPENMVG_LOG_ERROR << "Cannot describe an image tile.";
+    return nullptr;
+  }
+
+  // Keep the regions detected inside their tile (the margins overlap)
+  std::unique_ptr<Regions> regions = image_describer.Allocate();
+  std::vector<float> responses;
+  bool b_responses = true; // all the regions have their detector response
+  for (int t = 0; t < nb_tiles; ++t)
+  {
+    if (!tile_regions[t])
+      continue;
+    const int x0 = (t % nb_tiles_x) * tile_size;
+    const int y0 = (t / nb_tiles_x) * tile_size;
+    const Regions & tile = *tile_regions[t];
+    b_responses &= tile_responses[t].size() == tile.RegionCount();
+    for (size_t i = 0; i < tile.RegionCount(); ++i)
+    {
+      const Vec2 position = tile.GetRegionPosition(i);
+      if (position.x() >= x0 && position.x() < x0 + tile_size
+          && position.y() >= y0 && position.y() < y0 + tile_size)
+      {
+        tile.CopyRegion(i, regions.get());
+        if (b_responses)
+          responses.push_back(tile_responses[t][i]);
+      }
+    }
+    tile_regions[t].reset();
+  }
+
+  if (budget == 0 || regions->RegionCount() <= budget)
+    return regions;
+
+  if (!b_responses)
+  {
+    // The describers that cannot rank their keypoints by detector response
+    // apply the whole budget to each tile: enforce it on the image
+    regions->SelectSpatiallyUniform(w, h, budget);
+    return regions;
+  }
+
+  // Keep the best regions of the image by detector response, spread over it
+  std::vector<Vec2f> positions(regions->RegionCount());
+  for (size_t i = 0; i < regions->RegionCount(); ++i)
+    positions[i] = regions->GetRegionPosition(i).cast<float>();
+  const std::vector<uint32_t> selection =
+    SelectSpatiallyUniform(positions, responses, w, h, budget);
+  std::unique_ptr<Regions> selected_regions = image_describer.Allocate();
+  for (const uint32_t i : selection)
+    regions->CopyRegion(i, selected_regions.get());
+  return selected_regions;
+}
+
+} // namespace features
+} // namespace openMVG
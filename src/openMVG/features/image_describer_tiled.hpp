@@ -0,0 +1,76 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_FEATURES_IMAGE_DESCRIBER_TILED_HPP
+#define OPENMVG_FEATURES_IMAGE_DESCRIBER_TILED_HPP
+
+#include <memory>
+
+#include "openMVG/features/image_describer.hpp"
+
+namespace openMVG {
+namespace features {
+
+/// Configure the tiled region extraction of large images
+struct Tiling_Options
+{
+  /// Size of the tiles (in pixels). Each region belongs to the tile in
+  /// which it is detected, so the tiles do not produce duplicated regions.
+  int tile_size = 4096;
+  /// Border added around each tile (in pixels). It must cover the support
+  /// of the coarsest octave regions detected near the tile boundaries
+  /// (the regions whose support is larger than the margin are computed
+  /// on the extended tile only).
+  /// -1: the support radius of the describer regions
+  /// (see Image_describer::Region_support_radius), or 512 pixels if the
+  /// describer does not provide it.
+  int margin = -1;
+  /// Maximal number of tiles described at the same time
+  /// (0 means one per available thread).
+  unsigned int max_tiles_in_flight = 0;
+};
+
+/**
+* @brief Detect regions on a large image, tile by tile.
+*
+* The image is split into tiles of tile_size pixels. Each tile is
+* described with its margin (the scale space is only built for the
+* extended tile, so the peak memory depends on the tile size), then the
+* regions detected inside the tile are kept and moved to the image frame.
+* The values of the whole image that the detection depends on (i.e. the
+* AKAZE contrast factor) are computed once and used for every tile
+* (see Image_describer::Compute_image_statistics).
+* The tiles are described in parallel and the regions are merged in the
+* tile order (the output does not depend on the number of threads).
+* If the describer has a feature budget, each tile keeps its best regions
+* by detector response, spread over the tile, up to a few times its share
+* of the budget in proportion to its area (see
+* Image_describer::Scoped_feature_budget). The budget is then enforced on
+* the merged regions, ranked by their detector response: the budget left by
+* the poorly textured tiles goes to the textured ones, as when the whole
+* image is described. The describers without detector response apply the
+* whole budget to each tile, and the merged regions are ranked by scale.
+*
+* @param image_describer The describer used on each tile. Its Describe
+*  method must be thread safe when the tiles are described in parallel.
+* @param image Image.
+* @param mask 8-bit gray image for keypoint filtering (optional).
+*   Non-zero values depict the region of interest.
+* @param options Tiling settings
+* @return The detected regions (nullptr if a tile cannot be described)
+*/
+std::unique_ptr<Regions> DescribeTiled
+(
+  Image_describer & image_describer,
+  const image::Image<unsigned char> & image,
+  const image::Image<unsigned char> * mask = nullptr,
+  const Tiling_Options & options = Tiling_Options()
+);
+
+} // namespace features
+} // namespace openMVG
+
+#endif // OPENMVG_FEATURES_IMAGE_DESCRIBER_TILED_HPP
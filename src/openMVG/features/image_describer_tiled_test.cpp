@@ -0,0 +1,190 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/akaze/image_describer_akaze.hpp"
+#include "openMVG/features/image_describer_tiled.hpp"
+#include "openMVG/features/sift/SIFT_Anatomy_Image_Describer.hpp"
+#include "openMVG/image/image_container.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+
+// Random blobs of various sizes on a gray background
+Image<unsigned char> BlobImage(const int width, const int height)
+{
+  Image<unsigned char> image(width, height, true, 128);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> x_dist(0.f, width), y_dist(0.f, height);
+  std::uniform_real_distribution<float> radius_dist(2.f, 8.f);
+  std::uniform_int_distribution<int> color_dist(0, 1);
+  for (int i = 0; i < width * height / 400; ++i)
+  {
+    const float cx = x_dist(rng), cy = y_dist(rng), radius = radius_dist(rng);
+    const unsigned char color = color_dist(rng) ? 255 : 0;
+    for (int y = std::max(0, int(cy - radius)); y < std::min(height, int(cy + radius + 1)); ++y)
+      for (int x = std::max(0, int(cx - radius)); x < std::min(width, int(cx + radius + 1)); ++x)
+        if (Square(x - cx) + Square(y - cy) <= Square(radius))
+          image(y, x) = color;
+  }
+  return image;
+}
+
+TEST(DescribeTiled, SameRegionsAsWholeImage)
+{
+  const Image<unsigned char> image = BlobImage(512, 384);
+  SIFT_Anatomy_Image_describer describer(SIFT_Anatomy_Image_describer::Params(0, 3));
+
+  const std::unique_ptr<Regions> regions = describer.Describe(image);
+  Tiling_Options options;
+  options.tile_size = 160;
+  options.margin = 96;
+  const std::unique_ptr<Regions> tiled_regions = DescribeTiled(describer, image, nullptr, options);
+  EXPECT_TRUE(regions && tiled_regions);
+  EXPECT_TRUE(regions->RegionCount() > 100);
+
+  // The regions are found at the same positions with the same descriptors
+  const auto & features = dynamic_cast<const SIFT_Regions&>(*regions).Features();
+  const auto & tiled_features = dynamic_cast<const SIFT_Regions&>(*tiled_regions).Features();
+  int nb_found = 0;
+  for (size_t i = 0; i < features.size(); ++i)
+  {
+    for (size_t j = 0; j < tiled_features.size(); ++j)
+    {
+      if ((features[i].coords() - tiled_features[j].coords()).norm() < 0.1f
+          && std::abs(features[i].scale() - tiled_features[j].scale()) < 0.1f
+          && regions->SquaredDescriptorDistance(i, tiled_regions.get(), j) < 1.0)
+      {
+        ++nb_found;
+        break;
+      }
+    }
+  }
+  EXPECT_TRUE(nb_found >= 0.95 * features.size());
+  EXPECT_TRUE(tiled_regions->RegionCount() <= 1.05 * regions->RegionCount());
+}
+
+// Blobs with a lower contrast on the right half of the image: the
+// statistics of a tile differ from the ones of the whole image
+Image<unsigned char> UnevenContrastBlobImage(const int width, const int height)
+{
+  Image<unsigned char> image = BlobImage(width, height);
+  for (int y = 0; y < height; ++y)
+    for (int x = width / 2; x < width; ++x)
+      image(y, x) = static_cast<unsigned char>(128 + (image(y, x) - 128) / 4);
+  return image;
+}
+
+// Count the regions found in the other regions, at the same position and
+// scale and with the same descriptor
+template <typename RegionsT>
+int CountSameRegions
+(
+  const Regions & regions,
+  const Regions & other,
+  const double max_descriptor_distance
+)
+{
+  const auto & features = dynamic_cast<const RegionsT&>(regions).Features();
+  const auto & other_features = dynamic_cast<const RegionsT&>(other).Features();
+  int nb_found = 0;
+  for (size_t i = 0; i < features.size(); ++i)
+  {
+    for (size_t j = 0; j < other_features.size(); ++j)
+    {
+      if ((features[i].coords() - other_features[j].coords()).norm() < 0.1f
+          && std::abs(features[i].scale() - other_features[j].scale()) < 0.1f
+          && regions.SquaredDescriptorDistance(i, &other, j) <= max_descriptor_distance)
+      {
+        ++nb_found;
+        break;
+      }
+    }
+  }
+  return nb_found;
+}
+
+TEST(DescribeTiled, SameAKAZERegionsAsWholeImage)
+{
+  const Image<unsigned char> image = UnevenContrastBlobImage(512, 384);
+  AKAZE::Params akaze_params;
+  akaze_params.iNbOctave = 2;
+  AKAZE_Image_describer_SURF describer(AKAZE_Image_describer::Params(akaze_params, AKAZE_MSURF));
+
+  // The default margin is the support of the coarsest keypoints
+  const int margin = describer.Region_support_radius();
+  EXPECT_TRUE(margin > 0 && margin < 160);
+
+  const std::unique_ptr<Regions> regions = describer.Describe(image);
+  Tiling_Options options;
+  options.tile_size = 160;
+  const std::unique_ptr<Regions> tiled_regions = DescribeTiled(describer, image, nullptr, options);
+  EXPECT_TRUE(regions && tiled_regions);
+  EXPECT_TRUE(regions->RegionCount() > 100);
+
+  // The tiles use the contrast factor of the whole image:
+  // the regions are found at the same positions with the same descriptors
+  const int nb_found = CountSameRegions<AKAZE_Float_Regions>(*regions, *tiled_regions, 1e-2);
+  EXPECT_TRUE(nb_found >= 0.95 * regions->RegionCount());
+  EXPECT_TRUE(tiled_regions->RegionCount() <= 1.05 * regions->RegionCount());
+}
+
+TEST(DescribeTiled, SameAKAZEBinaryRegionsAsWholeImage)
+{
+  const Image<unsigned char> image = UnevenContrastBlobImage(512, 384);
+  AKAZE::Params akaze_params;
+  akaze_params.iNbOctave = 2;
+  AKAZE_Image_describer_MLDB describer(AKAZE_Image_describer::Params(akaze_params, AKAZE_MLDB));
+
+  const std::unique_ptr<Regions> regions = describer.Describe(image);
+  Tiling_Options options;
+  options.tile_size = 160;
+  const std::unique_ptr<Regions> tiled_regions = DescribeTiled(describer, image, nullptr, options);
+  EXPECT_TRUE(regions && tiled_regions);
+  EXPECT_TRUE(regions->RegionCount() > 100);
+
+  const int nb_found = CountSameRegions<AKAZE_Binary_Regions>(*regions, *tiled_regions, 8);
+  EXPECT_TRUE(nb_found >= 0.95 * regions->RegionCount());
+  EXPECT_TRUE(tiled_regions->RegionCount() <= 1.05 * regions->RegionCount());
+}
+
+TEST(DescribeTiled, Mask)
+{
+  const Image<unsigned char> image = BlobImage(512, 384);
+  // Only the left half of the image is used
+  Image<unsigned char> mask(512, 384, true, 0);
+  mask.block(0, 0, 384, 256).fill(255);
+
+  SIFT_Anatomy_Image_describer describer(SIFT_Anatomy_Image_describer::Params(0, 3));
+  Tiling_Options options;
+  options.tile_size = 128;
+  options.margin = 64;
+  options.max_tiles_in_flight = 2;
+  const std::unique_ptr<Regions> regions = DescribeTiled(describer, image, &mask, options);
+  EXPECT_TRUE(regions && regions->RegionCount() > 0);
+  for (size_t i = 0; i < regions->RegionCount(); ++i)
+  {
+    EXPECT_TRUE(regions->GetRegionPosition(i).x() < 256);
+  }
+}
+
+TEST(DescribeTiled, SmallImage)
+{
+  // The image fits in a tile: regular description
+  const Image<unsigned char> image = BlobImage(128, 128);
+  SIFT_Anatomy_Image_describer describer(SIFT_Anatomy_Image_describer::Params(0, 3));
+  const std::unique_ptr<Regions> regions = describer.Describe(image);
+  const std::unique_ptr<Regions> tiled_regions = DescribeTiled(describer, image);
+  EXPECT_EQ(regions->RegionCount(), tiled_regions->RegionCount());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
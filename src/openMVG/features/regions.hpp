@@ -74,11 +74,20 @@ public:
   /// Add the Inth region to another Region container
   virtual void CopyRegion(size_t i, Regions *) const = 0;
 
+  /// Translate the regions positions
+  /// (i.e. regions computed on a sub-image expressed in the image frame)
+  virtual void Translate(const Vec2f & offset) = 0;
+
   /// Sort the regions according the scale of the feature
   /// If the regions are not Scale invariant nothing is done and false is returned
   /// keep_count is used to save feature from largest scale to lower (-1 keep everything)
   virtual bool SortAndSelectByRegionScale(int keep_count = -1) = 0;
 
+  /// Keep at most keep_count regions spread uniformly over the image
+  /// (see SelectSpatiallyUniformRegions). The scale invariant regions are
+  /// ranked by scale. Return true if some regions have been removed.
+  virtual bool SelectSpatiallyUniform(int width, int height, size_t keep_count) = 0;
+
   virtual Regions * EmptyClone() const = 0;
 
 };
@@ -0,0 +1,151 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_FEATURES_REGIONS_SPATIAL_SELECTION_HPP
+#define OPENMVG_FEATURES_REGIONS_SPATIAL_SELECTION_HPP
+
+#include "openMVG/features/feature.hpp"
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace openMVG {
+namespace features {
+
+/**
+* @brief Select at most keep_count points spread uniformly over an image.
+*
+* The image is divided into a grid of square cells (about 4 points per cell
+* if keep_count points were uniformly spread). The points of each cell are
+* ranked by decreasing score and the points are selected rank by rank: the
+* best point of every cell, then the second best of every cell, ... The last
+* selected rank is completed by the points with the highest scores.
+* So the textured areas cannot take the whole budget, and the best points
+* are kept in each area.
+*
+* @param positions Position of the points in the image
+* @param scores Score of the points (the higher, the better)
+* @param width Image width
+* @param height Image height
+* @param keep_count Maximal number of points to keep
+* @return The indexes of the selected points (by increasing index)
+*/
+inline std::vector<uint32_t> SelectSpatiallyUniform
+(
+  const std::vector<Vec2f> & positions,
+  const std::vector<float> & scores,
+  const int width,
+  const int height,
+  const size_t keep_count
+)
+{
+  const uint32_t count = static_cast<uint32_t>(positions.size());
+  std::vector<uint32_t> indexes(count);
+  std::iota(indexes.begin(), indexes.end(), 0);
+  if (count <= keep_count)
+    return indexes;
+  if (keep_count == 0)
+    return {};
+
+  const int points_per_cell = 4;
+  const double cell_size = std::max(1.0,
+    std::sqrt(static_cast<double>(std::max(width, 1)) * std::max(height, 1) * points_per_cell / keep_count));
+  const int grid_width = std::max(1, static_cast<int>(std::ceil(width / cell_size)));
+  const int grid_height = std::max(1, static_cast<int>(std::ceil(height / cell_size)));
+
+  // Cell of each point (the points outside of the image belong to the border cells)
+  std::vector<int> cells(count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const int cx = std::min(grid_width - 1, std::max(0, static_cast<int>(positions[i].x() / cell_size)));
+    const int cy = std::min(grid_height - 1, std::max(0, static_cast<int>(positions[i].y() / cell_size)));
+    cells[i] = cy * grid_width + cx;
+  }
+
+  // Order the points by cell, then by decreasing score (the index breaks the ties)
+  const auto better = [&](const uint32_t a, const uint32_t b)
+  {
+    return (scores[a] != scores[b]) ? scores[a] > scores[b] : a < b;
+  };
+  std::sort(indexes.begin(), indexes.end(), [&](const uint32_t a, const uint32_t b)
+  {
+    return (cells[a] != cells[b]) ? cells[a] < cells[b] : better(a, b);
+  });
+
+  // Rank of each point in its cell
+  std::vector<uint32_t> ranks(count);
+  for (uint32_t k = 0; k < count; ++k)
+  {
+    const uint32_t i = indexes[k];
+    ranks[i] = (k > 0 && cells[indexes[k - 1]] == cells[i]) ? ranks[indexes[k - 1]] + 1 : 0;
+  }
+
+  // Keep the keep_count first points by increasing rank, then by decreasing score
+  std::nth_element(indexes.begin(), indexes.begin() + keep_count, indexes.end(),
+    [&](const uint32_t a, const uint32_t b)
+    {
+      return (ranks[a] != ranks[b]) ? ranks[a] < ranks[b] : better(a, b);
+    });
+  indexes.resize(keep_count);
+  std::sort(indexes.begin(), indexes.end());
+  return indexes;
+}
+
+/// Score used to select the regions spatially: the scale for the scale
+/// invariant features (as SortAndSelectByRegionScale), none otherwise.
+inline float RegionSelectionScore(const PointFeature &) { return 0.f; }
+inline float RegionSelectionScore(const SIOPointFeature & feat) { return feat.scale(); }
+
+/// Keep at most keep_count features and descriptors spread uniformly over
+/// the image (see SelectSpatiallyUniform). The kept regions are ranked by
+/// RegionSelectionScore and stay in their original order.
+/// Return true if some regions have been removed.
+template
+<
+typename FeatT,
+typename DescsT
+>
+bool SelectSpatiallyUniformRegions
+(
+  std::vector<FeatT> & feats,
+  DescsT & descs,
+  const int width,
+  const int height,
+  const size_t keep_count
+)
+{
+  if (feats.size() <= keep_count)
+    return false;
+
+  std::vector<Vec2f> positions(feats.size());
+  std::vector<float> scores(feats.size());
+  for (size_t i = 0; i < feats.size(); ++i)
+  {
+    positions[i] = feats[i].coords();
+    scores[i] = RegionSelectionScore(feats[i]);
+  }
+  const std::vector<uint32_t> selection =
+    SelectSpatiallyUniform(positions, scores, width, height, keep_count);
+
+  // The selection is sorted, so the regions can be compacted in place
+  for (size_t i = 0; i < selection.size(); ++i)
+  {
+    feats[i] = feats[selection[i]];
+    descs[i] = descs[selection[i]];
+  }
+  feats.resize(selection.size());
+  descs.resize(selection.size());
+  return true;
+}
+
+} // namespace features
+} // namespace openMVG
+
+#endif // OPENMVG_FEATURES_REGIONS_SPATIAL_SELECTION_HPP
@@ -0,0 +1,197 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/image_describer_tiled.hpp"
+#include "openMVG/features/regions_spatial_selection.hpp"
+#include "openMVG/features/sift/SIFT_Anatomy_Image_Describer.hpp"
+#include "openMVG/image/image_container.hpp"
+
+#include "testing/testing.h"
+
+#include <map>
+#include <random>
+#include <set>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+
+TEST(SelectSpatiallyUniform, SmallSets)
+{
+  const std::vector<Vec2f> positions = {{1.f, 1.f}, {5.f, 5.f}, {9.f, 9.f}};
+  const std::vector<float> scores = {1.f, 2.f, 3.f};
+
+  EXPECT_EQ(3, SelectSpatiallyUniform(positions, scores, 10, 10, 3).size());
+  EXPECT_EQ(3, SelectSpatiallyUniform(positions, scores, 10, 10, 10).size());
+  EXPECT_EQ(0, SelectSpatiallyUniform(positions, scores, 10, 10, 0).size());
+  // A single cell: the best points are kept
+  const std::vector<uint32_t> selection = SelectSpatiallyUniform(positions, scores, 10, 10, 2);
+  EXPECT_EQ(2, selection.size());
+  EXPECT_EQ(1, selection[0]);
+  EXPECT_EQ(2, selection[1]);
+}
+
+TEST(SelectSpatiallyUniform, Coverage)
+{
+  // A dense cluster of strong points in a corner and weak points everywhere
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> cluster_dist(0.f, 100.f), image_dist(0.f, 1000.f);
+  std::vector<Vec2f> positions;
+  std::vector<float> scores;
+  for (int i = 0; i < 2000; ++i)
+  {
+    positions.emplace_back(cluster_dist(rng), cluster_dist(rng));
+    scores.push_back(10.f + i);
+  }
+  const int nb_scattered = 400;
+  for (int i = 0; i < nb_scattered; ++i)
+  {
+    positions.emplace_back(image_dist(rng), image_dist(rng));
+    scores.push_back(1.f);
+  }
+
+  const size_t keep_count = 400;
+  const std::vector<uint32_t> selection =
+    SelectSpatiallyUniform(positions, scores, 1000, 1000, keep_count);
+  EXPECT_EQ(keep_count, selection.size());
+  EXPECT_TRUE(std::is_sorted(selection.begin(), selection.end()));
+  EXPECT_EQ(keep_count, std::set<uint32_t>(selection.begin(), selection.end()).size());
+
+  // Keeping the best scores only would keep the cluster only
+  const auto nb_cluster = std::count_if(selection.cbegin(), selection.cend(),
+    [](const uint32_t i) { return i < 2000; });
+  EXPECT_TRUE(nb_cluster > 0);
+  EXPECT_TRUE(keep_count - nb_cluster > nb_scattered / 2);
+
+  // The strongest point is always kept
+  EXPECT_TRUE(std::binary_search(selection.cbegin(), selection.cend(), 1999));
+}
+
+TEST(SelectSpatiallyUniform, Regions)
+{
+  SIFT_Regions regions;
+  for (int i = 0; i < 100; ++i)
+  {
+    regions.Features().emplace_back(i * 10.f, i * 5.f, 1.f + i, 0.f);
+    SIFT_Regions::DescriptorT desc;
+    desc.fill(static_cast<unsigned char>(i));
+    regions.Descriptors().push_back(desc);
+  }
+
+  EXPECT_FALSE(regions.SelectSpatiallyUniform(1000, 500, 100));
+  EXPECT_EQ(100, regions.RegionCount());
+
+  EXPECT_TRUE(regions.SelectSpatiallyUniform(1000, 500, 20));
+  EXPECT_EQ(20, regions.RegionCount());
+  // The features keep their descriptors
+  for (size_t i = 0; i < regions.RegionCount(); ++i)
+  {
+    const int id = static_cast<int>(regions.Features()[i].x() / 10.f + 0.5f);
+    EXPECT_EQ(id, regions.Descriptors()[i][0]);
+  }
+}
+
+// Random blobs of various sizes on a gray background
+static Image<unsigned char> BlobImage(const int width, const int height)
+{
+  Image<unsigned char> image(width, height, true, 128);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> x_dist(0.f, width), y_dist(0.f, height);
+  std::uniform_real_distribution<float> radius_dist(2.f, 8.f);
+  std::uniform_int_distribution<int> color_dist(0, 1);
+  for (int i = 0; i < width * height / 400; ++i)
+  {
+    const float cx = x_dist(rng), cy = y_dist(rng), radius = radius_dist(rng);
+    const unsigned char color = color_dist(rng) ? 255 : 0;
+    for (int y = std::max(0, int(cy - radius)); y < std::min(height, int(cy + radius + 1)); ++y)
+      for (int x = std::max(0, int(cx - radius)); x < std::min(width, int(cx + radius + 1)); ++x)
+        if (Square(x - cx) + Square(y - cy) <= Square(radius))
+          image(y, x) = color;
+  }
+  return image;
+}
+
+TEST(Image_describer, FeatureBudget)
+{
+  const Image<unsigned char> image = BlobImage(512, 384);
+  SIFT_Anatomy_Image_describer describer(SIFT_Anatomy_Image_describer::Params(0, 3));
+  const std::unique_ptr<Regions> all_regions = describer.Describe(image);
+  EXPECT_TRUE(all_regions->RegionCount() > 100);
+
+  describer.Set_feature_budget(100);
+  EXPECT_EQ(100, describer.Feature_budget());
+  const std::unique_ptr<Regions> regions = describer.Describe(image);
+  EXPECT_EQ(100, regions->RegionCount());
+
+  // The kept regions are a subset of the regions
+  const auto & all_features = dynamic_cast<const SIFT_Regions&>(*all_regions).Features();
+  for (const auto & feature : dynamic_cast<const SIFT_Regions&>(*regions).Features())
+  {
+    EXPECT_TRUE(std::any_of(all_features.cbegin(), all_features.cend(),
+      [&](const SIOPointFeature & f) { return f.coords() == feature.coords(); }));
+  }
+
+  // The budget holds for the whole image when it is described tile by tile
+  Tiling_Options options;
+  options.tile_size = 160;
+  options.margin = 96;
+  const std::unique_ptr<Regions> tiled_regions = DescribeTiled(describer, image, nullptr, options);
+  EXPECT_EQ(100, tiled_regions->RegionCount());
+
+  // The tiles are ranked together: they keep about the regions selected
+  // on the whole image (256x256 tiles on the top row, 256x128 tiles on the
+  // bottom row)
+  options.tile_size = 256;
+  const std::unique_ptr<Regions> split_regions = DescribeTiled(describer, image, nullptr, options);
+  EXPECT_EQ(100, split_regions->RegionCount());
+  std::map<std::pair<int, int>, int> tile_counts, whole_image_tile_counts;
+  for (size_t i = 0; i < split_regions->RegionCount(); ++i)
+  {
+    const Vec2 position = split_regions->GetRegionPosition(i);
+    ++tile_counts[{static_cast<int>(position.x()) / 256, static_cast<int>(position.y()) / 256}];
+  }
+  for (size_t i = 0; i < regions->RegionCount(); ++i)
+  {
+    const Vec2 position = regions->GetRegionPosition(i);
+    ++whole_image_tile_counts[{static_cast<int>(position.x()) / 256, static_cast<int>(position.y()) / 256}];
+  }
+  for (const auto & tile_count : whole_image_tile_counts)
+  {
+    EXPECT_TRUE(std::abs(tile_count.second - tile_counts[tile_count.first]) <= 2);
+  }
+  // The regions are ranked by their detector response as on the whole image
+  const auto & features = dynamic_cast<const SIFT_Regions&>(*regions).Features();
+  const auto nb_same = std::count_if(features.cbegin(), features.cend(),
+    [&](const SIOPointFeature & feature)
+    {
+      const auto & split_features = dynamic_cast<const SIFT_Regions&>(*split_regions).Features();
+      return std::any_of(split_features.cbegin(), split_features.cend(),
+        [&](const SIOPointFeature & f) { return (f.coords() - feature.coords()).norm() < 0.1f; });
+    });
+  EXPECT_TRUE(nb_same >= 90);
+}
+
+TEST(Image_describer, FeatureBudgetUnevenTexture)
+{
+  // The right half of the image is flat: the budget left by its tiles goes
+  // to the textured tiles
+  Image<unsigned char> image = BlobImage(512, 384);
+  image.block(0, 256, 384, 256).fill(128);
+  SIFT_Anatomy_Image_describer describer(SIFT_Anatomy_Image_describer::Params(0, 3));
+  describer.Set_feature_budget(200);
+  const std::unique_ptr<Regions> regions = describer.Describe(image);
+  EXPECT_EQ(200, regions->RegionCount());
+
+  Tiling_Options options;
+  options.tile_size = 256;
+  options.margin = 96;
+  const std::unique_ptr<Regions> tiled_regions = DescribeTiled(describer, image, nullptr, options);
+  EXPECT_EQ(regions->RegionCount(), tiled_regions->RegionCount());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
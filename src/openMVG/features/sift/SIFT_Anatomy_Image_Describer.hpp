@@ -25,6 +25,8 @@ Changes are:
 #ifndef OPENMVG_FEATURES_SIFT_SIFT_ANATOMY_IMAGE_DESCRIBER_HPP
 #define OPENMVG_FEATURES_SIFT_SIFT_ANATOMY_IMAGE_DESCRIBER_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <vector>
 
@@ -159,20 +161,24 @@ public:
         // Concatenate the found keypoints
         std::move(keys.begin(), keys.end(), std::back_inserter(keypoints));
       }
+      // Feature masking
+      if (mask)
+      {
+        const image::Image<unsigned char> & maskIma = *mask;
+        keypoints.erase(std::remove_if(keypoints.begin(), keypoints.end(),
+          [&](const sift::Keypoint & k) { return maskIma(k.y, k.x) == 0; }),
+          keypoints.end());
+      }
+      // Keep the strongest keypoints spread over the image (if there is a budget)
+      Select_keypoints_within_budget(keypoints, image.Width(), image.Height(),
+        [](const sift::Keypoint & k) { return Vec2f(k.x, k.y); },
+        [](const sift::Keypoint & k) { return std::abs(k.val); });
+
       for (const auto & k : keypoints)
       {
-        // Feature masking
-        if (mask)
-        {
-          const image::Image<unsigned char> & maskIma = *mask;
-          if (maskIma(k.y, k.x) == 0)
-            continue;
-        }
         // Create the SIFT region
-        {
-          regions->Descriptors().emplace_back(k.descr.cast<unsigned char>());
-          regions->Features().emplace_back(k.x, k.y, k.sigma, k.theta);
-        }
+        regions->Descriptors().emplace_back(k.descr.cast<unsigned char>());
+        regions->Features().emplace_back(k.x, k.y, k.sigma, k.theta);
       }
     }
     return regions;
@@ -183,6 +189,19 @@ public:
     return std::unique_ptr<Regions_type>(new Regions_type);
   }
 
+  /// Descriptor support of the keypoints of the coarsest octave
+  int Region_support_radius() const override
+  {
+    // Largest keypoint scale: last slice of the last octave
+    const float sigma_min = (params_.first_octave_ == -1) ? 1.6f/2.0f : 1.6f;
+    const float sigma_max = sigma_min * std::pow(2.f,
+      params_.num_octaves_ - 1 + (params_.num_scales_ + 1.f) / params_.num_scales_);
+    // Half diagonal of the descriptor box (see Sift_DescriptorExtractor)
+    const float lambda_descr = 6.f, nb_split2d = 4.f;
+    return static_cast<int>(std::ceil(
+      (1.f + 1.f / nb_split2d) * lambda_descr * sigma_max * std::sqrt(2.f)));
+  }
+
   template<class Archive>
   inline void serialize( Archive & ar );
 
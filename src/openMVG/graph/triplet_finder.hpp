@@ -11,12 +11,15 @@
 
 #include <algorithm>
 #include <array>
+#include <numeric>
 #include <ostream>
-#include <set>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
 #include "openMVG/types.hpp"
 
 namespace openMVG
@@ -96,11 +99,160 @@ inline std::ostream & operator<<( std::ostream & os, const Triplet & t )
   return os;
 }
 
+namespace internal
+{
+
+/**
+* @brief Degree ordered adjacency of an undirected graph in compressed row
+*  storage (CSR).
+* Nodes are ranked by ascending degree and each edge is stored once, oriented
+*  from its lowest ranked node to its highest ranked node. Every triangle is
+*  then found exactly once from its lowest ranked node, and the out degree of
+*  each node is bounded by O(sqrt(#edges)).
+*/
+struct Oriented_Adjacency
+{
+  template <typename IterablePairs>
+  explicit Oriented_Adjacency( const IterablePairs & pairs )
+  {
+    // List the edges (as node ids) & the node ids
+    std::vector<std::pair<IndexT, IndexT>> edges;
+    for (const auto & edge : pairs)
+    {
+      const IndexT a = static_cast<IndexT>(edge.first);
+      const IndexT b = static_cast<IndexT>(edge.second);
+      if (a != b) // ignore self loops
+        edges.emplace_back(std::min(a, b), std::max(a, b));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    node_ids.reserve(2 * edges.size());
+    for (const auto & edge : edges)
+    {
+      node_ids.push_back(edge.first);
+      node_ids.push_back(edge.second);
+    }
+    std::sort(node_ids.begin(), node_ids.end());
+    node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
+    const auto node_index = [&](const IndexT id)
+    {
+      return static_cast<IndexT>(
+        std::lower_bound(node_ids.cbegin(), node_ids.cend(), id) - node_ids.cbegin());
+    };
+
+    // Rank the nodes by ascending degree (ties broken by node id)
+    std::vector<IndexT> degree(node_ids.size(), 0);
+    for (auto & edge : edges)
+    {
+      edge = {node_index(edge.first), node_index(edge.second)};
+      ++degree[edge.first];
+      ++degree[edge.second];
+    }
+    std::vector<IndexT> order(node_ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+      [&degree](const IndexT a, const IndexT b) { return degree[a] < degree[b]; });
+    std::vector<IndexT> rank(node_ids.size());
+    for (IndexT r = 0; r < order.size(); ++r)
+      rank[order[r]] = r;
+
+    std::vector<IndexT> ranked_node_ids(node_ids.size());
+    for (IndexT i = 0; i < node_ids.size(); ++i)
+      ranked_node_ids[rank[i]] = node_ids[i];
+    node_ids = std::move(ranked_node_ids);
+
+    // Orient the edges from the lowest to the highest rank & build the CSR
+    offsets.assign(node_ids.size() + 1, 0);
+    for (auto & edge : edges)
+    {
+      edge = {std::min(rank[edge.first], rank[edge.second]),
+              std::max(rank[edge.first], rank[edge.second])};
+      ++offsets[edge.first + 1];
+    }
+    std::partial_sum(offsets.cbegin(), offsets.cend(), offsets.begin());
+    std::sort(edges.begin(), edges.end());
+    neighbors.resize(edges.size());
+    std::transform(edges.cbegin(), edges.cend(), neighbors.begin(),
+      [](const std::pair<IndexT, IndexT> & edge) { return edge.second; });
+  }
+
+  /// Number of nodes of the graph
+  IndexT size() const { return static_cast<IndexT>(node_ids.size()); }
+
+  /**
+  * @brief Call visitor for each triangle whose lowest ranked node is u
+  * @param u Node rank
+  * @param visitor Callable with a Triplet (node ids sorted as i<j<k)
+  */
+  template <typename TripletVisitor>
+  void VisitNodeTriplets( const IndexT u, TripletVisitor & visitor ) const
+  {
+    const IndexT * u_begin = neighbors.data() + offsets[u];
+    const IndexT * u_end = neighbors.data() + offsets[u + 1];
+    for (const IndexT * v_it = u_begin; v_it != u_end; ++v_it)
+    {
+      // Intersect the (sorted) out neighbors of u and v
+      const IndexT v = *v_it;
+      const IndexT * a = v_it + 1;
+      const IndexT * b = neighbors.data() + offsets[v];
+      const IndexT * b_end = neighbors.data() + offsets[v + 1];
+      while (a != u_end && b != b_end)
+      {
+        if (*a < *b) ++a;
+        else if (*b < *a) ++b;
+        else
+        {
+          std::array<IndexT, 3> triplet_indexes {{node_ids[u], node_ids[v], node_ids[*a]}};
+          // sort the triplet indexes as i<j<k (monotonic ascending sorting)
+          std::sort(triplet_indexes.begin(), triplet_indexes.end());
+          visitor(Triplet(triplet_indexes[0], triplet_indexes[1], triplet_indexes[2]));
+          ++a;
+          ++b;
+        }
+      }
+    }
+  }
+
+  std::vector<IndexT> node_ids;  // rank -> node id
+  std::vector<size_t> offsets;   // rank -> first out neighbor position
+  std::vector<IndexT> neighbors; // out neighbors ranks (sorted per node)
+};
+
+} // namespace internal
+
+/**
+* @brief Call a visitor for each triplet contained in the graph build from
+*  IterablePairs, without storing the triplets.
+* @param[in] pairs A list of pairs
+* @param[in] visitor Callable with a const Triplet & (node ids sorted as i<j<k).
+* @note If OpenMP is enabled the visitor is called concurrently from several
+*  threads (in no particular order), so it must be thread safe.
+**/
+template <typename IterablePairs, typename TripletVisitor>
+void VisitTriplets
+(
+  const IterablePairs & pairs,
+  TripletVisitor && visitor
+)
+{
+  const internal::Oriented_Adjacency adjacency(pairs);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (int u = 0; u < static_cast<int>(adjacency.size()); ++u)
+  {
+    adjacency.VisitNodeTriplets(u, visitor);
+  }
+}
+
 /**
 * @brief Return triplets contained in the graph build from IterablePairs
 * @param[in] pairs A list of pairs
 * @param[out] triplets List of triplet found in graph
 * @return boolean return true if some triplet are found
+* @note The triplets are listed in parallel (if OpenMP is enabled), the output
+*  order does not depend on the number of threads.
 **/
 template <typename IterablePairs, class TTripletContainer>
 bool ListTriplets
@@ -111,51 +263,37 @@ bool ListTriplets
 {
   triplets.clear();
 
-  // Build an adjacency list corresponding to the edge list
-  std::unordered_map<IndexT, std::set<IndexT>> adjacency_list;
-  for (const auto & edge : pairs)
-  {
-    adjacency_list[edge.first].insert(edge.second);
-    adjacency_list[edge.second].insert(edge.first);
-  }
-
-  std::vector<IndexT> node_candidate_for_triplet;
+  const internal::Oriented_Adjacency adjacency(pairs);
 
-  // List the pair and find all triplets thanks to the adjacency list
-  for (const auto & edge_it : pairs)
+  // List the triplets per chunk of nodes, then concatenate the chunks in order
+  const int chunk_size = 64;
+  const int chunk_count = (adjacency.size() + chunk_size - 1) / chunk_size;
+  std::vector<std::vector<Triplet>> chunk_triplets(chunk_count);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int chunk = 0; chunk < chunk_count; ++chunk)
   {
-    // Find any targeting edge that contains the first and the second node index
-    const auto & node1_edges = adjacency_list.find(edge_it.first)->second;
-    const auto & node2_edges = adjacency_list.find(edge_it.second)->second;
-
-    // Compute the intersection between the two adjacency lists to find
-    //  triplets (it will list the nodes that are connected to the first and
-    //  second)
-    node_candidate_for_triplet.clear();
-    std::set_intersection(node1_edges.cbegin(),
-                          node1_edges.cend(),
-                          node2_edges.cbegin(),
-                          node2_edges.cend(),
-                          std::back_inserter(node_candidate_for_triplet));
-    // Add a triplet
-    for (const auto & node_index_it : node_candidate_for_triplet)
+    std::vector<Triplet> & local_triplets = chunk_triplets[chunk];
+    const auto add_triplet = [&local_triplets](const Triplet & triplet)
     {
-      std::array<IndexT, 3> triplet_indexes {{
-        static_cast<IndexT>(edge_it.first),
-        static_cast<IndexT>(edge_it.second),
-        node_index_it}};
-      // sort the triplet indexes as i<j<k (monotonic ascending sorting)
-      std::sort(triplet_indexes.begin(), triplet_indexes.end());
-      triplets.emplace_back(triplet_indexes[0],
-                            triplet_indexes[1],
-                            triplet_indexes[2]);
+      local_triplets.push_back(triplet);
+    };
+    const IndexT chunk_end = std::min<IndexT>(adjacency.size(), (chunk + 1) * chunk_size);
+    for (IndexT u = chunk * chunk_size; u < chunk_end; ++u)
+    {
+      adjacency.VisitNodeTriplets(u, add_triplet);
     }
+  }
 
-    // Since we have already listed all the triplets than contain this edge.
-    // We can now remove the edge from the adjacency graph to reduce the
-    // node array size for the next iterations.
-    adjacency_list[edge_it.first].erase(edge_it.second);
-    adjacency_list[edge_it.second].erase(edge_it.first);
+  size_t triplet_count = 0;
+  for (const auto & local_triplets : chunk_triplets)
+    triplet_count += local_triplets.size();
+  triplets.reserve(triplet_count);
+  for (auto & local_triplets : chunk_triplets)
+  {
+    triplets.insert(triplets.end(), local_triplets.cbegin(), local_triplets.cend());
+    std::vector<Triplet>().swap(local_triplets);
   }
   return ( !triplets.empty() );
 }
@@ -11,7 +11,11 @@
 #include "CppUnitLite/TestHarness.h"
 #include "testing/testing.h"
 
+#include <atomic>
 #include <iostream>
+#include <random>
+#include <set>
+#include <tuple>
 #include <vector>
 
 using namespace openMVG::graph;
@@ -187,6 +191,63 @@ TEST(TripletFinder, test_for_triplet) {
   }
 }
 
+TEST(TripletFinder, test_visit_triplet) {
+
+  //
+  // a__b
+  // |\/|
+  // |/\|
+  // c--d
+  const int a = 0, b = 1, c = 2, d = 3;
+  const Pairs pairs = { {a,b}, {a,c}, {a,d}, {c,d}, {b,d}, {c,b} };
+
+  std::atomic<int> triplet_count(0);
+  VisitTriplets(pairs, [&triplet_count](const Triplet & triplet)
+  {
+    if (triplet.i < triplet.j && triplet.j < triplet.k)
+      ++triplet_count;
+  });
+  EXPECT_EQ(4, triplet_count);
+}
+
+TEST(TripletFinder, test_random_graph) {
+
+  // Compare the listed triplets to an exhaustive search on a random graph
+  // (with duplicated edges, inverted edges and self loops)
+  const int node_count = 60;
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> node_distribution(0, node_count - 1);
+  Pairs pairs;
+  std::set<std::pair<int,int>> edges;
+  for (int i = 0; i < 600; ++i)
+  {
+    const int a = node_distribution(random_generator);
+    const int b = node_distribution(random_generator);
+    pairs.emplace_back(a, b);
+    if (a != b)
+      edges.insert({std::min(a, b), std::max(a, b)});
+  }
+
+  std::set<std::tuple<int,int,int>> expected_triplets;
+  for (int i = 0; i < node_count; ++i)
+    for (int j = i + 1; j < node_count; ++j)
+      for (int k = j + 1; k < node_count; ++k)
+        if (edges.count({i, j}) && edges.count({j, k}) && edges.count({i, k}))
+          expected_triplets.insert(std::make_tuple(i, j, k));
+
+  std::vector<Triplet> vec_triplets;
+  EXPECT_TRUE(ListTriplets(pairs, vec_triplets));
+  EXPECT_EQ(expected_triplets.size(), vec_triplets.size());
+
+  std::set<std::tuple<int,int,int>> listed_triplets;
+  for (const Triplet & triplet : vec_triplets)
+  {
+    EXPECT_TRUE(triplet.i < triplet.j && triplet.j < triplet.k);
+    listed_triplets.insert(std::make_tuple(triplet.i, triplet.j, triplet.k));
+  }
+  EXPECT_TRUE(expected_triplets == listed_triplets);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
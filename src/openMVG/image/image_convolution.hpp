@@ -9,6 +9,7 @@
 #ifndef OPENMVG_IMAGE_IMAGE_CONVOLUTION_HPP
 #define OPENMVG_IMAGE_IMAGE_CONVOLUTION_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -104,7 +105,7 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
     {
       line[ k ] = start_pix;
     }
-    std::memcpy( &line[0] + half_kernel_width, img.data() + row * cols, sizeof( pix_t ) * cols );
+    std::memcpy( &line[0] + half_kernel_width, img.data() + static_cast<Eigen::Index>( row ) * cols, sizeof( pix_t ) * cols );
     const pix_t end_pix = img.coeffRef( row , cols - 1 );
     for (int k = 0; k < half_kernel_width; ++k ) // pad after
     {
@@ -114,13 +115,15 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
     // Apply convolution
     conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
 
-    std::memcpy( out.data() + row * cols, &line[0], sizeof( pix_t ) * cols );
+    std::memcpy( out.data() + static_cast<Eigen::Index>( row ) * cols, &line[0], sizeof( pix_t ) * cols );
   }
 }
 
 /**
  ** Vertical (1d) convolution
  ** assume kernel has odd size
+ ** The input rows are accumulated in a row buffer (contiguous memory accesses)
+ ** rather than filtering the image column by column.
  ** @param img Input image
  ** @param kernel convolution kernel
  ** @param out Output image
@@ -129,6 +132,7 @@ template<typename ImageTypeIn, typename ImageTypeOut, typename Kernel>
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out )
 {
   using pix_t = typename ImageTypeIn::Tpixel;
+  using kernel_t = typename Kernel::Scalar;
 
   const int kernel_width = kernel.size();
   const int half_kernel_width = kernel_width / 2;
@@ -136,32 +140,30 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
   const int rows = img.rows();
   const int cols = img.cols();
 
-  out.resize( cols , rows );
+  out.resize( cols , rows , false );
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t>> line( rows + kernel_width );
+  std::vector<kernel_t, Eigen::aligned_allocator<kernel_t>> sum( cols );
+  std::vector<pix_t, Eigen::aligned_allocator<pix_t>> line( cols );
 
-  for (int col = 0; col < cols; ++col )
+  for (int row = 0; row < rows; ++row )
   {
-    // Copy column
-    for (int k = 0; k < half_kernel_width; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col );
-    }
-    for (int k = 0; k < rows; ++k )
+    // Accumulate the weighted rows (border rows are repeated)
+    std::fill( sum.begin(), sum.end(), kernel_t( 0 ) );
+    for (int k = 0; k < kernel_width; ++k )
     {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col );
-    }
-    for (int k = 0; k < half_kernel_width; ++k )
-    {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col );
+      const int src_row = std::min( std::max( row + k - half_kernel_width, 0 ), rows - 1 );
+      const pix_t * src = img.data() + static_cast<Eigen::Index>( src_row ) * cols;
+      const kernel_t weight = kernel.data()[ k ];
+      for (int col = 0; col < cols; ++col )
+      {
+        sum[ col ] += src[ col ] * weight;
+      }
     }
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
-
-    for (int row = 0; row < rows; ++row )
+    for (int col = 0; col < cols; ++col )
     {
-      out.coeffRef( row , col ) = line[row];
+      line[ col ] = sum[ col ];
+      out.coeffRef( row , col ) = line[ col ];
     }
   }
 }
@@ -194,75 +196,64 @@ void ImageSeparableConvolution( const ImageType & img ,
 using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 
 /// Specialization for Float based image (for arbitrary sized kernel)
+/// The image is processed by strips of rows. For each output row, the input
+/// rows (kept in cache by the previous output rows of the strip) are
+/// accumulated in a row buffer by the vertical filter, and this buffer is then
+/// filtered horizontally. Both passes are vectorized row operations and no
+/// intermediate image is required.
+/// The borders are mirrored (-1 -> 1, size -> size - 2).
 inline void SeparableConvolution2d( const RowMatrixXf& image,
                                     const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                                     const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
                                     RowMatrixXf* out )
 {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
-
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
-#if defined(OPENMVG_USE_OPENMP)
-  #pragma omp parallel for schedule(dynamic)
-#endif
-  for ( int i = 0; i < half_sigma_y; i++ )
-  {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row( i ) = kernel_y.tail( forward_size ) *
-                    image.block( 0, 0, forward_size, image.cols() ) +
-                    reverse_kernel_y.tail( reverse_size ) *
-                    image.block( 1, 0, reverse_size, image.cols() );
-
-    // Apply the same technique for the end rows.
-    out->row( image.rows() - i - 1 ) =
-      kernel_y.head( forward_size ) *
-      image.block( image.rows() - forward_size, 0, forward_size, image.cols() )
-      +
-      reverse_kernel_y.head( reverse_size ) *
-      image.block( image.rows() - reverse_size - 1, 0, reverse_size, image.cols() );
-  }
-
-  // Applying the rest of the y filter.
-#if defined(OPENMVG_USE_OPENMP)
-  #pragma omp parallel for schedule(dynamic)
-#endif
-  for ( int row = half_sigma_y; row < image.rows() - half_sigma_y; row++ )
+  const int rows = static_cast<int>( image.rows() );
+  const int cols = static_cast<int>( image.cols() );
+  if ( rows == 0 || cols == 0 )
   {
-    out->row( row ) =  kernel_y * image.block( row - half_sigma_y, 0, sigma_y, out->cols() );
+    return;
   }
 
   const int sigma_x = static_cast<int>( kernel_x.cols() );
-  const int half_sigma_x = static_cast<int>( kernel_x.cols() / 2 );
+  const int half_sigma_x = sigma_x / 2;
+  const int sigma_y = static_cast<int>( kernel_y.cols() );
+  const int half_sigma_y = sigma_y / 2;
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row( image.cols() + sigma_x - 1 );
+  // Number of consecutive rows filtered by a thread
+  const int strip_height = 32;
+  const int strip_count = ( rows + strip_height - 1 ) / strip_height;
 #if defined(OPENMVG_USE_OPENMP)
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
+  #pragma omp parallel for schedule(dynamic)
 #endif
-  for ( int row = 0; row < out->rows(); row++ )
+  for ( int strip = 0; strip < strip_count; ++strip )
   {
-    temp_row.head( half_sigma_x ) =
-      out->row( row ).segment( 1, half_sigma_x ).reverse();
-    temp_row.segment( half_sigma_x, image.cols() ) = out->row( row );
-    temp_row.tail( half_sigma_x ) =
-      out->row( row )
-      .segment( image.cols() - 2 - half_sigma_x, half_sigma_x )
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row( row ) = kernel_x( 0 ) * temp_row.head( image.cols() );
-    for ( int i = 1; i < sigma_x; i++ )
+    // Vertically filtered row, padded with its mirrored borders
+    Eigen::RowVectorXf buffer( cols + 2 * half_sigma_x );
+    float * filtered_row = buffer.data() + half_sigma_x;
+    std::vector<const float *> inputs( std::max( sigma_x, sigma_y ) );
+
+    const int row_end = std::min( rows, ( strip + 1 ) * strip_height );
+    for ( int row = strip * strip_height; row < row_end; ++row )
     {
-      out->row( row ) += kernel_x( i ) * temp_row.segment( i, image.cols() );
+      // Vertical filter: weighted sum of the input rows
+      for ( int i = 0; i < sigma_y; ++i )
+      {
+        inputs[i] = image.data() + static_cast<Eigen::Index>( MirrorIndex( row - half_sigma_y + i, rows ) ) * cols;
+      }
+      conv_arrays_( inputs.data(), kernel_y.data(), sigma_y, filtered_row, cols );
+
+      for ( int i = 1; i <= half_sigma_x; ++i )
+      {
+        filtered_row[ -i ] = filtered_row[ MirrorIndex( -i, cols ) ];
+        filtered_row[ cols - 1 + i ] = filtered_row[ MirrorIndex( cols - 1 + i, cols ) ];
+      }
+
+      // Horizontal filter: use the row pixels as a sliding window around the filter.
+      for ( int i = 0; i < sigma_x; ++i )
+      {
+        inputs[i] = buffer.data() + i;
+      }
+      conv_arrays_( inputs.data(), kernel_x.data(), sigma_x, out->data() + static_cast<Eigen::Index>( row ) * cols, cols );
     }
   }
 }
@@ -287,7 +278,7 @@ void ImageSeparableConvolution( const Image<float> & img ,
   const VecKernel horiz_k_cast = horiz_k.template cast< typename openMVG::Accumulator<pix_t>::Type >();
   const VecKernel vert_k_cast = vert_k.template cast< typename openMVG::Accumulator<pix_t>::Type >();
 
-  out.resize( img.Width(), img.Height() );
+  out.resize( img.Width(), img.Height(), false );
   SeparableConvolution2d( img.GetMat(), horiz_k_cast, vert_k_cast, &out );
 }
 
@@ -11,10 +11,31 @@
 
 #include <cstddef>
 
+#include <Eigen/Core>
+
 namespace openMVG
 {
 namespace image
 {
+/**
+ ** Mirror an index inside [0, size) without repeating the border sample
+ ** (-1 -> 1, size -> size - 2), as the separable convolutions pad the images.
+ ** @param i index (possibly outside the range)
+ ** @param size range length
+**/
+inline int MirrorIndex( int i, const int size )
+{
+  if ( size == 1 )
+  {
+    return 0;
+  }
+  while ( i < 0 || i >= size )
+  {
+    i = ( i < 0 ) ? -i : 2 * ( size - 1 ) - i;
+  }
+  return i;
+}
+
 /**
  ** Filter an extended row [halfKernelSize][row][halfKernelSize]
  ** @param buffer data to filter
@@ -35,6 +56,42 @@ void conv_buffer_( T1* buffer, const T2* kernel, int rsize, int ksize )
     buffer[i] = sum;
   }
 }
+
+/**
+ ** Weighted sum of ksize arrays: out[i] = sum_j kernel[j] * inputs[j][i]
+ ** The outputs are computed by blocks held in (SIMD) registers, so each sum
+ ** is written once and each input is read once.
+ ** @param inputs array of ksize input pointers
+ ** @param kernel kernel array
+ ** @param ksize kernel length
+ ** @param out output array
+ ** @param size output length
+**/
+template<class T> inline
+void conv_arrays_( const T* const* inputs, const T* kernel, int ksize, T* out, int size )
+{
+  using Block = Eigen::Array<T, 32, 1>;
+  using ConstBlockMap = Eigen::Map<const Block, Eigen::Unaligned>;
+  int i = 0;
+  for ( ; i + Block::SizeAtCompileTime <= size; i += Block::SizeAtCompileTime )
+  {
+    Block sum = kernel[0] * ConstBlockMap( inputs[0] + i );
+    for ( int j = 1; j < ksize; ++j )
+    {
+      sum += kernel[j] * ConstBlockMap( inputs[j] + i );
+    }
+    Eigen::Map<Block, Eigen::Unaligned>( out + i ) = sum;
+  }
+  for ( ; i < size; ++i )
+  {
+    T sum = kernel[0] * inputs[0][i];
+    for ( int j = 1; j < ksize; ++j )
+    {
+      sum += kernel[j] * inputs[j][i];
+    }
+    out[i] = sum;
+  }
+}
 } // namespace image
 } // namespace openMVG
 
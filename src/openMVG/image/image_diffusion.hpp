@@ -21,6 +21,7 @@
 #include <omp.h>
 #endif
 
+#include "openMVG/image/image_convolution_base.hpp"
 #include "openMVG/numeric/numeric.h"
 
 namespace openMVG
@@ -51,6 +52,65 @@ void ImagePeronaMalikG2DiffusionCoef( const Image & Lx , const Image & Ly , cons
   out.array() = ( static_cast<Real>( 1.f ) + ( Lx.array().square() + Ly.array().square() ) / ( k * k ) ).inverse();
 }
 
+/**
+ ** Compute Perona and Malik G2 diffusion coefficient from the (non normalized)
+ ** 3x3 Scharr derivatives of an image.
+ ** Same result as ImageScharrXDerivative, ImageScharrYDerivative followed by
+ ** ImagePeronaMalikG2DiffusionCoef, but computed in a single pass over the image
+ ** (in parallel over the rows) without the derivatives images.
+ ** @param img Input image
+ ** @param k sensitivity factor
+ ** @param out output coefficient
+ **/
+template <typename Image>
+void ImageScharrPeronaMalikG2DiffusionCoef( const Image & img , const typename Image::Tpixel k , Image & out )
+{
+  using Real = typename Image::Tpixel;
+  const int width = img.Width();
+  const int height = img.Height();
+  const Eigen::Index stride = width; // Row offsets as Eigen::Index
+
+  out.resize( width , height , false );
+  if (width == 0 || height == 0)
+  {
+    return;
+  }
+
+  // The borders are mirrored as the separable convolution does
+  const Real k2 = k * k;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; ++i)
+  {
+    const Real * up = img.data() + MirrorIndex( i - 1 , height ) * stride;
+    const Real * row = img.data() + i * stride;
+    const Real * down = img.data() + MirrorIndex( i + 1 , height ) * stride;
+    Real * out_row = out.data() + i * stride;
+
+    const auto coef = [&]( const int j , const int j_left , const int j_right )
+    {
+      const Real lx = static_cast<Real>( 3 ) * ( up[ j_right ] - up[ j_left ] )
+                    + static_cast<Real>( 10 ) * ( row[ j_right ] - row[ j_left ] )
+                    + static_cast<Real>( 3 ) * ( down[ j_right ] - down[ j_left ] );
+      const Real ly = static_cast<Real>( 3 ) * ( down[ j_left ] - up[ j_left ] )
+                    + static_cast<Real>( 10 ) * ( down[ j ] - up[ j ] )
+                    + static_cast<Real>( 3 ) * ( down[ j_right ] - up[ j_right ] );
+      out_row[ j ] = static_cast<Real>( 1 ) / ( static_cast<Real>( 1 ) + ( lx * lx + ly * ly ) / k2 );
+    };
+
+    coef( 0 , MirrorIndex( -1 , width ) , MirrorIndex( 1 , width ) );
+    for (int j = 1; j < width - 1; ++j)
+    {
+      coef( j , j - 1 , j + 1 );
+    }
+    if (width > 1)
+    {
+      coef( width - 1 , width - 2 , MirrorIndex( width , width ) );
+    }
+  }
+}
+
 /**
 ** Apply Fast Explicit Diffusion to an Image (on central part)
 ** @param src input image
@@ -234,23 +294,97 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
   }
 }
 
+/**
+** Apply one Fast Explicit Diffusion step to an Image: out = src + FED(src)
+** Same result as ImageFED followed by the accumulation into src, but the
+** flux and the update are computed in a single pass over the image (in
+** parallel over the rows). There is no flux across the image borders.
+** @param src input image
+** @param diff diffusion coefficient image
+** @param half_t Half diffusion time
+** @param out Output image (must not be src)
+**/
+template<typename Image>
+void ImageFEDStep( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out )
+{
+  using Real = typename Image::Tpixel;
+  const int width = src.Width();
+  const int height = src.Height();
+  const Eigen::Index stride = width; // Row offsets as Eigen::Index
+
+  out.resize( width , height , false );
+
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; ++i)
+  {
+    const int i_up = std::max( i - 1 , 0 );
+    const int i_down = std::min( i + 1 , height - 1 );
+    const Real * src_up = src.data() + i_up * stride;
+    const Real * src_row = src.data() + i * stride;
+    const Real * src_down = src.data() + i_down * stride;
+    const Real * diff_up = diff.data() + i_up * stride;
+    const Real * diff_row = diff.data() + i * stride;
+    const Real * diff_down = diff.data() + i_down * stride;
+    Real * out_row = out.data() + i * stride;
+
+    // A border neighbor is the pixel itself (its flux is zero)
+    const auto step = [&]( const int j , const int j_left , const int j_right )
+    {
+      const Real cur_src = src_row[ j ];
+      const Real cur_diff = diff_row[ j ];
+      const Real a = ( cur_diff + diff_row[ j_right ] ) * ( src_row[ j_right ] - cur_src );
+      const Real b = ( cur_diff + diff_up[ j ] ) * ( cur_src - src_up[ j ] );
+      const Real c = ( cur_diff + diff_row[ j_left ] ) * ( cur_src - src_row[ j_left ] );
+      const Real d = ( cur_diff + diff_down[ j ] ) * ( src_down[ j ] - cur_src );
+      out_row[ j ] = cur_src + half_t * ( a - c + d - b );
+    };
+
+    step( 0 , 0 , std::min( 1 , width - 1 ) );
+    for (int j = 1; j < width - 1; ++j)
+    {
+      step( j , j - 1 , j + 1 );
+    }
+    if (width > 1)
+    {
+      step( width - 1 , width - 2 , width - 1 );
+    }
+  }
+}
+
 /**
  ** Compute Fast Explicit Diffusion cycle
  ** @param self input/output image
  ** @param diff diffusion coefficient
  ** @param tau cycle timing vector
+ ** @param tmp working image (its memory is reused if it has the size of self)
  **/
 template<typename Image>
-void ImageFEDCycle( Image & self , const Image & diff , const std::vector<typename Image::Tpixel > & tau )
+void ImageFEDCycle( Image & self , const Image & diff , const std::vector<typename Image::Tpixel > & tau , Image & tmp )
 {
-  Image tmp;
-  for (int i = 0; i < tau.size(); ++i)
+  using Real = typename Image::Tpixel;
+  for (const Real t : tau)
   {
-    ImageFED( self , diff , tau[i] , tmp );
-    self.array() += tmp.array();
+    ImageFEDStep( self , diff , t * static_cast<Real>( 0.5 ) , tmp );
+    // Exchange the buffers (no copy)
+    self.swap( tmp );
   }
 }
 
+/**
+ ** Compute Fast Explicit Diffusion cycle
+ ** @param self input/output image
+ ** @param diff diffusion coefficient
+ ** @param tau cycle timing vector
+ **/
+template<typename Image>
+void ImageFEDCycle( Image & self , const Image & diff , const std::vector<typename Image::Tpixel > & tau )
+{
+  Image tmp;
+  ImageFEDCycle( self , diff , tau , tmp );
+}
+
 /**
 * Compute if a number is prime of not
 * @param i Input number to test
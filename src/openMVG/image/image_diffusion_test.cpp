@@ -0,0 +1,98 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_diffusion.hpp"
+#include "openMVG/image/image_filtering.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::image;
+
+static Image<float> RandomImage(const int width, const int height)
+{
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  Image<float> image(width, height, false);
+  for (int i = 0; i < image.size(); ++i)
+    image.data()[i] = dist(rng);
+  return image;
+}
+
+TEST(ImageDiffusion, ScharrPeronaMalikG2DiffusionCoef)
+{
+  // Compare to the diffusion coefficient computed from the Scharr derivatives images
+  for (const auto & size : { std::make_pair(1, 1), std::make_pair(2, 3), std::make_pair(7, 5), std::make_pair(64, 48) })
+  {
+    const Image<float> image = RandomImage(size.first, size.second);
+    Image<float> Lx, Ly, expected, coef;
+    ImageScharrXDerivative(image, Lx, false);
+    ImageScharrYDerivative(image, Ly, false);
+    ImagePeronaMalikG2DiffusionCoef(Lx, Ly, 0.5f, expected);
+
+    ImageScharrPeronaMalikG2DiffusionCoef(image, 0.5f, coef);
+    EXPECT_EQ(expected.Width(), coef.Width());
+    EXPECT_EQ(expected.Height(), coef.Height());
+    EXPECT_MATRIX_NEAR(expected.GetMat(), coef.GetMat(), 1e-5);
+  }
+}
+
+TEST(ImageDiffusion, FEDStep)
+{
+  const Image<float> image = RandomImage(64, 48);
+  Image<float> diff;
+  ImageScharrPeronaMalikG2DiffusionCoef(image, 0.5f, diff);
+
+  // Compare to the FED update image accumulated in the image
+  Image<float> update;
+  ImageFED(image, diff, 0.25f, update);
+  const Image<float> expected(image.GetMat() + update.GetMat());
+
+  Image<float> out;
+  ImageFEDStep(image, diff, 0.125f, out);
+  // ImageFED does not update the corners
+  for (int i = 1; i < image.Height() - 1; ++i)
+  {
+    for (int j = 0; j < image.Width(); ++j)
+    {
+      EXPECT_NEAR(expected(i, j), out(i, j), 1e-6);
+    }
+  }
+  for (int j = 1; j < image.Width() - 1; ++j)
+  {
+    EXPECT_NEAR(expected(0, j), out(0, j), 1e-6);
+    EXPECT_NEAR(expected(image.Height() - 1, j), out(image.Height() - 1, j), 1e-6);
+  }
+
+  // There is no flux across the borders: the image mass is preserved
+  EXPECT_NEAR(image.GetMat().cast<double>().sum(), out.GetMat().cast<double>().sum(), 1e-3);
+}
+
+TEST(ImageDiffusion, FEDCycle)
+{
+  for (const auto & size : { std::make_pair(1, 1), std::make_pair(1, 7), std::make_pair(64, 48) })
+  {
+    const Image<float> image = RandomImage(size.first, size.second);
+    Image<float> diff;
+    ImageScharrPeronaMalikG2DiffusionCoef(image, 0.5f, diff);
+    std::vector<float> tau;
+    FEDCycleTimings(2.f, 0.25f, tau);
+
+    // The working image memory is reused (and its content does not matter)
+    Image<float> evolution = image, recycled = image, tmp(3, 2);
+    ImageFEDCycle(evolution, diff, tau);
+    ImageFEDCycle(recycled, diff, tau, tmp);
+    EXPECT_MATRIX_NEAR(evolution.GetMat(), recycled.GetMat(), 1e-8);
+    EXPECT_NEAR(image.GetMat().cast<double>().sum(), evolution.GetMat().cast<double>().sum(), 1e-3);
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
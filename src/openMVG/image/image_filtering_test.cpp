@@ -12,6 +12,7 @@
 #include "testing/testing.h"
 
 #include <iostream>
+#include <random>
 
 using namespace openMVG;
 using namespace openMVG::image;
@@ -130,6 +131,79 @@ TEST(Image, Convolution_Sobel_X_Y)
   EXPECT_TRUE(WriteImage("out_SobelY.png", Image<unsigned char>(outFiltered.cast<unsigned char>())));
 }
 
+// Direct 2D separable convolution (border pixels are mirrored)
+Image<float> ReferenceSeparableConvolution
+(
+  const Image<float> & in,
+  const Vec & kernel_x,
+  const Vec & kernel_y
+)
+{
+  const auto mirror = [](int i, const int size)
+  {
+    while (i < 0 || i >= size)
+      i = (i < 0) ? -i : 2 * (size - 1) - i;
+    return i;
+  };
+  Image<float> out(in.Width(), in.Height());
+  for (int y = 0; y < in.Height(); ++y)
+    for (int x = 0; x < in.Width(); ++x)
+    {
+      double sum = 0.0;
+      for (int j = 0; j < kernel_y.size(); ++j)
+        for (int i = 0; i < kernel_x.size(); ++i)
+          sum += kernel_y(j) * kernel_x(i)
+            * in(mirror(y + j - kernel_y.size() / 2, in.Height()),
+                 mirror(x + i - kernel_x.size() / 2, in.Width()));
+      out(y, x) = sum;
+    }
+  return out;
+}
+
+TEST(Image, Convolution_Separable_Float_Borders)
+{
+  Image<float> in(67, 45);
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> dist(0.f, 255.f);
+  for (int i = 0; i < in.size(); ++i)
+    in.data()[i] = dist(rng);
+
+  // Odd and even sized kernels (ImageGaussianFilter can produce both)
+  for (const double sigma : {0.8, 1.6, 3.2})
+  {
+    for (const int kernel_size : {5, 8, 21})
+    {
+      const Vec kernel = ComputeGaussianKernel(kernel_size, sigma);
+      Image<float> out;
+      ImageSeparableConvolution(in, kernel, kernel, out);
+      const Image<float> expected = ReferenceSeparableConvolution(in, kernel, kernel);
+      EXPECT_MATRIX_NEAR(expected, out, 1e-3);
+    }
+  }
+}
+
+TEST(Image, Convolution_Vertical_Rows)
+{
+  Image<float> in(67, 45);
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> dist(0.f, 255.f);
+  for (int i = 0; i < in.size(); ++i)
+    in.data()[i] = dist(rng);
+
+  // The border rows are repeated
+  const Vec kernel = ComputeGaussianKernel(9, 2.0);
+  Image<float> out;
+  ImageVerticalConvolution(in, kernel, out);
+  for (int y = 0; y < in.Height(); ++y)
+    for (int x = 0; x < in.Width(); ++x)
+    {
+      double sum = 0.0;
+      for (int j = 0; j < kernel.size(); ++j)
+        sum += kernel(j) * in(std::min(std::max(y + j - 4, 0), in.Height() - 1), x);
+      EXPECT_NEAR(sum, out(y, x), 1e-3);
+    }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
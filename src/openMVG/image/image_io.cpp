@@ -8,6 +8,7 @@
 
 #include "openMVG/image/image_io.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 
@@ -78,6 +79,108 @@ int ReadImage(const char *filename,
   };
 }
 
+int GetReadScaleDenominator(int width, int height, const ImageReadOptions & options)
+{
+  int denominator = 1;
+  if (options.max_dimension > 0)
+  {
+    const int max_size = std::max(width, height);
+    while (denominator < 8 && (max_size + denominator - 1) / denominator > options.max_dimension)
+      denominator *= 2;
+  }
+  return denominator;
+}
+
+// Convert a decoded image buffer to the requested color space
+static bool ConvertColorSpace(ColorSpace color_space,
+                              std::vector<unsigned char> * ptr,
+                              int w,
+                              int h,
+                              int * depth) {
+  const size_t pixel_count = static_cast<size_t>(w) * h;
+  if (color_space == ColorSpace::Native
+      || (color_space == ColorSpace::Gray && *depth == 1)
+      || (color_space == ColorSpace::Rgb && *depth == 3))
+    return true;
+
+  std::vector<unsigned char> converted(pixel_count * (color_space == ColorSpace::Gray ? 1 : 3));
+  if (color_space == ColorSpace::Gray && *depth == 3) {
+    const RGBColor * pixels = reinterpret_cast<const RGBColor*>(ptr->data());
+    for (size_t i = 0; i < pixel_count; ++i)
+      Convert(pixels[i], converted[i]);
+  } else if (color_space == ColorSpace::Gray && *depth == 4) {
+    const RGBAColor * pixels = reinterpret_cast<const RGBAColor*>(ptr->data());
+    for (size_t i = 0; i < pixel_count; ++i)
+      Convert(pixels[i], converted[i]);
+  } else if (color_space == ColorSpace::Rgb && *depth == 1) {
+    RGBColor * pixels = reinterpret_cast<RGBColor*>(converted.data());
+    for (size_t i = 0; i < pixel_count; ++i)
+      pixels[i] = RGBColor((*ptr)[i]);
+  } else if (color_space == ColorSpace::Rgb && *depth == 4) {
+    const RGBAColor * rgba_pixels = reinterpret_cast<const RGBAColor*>(ptr->data());
+    RGBColor * pixels = reinterpret_cast<RGBColor*>(converted.data());
+    for (size_t i = 0; i < pixel_count; ++i)
+      Convert(rgba_pixels[i], pixels[i]);
+  } else {
+    OPENMVG_LOG_ERROR << "Unsupported color conversion from " << *depth << " channel(s)";
+    return false;
+  }
+  ptr->swap(converted);
+  *depth = (color_space == ColorSpace::Gray) ? 1 : 3;
+  return true;
+}
+
+// Downscale a decoded image buffer (box filter over denominator x denominator pixels)
+static void Downscale(int denominator,
+                      std::vector<unsigned char> * ptr,
+                      int * w,
+                      int * h,
+                      int depth) {
+  if (denominator <= 1)
+    return;
+  const int out_w = (*w + denominator - 1) / denominator;
+  const int out_h = (*h + denominator - 1) / denominator;
+  std::vector<unsigned char> downscaled(static_cast<size_t>(out_w) * out_h * depth);
+  std::vector<int> sums(static_cast<size_t>(out_w) * depth);
+  for (int y = 0; y < out_h; ++y) {
+    std::fill(sums.begin(), sums.end(), 0);
+    const int y_end = std::min(*h, (y + 1) * denominator);
+    for (int yy = y * denominator; yy < y_end; ++yy) {
+      const unsigned char * row = &(*ptr)[static_cast<size_t>(yy) * (*w) * depth];
+      for (int x = 0; x < *w; ++x)
+        for (int c = 0; c < depth; ++c)
+          sums[(x / denominator) * depth + c] += row[x * depth + c];
+    }
+    const int row_count = y_end - y * denominator;
+    for (int x = 0; x < out_w; ++x) {
+      const int count = row_count * (std::min(*w, (x + 1) * denominator) - x * denominator);
+      for (int c = 0; c < depth; ++c)
+        downscaled[(static_cast<size_t>(y) * out_w + x) * depth + c] =
+          static_cast<unsigned char>((sums[x * depth + c] + count / 2) / count);
+    }
+  }
+  ptr->swap(downscaled);
+  *w = out_w;
+  *h = out_h;
+}
+
+int ReadImage(const char *filename,
+              std::vector<unsigned char> * ptr,
+              int * w,
+              int * h,
+              int * depth,
+              const ImageReadOptions & options) {
+  // JPEG images are downscaled and converted by the decoder
+  if (GetFormat(filename) == Jpg)
+    return ReadJpg(filename, ptr, w, h, depth, options);
+
+  if (!ReadImage(filename, ptr, w, h, depth)
+      || !ConvertColorSpace(options.color_space, ptr, *w, *h, depth))
+    return 0;
+  Downscale(GetReadScaleDenominator(*w, *h, options), ptr, w, h, *depth);
+  return 1;
+}
+
 int WriteImage(const char * filename,
               const std::vector<unsigned char> & ptr,
               int w,
@@ -104,13 +207,22 @@ int ReadJpg(const char * filename,
             int * w,
             int * h,
             int * depth) {
+  return ReadJpg(filename, ptr, w, h, depth, ImageReadOptions());
+}
+
+int ReadJpg(const char * filename,
+            std::vector<unsigned char> * ptr,
+            int * w,
+            int * h,
+            int * depth,
+            const ImageReadOptions & options) {
 
   FILE *file = fopen(filename, "rb");
   if (!file) {
     OPENMVG_LOG_ERROR << "Couldn't open " << filename << " fopen returned 0";
     return 0;
   }
-  const int res = ReadJpgStream(file, ptr, w, h, depth);
+  const int res = ReadJpgStream(file, ptr, w, h, depth, options);
   fclose(file);
   return res;
 }
@@ -133,7 +245,20 @@ int ReadJpgStream(FILE * file,
                   int * w,
                   int * h,
                   int * depth) {
+  return ReadJpgStream(file, ptr, w, h, depth, ImageReadOptions());
+}
+
+int ReadJpgStream(FILE * file,
+                  std::vector<unsigned char> * ptr,
+                  int * w,
+                  int * h,
+                  int * depth,
+                  const ImageReadOptions & options) {
   jpeg_decompress_struct cinfo;
+  // Row pointers of the scanlines decoded per call (a fixed array: nothing
+  // is allocated between setjmp and a possible longjmp from the decoder)
+  const JDIMENSION max_rows_per_call = 16;
+  JSAMPROW rows[max_rows_per_call];
   struct my_error_mgr jerr;
   cinfo.err = jpeg_std_error(&jerr.pub);
   jerr.pub.error_exit = &jpeg_error;
@@ -147,6 +272,14 @@ int ReadJpgStream(FILE * file,
   jpeg_create_decompress(&cinfo);
   jpeg_stdio_src(&cinfo, file);
   jpeg_read_header(&cinfo, TRUE);
+
+  // Downscaling in the DCT domain (1/2, 1/4, 1/8)
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = GetReadScaleDenominator(cinfo.image_width, cinfo.image_height, options);
+  // Luminance only decoding (the chroma components are not decoded)
+  if (options.color_space == ColorSpace::Gray
+      && (cinfo.jpeg_color_space == JCS_YCbCr || cinfo.jpeg_color_space == JCS_GRAYSCALE))
+    cinfo.out_color_space = JCS_GRAYSCALE;
   jpeg_start_decompress(&cinfo);
 
   const int row_stride = cinfo.output_width * cinfo.output_components;
@@ -156,17 +289,20 @@ int ReadJpgStream(FILE * file,
   *depth = cinfo.output_components;
   ptr->resize((*h)*(*w)*(*depth));
 
-  unsigned char *ptrCpy = &(*ptr)[0];
-
+  // Let the decoder output several scanlines per call
   while (cinfo.output_scanline < cinfo.output_height) {
-    JSAMPROW scanline[1] = { ptrCpy };
-    jpeg_read_scanlines(&cinfo, scanline, 1);
-    ptrCpy += row_stride;
+    const JDIMENSION nb_rows =
+      std::min(max_rows_per_call, cinfo.output_height - cinfo.output_scanline);
+    for (JDIMENSION k = 0; k < nb_rows; ++k)
+      rows[k] = &(*ptr)[static_cast<size_t>(cinfo.output_scanline + k) * row_stride];
+    jpeg_read_scanlines(&cinfo, rows, nb_rows);
   }
 
   jpeg_finish_decompress(&cinfo);
   jpeg_destroy_decompress(&cinfo);
-  return 1;
+
+  // Conversions that are not handled by the decoder (i.e. gray to RGB)
+  return ConvertColorSpace(options.color_space, ptr, *w, *h, depth) ? 1 : 0;
 }
 
 
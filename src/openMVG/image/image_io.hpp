@@ -42,6 +42,44 @@ enum Format
   Pnm, Png, Jpg, Tiff, Unknown
 };
 
+/**
+* @enum ColorSpace Color space of a decoded image
+* @var Native
+*   Color space of the file (gray, RGB or RGBA)
+* @var Gray
+*   Luminance (depth 1)
+* @var Rgb
+*   Red, green, blue (depth 3)
+*/
+enum class ColorSpace
+{
+  Native, Gray, Rgb
+};
+
+/**
+* @brief Decoding options of ReadImage
+*/
+struct ImageReadOptions
+{
+  /// Largest dimension of the decoded image (0 means full resolution).
+  /// The image is downscaled by 2, 4 or 8 until it fits (8 at most).
+  /// JPEG images are downscaled in the DCT domain while they are decoded.
+  int max_dimension = 0;
+
+  /// Color space of the decoded image
+  ColorSpace color_space = ColorSpace::Native;
+};
+
+/**
+* @brief Downscaling factor that ReadImage applies to an image
+* @param width Width of the full resolution image
+* @param height Height of the full resolution image
+* @param options Decoding options
+* @return The scale denominator (1, 2, 4 or 8). The decoded image size is
+*  ceil(width / denominator) x ceil(height / denominator).
+*/
+int GetReadScaleDenominator( int width, int height, const ImageReadOptions & options );
+
 
 /**
 * @brief Get format of an image
@@ -84,6 +122,27 @@ int WriteImage( const char * path , const Image<T>& image );
 */
 int ReadImage( const char * path, std::vector<unsigned char> * image , int * w, int * h, int * depth );
 
+/**
+* @brief Unsigned char specialization, with decoding options
+* @param path Input path of the image to load
+* @param[out] image Output image
+* @param[out] w Width of the loaded image
+* @param[out] h Height of the loaded image
+* @param[out] depth Depth of the image
+* @param options Target size and color space
+* @retval 1 If loading is correct
+* @retval 0 If there was an error during load operation
+*/
+int ReadImage
+(
+  const char * path,
+  std::vector<unsigned char> * image,
+  int * w,
+  int * h,
+  int * depth,
+  const ImageReadOptions & options
+);
+
 /**
 * @brief Unsigned char specialization
 * @param path Output path of the image to save
@@ -163,6 +222,27 @@ int WritePngStream( FILE * stream ,  const std::vector<unsigned char>& array, in
 */
 int ReadJpg( const char * path , std::vector<unsigned char> * array, int * w, int * h, int * depth );
 
+/**
+* @brief Read JPEG image from file, with decoding options
+* @param[in] path Input filepath
+* @param[out] array Output image data
+* @param[out] w Image width
+* @param[out] h Image height
+* @param[out] depth Depth of image
+* @param options Target size and color space
+* @retval 0 if there is an error during read operation
+* @return non nul value if read operation is valid
+*/
+int ReadJpg
+(
+  const char * path,
+  std::vector<unsigned char> * array,
+  int * w,
+  int * h,
+  int * depth,
+  const ImageReadOptions & options
+);
+
 /**
 * @brief Read JPEG image from stream
 * @param[in] stream Input data stream
@@ -175,6 +255,29 @@ int ReadJpg( const char * path , std::vector<unsigned char> * array, int * w, in
 */
 int ReadJpgStream( FILE * stream , std::vector<unsigned char> * array, int * w, int * h, int * depth );
 
+/**
+* @brief Read JPEG image from stream, with decoding options
+* @param[in] stream Input data stream
+* @param[out] array Output image data
+* @param[out] w Image width
+* @param[out] h Image height
+* @param[out] depth Depth of image
+* @param options Target size and color space
+* @retval 0 if there is an error during read operation
+* @return non nul value if read operation is valid
+* @note The downscaling and the gray conversion are done by libjpeg
+*  (DCT domain scaling and luminance only decoding).
+*/
+int ReadJpgStream
+(
+  FILE * stream,
+  std::vector<unsigned char> * array,
+  int * w,
+  int * h,
+  int * depth,
+  const ImageReadOptions & options
+);
+
 /**
 * @brief Write JPEG file
 * @param path Output image path
@@ -357,46 +460,39 @@ bool Read_TIFF_ImageHeader( const char * path , ImageHeader * hdr );
 
 
 /**
-* @brief Generic Image read from file
+* @brief Gray image read from file, with decoding options
 * @param[in] path Input image path
 * @param[out] im Ouput image
-* @retval 0 if there was an errir during read operation
+* @param options Target size
+* @retval 0 if there was an error during read operation
 * @retval 1 if read is correct
 */
-template<>
-inline int ReadImage( const char * path, Image<unsigned char> * im )
+inline int ReadImage( const char * path, Image<unsigned char> * im, const ImageReadOptions & options )
 {
+  ImageReadOptions gray_options = options;
+  gray_options.color_space = ColorSpace::Gray;
   std::vector<unsigned char> ptr;
   int w, h, depth;
-  const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( res == 1 && depth == 1 )
-  {
-    //convert raw array to Image
-    ( *im ) = Eigen::Map<Image<unsigned char>::Base>( &ptr[0], h, w );
-  }
-  else if ( res == 1 && depth == 3 )
-  {
-    //-- Must convert RGB to gray
-    RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
-    Image<RGBColor> rgbColIm;
-    rgbColIm = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
-    //convert RGB to gray
-    ConvertPixelType( rgbColIm, im );
-  }
-  else if ( res == 1 && depth == 4 )
-  {
-    //-- Must convert RGBA to gray
-    RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
-    Image<RGBAColor> rgbaColIm;
-    rgbaColIm = Eigen::Map<Image<RGBAColor>::Base>( ptrCol, h, w );
-    //convert RGBA to gray
-    ConvertPixelType( rgbaColIm, im );
-  }
-  else if ( depth != 1 )
+  if ( !ReadImage( path, &ptr, &w, &h, &depth, gray_options ) || depth != 1 )
   {
     return 0;
   }
-  return res;
+  ( *im ) = Eigen::Map<Image<unsigned char>::Base>( &ptr[0], h, w );
+  return 1;
+}
+
+/**
+* @brief Generic Image read from file
+* @param[in] path Input image path
+* @param[out] im Ouput image
+* @retval 0 if there was an errir during read operation
+* @retval 1 if read is correct
+*/
+template<>
+inline int ReadImage( const char * path, Image<unsigned char> * im )
+{
+  // Decode the luminance only (no RGB buffer and conversion for JPEG images)
+  return ReadImage( path, im, ImageReadOptions() );
 }
 
 
@@ -461,6 +557,29 @@ inline int ReadImage( const char * path, Image<RGBAColor> * im )
   return res;
 }
 
+/**
+* @brief RGB image read from file, with decoding options
+* @param[in] path Input image path
+* @param[out] im Ouput image
+* @param options Target size
+* @retval 0 if there was an error during read operation
+* @retval 1 if read is correct
+*/
+inline int ReadImage( const char * path, Image<RGBColor> * im, const ImageReadOptions & options )
+{
+  ImageReadOptions rgb_options = options;
+  rgb_options.color_space = ColorSpace::Rgb;
+  std::vector<unsigned char> ptr;
+  int w, h, depth;
+  if ( !ReadImage( path, &ptr, &w, &h, &depth, rgb_options ) || depth != 3 )
+  {
+    return 0;
+  }
+  RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
+  ( *im ) = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
+  return 1;
+}
+
 //--------
 //-- Image Writing
 //--------
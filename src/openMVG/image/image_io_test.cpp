@@ -225,6 +225,96 @@ TEST(ImageIOTest, Tiff_RGBA) {
   remove(filename.c_str());
 }
 
+TEST(ImageReadOptions, ScaleDenominator) {
+  ImageReadOptions options;
+  EXPECT_EQ(1, GetReadScaleDenominator(4000, 3000, options));
+  options.max_dimension = 4000;
+  EXPECT_EQ(1, GetReadScaleDenominator(4000, 3000, options));
+  options.max_dimension = 2000;
+  EXPECT_EQ(2, GetReadScaleDenominator(4000, 3000, options));
+  EXPECT_EQ(4, GetReadScaleDenominator(3000, 4001, options));
+  options.max_dimension = 100;
+  // The downscaling is bounded to 1/8
+  EXPECT_EQ(8, GetReadScaleDenominator(4000, 3000, options));
+}
+
+TEST(ImageReadOptions, Jpg_Downscaled) {
+  // Smooth color gradient
+  Image<RGBColor> image(64, 48);
+  for (int y = 0; y < image.Height(); ++y)
+    for (int x = 0; x < image.Width(); ++x)
+      image(y, x) = RGBColor(x * 4, y * 5, 128);
+  const std::string filename = ("test_read_options.jpg");
+  EXPECT_TRUE(WriteJpg(filename.c_str(), image, 100));
+
+  Image<unsigned char> gray_full, gray;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &gray_full));
+  ImageReadOptions options;
+  options.max_dimension = 16;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &gray, options));
+  EXPECT_EQ(16, gray.Width());
+  EXPECT_EQ(12, gray.Height());
+  // The decoded pixels are the average of the full resolution ones
+  for (int y = 0; y < gray.Height(); ++y)
+    for (int x = 0; x < gray.Width(); ++x)
+      EXPECT_NEAR(gray_full.block(y * 4, x * 4, 4, 4).cast<double>().mean(), gray(y, x), 3.0);
+
+  Image<RGBColor> color;
+  options.max_dimension = 32;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &color, options));
+  EXPECT_EQ(32, color.Width());
+  EXPECT_EQ(24, color.Height());
+  EXPECT_NEAR(128, color(10, 10).b(), 3);
+
+  // Raw buffer with the native color space
+  std::vector<unsigned char> buffer;
+  int w, h, depth;
+  options.max_dimension = 8;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &buffer, &w, &h, &depth, options));
+  EXPECT_EQ(8, w);
+  EXPECT_EQ(6, h);
+  EXPECT_EQ(3, depth);
+  EXPECT_EQ(8 * 6 * 3, buffer.size());
+  remove(filename.c_str());
+}
+
+TEST(ImageReadOptions, Jpg_GrayToRgb) {
+  Image<RGBColor> image;
+  const std::string jpg_filename = string(THIS_SOURCE_DIR) + "/image_test/two_pixels_monochrome.jpg";
+  EXPECT_TRUE(ReadImage(jpg_filename.c_str(), &image, ImageReadOptions()));
+  EXPECT_EQ(2, image.Width());
+  EXPECT_EQ(1, image.Height());
+  EXPECT_EQ(image(0,0), RGBColor((unsigned char)255));
+  EXPECT_EQ(image(0,1), RGBColor((unsigned char)0));
+}
+
+TEST(ImageReadOptions, Png_Downscaled) {
+  // Formats without decoder side scaling are downscaled after decoding
+  Image<unsigned char> image(5, 3);
+  image << 0, 2, 4, 6, 8,
+           2, 4, 6, 8, 10,
+           100, 100, 100, 100, 50;
+  const std::string filename = ("test_read_options.png");
+  EXPECT_TRUE(WriteImage(filename.c_str(), image));
+
+  ImageReadOptions options;
+  options.max_dimension = 3;
+  Image<unsigned char> gray;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &gray, options));
+  EXPECT_EQ(3, gray.Width());
+  EXPECT_EQ(2, gray.Height());
+  EXPECT_EQ(2, gray(0, 0));
+  EXPECT_EQ(6, gray(0, 1));
+  EXPECT_EQ(9, gray(0, 2));
+  EXPECT_EQ(100, gray(1, 0));
+  EXPECT_EQ(50, gray(1, 2));
+
+  Image<RGBColor> color;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &color, options));
+  EXPECT_EQ(color(0, 1), RGBColor((unsigned char)6));
+  remove(filename.c_str());
+}
+
 TEST(ImageHeader, AllFormats) {
 
   const std::vector<std::string> ext_Type = {"jpg", "png", "tif", "png", "pgm"};
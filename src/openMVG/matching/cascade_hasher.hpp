@@ -248,6 +248,9 @@ public:
 
   // Matches two collection of hashed descriptions with a fast matching scheme
   // based on the hash codes previously generated.
+  // If pvec_reverse_indices is set, it collects for each descriptions2 row
+  // the index of its nearest descriptions1 row, among the rows for which it
+  // has been a candidate (-1 if none), from the already computed distances.
   template <typename MatrixT, typename DistanceType>
   void Match_HashedDescriptions
   (
@@ -257,7 +260,8 @@ public:
     const MatrixT & descriptions2,
     IndMatches * pvec_indices,
     std::vector<DistanceType> * pvec_distances,
-    const int NN = 2
+    const int NN = 2,
+    std::vector<int> * pvec_reverse_indices = nullptr
   ) const
   {
     using MetricT = L2<typename MatrixT::Scalar>;
@@ -285,6 +289,14 @@ public:
     // feature for matching (i.e., prevents duplicates).
     std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
 
+    // Nearest descriptions1 row of each descriptions2 row
+    std::vector<DistanceType> reverse_distances;
+    if (pvec_reverse_indices)
+    {
+      pvec_reverse_indices->assign(hashed_descriptions2.hashed_desc.size(), -1);
+      reverse_distances.resize(hashed_descriptions2.hashed_desc.size());
+    }
+
     using HammingMetricType = matching::Hamming<stl::dynamic_bitset::BlockType>;
     static const HammingMetricType metricH = {};
     for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
@@ -348,6 +360,14 @@ public:
             descriptions1.cols());
 
           candidate_euclidean_distances.emplace_back(distance, candidate_id);
+
+          if (pvec_reverse_indices &&
+              ((*pvec_reverse_indices)[candidate_id] == -1 ||
+               distance < reverse_distances[candidate_id]))
+          {
+            (*pvec_reverse_indices)[candidate_id] = i;
+            reverse_distances[candidate_id] = distance;
+          }
         }
       }
 
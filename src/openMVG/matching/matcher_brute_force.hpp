@@ -12,7 +12,9 @@
 #include <algorithm>
 #include <memory>
 #include <future>
+#include <limits>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "openMVG/numeric/numeric.h"
@@ -80,7 +82,7 @@ class ArrayMatcherBruteForce : public ArrayMatcher<Scalar, Metric>
 
     IndMatches vec_index(1);
     std::vector<DistanceType> dist(1);
-    SearchNeighbours_func(query, 0, 1, &vec_index, &dist, 1);
+    SearchNeighbours_func(query, 0, 1, &vec_index, &dist, 1, nullptr);
     indice[0] = vec_index[0].j_;
     distance[0] = dist[0];
     return true;
@@ -104,6 +106,51 @@ class ArrayMatcherBruteForce : public ArrayMatcher<Scalar, Metric>
     std::vector<DistanceType> * pvec_distances,
     size_t NN
   ) override
+  {
+    return Search(query, nbQuery, pvec_indices, pvec_distances, NN, nullptr);
+  };
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query and the nearest
+   *  query of each dataset array, from the same distance computations.
+   *
+   * \param[in]   query     The query array.
+   * \param[in]   nbQuery   The number of query rows.
+   * \param[out]  indices   The corresponding (query, neighbor) indices.
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[in]  NN        The number of maximal neighbor that will be searched.
+   * \param[out]  reverse_indices For each dataset array, the index of its nearest query.
+   *
+   * \return True if success.
+   */
+  bool SearchMutualNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN,
+    std::vector<int> * pvec_reverse_indices
+  ) override
+  {
+    return Search(query, nbQuery, pvec_indices, pvec_distances, NN, pvec_reverse_indices);
+  }
+
+private:
+  using BaseMat = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  /// Use a memory mapping in order to avoid memory re-allocation
+  std::unique_ptr< Eigen::Map<BaseMat>> memMapping;
+
+  /// Nearest query (distance, query index) of each dataset array
+  using ReverseNeighbours = std::vector<std::pair<DistanceType, int>>;
+
+  bool Search
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN,
+    std::vector<int> * pvec_reverse_indices
+  )
   {
     if (!memMapping ||
         NN > memMapping->rows() ||
@@ -120,6 +167,12 @@ class ArrayMatcherBruteForce : public ArrayMatcher<Scalar, Metric>
     std::vector<int> range;
     SplitRange((int)0 , (int)nbQuery , nb_thread , range);
 
+    // Each range keeps its own nearest queries, merged once the ranges are done
+    std::vector<ReverseNeighbours> reverse_neighbours(
+      pvec_reverse_indices ? range.size() - 1 : 0,
+      ReverseNeighbours(memMapping->rows(),
+        {std::numeric_limits<DistanceType>::max(), -1}));
+
     std::vector<std::future<void>> fut;
     for (size_t i = 1; i < range.size(); ++i)
     {
@@ -133,20 +186,28 @@ class ArrayMatcherBruteForce : public ArrayMatcher<Scalar, Metric>
           range[i],
           pvec_indices,
           pvec_distances,
-          NN));
+          NN,
+          pvec_reverse_indices ? &reverse_neighbours[i-1] : nullptr));
     }
 
     for (const auto & fut_it : fut)
     {
       fut_it.wait();
     }
-    return true;
-  };
 
-private:
-  using BaseMat = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
-  /// Use a memory mapping in order to avoid memory re-allocation
-  std::unique_ptr< Eigen::Map<BaseMat>> memMapping;
+    if (pvec_reverse_indices)
+    {
+      pvec_reverse_indices->resize(memMapping->rows());
+      for (typename BaseMat::Index i = 0; i < memMapping->rows(); ++i)
+      {
+        std::pair<DistanceType, int> nearest = reverse_neighbours[0][i];
+        for (size_t r = 1; r < reverse_neighbours.size(); ++r)
+          nearest = std::min(nearest, reverse_neighbours[r][i]);
+        (*pvec_reverse_indices)[i] = nearest.second;
+      }
+    }
+    return true;
+  }
 
   /**
      * Search the N nearest Neighbor for a section of index of the scalar array query.
@@ -157,6 +218,7 @@ private:
      * \param[out]  indices   The corresponding (query, neighbor) indices (updated for the range).
      * \param[out]  distances The distances between the matched arrays (update for the range).
      * \param[in]  NN        The number of maximal neighbor that will be searched.
+     * \param[in,out] reverse_neighbours The nearest query of each dataset array (optional).
      *
      * \return True if success.
      */
@@ -167,7 +229,8 @@ private:
     size_t query_stop_index,
     IndMatches * pvec_indices,
     std::vector<DistanceType> * pvec_distances,
-    size_t NN
+    size_t NN,
+    ReverseNeighbours * reverse_neighbours
   )
   {
     // Compute the corresponding nearest neighbor(s) for the
@@ -185,6 +248,14 @@ private:
           (*memMapping).data() + i * memMapping->cols(),
           memMapping->cols());
       }
+      if (reverse_neighbours)
+      {
+        for (typename BaseMat::Index i = 0; i < memMapping->rows(); ++i)
+        {
+          (*reverse_neighbours)[i] = std::min((*reverse_neighbours)[i],
+            std::make_pair(vec_distance[i], static_cast<int>(queryIndex)));
+        }
+      }
 
       // Find the N minimum distances
       const int maxMinFound = static_cast<int>(std::min(size_t(NN), vec_distance.size()));
@@ -107,6 +107,31 @@ class ArrayMatcherCascadeHashing  : public ArrayMatcher<Scalar, Metric>
     std::vector<DistanceType> * pvec_distances,
     size_t NN
   )
+  {
+    return SearchMutualNeighbours(query, nbQuery, pvec_indices, pvec_distances, NN, nullptr);
+  };
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query and, among the
+   *  candidates compared to the queries, the nearest query of each dataset array.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances  The distances between the matched arrays.
+   * \param[in]   NN        The number of maximal neighbor that will be searched.
+   * \param[out]  reverse_indices For each dataset array, the index of its nearest query.
+   *
+   * \return True if success.
+   */
+  bool SearchMutualNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN,
+    std::vector<int> * pvec_reverse_indices
+  ) override
   {
     if (!memMapping.get())  {
       return false;
@@ -131,10 +156,10 @@ class ArrayMatcherCascadeHashing  : public ArrayMatcher<Scalar, Metric>
       hashed_query, mat_query,
       hashed_base_, *memMapping,
       pvec_indices, pvec_distances,
-      NN);
+      NN, pvec_reverse_indices);
 
     return true;
-  };
+  }
 
 private:
   using BaseMat = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
@@ -9,6 +9,7 @@
 #ifndef OPENMVG_MATCHING_MATCHER_KDTREE_FLANN_HPP
 #define OPENMVG_MATCHING_MATCHER_KDTREE_FLANN_HPP
 
+#include <cstdio>
 #include <memory>
 #include <vector>
 
@@ -38,6 +39,8 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
 
   ArrayMatcher_Kdtree_Flann() = default;
 
+  ArrayMatcher_Kdtree_Flann(ArrayMatcher_Kdtree_Flann &&) = default;
+
   virtual ~ArrayMatcher_Kdtree_Flann() = default;
 
   /**
@@ -66,7 +69,7 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
 
       //-- Build FLANN index
       index_.reset(
-          new flann::Index<Metric> (*datasetM_, flann::KDTreeIndexParams(4)));
+          new flann::KDTreeIndex<Metric> (*datasetM_, flann::KDTreeIndexParams(4)));
       index_->buildIndex();
 
       return true;
@@ -74,6 +77,72 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
     return false;
   }
 
+  /**
+   * Write the search trees to a stream (the dataset itself is not saved)
+   *
+   * \param[in] stream  An opened binary stream.
+   *
+   * \return True if success.
+   */
+  bool SaveIndex
+  (
+    std::FILE * stream
+  )
+  {
+    if (!index_ || !stream)
+      return false;
+    try
+    {
+      index_->saveIndex(stream);
+    }
+    catch (const flann::FLANNException &)
+    {
+      return false;
+    }
+    return std::ferror(stream) == 0;
+  }
+
+  /**
+   * Restore the matching structure of a dataset from search trees written
+   * by SaveIndex (avoid to build the trees again).
+   *
+   * \param[in] dataset   Input data (must be the one used to build the trees).
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the each
+   *  row of the dataset.
+   * \param[in] stream    A binary stream positioned at the saved trees.
+   *
+   * \return True if success.
+   */
+  bool LoadIndex
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension,
+    std::FILE * stream
+  )
+  {
+    if (nbRows <= 0 || !stream)
+      return false;
+
+    dimension_ = dimension;
+    datasetM_.reset(
+        new flann::Matrix<Scalar>((Scalar*)dataset, nbRows, dimension));
+    index_.reset(
+        new flann::KDTreeIndex<Metric> (*datasetM_, flann::KDTreeIndexParams(4)));
+    try
+    {
+      index_->loadIndex(stream);
+    }
+    catch (const flann::FLANNException &)
+    {
+      index_.reset();
+      return false;
+    }
+    return index_->size() == static_cast<size_t>(nbRows)
+      && index_->veclen() == static_cast<size_t>(dimension);
+  }
+
   /**
    * Search the nearest Neighbor of the scalar array query.
    *
@@ -172,7 +241,7 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
   private:
 
   std::unique_ptr<flann::Matrix<Scalar>> datasetM_;
-  std::unique_ptr<flann::Index<Metric>> index_;
+  std::unique_ptr<flann::KDTreeIndex<Metric>> index_;
   std::size_t dimension_;
 };
 
@@ -0,0 +1,380 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_MATCHER_MULTI_INDEX_HASHING_HPP
+#define OPENMVG_MATCHING_MATCHER_MULTI_INDEX_HASHING_HPP
+
+#include "openMVG/matching/matching_interface.hpp"
+#include "openMVG/matching/metric_hamming.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(OPENMVG_USE_AVX2) || defined(OPENMVG_USE_AVX512VPOPCNTDQ)
+#include <immintrin.h>
+#endif
+
+namespace openMVG {
+namespace matching {
+
+/**
+ * Exact k nearest neighbor search of binary descriptors (Hamming distance)
+ *  by Multi-Index Hashing.
+ *
+ * Reference:
+ * [1] Fast Exact Search in Hamming Space with Multi-Index Hashing.
+ * Authors: Mohammad Norouzi, Ali Punjani, David J. Fleet.
+ * Date: 2014.
+ * Journal: IEEE Transactions on Pattern Analysis and Machine Intelligence.
+ *
+ * The descriptors are split into m disjoint substrings, each one indexed
+ *  by its own hash table. Two descriptors at a Hamming distance lower than
+ *  r * m + j have, in one of their substrings, a distance lower than r
+ *  (or equal to r in one of the j first substrings). The tables are thus
+ *  probed with Hamming balls of increasing radius until the k best
+ *  candidates are guaranteed to be the exact nearest neighbors.
+ *  The candidates are verified with the full Hamming distance.
+ * If a Hamming ball becomes larger than the dataset (far neighbors),
+ *  the remaining descriptors are linearly scanned.
+ */
+template < typename Scalar = unsigned char >
+class ArrayMatcher_MultiIndexHashing : public ArrayMatcher<Scalar, Hamming<Scalar>>
+{
+  public:
+  using DistanceType = typename Hamming<Scalar>::ResultType;
+
+  /**
+   * @param substring_bits Length of the indexed substrings in bits [1, 16]
+   *  (0: automatic choice, log2 of the dataset size).
+   */
+  explicit ArrayMatcher_MultiIndexHashing(int substring_bits = 0):
+    substring_bits_option_(substring_bits)
+  {
+  }
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset (in bytes).
+   *
+   * \return True if success.
+   */
+  bool Build
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension
+  ) override
+  {
+    dataset_ = nullptr;
+    offsets_.clear();
+    ids_.clear();
+    if (nbRows < 1 || dimension < 1)
+      return false;
+
+    dataset_ = reinterpret_cast<const uint8_t *>(dataset);
+    nb_rows_ = nbRows;
+    dimension_ = dimension;
+    nb_bits_ = dimension * 8;
+    substring_bits_ = (substring_bits_option_ > 0)
+      ? substring_bits_option_
+      : static_cast<int>(std::round(std::log2(static_cast<double>(nbRows))));
+    substring_bits_ = std::max(1, std::min({substring_bits_, 16, nb_bits_}));
+    nb_substrings_ = (nb_bits_ + substring_bits_ - 1) / substring_bits_;
+
+    // One hash table per substring, stored as buckets of descriptor ids
+    // (bucket offsets indexed by the substring value)
+    const size_t nb_buckets = (size_t(1) << substring_bits_) + 1;
+    offsets_.assign(nb_substrings_ * nb_buckets, 0);
+    ids_.resize(static_cast<size_t>(nb_substrings_) * nb_rows_);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for (int k = 0; k < nb_substrings_; ++k)
+    {
+      uint32_t * offsets = &offsets_[k * nb_buckets];
+      uint32_t * ids = &ids_[static_cast<size_t>(k) * nb_rows_];
+      std::vector<uint32_t> keys(nb_rows_);
+      for (int i = 0; i < nb_rows_; ++i)
+      {
+        keys[i] = Substring(dataset_ + static_cast<size_t>(i) * dimension_, k);
+        ++offsets[keys[i] + 1];
+      }
+      for (size_t b = 1; b < nb_buckets; ++b)
+        offsets[b] += offsets[b - 1];
+      std::vector<uint32_t> position(offsets, offsets + nb_buckets - 1);
+      for (int i = 0; i < nb_rows_; ++i)
+        ids[position[keys[i]]++] = i;
+    }
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour
+  (
+    const Scalar * query,
+    int * indice,
+    DistanceType * distance
+  ) override
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices[0].j_;
+    *distance = distances[0];
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[in]   NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query,
+    int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  ) override
+  {
+    if (!dataset_ || NN < 1 || NN > static_cast<size_t>(nb_rows_) || nbQuery < 1)
+      return false;
+
+    pvec_indices->resize(nbQuery * NN);
+    pvec_distances->resize(nbQuery * NN);
+
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      // Last query that has verified each descriptor
+      std::vector<int> visited(nb_rows_, -1);
+      std::vector<uint32_t> query_keys(nb_substrings_);
+      std::vector<std::pair<DistanceType, int>> best;
+      best.reserve(NN + 1);
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp for schedule(dynamic, 64)
+#endif
+      for (int q = 0; q < nbQuery; ++q)
+      {
+        const uint8_t * query_ptr =
+          reinterpret_cast<const uint8_t *>(query) + static_cast<size_t>(q) * dimension_;
+        SearchQuery(query_ptr, q, NN, visited, query_keys, best);
+        for (size_t k = 0; k < NN; ++k)
+        {
+          (*pvec_distances)[q * NN + k] = best[k].first;
+          (*pvec_indices)[q * NN + k] = IndMatch(q, best[k].second);
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Hamming distance between two binary descriptors of size bytes
+  static inline DistanceType HammingDistance
+  (
+    const uint8_t * a,
+    const uint8_t * b,
+    int size
+  )
+  {
+#ifdef OPENMVG_USE_AVX512VPOPCNTDQ
+    if (size % 64 == 0)
+    {
+      __m512i acc = _mm512_setzero_si512();
+      for (int i = 0; i < size; i += 64)
+      {
+        const __m512i x = _mm512_xor_si512(
+          _mm512_loadu_si512(reinterpret_cast<const void *>(a + i)),
+          _mm512_loadu_si512(reinterpret_cast<const void *>(b + i)));
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(x));
+      }
+      return static_cast<DistanceType>(_mm512_reduce_add_epi64(acc));
+    }
+#endif
+#ifdef OPENMVG_USE_AVX2
+    if (size % 32 == 0)
+    {
+      // Count the bits of each nibble with a lookup table
+      const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const __m256i low_mask = _mm256_set1_epi8(0x0f);
+      __m256i acc = _mm256_setzero_si256();
+      for (int i = 0; i < size; i += 32)
+      {
+        const __m256i x = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+        const __m256i count = _mm256_add_epi8(
+          _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low_mask)),
+          _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask)));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+      }
+      return static_cast<DistanceType>(
+        _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+        _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+    }
+#endif
+    return Hamming<uint8_t>()(a, b, size);
+  }
+
+  private:
+
+  /// Value of the k-th substring of a descriptor (bits are read in the
+  /// memory order, least significant bit first)
+  inline uint32_t Substring(const uint8_t * desc, int k) const
+  {
+    const int first_bit = k * substring_bits_;
+    const int length = SubstringLength(k);
+    const int first_byte = first_bit / 8;
+    const int last_byte = (first_bit + length - 1) / 8;
+    uint32_t value = 0;
+    for (int b = first_byte; b <= last_byte; ++b)
+      value |= static_cast<uint32_t>(desc[b]) << (8 * (b - first_byte));
+    return (value >> (first_bit % 8)) & ((uint32_t(1) << length) - 1);
+  }
+
+  inline int SubstringLength(int k) const
+  {
+    return std::min(substring_bits_, nb_bits_ - k * substring_bits_);
+  }
+
+  /// Number of values at a Hamming distance r of a length bits value
+  static double BallSurface(int length, int r)
+  {
+    if (r > length)
+      return 0.;
+    double count = 1.;
+    for (int i = 0; i < r; ++i)
+      count = count * (length - i) / (i + 1);
+    return count;
+  }
+
+  /// Verify a candidate and keep it if it is one of the NN best
+  inline void Verify
+  (
+    const uint8_t * query,
+    int id,
+    size_t NN,
+    std::vector<std::pair<DistanceType, int>> & best
+  ) const
+  {
+    const std::pair<DistanceType, int> candidate(
+      HammingDistance(query, dataset_ + static_cast<size_t>(id) * dimension_, dimension_),
+      id);
+    if (best.size() == NN && !(candidate < best.back()))
+      return;
+    best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+    if (best.size() > NN)
+      best.pop_back();
+  }
+
+  void SearchQuery
+  (
+    const uint8_t * query,
+    int query_id,
+    size_t NN,
+    std::vector<int> & visited,
+    std::vector<uint32_t> & query_keys,
+    std::vector<std::pair<DistanceType, int>> & best
+  ) const
+  {
+    best.clear();
+    for (int k = 0; k < nb_substrings_; ++k)
+      query_keys[k] = Substring(query, k);
+
+    const size_t nb_buckets = (size_t(1) << substring_bits_) + 1;
+    for (int r = 0; r <= substring_bits_; ++r)
+    {
+      // Use a linear scan if the Hamming balls are larger than the dataset
+      double nb_probes = 0.;
+      for (int k = 0; k < nb_substrings_; ++k)
+        nb_probes += BallSurface(SubstringLength(k), r);
+      if (nb_probes > nb_rows_)
+      {
+        for (int i = 0; i < nb_rows_; ++i)
+          if (visited[i] != query_id)
+            Verify(query, i, NN, best);
+        return;
+      }
+
+      for (int k = 0; k < nb_substrings_; ++k)
+      {
+        const int length = SubstringLength(k);
+        if (r <= length)
+        {
+          const uint32_t * offsets = &offsets_[k * nb_buckets];
+          const uint32_t * ids = &ids_[static_cast<size_t>(k) * nb_rows_];
+          // Enumerate the masks of length bits with r bits set (Gosper's hack)
+          const uint32_t end = uint32_t(1) << length;
+          for (uint32_t mask = (uint32_t(1) << r) - 1; mask < end;)
+          {
+            const uint32_t key = query_keys[k] ^ mask;
+            for (uint32_t b = offsets[key]; b < offsets[key + 1]; ++b)
+            {
+              const int id = static_cast<int>(ids[b]);
+              if (visited[id] != query_id)
+              {
+                visited[id] = query_id;
+                Verify(query, id, NN, best);
+              }
+            }
+            if (mask == 0)
+              break;
+            const uint32_t c = mask & (~mask + 1);
+            const uint32_t n = mask + c;
+            mask = (((n ^ mask) >> 2) / c) | n;
+          }
+        }
+        // All the descriptors closer than r * m + k + 1 have been verified
+        if (best.size() == NN &&
+            best.back().first <= static_cast<DistanceType>(r * nb_substrings_ + k))
+          return;
+      }
+    }
+  }
+
+  int substring_bits_option_;
+
+  const uint8_t * dataset_ = nullptr;
+  int nb_rows_ = 0;
+  int dimension_ = 0;
+  int nb_bits_ = 0;
+  int substring_bits_ = 0;
+  int nb_substrings_ = 0;
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> ids_;
+};
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_MATCHER_MULTI_INDEX_HASHING_HPP
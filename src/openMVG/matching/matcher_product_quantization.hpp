@@ -0,0 +1,256 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_MATCHER_PRODUCT_QUANTIZATION_HPP
+#define OPENMVG_MATCHING_MATCHER_PRODUCT_QUANTIZATION_HPP
+
+#include "openMVG/matching/matching_interface.hpp"
+#include "openMVG/matching/metric.hpp"
+#include "openMVG/matching/product_quantizer.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace openMVG {
+namespace matching {
+
+/**
+ * Approximate nearest neighbor search over product quantized descriptors.
+ *
+ * The database descriptors are stored as PQ codes (see ProductQuantizer) and
+ * compared to the raw queries by asymmetric distance computation (ADC).
+ * The rerank_count best ADC candidates of a query can be re-ranked with the
+ * exact squared L2 distance, if the raw database descriptors are available.
+ * Returned distances are squared L2 distances.
+ */
+template < typename Scalar >
+class ArrayMatcher_ProductQuantization : public ArrayMatcher<Scalar, L2<float>>
+{
+  public:
+  using DistanceType = float;
+
+  /**
+   * @param rerank_count Number of ADC candidates re-ranked with the exact
+   *  distance (0: no re-ranking, the ADC distances are returned).
+   * @param options Settings used to train a quantizer in Build().
+   * @param max_training_samples Maximal number of database descriptors used
+   *  to train a quantizer in Build().
+   */
+  explicit ArrayMatcher_ProductQuantization
+  (
+    int rerank_count = 16,
+    const ProductQuantizer::Options & options = ProductQuantizer::Options(),
+    int max_training_samples = 20000
+  ):
+    rerank_count_(rerank_count),
+    options_(options),
+    max_training_samples_(max_training_samples)
+  {
+  }
+
+  /// Use an already trained quantizer (i.e. shared by a collection of images)
+  void SetQuantizer(std::shared_ptr<const ProductQuantizer> quantizer)
+  {
+    quantizer_ = quantizer;
+  }
+
+  const std::shared_ptr<const ProductQuantizer> & Quantizer() const { return quantizer_; }
+
+  /**
+   * Build the matching structure: encode the dataset (the quantizer is trained
+   * on a sample of the dataset if none has been set).
+   * The dataset must outlive the matcher to re-rank the candidates.
+   */
+  bool Build
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension
+  ) override
+  {
+    if (nbRows < 1)
+      return false;
+    if (!quantizer_ || quantizer_->Dimension() != dimension)
+    {
+      // Train on evenly spaced descriptors
+      const int nb_samples = std::min(nbRows, std::max(1, max_training_samples_));
+      ProductQuantizer::RowMatrixXf samples(nb_samples, dimension);
+      for (int i = 0; i < nb_samples; ++i)
+      {
+        const size_t row = static_cast<size_t>(i) * nbRows / nb_samples;
+        for (int d = 0; d < dimension; ++d)
+          samples(i, d) = static_cast<float>(dataset[row * dimension + d]);
+      }
+      // The code length must divide the descriptor length
+      ProductQuantizer::Options options = options_;
+      while (options.nb_subquantizers > 1 && dimension % options.nb_subquantizers != 0)
+        --options.nb_subquantizers;
+      auto quantizer = std::make_shared<ProductQuantizer>();
+      if (!quantizer->Train(samples, options))
+        return false;
+      quantizer_ = quantizer;
+    }
+    auto codes = std::make_shared<std::vector<uint8_t>>();
+    quantizer_->Encode(dataset, nbRows, *codes);
+    codes_ = codes;
+    dataset_ = dataset;
+    nb_rows_ = nbRows;
+    return true;
+  }
+
+  /**
+   * Build the matching structure from already encoded descriptors.
+   * \param[in] quantizer The quantizer used to encode the descriptors.
+   * \param[in] codes     nbRows codes of quantizer->CodeLength() bytes.
+   * \param[in] nbRows    The number of codes.
+   * \param[in] dataset   The optional raw descriptors (used for re-ranking).
+   */
+  bool Build
+  (
+    std::shared_ptr<const ProductQuantizer> quantizer,
+    std::shared_ptr<const std::vector<uint8_t>> codes,
+    int nbRows,
+    const Scalar * dataset = nullptr
+  )
+  {
+    if (!quantizer || !codes || nbRows < 1
+        || codes->size() != static_cast<size_t>(nbRows) * quantizer->CodeLength())
+      return false;
+    quantizer_ = quantizer;
+    codes_ = codes;
+    nb_rows_ = nbRows;
+    dataset_ = dataset;
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour
+  (
+    const Scalar * query,
+    int * indice,
+    DistanceType * distance
+  ) override
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices[0].j_;
+    *distance = distances[0];
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[in]   NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query,
+    int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  ) override
+  {
+    if (!codes_ || NN > static_cast<size_t>(nb_rows_) || nbQuery < 1)
+      return false;
+
+    const int dimension = quantizer_->Dimension();
+    const int code_length = quantizer_->CodeLength();
+    const bool b_rerank = dataset_ && rerank_count_ > 0;
+    const size_t candidate_count = b_rerank
+      ? std::min(static_cast<size_t>(nb_rows_), std::max(NN, static_cast<size_t>(rerank_count_)))
+      : NN;
+
+    pvec_indices->resize(nbQuery * NN);
+    pvec_distances->resize(nbQuery * NN);
+
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      std::vector<float> table(code_length * ProductQuantizer::kCentroidCount);
+      std::vector<float> adc_distances(nb_rows_);
+      std::vector<int> candidates(nb_rows_);
+      std::vector<std::pair<DistanceType, int>> reranked(candidate_count);
+      const L2<Scalar> metric;
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp for schedule(dynamic, 64)
+#endif
+      for (int q = 0; q < nbQuery; ++q)
+      {
+        const Scalar * query_ptr = query + static_cast<size_t>(q) * dimension;
+
+        // Approximate distances to all the database codes
+        quantizer_->ComputeDistanceTable(query_ptr, table.data());
+        const uint8_t * code = codes_->data();
+        for (int i = 0; i < nb_rows_; ++i, code += code_length)
+          adc_distances[i] = quantizer_->AsymmetricDistance(table.data(), code);
+
+        // Keep the best candidates
+        std::iota(candidates.begin(), candidates.end(), 0);
+        const auto closer = [&adc_distances](const int a, const int b)
+        {
+          return adc_distances[a] < adc_distances[b];
+        };
+        std::partial_sort(candidates.begin(), candidates.begin() + candidate_count,
+                          candidates.end(), closer);
+
+        for (size_t k = 0; k < candidate_count; ++k)
+        {
+          const int i = candidates[k];
+          reranked[k].first = b_rerank
+            ? static_cast<DistanceType>(metric(query_ptr, dataset_ + static_cast<size_t>(i) * dimension, dimension))
+            : adc_distances[i];
+          reranked[k].second = i;
+        }
+        if (b_rerank)
+          std::partial_sort(reranked.begin(), reranked.begin() + NN, reranked.end());
+
+        for (size_t k = 0; k < NN; ++k)
+        {
+          (*pvec_distances)[q * NN + k] = reranked[k].first;
+          (*pvec_indices)[q * NN + k] = IndMatch(q, reranked[k].second);
+        }
+      }
+    }
+    return true;
+  }
+
+  private:
+  int rerank_count_;
+  ProductQuantizer::Options options_;
+  int max_training_samples_;
+
+  std::shared_ptr<const ProductQuantizer> quantizer_;
+  std::shared_ptr<const std::vector<uint8_t>> codes_;
+  int nb_rows_ = 0;
+  const Scalar * dataset_ = nullptr;
+};
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_MATCHER_PRODUCT_QUANTIZATION_HPP
@@ -20,7 +20,9 @@ enum EMatcherType : unsigned char
   HNSW_L2,
   HNSW_L1,
   BRUTE_FORCE_HAMMING,
-  HNSW_HAMMING
+  HNSW_HAMMING,
+  PRODUCT_QUANTIZATION_L2,
+  MULTI_INDEX_HASHING_HAMMING
 };
 
 } // namespace matching
@@ -68,6 +68,30 @@ class ArrayMatcher
                                   IndMatches * indices,
                                   std::vector<DistanceType> * distances,
                                   size_t NN)=0;
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query and, in the
+   *  same pass, the nearest query of each dataset array
+   *  (used for mutual nearest neighbor filtering).
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[in]   NN        The number of maximal neighbor that will be searched.
+   * \param[out]  reverse_indices For each dataset array, the index of its
+   *  nearest query (-1 if no query has been compared to it).
+   *
+   * \return False if the reverse search is not supported by the matcher.
+   */
+  virtual bool SearchMutualNeighbours( const Scalar * /*query*/, int /*nbQuery*/,
+                                       IndMatches * /*indices*/,
+                                       std::vector<DistanceType> * /*distances*/,
+                                       size_t /*NN*/,
+                                       std::vector<int> * /*reverse_indices*/)
+  {
+    return false;
+  }
 };
 
 }  // namespace matching
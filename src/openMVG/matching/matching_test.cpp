@@ -12,13 +12,17 @@
 #include "openMVG/matching/matcher_cascade_hashing.hpp"
 #include "openMVG/matching/matcher_kdtree_flann.hpp"
 #include "openMVG/matching/matcher_hnsw.hpp"
+#include "openMVG/matching/matcher_multi_index_hashing.hpp"
 
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
 
 #include "testing/testing.h"
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <random>
 
 using namespace openMVG;
 using namespace matching;
@@ -86,6 +90,42 @@ TEST(Matching, ArrayMatcherBruteForce_Simple_Dim4)
   EXPECT_NEAR( 0.0f, fDistance, 1e-8); //distance
 }
 
+TEST(Matching, ArrayMatcherBruteForce_MutualNeighbours)
+{
+  // The reverse nearest neighbors are the ones of the reversed matching
+  const int nb_rows = 300, nb_query = 200, dimension = 8;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<float> dataset(nb_rows * dimension), queries(nb_query * dimension);
+  for (auto & value : dataset)
+    value = dist(rng);
+  for (auto & value : queries)
+    value = dist(rng);
+
+  ArrayMatcherBruteForce<float> matcher;
+  EXPECT_TRUE( matcher.Build(dataset.data(), nb_rows, dimension) );
+  IndMatches vec_nIndice, vec_nIndice_mutual;
+  std::vector<float> vec_fDistance, vec_fDistance_mutual;
+  std::vector<int> reverse_indices;
+  EXPECT_TRUE( matcher.SearchNeighbours(queries.data(), nb_query, &vec_nIndice, &vec_fDistance, 2) );
+  EXPECT_TRUE( matcher.SearchMutualNeighbours(queries.data(), nb_query,
+    &vec_nIndice_mutual, &vec_fDistance_mutual, 2, &reverse_indices) );
+  EXPECT_TRUE( vec_nIndice == vec_nIndice_mutual );
+  EXPECT_TRUE( vec_fDistance == vec_fDistance_mutual );
+
+  ArrayMatcherBruteForce<float> reverse_matcher;
+  EXPECT_TRUE( reverse_matcher.Build(queries.data(), nb_query, dimension) );
+  IndMatches vec_nIndice_reverse;
+  std::vector<float> vec_fDistance_reverse;
+  EXPECT_TRUE( reverse_matcher.SearchNeighbours(dataset.data(), nb_rows,
+    &vec_nIndice_reverse, &vec_fDistance_reverse, 1) );
+  EXPECT_EQ( nb_rows, reverse_indices.size() );
+  for (int i = 0; i < nb_rows; ++i)
+  {
+    EXPECT_EQ( vec_nIndice_reverse[i].j_, reverse_indices[i] );
+  }
+}
+
 TEST(Matching, ArrayMatcher_Kdtree_Flann_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -118,6 +158,40 @@ TEST(Matching, ArrayMatcher_Kdtree_Flann_Simple__NN)
   EXPECT_EQ(IndMatch(0,4), vec_nIndice[4]);
 }
 
+TEST(Matching, ArrayMatcher_Kdtree_Flann_SaveLoadIndex)
+{
+  const int dimension = 8, nbRows = 200;
+  std::vector<float> array(nbRows * dimension);
+  for (size_t i = 0; i < array.size(); ++i)
+    array[i] = static_cast<float>((i * 7919) % 101);
+
+  ArrayMatcher_Kdtree_Flann<float> matcher;
+  EXPECT_TRUE( matcher.Build(array.data(), nbRows, dimension) );
+
+  std::FILE * stream = std::tmpfile();
+  CHECK( stream != nullptr );
+  EXPECT_TRUE( matcher.SaveIndex(stream) );
+  std::rewind(stream);
+
+  ArrayMatcher_Kdtree_Flann<float> loaded_matcher;
+  EXPECT_TRUE( loaded_matcher.LoadIndex(array.data(), nbRows, dimension, stream) );
+  std::fclose(stream);
+
+  // The restored trees give the same neighbors as the built ones
+  const float * queries = array.data() + 10 * dimension;
+  IndMatches vec_nIndice, vec_nIndice_loaded;
+  std::vector<float> vec_fDistance, vec_fDistance_loaded;
+  EXPECT_TRUE( matcher.SearchNeighbours(queries, 20, &vec_nIndice, &vec_fDistance, 2) );
+  EXPECT_TRUE( loaded_matcher.SearchNeighbours(queries, 20,
+    &vec_nIndice_loaded, &vec_fDistance_loaded, 2) );
+  EXPECT_EQ( vec_nIndice.size(), vec_nIndice_loaded.size() );
+  for (size_t i = 0; i < vec_nIndice.size(); ++i)
+  {
+    EXPECT_EQ( vec_nIndice[i], vec_nIndice_loaded[i] );
+    EXPECT_NEAR( vec_fDistance[i], vec_fDistance_loaded[i], 1e-6 );
+  }
+}
+
 TEST(Matching, ArrayMatcher_Hnsw_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -150,6 +224,54 @@ TEST(Matching, ArrayMatcher_Hnsw_Simple__NN)
   EXPECT_EQ(IndMatch(0,4), vec_nIndice[4]);
 }
 
+TEST(Matching, ArrayMatcher_MultiIndexHashing_SameAsBruteForce)
+{
+  // Random 256 bits descriptors, the queries are noisy copies of some of them
+  const int nb_rows = 2000, nb_query = 200, dimension = 32;
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> byte_dist(0, 255), bit_dist(0, dimension * 8 - 1);
+  std::vector<unsigned char> dataset(nb_rows * dimension), queries(nb_query * dimension);
+  for (auto & value : dataset)
+    value = byte_dist(rng);
+  for (int q = 0; q < nb_query; ++q)
+  {
+    std::copy_n(&dataset[(q * 7) * dimension], dimension, &queries[q * dimension]);
+    // From near duplicates to unrelated descriptors
+    for (int i = 0; i < q / 2; ++i)
+    {
+      const int bit = bit_dist(rng);
+      queries[q * dimension + bit / 8] ^= (1 << (bit % 8));
+    }
+  }
+
+  using MetricT = Hamming<unsigned char>;
+  ArrayMatcherBruteForce<unsigned char, MetricT> bf_matcher;
+  EXPECT_TRUE(bf_matcher.Build(dataset.data(), nb_rows, dimension));
+
+  for (const int substring_bits : {0, 5, 16})
+  {
+    ArrayMatcher_MultiIndexHashing<unsigned char> mih_matcher(substring_bits);
+    EXPECT_TRUE(mih_matcher.Build(dataset.data(), nb_rows, dimension));
+
+    const size_t NN = 2;
+    IndMatches bf_indices, mih_indices;
+    std::vector<MetricT::ResultType> bf_distances, mih_distances;
+    EXPECT_TRUE(bf_matcher.SearchNeighbours(queries.data(), nb_query, &bf_indices, &bf_distances, NN));
+    EXPECT_TRUE(mih_matcher.SearchNeighbours(queries.data(), nb_query, &mih_indices, &mih_distances, NN));
+
+    // The search is exact: same distances
+    EXPECT_EQ(bf_distances.size(), mih_distances.size());
+    for (size_t i = 0; i < bf_distances.size(); ++i)
+    {
+      EXPECT_EQ(bf_distances[i], mih_distances[i]);
+      EXPECT_EQ(bf_indices[i].i_, mih_indices[i].i_);
+      EXPECT_EQ(MetricT()(&queries[mih_indices[i].i_ * dimension],
+                          &dataset[mih_indices[i].j_ * dimension], dimension),
+                mih_distances[i]);
+    }
+  }
+}
+
 //-- Test LIMIT case (empty arrays)
 
 TEST(Matching, ArrayMatcherBruteForce_Simple_EmptyArrays)
@@ -182,6 +304,65 @@ TEST(Matching, Cascade_Hashing_Simple_EmptyArrays)
   EXPECT_FALSE( matcher.SearchNeighbour(nullptr, &nIndice, &fDistance) );
 }
 
+TEST(Matching, Cascade_Hashing_MutualNeighbours)
+{
+  // The queries are noisy copies of the dataset rows (in a shuffled order)
+  const int nb_rows = 300, dimension = 64;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::normal_distribution<float> noise(0.f, 0.01f);
+  std::vector<float> dataset(nb_rows * dimension), queries(nb_rows * dimension);
+  for (auto & value : dataset)
+    value = dist(rng);
+  std::vector<int> row_of_query(nb_rows);
+  std::iota(row_of_query.begin(), row_of_query.end(), 0);
+  std::shuffle(row_of_query.begin(), row_of_query.end(), rng);
+  for (int q = 0; q < nb_rows; ++q)
+    for (int d = 0; d < dimension; ++d)
+      queries[q * dimension + d] = dataset[row_of_query[q] * dimension + d] + noise(rng);
+
+  ArrayMatcherCascadeHashing<float> matcher;
+  EXPECT_TRUE( matcher.Build(dataset.data(), nb_rows, dimension) );
+  IndMatches vec_nIndice, vec_nIndice_mutual;
+  std::vector<float> vec_fDistance, vec_fDistance_mutual;
+  std::vector<int> reverse_indices;
+  EXPECT_TRUE( matcher.SearchNeighbours(queries.data(), nb_rows, &vec_nIndice, &vec_fDistance, 2) );
+  EXPECT_TRUE( matcher.SearchMutualNeighbours(queries.data(), nb_rows,
+    &vec_nIndice_mutual, &vec_fDistance_mutual, 2, &reverse_indices) );
+  // The neighbors of the queries are the same with the reverse search
+  EXPECT_TRUE( vec_nIndice == vec_nIndice_mutual );
+  EXPECT_TRUE( vec_fDistance == vec_fDistance_mutual );
+  EXPECT_EQ( nb_rows, reverse_indices.size() );
+
+  // The nearest query of a dataset row is its noisy copy
+  for (int q = 0; q < nb_rows; ++q)
+  {
+    EXPECT_EQ( q, reverse_indices[row_of_query[q]] );
+  }
+
+  // A query that has a row among its neighbors is not closer to it than the
+  // reverse nearest query of the row
+  const L2<float> metric;
+  for (size_t k = 0; k < vec_nIndice_mutual.size(); ++k)
+  {
+    const IndMatch & match = vec_nIndice_mutual[k];
+    const int reverse_query = reverse_indices[match.j_];
+    CHECK( reverse_query >= 0 );
+    EXPECT_TRUE( metric(&dataset[match.j_ * dimension], &queries[reverse_query * dimension], dimension)
+      <= vec_fDistance_mutual[k] );
+  }
+}
+
+TEST(Matching, ArrayMatcher_MultiIndexHashing_EmptyArrays)
+{
+  ArrayMatcher_MultiIndexHashing<unsigned char> matcher;
+  EXPECT_FALSE( matcher.Build(nullptr, 0, 32) );
+
+  int nIndice = -1;
+  unsigned int distance = 0;
+  EXPECT_FALSE( matcher.SearchNeighbour(nullptr, &nIndice, &distance) );
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -0,0 +1,277 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching/product_quantizer.hpp"
+
+#include <Eigen/SVD>
+
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <random>
+
+namespace openMVG {
+namespace matching {
+
+using RowMatrixXf = ProductQuantizer::RowMatrixXf;
+
+namespace
+{
+
+/// Index of the closest centroid of each sample
+void AssignToCentroids
+(
+  const RowMatrixXf & samples,
+  const RowMatrixXf & centroids,
+  std::vector<int> & assignments
+)
+{
+  // ||x - c||^2 = ||x||^2 - 2 x.c + ||c||^2, ||x||^2 does not change the argmin
+  const Eigen::RowVectorXf centroid_norms = centroids.rowwise().squaredNorm().transpose();
+  assignments.resize(samples.rows());
+  const int kChunkSize = 1024;
+  for (Eigen::Index start = 0; start < samples.rows(); start += kChunkSize)
+  {
+    const Eigen::Index rows = std::min<Eigen::Index>(kChunkSize, samples.rows() - start);
+    const Eigen::MatrixXf distances =
+      (-2.f * samples.middleRows(start, rows) * centroids.transpose()).rowwise()
+      + centroid_norms;
+    for (Eigen::Index i = 0; i < rows; ++i)
+    {
+      Eigen::Index best;
+      distances.row(i).minCoeff(&best);
+      assignments[start + i] = static_cast<int>(best);
+    }
+  }
+}
+
+/// Lloyd k-means, initialized with distinct random samples
+void KMeans
+(
+  const RowMatrixXf & samples,
+  const int nb_iterations,
+  std::mt19937 & random_generator,
+  RowMatrixXf & centroids
+)
+{
+  const Eigen::Index nb_samples = samples.rows();
+  const int k = ProductQuantizer::kCentroidCount;
+  centroids.resize(k, samples.cols());
+
+  std::vector<Eigen::Index> order(nb_samples);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), random_generator);
+  // With less samples than centroids, some centroids are duplicated
+  // (the codes only use the first of them)
+  for (int c = 0; c < k; ++c)
+    centroids.row(c) = samples.row(order[c % nb_samples]);
+
+  std::uniform_int_distribution<Eigen::Index> random_sample(0, nb_samples - 1);
+  std::vector<int> assignments;
+  for (int iteration = 0; iteration < nb_iterations; ++iteration)
+  {
+    AssignToCentroids(samples, centroids, assignments);
+
+    RowMatrixXf sums = RowMatrixXf::Zero(k, samples.cols());
+    std::vector<int> counts(k, 0);
+    for (Eigen::Index i = 0; i < nb_samples; ++i)
+    {
+      sums.row(assignments[i]) += samples.row(i);
+      ++counts[assignments[i]];
+    }
+    for (int c = 0; c < k; ++c)
+    {
+      if (counts[c] > 0)
+        centroids.row(c) = sums.row(c) / static_cast<float>(counts[c]);
+      else if (nb_samples >= k) // re-seed the empty cluster
+        centroids.row(c) = samples.row(random_sample(random_generator));
+    }
+  }
+}
+
+} // namespace
+
+void ProductQuantizer::TrainCodebooks
+(
+  const RowMatrixXf & samples,
+  const Options & options,
+  const int nb_iterations
+)
+{
+  codebooks_.resize(nb_subquantizers_);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int m = 0; m < nb_subquantizers_; ++m)
+  {
+    // One random generator per sub-space to remain deterministic
+    std::mt19937 random_generator(options.seed + m);
+    const RowMatrixXf sub_samples = samples.middleCols(m * sub_dimension_, sub_dimension_);
+    KMeans(sub_samples, nb_iterations, random_generator, codebooks_[m]);
+  }
+}
+
+bool ProductQuantizer::Train
+(
+  const RowMatrixXf & samples,
+  const Options & options
+)
+{
+  codebooks_.clear();
+  rotation_.resize(0, 0);
+  if (samples.rows() == 0 || options.nb_subquantizers < 1
+      || samples.cols() % options.nb_subquantizers != 0)
+    return false;
+
+  dimension_ = static_cast<int>(samples.cols());
+  nb_subquantizers_ = options.nb_subquantizers;
+  sub_dimension_ = dimension_ / nb_subquantizers_;
+
+  if (options.opq_iterations > 0)
+  {
+    // Non-parametric OPQ [2]: alternate the codebook training and the
+    // rotation R minimizing ||X R - Y|| (Y: the reconstructed samples),
+    // solved as an orthogonal Procrustes problem.
+    rotation_ = Eigen::MatrixXf::Identity(dimension_, dimension_);
+    const int nb_iterations_per_step = std::max(1, options.nb_iterations / 4);
+    std::vector<uint8_t> codes;
+    for (int step = 0; step < options.opq_iterations; ++step)
+    {
+      const RowMatrixXf rotated = samples * rotation_;
+      TrainCodebooks(rotated, options, nb_iterations_per_step);
+      codes.resize(static_cast<size_t>(samples.rows()) * nb_subquantizers_);
+      EncodeProjected(rotated, codes.data());
+
+      RowMatrixXf reconstructed(samples.rows(), dimension_);
+      for (Eigen::Index i = 0; i < samples.rows(); ++i)
+      {
+        for (int m = 0; m < nb_subquantizers_; ++m)
+        {
+          reconstructed.block(i, m * sub_dimension_, 1, sub_dimension_) =
+            codebooks_[m].row(codes[i * nb_subquantizers_ + m]);
+        }
+      }
+      const Eigen::JacobiSVD<Eigen::MatrixXf> svd(
+        samples.transpose() * reconstructed, Eigen::ComputeFullU | Eigen::ComputeFullV);
+      rotation_ = svd.matrixU() * svd.matrixV().transpose();
+    }
+    TrainCodebooks(samples * rotation_, options, options.nb_iterations);
+  }
+  else
+  {
+    TrainCodebooks(samples, options, options.nb_iterations);
+  }
+  return true;
+}
+
+void ProductQuantizer::EncodeProjected
+(
+  const RowMatrixXf & projected,
+  uint8_t * codes
+) const
+{
+  std::vector<int> assignments;
+  for (int m = 0; m < nb_subquantizers_; ++m)
+  {
+    AssignToCentroids(projected.middleCols(m * sub_dimension_, sub_dimension_),
+                      codebooks_[m], assignments);
+    for (Eigen::Index i = 0; i < projected.rows(); ++i)
+      codes[i * nb_subquantizers_ + m] = static_cast<uint8_t>(assignments[i]);
+  }
+}
+
+void ProductQuantizer::Decode
+(
+  const uint8_t * code,
+  float * descriptor
+) const
+{
+  Eigen::VectorXf reconstructed(dimension_);
+  for (int m = 0; m < nb_subquantizers_; ++m)
+    reconstructed.segment(m * sub_dimension_, sub_dimension_) = codebooks_[m].row(code[m]).transpose();
+  if (rotation_.size() == 0)
+    Eigen::Map<Eigen::VectorXf>(descriptor, dimension_) = reconstructed;
+  else
+    Eigen::Map<Eigen::VectorXf>(descriptor, dimension_) = rotation_ * reconstructed;
+}
+
+void ProductQuantizer::ComputeDistanceTableProjected
+(
+  const float * projected,
+  float * table
+) const
+{
+  for (int m = 0; m < nb_subquantizers_; ++m)
+  {
+    const Eigen::Map<const Eigen::RowVectorXf> sub_query(projected + m * sub_dimension_, sub_dimension_);
+    Eigen::Map<Eigen::VectorXf>(table + m * kCentroidCount, kCentroidCount) =
+      (codebooks_[m].rowwise() - sub_query).rowwise().squaredNorm();
+  }
+}
+
+namespace
+{
+const uint32_t kSerializationMagic = 0x31305150; // "PQ01"
+
+template <typename T>
+void WriteValue(std::ostream & stream, const T & value)
+{
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadValue(std::istream & stream, T & value)
+{
+  return static_cast<bool>(stream.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+} // namespace
+
+bool ProductQuantizer::Save(std::ostream & stream) const
+{
+  if (!IsTrained())
+    return false;
+  WriteValue(stream, kSerializationMagic);
+  WriteValue(stream, static_cast<int32_t>(dimension_));
+  WriteValue(stream, static_cast<int32_t>(nb_subquantizers_));
+  WriteValue(stream, static_cast<int32_t>(rotation_.size() != 0));
+  if (rotation_.size() != 0)
+    stream.write(reinterpret_cast<const char *>(rotation_.data()), sizeof(float) * rotation_.size());
+  for (const RowMatrixXf & codebook : codebooks_)
+    stream.write(reinterpret_cast<const char *>(codebook.data()), sizeof(float) * codebook.size());
+  return static_cast<bool>(stream);
+}
+
+bool ProductQuantizer::Load(std::istream & stream)
+{
+  codebooks_.clear();
+  rotation_.resize(0, 0);
+  uint32_t magic;
+  int32_t dimension, nb_subquantizers, has_rotation;
+  if (!ReadValue(stream, magic) || magic != kSerializationMagic
+      || !ReadValue(stream, dimension) || !ReadValue(stream, nb_subquantizers)
+      || !ReadValue(stream, has_rotation)
+      || dimension < 1 || nb_subquantizers < 1 || dimension % nb_subquantizers != 0)
+    return false;
+
+  dimension_ = dimension;
+  nb_subquantizers_ = nb_subquantizers;
+  sub_dimension_ = dimension / nb_subquantizers;
+  if (has_rotation)
+  {
+    rotation_.resize(dimension_, dimension_);
+    stream.read(reinterpret_cast<char *>(rotation_.data()), sizeof(float) * rotation_.size());
+  }
+  std::vector<RowMatrixXf> codebooks(nb_subquantizers_, RowMatrixXf(kCentroidCount, sub_dimension_));
+  for (RowMatrixXf & codebook : codebooks)
+    stream.read(reinterpret_cast<char *>(codebook.data()), sizeof(float) * codebook.size());
+  if (!stream)
+    return false;
+  codebooks_ = std::move(codebooks);
+  return true;
+}
+
+} // namespace matching
+} // namespace openMVG
@@ -0,0 +1,181 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_PRODUCT_QUANTIZER_HPP
+#define OPENMVG_MATCHING_PRODUCT_QUANTIZER_HPP
+
+//------------------
+//-- Bibliography --
+//------------------
+//- [1] "Product quantization for nearest neighbor search"
+//- Authors: Herve Jegou, Matthijs Douze, Cordelia Schmid.
+//- Date: 2011.
+//- Journal: PAMI.
+//
+//- [2] "Optimized Product Quantization"
+//- Authors: Tiezheng Ge, Kaiming He, Qifa Ke, Jian Sun.
+//- Date: 2014.
+//- Journal: PAMI.
+//
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace openMVG {
+namespace matching {
+
+/**
+ * Product quantizer [1] of fixed length descriptors:
+ *  - the descriptor space is split in M sub-spaces of D/M dimensions,
+ *  - each sub-space is quantized by a 256 centroids codebook (k-means),
+ *  - a descriptor is encoded by M bytes (the index of its closest centroid
+ *    in every sub-space).
+ * An optional rotation of the descriptor space (Optimized PQ [2]) balances the
+ * variance between the sub-spaces and reduces the quantization error.
+ *
+ * The squared L2 distance between a raw query and an encoded descriptor is
+ * approximated by an asymmetric distance computation (ADC): M lookups in a
+ * per query table of the distances to all the sub-space centroids.
+ */
+class ProductQuantizer
+{
+public:
+  static const int kCentroidCount = 256;
+
+  struct Options
+  {
+    int nb_subquantizers = 16;  // M: code length in bytes (must divide D)
+    int nb_iterations = 20;     // k-means iterations
+    int opq_iterations = 0;     // 0: plain PQ, N: N rotation optimization steps
+    unsigned int seed = 5489u;  // random seed of the k-means initialization
+  };
+
+  using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /**
+   * @brief Train the codebooks (and the optional rotation) from a sample.
+   * @param[in] samples Training descriptors (one per row)
+   * @param[in] options Quantizer settings
+   * @return false if the descriptor length is not a multiple of the number of
+   *  sub-quantizers or if the sample is empty.
+   */
+  bool Train(const RowMatrixXf & samples, const Options & options);
+
+  template <typename Scalar>
+  bool Train
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension,
+    const Options & options
+  )
+  {
+    if (nbRows < 1 || dimension < 1)
+      return false;
+    const RowMatrixXf samples =
+      Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(
+        dataset, nbRows, dimension).template cast<float>();
+    return Train(samples, options);
+  }
+
+  bool IsTrained() const { return !codebooks_.empty(); }
+  int Dimension() const { return dimension_; }
+  /// Length of a code in bytes (M)
+  int CodeLength() const { return nb_subquantizers_; }
+
+  /// Encode some descriptors (row major) into nbRows * CodeLength() bytes
+  template <typename Scalar>
+  void Encode(const Scalar * dataset, int nbRows, uint8_t * codes) const
+  {
+    // Process the descriptors by chunks to bound the temporary memory
+    const int kChunkSize = 4096;
+    for (int start = 0; start < nbRows; start += kChunkSize)
+    {
+      const int rows = std::min(kChunkSize, nbRows - start);
+      RowMatrixXf projected =
+        Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(
+          dataset + static_cast<size_t>(start) * dimension_, rows, dimension_).template cast<float>();
+      if (rotation_.size() != 0)
+        projected = projected * rotation_;
+      EncodeProjected(projected, codes + static_cast<size_t>(start) * nb_subquantizers_);
+    }
+  }
+
+  template <typename Scalar>
+  void Encode(const Scalar * dataset, int nbRows, std::vector<uint8_t> & codes) const
+  {
+    codes.resize(static_cast<size_t>(nbRows) * nb_subquantizers_);
+    Encode(dataset, nbRows, codes.data());
+  }
+
+  /// Reconstruct the descriptor of a code (in the original descriptor space)
+  void Decode(const uint8_t * code, float * descriptor) const;
+
+  /**
+   * @brief Compute the ADC table of a query: the squared L2 distances between
+   *  the query sub-vectors and all the sub-space centroids.
+   * @param[in] query The raw query descriptor
+   * @param[out] table CodeLength() * kCentroidCount distances
+   */
+  template <typename Scalar>
+  void ComputeDistanceTable(const Scalar * query, float * table) const
+  {
+    std::vector<float> projected(dimension_);
+    Project(query, projected.data());
+    ComputeDistanceTableProjected(projected.data(), table);
+  }
+
+  /// Approximate squared L2 distance between a query (its ADC table) and a code
+  inline float AsymmetricDistance(const float * table, const uint8_t * code) const
+  {
+    float distance = 0.f;
+    for (int m = 0; m < nb_subquantizers_; ++m, table += kCentroidCount)
+      distance += table[code[m]];
+    return distance;
+  }
+
+  /// Binary serialization of the trained quantizer
+  bool Save(std::ostream & stream) const;
+  bool Load(std::istream & stream);
+
+private:
+
+  /// Apply the rotation (if any) to a descriptor
+  template <typename Scalar>
+  void Project(const Scalar * descriptor, float * projected) const
+  {
+    const Eigen::VectorXf x = Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, 1>>(
+      descriptor, dimension_).template cast<float>();
+    if (rotation_.size() == 0)
+      Eigen::Map<Eigen::VectorXf>(projected, dimension_) = x;
+    else
+      Eigen::Map<Eigen::VectorXf>(projected, dimension_) = rotation_.transpose() * x;
+  }
+
+  /// Encode some rotated descriptors (one per row)
+  void EncodeProjected(const RowMatrixXf & projected, uint8_t * codes) const;
+  void ComputeDistanceTableProjected(const float * projected, float * table) const;
+
+  /// Train the sub-space codebooks on some (rotated) samples
+  void TrainCodebooks(const RowMatrixXf & samples, const Options & options, int nb_iterations);
+
+  int dimension_ = 0;
+  int nb_subquantizers_ = 0;
+  int sub_dimension_ = 0;
+  // Descriptor space rotation (D x D, empty for plain PQ): projected = R^T x
+  Eigen::MatrixXf rotation_;
+  // Codebook of each sub-space (kCentroidCount x sub_dimension)
+  std::vector<RowMatrixXf> codebooks_;
+};
+
+} // namespace matching
+} // namespace openMVG
+
+#endif // OPENMVG_MATCHING_PRODUCT_QUANTIZER_HPP
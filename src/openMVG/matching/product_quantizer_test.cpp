@@ -0,0 +1,228 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching/matcher_brute_force.hpp"
+#include "openMVG/matching/matcher_product_quantization.hpp"
+#include "openMVG/matching/product_quantizer.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+#include <sstream>
+
+using namespace openMVG;
+using namespace matching;
+
+// Clustered random descriptors (dimension 32)
+std::vector<float> RandomDescriptors(const int nb_descriptors, const unsigned int seed)
+{
+  const int dimension = 32;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> center(0.f, 100.f);
+  std::normal_distribution<float> noise(0.f, 2.f);
+  std::vector<float> centers(64 * dimension);
+  std::mt19937 center_rng(0);
+  for (float & value : centers)
+    value = center(center_rng);
+
+  std::uniform_int_distribution<int> cluster(0, 63);
+  std::vector<float> descriptors(nb_descriptors * dimension);
+  for (int i = 0; i < nb_descriptors; ++i)
+  {
+    const int c = cluster(rng);
+    for (int d = 0; d < dimension; ++d)
+      descriptors[i * dimension + d] = centers[c * dimension + d] + noise(rng);
+  }
+  return descriptors;
+}
+
+// Mean relative squared reconstruction error
+double ReconstructionError(const ProductQuantizer & quantizer, const std::vector<float> & data)
+{
+  const int dimension = quantizer.Dimension();
+  const int nb_rows = data.size() / dimension;
+  std::vector<uint8_t> codes;
+  quantizer.Encode(data.data(), nb_rows, codes);
+
+  double error = 0.0, norm = 0.0;
+  std::vector<float> decoded(dimension);
+  for (int i = 0; i < nb_rows; ++i)
+  {
+    quantizer.Decode(&codes[i * quantizer.CodeLength()], decoded.data());
+    for (int d = 0; d < dimension; ++d)
+    {
+      error += Square(decoded[d] - data[i * dimension + d]);
+      norm += Square(data[i * dimension + d]);
+    }
+  }
+  return error / norm;
+}
+
+TEST(ProductQuantizer, EncodeDecode)
+{
+  const std::vector<float> data = RandomDescriptors(2000, 1);
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 8;
+
+  ProductQuantizer quantizer;
+  EXPECT_FALSE(quantizer.IsTrained());
+  EXPECT_TRUE(quantizer.Train(data.data(), 2000, 32, options));
+  EXPECT_TRUE(quantizer.IsTrained());
+  EXPECT_EQ(32, quantizer.Dimension());
+  EXPECT_EQ(8, quantizer.CodeLength());
+  std::vector<uint8_t> codes;
+  quantizer.Encode(data.data(), 2000, codes);
+  EXPECT_EQ(2000 * 8, codes.size());
+  EXPECT_TRUE(ReconstructionError(quantizer, data) < 0.01);
+
+  // The code length must divide the dimension
+  options.nb_subquantizers = 5;
+  EXPECT_FALSE(quantizer.Train(data.data(), 2000, 32, options));
+}
+
+TEST(ProductQuantizer, OptimizedRotation)
+{
+  const std::vector<float> data = RandomDescriptors(2000, 2);
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 4;
+  options.opq_iterations = 4;
+
+  ProductQuantizer quantizer;
+  EXPECT_TRUE(quantizer.Train(data.data(), 2000, 32, options));
+  EXPECT_TRUE(ReconstructionError(quantizer, data) < 0.01);
+}
+
+TEST(ProductQuantizer, AsymmetricDistance)
+{
+  const std::vector<float> data = RandomDescriptors(2000, 3);
+  const std::vector<float> queries = RandomDescriptors(10, 4);
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 8;
+  ProductQuantizer quantizer;
+  EXPECT_TRUE(quantizer.Train(data.data(), 2000, 32, options));
+
+  std::vector<uint8_t> codes;
+  quantizer.Encode(data.data(), 2000, codes);
+
+  // The ADC distance is the exact distance to the decoded descriptor
+  std::vector<float> table(quantizer.CodeLength() * ProductQuantizer::kCentroidCount);
+  std::vector<float> decoded(32);
+  const L2<float> metric;
+  for (int q = 0; q < 10; ++q)
+  {
+    quantizer.ComputeDistanceTable(&queries[q * 32], table.data());
+    for (int i = 0; i < 2000; i += 97)
+    {
+      quantizer.Decode(&codes[i * 8], decoded.data());
+      const float expected = metric(&queries[q * 32], decoded.data(), 32);
+      EXPECT_NEAR(expected, quantizer.AsymmetricDistance(table.data(), &codes[i * 8]),
+                  1e-3 * expected + 1e-2);
+    }
+  }
+}
+
+TEST(ProductQuantizer, SaveLoad)
+{
+  const std::vector<float> data = RandomDescriptors(1000, 5);
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 8;
+  options.opq_iterations = 2;
+  ProductQuantizer quantizer;
+  EXPECT_TRUE(quantizer.Train(data.data(), 1000, 32, options));
+
+  std::stringstream stream;
+  EXPECT_TRUE(quantizer.Save(stream));
+  ProductQuantizer loaded;
+  EXPECT_TRUE(loaded.Load(stream));
+  EXPECT_EQ(quantizer.Dimension(), loaded.Dimension());
+  EXPECT_EQ(quantizer.CodeLength(), loaded.CodeLength());
+
+  std::vector<uint8_t> codes, loaded_codes;
+  quantizer.Encode(data.data(), 1000, codes);
+  loaded.Encode(data.data(), 1000, loaded_codes);
+  EXPECT_TRUE(codes == loaded_codes);
+
+  // A truncated stream is rejected
+  std::stringstream truncated(stream.str().substr(0, 100));
+  EXPECT_FALSE(loaded.Load(truncated));
+  EXPECT_FALSE(loaded.IsTrained());
+}
+
+TEST(ProductQuantizer, ArrayMatcher_Rerank)
+{
+  const std::vector<float> data = RandomDescriptors(2000, 6);
+  // Queries close to some database descriptors
+  std::vector<float> queries(data.begin(), data.begin() + 50 * 32);
+  std::mt19937 rng(7);
+  std::normal_distribution<float> noise(0.f, 0.1f);
+  for (float & value : queries)
+    value += noise(rng);
+
+  ArrayMatcherBruteForce<float> bf_matcher;
+  EXPECT_TRUE(bf_matcher.Build(data.data(), 2000, 32));
+  IndMatches bf_indices;
+  std::vector<float> bf_distances;
+  EXPECT_TRUE(bf_matcher.SearchNeighbours(queries.data(), 50, &bf_indices, &bf_distances, 2));
+
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 8;
+  ArrayMatcher_ProductQuantization<float> pq_matcher(32, options);
+  EXPECT_TRUE(pq_matcher.Build(data.data(), 2000, 32));
+  EXPECT_TRUE(pq_matcher.Quantizer() != nullptr);
+  IndMatches pq_indices;
+  std::vector<float> pq_distances;
+  EXPECT_TRUE(pq_matcher.SearchNeighbours(queries.data(), 50, &pq_indices, &pq_distances, 2));
+  EXPECT_EQ(bf_indices.size(), pq_indices.size());
+
+  // The re-ranked nearest neighbors are exact
+  for (int q = 0; q < 50; ++q)
+  {
+    EXPECT_EQ(q, pq_indices[q * 2].i_);
+    EXPECT_EQ(bf_indices[q * 2].j_, pq_indices[q * 2].j_);
+    EXPECT_NEAR(bf_distances[q * 2], pq_distances[q * 2], 1e-3);
+  }
+
+  int nIndice = -1;
+  float fDistance = -1.f;
+  EXPECT_TRUE(pq_matcher.SearchNeighbour(queries.data(), &nIndice, &fDistance));
+  EXPECT_EQ(0, nIndice);
+
+  // More neighbors than database descriptors
+  EXPECT_FALSE(pq_matcher.SearchNeighbours(queries.data(), 1, &pq_indices, &pq_distances, 2001));
+}
+
+TEST(ProductQuantizer, ArrayMatcher_SharedCodes)
+{
+  const std::vector<float> data = RandomDescriptors(1000, 8);
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 8;
+  auto quantizer = std::make_shared<ProductQuantizer>();
+  EXPECT_TRUE(quantizer->Train(data.data(), 1000, 32, options));
+  auto codes = std::make_shared<std::vector<uint8_t>>();
+  quantizer->Encode(data.data(), 1000, *codes);
+
+  // Without the raw descriptors, the ADC distances are used
+  ArrayMatcher_ProductQuantization<float> matcher;
+  EXPECT_FALSE(matcher.Build(quantizer, codes, 999));
+  EXPECT_TRUE(matcher.Build(quantizer, codes, 1000));
+  IndMatches indices;
+  std::vector<float> distances;
+  EXPECT_TRUE(matcher.SearchNeighbours(data.data(), 20, &indices, &distances, 2));
+  int nb_correct = 0;
+  for (int q = 0; q < 20; ++q)
+  {
+    EXPECT_TRUE(distances[q * 2] <= distances[q * 2 + 1]);
+    // the descriptor itself, or one with the same code
+    nb_correct += (indices[q * 2].j_ == q
+                   || std::equal(&(*codes)[q * 8], &(*codes)[q * 8 + 8],
+                                 &(*codes)[indices[q * 2].j_ * 8]));
+  }
+  EXPECT_EQ(20, nb_correct);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -11,6 +11,8 @@
 #include "openMVG/matching/matcher_cascade_hashing.hpp"
 #include "openMVG/matching/matcher_kdtree_flann.hpp"
 #include "openMVG/matching/matcher_hnsw.hpp"
+#include "openMVG/matching/matcher_multi_index_hashing.hpp"
+#include "openMVG/matching/matcher_product_quantization.hpp"
 #include "openMVG/matching/metric.hpp"
 #include "openMVG/matching/metric_hamming.hpp"
 #include "openMVG/system/logger.hpp"
@@ -58,9 +60,13 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
 )
 {
   // Handle invalid request
-  if (regions.IsScalar() && (eMatcherType == BRUTE_FORCE_HAMMING && eMatcherType == HNSW_HAMMING) )
+  const bool b_hamming_matcher =
+    eMatcherType == BRUTE_FORCE_HAMMING ||
+    eMatcherType == HNSW_HAMMING ||
+    eMatcherType == MULTI_INDEX_HASHING_HAMMING;
+  if (regions.IsScalar() && b_hamming_matcher)
     return {};
-  if (regions.IsBinary() && (eMatcherType != BRUTE_FORCE_HAMMING && eMatcherType != HNSW_HAMMING) )
+  if (regions.IsBinary() && !b_hamming_matcher)
     return {};
 
   std::unique_ptr<RegionsMatcher> region_matcher;
@@ -107,6 +113,12 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
           region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
         }
         break;
+        case PRODUCT_QUANTIZATION_L2:
+        {
+          using MatcherT = ArrayMatcher_ProductQuantization<unsigned char>;
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+        }
+        break;
         default:
           OPENMVG_LOG_ERROR << "Using unknown matcher type";
       }
@@ -144,6 +156,12 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
           region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
         }
         break;
+        case PRODUCT_QUANTIZATION_L2:
+        {
+          using MatcherT = ArrayMatcher_ProductQuantization<float>;
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+        }
+        break;
         default:
           OPENMVG_LOG_ERROR << "Using unknown matcher type";
       }
@@ -195,6 +213,12 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
         region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false));
       }
       break;
+      case MULTI_INDEX_HASHING_HAMMING:
+      {
+        using MatcherT = ArrayMatcher_MultiIndexHashing<unsigned char>;
+        region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false));
+      }
+      break;
       default:
           OPENMVG_LOG_ERROR << "Using unknown matcher type";
     }
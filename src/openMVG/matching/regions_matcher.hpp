@@ -9,6 +9,7 @@
 #ifndef OPENMVG_MATCHING_REGION_MATCHER_HPP
 #define OPENMVG_MATCHING_REGION_MATCHER_HPP
 
+#include <utility>
 #include <vector>
 
 #include "openMVG/features/regions.hpp"
@@ -81,6 +82,18 @@ class RegionsMatcher
     const features::Regions & query_regions,
     matching::IndMatches & vec_putative_matches
   ) = 0;
+
+  /**
+   * @brief Match some regions to the database
+   * Same as MatchDistanceRatio, but a match is kept only if the query region
+   * is also the nearest neighbor of its database region (mutual check).
+   */
+  virtual bool MatchDistanceRatioSymmetric
+  (
+    const float dist_ratio,
+    const features::Regions & query_regions,
+    matching::IndMatches & vec_putative_matches
+  ) = 0;
 };
 
 /**
@@ -106,12 +119,13 @@ class RegionsMatcherT : public RegionsMatcher
 private:
   ArrayMatcherT matcher_;
   const features::Regions * regions_;
+  bool b_database_; // Store if the database descriptors are set
   const bool b_squared_metric_; // Store if the metric is squared or not
 public:
   using Scalar = typename ArrayMatcherT::ScalarT;
   using DistanceType = typename ArrayMatcherT::DistanceType;
 
-  RegionsMatcherT(): regions_(nullptr), b_squared_metric_(false) {}
+  RegionsMatcherT(): regions_(nullptr), b_database_(false), b_squared_metric_(false) {}
 
   /**
    * @brief Init the matcher with some reference regions.
@@ -122,6 +136,7 @@ public:
     bool b_squared_metric = false
   ):
     regions_(&regions),
+    b_database_(true),
     b_squared_metric_(b_squared_metric)
   {
     if (regions_->RegionCount() == 0)
@@ -131,13 +146,33 @@ public:
     matcher_.Build(tab, regions_->RegionCount(), regions_->DescriptorLength());
   }
 
+  /**
+   * @brief Init the matcher with an already setup array matcher
+   *  (i.e. a search structure restored from a file over descriptors that
+   *  are not stored in a Regions container).
+   */
+  RegionsMatcherT
+  (
+    ArrayMatcherT && matcher,
+    bool b_squared_metric = false
+  ):
+    matcher_(std::move(matcher)),
+    regions_(nullptr),
+    b_database_(true),
+    b_squared_metric_(b_squared_metric)
+  {
+  }
+
+  /// Return the array matcher used to search the database
+  ArrayMatcherT & array_matcher() { return matcher_; }
+
   bool Match
   (
     const features::Regions & query_regions,
     matching::IndMatches & matches
   ) override
   {
-    if (!regions_)
+    if (!b_database_)
       return false;
 
     const Scalar * queries = reinterpret_cast<const Scalar *>(query_regions.DescriptorRawData());
@@ -166,7 +201,7 @@ public:
     matching::IndMatches & matches
   ) override
   {
-    if (!regions_)
+    if (!b_database_)
       return false;
 
     const Scalar * queries = reinterpret_cast<const Scalar *>(query_regions.DescriptorRawData());
@@ -205,6 +240,89 @@ public:
 
     return (!matches.empty());
   }
+
+  /**
+   * @brief Match some regions to the database of internal regions
+   *  and keep the mutual nearest neighbors passing the distance ratio test.
+   */
+  bool MatchDistanceRatioSymmetric
+  (
+    const float distance_ratio,
+    const features::Regions & query_regions,
+    matching::IndMatches & matches
+  ) override
+  {
+    if (!b_database_)
+      return false;
+
+    const Scalar * queries = reinterpret_cast<const Scalar *>(query_regions.DescriptorRawData());
+
+    const size_t number_neighbor = 2;
+    matching::IndMatches nn_matches;
+    std::vector<DistanceType> nn_distances;
+    // Nearest query of each database region
+    std::vector<int> reverse_indexes;
+
+    // Search the 2 closest neighbours for each query descriptor and the
+    // closest query of each database descriptor in one pass
+    if (!matcher_.SearchMutualNeighbours(queries,
+                                         query_regions.RegionCount(),
+                                         &nn_matches,
+                                         &nn_distances,
+                                         number_neighbor,
+                                         &reverse_indexes))
+    {
+      // The matcher cannot search in both directions: match the database
+      // to the query regions
+      if (!regions_ || query_regions.RegionCount() == 0)
+        return false;
+      nn_matches.clear();
+      nn_distances.clear();
+      if (!matcher_.SearchNeighbours(queries,
+                                     query_regions.RegionCount(),
+                                     &nn_matches,
+                                     &nn_distances,
+                                     number_neighbor))
+        return false;
+
+      ArrayMatcherT reverse_matcher;
+      matching::IndMatches reverse_matches;
+      std::vector<DistanceType> reverse_distances;
+      if (!reverse_matcher.Build(queries, query_regions.RegionCount(), query_regions.DescriptorLength()) ||
+          !reverse_matcher.SearchNeighbours(
+            reinterpret_cast<const Scalar *>(regions_->DescriptorRawData()),
+            regions_->RegionCount(),
+            &reverse_matches,
+            &reverse_distances,
+            1))
+        return false;
+      reverse_indexes.assign(regions_->RegionCount(), -1);
+      for (const auto & match : reverse_matches)
+        reverse_indexes[match.i_] = match.j_;
+    }
+
+    std::vector<int> nn_ratio_indexes;
+    matching::NNdistanceRatio(
+      nn_distances.cbegin(), // distance start
+      nn_distances.cend(),   // distance end
+      number_neighbor,       // Number of neighbor in iterator sequence (minimum required 2)
+      nn_ratio_indexes,      // output (indices that respect the distance Ratio)
+      b_squared_metric_ ? Square(distance_ratio) : distance_ratio);
+
+    matches.clear();
+    matches.reserve(nn_ratio_indexes.size());
+    for (const auto & index : nn_ratio_indexes)
+    {
+      const IndMatch & nn_match = nn_matches[index * number_neighbor];
+      // Keep the match only if the query is the nearest neighbor of its match
+      if (reverse_indexes[nn_match.j_] == static_cast<int>(nn_match.i_))
+      {
+        matches.emplace_back(nn_match.j_, nn_match.i_);
+      }
+    }
+
+    return (!matches.empty());
+  }
 };
 
 }  // namespace matching
@@ -14,6 +14,7 @@
 #include "openMVG/matching/indMatchDecoratorXY.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
 #include "openMVG/system/progressinterface.hpp"
 #include "openMVG/types.hpp"
 
@@ -27,8 +28,9 @@ using namespace openMVG::features;
 Cascade_Hashing_Matcher_Regions
 ::Cascade_Hashing_Matcher_Regions
 (
-  float distRatio
-):Matcher(), f_dist_ratio_(distRatio)
+  float distRatio,
+  bool b_symmetric
+):Matcher(), f_dist_ratio_(distRatio), b_symmetric_(b_symmetric)
 {
 }
 
@@ -40,6 +42,7 @@ void Match
   const sfm::Regions_Provider & regions_provider,
   const Pair_Set & pairs,
   float fDistRatio,
+  bool b_symmetric,
   PairWiseMatchesContainer & map_PutativeMatches, // the pairwise photometric corresponding points
   system::ProgressInterface * my_progress_bar
 )
@@ -162,6 +165,7 @@ void Match
         continue;
       }
 
+      OPENMVG_PROFILE_ZONE("PutativeMatching");
       // Matrix representation of the query input data;
       const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ->DescriptorRawData());
       Eigen::Map<BaseMat> mat_J( (ScalarT*)tabJ, regionsJ->RegionCount(), dimension);
@@ -171,12 +175,15 @@ void Match
       std::vector<ResultType> pvec_distances;
       pvec_distances.reserve(regionsJ->RegionCount() * 2);
       pvec_indices.reserve(regionsJ->RegionCount() * 2);
+      // Nearest J region of each I region (computed if b_symmetric)
+      std::vector<int> reverse_indices;
 
       // Match the query descriptors to the database
       cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
         hashed_base_[J], mat_J,
         hashed_base_[I], mat_I,
-        &pvec_indices, &pvec_distances);
+        &pvec_indices, &pvec_distances,
+        2, b_symmetric ? &reverse_indices : nullptr);
 
       std::vector<int> vec_nn_ratio_idx;
       // Filter the matches using a distance ratio test:
@@ -195,6 +202,10 @@ void Match
       for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
       {
         const size_t index = vec_nn_ratio_idx[k];
+        // Mutual check: the J region must be the nearest neighbor of its I region
+        if (b_symmetric &&
+            reverse_indices[pvec_indices[index*2].j_] != static_cast<int>(pvec_indices[index*2].i_))
+          continue;
         vec_putative_matches.emplace_back(pvec_indices[index*2].j_, pvec_indices[index*2].i_);
       }
 
@@ -249,6 +260,7 @@ void Cascade_Hashing_Matcher_Regions::Match
       *regions_provider.get(),
       pairs,
       f_dist_ratio_,
+      b_symmetric_,
       map_PutativeMatches,
       my_progress_bar);
   }
@@ -259,6 +271,7 @@ void Cascade_Hashing_Matcher_Regions::Match
       *regions_provider.get(),
       pairs,
       f_dist_ratio_,
+      b_symmetric_,
       map_PutativeMatches,
       my_progress_bar);
   }
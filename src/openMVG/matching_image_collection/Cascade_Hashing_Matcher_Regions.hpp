@@ -25,13 +25,15 @@ namespace matching_image_collection {
 ///  a threshold over the distance ratio of the 2 nearest neighbours.
 /// Using a Cascade Hashing matching
 /// Cascade hashing tables are computed once and used for all the regions.
+/// Optionally only the mutual nearest neighbours are kept.
 ///
 class Cascade_Hashing_Matcher_Regions : public Matcher
 {
   public:
   explicit Cascade_Hashing_Matcher_Regions
   (
-    float dist_ratio
+    float dist_ratio,
+    bool b_symmetric = false
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -45,6 +47,8 @@ class Cascade_Hashing_Matcher_Regions : public Matcher
   private:
   // Distance ratio used to discard spurious correspondence
   float f_dist_ratio_;
+  // Keep only the mutual nearest neighbours
+  bool b_symmetric_;
 };
 
 } // namespace matching_image_collection
@@ -15,6 +15,7 @@
 
 #include "openMVG/features/feature.hpp"
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/system/profiler.hpp"
 #include "openMVG/system/progressinterface.hpp"
 
 namespace openMVG { namespace sfm { struct Regions_Provider; } }
@@ -91,6 +92,7 @@ void ImageCollectionGeometricFilter::Robust_model_estimation
 
     //-- Apply the geometric filter (robust model estimation)
     {
+      OPENMVG_PROFILE_ZONE("GeometricFiltering");
       IndMatches putative_inliers;
       GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
       if (geometricFilter.Robust_estimation(
@@ -12,6 +12,7 @@
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/system/progressinterface.hpp"
 #include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
 
 namespace openMVG {
 namespace matching_image_collection {
@@ -21,11 +22,12 @@ using namespace openMVG::features;
 
 Matcher_Regions::Matcher_Regions
 (
-  float distRatio, EMatcherType eMatcherType
+  float distRatio, EMatcherType eMatcherType, bool b_symmetric
 ):
   Matcher(),
   f_dist_ratio_(distRatio),
-  eMatcherType_(eMatcherType)
+  eMatcherType_(eMatcherType),
+  b_symmetric_(b_symmetric)
 {
 }
 
@@ -90,7 +92,13 @@ void Matcher_Regions::Match(
       }
 
       IndMatches vec_putative_matches;
-      matcher->MatchDistanceRatio(f_dist_ratio_, *regionsJ.get(), vec_putative_matches);
+      {
+        OPENMVG_PROFILE_ZONE("PutativeMatching");
+        if (b_symmetric_)
+          matcher->MatchDistanceRatioSymmetric(f_dist_ratio_, *regionsJ.get(), vec_putative_matches);
+        else
+          matcher->MatchDistanceRatio(f_dist_ratio_, *regionsJ.get(), vec_putative_matches);
+      }
 
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp critical
@@ -23,7 +23,8 @@ namespace matching_image_collection {
 /// Implementation of an Image Collection Matcher
 /// Compute putative matches between a collection of pictures
 /// Spurious correspondences are discarded by using the
-///  a threshold over the distance ratio of the 2 nearest neighbours.
+///  a threshold over the distance ratio of the 2 nearest neighbours
+///  and optionally by keeping only the mutual nearest neighbours.
 ///
 class Matcher_Regions : public Matcher
 {
@@ -31,7 +32,8 @@ class Matcher_Regions : public Matcher
   Matcher_Regions
   (
     float dist_ratio,
-    matching::EMatcherType eMatcherType
+    matching::EMatcherType eMatcherType,
+    bool b_symmetric = false
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -48,6 +50,8 @@ class Matcher_Regions : public Matcher
   float f_dist_ratio_;
   // Matcher Type
   matching::EMatcherType eMatcherType_;
+  // Keep only the mutual nearest neighbours
+  bool b_symmetric_;
 };
 
 } // namespace matching_image_collection
@@ -0,0 +1,361 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching_image_collection/Product_Quantization_Matcher_Regions.hpp"
+
+#include "openMVG/features/feature.hpp"
+#include "openMVG/matching/matcher_product_quantization.hpp"
+#include "openMVG/matching/matching_filters.hpp"
+#include "openMVG/matching/indMatchDecoratorXY.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
+#include "openMVG/system/progressinterface.hpp"
+#include "openMVG/types.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace openMVG {
+namespace matching_image_collection {
+
+using namespace openMVG::matching;
+using namespace openMVG::features;
+
+Product_Quantization_Matcher_Regions
+::Product_Quantization_Matcher_Regions
+(
+  float dist_ratio,
+  const ProductQuantizer::Options & options,
+  int rerank_count,
+  const std::string & codebook_filename
+):Matcher(),
+  f_dist_ratio_(dist_ratio),
+  options_(options),
+  rerank_count_(rerank_count),
+  codebook_filename_(codebook_filename)
+{
+}
+
+namespace impl
+{
+
+/// Load the codebook file, or train a codebook on regions sampled evenly
+/// over the used views (and save it to the codebook file).
+template <typename ScalarT>
+std::shared_ptr<const ProductQuantizer> InitQuantizer
+(
+  const sfm::Regions_Provider & regions_provider,
+  const std::set<IndexT> & used_index,
+  ProductQuantizer::Options options,
+  const std::string & codebook_filename
+)
+{
+  if (used_index.empty() || !regions_provider.getRegionsType())
+    return nullptr;
+  const size_t dimension = regions_provider.getRegionsType()->DescriptorLength();
+
+  auto quantizer = std::make_shared<ProductQuantizer>();
+  if (!codebook_filename.empty() && stlplus::file_exists(codebook_filename))
+  {
+    std::ifstream stream(codebook_filename, std::ios::binary);
+    if (quantizer->Load(stream) && quantizer->Dimension() == static_cast<int>(dimension))
+    {
+      OPENMVG_LOG_INFO << "Using the product quantization codebook: " << codebook_filename;
+      return quantizer;
+    }
+    OPENMVG_LOG_WARNING << "Invalid product quantization codebook, it will be trained again: "
+      << codebook_filename;
+  }
+
+  // Sample the regions evenly among all the views, in a single reading of
+  // the regions: every stride-th region is kept, and when the sample buffer
+  // is full the stride is doubled (every other sample is dropped).
+  // It keeps between kMaxTrainingSamples / 2 and kMaxTrainingSamples regions.
+  const size_t max_samples =
+    static_cast<size_t>(Product_Quantization_Matcher_Regions::kMaxTrainingSamples);
+  std::vector<float> sample_values; // row major samples
+  size_t stride = 1, region_index = 0;
+  for (const IndexT I : used_index)
+  {
+    const std::shared_ptr<features::Regions> regionsI = regions_provider.get(I);
+    if (!regionsI)
+      continue;
+    const ScalarT * tabI =
+      reinterpret_cast<const ScalarT*>(regionsI->DescriptorRawData());
+    const size_t region_count = regionsI->RegionCount();
+    for (size_t i = 0; i < region_count; ++i, ++region_index)
+    {
+      if (region_index % stride != 0)
+        continue;
+      if (sample_values.size() == max_samples * dimension)
+      {
+        for (size_t k = 1; 2 * k < max_samples; ++k)
+          std::copy_n(&sample_values[2 * k * dimension], dimension, &sample_values[k * dimension]);
+        sample_values.resize((max_samples + 1) / 2 * dimension);
+        stride *= 2;
+        if (region_index % stride != 0)
+          continue;
+      }
+      const ScalarT * descriptor = tabI + i * dimension;
+      sample_values.insert(sample_values.end(), descriptor, descriptor + dimension);
+    }
+  }
+  const size_t nb_samples = sample_values.size() / dimension;
+  if (nb_samples == 0)
+    return nullptr;
+  const ProductQuantizer::RowMatrixXf samples =
+    Eigen::Map<const ProductQuantizer::RowMatrixXf>(sample_values.data(), nb_samples, dimension);
+  std::vector<float>().swap(sample_values);
+
+  // The code length must divide the descriptor length
+  while (options.nb_subquantizers > 1 && dimension % options.nb_subquantizers != 0)
+    --options.nb_subquantizers;
+
+  OPENMVG_LOG_INFO << "Training the product quantization codebook on "
+    << nb_samples << " regions";
+  if (!quantizer->Train(samples, options))
+  {
+    OPENMVG_LOG_ERROR << "Cannot train the product quantization codebook";
+    return nullptr;
+  }
+  if (!codebook_filename.empty())
+  {
+    std::ofstream stream(codebook_filename, std::ios::binary);
+    if (!quantizer->Save(stream))
+      OPENMVG_LOG_WARNING << "Cannot save the product quantization codebook: " << codebook_filename;
+  }
+  return quantizer;
+}
+
+/// The compact representation of the regions of a view
+struct Encoded_Regions
+{
+  std::shared_ptr<const std::vector<uint8_t>> codes;
+  std::vector<features::PointFeature> positions;
+};
+
+template <typename ScalarT>
+void Match
+(
+  const sfm::Regions_Provider & regions_provider,
+  const Pair_Set & pairs,
+  float fDistRatio,
+  const ProductQuantizer::Options & options,
+  int rerank_count,
+  const std::string & codebook_filename,
+  PairWiseMatchesContainer & map_PutativeMatches, // the pairwise photometric corresponding points
+  system::ProgressInterface * my_progress_bar
+)
+{
+  if (!my_progress_bar)
+    my_progress_bar = &system::ProgressInterface::dummy();
+  my_progress_bar->Restart(pairs.size(), "- Matching -");
+
+  // Collect used view indexes
+  std::set<IndexT> used_index;
+  // Sort pairs according the first index to minimize later memory swapping
+  using Map_vectorT = std::map<IndexT, std::vector<IndexT>>;
+  Map_vectorT map_Pairs;
+  for (const auto & pair_idx : pairs)
+  {
+    map_Pairs[pair_idx.first].push_back(pair_idx.second);
+    used_index.insert(pair_idx.first);
+    used_index.insert(pair_idx.second);
+  }
+
+  const std::shared_ptr<const ProductQuantizer> quantizer =
+    InitQuantizer<ScalarT>(regions_provider, used_index, options, codebook_filename);
+  if (!quantizer)
+    return;
+
+  // Encode the regions of every view once.
+  // Only the codes and the region positions are kept: the raw descriptors
+  // are requested to the regions provider when they are used (as queries,
+  // and to re-rank the candidates), so a Regions_Provider_Cache bounds the
+  // number of raw regions in memory.
+  std::map<IndexT, Encoded_Regions> encoded_base;
+  for (const IndexT I : used_index)
+    encoded_base[I] = Encoded_Regions();
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(used_index.size()); ++i)
+  {
+    std::set<IndexT>::const_iterator iter = used_index.begin();
+    std::advance(iter, i);
+    const IndexT I = *iter;
+    const std::shared_ptr<features::Regions> regionsI = regions_provider.get(I);
+    if (!regionsI)
+      continue;
+    const ScalarT * tabI =
+      reinterpret_cast<const ScalarT*>(regionsI->DescriptorRawData());
+
+    // The map keys already exist: each thread writes its own value
+    Encoded_Regions & encoded = encoded_base.at(I);
+    auto codes = std::make_shared<std::vector<uint8_t>>();
+    quantizer->Encode(tabI, static_cast<int>(regionsI->RegionCount()), *codes);
+    encoded.codes = codes;
+    encoded.positions = regionsI->GetRegionsPositions();
+  }
+
+  // Perform matching between all the pairs
+  for (const auto & pair_it : map_Pairs)
+  {
+    if (my_progress_bar->hasBeenCanceled())
+      break;
+    const IndexT I = pair_it.first;
+    const std::vector<IndexT> & indexToCompare = pair_it.second;
+
+    const Encoded_Regions & encodedI = encoded_base.at(I);
+    const std::vector<features::PointFeature> & pointFeaturesI = encodedI.positions;
+    if (pointFeaturesI.size() < 2)
+    {
+      (*my_progress_bar) += indexToCompare.size();
+      continue;
+    }
+
+    // The database is the encoded regions of I,
+    // its raw descriptors are loaded only to re-rank the candidates
+    std::shared_ptr<features::Regions> regionsI;
+    if (rerank_count > 0)
+      regionsI = regions_provider.get(I);
+    const ScalarT * tabI = regionsI ?
+      reinterpret_cast<const ScalarT*>(regionsI->DescriptorRawData()) : nullptr;
+
+    ArrayMatcher_ProductQuantization<ScalarT> matcher(rerank_count);
+    if (!matcher.Build(quantizer, encodedI.codes,
+                       static_cast<int>(pointFeaturesI.size()), tabI))
+    {
+      (*my_progress_bar) += indexToCompare.size();
+      continue;
+    }
+
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int j = 0; j < (int)indexToCompare.size(); ++j)
+    {
+      if (my_progress_bar->hasBeenCanceled())
+        continue;
+      const size_t J = indexToCompare[j];
+      const std::shared_ptr<features::Regions> regionsJ = regions_provider.get(J);
+
+      if (!regionsJ || regionsJ->RegionCount() == 0)
+      {
+        ++(*my_progress_bar);
+        continue;
+      }
+
+      OPENMVG_PROFILE_ZONE("PutativeMatching");
+      const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ->DescriptorRawData());
+
+      IndMatches pvec_indices;
+      std::vector<float> pvec_distances;
+      // Match the query descriptors (J) to the database (I)
+      matcher.SearchNeighbours(tabJ, static_cast<int>(regionsJ->RegionCount()),
+                               &pvec_indices, &pvec_distances, 2);
+
+      std::vector<int> vec_nn_ratio_idx;
+      // Filter the matches using a distance ratio test:
+      //   The probability that a match is correct is determined by taking
+      //   the ratio of distance from the closest neighbor to the distance
+      //   of the second closest.
+      matching::NNdistanceRatio(
+        pvec_distances.begin(), // distance start
+        pvec_distances.end(),   // distance end
+        2, // Number of neighbor in iterator sequence (minimum required 2)
+        vec_nn_ratio_idx, // output (indices that respect the distance Ratio)
+        Square(fDistRatio));
+
+      matching::IndMatches vec_putative_matches;
+      vec_putative_matches.reserve(vec_nn_ratio_idx.size());
+      for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
+      {
+        const size_t index = vec_nn_ratio_idx[k];
+        vec_putative_matches.emplace_back(pvec_indices[index*2].j_, pvec_indices[index*2].i_);
+      }
+
+      // Remove duplicates
+      matching::IndMatch::getDeduplicated(vec_putative_matches);
+
+      // Remove matches that have the same (X,Y) coordinates
+      matching::IndMatchDecorator<float> matchDeduplicator(vec_putative_matches,
+        pointFeaturesI, encoded_base.at(J).positions);
+      matchDeduplicator.getDeduplicated(vec_putative_matches);
+
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp critical
+#endif
+      {
+        if (!vec_putative_matches.empty())
+        {
+          map_PutativeMatches.insert(
+            {
+              {I,J},
+              std::move(vec_putative_matches)
+            });
+        }
+      }
+      ++(*my_progress_bar);
+    }
+  }
+}
+} // namespace impl
+
+void Product_Quantization_Matcher_Regions::Match
+(
+  const std::shared_ptr<sfm::Regions_Provider> & regions_provider,
+  const Pair_Set & pairs,
+  PairWiseMatchesContainer & map_PutativeMatches, // the pairwise photometric corresponding points
+  system::ProgressInterface * my_progress_bar
+)const
+{
+#ifdef OPENMVG_USE_OPENMP
+  OPENMVG_LOG_INFO << "Using the OPENMP thread interface";
+#endif
+  if (!regions_provider)
+    return;
+
+  if (regions_provider->IsBinary())
+    return;
+
+  if (regions_provider->Type_id() == typeid(unsigned char).name())
+  {
+    impl::Match<unsigned char>(
+      *regions_provider.get(),
+      pairs,
+      f_dist_ratio_,
+      options_,
+      rerank_count_,
+      codebook_filename_,
+      map_PutativeMatches,
+      my_progress_bar);
+  }
+  else
+  if (regions_provider->Type_id() == typeid(float).name())
+  {
+    impl::Match<float>(
+      *regions_provider.get(),
+      pairs,
+      f_dist_ratio_,
+      options_,
+      rerank_count_,
+      codebook_filename_,
+      map_PutativeMatches,
+      my_progress_bar);
+  }
+  else
+  {
+    OPENMVG_LOG_ERROR << "Matcher not implemented for this region type: " << regions_provider->Type_id();
+  }
+}
+
+} // namespace openMVG
+} // namespace matching_image_collection
@@ -0,0 +1,83 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_PRODUCT_QUANTIZATION_MATCHER_REGIONS_HPP
+#define OPENMVG_MATCHING_PRODUCT_QUANTIZATION_MATCHER_REGIONS_HPP
+
+#include <memory>
+#include <string>
+
+#include "openMVG/matching/product_quantizer.hpp"
+#include "openMVG/matching_image_collection/Matcher.hpp"
+
+namespace openMVG { namespace matching { class PairWiseMatchesContainer; } }
+namespace openMVG { namespace sfm { struct Regions_Provider; } }
+
+namespace openMVG {
+namespace matching_image_collection {
+
+/// Implementation of an Image Collection Matcher
+/// Compute putative matches between a collection of pictures
+/// Spurious correspondences are discarded by using the
+///  a threshold over the distance ratio of the 2 nearest neighbours.
+/// Using a product quantization matching:
+/// - a single codebook is trained from a sample of all the regions
+///   (or loaded from a file),
+/// - the regions of each image are encoded once (CodeLength bytes per region),
+/// - each query is compared to the codes by asymmetric distance computation,
+///   and its best candidates are re-ranked with the exact L2 distance.
+/// Only the codes and the region positions are kept during the matching,
+/// the raw descriptors are requested to the regions provider when they are
+/// used (the queries, and the database only if the candidates are re-ranked).
+///
+class Product_Quantization_Matcher_Regions : public Matcher
+{
+  public:
+  /**
+   * @param dist_ratio Distance ratio used to discard spurious correspondence
+   * @param options Product quantizer settings
+   * @param rerank_count Number of candidates re-ranked with the exact distance
+   *  (0: the distance ratio is computed on the approximate distances)
+   * @param codebook_filename Optional codebook file: the codebook is loaded
+   *  from this file if it exists, else it is trained and saved to this file.
+   */
+  explicit Product_Quantization_Matcher_Regions
+  (
+    float dist_ratio,
+    const matching::ProductQuantizer::Options & options = matching::ProductQuantizer::Options(),
+    int rerank_count = 16,
+    const std::string & codebook_filename = ""
+  );
+
+  /// Find corresponding points between some pair of view Ids
+  void Match
+  (const std::shared_ptr<sfm::Regions_Provider> & regions_provider,
+    const Pair_Set & pairs,
+    matching::PairWiseMatchesContainer & map_PutativeMatches, // the pairwise photometric corresponding points
+    system::ProgressInterface * progress = nullptr
+  ) const override;
+
+  /// Maximal number of regions used to train the codebook
+  /// (sampled evenly among the views, at least half of it is used when there
+  /// are more regions)
+  static const int kMaxTrainingSamples = 100000;
+
+  /// Regions cache size advised with this matcher: the matcher keeps the
+  /// codes of all the views and reads the raw regions on demand
+  static const unsigned int kRegionsCacheSize = 32;
+
+  private:
+  // Distance ratio used to discard spurious correspondence
+  float f_dist_ratio_;
+  matching::ProductQuantizer::Options options_;
+  int rerank_count_;
+  std::string codebook_filename_;
+};
+
+} // namespace matching_image_collection
+} // namespace openMVG
+
+#endif // OPENMVG_MATCHING_PRODUCT_QUANTIZATION_MATCHER_REGIONS_HPP
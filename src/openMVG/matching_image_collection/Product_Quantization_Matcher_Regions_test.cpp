@@ -0,0 +1,131 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching_image_collection/Product_Quantization_Matcher_Regions.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::matching;
+using namespace openMVG::matching_image_collection;
+
+// A regions provider that returns a new copy of the regions at each request
+// (as Regions_Provider_Cache reads them from the disk), and counts the
+// requests and the copies in use.
+struct Counting_Regions_Provider : public sfm::Regions_Provider
+{
+  std::map<IndexT, AKAZE_Float_Regions> stored_regions;
+  mutable std::map<IndexT, int> nb_requests;
+  mutable std::atomic<int> nb_alive{0};
+  mutable std::mutex mutex;
+
+  Counting_Regions_Provider()
+  {
+    region_type_.reset(new AKAZE_Float_Regions);
+  }
+
+  std::shared_ptr<Regions> get(const IndexT x) const override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++nb_requests[x];
+    }
+    ++nb_alive;
+    return std::shared_ptr<Regions>(new AKAZE_Float_Regions(stored_regions.at(x)),
+      [this](Regions * regions) { --nb_alive; delete regions; });
+  }
+};
+
+// Three views of the same random descriptors (with some noise):
+// the region i of a view corresponds to the region i of the other views.
+void InitRegions(Counting_Regions_Provider & provider)
+{
+  const int nb_regions = 400, dimension = 64;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> value(0.f, 1.f);
+  std::normal_distribution<float> noise(0.f, 0.01f);
+  std::vector<float> descriptors(nb_regions * dimension);
+  for (float & d : descriptors)
+    d = value(rng);
+
+  for (IndexT view = 0; view < 3; ++view)
+  {
+    AKAZE_Float_Regions & regions = provider.stored_regions[view];
+    for (int i = 0; i < nb_regions; ++i)
+    {
+      regions.Features().emplace_back(1000.f * value(rng), 1000.f * value(rng), 1.f, 0.f);
+      AKAZE_Float_Regions::DescriptorT descriptor;
+      for (int d = 0; d < dimension; ++d)
+        descriptor[d] = descriptors[i * dimension + d] + noise(rng);
+      regions.Descriptors().push_back(descriptor);
+    }
+  }
+}
+
+TEST(Product_Quantization_Matcher_Regions, RawRegionsOnDemand)
+{
+  const Pair_Set pairs = {{0, 1}, {0, 2}, {1, 2}};
+  ProductQuantizer::Options options;
+  options.nb_subquantizers = 16;
+
+  // Train the codebook once (the training samples are read from all the views)
+  const std::string codebook_filename = "pq_codebook_test.bin";
+  {
+    auto provider = std::make_shared<Counting_Regions_Provider>();
+    InitRegions(*provider);
+    const Product_Quantization_Matcher_Regions matcher(0.8f, options, 0, codebook_filename);
+    PairWiseMatches matches;
+    matcher.Match(provider, pairs, matches);
+    EXPECT_TRUE(stlplus::file_exists(codebook_filename));
+    // The training samples are read in a single pass over the regions:
+    // the view 0 is read once to sample its regions, then once to be encoded
+    EXPECT_EQ(2, provider->nb_requests.at(0));
+  }
+
+  for (const int rerank_count : {0, 16})
+  {
+    auto provider = std::make_shared<Counting_Regions_Provider>();
+    InitRegions(*provider);
+
+    const Product_Quantization_Matcher_Regions matcher(0.8f, options, rerank_count, codebook_filename);
+    PairWiseMatches matches;
+    matcher.Match(provider, pairs, matches);
+
+    // The matching is correct
+    EXPECT_EQ(pairs.size(), matches.size());
+    for (const auto & pair_matches : matches)
+    {
+      const auto nb_correct = std::count_if(pair_matches.second.cbegin(), pair_matches.second.cend(),
+        [](const IndMatch & match) { return match.i_ == match.j_; });
+      EXPECT_TRUE(nb_correct > 0.9 * 400);
+    }
+
+    // No raw regions are kept after the matching
+    EXPECT_EQ(0, provider->nb_alive);
+    // The regions of the view 0 are only used as a database:
+    // they are read once to be encoded, and once more to re-rank the candidates
+    EXPECT_EQ(rerank_count > 0 ? 2 : 1, provider->nb_requests.at(0));
+    // The regions of the view 2 are only used as queries
+    // (once to be encoded, then by each pair)
+    EXPECT_EQ(3, provider->nb_requests.at(2));
+  }
+  EXPECT_TRUE(stlplus::file_delete(codebook_filename));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
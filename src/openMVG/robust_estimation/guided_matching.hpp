@@ -11,10 +11,12 @@
 
 #include <algorithm>
 #include <limits>
+#include <numeric>
 #include <vector>
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/features/regions.hpp"
+#include "openMVG/geometry/pose3.hpp"
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/numeric/numeric.h"
 
@@ -392,6 +394,188 @@ void GuidedMatching_Fundamental_Fast(
   }
 }
 
+/// Clip the segment [x0,x1] to the rectangle [min,max].
+/// Return false if the segment lies outside the rectangle (Liang-Barsky).
+static inline bool clip_segment(const Vec2 & min, const Vec2 & max, Vec2 & x0, Vec2 & x1)
+{
+  const Vec2 d = x1 - x0;
+  double t0 = 0.0, t1 = 1.0;
+  for (int k = 0; k < 2; ++k)
+  {
+    const double bounds[2][2] = {{-d(k), x0(k) - min(k)}, {d(k), max(k) - x0(k)}};
+    for (const auto & bound : bounds)
+    {
+      const double p = bound[0], q = bound[1];
+      if (p == 0.0)
+      {
+        if (q < 0.0)
+          return false;
+      }
+      else
+      {
+        const double t = q / p;
+        if (p < 0.0)
+          t0 = std::max(t0, t);
+        else
+          t1 = std::min(t1, t);
+      }
+    }
+  }
+  if (t0 > t1)
+    return false;
+  x1 = x0 + t1 * d;
+  x0 = x0 + t0 * d;
+  return true;
+}
+
+/// Guided Matching (features + descriptors with distance ratio) for known poses:
+/// Restrict the search of each left feature to the epipolar segment covered
+///  by its viewing ray between a near and a far depth of the left camera.
+///   Keep the best corresponding points under the user specified distance ratio.
+/// The right features are stored in a uniform grid, and only the cells along
+///  the (threshold enlarged) segment are visited.
+/// The cameras must be pinhole like: the near and far depths are measured
+///  along the left camera optical axis.
+static inline void GuidedMatching_Fundamental_Segment(
+  const cameras::IntrinsicBase * camL, // Camera used to undistord & back-project left features
+  const geometry::Pose3 & poseL,
+  const features::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const cameras::IntrinsicBase * camR, // Camera used to undistord right features & project points
+  const geometry::Pose3 & poseR,
+  const features::Regions & rRegions,  // regions (point features & corresponding descriptors)
+  const double depth_near, // Scene depth range in the left view
+  const double depth_far,
+  double errorTh,       // Maximal authorized error threshold (consider it's a square threshold)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  const size_t nb_right = rRegions.RegionCount();
+  if (lRegions.RegionCount() == 0 || nb_right == 0 || depth_far <= depth_near)
+    return;
+
+  //--
+  //-- Store the right points in a uniform grid
+  //--
+  std::vector<Vec2> rRegionsPos(nb_right);
+  Vec2 grid_min = Vec2::Constant(std::numeric_limits<double>::max());
+  Vec2 grid_max = Vec2::Constant(std::numeric_limits<double>::lowest());
+  for (size_t j = 0; j < nb_right; ++j)
+  {
+    rRegionsPos[j] = camR->get_ud_pixel(rRegions.GetRegionPosition(j));
+    grid_min = grid_min.cwiseMin(rRegionsPos[j]);
+    grid_max = grid_max.cwiseMax(rRegionsPos[j]);
+  }
+  const double radius = std::sqrt(errorTh);
+  grid_min.array() -= radius;
+  grid_max.array() += radius;
+  const Vec2 grid_extent = grid_max - grid_min;
+  // Cells are at least as large as the search band, and hold a few points on average
+  const double cell_size = std::max(
+    {2.0 * radius, std::sqrt(grid_extent(0) * grid_extent(1) / nb_right), 1.0});
+  const int
+    grid_w = static_cast<int>(grid_extent(0) / cell_size) + 1,
+    grid_h = static_cast<int>(grid_extent(1) / cell_size) + 1;
+  const auto to_cell = [&](const double v, const int dim, const int size)
+  {
+    return std::min(std::max(static_cast<int>((v - grid_min(dim)) / cell_size), 0), size - 1);
+  };
+
+  // Compressed storage: ids of the points of cell c are in [offsets[c], offsets[c+1])
+  std::vector<uint32_t> offsets(grid_w * grid_h + 1, 0), ids(nb_right);
+  std::vector<uint32_t> cell_of(nb_right);
+  for (size_t j = 0; j < nb_right; ++j)
+  {
+    cell_of[j] = to_cell(rRegionsPos[j](1), 1, grid_h) * grid_w
+      + to_cell(rRegionsPos[j](0), 0, grid_w);
+    ++offsets[cell_of[j] + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t j = 0; j < nb_right; ++j)
+      ids[fill[cell_of[j]]++] = j;
+  }
+
+  //--
+  //-- For each left point, visit the cells along its epipolar segment
+  //--
+  const Mat34 P_R = camR->get_projective_equivalent(poseR);
+  const Vec3 epipole = P_R * poseL.center().homogeneous();
+  const Mat3 Rt_L = poseL.rotation().transpose();
+
+  std::vector<size_t> cell_stamp(grid_w * grid_h, std::numeric_limits<size_t>::max());
+  for (size_t i = 0; i < lRegions.RegionCount(); ++i)
+  {
+    const Vec2 l_pt = camL->get_ud_pixel(lRegions.GetRegionPosition(i));
+    const Vec3 bearing = (*camL)(l_pt);
+    if (bearing(2) <= 0.0)
+      continue;
+    // Image of the ray point at depth d: epipole + d * direction
+    const Vec3 direction = P_R.leftCols<3>() * (Rt_L * (bearing / bearing(2)));
+
+    // Keep only the part of the depth range that lies in front of the right camera
+    double d0 = depth_near, d1 = depth_far;
+    const double z0 = epipole(2) + d0 * direction(2), z1 = epipole(2) + d1 * direction(2);
+    if (z0 <= 0.0 && z1 <= 0.0)
+      continue;
+    const double z_min = 1e-3 * std::max(z0, z1);
+    if (z0 < z_min)
+      d0 = (z_min - epipole(2)) / direction(2);
+    else if (z1 < z_min)
+      d1 = (z_min - epipole(2)) / direction(2);
+
+    Vec2
+      x0 = (epipole + d0 * direction).hnormalized(),
+      x1 = (epipole + d1 * direction).hnormalized();
+    if (!clip_segment(grid_min, grid_max, x0, x1))
+      continue;
+
+    // Sample the segment every cell_size: every point within radius of the
+    // segment is then within radius + cell_size / 2 of a sample.
+    const Vec2 segment = x1 - x0;
+    const double segment_sq_length = segment.squaredNorm();
+    const int nb_samples = static_cast<int>(std::sqrt(segment_sq_length) / cell_size) + 1;
+    const double reach = radius + cell_size / 2.0;
+
+    distanceRatio<double> dR;
+    for (int s = 0; s <= nb_samples; ++s)
+    {
+      const Vec2 sample = x0 + segment * (static_cast<double>(s) / nb_samples);
+      const int
+        cx_min = to_cell(sample(0) - reach, 0, grid_w), cx_max = to_cell(sample(0) + reach, 0, grid_w),
+        cy_min = to_cell(sample(1) - reach, 1, grid_h), cy_max = to_cell(sample(1) + reach, 1, grid_h);
+      for (int cy = cy_min; cy <= cy_max; ++cy)
+      {
+        for (int cx = cx_min; cx <= cx_max; ++cx)
+        {
+          const int cell = cy * grid_w + cx;
+          if (cell_stamp[cell] == i)
+            continue;
+          cell_stamp[cell] = i;
+          for (uint32_t k = offsets[cell]; k < offsets[cell + 1]; ++k)
+          {
+            const uint32_t j = ids[k];
+            // Squared distance of the right point to the epipolar segment
+            const double t = segment_sq_length > 0.0 ?
+              std::min(std::max((rRegionsPos[j] - x0).dot(segment) / segment_sq_length, 0.0), 1.0)
+              : 0.0;
+            if ((x0 + t * segment - rRegionsPos[j]).squaredNorm() < errorTh)
+            {
+              // Update the corresponding points & distance (if required)
+              dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+            }
+          }
+        }
+      }
+    }
+    // Add correspondence only iff the distance ratio is valid
+    if (dR.isValid(distRatio))
+    {
+      vec_corresponding_index.emplace_back(i, dR.idx);
+    }
+  }
+}
+
 } // namespace geometry_aware
 } // namespace openMVG
 
@@ -0,0 +1,129 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/robust_estimation/guided_matching.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::features;
+using namespace openMVG::geometry;
+
+// Two side by side cameras looking at points with a depth in [5,10]
+// The right view contains the image of every point (same descriptor) and
+// as many distractors (random position & descriptor).
+struct Stereo_Scene
+{
+  const Pinhole_Intrinsic cam{1000, 800, 1000, 500, 400};
+  const Pose3 poseL{Mat3::Identity(), Vec3(0., 0., 0.)};
+  const Pose3 poseR{Mat3::Identity(), Vec3(1., 0., 0.)};
+  SIFT_Regions regionsL, regionsR;
+
+  explicit Stereo_Scene(const int nb_points)
+  {
+    std::mt19937 rng(std::mt19937::default_seed);
+    std::uniform_real_distribution<double> x_dist(-2., 2.), y_dist(-1.5, 1.5), z_dist(5., 10.);
+    std::uniform_real_distribution<float> u_dist(0.f, 1000.f), v_dist(0.f, 800.f);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    const auto random_descriptor = [&]()
+    {
+      SIFT_Regions::DescriptorT desc;
+      for (int k = 0; k < SIFT_Regions::DescriptorT::static_size; ++k)
+        desc[k] = byte_dist(rng);
+      return desc;
+    };
+    while (static_cast<int>(regionsL.RegionCount()) < nb_points)
+    {
+      const Vec3 X(x_dist(rng), y_dist(rng), z_dist(rng));
+      const Vec2 xL = cam.project(poseL(X)), xR = cam.project(poseR(X));
+      if ((xL.array() < 0.).any() || (xR.array() < 0.).any()
+          || xL(0) >= cam.w() || xR(0) >= cam.w() || xL(1) >= cam.h() || xR(1) >= cam.h())
+        continue;
+      const SIFT_Regions::DescriptorT desc = random_descriptor();
+      regionsL.Features().emplace_back(xL(0), xL(1));
+      regionsL.Descriptors().push_back(desc);
+      regionsR.Features().emplace_back(xR(0), xR(1));
+      regionsR.Descriptors().push_back(desc);
+    }
+    for (int i = 0; i < nb_points; ++i)
+    {
+      regionsR.Features().emplace_back(u_dist(rng), v_dist(rng));
+      regionsR.Descriptors().push_back(random_descriptor());
+    }
+  }
+};
+
+TEST(GuidedMatching_Fundamental_Segment, FindsPointsWithinDepthRange)
+{
+  const Stereo_Scene scene(500);
+
+  matching::IndMatches matches;
+  geometry_aware::GuidedMatching_Fundamental_Segment(
+    &scene.cam, scene.poseL, scene.regionsL,
+    &scene.cam, scene.poseR, scene.regionsR,
+    4., 12.,
+    Square(2.), Square(0.8),
+    matches);
+
+  // The distance ratio test discards the points without a second candidate
+  // on their segment, the other ones must be found and be correct.
+  EXPECT_TRUE(matches.size() > scene.regionsL.RegionCount() / 2);
+  for (const auto & match : matches)
+  {
+    EXPECT_EQ(match.i_, match.j_);
+  }
+}
+
+TEST(GuidedMatching_Fundamental_Segment, IgnoresPointsOutsideDepthRange)
+{
+  const Stereo_Scene scene(500);
+
+  // The true correspondences are closer than the searched depth range
+  matching::IndMatches matches;
+  geometry_aware::GuidedMatching_Fundamental_Segment(
+    &scene.cam, scene.poseL, scene.regionsL,
+    &scene.cam, scene.poseR, scene.regionsR,
+    20., 30.,
+    Square(2.), Square(0.8),
+    matches);
+
+  for (const auto & match : matches)
+  {
+    EXPECT_TRUE(match.i_ != match.j_);
+  }
+}
+
+TEST(GuidedMatching_Fundamental_Segment, EmptyRegions)
+{
+  const Stereo_Scene scene(10);
+  const SIFT_Regions empty_regions;
+
+  matching::IndMatches matches;
+  geometry_aware::GuidedMatching_Fundamental_Segment(
+    &scene.cam, scene.poseL, scene.regionsL,
+    &scene.cam, scene.poseR, empty_regions,
+    4., 12.,
+    Square(2.), Square(0.8),
+    matches);
+  EXPECT_TRUE(matches.empty());
+
+  geometry_aware::GuidedMatching_Fundamental_Segment(
+    &scene.cam, scene.poseL, empty_regions,
+    &scene.cam, scene.poseR, scene.regionsR,
+    4., 12.,
+    Square(2.), Square(0.8),
+    matches);
+  EXPECT_TRUE(matches.empty());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
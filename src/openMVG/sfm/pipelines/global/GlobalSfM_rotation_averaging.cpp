@@ -9,6 +9,7 @@
 #include "openMVG/sfm/pipelines/global/GlobalSfM_rotation_averaging.hpp"
 
 #include "openMVG/graph/graph.hpp"
+#include "openMVG/graph/triplet_finder.hpp"
 #include "openMVG/multiview/rotation_averaging.hpp"
 #include "openMVG/sfm/sfm_filters.hpp"
 #include "openMVG/sfm/pipelines/global/sfm_global_reindex.hpp"
@@ -17,6 +18,12 @@
 
 #include "third_party/histogram/histogram.hpp"
 
+#include <array>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
 namespace openMVG{
 namespace sfm{
 
@@ -46,13 +53,10 @@ bool GlobalSfM_Rotation_AveragingSolver::Run(
       //-------------------
       // Triplet inference (test over the composition error)
       //-------------------
-      Pair_Set pairs = getPairs(relativeRotations);
-      std::vector<graph::Triplet> vec_triplets = graph::TripletListing(pairs);
-
       //-- Rejection triplet that are 'not' identity rotation (error to identity > 5°)
-      TripletRotationRejection(5.0f, vec_triplets, relativeRotations);
+      TripletRotationRejection(5.0f, relativeRotations);
 
-      pairs = getPairs(relativeRotations);
+      Pair_Set pairs = getPairs(relativeRotations);
       const std::set<IndexT> set_remainingIds = graph::CleanGraph_KeepLargestBiEdge_Nodes<Pair_Set, IndexT>(pairs);
       if (set_remainingIds.empty())
         return false;
@@ -152,6 +156,74 @@ bool GlobalSfM_Rotation_AveragingSolver::Run(
   return bSuccess;
 }
 
+namespace
+{
+
+/// Compute the rotation composition error (in degree) of a triplet and
+///  retrieve the keys of its three relative rotations in map_relatives.
+float TripletRotationError
+(
+  const RelativeRotations_map & map_relatives,
+  const graph::Triplet & triplet,
+  std::array<Pair, 3> & triplet_edges
+)
+{
+  const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
+
+  //-- Find the three relative rotations
+  const Pair ij(I,J), ji(J,I);
+  const auto it_ij = map_relatives.find(ij);
+  const Mat3 RIJ = (it_ij != map_relatives.end()) ?
+    it_ij->second.Rij : Mat3(map_relatives.at(ji).Rij.transpose());
+  triplet_edges[0] = (it_ij != map_relatives.end()) ? ij : ji;
+
+  const Pair jk(J,K), kj(K,J);
+  const auto it_jk = map_relatives.find(jk);
+  const Mat3 RJK = (it_jk != map_relatives.end()) ?
+    it_jk->second.Rij : Mat3(map_relatives.at(kj).Rij.transpose());
+  triplet_edges[1] = (it_jk != map_relatives.end()) ? jk : kj;
+
+  const Pair ki(K,I), ik(I,K);
+  const auto it_ki = map_relatives.find(ki);
+  const Mat3 RKI = (it_ki != map_relatives.end()) ?
+    it_ki->second.Rij : Mat3(map_relatives.at(ik).Rij.transpose());
+  triplet_edges[2] = (it_ki != map_relatives.end()) ? ki : ik;
+
+  const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
+  return static_cast<float>(R2D(getRotationMagnitude(Rot_To_Identity)));
+}
+
+/// Display statistics about rotation triplets error
+void LogTripletRotationStatistics
+(
+  std::vector<float> & vec_errToIdentityPerTriplet,
+  const size_t triplet_count_before,
+  const size_t triplet_count_after
+)
+{
+  std::ostringstream os;
+  os << "Statistics about rotation triplets:\n";
+  minMaxMeanMedian<float>(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend(), os);
+
+  std::sort(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end());
+
+  if (!vec_errToIdentityPerTriplet.empty())
+  {
+    Histogram<float> histo(0.0f, *max_element(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend()), 20);
+    histo.Add(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend());
+    os << histo.ToString() << "\n";
+  }
+
+  {
+    os << "\nTriplets filtering based on unit cycle rotation composition error:"
+      << "\n#Triplets before: " << triplet_count_before
+      << "\n#Triplets after: " << triplet_count_after;
+    OPENMVG_LOG_INFO << os.str();
+  }
+}
+
+} // namespace
+
 /// Reject edges of the view graph that do not produce triplets with tiny
 ///  angular error once rotation composition have been computed.
 void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
@@ -177,43 +249,15 @@ void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
   for (size_t i = 0; i < vec_triplets.size(); ++i)
   {
     const graph::Triplet & triplet = vec_triplets[i];
-    const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-
-    //-- Find the three relative rotations
-    const Pair ij(I,J), ji(J,I);
-    const Mat3 RIJ = (map_relatives.count(ij)) ?
-      map_relatives.at(ij).Rij : Mat3(map_relatives.at(ji).Rij.transpose());
-
-    const Pair jk(J,K), kj(K,J);
-    const Mat3 RJK = (map_relatives.count(jk)) ?
-      map_relatives.at(jk).Rij : Mat3(map_relatives.at(kj).Rij.transpose());
-
-    const Pair ki(K,I), ik(I,K);
-    const Mat3 RKI = (map_relatives.count(ki)) ?
-      map_relatives.at(ki).Rij : Mat3(map_relatives.at(ik).Rij.transpose());
-
-    const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
-    const float angularErrorDegree = static_cast<float>(R2D(getRotationMagnitude(Rot_To_Identity)));
+    std::array<Pair, 3> triplet_edges;
+    const float angularErrorDegree = TripletRotationError(map_relatives, triplet, triplet_edges);
     vec_errToIdentityPerTriplet.push_back(angularErrorDegree);
 
     if (angularErrorDegree < max_angular_error)
     {
       vec_triplets_validated.push_back(triplet);
-
-      if (map_relatives.count(ij))
-        map_relatives_validated[ij] = map_relatives.at(ij);
-      else
-        map_relatives_validated[ji] = map_relatives.at(ji);
-
-      if (map_relatives.count(jk))
-        map_relatives_validated[jk] = map_relatives.at(jk);
-      else
-        map_relatives_validated[kj] = map_relatives.at(kj);
-
-      if (map_relatives.count(ki))
-        map_relatives_validated[ki] = map_relatives.at(ki);
-      else
-        map_relatives_validated[ik] = map_relatives.at(ik);
+      for (const Pair & edge : triplet_edges)
+        map_relatives_validated[edge] = map_relatives.at(edge);
     }
   }
   map_relatives = std::move(map_relatives_validated);
@@ -224,28 +268,80 @@ void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
   std::transform(map_relatives.cbegin(), map_relatives.cend(), std::back_inserter(relativeRotations), stl::RetrieveValue());
   std::transform(map_relatives.cbegin(), map_relatives.cend(), std::inserter(used_pairs, used_pairs.begin()), stl::RetrieveKey());
 
-  // Display statistics about rotation triplets error:
-  std::ostringstream os;
-  os << "Statistics about rotation triplets:\n";
-  minMaxMeanMedian<float>(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend(), os);
+  LogTripletRotationStatistics(vec_errToIdentityPerTriplet, vec_triplets.size(), vec_triplets_validated.size());
 
-  std::sort(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end());
+  vec_triplets = std::move(vec_triplets_validated);
 
-  if (!vec_errToIdentityPerTriplet.empty())
+  const size_t edges_end_count = relativeRotations.size();
+  OPENMVG_LOG_INFO << "\n #Edges removed by triplet inference: " << edges_start_count - edges_end_count;
+}
+
+void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
+  const double max_angular_error,
+  RelativeRotations & relativeRotations) const
+{
+  const size_t edges_start_count = relativeRotations.size();
+
+  const RelativeRotations_map map_relatives = getMap(relativeRotations);
+
+  //--
+  // ROTATION OUTLIERS DETECTION
+  //--
+
+  // Per thread results (the triplets are visited concurrently)
+#ifdef OPENMVG_USE_OPENMP
+  const int nb_thread = omp_get_max_threads();
+#else
+  const int nb_thread = 1;
+#endif
+  std::vector<std::vector<float>> vec_errToIdentityPerTriplet_thread(nb_thread);
+  std::vector<std::vector<Pair>> vec_validated_edges_thread(nb_thread);
+
+  // Compute the composition error for each length 3 cycles
+  graph::VisitTriplets(getPairs(relativeRotations),
+    [&](const graph::Triplet & triplet)
+    {
+#ifdef OPENMVG_USE_OPENMP
+      const int thread_id = omp_get_thread_num();
+#else
+      const int thread_id = 0;
+#endif
+      std::array<Pair, 3> triplet_edges;
+      const float angularErrorDegree = TripletRotationError(map_relatives, triplet, triplet_edges);
+      vec_errToIdentityPerTriplet_thread[thread_id].push_back(angularErrorDegree);
+
+      if (angularErrorDegree < max_angular_error)
+      {
+        auto & validated_edges = vec_validated_edges_thread[thread_id];
+        validated_edges.insert(validated_edges.end(), triplet_edges.cbegin(), triplet_edges.cend());
+      }
+    });
+
+  // Gather the per thread results
+  std::vector<float> vec_errToIdentityPerTriplet;
+  size_t triplet_count_after = 0;
+  Pair_Set validated_edges;
+  for (int thread_id = 0; thread_id < nb_thread; ++thread_id)
   {
-    Histogram<float> histo(0.0f, *max_element(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend()), 20);
-    histo.Add(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend());
-    os << histo.ToString() << "\n";
+    const auto & thread_errors = vec_errToIdentityPerTriplet_thread[thread_id];
+    vec_errToIdentityPerTriplet.insert(vec_errToIdentityPerTriplet.end(),
+      thread_errors.cbegin(), thread_errors.cend());
+    const auto & thread_edges = vec_validated_edges_thread[thread_id];
+    triplet_count_after += thread_edges.size() / 3;
+    validated_edges.insert(thread_edges.cbegin(), thread_edges.cend());
   }
+  const size_t triplet_count_before = vec_errToIdentityPerTriplet.size();
 
+  // update to keep only useful triplets
+  relativeRotations.clear();
+  relativeRotations.reserve(validated_edges.size());
+  for (const Pair & edge : validated_edges)
   {
-    os << "\nTriplets filtering based on unit cycle rotation composition error:"
-      << "\n#Triplets before: " << vec_triplets.size()
-      << "\n#Triplets after: " << vec_triplets_validated.size();
-    OPENMVG_LOG_INFO << os.str();
+    relativeRotations.push_back(map_relatives.at(edge));
+    used_pairs.insert(edge);
   }
 
-  vec_triplets = std::move(vec_triplets_validated);
+  LogTripletRotationStatistics(vec_errToIdentityPerTriplet, triplet_count_before, triplet_count_after);
 
   const size_t edges_end_count = relativeRotations.size();
   OPENMVG_LOG_INFO << "\n #Edges removed by triplet inference: " << edges_start_count - edges_end_count;
@@ -56,6 +56,14 @@ public:
     std::vector<graph::Triplet> & vec_triplets,
     rotation_averaging::RelativeRotations & relativeRotations) const;
 
+  /// Reject edges of the view graph that do not produce triplets with tiny
+  ///  angular error once rotation composition have been computed.
+  /// The triplets are enumerated (in parallel) from the relative rotations
+  ///  graph and tested on the fly, they are never stored.
+  void TripletRotationRejection(
+    const double max_angular_error,
+    rotation_averaging::RelativeRotations & relativeRotations) const;
+
   /// Return the pairs validated by the GlobalRotation routine (inference can remove some)
   Pair_Set GetUsedPairs() const;
 };
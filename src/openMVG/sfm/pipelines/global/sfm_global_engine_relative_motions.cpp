@@ -26,6 +26,7 @@
 #include "openMVG/system/timer.hpp"
 #include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
+#include "openMVG/system/profiler.hpp"
 #include "openMVG/tracks/tracks.hpp"
 #include "openMVG/types.hpp"
 
@@ -36,6 +37,7 @@
 #include <ceres/types.h>
 
 #include <iostream>
+#include <memory>
 
 #ifdef _MSC_VER
 #pragma warning( once : 4267 ) //warning C4267: 'argument' : conversion from 'size_t' to 'const int', possible loss of data
@@ -110,6 +112,7 @@ void GlobalSfMReconstructionEngine_RelativeMotions::SetTranslationAveragingMetho
 }
 
 bool GlobalSfMReconstructionEngine_RelativeMotions::Process() {
+  OPENMVG_PROFILE_ZONE("GlobalSfM");
 
   //-------------------
   // Keep only the largest biedge connected subgraph
@@ -181,6 +184,7 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Global_Rotations
   Hash_Map<IndexT, Mat3> & global_rotations
 )
 {
+  OPENMVG_PROFILE_ZONE("RotationAveraging");
   if (relatives_R.empty())
     return false;
   // Log statistics about the relative rotation graph
@@ -294,6 +298,7 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Global_Translations
   matching::PairWiseMatches & tripletWise_matches
 )
 {
+  OPENMVG_PROFILE_ZONE("TranslationAveraging");
   // Translation averaging (compute translations & update them to a global common coordinates system)
   GlobalSfM_Translation_AveragingSolver translation_averaging_solver;
   const bool bTranslationAveraging = translation_averaging_solver.Run(
@@ -320,6 +325,7 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Initial_Structure
   matching::PairWiseMatches & tripletWise_matches
 )
 {
+  OPENMVG_PROFILE_ZONE("TrackBuilding");
   // Build tracks from selected triplets (Union of all the validated triplet tracks (_tripletWise_matches))
   {
     using namespace openMVG::tracks;
@@ -417,9 +423,22 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Initial_Structure
 // Adjust the scene (& remove outliers)
 bool GlobalSfMReconstructionEngine_RelativeMotions::Adjust()
 {
+  OPENMVG_PROFILE_ZONE("BundleAdjustment");
   // Refine sfm_scene (in a 3 iteration process (free the parameters regarding their uncertainty order)):
 
-  Bundle_Adjustment_Ceres bundle_adjustment_obj;
+  std::unique_ptr<Bundle_Adjustment> bundle_adjustment_ptr;
+  if (ba_partition_cluster_size_ > 0
+      && sfm_data_.GetPoses().size() > ba_partition_cluster_size_)
+  {
+    bundle_adjustment_ptr.reset(new Bundle_Adjustment_Ceres_Partitioned(
+      Bundle_Adjustment_Ceres::BA_Ceres_options(),
+      Bundle_Adjustment_Ceres_Partitioned::Partition_options(ba_partition_cluster_size_)));
+  }
+  else
+  {
+    bundle_adjustment_ptr.reset(new Bundle_Adjustment_Ceres);
+  }
+  Bundle_Adjustment & bundle_adjustment_obj = *bundle_adjustment_ptr;
   // - refine only Structure and translations
   bool b_BA_Status = bundle_adjustment_obj.Adjust
     (
@@ -536,6 +555,7 @@ void GlobalSfMReconstructionEngine_RelativeMotions::Compute_Relative_Rotations
   rotation_averaging::RelativeRotations & vec_relatives_R
 )
 {
+  OPENMVG_PROFILE_ZONE("RelativeRotations");
   // Compute a relative pose for each edge of the pose pair graph
   const Relative_Pose_Engine::Relative_Pair_Poses relative_poses = [&]
   {
@@ -0,0 +1,287 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/localization/SfM_Localization_Service.hpp"
+
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/features/regions.hpp"
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Single_3DTrackObservation_Database.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace openMVG {
+namespace sfm {
+
+namespace {
+
+  double ElapsedSeconds(const std::chrono::steady_clock::time_point & start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+} // namespace
+
+//-- Work_Queue
+
+template <typename T>
+bool SfM_Localization_Service::Work_Queue<T>::push(T && item)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_)
+      return false;
+    items_.push_back(std::move(item));
+  }
+  condition_.notify_one();
+  return true;
+}
+
+template <typename T>
+bool SfM_Localization_Service::Work_Queue<T>::pop(T & item)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this]{ return !items_.empty() || closed_; });
+  if (items_.empty())
+    return false;
+  item = std::move(items_.front());
+  items_.pop_front();
+  return true;
+}
+
+template <typename T>
+bool SfM_Localization_Service::Work_Queue<T>::pop_until
+(
+  T & item,
+  const std::chrono::steady_clock::time_point & deadline
+)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait_until(lock, deadline, [this]{ return !items_.empty() || closed_; });
+  if (items_.empty())
+    return false;
+  item = std::move(items_.front());
+  items_.pop_front();
+  return true;
+}
+
+template <typename T>
+void SfM_Localization_Service::Work_Queue<T>::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  condition_.notify_all();
+}
+
+template <typename T>
+void SfM_Localization_Service::Work_Queue<T>::open()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = false;
+}
+
+//-- SfM_Localization_Service
+
+SfM_Localization_Service::SfM_Localization_Service
+(
+  const SfM_Localization_Single_3DTrackObservation_Database & localizer,
+  const Describe_Functor & describe,
+  const Result_Callback & on_result,
+  const Options & options
+):
+  localizer_(localizer),
+  describe_(describe),
+  on_result_(on_result),
+  options_(options)
+{
+  options_.nb_describe_threads = std::max(1u, options_.nb_describe_threads);
+  options_.nb_resection_threads = std::max(1u, options_.nb_resection_threads);
+  options_.max_batch_size = std::max(1u, options_.max_batch_size);
+  // Nothing is accepted before Start
+  describe_queue_.close();
+}
+
+SfM_Localization_Service::~SfM_Localization_Service()
+{
+  Stop();
+}
+
+void SfM_Localization_Service::Start()
+{
+  if (running_)
+    return;
+  running_ = true;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    start_time_ = std::chrono::steady_clock::now();
+    latencies_.clear();
+    last_answer_time_ = 0.0;
+    nb_localized_ = nb_batches_ = 0;
+  }
+  describe_queue_.open();
+  match_queue_.open();
+  resection_queue_.open();
+  for (unsigned int i = 0; i < options_.nb_describe_threads; ++i)
+    describe_threads_.emplace_back(&SfM_Localization_Service::DescribeWorker, this);
+  match_thread_ = std::thread(&SfM_Localization_Service::MatchWorker, this);
+  for (unsigned int i = 0; i < options_.nb_resection_threads; ++i)
+    resection_threads_.emplace_back(&SfM_Localization_Service::ResectionWorker, this);
+}
+
+bool SfM_Localization_Service::Submit(const Localization_Query & query)
+{
+  Pending_Query_Ptr pending(new Pending_Query);
+  pending->query = query;
+  pending->submission_time = std::chrono::steady_clock::now();
+  return describe_queue_.push(std::move(pending));
+}
+
+void SfM_Localization_Service::Stop()
+{
+  if (!running_)
+    return;
+  // Each stage is drained before the next one is closed
+  describe_queue_.close();
+  for (auto & thread : describe_threads_)
+    thread.join();
+  describe_threads_.clear();
+  match_queue_.close();
+  match_thread_.join();
+  resection_queue_.close();
+  for (auto & thread : resection_threads_)
+    thread.join();
+  resection_threads_.clear();
+  running_ = false;
+}
+
+void SfM_Localization_Service::DescribeWorker()
+{
+  Pending_Query_Ptr pending;
+  while (describe_queue_.pop(pending))
+  {
+    if (!describe_(pending->query, pending->regions, pending->image_size)
+        || !pending->regions)
+    {
+      OPENMVG_LOG_ERROR << "Cannot describe the query: " << pending->query.id;
+      Localization_Result result;
+      Answer(*pending, result);
+      continue;
+    }
+    match_queue_.push(std::move(pending));
+  }
+}
+
+void SfM_Localization_Service::MatchWorker()
+{
+  Pending_Query_Ptr pending;
+  while (match_queue_.pop(pending))
+  {
+    // Gather the queries arriving within the batch delay
+    std::vector<Pending_Query_Ptr> batch;
+    batch.push_back(std::move(pending));
+    const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::microseconds(static_cast<long long>(options_.max_batch_delay_ms * 1000.0));
+    while (batch.size() < options_.max_batch_size
+           && match_queue_.pop_until(pending, deadline))
+    {
+      batch.push_back(std::move(pending));
+    }
+
+    std::vector<const features::Regions *> batch_regions;
+    for (const auto & query : batch)
+      batch_regions.push_back(query->regions.get());
+    std::vector<matching::IndMatches> batch_matches;
+    localizer_.MatchBatch(batch_regions, batch_matches);
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      ++nb_batches_;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      batch[i]->matches = std::move(batch_matches[i]);
+      resection_queue_.push(std::move(batch[i]));
+    }
+  }
+}
+
+void SfM_Localization_Service::ResectionWorker()
+{
+  Pending_Query_Ptr pending;
+  while (resection_queue_.pop(pending))
+  {
+    const Localization_Query & query = pending->query;
+    Image_Localizer_Match_Data matching_data;
+    matching_data.error_max = query.max_residual_error;
+
+    Localization_Result result;
+    result.localized = localizer_.Localize(
+      query.intrinsics ? query.solver_type : resection::SolverType::DLT_6POINTS,
+      pending->image_size,
+      query.intrinsics.get(),
+      *pending->regions,
+      pending->matches,
+      result.pose,
+      &matching_data);
+    result.nb_inliers = result.localized ? matching_data.vec_inliers.size() : 0;
+    Answer(*pending, result);
+  }
+}
+
+void SfM_Localization_Service::Answer
+(
+  const Pending_Query & pending,
+  Localization_Result & result
+)
+{
+  result.id = pending.query.id;
+  result.image_size = pending.image_size;
+  result.nb_putatives = pending.matches.size();
+  result.latency = ElapsedSeconds(pending.submission_time);
+
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  latencies_.push_back(result.latency);
+  last_answer_time_ = ElapsedSeconds(start_time_);
+  if (result.localized)
+    ++nb_localized_;
+  if (on_result_)
+    on_result_(result);
+}
+
+Localization_Service_Stats SfM_Localization_Service::Stats() const
+{
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  Localization_Service_Stats stats;
+  stats.nb_queries = latencies_.size();
+  stats.nb_localized = nb_localized_;
+  stats.nb_batches = nb_batches_;
+  stats.elapsed = last_answer_time_;
+  if (latencies_.empty())
+    return stats;
+
+  if (stats.elapsed > 0.0)
+    stats.throughput = stats.nb_queries / stats.elapsed;
+
+  // Nearest rank percentiles
+  std::vector<double> latencies = latencies_;
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](const double p)
+  {
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * latencies.size()));
+    return latencies[std::max<size_t>(rank, 1) - 1];
+  };
+  stats.latency_p50 = percentile(50);
+  stats.latency_p90 = percentile(90);
+  stats.latency_p99 = percentile(99);
+  stats.latency_max = latencies.back();
+  return stats;
+}
+
+} // namespace sfm
+} // namespace openMVG
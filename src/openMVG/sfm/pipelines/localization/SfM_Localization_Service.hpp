@@ -0,0 +1,192 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZATION_SERVICE_HPP
+#define OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZATION_SERVICE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "openMVG/geometry/pose3.hpp"
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/multiview/solver_resection.hpp"
+#include "openMVG/types.hpp"
+
+namespace openMVG { namespace cameras { struct IntrinsicBase; } }
+namespace openMVG { namespace features { class Regions; } }
+
+namespace openMVG {
+namespace sfm {
+
+class SfM_Localization_Single_3DTrackObservation_Database;
+
+/// A localization request
+struct Localization_Query
+{
+  std::string id;
+  /// Image to localize (read by the service describe function)
+  std::string image_path;
+  /// Camera intrinsic if known (else nullptr: the DLT is used)
+  std::shared_ptr<cameras::IntrinsicBase> intrinsics;
+  resection::SolverType solver_type = resection::SolverType::DEFAULT;
+  /// Upper bound pixel(s) tolerance for the resection residual errors
+  double max_residual_error = std::numeric_limits<double>::infinity();
+};
+
+/// The answer to a localization request
+struct Localization_Result
+{
+  std::string id;
+  bool localized = false;
+  geometry::Pose3 pose;
+  Pair image_size = {0, 0};
+  size_t nb_putatives = 0;
+  size_t nb_inliers = 0;
+  /// Time between the query submission and its result (seconds)
+  double latency = 0.0;
+};
+
+/// Throughput and latency of the queries answered by the service
+struct Localization_Service_Stats
+{
+  size_t nb_queries = 0;
+  size_t nb_localized = 0;
+  size_t nb_batches = 0;
+  double elapsed = 0.0;       // seconds since the service start
+  double throughput = 0.0;    // answered queries per second
+  double latency_p50 = 0.0;   // latency percentiles (seconds)
+  double latency_p90 = 0.0;
+  double latency_p99 = 0.0;
+  double latency_max = 0.0;
+};
+
+/**
+* @brief Long running localization service.
+* The database stays resident and the queries go through a pipeline of threads:
+* - describe: image decoding and regions computation (several workers),
+* - match: the regions of the pending queries are matched to the database
+*   in batches (one database search for several queries),
+* - resection: robust pose estimation (several workers).
+* The result of each query is given to a callback as soon as it is known.
+*/
+class SfM_Localization_Service
+{
+public:
+
+  /// Compute the regions and the size of a query image
+  using Describe_Functor = std::function<bool(
+    const Localization_Query & query,
+    std::unique_ptr<features::Regions> & regions,
+    Pair & image_size)>;
+
+  /// Called (from a resection thread, one call at a time) for each query
+  using Result_Callback = std::function<void(const Localization_Result &)>;
+
+  struct Options
+  {
+    unsigned int nb_describe_threads = 1;
+    unsigned int nb_resection_threads = 1;
+    /// Maximum number of queries matched with a single database search
+    unsigned int max_batch_size = 8;
+    /// Time the matcher waits for other queries to fill a batch
+    double max_batch_delay_ms = 2.0;
+  };
+
+  SfM_Localization_Service
+  (
+    const SfM_Localization_Single_3DTrackObservation_Database & localizer,
+    const Describe_Functor & describe,
+    const Result_Callback & on_result,
+    const Options & options
+  );
+
+  /// Answer the pending queries and stop the threads
+  ~SfM_Localization_Service();
+
+  SfM_Localization_Service(const SfM_Localization_Service &) = delete;
+  SfM_Localization_Service & operator=(const SfM_Localization_Service &) = delete;
+
+  /// Launch the pipeline threads
+  void Start();
+
+  /**
+  * @brief Add a query to the pipeline (returns immediately)
+  * @return False if the service is not running
+  */
+  bool Submit(const Localization_Query & query);
+
+  /// Wait for the pending queries to be answered and stop the threads
+  void Stop();
+
+  Localization_Service_Stats Stats() const;
+
+private:
+
+  struct Pending_Query
+  {
+    Localization_Query query;
+    std::chrono::steady_clock::time_point submission_time;
+    std::unique_ptr<features::Regions> regions;
+    Pair image_size = {0, 0};
+    matching::IndMatches matches;
+  };
+
+  /// Thread safe FIFO, closed when the producers have finished
+  template <typename T>
+  class Work_Queue
+  {
+  public:
+    bool push(T && item);
+    /// Wait for an item (false if the queue is closed and empty)
+    bool pop(T & item);
+    /// Wait for an item until a deadline (false on timeout or closed queue)
+    bool pop_until(T & item, const std::chrono::steady_clock::time_point & deadline);
+    void close();
+    void open();
+  private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<T> items_;
+    bool closed_ = false;
+  };
+
+  void DescribeWorker();
+  void MatchWorker();
+  void ResectionWorker();
+  void Answer(const Pending_Query & pending, Localization_Result & result);
+
+  const SfM_Localization_Single_3DTrackObservation_Database & localizer_;
+  Describe_Functor describe_;
+  Result_Callback on_result_;
+  Options options_;
+
+  using Pending_Query_Ptr = std::unique_ptr<Pending_Query>;
+  Work_Queue<Pending_Query_Ptr> describe_queue_, match_queue_, resection_queue_;
+  std::vector<std::thread> describe_threads_, resection_threads_;
+  std::thread match_thread_;
+  bool running_ = false;
+
+  // Statistics (guarded by stats_mutex_, that also serializes on_result_)
+  mutable std::mutex stats_mutex_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::vector<double> latencies_;
+  double last_answer_time_ = 0.0;
+  size_t nb_localized_ = 0;
+  size_t nb_batches_ = 0;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZATION_SERVICE_HPP
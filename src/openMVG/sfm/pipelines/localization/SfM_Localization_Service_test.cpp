@@ -0,0 +1,138 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/localization/SfM_Localization_Service.hpp"
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Single_3DTrackObservation_Database.hpp"
+#include "openMVG/sfm/pipelines/localization/localization_test.hpp"
+
+#include "testing/testing.h"
+
+#include <map>
+#include <set>
+
+TEST(Localization_Service, MatchBatch)
+{
+  Localization_Scene scene;
+  SfM_Localization_Single_3DTrackObservation_Database localizer;
+  EXPECT_TRUE(localizer.Init(scene.sfm_data, scene.regions_provider));
+
+  const std::vector<SIFT_Regions> queries =
+    {scene.Query(Vec3(0, 0, 0)), SIFT_Regions(), scene.Query(Vec3(1, 0, 0))};
+  std::vector<const Regions *> queries_regions;
+  for (const auto & query : queries)
+    queries_regions.push_back(&query);
+
+  std::vector<matching::IndMatches> queries_matches;
+  EXPECT_TRUE(localizer.MatchBatch(queries_regions, queries_matches));
+  CHECK_EQUAL(queries.size(), queries_matches.size());
+  EXPECT_TRUE(queries_matches[1].empty());
+
+  // The batch gives the same correspondences as the queries taken one by one
+  for (const size_t i : {0, 2})
+  {
+    EXPECT_EQ(static_cast<size_t>(Localization_Scene::nb_landmarks), queries_matches[i].size());
+    Image_Localizer_Match_Data single_data, batch_data;
+    geometry::Pose3 single_pose, batch_pose;
+    EXPECT_TRUE(localizer.Localize(resection::SolverType::DLT_6POINTS, {1000, 1000},
+      nullptr, queries[i], single_pose, &single_data));
+    EXPECT_TRUE(localizer.Localize(resection::SolverType::DLT_6POINTS, {1000, 1000},
+      nullptr, queries[i], queries_matches[i], batch_pose, &batch_data));
+    EXPECT_MATRIX_NEAR(single_data.pt2D, batch_data.pt2D, 1e-8);
+    EXPECT_MATRIX_NEAR(single_data.pt3D, batch_data.pt3D, 1e-8);
+    EXPECT_MATRIX_NEAR(single_pose.center(), batch_pose.center(), 1e-8);
+  }
+}
+
+// The test client: submit concurrent queries and collect the answers
+TEST(Localization_Service, Queries)
+{
+  Localization_Scene scene;
+  SfM_Localization_Single_3DTrackObservation_Database localizer;
+  EXPECT_TRUE(localizer.Init(scene.sfm_data, scene.regions_provider));
+
+  const int nb_queries = 24;
+  std::map<std::string, SIFT_Regions> query_regions;
+  std::map<std::string, Vec3> query_centers;
+  for (int i = 0; i < nb_queries; ++i)
+  {
+    const std::string id = std::to_string(i);
+    query_centers[id] = Vec3(0.1 * i, -0.05 * i, 0.0);
+    query_regions[id] = scene.Query(query_centers[id]);
+  }
+
+  const auto describe = [&query_regions]
+    (const Localization_Query & query, std::unique_ptr<Regions> & regions, Pair & image_size)
+  {
+    const auto it = query_regions.find(query.image_path);
+    if (it == query_regions.end())
+      return false;
+    regions.reset(it->second.EmptyClone());
+    for (size_t i = 0; i < it->second.RegionCount(); ++i)
+      it->second.CopyRegion(i, regions.get());
+    image_size = {1000, 1000};
+    return true;
+  };
+
+  std::vector<Localization_Result> results;
+  const auto on_result = [&results](const Localization_Result & result)
+  {
+    results.push_back(result);
+  };
+
+  SfM_Localization_Service::Options options;
+  options.nb_describe_threads = 2;
+  options.nb_resection_threads = 2;
+  options.max_batch_size = 4;
+  SfM_Localization_Service service(localizer, describe, on_result, options);
+
+  EXPECT_FALSE(service.Submit(Localization_Query()));
+  service.Start();
+  for (int i = 0; i < nb_queries; ++i)
+  {
+    Localization_Query query;
+    query.id = query.image_path = std::to_string(i);
+    EXPECT_TRUE(service.Submit(query));
+  }
+  Localization_Query missing_query;
+  missing_query.id = missing_query.image_path = "missing";
+  EXPECT_TRUE(service.Submit(missing_query));
+  service.Stop();
+
+  // Every query is answered once
+  CHECK_EQUAL(nb_queries + 1, results.size());
+  std::set<std::string> answered;
+  for (const auto & result : results)
+  {
+    answered.insert(result.id);
+    if (result.id == "missing")
+    {
+      EXPECT_FALSE(result.localized);
+      EXPECT_EQ(0, result.nb_putatives);
+      continue;
+    }
+    EXPECT_TRUE(result.localized);
+    EXPECT_EQ(static_cast<size_t>(Localization_Scene::nb_landmarks), result.nb_putatives);
+    EXPECT_MATRIX_NEAR(query_centers[result.id], result.pose.center(), 1e-2);
+  }
+  EXPECT_EQ(nb_queries + 1, answered.size());
+
+  const Localization_Service_Stats stats = service.Stats();
+  EXPECT_EQ(nb_queries + 1, stats.nb_queries);
+  EXPECT_EQ(nb_queries, stats.nb_localized);
+  EXPECT_TRUE(stats.nb_batches >= nb_queries / options.max_batch_size);
+  EXPECT_TRUE(stats.nb_batches <= nb_queries);
+  EXPECT_TRUE(stats.throughput > 0.0);
+  EXPECT_TRUE(stats.latency_p50 <= stats.latency_p90);
+  EXPECT_TRUE(stats.latency_p90 <= stats.latency_p99);
+  EXPECT_TRUE(stats.latency_p99 <= stats.latency_max);
+
+  // Submissions are refused once the service is stopped
+  EXPECT_FALSE(service.Submit(missing_query));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -0,0 +1,709 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Covisibility_Search.hpp"
+
+#include "openMVG/clustering/kmeans.hpp"
+#include "openMVG/features/regions.hpp"
+#include "openMVG/matching/metric.hpp"
+#include "openMVG/numeric/numeric.h"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <typeinfo>
+
+using namespace openMVG::matching;
+
+namespace openMVG {
+namespace sfm {
+
+namespace {
+
+  // Binary layout of a search file (native endianness):
+  // - Search_Header,
+  // - the vocabulary centroids (float, row major),
+  // - the idf weight of each word (float),
+  // - the number of views of each word in the inverted file (uint32),
+  // - the (view id (uint32), tf-idf weight (float)) entries of the inverted file.
+  struct Search_Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t vocabulary_size;
+    uint64_t descriptor_length;
+    uint64_t descriptor_count;
+    uint64_t word_count;
+    uint64_t entry_count;
+  };
+
+  const char search_magic[8] = "OMVGCVS";
+  const uint32_t search_version = 1;
+
+  // Number of descriptors converted to float at once for the quantization
+  const size_t quantization_chunk_size = 4096;
+
+  template <typename T>
+  bool WriteArray(std::FILE * stream, const T * data, const size_t count)
+  {
+    return count == 0 || std::fwrite(data, sizeof(T), count, stream) == count;
+  }
+
+  template <typename T>
+  bool ReadArray(std::FILE * stream, T * data, const size_t count)
+  {
+    return count == 0 || std::fread(data, sizeof(T), count, stream) == count;
+  }
+
+  // Below this number of new database descriptors, the queries are
+  // compared to them exhaustively instead of building a kd-tree
+  const size_t brute_force_max_descriptors = 256;
+
+  // Two nearest database descriptors of a query among the searched ones
+  // (squared L2 distances)
+  struct Query_Neighbors
+  {
+    float distances[2] = {std::numeric_limits<float>::infinity(),
+                          std::numeric_limits<float>::infinity()};
+    uint32_t nearest = 0;
+
+    void Update(const float distance, const uint32_t index)
+    {
+      if (distance < distances[0])
+      {
+        distances[1] = distances[0];
+        distances[0] = distance;
+        nearest = index;
+      }
+      else if (distance < distances[1])
+      {
+        distances[1] = distance;
+      }
+    }
+  };
+
+  // Search the queries neighbors among some new database descriptors.
+  // The neighborhood grows by expansion: each database descriptor is indexed
+  // once per query, instead of indexing the whole neighborhood again.
+  template <typename Scalar>
+  void SearchSubset
+  (
+    const Scalar * database,
+    const size_t descriptor_length,
+    const std::vector<uint32_t> & subset,
+    const Scalar * queries,
+    const size_t nb_queries,
+    std::vector<Query_Neighbors> & neighbors
+  )
+  {
+    if (subset.empty() || nb_queries == 0)
+      return;
+
+    if (subset.size() <= brute_force_max_descriptors)
+    {
+      L2<Scalar> metric;
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(static)
+#endif
+      for (int q = 0; q < static_cast<int>(nb_queries); ++q)
+      {
+        const Scalar * query = queries + q * descriptor_length;
+        for (const uint32_t index : subset)
+        {
+          neighbors[q].Update(
+            static_cast<float>(metric(query, database + index * descriptor_length, descriptor_length)),
+            index);
+        }
+      }
+      return;
+    }
+
+    std::vector<Scalar> subset_descriptors(subset.size() * descriptor_length);
+    for (size_t i = 0; i < subset.size(); ++i)
+    {
+      std::copy(database + subset[i] * descriptor_length,
+                database + (subset[i] + 1) * descriptor_length,
+                subset_descriptors.begin() + i * descriptor_length);
+    }
+
+    using Matcher = ArrayMatcher_Kdtree_Flann<Scalar>;
+    Matcher matcher;
+    if (!matcher.Build(subset_descriptors.data(), subset.size(), descriptor_length))
+      return;
+    IndMatches nn_matches;
+    std::vector<typename Matcher::DistanceType> nn_distances;
+    const int NN = 2;
+    if (!matcher.SearchNeighbours(queries, nb_queries, &nn_matches, &nn_distances, NN))
+      return;
+    for (size_t i = 0; i < nn_matches.size(); ++i)
+    {
+      const IndMatch & match = nn_matches[i];
+      neighbors[match.i_].Update(static_cast<float>(nn_distances[i]), subset[match.j_]);
+    }
+  }
+
+  // Keep the nearest neighbors that pass the distance ratio test
+  // (i_: database descriptor, j_: query region)
+  void RatioTestMatches
+  (
+    const std::vector<Query_Neighbors> & neighbors,
+    const float distance_ratio,
+    IndMatches & matches
+  )
+  {
+    matches.clear();
+    // The metric is squared
+    const float squared_ratio = Square(distance_ratio);
+    for (size_t q = 0; q < neighbors.size(); ++q)
+    {
+      const Query_Neighbors & neighbor = neighbors[q];
+      if (std::isfinite(neighbor.distances[1])
+          && neighbor.distances[0] < squared_ratio * neighbor.distances[1])
+        matches.emplace_back(neighbor.nearest, q);
+    }
+  }
+
+} // namespace
+
+Covisibility_Landmark_Search::Covisibility_Landmark_Search
+(
+  const Options & options
+):
+  options_(options),
+  descriptors_(nullptr),
+  b_float_descriptors_(false),
+  descriptor_length_(0),
+  descriptor_count_(0)
+{
+  options_.vocabulary_size = std::max(1u, options_.vocabulary_size);
+  options_.nb_candidate_views = std::max(1u, options_.nb_candidate_views);
+}
+
+bool Covisibility_Landmark_Search::Init
+(
+  const SfM_Data & sfm_data,
+  const void * descriptors,
+  const std::string & descriptor_type_id,
+  const size_t descriptor_length,
+  const std::vector<IndexT> & index_to_landmark_id
+)
+{
+  if (!SetDescriptors(descriptors, descriptor_type_id, descriptor_length,
+        index_to_landmark_id.size()))
+    return false;
+  BuildViewNeighborhoods(sfm_data, index_to_landmark_id);
+  if (!BuildVocabulary(index_to_landmark_id.size()))
+    return false;
+  BuildInvertedFile(index_to_landmark_id.size());
+
+  OPENMVG_LOG_INFO << "Covisibility landmark search:\n"
+    << "#words: " << vocabulary_.size() / descriptor_length_ << "\n"
+    << "#views: " << view_descriptors_.size();
+  return true;
+}
+
+bool Covisibility_Landmark_Search::Load
+(
+  const SfM_Data & sfm_data,
+  const void * descriptors,
+  const std::string & descriptor_type_id,
+  const size_t descriptor_length,
+  const std::vector<IndexT> & index_to_landmark_id,
+  const std::string & filename
+)
+{
+  if (!SetDescriptors(descriptors, descriptor_type_id, descriptor_length,
+        index_to_landmark_id.size()))
+    return false;
+
+  std::FILE * stream = std::fopen(filename.c_str(), "rb");
+  if (!stream)
+    return false;
+
+  // Check that the file has been built for this database and these options
+  Search_Header header;
+  bool bOk = ReadArray(stream, &header, 1)
+    && std::memcmp(header.magic, search_magic, sizeof(header.magic)) == 0
+    && header.version == search_version
+    && header.vocabulary_size == options_.vocabulary_size
+    && header.descriptor_length == descriptor_length_
+    && header.descriptor_count == index_to_landmark_id.size()
+    && header.word_count > 0
+    && header.word_count <= header.vocabulary_size
+    && header.entry_count <= header.word_count * sfm_data.GetViews().size();
+
+  std::vector<uint32_t> word_entry_counts;
+  if (bOk)
+  {
+    vocabulary_.resize(header.word_count * descriptor_length_);
+    word_idf_.resize(header.word_count);
+    word_entry_counts.resize(header.word_count);
+    bOk = ReadArray(stream, vocabulary_.data(), vocabulary_.size())
+      && ReadArray(stream, word_idf_.data(), word_idf_.size())
+      && ReadArray(stream, word_entry_counts.data(), word_entry_counts.size());
+  }
+  if (bOk)
+  {
+    inverted_file_.assign(header.word_count, {});
+    uint64_t entry_count = 0;
+    for (size_t word = 0; bOk && word < header.word_count; ++word)
+    {
+      entry_count += word_entry_counts[word];
+      bOk = entry_count <= header.entry_count;
+      for (uint32_t i = 0; bOk && i < word_entry_counts[word]; ++i)
+      {
+        uint32_t view_id;
+        float weight;
+        bOk = ReadArray(stream, &view_id, 1) && ReadArray(stream, &weight, 1)
+          && sfm_data.GetViews().count(view_id) > 0;
+        if (bOk)
+          inverted_file_[word].emplace_back(view_id, weight);
+      }
+    }
+    bOk = bOk && entry_count == header.entry_count;
+  }
+  std::fclose(stream);
+
+  if (bOk)
+  {
+    vocabulary_matcher_.reset(new ArrayMatcher_Kdtree_Flann<float>);
+    bOk = vocabulary_matcher_->Build(vocabulary_.data(),
+      static_cast<int>(header.word_count), static_cast<int>(descriptor_length_));
+  }
+  if (!bOk)
+  {
+    vocabulary_.clear();
+    vocabulary_matcher_.reset();
+    word_idf_.clear();
+    inverted_file_.clear();
+    descriptors_ = nullptr;
+    return false;
+  }
+  BuildViewNeighborhoods(sfm_data, index_to_landmark_id);
+
+  OPENMVG_LOG_INFO << "Covisibility landmark search loaded:\n"
+    << "#words: " << header.word_count << "\n"
+    << "#views: " << view_descriptors_.size();
+  return true;
+}
+
+bool Covisibility_Landmark_Search::Save
+(
+  const std::string & filename
+) const
+{
+  if (!descriptors_ || vocabulary_.empty())
+    return false;
+
+  std::FILE * stream = std::fopen(filename.c_str(), "wb");
+  if (!stream)
+  {
+    OPENMVG_LOG_ERROR << "Cannot open the covisibility search file: " << filename;
+    return false;
+  }
+
+  Search_Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, search_magic, sizeof(header.magic));
+  header.version = search_version;
+  header.vocabulary_size = options_.vocabulary_size;
+  header.descriptor_length = descriptor_length_;
+  header.descriptor_count = descriptor_count_;
+  header.word_count = inverted_file_.size();
+  std::vector<uint32_t> word_entry_counts(inverted_file_.size());
+  for (size_t word = 0; word < inverted_file_.size(); ++word)
+  {
+    word_entry_counts[word] = static_cast<uint32_t>(inverted_file_[word].size());
+    header.entry_count += inverted_file_[word].size();
+  }
+
+  bool bOk = WriteArray(stream, &header, 1)
+    && WriteArray(stream, vocabulary_.data(), vocabulary_.size())
+    && WriteArray(stream, word_idf_.data(), word_idf_.size())
+    && WriteArray(stream, word_entry_counts.data(), word_entry_counts.size());
+  for (const auto & word_entries : inverted_file_)
+  {
+    for (const auto & view_weight : word_entries)
+    {
+      const uint32_t view_id = static_cast<uint32_t>(view_weight.first);
+      bOk = bOk && WriteArray(stream, &view_id, 1)
+        && WriteArray(stream, &view_weight.second, 1);
+    }
+  }
+  bOk = (std::fclose(stream) == 0) && bOk;
+  if (!bOk)
+    OPENMVG_LOG_ERROR << "Cannot write the covisibility search file: " << filename;
+  return bOk;
+}
+
+bool Covisibility_Landmark_Search::SetDescriptors
+(
+  const void * descriptors,
+  const std::string & descriptor_type_id,
+  const size_t descriptor_length,
+  const size_t descriptor_count
+)
+{
+  descriptors_ = nullptr;
+  descriptor_count_ = 0;
+  vocabulary_.clear();
+  vocabulary_matcher_.reset();
+  word_idf_.clear();
+  inverted_file_.clear();
+  view_descriptors_.clear();
+  covisibility_.clear();
+
+  if (descriptor_type_id == typeid(float).name())
+    b_float_descriptors_ = true;
+  else if (descriptor_type_id == typeid(unsigned char).name())
+    b_float_descriptors_ = false;
+  else
+    return false;
+  if (!descriptors || descriptor_count == 0 || descriptor_length == 0)
+    return false;
+  descriptors_ = descriptors;
+  descriptor_type_id_ = descriptor_type_id;
+  descriptor_length_ = descriptor_length;
+  descriptor_count_ = descriptor_count;
+  return true;
+}
+
+void Covisibility_Landmark_Search::BuildViewNeighborhoods
+(
+  const SfM_Data & sfm_data,
+  const std::vector<IndexT> & index_to_landmark_id
+)
+{
+  Hash_Map<IndexT, std::vector<uint32_t>> landmark_descriptors;
+  for (size_t i = 0; i < index_to_landmark_id.size(); ++i)
+    landmark_descriptors[index_to_landmark_id[i]].push_back(static_cast<uint32_t>(i));
+
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+  {
+    const auto descriptors_it = landmark_descriptors.find(landmark_it.first);
+    if (descriptors_it == landmark_descriptors.end())
+      continue;
+    const Observations & obs = landmark_it.second.obs;
+    for (const auto & obs_it : obs)
+    {
+      std::vector<uint32_t> & view_descriptors = view_descriptors_[obs_it.first];
+      view_descriptors.insert(view_descriptors.end(),
+        descriptors_it->second.cbegin(), descriptors_it->second.cend());
+      // Covisibility graph
+      for (const auto & other_obs_it : obs)
+      {
+        if (other_obs_it.first != obs_it.first)
+          ++covisibility_[obs_it.first][other_obs_it.first];
+      }
+    }
+  }
+  // Representatives of a landmark may be shared by views: keep unique indexes
+  for (auto & view_descriptors : view_descriptors_)
+  {
+    std::sort(view_descriptors.second.begin(), view_descriptors.second.end());
+    view_descriptors.second.erase(
+      std::unique(view_descriptors.second.begin(), view_descriptors.second.end()),
+      view_descriptors.second.end());
+  }
+}
+
+bool Covisibility_Landmark_Search::BuildVocabulary
+(
+  const size_t descriptor_count
+)
+{
+  // Coarse vocabulary learnt on a regular sample of the database
+  // (only the sampled descriptors are converted to float)
+  const size_t nb_words = std::min<size_t>(options_.vocabulary_size, descriptor_count);
+  const size_t nb_samples = std::min<size_t>(descriptor_count, 50 * nb_words);
+  using DescriptorType = Eigen::Matrix<float, Eigen::Dynamic, 1>;
+  std::vector<DescriptorType> samples(nb_samples);
+  for (size_t i = 0; i < nb_samples; ++i)
+  {
+    const size_t index = i * descriptor_count / nb_samples;
+    if (b_float_descriptors_)
+      samples[i] = Eigen::Map<const DescriptorType>(
+        static_cast<const float *>(descriptors_) + index * descriptor_length_,
+        descriptor_length_);
+    else
+      samples[i] = Eigen::Map<const Eigen::Matrix<unsigned char, Eigen::Dynamic, 1>>(
+        static_cast<const unsigned char *>(descriptors_) + index * descriptor_length_,
+        descriptor_length_).cast<float>();
+  }
+  std::vector<uint32_t> sample_words;
+  std::vector<DescriptorType> centers;
+  clustering::KMeans(samples, sample_words, centers, nb_words, 10,
+    clustering::KMeansInitType::KMEANS_INIT_RANDOM);
+  // Empty clusters have no valid center
+  std::vector<bool> used_centers(centers.size(), false);
+  for (const uint32_t word : sample_words)
+    if (word < centers.size())
+      used_centers[word] = true;
+  for (size_t i = 0; i < centers.size(); ++i)
+  {
+    if (used_centers[i])
+      vocabulary_.insert(vocabulary_.end(), centers[i].data(), centers[i].data() + centers[i].size());
+  }
+  if (vocabulary_.empty())
+    return false;
+
+  vocabulary_matcher_.reset(new ArrayMatcher_Kdtree_Flann<float>);
+  return vocabulary_matcher_->Build(vocabulary_.data(),
+    static_cast<int>(vocabulary_.size() / descriptor_length_),
+    static_cast<int>(descriptor_length_));
+}
+
+void Covisibility_Landmark_Search::BuildInvertedFile
+(
+  const size_t descriptor_count
+)
+{
+  //-- Word histogram of the views (from the descriptors of the landmarks they observe)
+  const std::vector<uint32_t> descriptor_words = Quantize(descriptors_, descriptor_count);
+  Hash_Map<IndexT, Hash_Map<uint32_t, float>> view_histograms;
+  for (const auto & view_descriptors : view_descriptors_)
+  {
+    Hash_Map<uint32_t, float> & histogram = view_histograms[view_descriptors.first];
+    for (const uint32_t descriptor : view_descriptors.second)
+      histogram[descriptor_words[descriptor]] += 1.f;
+  }
+
+  //-- tf-idf inverted file
+  const size_t vocabulary_size = vocabulary_.size() / descriptor_length_;
+  std::vector<size_t> word_view_count(vocabulary_size, 0);
+  for (const auto & histogram : view_histograms)
+    for (const auto & word : histogram.second)
+      ++word_view_count[word.first];
+  word_idf_.resize(vocabulary_size, 0.f);
+  for (size_t word = 0; word < vocabulary_size; ++word)
+  {
+    if (word_view_count[word] > 0)
+      word_idf_[word] = std::log(static_cast<float>(view_histograms.size()) / word_view_count[word]);
+  }
+  inverted_file_.resize(vocabulary_size);
+  for (const auto & histogram : view_histograms)
+  {
+    float norm = 0.f;
+    for (const auto & word : histogram.second)
+      norm += Square(word.second * word_idf_[word.first]);
+    norm = std::sqrt(norm);
+    for (const auto & word : histogram.second)
+    {
+      const float weight = word.second * word_idf_[word.first];
+      if (norm > 0.f && weight > 0.f)
+        inverted_file_[word.first].emplace_back(histogram.first, weight / norm);
+    }
+  }
+}
+
+std::vector<uint32_t> Covisibility_Landmark_Search::Quantize
+(
+  const void * descriptors,
+  const size_t count
+) const
+{
+  std::vector<uint32_t> words(count, 0);
+  if (count == 0 || !vocabulary_matcher_)
+    return words;
+
+  // The descriptors are searched by chunks: the unsigned char descriptors
+  // are converted to float one chunk at a time
+  std::vector<float> chunk;
+  IndMatches nn_matches;
+  std::vector<float> nn_distances;
+  for (size_t first = 0; first < count; first += quantization_chunk_size)
+  {
+    const size_t chunk_count = std::min(quantization_chunk_size, count - first);
+    const float * chunk_descriptors = nullptr;
+    if (b_float_descriptors_)
+    {
+      chunk_descriptors = static_cast<const float *>(descriptors) + first * descriptor_length_;
+    }
+    else
+    {
+      const unsigned char * begin =
+        static_cast<const unsigned char *>(descriptors) + first * descriptor_length_;
+      chunk.assign(begin, begin + chunk_count * descriptor_length_);
+      chunk_descriptors = chunk.data();
+    }
+    nn_matches.clear();
+    nn_distances.clear();
+    if (vocabulary_matcher_->SearchNeighbours(chunk_descriptors, static_cast<int>(chunk_count),
+          &nn_matches, &nn_distances, 1))
+    {
+      for (const auto & match : nn_matches)
+        words[first + match.i_] = match.j_;
+    }
+  }
+  return words;
+}
+
+std::vector<std::pair<float, IndexT>> Covisibility_Landmark_Search::ScoreViews
+(
+  const std::vector<uint32_t> & query_words
+) const
+{
+  // tf-idf cosine similarity through the inverted file
+  Hash_Map<uint32_t, float> query_histogram;
+  for (const uint32_t word : query_words)
+    query_histogram[word] += 1.f;
+  float query_norm = 0.f;
+  for (const auto & word : query_histogram)
+    query_norm += Square(word.second * word_idf_[word.first]);
+  query_norm = std::sqrt(query_norm);
+
+  Hash_Map<IndexT, float> view_scores;
+  if (query_norm > 0.f)
+  {
+    for (const auto & word : query_histogram)
+    {
+      const float weight = word.second * word_idf_[word.first] / query_norm;
+      for (const auto & view_weight : inverted_file_[word.first])
+        view_scores[view_weight.first] += weight * view_weight.second;
+    }
+  }
+
+  std::vector<std::pair<float, IndexT>> ranked_views;
+  ranked_views.reserve(view_scores.size());
+  for (const auto & view_score : view_scores)
+    ranked_views.emplace_back(view_score.second, view_score.first);
+  std::sort(ranked_views.begin(), ranked_views.end(),
+    [](const std::pair<float, IndexT> & a, const std::pair<float, IndexT> & b)
+    {
+      return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+  return ranked_views;
+}
+
+std::vector<IndexT> Covisibility_Landmark_Search::RetrieveViews
+(
+  const features::Regions & query_regions,
+  const size_t nb_views
+) const
+{
+  std::vector<IndexT> views;
+  if (!descriptors_ || query_regions.RegionCount() == 0
+      || query_regions.Type_id() != descriptor_type_id_
+      || query_regions.DescriptorLength() != descriptor_length_)
+    return views;
+  for (const auto & ranked_view : ScoreViews(Quantize(query_regions.DescriptorRawData(), query_regions.RegionCount())))
+  {
+    if (views.size() == nb_views)
+      break;
+    views.push_back(ranked_view.second);
+  }
+  return views;
+}
+
+bool Covisibility_Landmark_Search::Match
+(
+  const features::Regions & query_regions,
+  matching::IndMatches & matches,
+  std::vector<IndexT> * searched_views
+) const
+{
+  matches.clear();
+  if (!descriptors_ || query_regions.RegionCount() == 0
+      || query_regions.Type_id() != descriptor_type_id_
+      || query_regions.DescriptorLength() != descriptor_length_)
+    return false;
+
+  const std::vector<std::pair<float, IndexT>> ranked_views =
+    ScoreViews(Quantize(query_regions.DescriptorRawData(), query_regions.RegionCount()));
+  std::set<IndexT> selected_views;
+  // Database descriptors already searched, and the neighbors found among them
+  std::vector<uint32_t> searched;
+  std::vector<Query_Neighbors> neighbors(query_regions.RegionCount());
+  size_t next_ranked_view = 0;
+  const auto add_next_ranked_views = [&]()
+  {
+    size_t nb_added = 0;
+    for (; next_ranked_view < ranked_views.size()
+           && nb_added < options_.nb_candidate_views; ++next_ranked_view)
+    {
+      nb_added += selected_views.insert(ranked_views[next_ranked_view].second).second;
+    }
+    return nb_added;
+  };
+  add_next_ranked_views();
+
+  for (unsigned int expansion = 0; !selected_views.empty(); ++expansion)
+  {
+    // Database descriptors of the landmarks seen by the selected views
+    std::vector<uint32_t> subset;
+    for (const IndexT view_id : selected_views)
+    {
+      const auto it = view_descriptors_.find(view_id);
+      if (it != view_descriptors_.end())
+        subset.insert(subset.end(), it->second.cbegin(), it->second.cend());
+    }
+    std::sort(subset.begin(), subset.end());
+    subset.erase(std::unique(subset.begin(), subset.end()), subset.end());
+
+    // Search the descriptors added by the expansion only
+    std::vector<uint32_t> new_subset;
+    std::set_difference(subset.cbegin(), subset.cend(), searched.cbegin(), searched.cend(),
+      std::back_inserter(new_subset));
+    searched = std::move(subset);
+
+    if (b_float_descriptors_)
+      SearchSubset(static_cast<const float *>(descriptors_), descriptor_length_, new_subset,
+        static_cast<const float *>(query_regions.DescriptorRawData()),
+        query_regions.RegionCount(), neighbors);
+    else
+      SearchSubset(static_cast<const unsigned char *>(descriptors_), descriptor_length_, new_subset,
+        static_cast<const unsigned char *>(query_regions.DescriptorRawData()),
+        query_regions.RegionCount(), neighbors);
+    RatioTestMatches(neighbors, options_.distance_ratio, matches);
+
+    if (matches.size() >= options_.min_correspondences
+        || expansion == options_.max_expansions)
+      break;
+
+    // Expand to the views sharing the most landmarks with the selected ones
+    Hash_Map<IndexT, uint32_t> neighbor_scores;
+    for (const IndexT view_id : selected_views)
+    {
+      const auto it = covisibility_.find(view_id);
+      if (it == covisibility_.end())
+        continue;
+      for (const auto & neighbor : it->second)
+      {
+        if (selected_views.count(neighbor.first) == 0)
+          neighbor_scores[neighbor.first] += neighbor.second;
+      }
+    }
+    std::vector<std::pair<uint32_t, IndexT>> neighbors;
+    for (const auto & neighbor : neighbor_scores)
+      neighbors.emplace_back(neighbor.second, neighbor.first);
+    std::sort(neighbors.begin(), neighbors.end(),
+      [](const std::pair<uint32_t, IndexT> & a, const std::pair<uint32_t, IndexT> & b)
+      {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+      });
+    if (neighbors.size() > options_.nb_candidate_views)
+      neighbors.resize(options_.nb_candidate_views);
+    for (const auto & neighbor : neighbors)
+      selected_views.insert(neighbor.second);
+
+    // Disconnected neighborhood: continue with the next retrieved views
+    if (neighbors.empty() && add_next_ranked_views() == 0)
+      break;
+  }
+
+  if (searched_views)
+    searched_views->assign(selected_views.cbegin(), selected_views.cend());
+  return !matches.empty();
+}
+
+} // namespace sfm
+} // namespace openMVG
@@ -0,0 +1,196 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_COVISIBILITY_SEARCH_HPP
+#define OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_COVISIBILITY_SEARCH_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/matcher_kdtree_flann.hpp"
+#include "openMVG/types.hpp"
+
+namespace openMVG { namespace features { class Regions; } }
+namespace openMVG { namespace sfm { struct SfM_Data; } }
+
+namespace openMVG {
+namespace sfm {
+
+/**
+* @brief Prioritized 2D-3D matching for the localization database.
+* Instead of searching the descriptors of the whole model, a query is:
+* - described by a coarse visual vocabulary (tf-idf bag of words) to retrieve
+*   the most similar database views,
+* - matched only to the landmarks observed by these views,
+* - if too few correspondences are found, the search is expanded to the views
+*   that share the most landmarks with the already searched ones
+*   (covisibility in sfm_data.structure).
+* The query cost depends on the size of the searched neighborhood,
+* not on the size of the model.
+* The vocabulary and the inverted file can be saved and restored, so the
+* k-means training and the database quantization run only once.
+*/
+class Covisibility_Landmark_Search
+{
+public:
+
+  struct Options
+  {
+    /// Number of words of the coarse vocabulary
+    unsigned int vocabulary_size = 256;
+    /// Number of views retrieved first (and added by each expansion)
+    unsigned int nb_candidate_views = 5;
+    /// Number of 2D-3D correspondences that stops the expansion
+    unsigned int min_correspondences = 50;
+    /// Maximum number of covisibility expansions
+    unsigned int max_expansions = 3;
+    float distance_ratio = 0.8f;
+  };
+
+  explicit Covisibility_Landmark_Search(const Options & options);
+
+  /**
+  * @brief Build the vocabulary, the inverted file and the covisibility graph
+  *
+  * @param[in] sfm_data the scene of the database
+  * @param[in] descriptors the database descriptors (row major array)
+  * @param[in] descriptor_type_id type id of a descriptor element (unsigned char or float)
+  * @param[in] descriptor_length number of elements of a descriptor
+  * @param[in] index_to_landmark_id landmark id of each database descriptor
+  * @return True if the search structure has been built
+  */
+  bool Init
+  (
+    const SfM_Data & sfm_data,
+    const void * descriptors,
+    const std::string & descriptor_type_id,
+    const size_t descriptor_length,
+    const std::vector<IndexT> & index_to_landmark_id
+  );
+
+  /**
+  * @brief Restore the vocabulary and the inverted file written by Save
+  *  (the covisibility graph is built again from the scene)
+  *
+  * @param[in] sfm_data the scene of the database
+  * @param[in] descriptors the database descriptors (row major array)
+  * @param[in] descriptor_type_id type id of a descriptor element (unsigned char or float)
+  * @param[in] descriptor_length number of elements of a descriptor
+  * @param[in] index_to_landmark_id landmark id of each database descriptor
+  * @param[in] filename the file written by Save
+  * @return False if the file is missing or does not match the database
+  *  and the options
+  */
+  bool Load
+  (
+    const SfM_Data & sfm_data,
+    const void * descriptors,
+    const std::string & descriptor_type_id,
+    const size_t descriptor_length,
+    const std::vector<IndexT> & index_to_landmark_id,
+    const std::string & filename
+  );
+
+  /**
+  * @brief Save the vocabulary and the inverted file to a binary file
+  *
+  * @param[in] filename the file to write
+  * @return True if the file has been written
+  */
+  bool Save
+  (
+    const std::string & filename
+  ) const;
+
+  /**
+  * @brief Return the database views ranked by similarity to the query
+  *  (the best ones first)
+  */
+  std::vector<IndexT> RetrieveViews
+  (
+    const features::Regions & query_regions,
+    const size_t nb_views
+  ) const;
+
+  /**
+  * @brief Match the query descriptors to the landmarks of a view neighborhood
+  *
+  * @param[in] query_regions the query regions (same type as the database)
+  * @param[out] matches the putative matches
+  *  (i_: database descriptor, j_: query region)
+  * @param[out] searched_views the views whose landmarks have been searched (optional)
+  * @return True if some matches have been found
+  */
+  bool Match
+  (
+    const features::Regions & query_regions,
+    matching::IndMatches & matches,
+    std::vector<IndexT> * searched_views = nullptr
+  ) const;
+
+  const Options & options() const { return options_; }
+
+private:
+
+  /// Check and keep a reference to the database descriptors
+  bool SetDescriptors
+  (
+    const void * descriptors,
+    const std::string & descriptor_type_id,
+    const size_t descriptor_length,
+    const size_t descriptor_count
+  );
+
+  /// Database descriptors of each view and covisibility graph (from the scene)
+  void BuildViewNeighborhoods
+  (
+    const SfM_Data & sfm_data,
+    const std::vector<IndexT> & index_to_landmark_id
+  );
+
+  /// Learn the vocabulary on a regular sample of the database descriptors
+  bool BuildVocabulary(const size_t descriptor_count);
+
+  /// Build the tf-idf inverted file from the word histogram of the views
+  void BuildInvertedFile(const size_t descriptor_count);
+
+  /// Nearest word of some descriptors (same type as the database)
+  std::vector<uint32_t> Quantize(const void * descriptors, const size_t count) const;
+
+  /// Views ranked by tf-idf similarity
+  std::vector<std::pair<float, IndexT>> ScoreViews
+  (
+    const std::vector<uint32_t> & query_words
+  ) const;
+
+  Options options_;
+
+  const void * descriptors_;
+  std::string descriptor_type_id_;
+  bool b_float_descriptors_;
+  size_t descriptor_length_;
+  size_t descriptor_count_;
+
+  /// Vocabulary centroids (row major)
+  std::vector<float> vocabulary_;
+  /// Nearest word search structure (built once over vocabulary_)
+  std::unique_ptr<matching::ArrayMatcher_Kdtree_Flann<float>> vocabulary_matcher_;
+  std::vector<float> word_idf_;
+  /// View ids and tf-idf weights of the views containing each word
+  std::vector<std::vector<std::pair<IndexT, float>>> inverted_file_;
+  /// Database descriptors observed by each view
+  Hash_Map<IndexT, std::vector<uint32_t>> view_descriptors_;
+  /// Number of landmarks shared by each pair of views
+  Hash_Map<IndexT, Hash_Map<IndexT, uint32_t>> covisibility_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_COVISIBILITY_SEARCH_HPP
@@ -0,0 +1,374 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching/metric.hpp"
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Covisibility_Search.hpp"
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Single_3DTrackObservation_Database.hpp"
+#include "openMVG/sfm/pipelines/localization/localization_test.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+// A corridor of views: the landmarks of the segment s are seen
+// by the views s and s+1 (a chain of covisible views)
+struct Corridor_Scene
+{
+  enum : int { nb_segments = 20, nb_landmarks_per_segment = 30, nb_prototypes = 200 };
+
+  SfM_Data sfm_data;
+  Memory_Regions_Provider regions_provider;
+  SIFT_Regions landmark_descriptors;  // one descriptor per landmark (id order)
+  std::vector<IndexT> index_to_landmark_id;
+  std::mt19937 rng;
+
+  Corridor_Scene()
+  {
+    // The descriptors are variations of some visual word prototypes
+    std::uniform_int_distribution<int> value(0, 255), variation(-40, 40);
+    std::uniform_int_distribution<int> prototype_index(0, nb_prototypes - 1);
+    std::uniform_real_distribution<double> coordinate(-5.0, 5.0);
+    std::vector<SIFT_Regions::DescriptorT> prototypes(nb_prototypes);
+    for (auto & prototype : prototypes)
+      for (int k = 0; k < 128; ++k)
+        prototype[k] = value(rng);
+    std::vector<std::shared_ptr<SIFT_Regions>> view_regions(nb_segments + 1);
+    for (int i = 0; i <= nb_segments; ++i)
+    {
+      sfm_data.views[i] = std::make_shared<View>("", i, 0, i);
+      sfm_data.poses[i] = geometry::Pose3();
+      view_regions[i] = std::make_shared<SIFT_Regions>();
+    }
+    for (int landmark_id = 0; landmark_id < nb_segments * nb_landmarks_per_segment; ++landmark_id)
+    {
+      SIFT_Regions::DescriptorT descriptor = prototypes[prototype_index(rng)];
+      for (int k = 0; k < 128; ++k)
+        descriptor[k] = std::min(255, std::max(0, descriptor[k] + variation(rng)));
+      landmark_descriptors.Features().emplace_back(0.f, 0.f);
+      landmark_descriptors.Descriptors().push_back(descriptor);
+      index_to_landmark_id.push_back(landmark_id);
+
+      Landmark & landmark = sfm_data.structure[landmark_id];
+      landmark.X = Vec3(coordinate(rng), coordinate(rng), 10.0 + coordinate(rng));
+      const int segment = landmark_id / nb_landmarks_per_segment;
+      for (const int view_id : {segment, segment + 1})
+      {
+        SIFT_Regions & regions = *view_regions[view_id];
+        landmark.obs[view_id] = Observation(Vec2::Zero(), regions.RegionCount());
+        regions.Features().emplace_back(0.f, 0.f);
+        regions.Descriptors().push_back(Noisy(descriptor));
+      }
+    }
+    for (int i = 0; i <= nb_segments; ++i)
+      regions_provider.set(i, view_regions[i]);
+  }
+
+  SIFT_Regions::DescriptorT Noisy(const SIFT_Regions::DescriptorT & descriptor)
+  {
+    return NoisyDescriptor(descriptor, rng);
+  }
+
+  // A query seeing the landmarks of some segments
+  SIFT_Regions Query(const std::vector<int> & segments)
+  {
+    SIFT_Regions query;
+    for (const int segment : segments)
+    {
+      for (int i = 0; i < nb_landmarks_per_segment; ++i)
+      {
+        const int landmark_id = segment * nb_landmarks_per_segment + i;
+        const Vec2 x = ProjectQuery(sfm_data.structure.at(landmark_id).X, Vec3::Zero());
+        query.Features().emplace_back(static_cast<float>(x(0)), static_cast<float>(x(1)));
+        query.Descriptors().push_back(Noisy(landmark_descriptors.Descriptors()[landmark_id]));
+      }
+    }
+    return query;
+  }
+
+  bool InitSearch(Covisibility_Landmark_Search & search) const
+  {
+    return search.Init(sfm_data, landmark_descriptors.DescriptorRawData(),
+      landmark_descriptors.Type_id(), landmark_descriptors.DescriptorLength(),
+      index_to_landmark_id);
+  }
+};
+
+// Count the matches linking a query region to its own landmark
+size_t CountCorrectMatches
+(
+  const matching::IndMatches & matches,
+  const std::vector<int> & segments
+)
+{
+  size_t count = 0;
+  for (const auto & match : matches)
+  {
+    const int segment = segments[match.j_ / Corridor_Scene::nb_landmarks_per_segment];
+    count += (match.i_ == static_cast<IndexT>(segment * Corridor_Scene::nb_landmarks_per_segment
+      + match.j_ % Corridor_Scene::nb_landmarks_per_segment));
+  }
+  return count;
+}
+
+TEST(Covisibility_Landmark_Search, RetrieveViews)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  Covisibility_Landmark_Search search(options);
+  EXPECT_TRUE(scene.InitSearch(search));
+
+  // The two views seeing the segment are the most similar ones
+  const std::vector<IndexT> views = search.RetrieveViews(scene.Query({7}), 2);
+  CHECK_EQUAL(2, views.size());
+  const std::set<IndexT> view_set(views.cbegin(), views.cend());
+  EXPECT_TRUE(view_set == std::set<IndexT>({7, 8}));
+}
+
+TEST(Covisibility_Landmark_Search, Match_LocalNeighborhood)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  options.nb_candidate_views = 2;
+  options.min_correspondences = 20;
+  Covisibility_Landmark_Search search(options);
+  EXPECT_TRUE(scene.InitSearch(search));
+
+  const std::vector<int> segments = {12};
+  matching::IndMatches matches;
+  std::vector<IndexT> searched_views;
+  EXPECT_TRUE(search.Match(scene.Query(segments), matches, &searched_views));
+  EXPECT_EQ(Corridor_Scene::nb_landmarks_per_segment, matches.size());
+  EXPECT_EQ(matches.size(), CountCorrectMatches(matches, segments));
+  // Enough correspondences have been found without expansion
+  EXPECT_EQ(2, searched_views.size());
+}
+
+TEST(Covisibility_Landmark_Search, Match_Expansion)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  options.nb_candidate_views = 1;
+  options.min_correspondences = 2 * Corridor_Scene::nb_landmarks_per_segment;
+
+  // A query seeing two segments: the second one is reached by expansion
+  const std::vector<int> segments = {4, 6};
+  const SIFT_Regions query = scene.Query(segments);
+  matching::IndMatches matches;
+  std::vector<IndexT> searched_views;
+
+  options.max_expansions = 0;
+  Covisibility_Landmark_Search local_search(options);
+  EXPECT_TRUE(scene.InitSearch(local_search));
+  EXPECT_TRUE(local_search.Match(query, matches, &searched_views));
+  EXPECT_EQ(1, searched_views.size());
+  // A single view sees at most one of the two segments
+  EXPECT_TRUE(CountCorrectMatches(matches, segments) <= Corridor_Scene::nb_landmarks_per_segment);
+
+  options.max_expansions = 10;
+  Covisibility_Landmark_Search search(options);
+  EXPECT_TRUE(scene.InitSearch(search));
+  EXPECT_TRUE(search.Match(query, matches, &searched_views));
+  EXPECT_EQ(2 * Corridor_Scene::nb_landmarks_per_segment, matches.size());
+  EXPECT_EQ(matches.size(), CountCorrectMatches(matches, segments));
+  // Only a neighborhood of the corridor has been searched
+  EXPECT_TRUE(searched_views.size() < scene.sfm_data.GetViews().size() / 2);
+}
+
+TEST(Covisibility_Landmark_Search, Match_SameAsNeighborhoodSearch)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  options.nb_candidate_views = 1;
+  options.min_correspondences = 3 * Corridor_Scene::nb_landmarks_per_segment;
+  options.max_expansions = 10;
+  Covisibility_Landmark_Search search(options);
+  EXPECT_TRUE(scene.InitSearch(search));
+
+  const std::vector<int> segments = {4, 6, 8};
+  const SIFT_Regions query = scene.Query(segments);
+  matching::IndMatches matches;
+  std::vector<IndexT> searched_views;
+  EXPECT_TRUE(search.Match(query, matches, &searched_views));
+  EXPECT_TRUE(searched_views.size() > 2);
+
+  // The neighbors found expansion by expansion are the nearest descriptors
+  // of the whole searched neighborhood
+  const std::set<IndexT> searched_view_set(searched_views.cbegin(), searched_views.cend());
+  std::vector<uint32_t> neighborhood;
+  for (size_t i = 0; i < scene.index_to_landmark_id.size(); ++i)
+  {
+    for (const auto & obs : scene.sfm_data.structure.at(scene.index_to_landmark_id[i]).obs)
+    {
+      if (searched_view_set.count(obs.first))
+      {
+        neighborhood.push_back(static_cast<uint32_t>(i));
+        break;
+      }
+    }
+  }
+  matching::IndMatches expected_matches;
+  matching::L2<unsigned char> metric;
+  for (size_t q = 0; q < query.RegionCount(); ++q)
+  {
+    std::vector<std::pair<int, uint32_t>> distances;
+    for (const uint32_t i : neighborhood)
+      distances.emplace_back(metric(query.Descriptors()[q].data(),
+        scene.landmark_descriptors.Descriptors()[i].data(), 128), i);
+    std::partial_sort(distances.begin(), distances.begin() + 2, distances.end());
+    if (distances[0].first < Square(options.distance_ratio) * distances[1].first)
+      expected_matches.emplace_back(distances[0].second, q);
+  }
+  EXPECT_TRUE(matches == expected_matches);
+}
+
+TEST(Covisibility_Landmark_Search, Match_DescriptorType)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  Covisibility_Landmark_Search search(options);
+  EXPECT_TRUE(scene.InitSearch(search));
+
+  // Float descriptors of the same length as the database ones
+  using Float_Regions = Scalar_Regions<SIOPointFeature, float, 128>;
+  const SIFT_Regions query = scene.Query({7});
+  Float_Regions float_query;
+  for (size_t i = 0; i < query.RegionCount(); ++i)
+  {
+    float_query.Features().push_back(query.Features()[i]);
+    float_query.Descriptors().push_back(query.Descriptors()[i].cast<float>());
+  }
+  EXPECT_EQ(query.DescriptorLength(), float_query.DescriptorLength());
+  matching::IndMatches matches;
+  EXPECT_TRUE(search.RetrieveViews(float_query, 2).empty());
+  EXPECT_FALSE(search.Match(float_query, matches));
+  EXPECT_TRUE(matches.empty());
+  EXPECT_TRUE(search.Match(query, matches));
+}
+
+TEST(Covisibility_Landmark_Search, Localization_Database)
+{
+  Corridor_Scene scene;
+  SfM_Localization_Single_3DTrackObservation_Database exhaustive_localizer(1);
+  EXPECT_TRUE(exhaustive_localizer.Init(scene.sfm_data, scene.regions_provider));
+
+  SfM_Localization_Single_3DTrackObservation_Database localizer(1);
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  options.min_correspondences = 20;
+  EXPECT_TRUE(localizer.Init(scene.sfm_data, scene.regions_provider));
+  EXPECT_TRUE(localizer.EnableCovisibilitySearch(options));
+
+  // Both searches find the same 2D-3D correspondences
+  const SIFT_Regions query = scene.Query({15});
+  Image_Localizer_Match_Data exhaustive_data, data;
+  geometry::Pose3 exhaustive_pose, pose;
+  EXPECT_TRUE(exhaustive_localizer.Localize(resection::SolverType::DLT_6POINTS,
+    {1000, 1000}, nullptr, query, exhaustive_pose, &exhaustive_data));
+  EXPECT_TRUE(localizer.Localize(resection::SolverType::DLT_6POINTS,
+    {1000, 1000}, nullptr, query, pose, &data));
+  EXPECT_EQ(Corridor_Scene::nb_landmarks_per_segment, data.pt3D.cols());
+  EXPECT_MATRIX_NEAR(exhaustive_data.pt3D, data.pt3D, 1e-8);
+  EXPECT_MATRIX_NEAR(exhaustive_pose.center(), pose.center(), 1e-6);
+}
+
+TEST(Covisibility_Landmark_Search, SaveLoad)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  options.nb_candidate_views = 2;
+  options.min_correspondences = 20;
+  Covisibility_Landmark_Search search(options);
+  EXPECT_TRUE(scene.InitSearch(search));
+  const std::string filename = "covisibility_search_test.bin";
+  EXPECT_TRUE(search.Save(filename));
+
+  // The restored search retrieves the same views and matches
+  Covisibility_Landmark_Search loaded_search(options);
+  EXPECT_TRUE(loaded_search.Load(scene.sfm_data, scene.landmark_descriptors.DescriptorRawData(),
+    scene.landmark_descriptors.Type_id(), scene.landmark_descriptors.DescriptorLength(),
+    scene.index_to_landmark_id, filename));
+  for (const int segment : {3, 12})
+  {
+    const SIFT_Regions query = scene.Query({segment});
+    EXPECT_TRUE(search.RetrieveViews(query, 4) == loaded_search.RetrieveViews(query, 4));
+    matching::IndMatches matches, loaded_matches;
+    std::vector<IndexT> searched_views, loaded_searched_views;
+    EXPECT_TRUE(search.Match(query, matches, &searched_views));
+    EXPECT_TRUE(loaded_search.Match(query, loaded_matches, &loaded_searched_views));
+    EXPECT_TRUE(matches == loaded_matches);
+    EXPECT_TRUE(searched_views == loaded_searched_views);
+  }
+
+  // The file must match the options and the database
+  Covisibility_Landmark_Search::Options other_options = options;
+  other_options.vocabulary_size = Corridor_Scene::nb_prototypes / 2;
+  Covisibility_Landmark_Search other_search(other_options);
+  EXPECT_FALSE(other_search.Load(scene.sfm_data, scene.landmark_descriptors.DescriptorRawData(),
+    scene.landmark_descriptors.Type_id(), scene.landmark_descriptors.DescriptorLength(),
+    scene.index_to_landmark_id, filename));
+  const std::vector<IndexT> fewer_landmarks(scene.index_to_landmark_id.cbegin(),
+    scene.index_to_landmark_id.cend() - 1);
+  EXPECT_FALSE(loaded_search.Load(scene.sfm_data, scene.landmark_descriptors.DescriptorRawData(),
+    scene.landmark_descriptors.Type_id(), scene.landmark_descriptors.DescriptorLength(),
+    fewer_landmarks, filename));
+  std::remove(filename.c_str());
+}
+
+TEST(Covisibility_Landmark_Search, Localization_Database_SaveLoad)
+{
+  Corridor_Scene scene;
+  Covisibility_Landmark_Search::Options options;
+  options.vocabulary_size = Corridor_Scene::nb_prototypes;
+  options.min_correspondences = 20;
+  SfM_Localization_Single_3DTrackObservation_Database localizer(1);
+  EXPECT_TRUE(localizer.EnableCovisibilitySearch(options));
+  EXPECT_TRUE(localizer.Init(scene.sfm_data, scene.regions_provider));
+  const std::string filename = "covisibility_localization_database_test.bin";
+  const std::string search_filename = filename + ".covisibility";
+  EXPECT_TRUE(localizer.Save(filename));
+
+  // The search structure is stored next to the database
+  std::FILE * search_file = std::fopen(search_filename.c_str(), "rb");
+  EXPECT_TRUE(search_file != nullptr);
+  if (search_file)
+    std::fclose(search_file);
+
+  SfM_Localization_Single_3DTrackObservation_Database loaded_localizer;
+  EXPECT_TRUE(loaded_localizer.EnableCovisibilitySearch(options));
+  EXPECT_TRUE(loaded_localizer.Load(scene.sfm_data, filename, SIFT_Regions()));
+  const SIFT_Regions query = scene.Query({9});
+  matching::IndMatches matches, loaded_matches;
+  std::vector<matching::IndMatches> batch_matches, loaded_batch_matches;
+  EXPECT_TRUE(localizer.MatchBatch({&query}, batch_matches));
+  EXPECT_TRUE(loaded_localizer.MatchBatch({&query}, loaded_batch_matches));
+  EXPECT_EQ(Corridor_Scene::nb_landmarks_per_segment, loaded_batch_matches[0].size());
+  EXPECT_TRUE(batch_matches == loaded_batch_matches);
+
+  // A missing search file is built and written again on load
+  std::remove(search_filename.c_str());
+  SfM_Localization_Single_3DTrackObservation_Database rebuilt_localizer;
+  EXPECT_TRUE(rebuilt_localizer.EnableCovisibilitySearch(options));
+  EXPECT_TRUE(rebuilt_localizer.Load(scene.sfm_data, filename, SIFT_Regions()));
+  search_file = std::fopen(search_filename.c_str(), "rb");
+  EXPECT_TRUE(search_file != nullptr);
+  if (search_file)
+    std::fclose(search_file);
+
+  std::remove(filename.c_str());
+  std::remove(search_filename.c_str());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
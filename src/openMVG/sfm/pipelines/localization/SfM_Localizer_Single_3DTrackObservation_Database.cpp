@@ -10,20 +10,233 @@
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/matcher_kdtree_flann.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/system/logger.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <typeinfo>
+
 using namespace openMVG::matching;
 
 namespace openMVG {
 namespace sfm {
 
+namespace {
+
+  // Binary layout of a localization database file (native endianness):
+  // - Database_Header,
+  // - the ANN search trees,
+  // - the landmark id of each descriptor (uint32),
+  // - the descriptors (64 bytes aligned, ready to be memory mapped).
+  struct Database_Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t descriptor_type;
+    uint64_t descriptor_length;
+    uint64_t descriptor_count;
+    uint64_t index_offset;
+    uint64_t landmark_ids_offset;
+    uint64_t descriptors_offset;
+  };
+
+  const char database_magic[8] = "OMVGLDB";
+  const uint32_t database_version = 1;
+  const uint64_t descriptors_alignment = 64;
+
+  enum Descriptor_Type : uint32_t
+  {
+    DESCRIPTOR_UNSIGNED_CHAR = 0,
+    DESCRIPTOR_FLOAT = 1,
+    DESCRIPTOR_UNKNOWN = 255
+  };
+
+  Descriptor_Type DescriptorTypeFromId(const std::string & type_id)
+  {
+    if (type_id == typeid(unsigned char).name())
+      return DESCRIPTOR_UNSIGNED_CHAR;
+    if (type_id == typeid(float).name())
+      return DESCRIPTOR_FLOAT;
+    return DESCRIPTOR_UNKNOWN;
+  }
+
+  size_t DescriptorTypeSize(const Descriptor_Type type)
+  {
+    return (type == DESCRIPTOR_UNSIGNED_CHAR) ? sizeof(unsigned char) : sizeof(float);
+  }
+
+  // The matcher built by RegionMatcherFactory for ANN_L2
+  template <typename Scalar>
+  using Database_Matcher = RegionsMatcherT<ArrayMatcher_Kdtree_Flann<Scalar>>;
+
+  template <typename Scalar>
+  bool SaveSearchIndex
+  (
+    RegionsMatcher * matcher,
+    std::FILE * stream
+  )
+  {
+    auto * database_matcher = dynamic_cast<Database_Matcher<Scalar> *>(matcher);
+    return database_matcher && database_matcher->array_matcher().SaveIndex(stream);
+  }
+
+  template <typename Scalar>
+  std::unique_ptr<RegionsMatcher> LoadSearchIndex
+  (
+    const void * descriptors,
+    const size_t descriptor_count,
+    const size_t descriptor_length,
+    std::FILE * stream
+  )
+  {
+    ArrayMatcher_Kdtree_Flann<Scalar> array_matcher;
+    if (!array_matcher.LoadIndex(static_cast<const Scalar *>(descriptors),
+          descriptor_count, descriptor_length, stream))
+      return {};
+    return std::unique_ptr<RegionsMatcher>(
+      new Database_Matcher<Scalar>(std::move(array_matcher), true));
+  }
+
+  // The covisibility search structure is stored next to the database file
+  std::string CovisibilitySearchFilename(const std::string & database_filename)
+  {
+    return database_filename + ".covisibility";
+  }
+
+  uint64_t StreamPosition(std::FILE * stream)
+  {
+#ifdef _WIN32
+    return static_cast<uint64_t>(_ftelli64(stream));
+#else
+    return static_cast<uint64_t>(ftello(stream));
+#endif
+  }
+
+  // Pad the stream with zeros up to the next multiple of alignment
+  uint64_t AlignStream(std::FILE * stream, const uint64_t alignment)
+  {
+    uint64_t position = StreamPosition(stream);
+    for (; position % alignment != 0; ++position)
+      std::fputc(0, stream);
+    return position;
+  }
+
+  /**
+  * @brief Select the representative descriptors of a track: greedily add the
+  *  descriptor that most reduces the distance of the track descriptors to
+  *  their closest representative (the first one is the track medoid).
+  */
+  std::vector<size_t> SelectRepresentativeDescriptors
+  (
+    const features::Regions & track_regions,
+    const size_t max_count
+  )
+  {
+    const size_t count = track_regions.RegionCount();
+    std::vector<size_t> representatives;
+    if (count <= max_count)
+    {
+      for (size_t i = 0; i < count; ++i)
+        representatives.push_back(i);
+      return representatives;
+    }
+
+    std::vector<double> distances(count * count, 0.0);
+    for (size_t i = 0; i < count; ++i)
+    {
+      for (size_t j = i + 1; j < count; ++j)
+      {
+        distances[i * count + j] = distances[j * count + i] =
+          std::sqrt(track_regions.SquaredDescriptorDistance(i, &track_regions, j));
+      }
+    }
+
+    std::vector<double> closest_distance(count, std::numeric_limits<double>::max());
+    std::vector<bool> selected(count, false);
+    while (representatives.size() < max_count)
+    {
+      size_t best_candidate = 0;
+      double best_cost = std::numeric_limits<double>::max();
+      for (size_t candidate = 0; candidate < count; ++candidate)
+      {
+        if (selected[candidate])
+          continue;
+        double cost = 0.0;
+        for (size_t i = 0; i < count; ++i)
+          cost += std::min(closest_distance[i], distances[i * count + candidate]);
+        if (cost < best_cost)
+        {
+          best_cost = cost;
+          best_candidate = candidate;
+        }
+      }
+      selected[best_candidate] = true;
+      representatives.push_back(best_candidate);
+      for (size_t i = 0; i < count; ++i)
+        closest_distance[i] = std::min(closest_distance[i], distances[i * count + best_candidate]);
+    }
+    std::sort(representatives.begin(), representatives.end());
+    return representatives;
+  }
+
+} // namespace
+
   SfM_Localization_Single_3DTrackObservation_Database::
-  SfM_Localization_Single_3DTrackObservation_Database()
-  :SfM_Localizer()
+  SfM_Localization_Single_3DTrackObservation_Database
+  (
+    const unsigned int max_descriptors_per_landmark
+  )
+  :SfM_Localizer(),
+  max_descriptors_per_landmark_(max_descriptors_per_landmark),
+  sfm_data_(nullptr),
+  descriptors_(nullptr),
+  descriptor_length_(0)
   {}
 
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::EnableCovisibilitySearch
+  (
+    const Covisibility_Landmark_Search::Options & options
+  )
+  {
+    covisibility_search_.reset(new Covisibility_Landmark_Search(options));
+    return !sfm_data_ || InitCovisibilitySearch();
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::InitCovisibilitySearch()
+  {
+    if (!covisibility_search_)
+      return true;
+    if (!covisibility_search_->Init(*sfm_data_, descriptors_, descriptor_type_,
+          descriptor_length_, index_to_landmark_id_))
+    {
+      OPENMVG_LOG_ERROR << "Cannot initialize the covisibility search.";
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::MatchQuery
+  (
+    const features::Regions & query_regions,
+    matching::IndMatches & putative_matches
+  ) const
+  {
+    if (covisibility_search_)
+      return covisibility_search_->Match(query_regions, putative_matches);
+    return matching_interface_->MatchDistanceRatio(0.8, query_regions, putative_matches);
+  }
+
   bool
   SfM_Localization_Single_3DTrackObservation_Database::Init
   (
@@ -42,21 +255,49 @@ namespace sfm {
     // - each view observation leads to a new regions
     // - link each observation region to a track id to ease 2D-3D correspondences search
 
+    database_file_.reset();
+    index_to_landmark_id_.clear();
     landmark_observations_descriptors_.reset(regions_provider.getRegionsType()->EmptyClone());
+    std::unique_ptr<features::Regions> track_regions(
+      regions_provider.getRegionsType()->EmptyClone());
     for (const auto & landmark : sfm_data.GetLandmarks())
     {
+      if (max_descriptors_per_landmark_ == 0)
+      {
+        for (const auto & observation : landmark.second.obs)
+        {
+          if (observation.second.id_feat != UndefinedIndexT)
+          {
+            // copy the feature/descriptor to landmark_observations_descriptors
+            const std::shared_ptr<features::Regions> view_regions = regions_provider.get(observation.first);
+            view_regions->CopyRegion(observation.second.id_feat, landmark_observations_descriptors_.get());
+            // link this descriptor to the track Id
+            index_to_landmark_id_.push_back(landmark.first);
+          }
+        }
+        continue;
+      }
+
+      // Keep only the representative descriptors of the track
+      track_regions.reset(regions_provider.getRegionsType()->EmptyClone());
       for (const auto & observation : landmark.second.obs)
       {
         if (observation.second.id_feat != UndefinedIndexT)
         {
-          // copy the feature/descriptor to landmark_observations_descriptors
           const std::shared_ptr<features::Regions> view_regions = regions_provider.get(observation.first);
-          view_regions->CopyRegion(observation.second.id_feat, landmark_observations_descriptors_.get());
-          // link this descriptor to the track Id
-          index_to_landmark_id_.push_back(landmark.first);
+          view_regions->CopyRegion(observation.second.id_feat, track_regions.get());
         }
       }
+      for (const size_t i :
+        SelectRepresentativeDescriptors(*track_regions, max_descriptors_per_landmark_))
+      {
+        track_regions->CopyRegion(i, landmark_observations_descriptors_.get());
+        index_to_landmark_id_.push_back(landmark.first);
+      }
     }
+    descriptors_ = landmark_observations_descriptors_->DescriptorRawData();
+    descriptor_type_ = landmark_observations_descriptors_->Type_id();
+    descriptor_length_ = landmark_observations_descriptors_->DescriptorLength();
     OPENMVG_LOG_INFO << "Init retrieval database ... ";
     // Initialize the matching interface
     matching_interface_ =
@@ -70,6 +311,175 @@ namespace sfm {
 
     sfm_data_ = &sfm_data;
 
+    return InitCovisibilitySearch();
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::Save
+  (
+    const std::string & filename
+  ) const
+  {
+    const Descriptor_Type descriptor_type = DescriptorTypeFromId(descriptor_type_);
+    if (!matching_interface_ || !descriptors_ || descriptor_type == DESCRIPTOR_UNKNOWN)
+    {
+      OPENMVG_LOG_ERROR << "Only an initialized database of scalar descriptors can be saved.";
+      return false;
+    }
+
+    std::FILE * stream = std::fopen(filename.c_str(), "wb");
+    if (!stream)
+    {
+      OPENMVG_LOG_ERROR << "Cannot open the localization database file: " << filename;
+      return false;
+    }
+
+    Database_Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, database_magic, sizeof(header.magic));
+    header.version = database_version;
+    header.descriptor_type = descriptor_type;
+    header.descriptor_length = descriptor_length_;
+    header.descriptor_count = index_to_landmark_id_.size();
+    // The header is written again once the section offsets are known
+    bool bOk = std::fwrite(&header, sizeof(header), 1, stream) == 1;
+
+    header.index_offset = StreamPosition(stream);
+    bOk = bOk && ((descriptor_type == DESCRIPTOR_UNSIGNED_CHAR) ?
+      SaveSearchIndex<unsigned char>(matching_interface_.get(), stream) :
+      SaveSearchIndex<float>(matching_interface_.get(), stream));
+
+    header.landmark_ids_offset = AlignStream(stream, sizeof(uint32_t));
+    for (const IndexT landmark_id : index_to_landmark_id_)
+    {
+      const uint32_t id = static_cast<uint32_t>(landmark_id);
+      bOk = bOk && std::fwrite(&id, sizeof(id), 1, stream) == 1;
+    }
+
+    header.descriptors_offset = AlignStream(stream, descriptors_alignment);
+    const size_t descriptors_size =
+      header.descriptor_count * descriptor_length_ * DescriptorTypeSize(descriptor_type);
+    bOk = bOk && std::fwrite(descriptors_, 1, descriptors_size, stream) == descriptors_size;
+
+    std::rewind(stream);
+    bOk = bOk && std::fwrite(&header, sizeof(header), 1, stream) == 1;
+    bOk = (std::fclose(stream) == 0) && bOk;
+    if (!bOk)
+      OPENMVG_LOG_ERROR << "Cannot write the localization database file: " << filename;
+    if (bOk && covisibility_search_)
+      bOk = covisibility_search_->Save(CovisibilitySearchFilename(filename));
+    return bOk;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::Load
+  (
+    const SfM_Data & sfm_data,
+    const std::string & filename,
+    const features::Regions & regions_type
+  )
+  {
+    matching_interface_.reset();
+    landmark_observations_descriptors_.reset();
+    index_to_landmark_id_.clear();
+    descriptors_ = nullptr;
+
+    database_file_.reset(new system::MappedFile);
+    if (!database_file_->open(filename))
+    {
+      OPENMVG_LOG_ERROR << "Cannot open the localization database file: " << filename;
+      database_file_.reset();
+      return false;
+    }
+
+    // Check the header and the layout of the file
+    const unsigned char * data = database_file_->data();
+    const uint64_t file_size = database_file_->size();
+    Database_Header header;
+    bool bValid = file_size >= sizeof(header);
+    if (bValid)
+    {
+      std::memcpy(&header, data, sizeof(header));
+      const Descriptor_Type descriptor_type =
+        static_cast<Descriptor_Type>(header.descriptor_type);
+      bValid = std::memcmp(header.magic, database_magic, sizeof(header.magic)) == 0
+        && header.version == database_version
+        && regions_type.IsScalar()
+        && descriptor_type == DescriptorTypeFromId(regions_type.Type_id())
+        && descriptor_type != DESCRIPTOR_UNKNOWN
+        && header.descriptor_length == regions_type.DescriptorLength()
+        && header.descriptor_count > 0
+        && header.descriptor_count <= static_cast<uint64_t>(std::numeric_limits<int>::max())
+        && header.landmark_ids_offset % sizeof(uint32_t) == 0
+        && header.landmark_ids_offset + header.descriptor_count * sizeof(uint32_t)
+          <= header.descriptors_offset
+        && header.descriptors_offset % descriptors_alignment == 0
+        && header.descriptors_offset + header.descriptor_count * header.descriptor_length
+          * DescriptorTypeSize(descriptor_type) <= file_size;
+    }
+    if (!bValid)
+    {
+      OPENMVG_LOG_ERROR << "Invalid localization database file (or regions type): " << filename;
+      database_file_.reset();
+      return false;
+    }
+
+    // Restore the descriptor to landmark table (it must match the scene)
+    const uint32_t * landmark_ids =
+      reinterpret_cast<const uint32_t *>(data + header.landmark_ids_offset);
+    index_to_landmark_id_.assign(landmark_ids, landmark_ids + header.descriptor_count);
+    for (const IndexT landmark_id : index_to_landmark_id_)
+    {
+      if (sfm_data.GetLandmarks().count(landmark_id) == 0)
+      {
+        OPENMVG_LOG_ERROR << "The localization database does not match the SfM_Data scene.";
+        index_to_landmark_id_.clear();
+        database_file_.reset();
+        return false;
+      }
+    }
+
+    // Restore the ANN search trees on the mapped descriptors
+    descriptors_ = data + header.descriptors_offset;
+    descriptor_type_ = regions_type.Type_id();
+    descriptor_length_ = header.descriptor_length;
+    std::FILE * stream = std::fopen(filename.c_str(), "rb");
+    if (stream && std::fseek(stream, static_cast<long>(header.index_offset), SEEK_SET) == 0)
+    {
+      matching_interface_ = (header.descriptor_type == DESCRIPTOR_UNSIGNED_CHAR) ?
+        LoadSearchIndex<unsigned char>(descriptors_, header.descriptor_count,
+          descriptor_length_, stream) :
+        LoadSearchIndex<float>(descriptors_, header.descriptor_count,
+          descriptor_length_, stream);
+    }
+    if (stream)
+      std::fclose(stream);
+    if (!matching_interface_)
+    {
+      OPENMVG_LOG_ERROR << "Cannot read the search index of the localization database.";
+      index_to_landmark_id_.clear();
+      descriptors_ = nullptr;
+      database_file_.reset();
+      return false;
+    }
+
+    OPENMVG_LOG_INFO << "Retrieval database loaded with:\n"
+      << "#landmarks: " << sfm_data.GetLandmarks().size() << "\n"
+      << "#descriptors: " << index_to_landmark_id_.size();
+
+    sfm_data_ = &sfm_data;
+
+    // Restore the covisibility search, or build it and store it for the next loads
+    if (!covisibility_search_)
+      return true;
+    const std::string search_filename = CovisibilitySearchFilename(filename);
+    if (covisibility_search_->Load(sfm_data, descriptors_, descriptor_type_,
+          descriptor_length_, index_to_landmark_id_, search_filename))
+      return true;
+    if (!InitCovisibilitySearch())
+      return false;
+    if (!covisibility_search_->Save(search_filename))
+      OPENMVG_LOG_WARNING << "The covisibility search will be built again on the next load.";
     return true;
   }
 
@@ -91,7 +501,80 @@ namespace sfm {
     }
 
     matching::IndMatches vec_putative_matches;
-    if (!matching_interface_->MatchDistanceRatio(0.8, query_regions, vec_putative_matches))
+    if (!MatchQuery(query_regions, vec_putative_matches))
+    {
+      return false;
+    }
+
+    return Localize(solver_type, image_size, optional_intrinsics, query_regions,
+      vec_putative_matches, pose, resection_data_ptr);
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::MatchBatch
+  (
+    const std::vector<const features::Regions *> & queries_regions,
+    std::vector<matching::IndMatches> & queries_matches
+  ) const
+  {
+    queries_matches.assign(queries_regions.size(), matching::IndMatches());
+    if (!sfm_data_ || !matching_interface_ || queries_regions.empty())
+    {
+      return false;
+    }
+
+    // The prioritized search is specific to each query
+    if (covisibility_search_)
+    {
+      for (size_t i = 0; i < queries_regions.size(); ++i)
+        MatchQuery(*queries_regions[i], queries_matches[i]);
+      return true;
+    }
+
+    // Gather the query descriptors in a single array:
+    //  the ANN search is run once for the whole batch
+    std::unique_ptr<features::Regions> batch_regions(queries_regions.front()->EmptyClone());
+    std::vector<size_t> offsets(1, 0);
+    for (const features::Regions * query_regions : queries_regions)
+    {
+      for (size_t i = 0; i < query_regions->RegionCount(); ++i)
+      {
+        query_regions->CopyRegion(i, batch_regions.get());
+      }
+      offsets.push_back(batch_regions->RegionCount());
+    }
+    if (batch_regions->RegionCount() == 0)
+    {
+      return true;
+    }
+
+    matching::IndMatches batch_matches;
+    matching_interface_->MatchDistanceRatio(0.8, *batch_regions, batch_matches);
+
+    // Dispatch the matches to their query (offsets are sorted)
+    for (const auto & match : batch_matches)
+    {
+      const size_t query_index =
+        std::distance(offsets.cbegin(),
+                      std::upper_bound(offsets.cbegin(), offsets.cend(), match.j_)) - 1;
+      queries_matches[query_index].emplace_back(match.i_, match.j_ - offsets[query_index]);
+    }
+    return true;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::Localize
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    const features::Regions & query_regions,
+    const matching::IndMatches & vec_putative_matches,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr
+  ) const
+  {
+    if (!sfm_data_ || vec_putative_matches.empty())
     {
       return false;
     }
@@ -9,10 +9,14 @@
 #ifndef OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_STO_DB_HPP
 #define OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_STO_DB_HPP
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "openMVG/matching/regions_matcher.hpp"
 #include "openMVG/sfm/pipelines/localization/SfM_Localizer.hpp"
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Covisibility_Search.hpp"
+#include "openMVG/system/mapped_file.hpp"
 #include "openMVG/types.hpp"
 
 namespace openMVG { namespace cameras { struct IntrinsicBase; } }
@@ -29,12 +33,41 @@ namespace sfm {
 // - create a large array with all the used descriptors and init a Matcher with it
 // - to localize an input image compare its regions to the database and robust estimate
 //   the pose from found 2d-3D correspondences
+//
+// The database can be saved to a binary file and restored without the
+// regions of the scene: the descriptors are memory mapped and the ANN search
+// trees are read back instead of being built again.
+//
+// Optionally the query descriptors are matched only to the landmarks of the
+// views retrieved for the query and of their covisible views
+// (see Covisibility_Landmark_Search).
 
 class SfM_Localization_Single_3DTrackObservation_Database : public SfM_Localizer
 {
 public:
 
-  SfM_Localization_Single_3DTrackObservation_Database();
+  /**
+  * @param[in] max_descriptors_per_landmark number of descriptors kept per
+  *  landmark when the database is built (0: all the observations). The kept
+  *  descriptors are the representatives closest to the other ones of the track.
+  */
+  explicit SfM_Localization_Single_3DTrackObservation_Database
+  (
+    const unsigned int max_descriptors_per_landmark = 0
+  );
+
+  /**
+  * @brief Use the covisibility prioritized search instead of the exhaustive
+  *  one to find the 2D-3D putative matches (built at once if the database is
+  *  already setup, else by Init or Load)
+  *
+  * @param[in] options vocabulary and view neighborhood expansion settings
+  * @return False if the search structure cannot be built
+  */
+  bool EnableCovisibilitySearch
+  (
+    const Covisibility_Landmark_Search::Options & options
+  );
 
   /**
   * @brief Build the retrieval database (3D points descriptors)
@@ -49,6 +82,39 @@ public:
     const Regions_Provider & regions_provider
   ) override;
 
+  /**
+  * @brief Save the retrieval database (descriptors, descriptor to landmark
+  *  table and ANN search trees) to a binary file.
+  *  The covisibility search (if enabled) is saved next to it
+  *  (vocabulary and inverted file, in filename + ".covisibility").
+  *
+  * @param[in] filename the database file
+  * @return True if the database has been written
+  */
+  bool Save
+  (
+    const std::string & filename
+  ) const;
+
+  /**
+  * @brief Restore a retrieval database written by Save
+  *  (the descriptors are memory mapped and stay on disk until used).
+  *  If the covisibility search is enabled, it is restored from the file
+  *  next to the database; if this file is missing or outdated, the search
+  *  is built and the file is written.
+  *
+  * @param[in] sfm_data the SfM scene the database has been built from
+  * @param[in] filename the database file
+  * @param[in] regions_type the regions type of the query images
+  * @return True if the database has been correctly setup
+  */
+  bool Load
+  (
+    const SfM_Data & sfm_data,
+    const std::string & filename,
+    const features::Regions & regions_type
+  );
+
   /**
   * @brief Try to localize an image in the database
   *
@@ -70,16 +136,75 @@ public:
     Image_Localizer_Match_Data * resection_data_ptr = nullptr
   ) const override;
 
+  /**
+  * @brief Match the regions of several query images with a single database
+  *  search (the query descriptors are gathered in one array)
+  *
+  * @param[in] queries_regions the regions of each query image
+  * @param[out] queries_matches the putative matches of each query
+  *  (i_: database descriptor, j_: query region)
+  * @return True if the database has been searched
+  */
+  bool MatchBatch
+  (
+    const std::vector<const features::Regions *> & queries_regions,
+    std::vector<matching::IndMatches> & queries_matches
+  ) const;
+
+  /**
+  * @brief Try to localize an image from already computed putative matches
+  *  (see MatchBatch)
+  *
+  * @param[in] solver_type the type of absolute pose solver to use
+  * @param[in] image_size the w,h image size
+  * @param[in] optional_intrinsics camera intrinsic if known (else nullptr)
+  * @param[in] query_regions the image regions
+  * @param[in] putative_matches the database to query regions matches
+  * @param[out] pose found pose
+  * @param[out] resection_data matching data (2D-3D and inliers; optional)
+  * @return True if a putative pose has been estimated
+  */
+  bool Localize
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    const features::Regions & query_regions,
+    const matching::IndMatches & putative_matches,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr = nullptr
+  ) const;
+
 private:
+  /// Build the covisibility search structure (if enabled)
+  bool InitCovisibilitySearch();
+
+  /// Putative matches of a query (i_: database descriptor, j_: query region)
+  bool MatchQuery
+  (
+    const features::Regions & query_regions,
+    matching::IndMatches & putative_matches
+  ) const;
+
+  /// Number of descriptors kept per landmark (0: all)
+  unsigned int max_descriptors_per_landmark_;
   // Reference to the scene
   const SfM_Data * sfm_data_;
   /// Association of a regions to a landmark observation
   std::unique_ptr<features::Regions> landmark_observations_descriptors_;
+  /// Database file (descriptors of a restored database)
+  std::unique_ptr<system::MappedFile> database_file_;
+  /// Raw database descriptors (from the regions or the database file)
+  const void * descriptors_;
+  std::string descriptor_type_;
+  size_t descriptor_length_;
   /// Association of a track observation to a track Id (used for retrieval)
   std::vector<IndexT> index_to_landmark_id_;
   /// A matching interface to find matches between 2D descriptor matches
   ///  and 3D points observation descriptors
   std::unique_ptr<matching::RegionsMatcher> matching_interface_;
+  /// Prioritized 2D-3D search (nullptr: exhaustive search)
+  std::unique_ptr<Covisibility_Landmark_Search> covisibility_search_;
 };
 
 } // namespace sfm
@@ -0,0 +1,112 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Single_3DTrackObservation_Database.hpp"
+#include "openMVG/sfm/pipelines/localization/localization_test.hpp"
+
+#include "testing/testing.h"
+
+#include <cstdio>
+
+// Return the 2D-3D putative correspondences found for a query
+Image_Localizer_Match_Data Correspondences
+(
+  const SfM_Localization_Single_3DTrackObservation_Database & localizer,
+  const Regions & query
+)
+{
+  Image_Localizer_Match_Data resection_data;
+  geometry::Pose3 pose;
+  localizer.Localize(resection::SolverType::DLT_6POINTS, {1000, 1000}, nullptr,
+    query, pose, &resection_data);
+  return resection_data;
+}
+
+// Check that each query descriptor is associated to its own landmark
+// (the query point is the projection of the landmark)
+bool IsCorrectlyMatched(const Image_Localizer_Match_Data & resection_data)
+{
+  for (Mat::Index i = 0; i < resection_data.pt2D.cols(); ++i)
+  {
+    const Vec2 projection = ProjectQuery(resection_data.pt3D.col(i), Vec3::Zero());
+    if ((resection_data.pt2D.col(i) - projection).norm() > 1e-2)
+      return false;
+  }
+  return resection_data.pt2D.cols() > 0;
+}
+
+TEST(Localization_Database, SaveLoad)
+{
+  // One observation per landmark: the distance ratio test is not
+  // disturbed by the other observations of the track
+  Localization_Scene scene(1);
+  const SIFT_Regions query = scene.Query();
+  const std::string filename = "localization_database_test.bin";
+
+  SfM_Localization_Single_3DTrackObservation_Database localizer;
+  EXPECT_TRUE(localizer.Init(scene.sfm_data, scene.regions_provider));
+  EXPECT_TRUE(localizer.Save(filename));
+  const Image_Localizer_Match_Data built = Correspondences(localizer, query);
+  EXPECT_TRUE(IsCorrectlyMatched(built));
+
+  // The restored database does not need the regions anymore
+  SfM_Localization_Single_3DTrackObservation_Database loaded_localizer;
+  EXPECT_TRUE(loaded_localizer.Load(scene.sfm_data, filename, SIFT_Regions()));
+  const Image_Localizer_Match_Data loaded = Correspondences(loaded_localizer, query);
+  EXPECT_TRUE(IsCorrectlyMatched(loaded));
+  EXPECT_EQ(built.pt2D.cols(), loaded.pt2D.cols());
+  EXPECT_MATRIX_NEAR(built.pt2D, loaded.pt2D, 1e-8);
+  EXPECT_MATRIX_NEAR(built.pt3D, loaded.pt3D, 1e-8);
+
+  // The database must match the scene and the regions type
+  EXPECT_FALSE(loaded_localizer.Load(scene.sfm_data, filename, AKAZE_Float_Regions()));
+  SfM_Data other_scene = scene.sfm_data;
+  other_scene.structure.erase(0);
+  EXPECT_FALSE(loaded_localizer.Load(other_scene, filename, SIFT_Regions()));
+  EXPECT_FALSE(loaded_localizer.Load(scene.sfm_data, "missing_database.bin", SIFT_Regions()));
+
+  std::remove(filename.c_str());
+}
+
+TEST(Localization_Database, RepresentativeDescriptors)
+{
+  Localization_Scene scene(3);
+  const SIFT_Regions query = scene.Query();
+  const std::string filename = "localization_database_representatives_test.bin";
+  const std::string filename_all = "localization_database_all_test.bin";
+
+  SfM_Localization_Single_3DTrackObservation_Database localizer(1);
+  EXPECT_TRUE(localizer.Init(scene.sfm_data, scene.regions_provider));
+  EXPECT_TRUE(IsCorrectlyMatched(Correspondences(localizer, query)));
+  EXPECT_TRUE(localizer.Save(filename));
+
+  // The observations of a track are too similar to pass the distance ratio test
+  SfM_Localization_Single_3DTrackObservation_Database localizer_all;
+  EXPECT_TRUE(localizer_all.Init(scene.sfm_data, scene.regions_provider));
+  EXPECT_FALSE(IsCorrectlyMatched(Correspondences(localizer_all, query)));
+  EXPECT_TRUE(localizer_all.Save(filename_all));
+
+  // One descriptor per landmark instead of three
+  std::FILE * file = std::fopen(filename.c_str(), "rb");
+  std::FILE * file_all = std::fopen(filename_all.c_str(), "rb");
+  CHECK(file && file_all);
+  std::fseek(file, 0, SEEK_END);
+  std::fseek(file_all, 0, SEEK_END);
+  EXPECT_TRUE(std::ftell(file) < std::ftell(file_all));
+  std::fclose(file);
+  std::fclose(file_all);
+
+  SfM_Localization_Single_3DTrackObservation_Database loaded_localizer;
+  EXPECT_TRUE(loaded_localizer.Load(scene.sfm_data, filename, SIFT_Regions()));
+  EXPECT_TRUE(IsCorrectlyMatched(Correspondences(loaded_localizer, query)));
+
+  std::remove(filename.c_str());
+  std::remove(filename_all.c_str());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -0,0 +1,123 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_LOCALIZATION_TEST_HPP
+#define OPENMVG_SFM_LOCALIZATION_TEST_HPP
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/geometry/pose3.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::sfm;
+
+// A regions provider filled with in memory regions
+struct Memory_Regions_Provider : public Regions_Provider
+{
+  Memory_Regions_Provider()
+  {
+    region_type_.reset(new SIFT_Regions);
+  }
+
+  void set(const IndexT view_id, std::shared_ptr<Regions> regions)
+  {
+    cache_[view_id] = regions;
+  }
+};
+
+// Return a copy of a descriptor with some noise
+inline SIFT_Regions::DescriptorT NoisyDescriptor
+(
+  const SIFT_Regions::DescriptorT & descriptor,
+  std::mt19937 & rng
+)
+{
+  std::uniform_int_distribution<int> noise(-4, 4);
+  SIFT_Regions::DescriptorT noisy = descriptor;
+  for (int k = 0; k < 128; ++k)
+    noisy[k] = std::min(255, std::max(0, descriptor[k] + noise(rng)));
+  return noisy;
+}
+
+// Project a point with the pinhole camera used by the queries
+// (identity rotation, focal 1000, principal point (500, 500))
+inline Vec2 ProjectQuery(const Vec3 & X, const Vec3 & center)
+{
+  const Vec3 Xc = X - center;
+  return Vec2(500.0 + 1000.0 * Xc(0) / Xc(2), 500.0 + 1000.0 * Xc(1) / Xc(2));
+}
+
+// Random landmark descriptors observed (with some noise) in nb_observations
+// consecutive views
+struct Localization_Scene
+{
+  static const int nb_views = 6;
+  static const int nb_landmarks = 40;
+
+  SfM_Data sfm_data;
+  Memory_Regions_Provider regions_provider;
+  std::vector<SIFT_Regions::DescriptorT> landmark_descriptors;
+  std::mt19937 rng;
+
+  explicit Localization_Scene(const int nb_observations = 1)
+  {
+    std::uniform_int_distribution<int> value(0, 255);
+    std::uniform_real_distribution<double> coordinate(-5.0, 5.0);
+    std::vector<std::shared_ptr<SIFT_Regions>> view_regions(nb_views);
+    for (int i = 0; i < nb_views; ++i)
+    {
+      sfm_data.views[i] = std::make_shared<View>("", i, 0, i);
+      sfm_data.poses[i] = geometry::Pose3();
+      view_regions[i] = std::make_shared<SIFT_Regions>();
+    }
+
+    landmark_descriptors.resize(nb_landmarks);
+    for (int landmark_id = 0; landmark_id < nb_landmarks; ++landmark_id)
+    {
+      for (int k = 0; k < 128; ++k)
+        landmark_descriptors[landmark_id][k] = value(rng);
+      Landmark & landmark = sfm_data.structure[landmark_id];
+      landmark.X = Vec3(coordinate(rng), coordinate(rng), 10.0 + coordinate(rng));
+      for (int j = 0; j < nb_observations; ++j)
+      {
+        const int view_id = (landmark_id + j) % nb_views;
+        SIFT_Regions & regions = *view_regions[view_id];
+        landmark.obs[view_id] = Observation(Vec2::Zero(), regions.RegionCount());
+        regions.Features().emplace_back(0.f, 0.f);
+        regions.Descriptors().push_back(Noisy(landmark_descriptors[landmark_id]));
+      }
+    }
+    for (int i = 0; i < nb_views; ++i)
+      regions_provider.set(i, view_regions[i]);
+  }
+
+  SIFT_Regions::DescriptorT Noisy(const SIFT_Regions::DescriptorT & descriptor)
+  {
+    return NoisyDescriptor(descriptor, rng);
+  }
+
+  // A query seeing every landmark from a translated camera (see ProjectQuery)
+  SIFT_Regions Query(const Vec3 & center = Vec3::Zero())
+  {
+    SIFT_Regions query;
+    for (int landmark_id = 0; landmark_id < nb_landmarks; ++landmark_id)
+    {
+      const Vec2 x = ProjectQuery(sfm_data.structure.at(landmark_id).X, center);
+      query.Features().emplace_back(static_cast<float>(x(0)), static_cast<float>(x(1)));
+      query.Descriptors().push_back(Noisy(landmark_descriptors[landmark_id]));
+    }
+    return query;
+  }
+};
+
+#endif // OPENMVG_SFM_LOCALIZATION_TEST_HPP
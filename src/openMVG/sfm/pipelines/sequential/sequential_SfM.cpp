@@ -17,11 +17,13 @@
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_BA.hpp"
 #include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/sfm/sfm_data_BA_mixed_precision.hpp"
 #include "openMVG/sfm/sfm_data_filters.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/stl/stl.hpp"
 #include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
+#include "openMVG/system/profiler.hpp"
 
 #include "third_party/histogram/histogram.hpp"
 #include "third_party/htmlDoc/htmlDoc.hpp"
@@ -141,6 +143,7 @@ GetPairWithMostMatches(const SfM_Data& sfm_data, const PairWiseMatches& matches,
 }
 
 bool SequentialSfMReconstructionEngine::Process() {
+  OPENMVG_PROFILE_ZONE("SequentialSfM");
 
   //-------------------
   //-- Incremental reconstruction
@@ -217,6 +220,11 @@ bool SequentialSfMReconstructionEngine::Process() {
   {
     eraseUnstablePosesAndObservations(sfm_data_);
   }
+  if (b_ba_mixed_precision_)
+  {
+    // The intermediate refinements were done in mixed precision
+    BundleAdjustment(true);
+  }
 
   //-- Reconstruction done.
   //-- Display some statistics
@@ -269,6 +277,7 @@ bool SequentialSfMReconstructionEngine::Process() {
 
 bool SequentialSfMReconstructionEngine::InitLandmarkTracks()
 {
+  OPENMVG_PROFILE_ZONE("TrackBuilding");
   // Compute tracks from matches
   tracks::TracksBuilder tracksBuilder;
 
@@ -452,6 +461,7 @@ bool SequentialSfMReconstructionEngine::AutomaticInitialPairChoice(Pair & initia
 /// Compute the initial 3D seed (First camera t=0; R=Id, second estimated by 5 point algorithm)
 bool SequentialSfMReconstructionEngine::MakeInitialPair3D(const Pair & current_pair)
 {
+  OPENMVG_PROFILE_ZONE("InitialPair");
   // Compute robust Essential matrix for ImageId [I,J]
   // use min max to have I < J
   const uint32_t
@@ -862,6 +872,7 @@ bool SequentialSfMReconstructionEngine::FindImagesWithPossibleResection(
  */
 bool SequentialSfMReconstructionEngine::Resection(const uint32_t viewIndex)
 {
+  OPENMVG_PROFILE_ZONE("Resection");
   using namespace tracks;
 
   // A. Compute 2D/3D matches
@@ -1187,8 +1198,9 @@ bool SequentialSfMReconstructionEngine::Resection(const uint32_t viewIndex)
 }
 
 /// Bundle adjustment to refine Structure; Motion and Intrinsics
-bool SequentialSfMReconstructionEngine::BundleAdjustment()
+bool SequentialSfMReconstructionEngine::BundleAdjustment(const bool b_final_refinement)
 {
+  OPENMVG_PROFILE_ZONE("BundleAdjustment");
   Bundle_Adjustment_Ceres::BA_Ceres_options options;
   if ( sfm_data_.GetPoses().size() > 100 &&
       (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
@@ -1203,7 +1215,6 @@ bool SequentialSfMReconstructionEngine::BundleAdjustment()
   {
     options.linear_solver_type_ = ceres::DENSE_SCHUR;
   }
-  Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
   const Optimize_Options ba_refine_options
     ( ReconstructionEngine::intrinsic_refinement_options_,
       Extrinsic_Parameter_Type::ADJUST_ALL, // Adjust camera motion
@@ -1211,7 +1222,39 @@ bool SequentialSfMReconstructionEngine::BundleAdjustment()
       Control_Point_Parameter(),
       this->b_use_motion_prior_
     );
-  return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  if (this->b_use_motion_prior_)
+  {
+    // The motion prior registration changes the whole scene: use a new problem
+    Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
+    return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  }
+
+  if (ba_partition_cluster_size_ > 0
+      && sfm_data_.GetPoses().size() > ba_partition_cluster_size_)
+  {
+    // Large scene: refine bounded clusters of poses instead of the whole scene
+    //  (the session problem no longer matches the refined scene)
+    ba_session_.reset();
+    Bundle_Adjustment_Ceres_Partitioned bundle_adjustment_obj(options,
+      Bundle_Adjustment_Ceres_Partitioned::Partition_options(ba_partition_cluster_size_));
+    return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  }
+
+  if (b_ba_mixed_precision_ && !b_final_refinement)
+  {
+    // Intermediate refinement: single precision linear solver
+    ba_session_.reset();
+    Bundle_Adjustment_Mixed_Precision bundle_adjustment_obj(options);
+    return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  }
+
+  // Reuse the problem of the previous iterations:
+  //  only the new observations are added and the rejected ones removed.
+  if (!ba_session_)
+    ba_session_.reset(new Bundle_Adjustment_Ceres_Session(options, ba_refine_options));
+  else
+    ba_session_->ceres_options() = options;
+  return ba_session_->Adjust(sfm_data_);
 }
 
 /**
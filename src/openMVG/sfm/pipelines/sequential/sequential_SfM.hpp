@@ -9,6 +9,7 @@
 #ifndef OPENMVG_SFM_LOCALIZATION_SEQUENTIAL_SFM_HPP
 #define OPENMVG_SFM_LOCALIZATION_SEQUENTIAL_SFM_HPP
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -27,6 +28,7 @@ namespace sfm {
 
 struct Features_Provider;
 struct Matches_Provider;
+class Bundle_Adjustment_Ceres_Session;
 
 /// Sequential SfM Pipeline Reconstruction Engine.
 class SequentialSfMReconstructionEngine : public ReconstructionEngine
@@ -97,7 +99,8 @@ private:
   bool Resection(const uint32_t imageIndex);
 
   /// Bundle adjustment to refine Structure; Motion and Intrinsics
-  bool BundleAdjustment();
+  /// (the final refinement is always done in double precision)
+  bool BundleAdjustment(const bool b_final_refinement = false);
 
   /// Discard track with too large residual error
   bool badTrackRejector(double dPrecision, size_t count = 0);
@@ -131,6 +134,9 @@ private:
   ETriangulationMethod triangulation_method_ = ETriangulationMethod::DEFAULT;
 
   resection::SolverType resection_method_ = resection::SolverType::DEFAULT;
+
+  // Bundle adjustment problem reused across the resection/BA iterations
+  std::unique_ptr<Bundle_Adjustment_Ceres_Session> ba_session_;
 };
 
 } // namespace sfm
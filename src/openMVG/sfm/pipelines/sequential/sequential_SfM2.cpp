@@ -14,11 +14,13 @@
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_BA.hpp"
 #include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/sfm/sfm_data_BA_mixed_precision.hpp"
 #include "openMVG/sfm/sfm_data_filters.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/sfm/sfm_data_triangulation.hpp"
 #include "openMVG/stl/stl.hpp"
 #include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
 
 #include "third_party/histogram/histogram.hpp"
 #include "third_party/htmlDoc/htmlDoc.hpp"
@@ -82,6 +84,7 @@ void SequentialSfMReconstructionEngine2::SetMatchesProvider(Matches_Provider * p
 }
 
 bool SequentialSfMReconstructionEngine2::Process() {
+  OPENMVG_PROFILE_ZONE("SequentialSfM2");
 
   //-------------------
   //-- Incremental reconstruction
@@ -186,7 +189,10 @@ bool SequentialSfMReconstructionEngine2::Process() {
   //--
   //- 3. Final bundle Adjustment
   //--
-  BundleAdjustment();
+  // Triangulate all the tracks again with the refined poses: the tracks and
+  // observations rejected with less accurate poses are given a new chance.
+  Triangulation(true);
+  BundleAdjustment(true);
 
   //-- Reconstruction done.
   //-- Display some statistics
@@ -204,6 +210,7 @@ bool SequentialSfMReconstructionEngine2::Process() {
 
 bool SequentialSfMReconstructionEngine2::InitTracksAndLandmarks()
 {
+  OPENMVG_PROFILE_ZONE("TrackBuilding");
   // Compute tracks from matches
   tracks::TracksBuilder tracksBuilder;
   {
@@ -264,27 +271,134 @@ bool SequentialSfMReconstructionEngine2::InitTracksAndLandmarks()
   return map_tracks_.size() > 0;
 }
 
-bool SequentialSfMReconstructionEngine2::Triangulation()
+bool SequentialSfMReconstructionEngine2::Triangulation(const bool b_full_triangulation)
 {
-  sfm_data_.structure = landmarks_;
+  OPENMVG_PROFILE_ZONE("Triangulation");
 
   //--
   // Triangulation
   //--
-  // Clean the structure:
-  //  - keep observations that are linked to valid pose and intrinsic data.
+  // Only the tracks seen by the views localized since the last triangulation
+  // are (re)computed, the other landmarks keep their refined position:
+  //  - a new track is robustly triangulated from the observations of the
+  //    localized views,
+  //  - an existing landmark keeps its position and gets the new observations
+  //    that agree with it. If some of them do not agree, the track is
+  //    robustly triangulated again and the solution with the most
+  //    observations is kept.
+  // A full triangulation considers all the localized views as new ones: the
+  // observations of every landmark are validated again with the refined
+  // poses, and the tracks without landmark (i.e. removed as outliers) are
+  // triangulated again.
+
+  if (triangulated_views_.empty())
+    sfm_data_.structure.clear();
+  if (b_full_triangulation)
+    triangulated_views_.clear();
+
+  // Collect the newly localized views
+  std::set<IndexT> localized_views, new_views;
+  for (const auto & view_it : sfm_data_.GetViews())
+  {
+    if (sfm_data_.IsPoseAndIntrinsicDefined(view_it.second.get()))
+    {
+      localized_views.insert(view_it.first);
+      if (triangulated_views_.count(view_it.first) == 0)
+        new_views.insert(view_it.first);
+    }
+  }
+  // Views removed since the last call will be considered as new ones
+  // if they are localized again
+  triangulated_views_ = localized_views;
+
+  // Collect the tracks seen by the new views
+  std::set<IndexT> dirty_track_ids;
+  for (const IndexT view_id : new_views)
+  {
+    openMVG::tracks::STLMAPTracks view_tracks;
+    shared_track_visibility_helper_->GetTracksInImages({view_id}, view_tracks);
+    std::set<IndexT> view_track_ids;
+    tracks::TracksUtilsMap::GetTracksIdVector(view_tracks, &view_track_ids);
+    dirty_track_ids.insert(view_track_ids.cbegin(), view_track_ids.cend());
+  }
+  const std::vector<IndexT> track_ids(dirty_track_ids.cbegin(), dirty_track_ids.cend());
 
   const double max_reprojection_error = 4.0;
   const IndexT min_required_inliers = 2;
   const IndexT min_sample_index = 2;
-  eraseObservationsWithMissingPoses(sfm_data_, min_sample_index);
   SfM_Data_Structure_Computation_Robust triangulation_engine(
       max_reprojection_error,
       min_required_inliers,
       min_sample_index,
       triangulation_method_);
 
-  triangulation_engine.triangulate(sfm_data_);
+  std::vector<Landmark> updated_landmarks(track_ids.size());
+  std::vector<bool> is_valid(track_ids.size(), false);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(track_ids.size()); ++i)
+  {
+    const IndexT track_id = track_ids[i];
+    // Keep the observations of the localized views
+    Observations obs;
+    for (const auto & obs_it : landmarks_.at(track_id).obs)
+    {
+      if (localized_views.count(obs_it.first))
+        obs.insert(obs_it);
+    }
+
+    Landmark & landmark = updated_landmarks[i];
+    const auto structure_it = sfm_data_.structure.find(track_id);
+    bool b_need_triangulation = true;
+    if (structure_it != sfm_data_.structure.end())
+    {
+      // Validate the new observations with the current landmark position
+      landmark = structure_it->second;
+      if (b_full_triangulation)
+        landmark.obs.clear();
+      b_need_triangulation = false;
+      for (const auto & obs_it : obs)
+      {
+        if (new_views.count(obs_it.first) == 0)
+          continue;
+        const View * view = sfm_data_.GetViews().at(obs_it.first).get();
+        const IntrinsicBase * cam = sfm_data_.GetIntrinsics().at(view->id_intrinsic).get();
+        const Pose3 pose = sfm_data_.GetPoseOrDie(view);
+        if (CheiralityTest((*cam)(obs_it.second.x), pose, landmark.X) &&
+            cam->residual(pose(landmark.X), obs_it.second.x).squaredNorm()
+              < Square(max_reprojection_error))
+        {
+          landmark.obs.insert(obs_it);
+        }
+        else
+        {
+          b_need_triangulation = true;
+        }
+      }
+      is_valid[i] = landmark.obs.size() >= min_required_inliers;
+    }
+    if (b_need_triangulation)
+    {
+      Landmark triangulated_landmark;
+      if (triangulation_engine.robust_triangulation(sfm_data_, obs, triangulated_landmark) &&
+          (!is_valid[i] || triangulated_landmark.obs.size() > landmark.obs.size()))
+      {
+        landmark = std::move(triangulated_landmark);
+        is_valid[i] = true;
+      }
+    }
+  }
+
+  // Update the scene structure
+  // (a landmark without enough valid observations is removed)
+  for (size_t i = 0; i < track_ids.size(); ++i)
+  {
+    if (is_valid[i])
+      sfm_data_.structure[track_ids[i]] = std::move(updated_landmarks[i]);
+    else
+      sfm_data_.structure.erase(track_ids[i]);
+  }
 
   return !sfm_data_.structure.empty();
 }
@@ -294,6 +408,7 @@ bool SequentialSfMReconstructionEngine2::AddingMissingView
   const float & track_inlier_ratio
 )
 {
+  OPENMVG_PROFILE_ZONE("Resection");
   if (sfm_data_.GetLandmarks().empty())
     return false;
 
@@ -504,8 +619,9 @@ bool SequentialSfMReconstructionEngine2::AddingMissingView
   return (pose_after != pose_before);
 }
 
-bool SequentialSfMReconstructionEngine2::BundleAdjustment()
+bool SequentialSfMReconstructionEngine2::BundleAdjustment(const bool b_final_refinement)
 {
+  OPENMVG_PROFILE_ZONE("BundleAdjustment");
   Bundle_Adjustment_Ceres::BA_Ceres_options options;
   if ( sfm_data_.GetPoses().size() > 100 &&
       (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
@@ -520,7 +636,6 @@ bool SequentialSfMReconstructionEngine2::BundleAdjustment()
   {
     options.linear_solver_type_ = ceres::DENSE_SCHUR;
   }
-  Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
   const Optimize_Options ba_refine_options
     ( ReconstructionEngine::intrinsic_refinement_options_,
       ReconstructionEngine::extrinsic_refinement_options_,
@@ -528,6 +643,13 @@ bool SequentialSfMReconstructionEngine2::BundleAdjustment()
       Control_Point_Parameter(),
       this->b_use_motion_prior_
     );
+  if (b_ba_mixed_precision_ && !b_final_refinement)
+  {
+    // Intermediate refinement: single precision linear solver
+    Bundle_Adjustment_Mixed_Precision bundle_adjustment_obj(options);
+    return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  }
+  Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
   return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
 }
 
@@ -50,14 +50,18 @@ public:
   /// Initialize tracks
   bool InitTracksAndLandmarks();
 
-  /// Triangulate tracks
-  bool Triangulation();
+  /// Triangulate the tracks seen by the views localized since the last call
+  /// (the other landmarks are kept as they are).
+  /// A full triangulation validates again all the observations with the
+  /// current poses and triangulates again the tracks without landmark.
+  bool Triangulation(const bool b_full_triangulation = false);
 
   /// Adding missing view (Try to find the pose of the missing camera)
   bool AddingMissingView(const float & track_inlier_ratio);
 
   /// Adjust intrinsics, landmark and extrinsics according the user config.
-  bool BundleAdjustment();
+  /// (the final refinement is always done in double precision)
+  bool BundleAdjustment(const bool b_final_refinement = false);
 
   /**
    * Set the default lens distortion type to use if it is declared unknown
@@ -108,6 +112,8 @@ private:
   openMVG::tracks::STLMAPTracks map_tracks_;
   /// Helper to compute fast 2D-3D visibility
   std::unique_ptr<openMVG::tracks::SharedTrackVisibilityHelper> shared_track_visibility_helper_;
+  /// Views whose observations have been used by the last triangulation
+  std::set<IndexT> triangulated_views_;
 
   /// 2View triangulation method used in the robust triangulation engine
   ETriangulationMethod triangulation_method_ = ETriangulationMethod::DEFAULT;
@@ -91,6 +91,72 @@ TEST(SEQUENTIAL_SFM2_STELLAR, Known_Intrinsics) {
   EXPECT_TRUE( IsTracksOneCC(sfmEngine.Get_SfM_Data()));
 }
 
+// Engine giving access to its scene, to alter it between two triangulations
+struct SequentialSfMReconstructionEngine2_Scene : public SequentialSfMReconstructionEngine2
+{
+  using SequentialSfMReconstructionEngine2::SequentialSfMReconstructionEngine2;
+  SfM_Data & Scene() { return sfm_data_; }
+};
+
+// Test that the full triangulation gives a new chance to the tracks and
+// the observations rejected by a previous round
+TEST(SEQUENTIAL_SFM2, Full_Triangulation) {
+
+  const int nviews = 6;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+
+  SfM_Data sfm_data_2 = sfm_data;
+  sfm_data_2.structure.clear();
+
+  std::shared_ptr<Features_Provider> feats_provider =
+    std::make_shared<Synthetic_Features_Provider>();
+  std::normal_distribution<double> distribution(0.0, 0.5);
+  dynamic_cast<Synthetic_Features_Provider*>(feats_provider.get())->load(d,distribution);
+
+  std::shared_ptr<Matches_Provider> matches_provider =
+    std::make_shared<Synthetic_Matches_Provider>();
+  dynamic_cast<Synthetic_Matches_Provider*>(matches_provider.get())->load(d);
+
+  SequentialSfMReconstructionEngine2_Scene sfmEngine(
+    nullptr,
+    sfm_data_2,
+    "./");
+  sfmEngine.SetFeaturesProvider(feats_provider.get());
+  sfmEngine.SetMatchesProvider(matches_provider.get());
+  EXPECT_TRUE(sfmEngine.InitTracksAndLandmarks());
+
+  // Triangulation with the known poses (all the views are new)
+  EXPECT_TRUE(sfmEngine.Triangulation());
+  const Landmarks reference = sfmEngine.Scene().structure;
+  const double reference_rmse = RMSE(sfmEngine.Scene());
+  EXPECT_EQ(npoints, reference.size());
+
+  // Reject some tracks and some observations
+  Landmarks & structure = sfmEngine.Scene().structure;
+  for (IndexT track_id = 0; track_id < npoints; track_id += 4)
+    structure.erase(track_id);
+  for (IndexT track_id = 1; track_id < npoints; track_id += 4)
+    structure.at(track_id).obs.erase(structure.at(track_id).obs.begin());
+
+  // The incremental triangulation only considers the new views
+  EXPECT_TRUE(sfmEngine.Triangulation());
+  EXPECT_EQ(npoints - npoints / 4, sfmEngine.Scene().structure.size());
+
+  // The full triangulation restores the structure
+  EXPECT_TRUE(sfmEngine.Triangulation(true));
+  EXPECT_EQ(reference.size(), sfmEngine.Scene().structure.size());
+  for (const auto & landmark_it : reference)
+  {
+    const Landmark & landmark = sfmEngine.Scene().structure.at(landmark_it.first);
+    EXPECT_EQ(landmark_it.second.obs.size(), landmark.obs.size());
+    EXPECT_NEAR(0.0, (landmark_it.second.X - landmark.X).norm(), 1e-6);
+  }
+  EXPECT_NEAR(reference_rmse, RMSE(sfmEngine.Scene()), 1e-6);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -33,7 +33,9 @@ public:
     sfm_data_(sfm_data),
     intrinsic_refinement_options_(cameras::Intrinsic_Parameter_Type::ADJUST_ALL),
     extrinsic_refinement_options_(sfm::Extrinsic_Parameter_Type::ADJUST_ALL),
-    b_use_motion_prior_(false)
+    b_use_motion_prior_(false),
+    ba_partition_cluster_size_(0),
+    b_ba_mixed_precision_(false)
   {
   }
 
@@ -75,6 +77,26 @@ public:
     b_use_motion_prior_ = rhs;
   }
 
+  /// Use a partitioned bundle adjustment for the scenes having more than
+  ///  cluster_size poses (0: always use a global bundle adjustment)
+  void Set_BA_Partition_Cluster_Size
+  (
+    unsigned int cluster_size
+  )
+  {
+    ba_partition_cluster_size_ = cluster_size;
+  }
+
+  /// Use a mixed precision bundle adjustment for the intermediate
+  ///  refinements (the final refinement stays in double precision)
+  void Set_BA_Mixed_Precision
+  (
+    bool rhs
+  )
+  {
+    b_ba_mixed_precision_ = rhs;
+  }
+
   const SfM_Data & Get_SfM_Data() const {return sfm_data_;}
 
 protected:
@@ -91,6 +113,8 @@ protected:
   cameras::Intrinsic_Parameter_Type intrinsic_refinement_options_;
   sfm::Extrinsic_Parameter_Type extrinsic_refinement_options_;
   bool b_use_motion_prior_;
+  unsigned int ba_partition_cluster_size_;
+  bool b_ba_mixed_precision_;
 };
 
 } // namespace sfm
@@ -10,10 +10,8 @@
 
 #include "openMVG/cameras/cameras.hpp"
 #include "openMVG/features/feature.hpp"
-#include "openMVG/graph/graph.hpp"
 #include "openMVG/geometry/pose3.hpp"
 #include "openMVG/multiview/solver_fundamental_kernel.hpp"
-#include "openMVG/multiview/triangulation_nview.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 #include "openMVG/robust_estimation/guided_matching.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
@@ -59,9 +57,11 @@ void PointsToMat(
 
 SfM_Data_Structure_Estimation_From_Known_Poses::SfM_Data_Structure_Estimation_From_Known_Poses
 (
-  double max_reprojection_error // pixels
+  double max_reprojection_error, // pixels
+  const Frustum_Filter::NearFarPlanesT & depth_ranges
 ):
-  max_reprojection_error_(max_reprojection_error)
+  max_reprojection_error_(max_reprojection_error),
+  depth_ranges_(depth_ranges)
 {
 }
 
@@ -76,7 +76,6 @@ void SfM_Data_Structure_Estimation_From_Known_Poses::run(
   sfm_data.structure.clear();
 
   match(sfm_data, pairs, regions_provider);
-  filter(sfm_data, pairs, regions_provider);
   triangulate(sfm_data, regions_provider, triangulation_method);
 }
 
@@ -86,227 +85,178 @@ void SfM_Data_Structure_Estimation_From_Known_Poses::match(
   const Pair_Set & pairs,
   const std::shared_ptr<Regions_Provider> & regions_provider)
 {
+  // Group the pairs by their left view (pairs are sorted), so each left
+  // regions is requested once, and the views in use at a given time are
+  // close in the pair list (limited working set for the regions cache).
+  std::vector<std::pair<IndexT, std::vector<IndexT>>> pairs_per_view;
+  for (const Pair & pair : pairs)
+  {
+    if (pairs_per_view.empty() || pairs_per_view.back().first != pair.first)
+      pairs_per_view.emplace_back(pair.first, std::vector<IndexT>());
+    pairs_per_view.back().second.push_back(pair.second);
+  }
+
   system::LoggerProgress my_progress_bar( pairs.size(),
     "Pairwise fundamental guided matching" );
 #ifdef OPENMVG_USE_OPENMP
-  #pragma omp parallel
+  #pragma omp parallel for schedule(dynamic)
 #endif // OPENMVG_USE_OPENMP
-  for (const Pair & pair : pairs)
+  for (int k = 0; k < static_cast<int>(pairs_per_view.size()); ++k)
   {
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-#endif // OPENMVG_USE_OPENMP
+    const IndexT I = pairs_per_view[k].first;
+    const View * viewL = sfm_data.GetViews().at(I).get();
+    const Intrinsics::const_iterator iterIntrinsicL =
+      sfm_data.GetIntrinsics().find(viewL->id_intrinsic);
+    if (iterIntrinsicL == sfm_data.GetIntrinsics().end())
     {
-    // --
-    // Perform GUIDED MATCHING
-    // --
-    // Use the computed model to check valid correspondences
-    // - by considering geometric error and descriptor distance ratio.
-    std::vector<IndMatch> vec_corresponding_indexes;
-
-    const View
-      * viewL = sfm_data.GetViews().at(pair.first).get(),
-      * viewR = sfm_data.GetViews().at(pair.second).get();
+      my_progress_bar += pairs_per_view[k].second.size();
+      continue;
+    }
+    const Pose3 poseL = sfm_data.GetPoseOrDie(viewL);
+    const Mat34 P_L = iterIntrinsicL->second->get_projective_equivalent(poseL);
+    const std::shared_ptr<features::Regions> regionsL = regions_provider->get(I);
+
+    // Scene depth range of the left view (if known)
+    const auto iterDepth = depth_ranges_.find(I);
+    const bool bDepth_range =
+      iterDepth != depth_ranges_.end()
+      && iterDepth->second.first > 0.
+      && iterDepth->second.first < iterDepth->second.second
+      && isPinhole(iterIntrinsicL->second->getType());
+
+    for (const IndexT J : pairs_per_view[k].second)
+    {
+      ++my_progress_bar;
 
-    const Pose3
-      poseL = sfm_data.GetPoseOrDie(viewL),
-      poseR = sfm_data.GetPoseOrDie(viewR);
+      const View * viewR = sfm_data.GetViews().at(J).get();
+      const Intrinsics::const_iterator iterIntrinsicR =
+        sfm_data.GetIntrinsics().find(viewR->id_intrinsic);
+      if (iterIntrinsicR == sfm_data.GetIntrinsics().end())
+        continue;
 
-    if (sfm_data.GetIntrinsics().count(viewL->id_intrinsic) != 0 ||
-        sfm_data.GetIntrinsics().count(viewR->id_intrinsic) != 0)
-    {
-      const Intrinsics::const_iterator
-        iterIntrinsicL = sfm_data.GetIntrinsics().find(viewL->id_intrinsic),
-        iterIntrinsicR = sfm_data.GetIntrinsics().find(viewR->id_intrinsic);
+      // --
+      // Perform GUIDED MATCHING
+      // --
+      // Use the computed model to check valid correspondences
+      // - by considering geometric error and descriptor distance ratio.
+      std::vector<IndMatch> vec_corresponding_indexes;
 
-      const Mat34
-        P_L = iterIntrinsicL->second->get_projective_equivalent(poseL),
-        P_R = iterIntrinsicR->second->get_projective_equivalent(poseR);
+      const Pose3 poseR = sfm_data.GetPoseOrDie(viewR);
+      const Mat34 P_R = iterIntrinsicR->second->get_projective_equivalent(poseR);
 
-      const Mat3 F_lr = F_from_P(P_L, P_R);
       const double thresholdF = max_reprojection_error_;
 
-      const std::shared_ptr<features::Regions>
-        regionsL = regions_provider->get(pair.first),
-        regionsR = regions_provider->get(pair.second);
+      const std::shared_ptr<features::Regions> regionsR = regions_provider->get(J);
 
+      if (bDepth_range && isPinhole(iterIntrinsicR->second->getType()))
+      {
+        // Search only the epipolar segment covering the scene depth range
+        geometry_aware::GuidedMatching_Fundamental_Segment
+          (
+            iterIntrinsicL->second.get(),
+            poseL,
+            *regionsL.get(),
+            iterIntrinsicR->second.get(),
+            poseR,
+            *regionsR.get(),
+            iterDepth->second.first, iterDepth->second.second,
+            Square(thresholdF), Square(0.8),
+            vec_corresponding_indexes
+          );
+      }
+      else
+      {
+        const Mat3 F_lr = F_from_P(P_L, P_R);
     #if defined(EXHAUSTIVE_MATCHING)
-      geometry_aware::GuidedMatching
-        <Mat3, openMVG::fundamental::kernel::EpipolarDistanceError>
-        (
-          F_lr,
-          iterIntrinsicL->second.get(),
-          *regionsL.get(),
-          iterIntrinsicR->second.get(),
-          *regionsR.get(),
-          Square(thresholdF), Square(0.8),
-          vec_corresponding_indexes
-        );
+        geometry_aware::GuidedMatching
+          <Mat3, openMVG::fundamental::kernel::EpipolarDistanceError>
+          (
+            F_lr,
+            iterIntrinsicL->second.get(),
+            *regionsL.get(),
+            iterIntrinsicR->second.get(),
+            *regionsR.get(),
+            Square(thresholdF), Square(0.8),
+            vec_corresponding_indexes
+          );
     #else
-      const Vec3 epipole2  = epipole_from_P(P_R, poseL);
-
-      geometry_aware::GuidedMatching_Fundamental_Fast
-        <openMVG::fundamental::kernel::EpipolarDistanceError>
-        (
-          F_lr,
-          epipole2,
-          iterIntrinsicL->second.get(),
-          *regionsL.get(),
-          iterIntrinsicR->second.get(),
-          *regionsR.get(),
-          iterIntrinsicR->second->w(), iterIntrinsicR->second->h(),
-          Square(thresholdF), Square(0.8),
-          vec_corresponding_indexes
-        );
-  #endif
+        const Vec3 epipole2  = epipole_from_P(P_R, poseL);
+
+        geometry_aware::GuidedMatching_Fundamental_Fast
+          <openMVG::fundamental::kernel::EpipolarDistanceError>
+          (
+            F_lr,
+            epipole2,
+            iterIntrinsicL->second.get(),
+            *regionsL.get(),
+            iterIntrinsicR->second.get(),
+            *regionsR.get(),
+            iterIntrinsicR->second->w(), iterIntrinsicR->second->h(),
+            Square(thresholdF), Square(0.8),
+            vec_corresponding_indexes
+          );
+    #endif
+      }
 
+      if (!vec_corresponding_indexes.empty())
+      {
   #ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
+        #pragma omp critical
   #endif // OPENMVG_USE_OPENMP
         {
-          putative_matches[pair].insert(putative_matches[pair].end(),
-            vec_corresponding_indexes.begin(), vec_corresponding_indexes.end());
+          putative_matches[{I, J}] = std::move(vec_corresponding_indexes);
         }
-        ++my_progress_bar;
       }
     }
   }
 }
 
-/// Filter inconsistent correspondences by using 3-view correspondences on view triplets
-void SfM_Data_Structure_Estimation_From_Known_Poses::filter(
-  const SfM_Data & sfm_data,
-  const Pair_Set & pairs,
-  const std::shared_ptr<Regions_Provider> & regions_provider)
+/// Link the 2-view correspondences as tracks and robustly triangulate the
+/// tracks seen by at least 3 views (discard spurious correspondences)
+void SfM_Data_Structure_Estimation_From_Known_Poses::triangulate(
+  SfM_Data & sfm_data,
+  const std::shared_ptr<Regions_Provider> & regions_provider,
+  const ETriangulationMethod triangulation_method)
 {
-  // Compute triplets
-  // Triangulate triplet tracks
-  //  - keep valid one
-
-  using Triplets = std::vector<graph::Triplet>;
-  const Triplets triplets = graph::TripletListing(pairs);
+  // A single track building over all the putative correspondences.
+  // Tracks with conflicting features (many features in one view) are removed.
+  openMVG::tracks::STLMAPTracks map_tracksCommon;
+  {
+    openMVG::tracks::TracksBuilder tracksBuilder;
+    tracksBuilder.Build(putative_matches);
+    tracksBuilder.Filter(3);
+    tracksBuilder.ExportToSTL(map_tracksCommon);
+  }
+  matching::PairWiseMatches().swap(putative_matches);
 
-  system::LoggerProgress my_progress_bar( triplets.size(),
-    "Per triplet tracks validation (discard spurious correspondences)" );
-#ifdef OPENMVG_USE_OPENMP
-  #pragma omp parallel
-#endif // OPENMVG_USE_OPENMP
-  for (Triplets::const_iterator it = triplets.begin(); it != triplets.end(); ++it)
+  // Fill the track observations view by view (one regions request per view)
+  std::vector<Observations> tracks_observations(map_tracksCommon.size());
   {
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-#endif // OPENMVG_USE_OPENMP
+    std::map<IndexT, std::vector<std::pair<size_t, IndexT>>> features_per_view;
+    size_t track_index = 0;
+    for (const auto & track_it : map_tracksCommon)
     {
-      ++my_progress_bar;
-
-      const graph::Triplet & triplet = *it;
-      const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-
-      openMVG::tracks::STLMAPTracks map_tracksCommon;
-      openMVG::tracks::TracksBuilder tracksBuilder;
+      for (const auto & track_obs : track_it.second)
       {
-        PairWiseMatches map_matchesIJK;
-        if (putative_matches.count({I,J}))
-          map_matchesIJK.insert(*putative_matches.find({I,J}));
-
-        if (putative_matches.count({I,K}))
-          map_matchesIJK.insert(*putative_matches.find({I,K}));
-
-        if (putative_matches.count({J,K}))
-          map_matchesIJK.insert(*putative_matches.find({J,K}));
-
-        if (map_matchesIJK.size() >= 2) {
-          tracksBuilder.Build(map_matchesIJK);
-          tracksBuilder.Filter(3);
-          tracksBuilder.ExportToSTL(map_tracksCommon);
-        }
-
-        const std::map<IndexT, std::shared_ptr<openMVG::features::Regions>> regions =
-        {{I, regions_provider->get(I)},
-         {J, regions_provider->get(J)},
-         {K, regions_provider->get(K)},
-        };
-
-        // Triangulate the tracks
-        for (const auto & track_it : map_tracksCommon)
-        {
-          const tracks::submapTrack & subTrack = track_it.second;
-          std::vector<Vec3> bearing;
-          std::vector<Mat34> poses;
-          bearing.reserve(subTrack.size());
-          poses.reserve(subTrack.size());
-          for (const auto & observation_it : subTrack) {
-            const size_t imaIndex = observation_it.first;
-            const size_t featIndex = observation_it.second;
-            const View * view = sfm_data.GetViews().at(imaIndex).get();
-            const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
-            const Pose3 pose = sfm_data.GetPoseOrDie(view);
-            const Vec2 pt = regions.at(imaIndex)->GetRegionPosition(featIndex);
-            bearing.emplace_back((*cam)(cam->get_ud_pixel(pt)));
-            poses.emplace_back(pose.asMatrix());
-          }
-          const Eigen::Map<const Mat3X> bearing_matrix(bearing[0].data(), 3, bearing.size());
-          Vec4 Xhomogeneous;
-          TriangulateNViewAlgebraic(bearing_matrix, poses, &Xhomogeneous);
-          const Vec3 X = Xhomogeneous.hnormalized();
-
-          // Test validity of the hypothesis:
-          // - residual error
-          // - cheirality
-          bool bCheirality = true;
-          bool bReprojection_error = true;
-          int i(0);
-          for (tracks::submapTrack::const_iterator obs_it = subTrack.begin();
-            obs_it != subTrack.end() && bCheirality && bReprojection_error; ++obs_it, ++i)
-          {
-            const View * view = sfm_data.views.at(obs_it->first).get();
-
-            const Pose3 pose = sfm_data.GetPoseOrDie(view);
-            bCheirality &= CheiralityTest(bearing[i], pose, X);
-
-            const size_t imaIndex = obs_it->first;
-            const size_t featIndex = obs_it->second;
-            const Vec2 pt = regions.at(imaIndex)->GetRegionPosition(featIndex);
-            const IntrinsicBase * cam = sfm_data.intrinsics.at(view->id_intrinsic).get();
-            const Vec2 residual = cam->residual(pose(X), pt);
-            bReprojection_error &= residual.squaredNorm() < max_reprojection_error_;
-          }
-          if (bCheirality && bReprojection_error)
-          // TODO: Add an angular check ?
-          {
-            #ifdef OPENMVG_USE_OPENMP
-            #pragma omp critical
-            #endif // OPENMVG_USE_OPENMP
-            {
-              openMVG::tracks::submapTrack::const_iterator iterI, iterJ, iterK;
-              iterI = iterJ = iterK = subTrack.begin();
-              std::advance(iterJ,1);
-              std::advance(iterK,2);
-
-              triplets_matches[{I,J}].emplace_back(iterI->second, iterJ->second);
-              triplets_matches[{J,K}].emplace_back(iterJ->second, iterK->second);
-            }
-          }
-        }
+        features_per_view[track_obs.first].emplace_back(track_index, track_obs.second);
+      }
+      ++track_index;
+    }
+    for (const auto & view_it : features_per_view)
+    {
+      const std::shared_ptr<features::Regions> regions = regions_provider->get(view_it.first);
+      for (const auto & feature_it : view_it.second)
+      {
+        const Vec2 pt = regions->GetRegionPosition(feature_it.second);
+        tracks_observations[feature_it.first][view_it.first] = Observation(pt, feature_it.second);
       }
     }
   }
-  // Clear putatives matches since they are no longer required
-  matching::PairWiseMatches().swap(putative_matches);
-}
-
-/// Init & triangulate landmark observations from the fused validated 3-view correspondences
-void SfM_Data_Structure_Estimation_From_Known_Poses::triangulate(
-  SfM_Data & sfm_data,
-  const std::shared_ptr<Regions_Provider> & regions_provider,
-  const ETriangulationMethod triangulation_method)
-{
-  openMVG::tracks::STLMAPTracks map_tracksCommon;
-  openMVG::tracks::TracksBuilder tracksBuilder;
-  tracksBuilder.Build(triplets_matches);
-  tracksBuilder.Filter(3);
-  tracksBuilder.ExportToSTL(map_tracksCommon);
-  matching::PairWiseMatches().swap(triplets_matches);
+  std::vector<IndexT> track_ids;
+  track_ids.reserve(map_tracksCommon.size());
+  for (const auto & track_it : map_tracksCommon)
+    track_ids.push_back(track_it.first);
+  openMVG::tracks::STLMAPTracks().swap(map_tracksCommon);
 
   // Generate new Structure tracks
   sfm_data.structure.clear();
@@ -319,38 +269,23 @@ void SfM_Data_Structure_Estimation_From_Known_Poses::triangulate(
     min_required_inliers,
     min_sample_index,
     triangulation_method);
-  system::LoggerProgress my_progress_bar( map_tracksCommon.size(),
+  system::LoggerProgress my_progress_bar( track_ids.size(),
     "Tracks to structure conversion:" );
-  // Fill sfm_data with the computed tracks (no 3D yet)
+  // Fill sfm_data with the triangulated tracks
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp parallel for schedule(dynamic)
 #endif // OPENMVG_USE_OPENMP
-  for (int i = 0; i < map_tracksCommon.size(); ++i)
+  for (int i = 0; i < static_cast<int>(track_ids.size()); ++i)
   {
     ++my_progress_bar;
 
-    tracks::STLMAPTracks::const_iterator itTracks = map_tracksCommon.begin();
-    std::advance(itTracks, i);
+    Landmark landmark;
+    if (structure_estimator.robust_triangulation(sfm_data, tracks_observations[i], landmark))
+    #ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+    #endif // OPENMVG_USE_OPENMP
     {
-      const tracks::submapTrack & track = itTracks->second;
-
-      Observations obs;
-      for (const auto & track_obs : track)
-      {
-        const IndexT imaIndex = track_obs.first;
-        const IndexT featIndex = track_obs.second;
-        const std::shared_ptr<features::Regions> regions = regions_provider->get(imaIndex);
-        const Vec2 pt = regions->GetRegionPosition(featIndex);
-        obs[imaIndex] = Observation(pt, featIndex);
-      }
-      Landmark landmark;
-      if (structure_estimator.robust_triangulation(sfm_data, obs, landmark))
-      #ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
-      #endif // OPENMVG_USE_OPENMP
-      {
-        sfm_data.structure[itTracks->first] = landmark;
-      }
+      sfm_data.structure[track_ids[i]] = std::move(landmark);
     }
   }
 }
@@ -13,6 +13,7 @@
 
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/multiview/triangulation_method.hpp"
+#include "openMVG/sfm/sfm_data_filters_frustum.hpp"
 
 namespace openMVG { namespace sfm { struct Regions_Provider; } }
 namespace openMVG { namespace sfm { struct SfM_Data; } }
@@ -24,9 +25,13 @@ class SfM_Data_Structure_Estimation_From_Known_Poses
 {
 public:
 
+  /// If a valid depth range is given for a view, the guided matching of the
+  /// pairs starting from this view only searches the epipolar segment
+  /// covering this depth range. The whole epipolar line is searched otherwise.
   explicit SfM_Data_Structure_Estimation_From_Known_Poses
   (
-    double max_reprojection_error // pixels
+    double max_reprojection_error, // pixels
+    const Frustum_Filter::NearFarPlanesT & depth_ranges = {} // near & far depth per view
   );
 
 
@@ -45,13 +50,8 @@ private:
     const Pair_Set & pairs,
     const std::shared_ptr<Regions_Provider> & regions_provider);
 
-  /// Filter inconsistent correspondences by using 3-view correspondences on view triplets
-  void filter(
-    const SfM_Data & sfm_data,
-    const Pair_Set & pairs,
-    const std::shared_ptr<Regions_Provider> & regions_provider);
-
-  /// Init & triangulate landmark observations from the fused validated 3-view correspondences
+  /// Link the 2-view correspondences as tracks and robustly triangulate the
+  /// tracks seen by at least 3 views (discard spurious correspondences)
   void triangulate(
     SfM_Data & sfm_data,
     const std::shared_ptr<Regions_Provider> & regions_provider,
@@ -62,8 +62,8 @@ private:
   // DATA (temporary)
   //--
   matching::PairWiseMatches putative_matches;
-  matching::PairWiseMatches triplets_matches;
   double max_reprojection_error_;
+  Frustum_Filter::NearFarPlanesT depth_ranges_;
 };
 
 } // namespace sfm
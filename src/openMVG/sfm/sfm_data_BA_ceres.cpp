@@ -21,16 +21,23 @@
 //- Robust estimation - LMeds (since no threshold can be defined)
 #include "openMVG/robust_estimation/robust_estimator_LMeds.hpp"
 #include "openMVG/sfm/sfm_data_BA_ceres_camera_functor.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_camera_functor_analytic.hpp"
+#include "openMVG/sfm/sfm_data_BA_partition.hpp"
 #include "openMVG/sfm/sfm_data_transform.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
 #include "openMVG/types.hpp"
 
 #include <ceres/rotation.h>
 #include <ceres/types.h>
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <limits>
+#include <numeric>
+#include <set>
 
 namespace openMVG {
 namespace sfm {
@@ -42,6 +49,9 @@ using namespace openMVG::geometry;
 
 const double PI = 4.0 * atan( 1.0 ), RADTODEG = 180.0 / PI;
 
+template <typename T, int row_stride, int col_stride>
+void getAngles(const ceres::MatrixAdapter<const T, row_stride, col_stride>& R, T* euler);
+
 template <typename T>
 void getAngles(const T* R, T* euler) {
   getAngles(ceres::ColumnMajorAdapter3x3(R), euler);
@@ -174,9 +184,31 @@ ceres::CostFunction * IntrinsicsToCostFunction
 (
   IntrinsicBase * intrinsic,
   const Vec2 & observation,
-  const double weight
+  const double weight,
+  const bool use_analytic_jacobian
 )
 {
+  if (use_analytic_jacobian)
+  {
+    switch (intrinsic->getType())
+    {
+      case PINHOLE_CAMERA:
+        return new analytic::ResidualErrorCostFunction_Pinhole_Intrinsic(observation, weight);
+      case PINHOLE_CAMERA_RADIAL1:
+        return new analytic::ResidualErrorCostFunction_Pinhole_Intrinsic_Radial_K1(observation, weight);
+      case PINHOLE_CAMERA_RADIAL3:
+        return new analytic::ResidualErrorCostFunction_Pinhole_Intrinsic_Radial_K3(observation, weight);
+      case PINHOLE_CAMERA_BROWN:
+        return new analytic::ResidualErrorCostFunction_Pinhole_Intrinsic_Brown_T2(observation, weight);
+      case PINHOLE_CAMERA_FISHEYE:
+        return new analytic::ResidualErrorCostFunction_Pinhole_Intrinsic_Fisheye(observation, weight);
+      case CAMERA_SPHERICAL:
+        return new analytic::ResidualErrorCostFunction_Spherical(intrinsic, observation, weight);
+      default:
+        return {};
+    }
+  }
+
   switch (intrinsic->getType())
   {
     case PINHOLE_CAMERA:
@@ -206,6 +238,7 @@ Bundle_Adjustment_Ceres::BA_Ceres_options::BA_Ceres_options
   parameter_tolerance_(1e-8),
   gradient_tolerance_(1e-10),
   bUse_loss_function_(true),
+  bUse_analytic_jacobians_(false),
   max_num_iterations_(50),
   max_linear_solver_iterations_(500)
 {
@@ -238,6 +271,160 @@ Bundle_Adjustment_Ceres::BA_Ceres_options::BA_Ceres_options
 }
 
 
+namespace {
+
+/// Configure a Ceres solver from the openMVG BA options
+ceres::Solver::Options ToCeresSolverOptions
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ba_options
+)
+{
+  //  Make Ceres automatically detect the bundle structure.
+  ceres::Solver::Options ceres_config_options;
+  ceres_config_options.max_num_iterations = ba_options.max_num_iterations_;
+  ceres_config_options.max_linear_solver_iterations = ba_options.max_linear_solver_iterations_;
+  ceres_config_options.preconditioner_type =
+    static_cast<ceres::PreconditionerType>(ba_options.preconditioner_type_);
+  ceres_config_options.linear_solver_type =
+    static_cast<ceres::LinearSolverType>(ba_options.linear_solver_type_);
+  ceres_config_options.sparse_linear_algebra_library_type =
+    static_cast<ceres::SparseLinearAlgebraLibraryType>(ba_options.sparse_linear_algebra_library_type_);
+  ceres_config_options.minimizer_progress_to_stdout = ba_options.bVerbose_;
+  ceres_config_options.logging_type = ceres::SILENT;
+  ceres_config_options.num_threads = ba_options.nb_threads_;
+#if CERES_VERSION_MAJOR < 2
+  ceres_config_options.num_linear_solver_threads = ba_options.nb_threads_;
+#endif
+  ceres_config_options.parameter_tolerance = ba_options.parameter_tolerance_;
+  ceres_config_options.gradient_tolerance = ba_options.gradient_tolerance_;
+  return ceres_config_options;
+}
+
+/// Export a pose as a [angleAxis, translation] parameter block
+void PoseToParameterBlock(const Pose3 & pose, double * parameter_block)
+{
+  const Mat3 R = pose.rotation();
+  const Vec3 t = pose.translation();
+  ceres::RotationMatrixToAngleAxis((const double*)R.data(), parameter_block);
+  parameter_block[3] = t(0);
+  parameter_block[4] = t(1);
+  parameter_block[5] = t(2);
+}
+
+/// Update a pose from a refined [angleAxis, translation] parameter block
+void UpdatePoseFromParameterBlock
+(
+  const double * parameter_block,
+  const Extrinsic_Parameter_Type extrinsics_opt,
+  Pose3 & pose
+)
+{
+  Mat3 R_refined;
+  ceres::AngleAxisToRotationMatrix(parameter_block, R_refined.data());
+  const Vec3 t_refined(parameter_block[3], parameter_block[4], parameter_block[5]);
+  if (extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
+  {
+      // Update only rotation
+      pose.rotation() = R_refined;
+  }
+  else if (extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
+  {
+      // Update only translation
+      const Vec3 C_refined = -R_refined.transpose() * t_refined;
+      pose.center() = C_refined;
+  }
+  else
+  {
+      // Update rotation + translation
+      pose = Pose3(R_refined, -R_refined.transpose() * t_refined);
+  }
+}
+
+/// Set a subset parametrization to a parameter block
+void SetSubsetParameterization
+(
+  ceres::Problem & problem,
+  double * parameter_block,
+  const int block_size,
+  const std::vector<int> & constant_parameters
+)
+{
+#if OPENMVG_CERES_HAS_MANIFOLD
+  auto* subset_manifold = new ceres::SubsetManifold(block_size, constant_parameters);
+  problem.SetManifold(parameter_block, subset_manifold);
+#else
+  auto *subset_parameterization =
+    new ceres::SubsetParameterization(block_size, constant_parameters);
+  problem.SetParameterization(parameter_block, subset_parameterization);
+#endif
+}
+
+/// Add a pose parameter block and configure which part of it is refined
+void AddPoseParameterBlock
+(
+  ceres::Problem & problem,
+  double * parameter_block,
+  const Extrinsic_Parameter_Type extrinsics_opt
+)
+{
+  problem.AddParameterBlock(parameter_block, 6);
+  if (extrinsics_opt == Extrinsic_Parameter_Type::NONE)
+  {
+    // set the whole parameter block as constant for best performance
+    problem.SetParameterBlockConstant(parameter_block);
+  }
+  else  // Subset parametrization
+  {
+    std::vector<int> vec_constant_extrinsic;
+    // If we adjust only the translation, we must set ROTATION as constant
+    if (extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
+    {
+      // Subset rotation parametrization
+      vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {0,1,2});
+    }
+    // If we adjust only the rotation, we must set TRANSLATION as constant
+    if (extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
+    {
+      // Subset translation parametrization
+      vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {3,4,5});
+    }
+    if (!vec_constant_extrinsic.empty())
+    {
+      SetSubsetParameterization(problem, parameter_block, 6, vec_constant_extrinsic);
+    }
+  }
+}
+
+/// Add an intrinsic parameter block and configure which part of it is refined
+void AddIntrinsicParameterBlock
+(
+  ceres::Problem & problem,
+  std::vector<double> & parameter_block,
+  const IntrinsicBase & intrinsic,
+  const Intrinsic_Parameter_Type intrinsics_opt
+)
+{
+  problem.AddParameterBlock(parameter_block.data(), parameter_block.size());
+  if (intrinsics_opt == Intrinsic_Parameter_Type::NONE)
+  {
+    // set the whole parameter block as constant for best performance
+    problem.SetParameterBlockConstant(parameter_block.data());
+  }
+  else
+  {
+    const std::vector<int> vec_constant_intrinsic =
+      intrinsic.subsetParameterization(intrinsics_opt);
+    if (!vec_constant_intrinsic.empty())
+    {
+      SetSubsetParameterization(problem, parameter_block.data(),
+        parameter_block.size(), vec_constant_intrinsic);
+    }
+  }
+}
+
+} // namespace
+
+
 Bundle_Adjustment_Ceres::Bundle_Adjustment_Ceres
 (
   const Bundle_Adjustment_Ceres::BA_Ceres_options & options
@@ -257,6 +444,7 @@ bool Bundle_Adjustment_Ceres::Adjust
   const Optimize_Options & options
 )
 {
+  OPENMVG_PROFILE_ZONE("Ceres");
   //----------
   // Add camera parameters
   // - intrinsics
@@ -322,9 +510,12 @@ bool Bundle_Adjustment_Ceres::Adjust
           std::sort(residual.data(), residual.data() + residual.size());
           pose_center_robust_fitting_error = residual(residual.size()/2);
 
-          Vec residual_R = (Eigen::Map<Mat2X>(R_SfM[0].data(), 2, R_SfM.size())- Eigen::Map<Mat2X>(R_GPS[0].data(), 2, R_GPS.size())).colwise().squaredNorm();  
-          std::sort(residual_R.data(), residual_R.data() + residual_R.size());
-          pose_rotation_robust_fitting_error = residual_R(residual_R.size()/2);
+          if (!R_GPS.empty())
+          {
+            Vec residual_R = (Eigen::Map<Mat2X>(R_SfM[0].data(), 2, R_SfM.size())- Eigen::Map<Mat2X>(R_GPS[0].data(), 2, R_GPS.size())).colwise().squaredNorm();
+            std::sort(residual_R.data(), residual_R.data() + residual_R.size());
+            pose_rotation_robust_fitting_error = residual_R(residual_R.size()/2);
+          }
 
           // Apply the found transformation to the SfM Data Scene
           openMVG::sfm::ApplySimilarity(sim, sfm_data);
@@ -368,49 +559,11 @@ bool Bundle_Adjustment_Ceres::Adjust
   {
     const IndexT indexPose = pose_it.first;
 
-    const Pose3 & pose = pose_it.second;
-    const Mat3 R = pose.rotation();
-    const Vec3 t = pose.translation();
-
-    double angleAxis[3];
-    ceres::RotationMatrixToAngleAxis((const double*)R.data(), angleAxis);
     // angleAxis + translation
-    map_poses[indexPose] = {angleAxis[0], angleAxis[1], angleAxis[2], t(0), t(1), t(2)};
-
-    double * parameter_block = &map_poses.at(indexPose)[0];
-    problem.AddParameterBlock(parameter_block, 6);
-    if (options.extrinsics_opt == Extrinsic_Parameter_Type::NONE)
-    {
-      // set the whole parameter block as constant for best performance
-      problem.SetParameterBlockConstant(parameter_block);
-    }
-    else  // Subset parametrization
-    {
-      std::vector<int> vec_constant_extrinsic;
-      // If we adjust only the translation, we must set ROTATION as constant
-      if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
-      {
-        // Subset rotation parametrization
-        vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {0,1,2});
-      }
-      // If we adjust only the rotation, we must set TRANSLATION as constant
-      if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
-      {
-        // Subset translation parametrization
-        vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {3,4,5});
-      }
-      if (!vec_constant_extrinsic.empty())
-      {
-#if OPENMVG_CERES_HAS_MANIFOLD
-        auto* subset_manifold = new ceres::SubsetManifold(6, vec_constant_extrinsic);
-        problem.SetManifold(parameter_block, subset_manifold);
-#else
-        auto *subset_parameterization =
-          new ceres::SubsetParameterization(6, vec_constant_extrinsic);
-        problem.SetParameterization(parameter_block, subset_parameterization);
-#endif
-      }
-    }
+    std::vector<double> & parameter_block = map_poses[indexPose];
+    parameter_block.resize(6);
+    PoseToParameterBlock(pose_it.second, parameter_block.data());
+    AddPoseParameterBlock(problem, parameter_block.data(), options.extrinsics_opt);
   }
 
   // Setup Intrinsics data & subparametrization
@@ -423,32 +576,8 @@ bool Bundle_Adjustment_Ceres::Adjust
       map_intrinsics[indexCam] = intrinsic_it.second->getParams();
       if (!map_intrinsics.at(indexCam).empty())
       {
-        double * parameter_block = &map_intrinsics.at(indexCam)[0];
-        problem.AddParameterBlock(parameter_block, map_intrinsics.at(indexCam).size());
-        if (options.intrinsics_opt == Intrinsic_Parameter_Type::NONE)
-        {
-          // set the whole parameter block as constant for best performance
-          problem.SetParameterBlockConstant(parameter_block);
-        }
-        else
-        {
-          const std::vector<int> vec_constant_intrinsic =
-            intrinsic_it.second->subsetParameterization(options.intrinsics_opt);
-          if (!vec_constant_intrinsic.empty())
-          {
-#if OPENMVG_CERES_HAS_MANIFOLD
-            auto* subset_manifold =
-              new ceres::SubsetManifold(
-                map_intrinsics.at(indexCam).size(), vec_constant_intrinsic);
-            problem.SetManifold(parameter_block, subset_manifold);
-#else
-            auto *subset_parameterization =
-              new ceres::SubsetParameterization(
-                map_intrinsics.at(indexCam).size(), vec_constant_intrinsic);
-            problem.SetParameterization(parameter_block, subset_parameterization);
-#endif
-          }
-        }
+        AddIntrinsicParameterBlock(problem, map_intrinsics.at(indexCam),
+          *intrinsic_it.second, options.intrinsics_opt);
       }
     }
     else
@@ -472,7 +601,9 @@ bool Bundle_Adjustment_Ceres::Adjust
       // image location and compares the reprojection against the observation.
       ceres::CostFunction* cost_function =
         IntrinsicsToCostFunction(sfm_data.intrinsics.at(view->id_intrinsic).get(),
-                                 obs_it.second.x);
+                                 obs_it.second.x,
+                                 0.0,
+                                 ceres_options_.bUse_analytic_jacobians_);
 
       if (cost_function)
       {
@@ -522,7 +653,8 @@ bool Bundle_Adjustment_Ceres::Adjust
           IntrinsicsToCostFunction(
             sfm_data.intrinsics.at(view->id_intrinsic).get(),
             obs_it.second.x,
-            options.control_point_opt.weight);
+            options.control_point_opt.weight,
+            ceres_options_.bUse_analytic_jacobians_);
 
         if (cost_function)
         {
@@ -595,25 +727,7 @@ bool Bundle_Adjustment_Ceres::Adjust
   }
 
   // Configure a BA engine and run it
-  //  Make Ceres automatically detect the bundle structure.
-  ceres::Solver::Options ceres_config_options;
-  ceres_config_options.max_num_iterations = ceres_options_.max_num_iterations_;
-  ceres_config_options.max_linear_solver_iterations = ceres_options_.max_linear_solver_iterations_;
-  ceres_config_options.preconditioner_type =
-    static_cast<ceres::PreconditionerType>(ceres_options_.preconditioner_type_);
-  ceres_config_options.linear_solver_type =
-    static_cast<ceres::LinearSolverType>(ceres_options_.linear_solver_type_);
-  ceres_config_options.sparse_linear_algebra_library_type =
-    static_cast<ceres::SparseLinearAlgebraLibraryType>(ceres_options_.sparse_linear_algebra_library_type_);
-  ceres_config_options.minimizer_progress_to_stdout = ceres_options_.bVerbose_;
-  ceres_config_options.logging_type = ceres::SILENT;
-  ceres_config_options.num_threads = ceres_options_.nb_threads_;
-#if CERES_VERSION_MAJOR < 2
-  ceres_config_options.num_linear_solver_threads = ceres_options_.nb_threads_;
-#endif
-  ceres_config_options.parameter_tolerance = ceres_options_.parameter_tolerance_;
-  ceres_config_options.gradient_tolerance = ceres_options_.gradient_tolerance_;
-
+  const ceres::Solver::Options ceres_config_options = ToCeresSolverOptions(ceres_options_);
 
   // Solve BA
   ceres::Solver::Summary summary;
@@ -651,29 +765,8 @@ bool Bundle_Adjustment_Ceres::Adjust
     {
       for (auto & pose_it : sfm_data.poses)
       {
-        const IndexT indexPose = pose_it.first;
-
-        Mat3 R_refined;
-        ceres::AngleAxisToRotationMatrix(&map_poses.at(indexPose)[0], R_refined.data());
-        Vec3 t_refined(map_poses.at(indexPose)[3], map_poses.at(indexPose)[4], map_poses.at(indexPose)[5]);
-        // Update the pose
-        Pose3 & pose = pose_it.second;
-        if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
-        {
-            // Update only rotation
-            pose.rotation() = R_refined;
-        }
-        else if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
-        {
-            // Update only translation
-            Vec3 C_refined = -R_refined.transpose() * t_refined;
-            pose.center() = C_refined;
-        }
-        else
-        {
-            // Update rotation + translation
-            pose = Pose3(R_refined, -R_refined.transpose() * t_refined);
-        }
+        UpdatePoseFromParameterBlock(&map_poses.at(pose_it.first)[0],
+          options.extrinsics_opt, pose_it.second);
       }
     }
 
@@ -756,5 +849,998 @@ bool Bundle_Adjustment_Ceres::Adjust
   }
 }
 
-} // namespace sfm pose_rotation_robust_fitting_error
+
+/// Parameter and residual blocks of the persistent bundle adjustment problem
+struct Bundle_Adjustment_Ceres_Session::Problem_Data
+{
+  /// Residual block of a landmark observation
+  struct Observation_Residual
+  {
+    ceres::ResidualBlockId residual_id;
+    // Observed position (referenced by the cost function)
+    Vec2 x;
+  };
+
+  struct Landmark_Block
+  {
+    std::array<double, 3> X;
+    Hash_Map<IndexT, Observation_Residual> residuals; // per view id
+  };
+
+  struct Intrinsic_Block
+  {
+    EINTRINSIC type;
+    std::vector<double> params;
+  };
+
+  explicit Problem_Data(const bool use_loss_function)
+  {
+    ceres::Problem::Options problem_options;
+    // Required to remove residual and parameter blocks efficiently
+    problem_options.enable_fast_removal = true;
+    if (use_loss_function)
+    {
+      loss_function.reset(new ceres::HuberLoss(Square(4.0)));
+      problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    }
+    problem.reset(new ceres::Problem(problem_options));
+  }
+
+  // Declared first to be destroyed after the problem
+  std::unique_ptr<ceres::LossFunction> loss_function;
+  std::unique_ptr<ceres::Problem> problem;
+  // The parameter blocks (node based containers keep their addresses valid)
+  Hash_Map<IndexT, std::array<double, 6>> poses;
+  Hash_Map<IndexT, Intrinsic_Block> intrinsics;
+  Hash_Map<IndexT, Landmark_Block> landmarks;
+};
+
+Bundle_Adjustment_Ceres_Session::Bundle_Adjustment_Ceres_Session
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const Optimize_Options & options
+)
+: ceres_options_(ceres_options),
+  options_(options)
+{
+  if (options_.use_motion_priors_opt || options_.control_point_opt.bUse_control_points)
+  {
+    OPENMVG_LOG_WARNING
+      << "Bundle_Adjustment_Ceres_Session: motion priors and control points are ignored.";
+  }
+}
+
+Bundle_Adjustment_Ceres_Session::~Bundle_Adjustment_Ceres_Session() = default;
+
+Bundle_Adjustment_Ceres::BA_Ceres_options &
+Bundle_Adjustment_Ceres_Session::ceres_options()
+{
+  return ceres_options_;
+}
+
+size_t Bundle_Adjustment_Ceres_Session::NumResidualBlocks() const
+{
+  return problem_data_ ? problem_data_->problem->NumResidualBlocks() : 0;
+}
+
+bool Bundle_Adjustment_Ceres_Session::Synchronize
+(
+  const SfM_Data & sfm_data
+)
+{
+  // An intrinsic changed of model: start from a new problem
+  if (problem_data_)
+  {
+    for (const auto & intrinsic_it : problem_data_->intrinsics)
+    {
+      const auto sfm_intrinsic_it = sfm_data.intrinsics.find(intrinsic_it.first);
+      if (sfm_intrinsic_it != sfm_data.intrinsics.end()
+          && sfm_intrinsic_it->second->getType() != intrinsic_it.second.type)
+      {
+        problem_data_.reset();
+        break;
+      }
+    }
+  }
+  if (!problem_data_)
+    problem_data_.reset(new Problem_Data(ceres_options_.bUse_loss_function_));
+
+  ceres::Problem & problem = *problem_data_->problem;
+
+  // Add the new intrinsics and refresh the values of the existing ones
+  for (const auto & intrinsic_it : sfm_data.intrinsics)
+  {
+    if (!isValid(intrinsic_it.second->getType()))
+    {
+      OPENMVG_LOG_ERROR << "Unsupported camera type.";
+      continue;
+    }
+    auto block_it = problem_data_->intrinsics.find(intrinsic_it.first);
+    if (block_it == problem_data_->intrinsics.end())
+    {
+      Problem_Data::Intrinsic_Block & block = problem_data_->intrinsics[intrinsic_it.first];
+      block.type = intrinsic_it.second->getType();
+      block.params = intrinsic_it.second->getParams();
+      if (!block.params.empty())
+      {
+        AddIntrinsicParameterBlock(problem, block.params,
+          *intrinsic_it.second, options_.intrinsics_opt);
+      }
+    }
+    else
+    {
+      const std::vector<double> params = intrinsic_it.second->getParams();
+      std::copy(params.cbegin(), params.cend(), block_it->second.params.begin());
+    }
+  }
+
+  // Add the new poses and refresh the values of the existing ones
+  for (const auto & pose_it : sfm_data.poses)
+  {
+    auto block_it = problem_data_->poses.find(pose_it.first);
+    if (block_it == problem_data_->poses.end())
+    {
+      std::array<double, 6> & block = problem_data_->poses[pose_it.first];
+      PoseToParameterBlock(pose_it.second, block.data());
+      AddPoseParameterBlock(problem, block.data(), options_.extrinsics_opt);
+    }
+    else
+    {
+      PoseToParameterBlock(pose_it.second, block_it->second.data());
+    }
+  }
+
+  // Tell if an observation can be used (its view has a pose and an intrinsic block)
+  const auto usable_view = [&](const View * view) -> bool
+  {
+    if (!sfm_data.IsPoseAndIntrinsicDefined(view))
+      return false;
+    return problem_data_->intrinsics.count(view->id_intrinsic) != 0;
+  };
+
+  // Remove the landmarks that are no longer in the scene
+  // (their residual blocks are removed along with the parameter block)
+  for (auto landmark_it = problem_data_->landmarks.begin();
+       landmark_it != problem_data_->landmarks.end(); )
+  {
+    if (sfm_data.structure.count(landmark_it->first) == 0)
+    {
+      problem.RemoveParameterBlock(landmark_it->second.X.data());
+      landmark_it = problem_data_->landmarks.erase(landmark_it);
+    }
+    else
+      ++landmark_it;
+  }
+
+  // Synchronize the landmark observations
+  for (const auto & structure_landmark_it : sfm_data.structure)
+  {
+    const Landmark & landmark = structure_landmark_it.second;
+    const Observations & obs = landmark.obs;
+
+    auto block_it = problem_data_->landmarks.find(structure_landmark_it.first);
+    const bool b_new_landmark = (block_it == problem_data_->landmarks.end());
+    Problem_Data::Landmark_Block & block = b_new_landmark ?
+      problem_data_->landmarks[structure_landmark_it.first] : block_it->second;
+    std::copy(landmark.X.data(), landmark.X.data() + 3, block.X.begin());
+
+    if (b_new_landmark)
+    {
+      problem.AddParameterBlock(block.X.data(), 3);
+      if (options_.structure_opt == Structure_Parameter_Type::NONE)
+        problem.SetParameterBlockConstant(block.X.data());
+    }
+    else
+    {
+      // Remove the residuals of the removed (or updated) observations
+      for (auto residual_it = block.residuals.begin();
+           residual_it != block.residuals.end(); )
+      {
+        const auto obs_it = obs.find(residual_it->first);
+        if (obs_it == obs.end()
+            || obs_it->second.x != residual_it->second.x
+            || !usable_view(sfm_data.views.at(residual_it->first).get()))
+        {
+          problem.RemoveResidualBlock(residual_it->second.residual_id);
+          residual_it = block.residuals.erase(residual_it);
+        }
+        else
+          ++residual_it;
+      }
+    }
+
+    // Add the residuals of the new observations
+    for (const auto & obs_it : obs)
+    {
+      if (block.residuals.count(obs_it.first) != 0)
+        continue;
+
+      const View * view = sfm_data.views.at(obs_it.first).get();
+      if (!usable_view(view))
+        continue;
+
+      // The cost function keeps a reference to the observed position:
+      //  it is stored along the residual block to outlive scene updates.
+      Problem_Data::Observation_Residual & residual = block.residuals[obs_it.first];
+      residual.x = obs_it.second.x;
+      ceres::CostFunction* cost_function =
+        IntrinsicsToCostFunction(sfm_data.intrinsics.at(view->id_intrinsic).get(),
+                                 residual.x,
+                                 0.0,
+                                 ceres_options_.bUse_analytic_jacobians_);
+      if (!cost_function)
+      {
+        block.residuals.erase(obs_it.first);
+        OPENMVG_LOG_ERROR << "Cannot create a CostFunction for this camera model.";
+        return false;
+      }
+
+      std::vector<double> & intrinsic_params =
+        problem_data_->intrinsics.at(view->id_intrinsic).params;
+      double * pose_block = problem_data_->poses.at(view->id_pose).data();
+      residual.residual_id = intrinsic_params.empty() ?
+        problem.AddResidualBlock(cost_function,
+          problem_data_->loss_function.get(),
+          pose_block,
+          block.X.data())
+        : problem.AddResidualBlock(cost_function,
+          problem_data_->loss_function.get(),
+          intrinsic_params.data(),
+          pose_block,
+          block.X.data());
+    }
+  }
+
+  // Remove the poses and intrinsics that are no longer in the scene
+  // (no residual block depends on them anymore)
+  for (auto pose_it = problem_data_->poses.begin(); pose_it != problem_data_->poses.end(); )
+  {
+    if (sfm_data.poses.count(pose_it->first) == 0)
+    {
+      problem.RemoveParameterBlock(pose_it->second.data());
+      pose_it = problem_data_->poses.erase(pose_it);
+    }
+    else
+      ++pose_it;
+  }
+  for (auto intrinsic_it = problem_data_->intrinsics.begin();
+       intrinsic_it != problem_data_->intrinsics.end(); )
+  {
+    if (sfm_data.intrinsics.count(intrinsic_it->first) == 0)
+    {
+      if (!intrinsic_it->second.params.empty())
+        problem.RemoveParameterBlock(intrinsic_it->second.params.data());
+      intrinsic_it = problem_data_->intrinsics.erase(intrinsic_it);
+    }
+    else
+      ++intrinsic_it;
+  }
+  return true;
+}
+
+bool Bundle_Adjustment_Ceres_Session::Adjust
+(
+  SfM_Data & sfm_data
+)
+{
+  OPENMVG_PROFILE_ZONE("CeresSession");
+  if (!Synchronize(sfm_data))
+    return false;
+
+  // Solve BA
+  ceres::Solver::Summary summary;
+  ceres::Solve(ToCeresSolverOptions(ceres_options_), problem_data_->problem.get(), &summary);
+  if (ceres_options_.bCeres_summary_)
+    OPENMVG_LOG_INFO << summary.FullReport();
+
+  if (!summary.IsSolutionUsable())
+  {
+    OPENMVG_LOG_ERROR << "IsSolutionUsable is false. Bundle Adjustment failed.";
+    return false;
+  }
+
+  if (ceres_options_.bVerbose_)
+  {
+    // Display statistics about the minimization
+    OPENMVG_LOG_INFO
+      << "\nBundle Adjustment statistics (approximated RMSE):\n"
+      << " #views: " << sfm_data.views.size() << "\n"
+      << " #poses: " << sfm_data.poses.size() << "\n"
+      << " #intrinsics: " << sfm_data.intrinsics.size() << "\n"
+      << " #tracks: " << sfm_data.structure.size() << "\n"
+      << " #residuals: " << summary.num_residuals << "\n"
+      << " Initial RMSE: " << std::sqrt( summary.initial_cost / summary.num_residuals) << "\n"
+      << " Final RMSE: " << std::sqrt( summary.final_cost / summary.num_residuals) << "\n"
+      << " Time (s): " << summary.total_time_in_seconds;
+  }
+
+  // Write back the refined parameters
+  if (options_.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+  {
+    for (auto & pose_it : sfm_data.poses)
+    {
+      UpdatePoseFromParameterBlock(problem_data_->poses.at(pose_it.first).data(),
+        options_.extrinsics_opt, pose_it.second);
+    }
+  }
+  if (options_.intrinsics_opt != Intrinsic_Parameter_Type::NONE)
+  {
+    for (auto & intrinsic_it : sfm_data.intrinsics)
+    {
+      const auto block_it = problem_data_->intrinsics.find(intrinsic_it.first);
+      if (block_it != problem_data_->intrinsics.end())
+        intrinsic_it.second->updateFromParams(block_it->second.params);
+    }
+  }
+  if (options_.structure_opt != Structure_Parameter_Type::NONE)
+  {
+    for (auto & structure_landmark_it : sfm_data.structure)
+    {
+      const std::array<double, 3> & X =
+        problem_data_->landmarks.at(structure_landmark_it.first).X;
+      structure_landmark_it.second.X = Vec3(X[0], X[1], X[2]);
+    }
+  }
+  return true;
+}
+
+//--
+// Partitioned bundle adjustment
+//--
+
+namespace {
+
+/// Consensus penalty of a separator copy: residuals = scale .* (x - target)
+class ConsensusCostFunction : public ceres::CostFunction
+{
+public:
+  ConsensusCostFunction
+  (
+    const std::vector<double> & target,
+    const std::vector<double> & scale
+  ):
+    target_(target),
+    scale_(scale)
+  {
+    set_num_residuals(static_cast<int>(target_.size()));
+    mutable_parameter_block_sizes()->push_back(static_cast<int>(target_.size()));
+  }
+
+  bool Evaluate
+  (
+    double const * const * parameters,
+    double * residuals,
+    double ** jacobians
+  ) const override
+  {
+    const int size = static_cast<int>(target_.size());
+    for (int i = 0; i < size; ++i)
+      residuals[i] = scale_[i] * (parameters[0][i] - target_[i]);
+    if (jacobians && jacobians[0])
+    {
+      std::fill(jacobians[0], jacobians[0] + size * size, 0.0);
+      for (int i = 0; i < size; ++i)
+        jacobians[0][i * size + i] = scale_[i];
+    }
+    return true;
+  }
+
+private:
+  const std::vector<double> target_;
+  const std::vector<double> scale_;
+};
+
+/// A variable shared by several clusters, and the ADMM state of its copies
+struct Consensus_Variable
+{
+  std::vector<size_t> clusters; // Sorted ids of the clusters holding a copy
+  std::vector<double> scale; // Scale of each parameter (to pixels)
+  std::vector<std::vector<double>> local; // Last refined value of each copy
+  std::vector<std::vector<double>> dual; // Scaled dual variable of each copy
+
+  size_t Slot(const size_t cluster_id) const
+  {
+    return std::lower_bound(clusters.cbegin(), clusters.cend(), cluster_id)
+      - clusters.cbegin();
+  }
+};
+
+struct Consensus_Data
+{
+  Hash_Map<IndexT, Consensus_Variable> poses;
+  Hash_Map<IndexT, Consensus_Variable> intrinsics;
+  Hash_Map<IndexT, Consensus_Variable> landmarks;
+};
+
+/// Add the consensus penalty of a separator copy to a cluster problem:
+///  the copy is pulled toward (consensus value - dual)
+void AddConsensusResidual
+(
+  ceres::Problem & problem,
+  const Consensus_Variable & variable,
+  const size_t cluster_id,
+  const double * consensus_value,
+  const double penalty_weight,
+  double * parameter_block
+)
+{
+  const std::vector<double> & dual = variable.dual[variable.Slot(cluster_id)];
+  std::vector<double> target(dual.size()), scale(dual.size());
+  for (size_t i = 0; i < dual.size(); ++i)
+  {
+    target[i] = consensus_value[i] - dual[i];
+    scale[i] = std::sqrt(penalty_weight) * variable.scale[i];
+  }
+  problem.AddResidualBlock(new ConsensusCostFunction(target, scale),
+    nullptr, parameter_block);
+}
+
+/// ADMM residuals of a consensus update (in pixels)
+struct Consensus_Residuals
+{
+  double primal_squared = 0.0; // Sum of the squared copy/consensus differences
+  double dual_squared = 0.0; // Sum of the squared consensus value changes
+  double max_disagreement = 0.0; // Largest copy/consensus difference
+};
+
+/// Update the consensus value of a separator as the average of its dual
+///  corrected copies, then update the duals.
+/// @param[in,out] consensus_value The previous, then the updated consensus value
+void UpdateConsensus
+(
+  Consensus_Variable & variable,
+  std::vector<double> & consensus_value,
+  Consensus_Residuals & residuals
+)
+{
+  const size_t size = consensus_value.size();
+  const std::vector<double> previous_value = consensus_value;
+  std::fill(consensus_value.begin(), consensus_value.end(), 0.0);
+  for (size_t slot = 0; slot < variable.clusters.size(); ++slot)
+  {
+    for (size_t i = 0; i < size; ++i)
+      consensus_value[i] += variable.local[slot][i] + variable.dual[slot][i];
+  }
+  for (double & value : consensus_value)
+    value /= variable.clusters.size();
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    residuals.dual_squared += variable.clusters.size()
+      * Square(variable.scale[i] * (consensus_value[i] - previous_value[i]));
+  }
+  for (size_t slot = 0; slot < variable.clusters.size(); ++slot)
+  {
+    double disagreement = 0.0;
+    for (size_t i = 0; i < size; ++i)
+    {
+      const double difference = variable.local[slot][i] - consensus_value[i];
+      variable.dual[slot][i] += difference;
+      disagreement += Square(variable.scale[i] * difference);
+    }
+    residuals.primal_squared += disagreement;
+    residuals.max_disagreement = std::max(residuals.max_disagreement, std::sqrt(disagreement));
+  }
+}
+
+/// Scale the scaled dual variables after a penalty weight change
+void ScaleDuals
+(
+  Hash_Map<IndexT, Consensus_Variable> & variables,
+  const double factor
+)
+{
+  for (auto & variable_it : variables)
+    for (auto & dual : variable_it.second.dual)
+      for (double & value : dual)
+        value *= factor;
+}
+
+/// Refine a cluster of the scene:
+/// - its poses, the intrinsics they use, and the landmarks they observe are
+///   copied in a Ceres problem along with their observations,
+/// - separator copies are pulled toward their consensus values,
+/// - refined non separator values are written back into the scene, refined
+///   separator values are stored as the cluster copies.
+bool SolveCluster
+(
+  SfM_Data & sfm_data,
+  const size_t cluster_id,
+  const std::set<IndexT> & cluster_poses,
+  const std::vector<IndexT> & cluster_landmarks,
+  Consensus_Data & consensus,
+  const double penalty_weight,
+  const Optimize_Options & options,
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  double & final_cost,
+  size_t & num_residuals
+)
+{
+  ceres::Problem::Options problem_options;
+  std::unique_ptr<ceres::LossFunction> loss_function;
+  if (ceres_options.bUse_loss_function_)
+  {
+    loss_function.reset(new ceres::HuberLoss(Square(4.0)));
+    problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  }
+  ceres::Problem problem(problem_options);
+
+  // Local copies of the cluster parameters
+  Hash_Map<IndexT, std::array<double, 6>> poses;
+  Hash_Map<IndexT, std::vector<double>> intrinsics;
+  Hash_Map<IndexT, std::array<double, 3>> landmarks;
+
+  for (const IndexT pose_id : cluster_poses)
+  {
+    std::array<double, 6> & block = poses[pose_id];
+    PoseToParameterBlock(sfm_data.poses.at(pose_id), block.data());
+    AddPoseParameterBlock(problem, block.data(), options.extrinsics_opt);
+    const auto separator_it = consensus.poses.find(pose_id);
+    if (separator_it != consensus.poses.end())
+    {
+      const std::array<double, 6> consensus_value = block;
+      AddConsensusResidual(problem, separator_it->second, cluster_id,
+        consensus_value.data(), penalty_weight, block.data());
+    }
+  }
+
+  for (const auto & view_it : sfm_data.views)
+  {
+    const View * view = view_it.second.get();
+    if (!cluster_poses.count(view->id_pose)
+        || intrinsics.count(view->id_intrinsic)
+        || !sfm_data.IsPoseAndIntrinsicDefined(view))
+      continue;
+    const IntrinsicBase * intrinsic = sfm_data.intrinsics.at(view->id_intrinsic).get();
+    if (!isValid(intrinsic->getType()))
+      continue;
+    std::vector<double> & block = intrinsics[view->id_intrinsic];
+    block = intrinsic->getParams();
+    if (block.empty())
+      continue;
+    AddIntrinsicParameterBlock(problem, block, *intrinsic, options.intrinsics_opt);
+    const auto separator_it = consensus.intrinsics.find(view->id_intrinsic);
+    if (separator_it != consensus.intrinsics.end())
+    {
+      const std::vector<double> consensus_value = block;
+      AddConsensusResidual(problem, separator_it->second, cluster_id,
+        consensus_value.data(), penalty_weight, block.data());
+    }
+  }
+
+  for (const IndexT landmark_id : cluster_landmarks)
+  {
+    Landmark & landmark = sfm_data.structure.at(landmark_id);
+    std::array<double, 3> & block = landmarks[landmark_id];
+    std::copy(landmark.X.data(), landmark.X.data() + 3, block.begin());
+    bool b_observed = false;
+    for (const auto & obs_it : landmark.obs)
+    {
+      const View * view = sfm_data.views.at(obs_it.first).get();
+      const auto intrinsic_it = intrinsics.find(view->id_intrinsic);
+      if (!cluster_poses.count(view->id_pose) || intrinsic_it == intrinsics.end())
+        continue;
+
+      ceres::CostFunction * cost_function =
+        IntrinsicsToCostFunction(sfm_data.intrinsics.at(view->id_intrinsic).get(),
+                                 obs_it.second.x,
+                                 0.0,
+                                 ceres_options.bUse_analytic_jacobians_);
+      if (!cost_function)
+        continue;
+      if (!intrinsic_it->second.empty())
+      {
+        problem.AddResidualBlock(cost_function,
+          loss_function.get(),
+          intrinsic_it->second.data(),
+          poses.at(view->id_pose).data(),
+          block.data());
+      }
+      else
+      {
+        problem.AddResidualBlock(cost_function,
+          loss_function.get(),
+          poses.at(view->id_pose).data(),
+          block.data());
+      }
+      b_observed = true;
+    }
+    const auto separator_it = consensus.landmarks.find(landmark_id);
+    if (!b_observed)
+    {
+      // Keep the copy on the consensus value
+      if (separator_it != consensus.landmarks.end())
+      {
+        Consensus_Variable & variable = separator_it->second;
+        variable.local[variable.Slot(cluster_id)].assign(block.cbegin(), block.cend());
+      }
+      landmarks.erase(landmark_id);
+      continue;
+    }
+    if (options.structure_opt == Structure_Parameter_Type::NONE)
+      problem.SetParameterBlockConstant(block.data());
+    if (separator_it != consensus.landmarks.end())
+    {
+      AddConsensusResidual(problem, separator_it->second, cluster_id,
+        landmark.X.data(), penalty_weight, block.data());
+    }
+  }
+
+  ceres::Solver::Summary summary;
+  ceres::Solve(ToCeresSolverOptions(ceres_options), &problem, &summary);
+  if (ceres_options.bCeres_summary_)
+    OPENMVG_LOG_INFO << summary.FullReport();
+  if (!summary.IsSolutionUsable())
+    return false;
+  final_cost = summary.final_cost;
+  num_residuals = summary.num_residuals;
+
+  // Store the cluster copies of the separators, update the other variables
+  // (they are only refined by this cluster)
+  for (auto & pose_it : poses)
+  {
+    const auto separator_it = consensus.poses.find(pose_it.first);
+    if (separator_it != consensus.poses.end())
+    {
+      Consensus_Variable & variable = separator_it->second;
+      variable.local[variable.Slot(cluster_id)].assign(pose_it.second.cbegin(), pose_it.second.cend());
+    }
+    else if (options.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+    {
+      UpdatePoseFromParameterBlock(pose_it.second.data(), options.extrinsics_opt,
+        sfm_data.poses.at(pose_it.first));
+    }
+  }
+  for (auto & intrinsic_it : intrinsics)
+  {
+    const auto separator_it = consensus.intrinsics.find(intrinsic_it.first);
+    if (separator_it != consensus.intrinsics.end())
+    {
+      Consensus_Variable & variable = separator_it->second;
+      variable.local[variable.Slot(cluster_id)] = intrinsic_it.second;
+    }
+    else if (options.intrinsics_opt != Intrinsic_Parameter_Type::NONE
+             && !intrinsic_it.second.empty())
+    {
+      sfm_data.intrinsics.at(intrinsic_it.first)->updateFromParams(intrinsic_it.second);
+    }
+  }
+  for (auto & landmark_it : landmarks)
+  {
+    const auto separator_it = consensus.landmarks.find(landmark_it.first);
+    if (separator_it != consensus.landmarks.end())
+    {
+      Consensus_Variable & variable = separator_it->second;
+      variable.local[variable.Slot(cluster_id)].assign(landmark_it.second.cbegin(), landmark_it.second.cend());
+    }
+    else if (options.structure_opt != Structure_Parameter_Type::NONE)
+    {
+      sfm_data.structure.at(landmark_it.first).X =
+        Vec3(landmark_it.second[0], landmark_it.second[1], landmark_it.second[2]);
+    }
+  }
+  return true;
+}
+
+/// Initialize a consensus variable shared by the given clusters
+void InitConsensusVariable
+(
+  Consensus_Variable & variable,
+  const std::set<size_t> & clusters,
+  const std::vector<double> & value,
+  std::vector<double> scale
+)
+{
+  variable.clusters.assign(clusters.cbegin(), clusters.cend());
+  variable.scale = std::move(scale);
+  variable.local.assign(clusters.size(), value);
+  variable.dual.assign(clusters.size(), std::vector<double>(value.size(), 0.0));
+}
+
+} // namespace
+
+Bundle_Adjustment_Ceres_Partitioned::Partition_options::Partition_options
+(
+  const unsigned int max_cluster_size,
+  const double overlap_ratio
+)
+: max_cluster_size_(max_cluster_size),
+  overlap_ratio_(overlap_ratio),
+  max_consensus_iterations_(30),
+  consensus_weight_(1.0),
+  consensus_tolerance_(0.1),
+  bGlobal_pass_(false)
+{
+}
+
+Bundle_Adjustment_Ceres_Partitioned::Bundle_Adjustment_Ceres_Partitioned
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const Partition_options & partition_options
+)
+: ceres_options_(ceres_options),
+  partition_options_(partition_options)
+{}
+
+Bundle_Adjustment_Ceres::BA_Ceres_options &
+Bundle_Adjustment_Ceres_Partitioned::ceres_options()
+{
+  return ceres_options_;
+}
+
+Bundle_Adjustment_Ceres_Partitioned::Partition_options &
+Bundle_Adjustment_Ceres_Partitioned::partition_options()
+{
+  return partition_options_;
+}
+
+bool Bundle_Adjustment_Ceres_Partitioned::Adjust
+(
+  SfM_Data & sfm_data,
+  const Optimize_Options & options
+)
+{
+  OPENMVG_PROFILE_ZONE("CeresPartitioned");
+
+  if (options.use_motion_priors_opt || options.control_point_opt.bUse_control_points)
+  {
+    OPENMVG_LOG_WARNING << "Partitioned bundle adjustment: motion priors and"
+      << " control points require a global adjustment.";
+    return Bundle_Adjustment_Ceres(ceres_options_).Adjust(sfm_data, options);
+  }
+
+  const std::vector<BA_Pose_Cluster> clusters =
+    PartitionPosesByCovisibility(sfm_data,
+      partition_options_.max_cluster_size_,
+      partition_options_.overlap_ratio_);
+  if (clusters.size() < 2)
+  {
+    return Bundle_Adjustment_Ceres(ceres_options_).Adjust(sfm_data, options);
+  }
+
+  //--
+  // Assign the variables to the clusters and list the separators
+  //--
+  std::vector<std::set<IndexT>> cluster_poses(clusters.size());
+  Hash_Map<IndexT, std::set<size_t>> pose_clusters;
+  for (size_t cluster_id = 0; cluster_id < clusters.size(); ++cluster_id)
+  {
+    cluster_poses[cluster_id] = clusters[cluster_id].poses();
+    for (const IndexT pose_id : cluster_poses[cluster_id])
+      pose_clusters[pose_id].insert(cluster_id);
+  }
+
+  Hash_Map<IndexT, std::set<size_t>> intrinsic_clusters;
+  for (const auto & view_it : sfm_data.views)
+  {
+    const auto pose_clusters_it = pose_clusters.find(view_it.second->id_pose);
+    if (pose_clusters_it != pose_clusters.end()
+        && sfm_data.IsPoseAndIntrinsicDefined(view_it.second.get()))
+    {
+      intrinsic_clusters[view_it.second->id_intrinsic].insert(
+        pose_clusters_it->second.cbegin(), pose_clusters_it->second.cend());
+    }
+  }
+
+  std::vector<std::vector<IndexT>> cluster_landmarks(clusters.size());
+  Hash_Map<IndexT, std::set<size_t>> landmark_clusters;
+  std::vector<double> landmark_depths;
+  for (const auto & landmark_it : sfm_data.structure)
+  {
+    std::set<size_t> clusters_of_landmark;
+    bool b_depth_sampled = false;
+    for (const auto & obs_it : landmark_it.second.obs)
+    {
+      const auto view_it = sfm_data.views.find(obs_it.first);
+      if (view_it == sfm_data.views.end()
+          || !sfm_data.IsPoseAndIntrinsicDefined(view_it->second.get()))
+        continue;
+      const auto pose_clusters_it = pose_clusters.find(view_it->second->id_pose);
+      if (pose_clusters_it == pose_clusters.end())
+        continue;
+      clusters_of_landmark.insert(pose_clusters_it->second.cbegin(),
+        pose_clusters_it->second.cend());
+      if (!b_depth_sampled)
+      {
+        landmark_depths.push_back(
+          (landmark_it.second.X - sfm_data.poses.at(view_it->second->id_pose).center()).norm());
+        b_depth_sampled = true;
+      }
+    }
+    for (const size_t cluster_id : clusters_of_landmark)
+      cluster_landmarks[cluster_id].push_back(landmark_it.first);
+    if (clusters_of_landmark.size() > 1)
+      landmark_clusters[landmark_it.first] = std::move(clusters_of_landmark);
+    else
+      landmark_clusters[landmark_it.first];
+  }
+
+  //--
+  // Express the consensus residuals in pixels:
+  // - angles are scaled by the median focal length,
+  // - distances by the median focal length over the median landmark depth.
+  //--
+  std::vector<double> focals;
+  for (const auto & intrinsic_it : sfm_data.intrinsics)
+  {
+    if (isValid(intrinsic_it.second->getType()))
+      focals.push_back(1.0 / intrinsic_it.second->imagePlane_toCameraPlaneError(1.0));
+  }
+  const auto Median = [](std::vector<double> & values, const double default_value)
+  {
+    if (values.empty())
+      return default_value;
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+  };
+  const double focal_scale = Median(focals, 1.0);
+  const double median_depth = Median(landmark_depths, 1.0);
+  const double distance_scale = focal_scale / (median_depth > 0.0 ? median_depth : 1.0);
+
+  Consensus_Data consensus;
+  if (options.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+  {
+    for (const auto & pose_clusters_it : pose_clusters)
+    {
+      if (pose_clusters_it.second.size() < 2)
+        continue;
+      std::vector<double> value(6);
+      PoseToParameterBlock(sfm_data.poses.at(pose_clusters_it.first), value.data());
+      std::vector<double> scale(6, focal_scale);
+      std::fill(scale.begin() + 3, scale.end(), distance_scale);
+      InitConsensusVariable(consensus.poses[pose_clusters_it.first],
+        pose_clusters_it.second, value, std::move(scale));
+    }
+  }
+  if (options.intrinsics_opt != Intrinsic_Parameter_Type::NONE)
+  {
+    for (const auto & intrinsic_clusters_it : intrinsic_clusters)
+    {
+      const IntrinsicBase * intrinsic = sfm_data.intrinsics.at(intrinsic_clusters_it.first).get();
+      const std::vector<double> value = intrinsic->getParams();
+      if (intrinsic_clusters_it.second.size() < 2 || value.empty())
+        continue;
+      // Pinhole models: [focal, ppx, ppy] are in pixels, the distortion
+      //  coefficients are expressed in the normalized camera plane
+      std::vector<double> scale(value.size(), 1.0);
+      if (isPinhole(intrinsic->getType()))
+        std::fill(scale.begin() + std::min<size_t>(3, value.size()), scale.end(),
+          focal_scale);
+      InitConsensusVariable(consensus.intrinsics[intrinsic_clusters_it.first],
+        intrinsic_clusters_it.second, value, std::move(scale));
+    }
+  }
+  if (options.structure_opt != Structure_Parameter_Type::NONE)
+  {
+    for (const auto & landmark_clusters_it : landmark_clusters)
+    {
+      if (landmark_clusters_it.second.size() < 2)
+        continue;
+      const Vec3 & X = sfm_data.structure.at(landmark_clusters_it.first).X;
+      InitConsensusVariable(consensus.landmarks[landmark_clusters_it.first],
+        landmark_clusters_it.second, {X(0), X(1), X(2)},
+        std::vector<double>(3, distance_scale));
+    }
+  }
+  landmark_clusters.clear();
+
+  if (ceres_options_.bVerbose_)
+  {
+    OPENMVG_LOG_INFO
+      << "\nPartitioned Bundle Adjustment:\n"
+      << " #clusters: " << clusters.size() << "\n"
+      << " #separator poses: " << consensus.poses.size() << "\n"
+      << " #separator intrinsics: " << consensus.intrinsics.size() << "\n"
+      << " #separator landmarks: " << consensus.landmarks.size();
+  }
+
+  //--
+  // Consensus iterations
+  //--
+  // The clusters are solved in parallel, each with a single threaded solver
+  // (remaining threads are given to the solvers if there are few clusters)
+  Bundle_Adjustment_Ceres::BA_Ceres_options cluster_ceres_options = ceres_options_;
+  cluster_ceres_options.bVerbose_ = false;
+  cluster_ceres_options.nb_threads_ =
+    std::max(1u, ceres_options_.nb_threads_ / static_cast<unsigned int>(clusters.size()));
+
+  // Penalty weight, adapted to balance the primal and dual residuals
+  double penalty_weight = partition_options_.consensus_weight_;
+
+  const int cluster_count = static_cast<int>(clusters.size());
+  for (unsigned int iteration = 0;
+       iteration < std::max(1u, partition_options_.max_consensus_iterations_);
+       ++iteration)
+  {
+    std::vector<double> cluster_costs(clusters.size(), 0.0);
+    std::vector<size_t> cluster_residuals(clusters.size(), 0);
+    bool b_usable = true;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(ceres_options_.nb_threads_)
+#endif
+    for (int cluster_id = 0; cluster_id < cluster_count; ++cluster_id)
+    {
+      if (!SolveCluster(sfm_data, cluster_id, cluster_poses[cluster_id],
+            cluster_landmarks[cluster_id], consensus, penalty_weight, options,
+            cluster_ceres_options, cluster_costs[cluster_id],
+            cluster_residuals[cluster_id]))
+      {
+#ifdef OPENMVG_USE_OPENMP
+        #pragma omp critical
+#endif
+        b_usable = false;
+      }
+    }
+    if (!b_usable)
+    {
+      OPENMVG_LOG_ERROR << "IsSolutionUsable is false. Partitioned Bundle Adjustment failed.";
+      return false;
+    }
+
+    // Update the consensus values and write them into the scene
+    Consensus_Residuals residuals;
+    for (auto & variable_it : consensus.poses)
+    {
+      Pose3 & pose = sfm_data.poses.at(variable_it.first);
+      std::vector<double> value(6);
+      PoseToParameterBlock(pose, value.data());
+      UpdateConsensus(variable_it.second, value, residuals);
+      UpdatePoseFromParameterBlock(value.data(), options.extrinsics_opt, pose);
+    }
+    for (auto & variable_it : consensus.intrinsics)
+    {
+      IntrinsicBase * intrinsic = sfm_data.intrinsics.at(variable_it.first).get();
+      std::vector<double> value = intrinsic->getParams();
+      UpdateConsensus(variable_it.second, value, residuals);
+      intrinsic->updateFromParams(value);
+    }
+    for (auto & variable_it : consensus.landmarks)
+    {
+      Vec3 & X = sfm_data.structure.at(variable_it.first).X;
+      std::vector<double> value = {X(0), X(1), X(2)};
+      UpdateConsensus(variable_it.second, value, residuals);
+      X = Vec3(value[0], value[1], value[2]);
+    }
+
+    if (ceres_options_.bVerbose_)
+    {
+      const double total_cost =
+        std::accumulate(cluster_costs.cbegin(), cluster_costs.cend(), 0.0);
+      const size_t total_residuals =
+        std::accumulate(cluster_residuals.cbegin(), cluster_residuals.cend(), size_t(0));
+      OPENMVG_LOG_INFO
+        << "Consensus iteration " << iteration
+        << ": clusters RMSE: " << std::sqrt(total_cost / std::max<size_t>(1, total_residuals))
+        << ", separators max disagreement (px): " << residuals.max_disagreement
+        << ", penalty weight: " << penalty_weight;
+    }
+    if (residuals.max_disagreement < partition_options_.consensus_tolerance_)
+      break;
+
+    // Residual balancing: a large primal residual calls for a stronger
+    // consensus, a large dual residual (moving consensus) for a weaker one
+    const double primal_residual = std::sqrt(residuals.primal_squared);
+    const double dual_residual = penalty_weight * std::sqrt(residuals.dual_squared);
+    if (primal_residual > 10.0 * dual_residual)
+    {
+      penalty_weight *= 2.0;
+      for (auto * variables : {&consensus.poses, &consensus.intrinsics, &consensus.landmarks})
+        ScaleDuals(*variables, 0.5);
+    }
+    else if (dual_residual > 10.0 * primal_residual)
+    {
+      penalty_weight *= 0.5;
+      for (auto * variables : {&consensus.poses, &consensus.intrinsics, &consensus.landmarks})
+        ScaleDuals(*variables, 2.0);
+    }
+  }
+
+  if (partition_options_.bGlobal_pass_)
+  {
+    return Bundle_Adjustment_Ceres(ceres_options_).Adjust(sfm_data, options);
+  }
+  return true;
+}
+
+} // namespace sfm
 } // namespace openMVG
@@ -12,6 +12,8 @@
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 #include "openMVG/sfm/sfm_data_BA.hpp"
 
+#include <memory>
+
 namespace ceres { class CostFunction; }
 namespace openMVG { namespace cameras { struct IntrinsicBase; } }
 namespace openMVG { namespace sfm { struct SfM_Data; } }
@@ -27,11 +29,14 @@ namespace sfm {
 
 /// Create the appropriate cost functor according the provided input camera intrinsic model
 /// Can be residual cost functor can be weighetd if desired (default 0.0 means no weight).
+/// If use_analytic_jacobian is true, a cost function with hand derived Jacobians
+/// is used instead of the AutoDiff functor (same residuals, faster evaluation).
 ceres::CostFunction * IntrinsicsToCostFunction
 (
   cameras::IntrinsicBase * intrinsic,
   const Vec2 & observation,
-  const double weight = 0.0
+  const double weight = 0.0,
+  const bool use_analytic_jacobian = false
 );
 
 class Bundle_Adjustment_Ceres : public Bundle_Adjustment
@@ -48,6 +53,7 @@ class Bundle_Adjustment_Ceres : public Bundle_Adjustment
     double parameter_tolerance_;
     double gradient_tolerance_;
     bool bUse_loss_function_;
+    bool bUse_analytic_jacobians_; // Use hand derived Jacobians instead of AutoDiff
     int max_num_iterations_;
     int max_linear_solver_iterations_;
 
@@ -74,6 +80,115 @@ class Bundle_Adjustment_Ceres : public Bundle_Adjustment
   ) override;
 };
 
+/**
+* @brief Bundle adjustment problem kept alive across successive refinements of
+*  a growing scene (i.e. the sequential SfM resection/BA loop).
+*
+* The first Adjust call builds the whole Ceres problem. The next calls only
+* synchronize it with the scene:
+*  - parameter blocks are created for the new poses, intrinsics and landmarks,
+*  - residual blocks are added for the new observations only,
+*  - residual blocks of removed observations and parameter blocks of removed
+*    landmarks/poses/intrinsics are dropped from the problem.
+* The refined parameters are then written back in place into the scene.
+*
+* Pose priors and ground control points are not handled by the session
+* (use Bundle_Adjustment_Ceres for such configurations).
+*/
+class Bundle_Adjustment_Ceres_Session
+{
+  public:
+  Bundle_Adjustment_Ceres_Session
+  (
+    const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+    // tell which parameter needs to be adjusted
+    const Optimize_Options & options
+  );
+
+  ~Bundle_Adjustment_Ceres_Session();
+
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options();
+
+  /// Synchronize the problem with the scene, solve it and update the scene
+  bool Adjust(sfm::SfM_Data & sfm_data);
+
+  /// Number of residual blocks of the persistent problem
+  size_t NumResidualBlocks() const;
+
+  private:
+  /// Update the persistent problem to reflect the scene content
+  bool Synchronize(const sfm::SfM_Data & sfm_data);
+
+  struct Problem_Data;
+  std::unique_ptr<Problem_Data> problem_data_;
+  Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options_;
+  Optimize_Options options_;
+};
+
+/**
+* @brief Partitioned (divide and conquer) bundle adjustment for large scenes.
+*
+* The poses are split into overlapping clusters from the landmark covisibility
+* (see PartitionPosesByCovisibility). Each cluster is refined as an independent
+* Ceres problem holding only its poses, intrinsics, landmarks and observations.
+* The variables shared by several clusters (separators: overlap poses, shared
+* intrinsics and landmarks seen across clusters) are driven to agreement by a
+* consensus ADMM scheme:
+*  - each cluster solves its reprojection problem with a quadratic penalty
+*    pulling its separator copies toward the consensus values,
+*  - the consensus values are updated as the average of the cluster copies
+*    (corrected by their scaled dual variables), and the duals are updated,
+*  - the process stops when the copies agree within a tolerance (pixels).
+* The clusters are solved in parallel: only the problems of the clusters being
+* solved are alive, so the memory is bounded by the cluster size.
+* An optional final pass refines the whole scene at once.
+*
+* Pose priors and ground control points are not handled by the partitioning:
+* such configurations are adjusted by Bundle_Adjustment_Ceres.
+*/
+class Bundle_Adjustment_Ceres_Partitioned : public Bundle_Adjustment
+{
+  public:
+  struct Partition_options
+  {
+    unsigned int max_cluster_size_; // Maximal number of poses per cluster core
+    double overlap_ratio_; // Number of overlap poses per cluster, relative to its core size
+    unsigned int max_consensus_iterations_;
+    double consensus_weight_; // ADMM penalty weight, relative to the reprojection residuals
+    double consensus_tolerance_; // Maximal separator disagreement at convergence (pixels)
+    bool bGlobal_pass_; // Refine the whole scene once the clusters agree
+
+    Partition_options
+    (
+      const unsigned int max_cluster_size = 500,
+      const double overlap_ratio = 0.2
+    );
+  };
+
+  explicit Bundle_Adjustment_Ceres_Partitioned
+  (
+    const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options =
+      Bundle_Adjustment_Ceres::BA_Ceres_options(),
+    const Partition_options & partition_options = Partition_options()
+  );
+
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options();
+
+  Partition_options & partition_options();
+
+  bool Adjust
+  (
+    // the SfM scene to refine
+    sfm::SfM_Data & sfm_data,
+    // tell which parameter needs to be adjusted
+    const Optimize_Options & options
+  ) override;
+
+  private:
+  Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options_;
+  Partition_options partition_options_;
+};
+
 } // namespace sfm
 } // namespace openMVG
 
@@ -0,0 +1,507 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_BA_CERES_CAMERA_FUNCTOR_ANALYTIC_HPP
+#define OPENMVG_SFM_SFM_DATA_BA_CERES_CAMERA_FUNCTOR_ANALYTIC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/numeric/numeric.h"
+
+//--
+//- Ceres cost functions with analytic (hand derived) Jacobians for the
+//- OpenMVG camera models.
+//- They compute the same residuals as the AutoDiff functors of
+//- sfm_data_BA_ceres_camera_functor.hpp, using the same parameter blocks.
+//--
+
+namespace openMVG {
+namespace sfm {
+namespace analytic {
+
+using Mat2 = Eigen::Matrix2d;
+using RowMat23 = Eigen::Matrix<double, 2, 3, Eigen::RowMajor>;
+
+/**
+ * @brief Transform a 3D point by a [angleAxis, translation] pose and
+ *  compute the derivatives of the transformed point.
+ *
+ * @param[in] cam_extrinsics: [rX,rY,rZ,tx,ty,tz]
+ * @param[in] pos_3dpoint: the 3D point X
+ * @param[out] transformed_point: P = R X + t
+ * @param[out] dP_dangle_axis: derivative of P wrt. the angle axis (if not null)
+ * @param[out] dP_dX: derivative of P wrt. X, i.e R (if not null)
+ */
+inline void TransformPoint
+(
+  const double * const cam_extrinsics,
+  const double * const pos_3dpoint,
+  Vec3 & transformed_point,
+  Mat3 * dP_dangle_axis,
+  Mat3 * dP_dX
+)
+{
+  const Eigen::Map<const Vec3> angle_axis(cam_extrinsics);
+  const Eigen::Map<const Vec3> X(pos_3dpoint);
+
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(cam_extrinsics, R.data());
+  transformed_point = R * X + Eigen::Map<const Vec3>(&cam_extrinsics[3]);
+
+  if (dP_dangle_axis)
+  {
+    const Mat3 X_cross = CrossProductMatrix(X);
+    const double theta2 = angle_axis.squaredNorm();
+    if (theta2 > std::numeric_limits<double>::epsilon())
+    {
+      // d(R X)/dw = - R [X]x Jr(w), with Jr the right Jacobian of SO(3)
+      const double theta = std::sqrt(theta2);
+      const Mat3 w_cross = CrossProductMatrix(angle_axis);
+      const Mat3 right_jacobian =
+        Mat3::Identity()
+        - (1.0 - std::cos(theta)) / theta2 * w_cross
+        + (theta - std::sin(theta)) / (theta2 * theta) * w_cross * w_cross;
+      *dP_dangle_axis = - R * X_cross * right_jacobian;
+    }
+    else
+    {
+      // First order approximation used near the identity: R X = X + w x X
+      *dP_dangle_axis = - X_cross;
+    }
+  }
+  if (dP_dX)
+  {
+    *dP_dX = R;
+  }
+}
+
+/// Write the Jacobians of a residual wrt. the pose and the 3D point
+/// from the Jacobian of the residual wrt. the transformed point.
+inline void WritePoseAndPointJacobians
+(
+  const RowMat23 & dres_dP,
+  const Mat3 & dP_dangle_axis,
+  const Mat3 & dP_dX,
+  double * jacobian_extrinsics,
+  double * jacobian_point
+)
+{
+  if (jacobian_extrinsics)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobian_extrinsics);
+    J.leftCols<3>() = dres_dP * dP_dangle_axis;
+    J.rightCols<3>() = dres_dP;
+  }
+  if (jacobian_point)
+  {
+    Eigen::Map<RowMat23> J(jacobian_point);
+    J = dres_dP * dP_dX;
+  }
+}
+
+/// Derivative of the projection p = (P.x/P.z, P.y/P.z) wrt. P
+inline RowMat23 ProjectionJacobian(const Vec3 & P)
+{
+  const double inv_z = 1.0 / P.z();
+  RowMat23 dp_dP;
+  dp_dP << inv_z, 0.0, -P.x() * inv_z * inv_z,
+           0.0, inv_z, -P.y() * inv_z * inv_z;
+  return dp_dP;
+}
+
+//--
+// Distortion models: (xd, yd) = disto(x_u, y_u)
+// - NUM_PARAMS: number of distortion parameters (stored after [f, ppx, ppy])
+// - Apply: compute the distorted point, and optionally its derivatives wrt.
+//   the undistorted point (2x2) and wrt. the distortion parameters (2xN).
+//--
+
+struct No_Distortion
+{
+  enum : int { NUM_PARAMS = 0 };
+
+  static void Apply
+  (
+    const double * const /*disto*/,
+    const Vec2 & p,
+    Vec2 & p_d,
+    Mat2 * dpd_dp,
+    double * /*dpd_ddisto*/
+  )
+  {
+    p_d = p;
+    if (dpd_dp)
+      dpd_dp->setIdentity();
+  }
+};
+
+struct Radial_K1_Distortion
+{
+  enum : int { NUM_PARAMS = 1 };
+
+  static void Apply
+  (
+    const double * const disto,
+    const Vec2 & p,
+    Vec2 & p_d,
+    Mat2 * dpd_dp,
+    double * dpd_ddisto
+  )
+  {
+    const double & k1 = disto[0];
+    const double r2 = p.squaredNorm();
+    const double r_coeff = 1.0 + k1 * r2;
+    p_d = p * r_coeff;
+    if (dpd_dp)
+    {
+      // d(p r_coeff)/dp = r_coeff I + p (d r_coeff/dp)^T
+      *dpd_dp = r_coeff * Mat2::Identity() + (2.0 * k1) * p * p.transpose();
+    }
+    if (dpd_ddisto)
+    {
+      Eigen::Map<Vec2> J(dpd_ddisto);
+      J = p * r2;
+    }
+  }
+};
+
+struct Radial_K3_Distortion
+{
+  enum : int { NUM_PARAMS = 3 };
+
+  static void Apply
+  (
+    const double * const disto,
+    const Vec2 & p,
+    Vec2 & p_d,
+    Mat2 * dpd_dp,
+    double * dpd_ddisto
+  )
+  {
+    const double & k1 = disto[0], & k2 = disto[1], & k3 = disto[2];
+    const double r2 = p.squaredNorm();
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    p_d = p * r_coeff;
+    if (dpd_dp)
+    {
+      const double dcoeff_dr2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+      *dpd_dp = r_coeff * Mat2::Identity() + (2.0 * dcoeff_dr2) * p * p.transpose();
+    }
+    if (dpd_ddisto)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(dpd_ddisto);
+      J.col(0) = p * r2;
+      J.col(1) = p * r4;
+      J.col(2) = p * r6;
+    }
+  }
+};
+
+struct Brown_T2_Distortion
+{
+  enum : int { NUM_PARAMS = 5 };
+
+  static void Apply
+  (
+    const double * const disto,
+    const Vec2 & p,
+    Vec2 & p_d,
+    Mat2 * dpd_dp,
+    double * dpd_ddisto
+  )
+  {
+    const double & k1 = disto[0], & k2 = disto[1], & k3 = disto[2];
+    const double & t1 = disto[3], & t2 = disto[4];
+    const double x_u = p.x(), y_u = p.y();
+    const double r2 = p.squaredNorm();
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double t_x = t2 * (r2 + 2.0 * x_u * x_u) + 2.0 * t1 * x_u * y_u;
+    const double t_y = t1 * (r2 + 2.0 * y_u * y_u) + 2.0 * t2 * x_u * y_u;
+    p_d << x_u * r_coeff + t_x, y_u * r_coeff + t_y;
+    if (dpd_dp)
+    {
+      const double dcoeff_dr2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+      Mat2 dt_dp;
+      dt_dp << 6.0 * t2 * x_u + 2.0 * t1 * y_u, 2.0 * t2 * y_u + 2.0 * t1 * x_u,
+               2.0 * t1 * x_u + 2.0 * t2 * y_u, 6.0 * t1 * y_u + 2.0 * t2 * x_u;
+      *dpd_dp = r_coeff * Mat2::Identity() + (2.0 * dcoeff_dr2) * p * p.transpose() + dt_dp;
+    }
+    if (dpd_ddisto)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 5, Eigen::RowMajor>> J(dpd_ddisto);
+      J.col(0) = p * r2;
+      J.col(1) = p * r4;
+      J.col(2) = p * r6;
+      J.col(3) << 2.0 * x_u * y_u, r2 + 2.0 * y_u * y_u;
+      J.col(4) << r2 + 2.0 * x_u * x_u, 2.0 * x_u * y_u;
+    }
+  }
+};
+
+struct Fisheye_Distortion
+{
+  enum : int { NUM_PARAMS = 4 };
+
+  static void Apply
+  (
+    const double * const disto,
+    const Vec2 & p,
+    Vec2 & p_d,
+    Mat2 * dpd_dp,
+    double * dpd_ddisto
+  )
+  {
+    const double & k1 = disto[0], & k2 = disto[1], & k3 = disto[2], & k4 = disto[3];
+    const double r2 = p.squaredNorm();
+    const double r = std::sqrt(r2);
+    if (r <= 1e-8)
+    {
+      // The distortion is the identity near the principal point
+      p_d = p;
+      if (dpd_dp)
+        dpd_dp->setIdentity();
+      if (dpd_ddisto)
+        std::fill(dpd_ddisto, dpd_ddisto + 2 * NUM_PARAMS, 0.0);
+      return;
+    }
+    const double
+      theta = std::atan(r),
+      theta2 = theta * theta,
+      theta3 = theta2 * theta,
+      theta4 = theta2 * theta2,
+      theta5 = theta4 * theta,
+      theta6 = theta3 * theta3,
+      theta7 = theta6 * theta,
+      theta8 = theta4 * theta4,
+      theta9 = theta8 * theta;
+    const double theta_dist = theta + k1 * theta3 + k2 * theta5 + k3 * theta7 + k4 * theta9;
+    const double inv_r = 1.0 / r;
+    const double cdist = theta_dist * inv_r;
+    p_d = p * cdist;
+    if (dpd_dp)
+    {
+      const double dtheta_dist_dr =
+        (1.0 + 3.0 * k1 * theta2 + 5.0 * k2 * theta4 + 7.0 * k3 * theta6 + 9.0 * k4 * theta8)
+        / (1.0 + r2);
+      const double dcdist_dr = (dtheta_dist_dr * r - theta_dist) * inv_r * inv_r;
+      // d(p cdist)/dp = cdist I + p (dcdist/dr p/r)^T
+      *dpd_dp = cdist * Mat2::Identity() + (dcdist_dr * inv_r) * p * p.transpose();
+    }
+    if (dpd_ddisto)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 4, Eigen::RowMajor>> J(dpd_ddisto);
+      J.col(0) = p * (theta3 * inv_r);
+      J.col(1) = p * (theta5 * inv_r);
+      J.col(2) = p * (theta7 * inv_r);
+      J.col(3) = p * (theta9 * inv_r);
+    }
+  }
+};
+
+/**
+ * @brief Reprojection error of a pinhole camera model with a distortion model,
+ *  with analytic Jacobians.
+ *
+ *  Data parameter blocks are the following <2, 3 + Distortion::NUM_PARAMS, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - 3 + N => the intrinsic data block [focal, principal point x, principal point y, disto...],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+template <typename Distortion>
+class ResidualErrorCostFunction_Pinhole
+  : public ceres::SizedCostFunction<2, 3 + Distortion::NUM_PARAMS, 6, 3>
+{
+public:
+  enum : int { NUM_INTRINSICS = 3 + Distortion::NUM_PARAMS };
+
+  /**
+   * @param[in] observation: the observed 2D point (copied)
+   * @param[in] weight: residual weight (0.0 means no weight)
+   */
+  explicit ResidualErrorCostFunction_Pinhole
+  (
+    const Vec2 & observation,
+    const double weight = 0.0
+  ):
+    observation_(observation),
+    weight_(weight == 0.0 ? 1.0 : weight)
+  {
+  }
+
+  bool Evaluate
+  (
+    double const * const * parameters,
+    double * residuals,
+    double ** jacobians
+  ) const override
+  {
+    const double * const cam_intrinsics = parameters[0];
+    const double * const cam_extrinsics = parameters[1];
+    const double * const pos_3dpoint = parameters[2];
+
+    const bool b_pose_point_jacobians =
+      jacobians && (jacobians[1] || jacobians[2]);
+
+    Vec3 transformed_point;
+    Mat3 dP_dangle_axis, dP_dX;
+    TransformPoint(cam_extrinsics, pos_3dpoint, transformed_point,
+      b_pose_point_jacobians ? &dP_dangle_axis : nullptr,
+      b_pose_point_jacobians ? &dP_dX : nullptr);
+
+    // Transform the point from homogeneous to euclidean (undistorted point)
+    const Vec2 projected_point = transformed_point.hnormalized();
+
+    const double focal = cam_intrinsics[0];
+    const double principal_point_x = cam_intrinsics[1];
+    const double principal_point_y = cam_intrinsics[2];
+
+    Vec2 distorted_point;
+    Mat2 dpd_dp;
+    // Row major 2 x NUM_PARAMS derivatives of the distorted point
+    double dpd_ddisto[2 * (Distortion::NUM_PARAMS ? Distortion::NUM_PARAMS : 1)];
+    Distortion::Apply(&cam_intrinsics[3], projected_point, distorted_point,
+      b_pose_point_jacobians ? &dpd_dp : nullptr,
+      (jacobians && jacobians[0]) ? dpd_ddisto : nullptr);
+
+    residuals[0] = weight_ *
+      (principal_point_x + distorted_point.x() * focal - observation_.x());
+    residuals[1] = weight_ *
+      (principal_point_y + distorted_point.y() * focal - observation_.y());
+
+    if (!jacobians)
+      return true;
+
+    if (jacobians[0])
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, NUM_INTRINSICS, Eigen::RowMajor>>
+        J(jacobians[0]);
+      J.col(0) = weight_ * distorted_point;
+      J.col(1) << weight_, 0.0;
+      J.col(2) << 0.0, weight_;
+      for (int i = 0; i < Distortion::NUM_PARAMS; ++i)
+      {
+        J(0, 3 + i) = weight_ * focal * dpd_ddisto[i];
+        J(1, 3 + i) = weight_ * focal * dpd_ddisto[Distortion::NUM_PARAMS + i];
+      }
+    }
+    if (b_pose_point_jacobians)
+    {
+      const RowMat23 dres_dP =
+        (weight_ * focal) * dpd_dp * ProjectionJacobian(transformed_point);
+      WritePoseAndPointJacobians(dres_dP, dP_dangle_axis, dP_dX,
+        jacobians[1], jacobians[2]);
+    }
+    return true;
+  }
+
+private:
+  const Vec2 observation_;
+  const double weight_;
+};
+
+/**
+ * @brief Reprojection error of a spherical camera model, with analytic Jacobians.
+ *
+ *  Data parameter blocks are the following <2,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+class ResidualErrorCostFunction_Spherical
+  : public ceres::SizedCostFunction<2, 6, 3>
+{
+public:
+  ResidualErrorCostFunction_Spherical
+  (
+    const cameras::IntrinsicBase * cameraInterface,
+    const Vec2 & observation,
+    const double weight = 0.0
+  ):
+    observation_(observation),
+    image_size_{static_cast<double>(cameraInterface->w()),
+                static_cast<double>(cameraInterface->h())},
+    weight_(weight == 0.0 ? 1.0 : weight)
+  {
+  }
+
+  bool Evaluate
+  (
+    double const * const * parameters,
+    double * residuals,
+    double ** jacobians
+  ) const override
+  {
+    const bool b_jacobians = jacobians && (jacobians[0] || jacobians[1]);
+
+    Vec3 P;
+    Mat3 dP_dangle_axis, dP_dX;
+    TransformPoint(parameters[0], parameters[1], P,
+      b_jacobians ? &dP_dangle_axis : nullptr,
+      b_jacobians ? &dP_dX : nullptr);
+
+    // Transform the coord in is Image space
+    const double rho2 = P.x() * P.x() + P.z() * P.z();
+    const double rho = std::sqrt(rho2);
+    const double lon = std::atan2(P.x(), P.z());
+    const double lat = std::atan2(-P.y(), rho);
+
+    const double size = std::max(image_size_[0], image_size_[1]);
+    const double scale = size / (2 * M_PI);
+    residuals[0] = weight_ * (lon * scale + image_size_[0] / 2.0 - observation_.x());
+    residuals[1] = weight_ * (-lat * scale + image_size_[1] / 2.0 - observation_.y());
+
+    if (b_jacobians)
+    {
+      const double norm2 = rho2 + P.y() * P.y();
+      RowMat23 dres_dP;
+      // d(lon)/dP
+      dres_dP.row(0) << P.z() / rho2, 0.0, -P.x() / rho2;
+      // -d(lat)/dP
+      dres_dP.row(1) << -P.y() * P.x() / (rho * norm2),
+                         rho / norm2,
+                        -P.y() * P.z() / (rho * norm2);
+      dres_dP *= weight_ * scale;
+      WritePoseAndPointJacobians(dres_dP, dP_dangle_axis, dP_dX,
+        jacobians[0], jacobians[1]);
+    }
+    return true;
+  }
+
+private:
+  const Vec2 observation_;
+  const double image_size_[2];
+  const double weight_;
+};
+
+using ResidualErrorCostFunction_Pinhole_Intrinsic =
+  ResidualErrorCostFunction_Pinhole<No_Distortion>;
+using ResidualErrorCostFunction_Pinhole_Intrinsic_Radial_K1 =
+  ResidualErrorCostFunction_Pinhole<Radial_K1_Distortion>;
+using ResidualErrorCostFunction_Pinhole_Intrinsic_Radial_K3 =
+  ResidualErrorCostFunction_Pinhole<Radial_K3_Distortion>;
+using ResidualErrorCostFunction_Pinhole_Intrinsic_Brown_T2 =
+  ResidualErrorCostFunction_Pinhole<Brown_T2_Distortion>;
+using ResidualErrorCostFunction_Pinhole_Intrinsic_Fisheye =
+  ResidualErrorCostFunction_Pinhole<Fisheye_Distortion>;
+
+} // namespace analytic
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_BA_CERES_CAMERA_FUNCTOR_ANALYTIC_HPP
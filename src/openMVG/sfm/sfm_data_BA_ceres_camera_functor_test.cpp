@@ -0,0 +1,220 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/cameras.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_camera_functor.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_camera_functor_analytic.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::sfm;
+
+namespace
+{
+
+// Evaluate the residuals and the Jacobians of an AutoDiff and an analytic
+// cost function on the same parameters and check that they agree.
+bool CheckCostFunctions
+(
+  const ceres::CostFunction & autodiff_cost,
+  const ceres::CostFunction & analytic_cost,
+  const std::vector<std::vector<double>> & parameter_blocks
+)
+{
+  const std::vector<int> & block_sizes = autodiff_cost.parameter_block_sizes();
+  if (block_sizes != analytic_cost.parameter_block_sizes()
+      || autodiff_cost.num_residuals() != analytic_cost.num_residuals()
+      || block_sizes.size() != parameter_blocks.size())
+    return false;
+
+  std::vector<const double *> parameters;
+  for (const auto & block : parameter_blocks)
+    parameters.push_back(block.data());
+
+  const int num_residuals = autodiff_cost.num_residuals();
+  std::vector<double> residuals_autodiff(num_residuals), residuals_analytic(num_residuals);
+  std::vector<std::vector<double>> jacobians_autodiff, jacobians_analytic;
+  for (const int block_size : block_sizes)
+  {
+    jacobians_autodiff.emplace_back(num_residuals * block_size);
+    jacobians_analytic.emplace_back(num_residuals * block_size);
+  }
+  std::vector<double *> jacobians_autodiff_ptr, jacobians_analytic_ptr;
+  for (size_t i = 0; i < block_sizes.size(); ++i)
+  {
+    jacobians_autodiff_ptr.push_back(jacobians_autodiff[i].data());
+    jacobians_analytic_ptr.push_back(jacobians_analytic[i].data());
+  }
+
+  if (!autodiff_cost.Evaluate(parameters.data(),
+        residuals_autodiff.data(), jacobians_autodiff_ptr.data())
+      || !analytic_cost.Evaluate(parameters.data(),
+        residuals_analytic.data(), jacobians_analytic_ptr.data()))
+    return false;
+
+  for (int i = 0; i < num_residuals; ++i)
+    if (std::abs(residuals_autodiff[i] - residuals_analytic[i]) > 1e-8)
+      return false;
+
+  for (size_t i = 0; i < block_sizes.size(); ++i)
+  {
+    for (size_t j = 0; j < jacobians_autodiff[i].size(); ++j)
+    {
+      const double tolerance = 1e-6 * std::max(1.0, std::abs(jacobians_autodiff[i][j]));
+      if (std::abs(jacobians_autodiff[i][j] - jacobians_analytic[i][j]) > tolerance)
+        return false;
+    }
+  }
+
+  // Residuals only request
+  std::vector<double> residuals_only(num_residuals);
+  if (!analytic_cost.Evaluate(parameters.data(), residuals_only.data(), nullptr)
+      || residuals_only != residuals_analytic)
+    return false;
+
+  // Partial Jacobian request (3D point only)
+  std::vector<double> partial_jacobian(jacobians_analytic.back().size());
+  std::vector<double *> partial_jacobians_ptr(block_sizes.size(), nullptr);
+  partial_jacobians_ptr.back() = partial_jacobian.data();
+  return analytic_cost.Evaluate(parameters.data(),
+      residuals_only.data(), partial_jacobians_ptr.data())
+    && partial_jacobian == jacobians_analytic.back();
+}
+
+// Random pose [angle axis, translation] and a 3D point in front of the camera
+void RandomPoseAndPoint
+(
+  std::mt19937 & rng,
+  const double rotation_magnitude,
+  std::vector<double> & pose,
+  std::vector<double> & point
+)
+{
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  pose = {unit(rng), unit(rng), unit(rng), unit(rng), unit(rng), unit(rng)};
+  const double norm = Eigen::Map<const Vec3>(pose.data()).norm();
+  for (int i = 0; i < 3; ++i)
+    pose[i] *= rotation_magnitude / norm;
+
+  // Choose the point in the camera frame, then bring it in the world frame
+  const Vec3 X_cam(0.5 * unit(rng), 0.5 * unit(rng), 4.0 + unit(rng));
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(pose.data(), R.data());
+  const Vec3 X = R.transpose() * (X_cam - Eigen::Map<const Vec3>(&pose[3]));
+  point = {X.x(), X.y(), X.z()};
+}
+
+// Compare the AutoDiff and the analytic cost functions of an intrinsic model
+// for different poses (including near identity rotations) and weights.
+bool CheckIntrinsic
+(
+  IntrinsicBase * intrinsic
+)
+{
+  const std::vector<double> intrinsic_params = intrinsic->getParams();
+  std::mt19937 rng(std::mt19937::default_seed);
+  for (const double rotation_magnitude : {0.4, 1e-10, 0.0})
+  {
+    for (const double weight : {0.0, 2.5})
+    {
+      std::vector<double> pose, point;
+      RandomPoseAndPoint(rng, rotation_magnitude, pose, point);
+      const Vec2 observation(1000.0, 600.0);
+
+      std::unique_ptr<ceres::CostFunction> autodiff_cost(
+        IntrinsicsToCostFunction(intrinsic, observation, weight, false));
+      std::unique_ptr<ceres::CostFunction> analytic_cost(
+        IntrinsicsToCostFunction(intrinsic, observation, weight, true));
+      if (!autodiff_cost || !analytic_cost)
+        return false;
+
+      const bool consistent = (intrinsic->getType() == CAMERA_SPHERICAL) ?
+        CheckCostFunctions(*autodiff_cost, *analytic_cost, {pose, point}) :
+        CheckCostFunctions(*autodiff_cost, *analytic_cost, {intrinsic_params, pose, point});
+      if (!consistent)
+        return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Pinhole)
+{
+  Pinhole_Intrinsic intrinsic(2000, 1500, 1800.0, 1000.0, 750.0);
+  EXPECT_TRUE(CheckIntrinsic(&intrinsic));
+}
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Pinhole_Radial_K1)
+{
+  Pinhole_Intrinsic_Radial_K1 intrinsic(2000, 1500, 1800.0, 1000.0, 750.0, -0.12);
+  EXPECT_TRUE(CheckIntrinsic(&intrinsic));
+}
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Pinhole_Radial_K3)
+{
+  Pinhole_Intrinsic_Radial_K3 intrinsic(2000, 1500, 1800.0, 1000.0, 750.0, -0.12, 0.05, -0.01);
+  EXPECT_TRUE(CheckIntrinsic(&intrinsic));
+}
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Pinhole_Brown_T2)
+{
+  Pinhole_Intrinsic_Brown_T2 intrinsic(2000, 1500, 1800.0, 1000.0, 750.0,
+    -0.12, 0.05, -0.01, 0.002, -0.003);
+  EXPECT_TRUE(CheckIntrinsic(&intrinsic));
+}
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Pinhole_Fisheye)
+{
+  Pinhole_Intrinsic_Fisheye intrinsic(2000, 1500, 1800.0, 1000.0, 750.0,
+    -0.03, 0.01, -0.005, 0.001);
+  EXPECT_TRUE(CheckIntrinsic(&intrinsic));
+}
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Spherical)
+{
+  Intrinsic_Spherical intrinsic(4000, 2000);
+  EXPECT_TRUE(CheckIntrinsic(&intrinsic));
+}
+
+TEST(BA_CERES_ANALYTIC_COST_FUNCTION, Fisheye_PrincipalPoint)
+{
+  // A point on the optical axis: the fisheye distortion is not differentiable
+  // wrt. its coefficients there, both implementations must stay finite.
+  Pinhole_Intrinsic_Fisheye intrinsic(2000, 1500, 1800.0, 1000.0, 750.0,
+    -0.03, 0.01, -0.005, 0.001);
+  const std::vector<double> params = intrinsic.getParams();
+  const std::vector<double> pose = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  const std::vector<double> point = {0.0, 0.0, 5.0};
+
+  std::unique_ptr<ceres::CostFunction> analytic_cost(
+    IntrinsicsToCostFunction(&intrinsic, Vec2(1000.0, 750.0), 0.0, true));
+  const double * parameters[] = {params.data(), pose.data(), point.data()};
+  double residuals[2];
+  double jacobian_intrinsics[2 * 7], jacobian_pose[2 * 6], jacobian_point[2 * 3];
+  double * jacobians[] = {jacobian_intrinsics, jacobian_pose, jacobian_point};
+  EXPECT_TRUE(analytic_cost->Evaluate(parameters, residuals, jacobians));
+  EXPECT_NEAR(0.0, residuals[0], 1e-10);
+  EXPECT_NEAR(0.0, residuals[1], 1e-10);
+  for (const double value : jacobian_intrinsics)
+    EXPECT_TRUE(std::isfinite(value));
+  for (const double value : jacobian_pose)
+    EXPECT_TRUE(std::isfinite(value));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
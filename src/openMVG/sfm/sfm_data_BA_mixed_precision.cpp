@@ -0,0 +1,1009 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_data_BA_mixed_precision.hpp"
+
+#include "ceres/cost_function.h"
+#include "openMVG/cameras/Camera_Common.hpp"
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
+#include "openMVG/system/timer.hpp"
+#include "openMVG/types.hpp"
+
+#include <ceres/rotation.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+using namespace openMVG::cameras;
+using namespace openMVG::geometry;
+
+Bundle_Adjustment_Mixed_Precision::Mixed_Precision_options::Mixed_Precision_options
+(
+  const double linear_solver_tolerance,
+  const bool bLandmark_centered_frame
+)
+: linear_solver_tolerance_(linear_solver_tolerance),
+  bLandmark_centered_frame_(bLandmark_centered_frame)
+{
+}
+
+namespace {
+
+using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using MapMatrixXf = Eigen::Map<RowMatrixXf>;
+using ConstMapMatrixXf = Eigen::Map<const RowMatrixXf>;
+
+// Levenberg-Marquardt settings (Ceres default values)
+const double kInitialDamping = 1e-4;
+const double kMaxDamping = 1e32;
+const double kMinDiagonal = 1e-6;
+const double kMaxDiagonal = 1e32;
+const double kMinRelativeDecrease = 1e-3;
+const double kFunctionTolerance = 1e-6;
+// Huber loss scale (same as Bundle_Adjustment_Ceres)
+const double kHuberScale = Square(4.0);
+
+/// A camera side parameter block (intrinsic or pose) of the reduced camera system
+struct Camera_Block
+{
+  double * parameters;
+  int size;
+  int offset; // position in the reduced camera system
+  std::vector<char> is_constant; // subset parametrization
+  // Blocks of the reduced camera system row: (block id, storage offset) sorted by id
+  std::vector<std::pair<int, size_t>> row;
+  std::vector<int> residuals; // residuals depending on this block
+  std::vector<int> landmarks; // variable landmarks linked to this block
+
+  size_t RowBlockOffset(const int block) const
+  {
+    return std::lower_bound(row.begin(), row.end(), std::make_pair(block, size_t(0)))->second;
+  }
+};
+
+/// A landmark, with its Schur complement data
+struct Landmark_Block
+{
+  double * X;
+  bool is_variable;
+  std::vector<int> residuals;
+  // Camera blocks linked to the landmark (sorted) and their W = J_c^T J_X blocks
+  std::vector<int> camera_blocks;
+  std::vector<size_t> w_offsets;
+  std::vector<float> w;
+  Eigen::Matrix3f v;         // J_X^T J_X
+  Eigen::Matrix3f v_inverse; // (J_X^T J_X + damping)^-1
+  Eigen::Vector3f gradient;  // J_X^T r
+  Eigen::Vector3f damping;
+  Eigen::Vector3f step;
+
+  int Slot(const int block) const
+  {
+    return std::lower_bound(camera_blocks.begin(), camera_blocks.end(), block)
+      - camera_blocks.begin();
+  }
+};
+
+/// A reprojection residual and its single precision linearization
+struct Residual_Block
+{
+  std::unique_ptr<ceres::CostFunction> cost_function;
+  std::vector<double*> parameters; // [intrinsic], pose, landmark
+  int nb_camera_parameters; // number of camera side parameter blocks
+  std::array<int, 2> camera_blocks; // camera block of the camera side parameters (-1: constant)
+  std::array<int, 2> landmark_slots; // slot of the camera blocks in the landmark
+  std::array<size_t, 3> jacobian_offsets;
+  int landmark;
+  Eigen::Vector2f residual; // weighted by the loss function
+  std::vector<float> jacobians; // row major 2xN blocks (weighted by the loss function)
+};
+
+/// Cost of a squared residual norm (optional Huber loss)
+/// and the corresponding residual weight (square root of the loss derivative)
+inline double Loss(const double squared_norm, const bool use_loss, double * weight)
+{
+  if (!use_loss || squared_norm <= Square(kHuberScale))
+  {
+    if (weight) *weight = 1.0;
+    return squared_norm;
+  }
+  const double norm = std::sqrt(squared_norm);
+  if (weight) *weight = std::sqrt(kHuberScale / norm);
+  return 2.0 * kHuberScale * norm - Square(kHuberScale);
+}
+
+/// Evaluate a residual (and its single precision Jacobians if asked)
+/// Return the cost of the residual or -1 if it cannot be evaluated.
+double EvaluateResidual
+(
+  Residual_Block & residual_block,
+  const std::vector<Camera_Block> & camera_blocks,
+  const bool is_landmark_variable,
+  const bool use_loss,
+  const bool b_jacobians
+)
+{
+  const ceres::CostFunction & cost_function = *residual_block.cost_function;
+  const auto & block_sizes = cost_function.parameter_block_sizes();
+  const int nb_parameters = residual_block.parameters.size();
+
+  double residual[2];
+  std::array<std::vector<double>, 3> jacobian_values;
+  std::array<double*, 3> jacobians = {{nullptr, nullptr, nullptr}};
+  if (b_jacobians)
+  {
+    for (int i = 0; i < nb_parameters; ++i)
+    {
+      const bool is_variable = (i < residual_block.nb_camera_parameters)
+        ? residual_block.camera_blocks[i] >= 0
+        : is_landmark_variable;
+      if (is_variable)
+      {
+        jacobian_values[i].resize(2 * block_sizes[i]);
+        jacobians[i] = jacobian_values[i].data();
+      }
+    }
+  }
+  if (!cost_function.Evaluate(residual_block.parameters.data(), residual,
+                              b_jacobians ? jacobians.data() : nullptr))
+    return -1.0;
+
+  double weight;
+  const double cost = 0.5 * Loss(Square(residual[0]) + Square(residual[1]), use_loss, &weight);
+  if (!b_jacobians)
+    return cost;
+
+  residual_block.residual << weight * residual[0], weight * residual[1];
+  for (int i = 0; i < nb_parameters; ++i)
+  {
+    if (!jacobians[i])
+      continue;
+    float * jacobian = &residual_block.jacobians[residual_block.jacobian_offsets[i]];
+    for (int k = 0; k < 2 * block_sizes[i]; ++k)
+      jacobian[k] = static_cast<float>(weight * jacobian_values[i][k]);
+    // The constant parameters of a subset parametrization have no Jacobian
+    if (i < residual_block.nb_camera_parameters)
+    {
+      const Camera_Block & camera_block = camera_blocks[residual_block.camera_blocks[i]];
+      for (int c = 0; c < camera_block.size; ++c)
+      {
+        if (camera_block.is_constant[c])
+        {
+          jacobian[c] = 0.f;
+          jacobian[camera_block.size + c] = 0.f;
+        }
+      }
+    }
+  }
+  return cost;
+}
+
+/// Damping of a diagonal coefficient
+inline float Damping(const float diagonal, const double mu)
+{
+  return static_cast<float>(mu * std::min(std::max(static_cast<double>(diagonal), kMinDiagonal), kMaxDiagonal));
+}
+
+inline double SquaredNorm(const Eigen::VectorXf & x)
+{
+  return x.cast<double>().squaredNorm();
+}
+
+/// The mixed precision Levenberg-Marquardt problem
+class Mixed_Precision_Problem
+{
+  public:
+  Mixed_Precision_Problem
+  (
+    std::vector<Camera_Block> && camera_blocks,
+    std::vector<Landmark_Block> && landmark_blocks,
+    std::vector<Residual_Block> && residual_blocks,
+    const bool use_loss,
+    const int nb_threads
+  ):
+    camera_blocks_(std::move(camera_blocks)),
+    landmark_blocks_(std::move(landmark_blocks)),
+    residual_blocks_(std::move(residual_blocks)),
+    use_loss_(use_loss),
+    nb_threads_(std::max(1, nb_threads))
+  {
+    BuildStructure();
+  }
+
+  /// Evaluate the cost (and linearize the problem if asked)
+  bool Evaluate(const bool b_linearize, double & cost);
+
+  /// Compute the Levenberg-Marquardt step for the damping mu
+  int ComputeStep(const double mu, const double tolerance, const int max_iterations);
+
+  /// Cost decrease predicted by the linearized problem for the current step
+  double PredictedDecrease() const;
+
+  /// Infinity norm of the gradient (variable parameters)
+  double GradientMaxNorm() const;
+
+  double StepNorm() const;
+  double ParameterNorm() const;
+
+  /// Apply the current step (a copy of the parameters is kept to undo it)
+  void ApplyStep();
+  void UndoStep();
+
+  size_t NumResiduals() const { return residual_blocks_.size(); }
+  size_t NumCameraParameters() const { return camera_step_.size(); }
+
+  private:
+  void BuildStructure();
+  void BuildReducedCameraSystem(const double mu);
+  int SolveReducedCameraSystem(const double tolerance, const int max_iterations);
+  void MultiplyReducedCameraSystem(const Eigen::VectorXf & x, Eigen::VectorXf & y) const;
+
+  std::vector<Camera_Block> camera_blocks_;
+  std::vector<Landmark_Block> landmark_blocks_;
+  std::vector<Residual_Block> residual_blocks_;
+  bool use_loss_;
+  int nb_threads_;
+
+  // Reduced camera system (single precision, full block storage)
+  std::vector<float> reduced_camera_system_;
+  Eigen::VectorXf reduced_rhs_;
+  Eigen::VectorXf camera_gradient_;
+  Eigen::VectorXf camera_damping_;
+  Eigen::VectorXf camera_step_;
+  // Inverse of the diagonal blocks (block Jacobi preconditioner)
+  std::vector<RowMatrixXf> preconditioner_;
+
+  // Parameters before the last step
+  std::vector<std::vector<double>> camera_backup_;
+  std::vector<Vec3> landmark_backup_;
+};
+
+void Mixed_Precision_Problem::BuildStructure()
+{
+  int nb_camera_parameters = 0;
+  for (Camera_Block & camera_block : camera_blocks_)
+  {
+    camera_block.offset = nb_camera_parameters;
+    nb_camera_parameters += camera_block.size;
+  }
+
+  // Link the residuals and the blocks
+  std::vector<std::set<int>> rows(camera_blocks_.size());
+  for (int k = 0; k < static_cast<int>(residual_blocks_.size()); ++k)
+  {
+    Residual_Block & residual_block = residual_blocks_[k];
+    landmark_blocks_[residual_block.landmark].residuals.push_back(k);
+    size_t jacobian_size = 0;
+    const auto & block_sizes = residual_block.cost_function->parameter_block_sizes();
+    for (size_t i = 0; i < residual_block.parameters.size(); ++i)
+    {
+      residual_block.jacobian_offsets[i] = jacobian_size;
+      jacobian_size += 2 * block_sizes[i];
+    }
+    residual_block.jacobians.resize(jacobian_size);
+    for (int i = 0; i < residual_block.nb_camera_parameters; ++i)
+    {
+      const int a = residual_block.camera_blocks[i];
+      if (a < 0)
+        continue;
+      camera_blocks_[a].residuals.push_back(k);
+      for (int j = 0; j < residual_block.nb_camera_parameters; ++j)
+        if (residual_block.camera_blocks[j] >= 0)
+          rows[a].insert(residual_block.camera_blocks[j]);
+    }
+  }
+
+  // The landmark elimination links all the camera blocks of a landmark
+  for (int p = 0; p < static_cast<int>(landmark_blocks_.size()); ++p)
+  {
+    Landmark_Block & landmark_block = landmark_blocks_[p];
+    if (!landmark_block.is_variable)
+      continue;
+    std::set<int> landmark_camera_blocks;
+    for (const int k : landmark_block.residuals)
+      for (int i = 0; i < residual_blocks_[k].nb_camera_parameters; ++i)
+        if (residual_blocks_[k].camera_blocks[i] >= 0)
+          landmark_camera_blocks.insert(residual_blocks_[k].camera_blocks[i]);
+    landmark_block.camera_blocks.assign(landmark_camera_blocks.begin(), landmark_camera_blocks.end());
+    size_t w_size = 0;
+    for (const int a : landmark_block.camera_blocks)
+    {
+      landmark_block.w_offsets.push_back(w_size);
+      w_size += camera_blocks_[a].size * 3;
+      camera_blocks_[a].landmarks.push_back(p);
+      rows[a].insert(landmark_block.camera_blocks.begin(), landmark_block.camera_blocks.end());
+    }
+    landmark_block.w.resize(w_size);
+    for (const int k : landmark_block.residuals)
+      for (int i = 0; i < residual_blocks_[k].nb_camera_parameters; ++i)
+        if (residual_blocks_[k].camera_blocks[i] >= 0)
+          residual_blocks_[k].landmark_slots[i] = landmark_block.Slot(residual_blocks_[k].camera_blocks[i]);
+  }
+
+  // Storage of the reduced camera system blocks
+  size_t storage_size = 0;
+  for (size_t a = 0; a < camera_blocks_.size(); ++a)
+  {
+    for (const int b : rows[a])
+    {
+      camera_blocks_[a].row.emplace_back(b, storage_size);
+      storage_size += camera_blocks_[a].size * camera_blocks_[b].size;
+    }
+  }
+  reduced_camera_system_.resize(storage_size);
+  reduced_rhs_.resize(nb_camera_parameters);
+  camera_gradient_.resize(nb_camera_parameters);
+  camera_damping_.resize(nb_camera_parameters);
+  camera_step_ = Eigen::VectorXf::Zero(nb_camera_parameters);
+  preconditioner_.resize(camera_blocks_.size());
+}
+
+bool Mixed_Precision_Problem::Evaluate(const bool b_linearize, double & cost)
+{
+  cost = 0.0;
+  int nb_invalid_residuals = 0;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(nb_threads_) reduction(+:cost, nb_invalid_residuals)
+#endif
+  for (int p = 0; p < static_cast<int>(landmark_blocks_.size()); ++p)
+  {
+    Landmark_Block & landmark_block = landmark_blocks_[p];
+    if (b_linearize && landmark_block.is_variable)
+    {
+      landmark_block.v.setZero();
+      landmark_block.gradient.setZero();
+      std::fill(landmark_block.w.begin(), landmark_block.w.end(), 0.f);
+    }
+    for (const int k : landmark_block.residuals)
+    {
+      Residual_Block & residual_block = residual_blocks_[k];
+      const double residual_cost = EvaluateResidual(residual_block, camera_blocks_,
+        landmark_block.is_variable, use_loss_, b_linearize);
+      if (residual_cost < 0.0)
+      {
+        ++nb_invalid_residuals;
+        continue;
+      }
+      cost += residual_cost;
+      if (!b_linearize || !landmark_block.is_variable)
+        continue;
+
+      // Landmark normal equations and W = J_c^T J_X blocks
+      const size_t landmark_parameter = residual_block.parameters.size() - 1;
+      const Eigen::Map<const Eigen::Matrix<float, 2, 3, Eigen::RowMajor>> J_X(
+        &residual_block.jacobians[residual_block.jacobian_offsets[landmark_parameter]]);
+      landmark_block.v.noalias() += J_X.transpose() * J_X;
+      landmark_block.gradient.noalias() += J_X.transpose() * residual_block.residual;
+      for (int i = 0; i < residual_block.nb_camera_parameters; ++i)
+      {
+        const int a = residual_block.camera_blocks[i];
+        if (a < 0)
+          continue;
+        const int size = camera_blocks_[a].size;
+        const ConstMapMatrixXf J_c(&residual_block.jacobians[residual_block.jacobian_offsets[i]], 2, size);
+        MapMatrixXf W(&landmark_block.w[landmark_block.w_offsets[residual_block.landmark_slots[i]]], size, 3);
+        W.noalias() += J_c.transpose() * J_X;
+      }
+    }
+  }
+  return nb_invalid_residuals == 0;
+}
+
+void Mixed_Precision_Problem::BuildReducedCameraSystem(const double mu)
+{
+  // Damped landmark systems
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(nb_threads_)
+#endif
+  for (int p = 0; p < static_cast<int>(landmark_blocks_.size()); ++p)
+  {
+    Landmark_Block & landmark_block = landmark_blocks_[p];
+    if (!landmark_block.is_variable)
+      continue;
+    Eigen::Matrix3f v = landmark_block.v;
+    for (int i = 0; i < 3; ++i)
+    {
+      landmark_block.damping(i) = Damping(v(i, i), mu);
+      v(i, i) += landmark_block.damping(i);
+    }
+    landmark_block.v_inverse = v.inverse();
+  }
+
+  // Reduced camera system: S = U - W V^-1 W^T, rhs = g_c - W V^-1 g_X
+  // Each row of blocks is assembled by a single thread.
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(nb_threads_)
+#endif
+  for (int a = 0; a < static_cast<int>(camera_blocks_.size()); ++a)
+  {
+    const Camera_Block & camera_block = camera_blocks_[a];
+    const int size_a = camera_block.size;
+    for (const auto & row_block : camera_block.row)
+    {
+      if (row_block.first >= a)
+        std::fill_n(&reduced_camera_system_[row_block.second],
+                    size_a * camera_blocks_[row_block.first].size, 0.f);
+    }
+    Eigen::VectorXf gradient = Eigen::VectorXf::Zero(size_a);
+
+    // U = J_c^T J_c, g_c = J_c^T r
+    for (const int k : camera_block.residuals)
+    {
+      const Residual_Block & residual_block = residual_blocks_[k];
+      const int i = (residual_block.camera_blocks[0] == a) ? 0 : 1;
+      const ConstMapMatrixXf J_a(&residual_block.jacobians[residual_block.jacobian_offsets[i]], 2, size_a);
+      gradient.noalias() += J_a.transpose() * residual_block.residual;
+      for (int j = 0; j < residual_block.nb_camera_parameters; ++j)
+      {
+        const int b = residual_block.camera_blocks[j];
+        if (b < a)
+          continue;
+        const int size_b = camera_blocks_[b].size;
+        const ConstMapMatrixXf J_b(&residual_block.jacobians[residual_block.jacobian_offsets[j]], 2, size_b);
+        MapMatrixXf S_ab(&reduced_camera_system_[camera_block.RowBlockOffset(b)], size_a, size_b);
+        S_ab.noalias() += J_a.transpose() * J_b;
+      }
+    }
+
+    // Levenberg-Marquardt damping
+    MapMatrixXf S_aa(&reduced_camera_system_[camera_block.RowBlockOffset(a)], size_a, size_a);
+    for (int i = 0; i < size_a; ++i)
+    {
+      camera_damping_(camera_block.offset + i) = Damping(S_aa(i, i), mu);
+      S_aa(i, i) += camera_damping_(camera_block.offset + i);
+    }
+    camera_gradient_.segment(camera_block.offset, size_a) = gradient;
+
+    // Landmark elimination
+    Eigen::VectorXf rhs = gradient;
+    RowMatrixXf T(size_a, 3);
+    for (const int p : camera_block.landmarks)
+    {
+      const Landmark_Block & landmark_block = landmark_blocks_[p];
+      const ConstMapMatrixXf W_a(&landmark_block.w[landmark_block.w_offsets[landmark_block.Slot(a)]], size_a, 3);
+      T.noalias() = W_a * landmark_block.v_inverse;
+      rhs.noalias() -= T * landmark_block.gradient;
+      for (size_t slot = 0; slot < landmark_block.camera_blocks.size(); ++slot)
+      {
+        const int b = landmark_block.camera_blocks[slot];
+        if (b < a)
+          continue;
+        const int size_b = camera_blocks_[b].size;
+        const ConstMapMatrixXf W_b(&landmark_block.w[landmark_block.w_offsets[slot]], size_b, 3);
+        MapMatrixXf S_ab(&reduced_camera_system_[camera_block.RowBlockOffset(b)], size_a, size_b);
+        S_ab.noalias() -= T * W_b.transpose();
+      }
+    }
+
+    // The constant parameters get a null step
+    for (int i = 0; i < size_a; ++i)
+    {
+      if (camera_block.is_constant[i])
+      {
+        S_aa(i, i) = 1.f;
+        rhs(i) = 0.f;
+      }
+    }
+    reduced_rhs_.segment(camera_block.offset, size_a) = rhs;
+  }
+
+  // Fill the lower blocks (S is symmetric) and invert the diagonal blocks
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(nb_threads_)
+#endif
+  for (int a = 0; a < static_cast<int>(camera_blocks_.size()); ++a)
+  {
+    const Camera_Block & camera_block = camera_blocks_[a];
+    for (const auto & row_block : camera_block.row)
+    {
+      const int b = row_block.first;
+      if (b <= a)
+        continue;
+      const ConstMapMatrixXf S_ab(&reduced_camera_system_[row_block.second], camera_block.size, camera_blocks_[b].size);
+      MapMatrixXf S_ba(&reduced_camera_system_[camera_blocks_[b].RowBlockOffset(a)], camera_blocks_[b].size, camera_block.size);
+      S_ba = S_ab.transpose();
+    }
+    const ConstMapMatrixXf S_aa(&reduced_camera_system_[camera_block.RowBlockOffset(a)], camera_block.size, camera_block.size);
+    preconditioner_[a] = S_aa.inverse();
+  }
+}
+
+void Mixed_Precision_Problem::MultiplyReducedCameraSystem
+(
+  const Eigen::VectorXf & x,
+  Eigen::VectorXf & y
+) const
+{
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(nb_threads_)
+#endif
+  for (int a = 0; a < static_cast<int>(camera_blocks_.size()); ++a)
+  {
+    const Camera_Block & camera_block = camera_blocks_[a];
+    Eigen::VectorXf y_a = Eigen::VectorXf::Zero(camera_block.size);
+    for (const auto & row_block : camera_block.row)
+    {
+      const Camera_Block & camera_block_b = camera_blocks_[row_block.first];
+      const ConstMapMatrixXf S_ab(&reduced_camera_system_[row_block.second], camera_block.size, camera_block_b.size);
+      y_a.noalias() += S_ab * x.segment(camera_block_b.offset, camera_block_b.size);
+    }
+    y.segment(camera_block.offset, camera_block.size) = y_a;
+  }
+}
+
+int Mixed_Precision_Problem::SolveReducedCameraSystem
+(
+  const double tolerance,
+  const int max_iterations
+)
+{
+  // Block Jacobi preconditioned conjugate gradient on S x = -rhs
+  const int n = reduced_rhs_.size();
+  Eigen::VectorXf & x = camera_step_;
+  x.setZero();
+  if (n == 0)
+    return 0;
+  Eigen::VectorXf r = -reduced_rhs_, z(n), p(n), q(n);
+  const double rhs_norm = std::sqrt(SquaredNorm(r));
+  if (rhs_norm == 0.0)
+    return 0;
+
+  const auto precondition = [&](const Eigen::VectorXf & in, Eigen::VectorXf & out)
+  {
+    for (size_t a = 0; a < camera_blocks_.size(); ++a)
+    {
+      const Camera_Block & camera_block = camera_blocks_[a];
+      out.segment(camera_block.offset, camera_block.size).noalias() =
+        preconditioner_[a] * in.segment(camera_block.offset, camera_block.size);
+    }
+  };
+
+  precondition(r, z);
+  p = z;
+  double rz = r.cast<double>().dot(z.cast<double>());
+  int iteration = 0;
+  while (iteration < max_iterations)
+  {
+    ++iteration;
+    MultiplyReducedCameraSystem(p, q);
+    const double pq = p.cast<double>().dot(q.cast<double>());
+    if (pq <= 0.0)
+      break;
+    const float alpha = static_cast<float>(rz / pq);
+    x += alpha * p;
+    r -= alpha * q;
+    if (std::sqrt(SquaredNorm(r)) <= tolerance * rhs_norm)
+      break;
+    precondition(r, z);
+    const double rz_next = r.cast<double>().dot(z.cast<double>());
+    p = z + static_cast<float>(rz_next / rz) * p;
+    rz = rz_next;
+  }
+  return iteration;
+}
+
+int Mixed_Precision_Problem::ComputeStep
+(
+  const double mu,
+  const double tolerance,
+  const int max_iterations
+)
+{
+  BuildReducedCameraSystem(mu);
+  const int nb_iterations = SolveReducedCameraSystem(tolerance, max_iterations);
+
+  // Back substitution: dX = -V^-1 (g_X + W^T dc)
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(nb_threads_)
+#endif
+  for (int p = 0; p < static_cast<int>(landmark_blocks_.size()); ++p)
+  {
+    Landmark_Block & landmark_block = landmark_blocks_[p];
+    if (!landmark_block.is_variable)
+      continue;
+    Eigen::Vector3f rhs = landmark_block.gradient;
+    for (size_t slot = 0; slot < landmark_block.camera_blocks.size(); ++slot)
+    {
+      const Camera_Block & camera_block = camera_blocks_[landmark_block.camera_blocks[slot]];
+      const ConstMapMatrixXf W(&landmark_block.w[landmark_block.w_offsets[slot]], camera_block.size, 3);
+      rhs.noalias() += W.transpose() * camera_step_.segment(camera_block.offset, camera_block.size);
+    }
+    landmark_block.step = -landmark_block.v_inverse * rhs;
+  }
+  return nb_iterations;
+}
+
+double Mixed_Precision_Problem::PredictedDecrease() const
+{
+  // 1/2 (|r|^2 - |r + J h|^2) summed over the residuals
+  double decrease = 0.0;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(nb_threads_) reduction(+:decrease)
+#endif
+  for (int k = 0; k < static_cast<int>(residual_blocks_.size()); ++k)
+  {
+    const Residual_Block & residual_block = residual_blocks_[k];
+    Eigen::Vector2f Jh = Eigen::Vector2f::Zero();
+    for (int i = 0; i < residual_block.nb_camera_parameters; ++i)
+    {
+      const int a = residual_block.camera_blocks[i];
+      if (a < 0)
+        continue;
+      const Camera_Block & camera_block = camera_blocks_[a];
+      const ConstMapMatrixXf J_a(&residual_block.jacobians[residual_block.jacobian_offsets[i]], 2, camera_block.size);
+      Jh.noalias() += J_a * camera_step_.segment(camera_block.offset, camera_block.size);
+    }
+    const Landmark_Block & landmark_block = landmark_blocks_[residual_block.landmark];
+    if (landmark_block.is_variable)
+    {
+      const Eigen::Map<const Eigen::Matrix<float, 2, 3, Eigen::RowMajor>> J_X(
+        &residual_block.jacobians[residual_block.jacobian_offsets[residual_block.parameters.size() - 1]]);
+      Jh.noalias() += J_X * landmark_block.step;
+    }
+    const Eigen::Vector2d r = residual_block.residual.cast<double>();
+    decrease += 0.5 * (r.squaredNorm() - (r + Jh.cast<double>()).squaredNorm());
+  }
+  return decrease;
+}
+
+double Mixed_Precision_Problem::GradientMaxNorm() const
+{
+  double max_norm = 0.0;
+  for (const Camera_Block & camera_block : camera_blocks_)
+    for (int i = 0; i < camera_block.size; ++i)
+      if (!camera_block.is_constant[i])
+        max_norm = std::max(max_norm, std::abs(static_cast<double>(camera_gradient_(camera_block.offset + i))));
+  for (const Landmark_Block & landmark_block : landmark_blocks_)
+    if (landmark_block.is_variable)
+      max_norm = std::max(max_norm, static_cast<double>(landmark_block.gradient.cwiseAbs().maxCoeff()));
+  return max_norm;
+}
+
+double Mixed_Precision_Problem::StepNorm() const
+{
+  double squared_norm = SquaredNorm(camera_step_);
+  for (const Landmark_Block & landmark_block : landmark_blocks_)
+    if (landmark_block.is_variable)
+      squared_norm += landmark_block.step.cast<double>().squaredNorm();
+  return std::sqrt(squared_norm);
+}
+
+double Mixed_Precision_Problem::ParameterNorm() const
+{
+  double squared_norm = 0.0;
+  for (const Camera_Block & camera_block : camera_blocks_)
+    squared_norm += Eigen::Map<const Vec>(camera_block.parameters, camera_block.size).squaredNorm();
+  for (const Landmark_Block & landmark_block : landmark_blocks_)
+    if (landmark_block.is_variable)
+      squared_norm += Eigen::Map<const Vec3>(landmark_block.X).squaredNorm();
+  return std::sqrt(squared_norm);
+}
+
+void Mixed_Precision_Problem::ApplyStep()
+{
+  camera_backup_.resize(camera_blocks_.size());
+  for (size_t a = 0; a < camera_blocks_.size(); ++a)
+  {
+    Camera_Block & camera_block = camera_blocks_[a];
+    camera_backup_[a].assign(camera_block.parameters, camera_block.parameters + camera_block.size);
+    for (int i = 0; i < camera_block.size; ++i)
+      camera_block.parameters[i] += camera_step_(camera_block.offset + i);
+  }
+  landmark_backup_.resize(landmark_blocks_.size());
+  for (size_t p = 0; p < landmark_blocks_.size(); ++p)
+  {
+    Landmark_Block & landmark_block = landmark_blocks_[p];
+    if (!landmark_block.is_variable)
+      continue;
+    Eigen::Map<Vec3> X(landmark_block.X);
+    landmark_backup_[p] = X;
+    X += landmark_block.step.cast<double>();
+  }
+}
+
+void Mixed_Precision_Problem::UndoStep()
+{
+  for (size_t a = 0; a < camera_blocks_.size(); ++a)
+    std::copy(camera_backup_[a].begin(), camera_backup_[a].end(), camera_blocks_[a].parameters);
+  for (size_t p = 0; p < landmark_blocks_.size(); ++p)
+    if (landmark_blocks_[p].is_variable)
+      Eigen::Map<Vec3>(landmark_blocks_[p].X) = landmark_backup_[p];
+}
+
+} // namespace
+
+Bundle_Adjustment_Mixed_Precision::Bundle_Adjustment_Mixed_Precision
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const Mixed_Precision_options & mixed_precision_options
+)
+: ceres_options_(ceres_options),
+  mixed_precision_options_(mixed_precision_options)
+{}
+
+Bundle_Adjustment_Ceres::BA_Ceres_options &
+Bundle_Adjustment_Mixed_Precision::ceres_options()
+{
+  return ceres_options_;
+}
+
+Bundle_Adjustment_Mixed_Precision::Mixed_Precision_options &
+Bundle_Adjustment_Mixed_Precision::mixed_precision_options()
+{
+  return mixed_precision_options_;
+}
+
+bool Bundle_Adjustment_Mixed_Precision::Adjust
+(
+  SfM_Data & sfm_data,     // the SfM scene to refine
+  const Optimize_Options & options
+)
+{
+  if (options.use_motion_priors_opt || options.control_point_opt.bUse_control_points)
+  {
+    // Pose priors and GCP are handled by the double precision solver
+    Bundle_Adjustment_Ceres bundle_adjustment_obj(ceres_options_);
+    return bundle_adjustment_obj.Adjust(sfm_data, options);
+  }
+
+  OPENMVG_PROFILE_ZONE("BA_Mixed_Precision");
+  const system::Timer timer;
+
+  // Express the scene in a frame centred on the landmarks:
+  //  the single precision Jacobians are computed on small coordinates.
+  Vec3 center = Vec3::Zero();
+  if (mixed_precision_options_.bLandmark_centered_frame_ && !sfm_data.structure.empty())
+  {
+    for (const auto & landmark_it : sfm_data.structure)
+      center += landmark_it.second.X;
+    center /= static_cast<double>(sfm_data.structure.size());
+  }
+
+  // Parameters (double precision)
+  Hash_Map<IndexT, std::vector<double>> map_poses;
+  Hash_Map<IndexT, std::vector<double>> map_intrinsics;
+  std::vector<Vec3> landmark_positions;
+  landmark_positions.reserve(sfm_data.structure.size());
+
+  std::vector<Camera_Block> camera_blocks;
+  Hash_Map<IndexT, int> pose_blocks, intrinsic_blocks;
+
+  for (const auto & pose_it : sfm_data.poses)
+  {
+    // angleAxis + translation (landmark centred frame)
+    const Pose3 pose(pose_it.second.rotation(), pose_it.second.center() - center);
+    std::vector<double> & parameter_block = map_poses[pose_it.first];
+    parameter_block.resize(6);
+    const Mat3 R = pose.rotation();
+    ceres::RotationMatrixToAngleAxis((const double*)R.data(), parameter_block.data());
+    parameter_block[3] = pose.translation()(0);
+    parameter_block[4] = pose.translation()(1);
+    parameter_block[5] = pose.translation()(2);
+
+    if (options.extrinsics_opt == Extrinsic_Parameter_Type::NONE)
+      continue;
+    Camera_Block camera_block;
+    camera_block.parameters = parameter_block.data();
+    camera_block.size = 6;
+    camera_block.is_constant.assign(6, false);
+    if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
+      std::fill_n(camera_block.is_constant.begin(), 3, true);
+    if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
+      std::fill_n(camera_block.is_constant.begin() + 3, 3, true);
+    pose_blocks[pose_it.first] = camera_blocks.size();
+    camera_blocks.push_back(std::move(camera_block));
+  }
+
+  for (const auto & intrinsic_it : sfm_data.intrinsics)
+  {
+    if (!isValid(intrinsic_it.second->getType()))
+    {
+      OPENMVG_LOG_ERROR << "Unsupported camera type.";
+      continue;
+    }
+    std::vector<double> & parameter_block = map_intrinsics[intrinsic_it.first];
+    parameter_block = intrinsic_it.second->getParams();
+    if (parameter_block.empty() || options.intrinsics_opt == Intrinsic_Parameter_Type::NONE)
+      continue;
+    Camera_Block camera_block;
+    camera_block.parameters = parameter_block.data();
+    camera_block.size = parameter_block.size();
+    camera_block.is_constant.assign(parameter_block.size(), false);
+    for (const int i : intrinsic_it.second->subsetParameterization(options.intrinsics_opt))
+      camera_block.is_constant[i] = true;
+    if (std::count(camera_block.is_constant.begin(), camera_block.is_constant.end(), true)
+        == camera_block.size)
+      continue;
+    intrinsic_blocks[intrinsic_it.first] = camera_blocks.size();
+    camera_blocks.push_back(std::move(camera_block));
+  }
+
+  // Landmarks and reprojection residuals
+  const bool b_variable_structure = (options.structure_opt == Structure_Parameter_Type::ADJUST_ALL);
+  std::vector<Landmark_Block> landmark_blocks(sfm_data.structure.size());
+  std::vector<Residual_Block> residual_blocks;
+  for (const auto & structure_landmark_it : sfm_data.structure)
+  {
+    const int p = landmark_positions.size();
+    landmark_positions.push_back(structure_landmark_it.second.X - center);
+    landmark_blocks[p].X = landmark_positions.back().data();
+    landmark_blocks[p].is_variable = b_variable_structure;
+
+    for (const auto & obs_it : structure_landmark_it.second.obs)
+    {
+      const View * view = sfm_data.views.at(obs_it.first).get();
+      Residual_Block residual_block;
+      residual_block.cost_function.reset(
+        IntrinsicsToCostFunction(sfm_data.intrinsics.at(view->id_intrinsic).get(),
+                                 obs_it.second.x,
+                                 0.0,
+                                 ceres_options_.bUse_analytic_jacobians_));
+      if (!residual_block.cost_function)
+      {
+        OPENMVG_LOG_ERROR << "Cannot create a CostFunction for this camera model.";
+        return false;
+      }
+      residual_block.camera_blocks = {{-1, -1}};
+      residual_block.landmark_slots = {{-1, -1}};
+      residual_block.nb_camera_parameters = 0;
+      std::vector<double> & intrinsic_parameters = map_intrinsics.at(view->id_intrinsic);
+      if (!intrinsic_parameters.empty())
+      {
+        const auto block_it = intrinsic_blocks.find(view->id_intrinsic);
+        residual_block.camera_blocks[residual_block.nb_camera_parameters++] =
+          (block_it != intrinsic_blocks.end()) ? block_it->second : -1;
+        residual_block.parameters.push_back(intrinsic_parameters.data());
+      }
+      const auto block_it = pose_blocks.find(view->id_pose);
+      residual_block.camera_blocks[residual_block.nb_camera_parameters++] =
+        (block_it != pose_blocks.end()) ? block_it->second : -1;
+      residual_block.parameters.push_back(map_poses.at(view->id_pose).data());
+      residual_block.parameters.push_back(landmark_blocks[p].X);
+      residual_block.landmark = p;
+      residual_blocks.push_back(std::move(residual_block));
+    }
+  }
+
+  // Levenberg-Marquardt iterations
+  Mixed_Precision_Problem problem(
+    std::move(camera_blocks), std::move(landmark_blocks), std::move(residual_blocks),
+    ceres_options_.bUse_loss_function_, ceres_options_.nb_threads_);
+
+  double cost = 0.0;
+  if (!problem.Evaluate(true, cost))
+  {
+    OPENMVG_LOG_ERROR << "Cannot evaluate the residuals. Bundle Adjustment failed.";
+    return false;
+  }
+  const double initial_cost = cost;
+  double mu = kInitialDamping, nu = 2.0;
+  int iteration = 0, nb_linear_iterations = 0;
+  bool b_linearized = true;
+  while (iteration < ceres_options_.max_num_iterations_ && problem.NumResiduals() > 0)
+  {
+    ++iteration;
+    if (b_linearized && problem.GradientMaxNorm() <= ceres_options_.gradient_tolerance_)
+      break;
+    b_linearized = false;
+
+    nb_linear_iterations += problem.ComputeStep(mu,
+      mixed_precision_options_.linear_solver_tolerance_,
+      ceres_options_.max_linear_solver_iterations_);
+    if (problem.StepNorm() <= ceres_options_.parameter_tolerance_
+        * (problem.ParameterNorm() + ceres_options_.parameter_tolerance_))
+      break;
+
+    const double predicted_decrease = problem.PredictedDecrease();
+    problem.ApplyStep();
+    double new_cost = 0.0;
+    const bool b_valid = problem.Evaluate(false, new_cost);
+    const double relative_decrease = (predicted_decrease > 0.0 && b_valid)
+      ? (cost - new_cost) / predicted_decrease
+      : -1.0;
+    if (relative_decrease > kMinRelativeDecrease)
+    {
+      // Successful step: decrease the damping
+      mu *= std::max(1.0 / 3.0, 1.0 - std::pow(2.0 * relative_decrease - 1.0, 3));
+      nu = 2.0;
+      const bool b_converged = (cost - new_cost) <= kFunctionTolerance * cost;
+      problem.Evaluate(true, cost);
+      b_linearized = true;
+      if (b_converged)
+        break;
+    }
+    else
+    {
+      // Unsuccessful step: increase the damping
+      problem.UndoStep();
+      mu *= nu;
+      nu *= 2.0;
+      if (mu > kMaxDamping)
+        break;
+    }
+  }
+
+  if (!std::isfinite(cost))
+  {
+    OPENMVG_LOG_ERROR << "The solution is not usable. Bundle Adjustment failed.";
+    return false;
+  }
+
+  if (ceres_options_.bVerbose_)
+  {
+    // Display statistics about the minimization
+    const double nb_residuals = std::max<double>(1.0, 2.0 * problem.NumResiduals());
+    OPENMVG_LOG_INFO
+      << "\nMixed precision Bundle Adjustment statistics (approximated RMSE):\n"
+      << " #views: " << sfm_data.views.size() << "\n"
+      << " #poses: " << sfm_data.poses.size() << "\n"
+      << " #intrinsics: " << sfm_data.intrinsics.size() << "\n"
+      << " #tracks: " << sfm_data.structure.size() << "\n"
+      << " #residuals: " << 2 * problem.NumResiduals() << "\n"
+      << " #camera parameters: " << problem.NumCameraParameters() << "\n"
+      << " #iterations: " << iteration << " (PCG: " << nb_linear_iterations << ")\n"
+      << " Initial RMSE: " << std::sqrt(2.0 * initial_cost / nb_residuals) << "\n"
+      << " Final RMSE: " << std::sqrt(2.0 * cost / nb_residuals) << "\n"
+      << " Time (s): " << timer.elapsedMs() / 1000.0;
+  }
+
+  // Update camera poses with refined data
+  if (options.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+  {
+    for (auto & pose_it : sfm_data.poses)
+    {
+      const std::vector<double> & parameter_block = map_poses.at(pose_it.first);
+      Mat3 R_refined;
+      ceres::AngleAxisToRotationMatrix(parameter_block.data(), R_refined.data());
+      const Vec3 t_refined(parameter_block[3], parameter_block[4], parameter_block[5]);
+      if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
+      {
+        // Update only rotation
+        pose_it.second.rotation() = R_refined;
+      }
+      else
+      {
+        const Vec3 C_refined = -R_refined.transpose() * t_refined + center;
+        if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
+          pose_it.second.center() = C_refined; // Update only translation
+        else
+          pose_it.second = Pose3(R_refined, C_refined);
+      }
+    }
+  }
+
+  // Update camera intrinsics with refined data
+  if (options.intrinsics_opt != Intrinsic_Parameter_Type::NONE)
+  {
+    for (auto & intrinsic_it : sfm_data.intrinsics)
+    {
+      const auto parameters_it = map_intrinsics.find(intrinsic_it.first);
+      if (parameters_it != map_intrinsics.end())
+        intrinsic_it.second->updateFromParams(parameters_it->second);
+    }
+  }
+
+  // Update the structure (back to the scene frame)
+  if (b_variable_structure)
+  {
+    size_t p = 0;
+    for (auto & structure_landmark_it : sfm_data.structure)
+      structure_landmark_it.second.X = landmark_positions[p++] + center;
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace openMVG
@@ -0,0 +1,83 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_BA_MIXED_PRECISION_HPP
+#define OPENMVG_SFM_SFM_DATA_BA_MIXED_PRECISION_HPP
+
+#include "openMVG/sfm/sfm_data_BA.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+struct SfM_Data;
+
+/**
+* @brief Mixed precision bundle adjustment (Levenberg-Marquardt).
+*
+* The parameters and the cost are kept in double precision, while the
+* linearized problem is handled in single precision:
+*  - the Jacobians of the reprojection residuals (same cost functions as
+*    Bundle_Adjustment_Ceres) are stored as float,
+*  - the landmarks are eliminated (Schur complement) and the reduced camera
+*    system is assembled in float,
+*  - the reduced camera system is solved by a float block-Jacobi
+*    preconditioned conjugate gradient.
+* It halves the memory traffic of the linear solver and is meant for the
+* intermediate refinements of a reconstruction: the final refinement should
+* use Bundle_Adjustment_Ceres (double precision).
+*
+* The scene is expressed in a landmark centred frame during the solve to keep
+* the coordinates small and the single precision Jacobians accurate.
+*
+* Pose priors and ground control points are not handled by this solver:
+* such configurations are adjusted by Bundle_Adjustment_Ceres.
+*/
+class Bundle_Adjustment_Mixed_Precision : public Bundle_Adjustment
+{
+  public:
+  struct Mixed_Precision_options
+  {
+    double linear_solver_tolerance_; // PCG stopping criterion (relative residual norm)
+    bool bLandmark_centered_frame_; // Solve in a frame centred on the landmarks
+
+    Mixed_Precision_options
+    (
+      const double linear_solver_tolerance = 1e-4,
+      const bool bLandmark_centered_frame = true
+    );
+  };
+
+  explicit Bundle_Adjustment_Mixed_Precision
+  (
+    const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options =
+      Bundle_Adjustment_Ceres::BA_Ceres_options(),
+    const Mixed_Precision_options & mixed_precision_options =
+      Mixed_Precision_options()
+  );
+
+  /// Shared settings (verbosity, threads, loss function, iterations, tolerances)
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options();
+
+  Mixed_Precision_options & mixed_precision_options();
+
+  bool Adjust
+  (
+    // the SfM scene to refine
+    sfm::SfM_Data & sfm_data,
+    // tell which parameter needs to be adjusted
+    const Optimize_Options & options
+  ) override;
+
+  private:
+  Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options_;
+  Mixed_Precision_options mixed_precision_options_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_BA_MIXED_PRECISION_HPP
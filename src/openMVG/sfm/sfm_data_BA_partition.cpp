@@ -0,0 +1,221 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_data_BA_partition.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace openMVG {
+namespace sfm {
+
+Pose_Covisibility_Graph ComputePoseCovisibility
+(
+  const SfM_Data & sfm_data
+)
+{
+  Pose_Covisibility_Graph covisibility;
+  for (const auto & view_it : sfm_data.GetViews())
+  {
+    if (sfm_data.IsPoseAndIntrinsicDefined(view_it.second.get()))
+      covisibility[view_it.second->id_pose];
+  }
+
+  std::vector<IndexT> landmark_poses;
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+  {
+    landmark_poses.clear();
+    for (const auto & obs_it : landmark_it.second.obs)
+    {
+      const auto view_it = sfm_data.GetViews().find(obs_it.first);
+      if (view_it != sfm_data.GetViews().end()
+          && sfm_data.IsPoseAndIntrinsicDefined(view_it->second.get()))
+      {
+        landmark_poses.push_back(view_it->second->id_pose);
+      }
+    }
+    // A pose can observe a landmark through several views (camera rigs)
+    std::sort(landmark_poses.begin(), landmark_poses.end());
+    landmark_poses.erase(std::unique(landmark_poses.begin(), landmark_poses.end()),
+      landmark_poses.end());
+    for (size_t i = 0; i < landmark_poses.size(); ++i)
+    {
+      for (size_t j = i + 1; j < landmark_poses.size(); ++j)
+      {
+        ++covisibility[landmark_poses[i]][landmark_poses[j]];
+        ++covisibility[landmark_poses[j]][landmark_poses[i]];
+      }
+    }
+  }
+  return covisibility;
+}
+
+namespace {
+
+/// Number of landmarks shared between a pose and a set of poses
+unsigned int ConnectionWeight
+(
+  const Pose_Covisibility_Graph & covisibility,
+  const IndexT pose_id,
+  const std::set<IndexT> & poses
+)
+{
+  unsigned int weight = 0;
+  for (const auto & neighbor_it : covisibility.at(pose_id))
+  {
+    if (poses.count(neighbor_it.first))
+      weight += neighbor_it.second;
+  }
+  return weight;
+}
+
+} // namespace
+
+std::vector<BA_Pose_Cluster> PartitionPosesByCovisibility
+(
+  const SfM_Data & sfm_data,
+  const unsigned int max_cluster_size,
+  const double overlap_ratio
+)
+{
+  const Pose_Covisibility_Graph covisibility = ComputePoseCovisibility(sfm_data);
+
+  // Seed the clusters from the most connected poses
+  std::vector<std::pair<unsigned int, IndexT>> seeds;
+  seeds.reserve(covisibility.size());
+  for (const auto & node_it : covisibility)
+  {
+    unsigned int degree = 0;
+    for (const auto & neighbor_it : node_it.second)
+      degree += neighbor_it.second;
+    seeds.emplace_back(degree, node_it.first);
+  }
+  std::sort(seeds.begin(), seeds.end(),
+    [](const std::pair<unsigned int, IndexT> & a, const std::pair<unsigned int, IndexT> & b)
+    {
+      return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+
+  //--
+  // Grow the cluster cores
+  //--
+  const unsigned int cluster_size = std::max(1u, max_cluster_size);
+  std::vector<std::set<IndexT>> cores;
+  Hash_Map<IndexT, size_t> pose_to_core;
+  for (const auto & seed : seeds)
+  {
+    if (pose_to_core.count(seed.second))
+      continue;
+
+    const size_t core_id = cores.size();
+    cores.emplace_back();
+    std::set<IndexT> & core = cores.back();
+    // Unassigned neighbors ordered by their connection to the core
+    std::map<IndexT, unsigned int> frontier_weight;
+    std::set<std::pair<unsigned int, IndexT>> frontier;
+
+    IndexT pose_id = seed.second;
+    while (true)
+    {
+      core.insert(pose_id);
+      pose_to_core[pose_id] = core_id;
+      for (const auto & neighbor_it : covisibility.at(pose_id))
+      {
+        if (pose_to_core.count(neighbor_it.first))
+          continue;
+        unsigned int & weight = frontier_weight[neighbor_it.first];
+        frontier.erase({weight, neighbor_it.first});
+        weight += neighbor_it.second;
+        frontier.insert({weight, neighbor_it.first});
+      }
+      if (core.size() >= cluster_size || frontier.empty())
+        break;
+      pose_id = frontier.rbegin()->second;
+      frontier.erase(std::prev(frontier.end()));
+    }
+  }
+
+  //--
+  // Merge the small cores into their most connected neighbor core
+  //--
+  const size_t min_cluster_size = std::max(1u, cluster_size / 4);
+  for (size_t core_id = 0; core_id < cores.size(); ++core_id)
+  {
+    if (cores[core_id].empty() || cores[core_id].size() >= min_cluster_size)
+      continue;
+
+    std::map<size_t, unsigned int> neighbor_core_weights;
+    for (const IndexT pose_id : cores[core_id])
+    {
+      for (const auto & neighbor_it : covisibility.at(pose_id))
+      {
+        const size_t neighbor_core = pose_to_core.at(neighbor_it.first);
+        if (neighbor_core != core_id)
+          neighbor_core_weights[neighbor_core] += neighbor_it.second;
+      }
+    }
+    if (neighbor_core_weights.empty())
+      continue; // Disconnected poses: keep them as their own cluster
+
+    const size_t target_core = std::max_element(neighbor_core_weights.cbegin(),
+      neighbor_core_weights.cend(),
+      [](const std::pair<const size_t, unsigned int> & a,
+         const std::pair<const size_t, unsigned int> & b)
+      {
+        return a.second < b.second;
+      })->first;
+    for (const IndexT pose_id : cores[core_id])
+      pose_to_core[pose_id] = target_core;
+    cores[target_core].insert(cores[core_id].cbegin(), cores[core_id].cend());
+    cores[core_id].clear();
+  }
+
+  //--
+  // Extend each core with its most connected neighbor poses
+  //--
+  std::vector<BA_Pose_Cluster> clusters;
+  for (auto & core : cores)
+  {
+    if (core.empty())
+      continue;
+
+    BA_Pose_Cluster cluster;
+    cluster.core_poses = std::move(core);
+
+    std::set<IndexT> neighbors;
+    for (const IndexT pose_id : cluster.core_poses)
+    {
+      for (const auto & neighbor_it : covisibility.at(pose_id))
+      {
+        if (!cluster.core_poses.count(neighbor_it.first))
+          neighbors.insert(neighbor_it.first);
+      }
+    }
+    std::vector<std::pair<unsigned int, IndexT>> ranked_neighbors;
+    for (const IndexT pose_id : neighbors)
+    {
+      ranked_neighbors.emplace_back(
+        ConnectionWeight(covisibility, pose_id, cluster.core_poses), pose_id);
+    }
+    std::sort(ranked_neighbors.begin(), ranked_neighbors.end(),
+      [](const std::pair<unsigned int, IndexT> & a, const std::pair<unsigned int, IndexT> & b)
+      {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+      });
+    const size_t overlap_count = std::min(ranked_neighbors.size(),
+      static_cast<size_t>(std::ceil(std::max(0.0, overlap_ratio) * cluster.core_poses.size())));
+    for (size_t i = 0; i < overlap_count; ++i)
+      cluster.overlap_poses.insert(ranked_neighbors[i].second);
+
+    clusters.emplace_back(std::move(cluster));
+  }
+  return clusters;
+}
+
+} // namespace sfm
+} // namespace openMVG
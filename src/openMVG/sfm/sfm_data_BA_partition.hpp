@@ -0,0 +1,77 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_BA_PARTITION_HPP
+#define OPENMVG_SFM_SFM_DATA_BA_PARTITION_HPP
+
+#include "openMVG/types.hpp"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+struct SfM_Data;
+
+/// Pose covisibility graph: for each pose, the number of landmarks it shares
+///  with each of its neighbor poses
+using Pose_Covisibility_Graph = Hash_Map<IndexT, std::map<IndexT, unsigned int>>;
+
+/**
+* @brief Compute the covisibility between the poses of a scene from the
+*  landmark observations. Every defined pose is a node of the graph, even if
+*  it does not share any landmark.
+*/
+Pose_Covisibility_Graph ComputePoseCovisibility
+(
+  const SfM_Data & sfm_data
+);
+
+/// A cluster of poses used by the partitioned bundle adjustment
+struct BA_Pose_Cluster
+{
+  /// Poses owned by the cluster (each pose belongs to exactly one core)
+  std::set<IndexT> core_poses;
+  /// Poses owned by neighbor clusters, shared with this one (separators)
+  std::set<IndexT> overlap_poses;
+
+  /// Return all the poses of the cluster (core + overlap)
+  std::set<IndexT> poses() const
+  {
+    std::set<IndexT> all_poses = core_poses;
+    all_poses.insert(overlap_poses.cbegin(), overlap_poses.cend());
+    return all_poses;
+  }
+};
+
+/**
+* @brief Split the poses of a scene into overlapping clusters.
+*
+* The cores are grown greedily over the covisibility graph from the most
+* connected unassigned pose, always adding the pose sharing the most landmarks
+* with the cluster, until max_cluster_size poses are reached. Cores smaller
+* than a quarter of this size are merged into their most connected neighbor.
+* Each cluster is then extended by the neighbor poses it shares the most
+* landmarks with (up to overlap_ratio * core size poses).
+*
+* @param sfm_data The scene
+* @param max_cluster_size Maximal number of poses of a cluster core
+* @param overlap_ratio Number of overlap poses, relative to the core size
+* @return The clusters (deterministic order)
+*/
+std::vector<BA_Pose_Cluster> PartitionPosesByCovisibility
+(
+  const SfM_Data & sfm_data,
+  const unsigned int max_cluster_size,
+  const double overlap_ratio
+);
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_BA_PARTITION_HPP
@@ -0,0 +1,114 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_BA_partition.hpp"
+
+#include "testing/testing.h"
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::sfm;
+
+// A chain of poses: each landmark is seen by 'window' consecutive poses
+SfM_Data ChainScene
+(
+  const int nposes,
+  const int window
+)
+{
+  SfM_Data sfm_data;
+  sfm_data.intrinsics[0] = std::make_shared<Pinhole_Intrinsic>(1000, 1000, 1000.0, 500.0, 500.0);
+  for (int i = 0; i < nposes; ++i)
+  {
+    sfm_data.views[i] = std::make_shared<View>("", i, 0, i, 1000, 1000);
+    sfm_data.poses[i] = geometry::Pose3(Mat3::Identity(), Vec3(i, 0, 0));
+  }
+  IndexT landmark_id = 0;
+  for (int i = 0; i + window <= nposes; ++i)
+  {
+    for (int k = 0; k < 5; ++k)
+    {
+      Landmark & landmark = sfm_data.structure[landmark_id++];
+      landmark.X = Vec3(i, 0, 10);
+      for (int j = i; j < i + window; ++j)
+        landmark.obs[j] = Observation(Vec2(500, 500), k);
+    }
+  }
+  return sfm_data;
+}
+
+TEST(BA_PARTITION, Covisibility)
+{
+  const SfM_Data sfm_data = ChainScene(6, 3);
+  const Pose_Covisibility_Graph covisibility = ComputePoseCovisibility(sfm_data);
+  EXPECT_EQ(6, covisibility.size());
+  // Poses 0 and 1 are both in the window starting at 0 (5 landmarks)
+  EXPECT_EQ(5, covisibility.at(0).at(1));
+  // Poses 2 and 3 share the windows starting at 1 and 2
+  EXPECT_EQ(10, covisibility.at(2).at(3));
+  EXPECT_EQ(0, covisibility.at(0).count(3));
+}
+
+TEST(BA_PARTITION, OverlappingClusters)
+{
+  const SfM_Data sfm_data = ChainScene(40, 3);
+  const unsigned int max_cluster_size = 8;
+  const double overlap_ratio = 0.25;
+  const std::vector<BA_Pose_Cluster> clusters =
+    PartitionPosesByCovisibility(sfm_data, max_cluster_size, overlap_ratio);
+  EXPECT_TRUE(clusters.size() >= 4);
+
+  // Each pose belongs to exactly one core
+  std::map<IndexT, int> core_count;
+  for (const auto & cluster : clusters)
+  {
+    EXPECT_TRUE(cluster.core_poses.size() <= max_cluster_size + max_cluster_size / 4);
+    EXPECT_TRUE(cluster.overlap_poses.size() <= 2 + overlap_ratio * cluster.core_poses.size());
+    EXPECT_FALSE(cluster.overlap_poses.empty());
+    for (const IndexT pose_id : cluster.core_poses)
+      ++core_count[pose_id];
+    for (const IndexT pose_id : cluster.overlap_poses)
+      EXPECT_EQ(0, cluster.core_poses.count(pose_id));
+  }
+  EXPECT_EQ(sfm_data.poses.size(), core_count.size());
+  for (const auto & count_it : core_count)
+    EXPECT_EQ(1, count_it.second);
+}
+
+TEST(BA_PARTITION, DisconnectedComponents)
+{
+  // Two chains that do not share any landmark
+  SfM_Data sfm_data = ChainScene(6, 3);
+  const SfM_Data other_chain = ChainScene(6, 3);
+  for (const auto & view_it : other_chain.views)
+  {
+    const IndexT id = view_it.first + 100;
+    sfm_data.views[id] = std::make_shared<View>("", id, 0, id, 1000, 1000);
+    sfm_data.poses[id] = other_chain.poses.at(view_it.first);
+  }
+  for (const auto & landmark_it : other_chain.structure)
+  {
+    Landmark & landmark = sfm_data.structure[landmark_it.first + 100];
+    landmark.X = landmark_it.second.X;
+    for (const auto & obs_it : landmark_it.second.obs)
+      landmark.obs[obs_it.first + 100] = obs_it.second;
+  }
+
+  const std::vector<BA_Pose_Cluster> clusters =
+    PartitionPosesByCovisibility(sfm_data, 100, 0.2);
+  EXPECT_EQ(2, clusters.size());
+  for (const auto & cluster : clusters)
+  {
+    EXPECT_EQ(6, cluster.core_poses.size());
+    EXPECT_TRUE(cluster.overlap_poses.empty());
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
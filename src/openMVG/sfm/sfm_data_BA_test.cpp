@@ -19,6 +19,7 @@
 #include "openMVG/cameras/Camera_Common.hpp"
 #include "openMVG/multiview/test_data_sets.hpp"
 #include "openMVG/sfm/sfm.hpp"
+#include "openMVG/sfm/sfm_data_BA_partition.hpp"
 
 #include "testing/testing.h"
 
@@ -184,6 +185,40 @@ TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_Intrinsic_Fisheye) {
   EXPECT_TRUE( dResidual_before > dResidual_after);
 }
 
+TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_AnalyticJacobians) {
+
+  const int nviews = 3;
+  const int npoints = 6;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  for (const EINTRINSIC eintrinsic :
+    {PINHOLE_CAMERA, PINHOLE_CAMERA_RADIAL1, PINHOLE_CAMERA_RADIAL3,
+     PINHOLE_CAMERA_BROWN, PINHOLE_CAMERA_FISHEYE})
+  {
+    // Refine the same scene with the AutoDiff and the analytic cost functions
+    SfM_Data sfm_data_autodiff = getInputScene(d, config, eintrinsic);
+    SfM_Data sfm_data_analytic = sfm_data_autodiff;
+    const double dResidual_before = RMSE(sfm_data_analytic);
+
+    const Optimize_Options ba_refine_options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL);
+    Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options(false, false);
+    EXPECT_TRUE( Bundle_Adjustment_Ceres(ceres_options).Adjust(
+      sfm_data_autodiff, ba_refine_options) );
+    ceres_options.bUse_analytic_jacobians_ = true;
+    EXPECT_TRUE( Bundle_Adjustment_Ceres(ceres_options).Adjust(
+      sfm_data_analytic, ba_refine_options) );
+
+    // Both converge (not necessarily to the same minimum: the intrinsics and
+    // the structure are refined together on a tiny scene)
+    EXPECT_TRUE( dResidual_before > RMSE(sfm_data_autodiff));
+    EXPECT_TRUE( dResidual_before > RMSE(sfm_data_analytic));
+  }
+}
+
 //-- Test with GCP - Camera position once BA done must be the same as the GT
 TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_GCP) {
 
@@ -305,6 +340,217 @@ TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_PosePriors) {
   }
 }
 
+/// Count the landmark observations of a scene
+size_t CountObservations(const SfM_Data & sfm_data)
+{
+  size_t count = 0;
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+    count += landmark_it.second.obs.size();
+  return count;
+}
+
+TEST(BUNDLE_ADJUSTMENT, Session_IncrementalProblem) {
+
+  const int nviews = 6;
+  const int npoints = 12;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  const SfM_Data full_scene = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // Start with a partial scene: the two last poses and landmarks are missing
+  SfM_Data sfm_data = full_scene;
+  for (const IndexT id : {4, 5})
+  {
+    sfm_data.poses.erase(id);
+    for (auto & landmark_it : sfm_data.structure)
+      landmark_it.second.obs.erase(id);
+  }
+  sfm_data.structure.erase(10);
+  sfm_data.structure.erase(11);
+
+  const bool bVerbose = true;
+  const bool bMultithread = false;
+  Bundle_Adjustment_Ceres_Session ba_session(
+    Bundle_Adjustment_Ceres::BA_Ceres_options(bVerbose, bMultithread),
+    Optimize_Options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL));
+
+  double dResidual_before = RMSE(sfm_data);
+  EXPECT_TRUE( ba_session.Adjust(sfm_data) );
+  EXPECT_TRUE( dResidual_before > RMSE(sfm_data) );
+  EXPECT_EQ( CountObservations(sfm_data), ba_session.NumResidualBlocks() );
+
+  // Grow the scene (new poses, observations and landmarks)
+  // and reject a landmark and an observation.
+  for (const IndexT id : {4, 5})
+  {
+    sfm_data.poses[id] = full_scene.poses.at(id);
+    for (auto & landmark_it : sfm_data.structure)
+      landmark_it.second.obs[id] = full_scene.structure.at(landmark_it.first).obs.at(id);
+  }
+  sfm_data.structure[10] = full_scene.structure.at(10);
+  sfm_data.structure[11] = full_scene.structure.at(11);
+  sfm_data.structure.erase(0);
+  sfm_data.structure.at(1).obs.erase(2);
+
+  dResidual_before = RMSE(sfm_data);
+  EXPECT_TRUE( ba_session.Adjust(sfm_data) );
+  EXPECT_EQ( CountObservations(sfm_data), ba_session.NumResidualBlocks() );
+  const double dResidual_session = RMSE(sfm_data);
+  EXPECT_TRUE( dResidual_before > dResidual_session );
+
+  // The reused problem must converge as a problem built from scratch
+  SfM_Data sfm_data_reference = sfm_data;
+  Bundle_Adjustment_Ceres ba_object(
+    Bundle_Adjustment_Ceres::BA_Ceres_options(bVerbose, bMultithread));
+  EXPECT_TRUE( ba_object.Adjust(sfm_data_reference,
+    Optimize_Options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL)) );
+  EXPECT_NEAR( RMSE(sfm_data_reference), dResidual_session, 1e-4 );
+}
+
+
+TEST(BUNDLE_ADJUSTMENT, Partitioned_Consensus) {
+
+  const int nviews = 16;
+  const int npoints = 64;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene and make the visibility
+  // local: each landmark is only seen by 4 consecutive views of the ring
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+  for (auto & landmark_it : sfm_data.structure)
+  {
+    Observations & obs = landmark_it.second.obs;
+    for (auto obs_it = obs.begin(); obs_it != obs.end();)
+    {
+      if ((obs_it->first + nviews - landmark_it.first % nviews) % nviews >= 4)
+        obs_it = obs.erase(obs_it);
+      else
+        ++obs_it;
+    }
+  }
+  SfM_Data sfm_data_global = sfm_data;
+  const double dResidual_before = RMSE(sfm_data);
+
+  const Optimize_Options ba_refine_options(
+    Intrinsic_Parameter_Type::NONE,
+    Extrinsic_Parameter_Type::ADJUST_ALL,
+    Structure_Parameter_Type::ADJUST_ALL);
+  const Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options(true, false);
+
+  EXPECT_TRUE( Bundle_Adjustment_Ceres(ceres_options).Adjust(
+    sfm_data_global, ba_refine_options) );
+
+  Bundle_Adjustment_Ceres_Partitioned::Partition_options partition_options(4, 0.5);
+  partition_options.max_consensus_iterations_ = 100;
+  partition_options.consensus_tolerance_ = 0.01;
+  EXPECT_TRUE( PartitionPosesByCovisibility(sfm_data, 4, 0.5).size() > 1);
+  Bundle_Adjustment_Ceres_Partitioned partitioned_ba(ceres_options, partition_options);
+  EXPECT_TRUE( partitioned_ba.Adjust(sfm_data, ba_refine_options) );
+
+  const double dResidual_after = RMSE(sfm_data);
+  EXPECT_TRUE( dResidual_before > dResidual_after);
+  // The consensus reaches the accuracy of the global adjustment
+  EXPECT_NEAR( RMSE(sfm_data_global), dResidual_after, 0.05);
+}
+
+TEST(BUNDLE_ADJUSTMENT, MixedPrecision_Accuracy) {
+
+  const int nviews = 8;
+  const int npoints = 64;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  for (const EINTRINSIC eintrinsic :
+    {PINHOLE_CAMERA, PINHOLE_CAMERA_RADIAL1, PINHOLE_CAMERA_RADIAL3,
+     PINHOLE_CAMERA_BROWN, PINHOLE_CAMERA_FISHEYE})
+  {
+    // Refine the same scene in double and in mixed precision
+    SfM_Data sfm_data_double = getInputScene(d, config, eintrinsic);
+    SfM_Data sfm_data_mixed = sfm_data_double;
+    const double dResidual_before = RMSE(sfm_data_double);
+
+    const Optimize_Options ba_refine_options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL);
+    const Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options(false, false);
+    EXPECT_TRUE( Bundle_Adjustment_Ceres(ceres_options).Adjust(
+      sfm_data_double, ba_refine_options) );
+    EXPECT_TRUE( Bundle_Adjustment_Mixed_Precision(ceres_options).Adjust(
+      sfm_data_mixed, ba_refine_options) );
+
+    // The single precision solve reaches the accuracy of the double precision one
+    const double dResidual_double = RMSE(sfm_data_double);
+    const double dResidual_mixed = RMSE(sfm_data_mixed);
+    EXPECT_TRUE( dResidual_before > dResidual_mixed );
+    EXPECT_TRUE( dResidual_mixed < dResidual_double + 1e-3 );
+
+    // A final double precision refinement does not move the solution anymore
+    EXPECT_TRUE( Bundle_Adjustment_Ceres(ceres_options).Adjust(
+      sfm_data_mixed, ba_refine_options) );
+    EXPECT_NEAR( dResidual_mixed, RMSE(sfm_data_mixed), 1e-3 );
+  }
+}
+
+TEST(BUNDLE_ADJUSTMENT, MixedPrecision_PartialRefinement) {
+
+  const int nviews = 6;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  const std::vector<Optimize_Options> ba_refine_options = {
+    // Fixed structure
+    Optimize_Options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::NONE),
+    // Fixed intrinsics, rotation only
+    Optimize_Options(
+      Intrinsic_Parameter_Type::NONE,
+      Extrinsic_Parameter_Type::ADJUST_ROTATION,
+      Structure_Parameter_Type::ADJUST_ALL),
+    // Subset parametrization of the intrinsics
+    Optimize_Options(
+      Intrinsic_Parameter_Type::ADJUST_FOCAL_LENGTH,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL)
+  };
+  for (const Optimize_Options & options : ba_refine_options)
+  {
+    SfM_Data sfm_data_double = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+    SfM_Data sfm_data_mixed = sfm_data_double;
+    const double dResidual_before = RMSE(sfm_data_double);
+
+    const Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options(false, false);
+    EXPECT_TRUE( Bundle_Adjustment_Ceres(ceres_options).Adjust(sfm_data_double, options) );
+    EXPECT_TRUE( Bundle_Adjustment_Mixed_Precision(ceres_options).Adjust(sfm_data_mixed, options) );
+
+    EXPECT_TRUE( dResidual_before > RMSE(sfm_data_mixed) );
+    EXPECT_TRUE( RMSE(sfm_data_mixed) < RMSE(sfm_data_double) + 1e-3 );
+    // The constant parameters are unchanged
+    if (options.structure_opt == Structure_Parameter_Type::NONE)
+    {
+      const SfM_Data sfm_data_input = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+      EXPECT_NEAR( 0.0, (sfm_data_input.structure.at(0).X - sfm_data_mixed.structure.at(0).X).norm(), 1e-12 );
+    }
+    if (options.intrinsics_opt == Intrinsic_Parameter_Type::ADJUST_FOCAL_LENGTH)
+    {
+      const std::vector<double> params = sfm_data_mixed.intrinsics.at(0)->getParams();
+      EXPECT_EQ( config._cx, params[1] );
+      EXPECT_EQ( config._cy, params[2] );
+    }
+  }
+}
 
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfM_Data & sfm_data)
@@ -9,15 +9,21 @@
 
 #include "openMVG/sfm/sfm_data_colorization.hpp"
 
-#include "openMVG/image/image_container.hpp"
 #include "openMVG/image/image_io.hpp"
-#include "openMVG/image/pixel_types.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
-#include "openMVG/stl/stl.hpp"
+#include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
 
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
 namespace openMVG {
 namespace sfm {
 
@@ -25,115 +31,217 @@ namespace sfm {
 bool ColorizeTracks(
   const SfM_Data & sfm_data,
   std::vector<Vec3> & vec_3dPoints,
-  std::vector<Vec3> & vec_tracksColor)
+  std::vector<Vec3> & vec_tracksColor,
+  const Colorization_Options & options)
 {
-  // Colorize each track
-  // Start with the most representative image
-  //   and iterate to provide a color to each 3D point
-
+  // Colorize each track in three steps:
+  //  1. Assign each track to its most representative view(s)
+  //     (the views that observe the most landmarks),
+  //  2. Decode the images in parallel and sample the assigned track colors,
+  //  3. Average the sampled colors of each track.
+
+  const Landmarks & landmarks = sfm_data.GetLandmarks();
+  const int track_count = static_cast<int>(landmarks.size());
+  const IndexT max_obs = std::max(1u, options.max_observations_per_track);
+
+  vec_3dPoints.resize(track_count);
+  vec_tracksColor.assign(track_count, Vec3::Zero());
+  if (track_count == 0)
+    return true;
+
+  // Build a list of contiguous index for the tracks and the views
+  std::vector<const Landmark *> tracks;
+  tracks.reserve(track_count);
+  for (const auto & landmark_it : landmarks)
   {
-    system::LoggerProgress my_progress_bar(sfm_data.GetLandmarks().size(),"- Compute scene structure color -" );
+    vec_3dPoints[tracks.size()] = landmark_it.second.X;
+    tracks.push_back(&landmark_it.second);
+  }
 
-    vec_tracksColor.resize(sfm_data.GetLandmarks().size());
-    vec_3dPoints.resize(sfm_data.GetLandmarks().size());
+  std::vector<IndexT> view_ids;
+  Hash_Map<IndexT, IndexT> view_id_to_index;
+  view_ids.reserve(sfm_data.GetViews().size());
+  for (const auto & view_it : sfm_data.GetViews())
+  {
+    view_id_to_index[view_it.first] = view_ids.size();
+    view_ids.push_back(view_it.first);
+  }
+  const IndexT view_count = view_ids.size();
 
-    //Build a list of contiguous index for the trackIds
-    std::map<IndexT, IndexT> trackIds_to_contiguousIndexes;
-    IndexT cpt = 0;
-    for (Landmarks::const_iterator it = sfm_data.GetLandmarks().begin();
-      it != sfm_data.GetLandmarks().end(); ++it, ++cpt)
+  // Count the number of observation per view
+  std::vector<IndexT> view_cardinal(view_count, 0);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std::vector<IndexT> local_view_cardinal(view_count, 0);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for (int i = 0; i < track_count; ++i)
     {
-      trackIds_to_contiguousIndexes[it->first] = cpt;
-      vec_3dPoints[cpt] = it->second.X;
+      for (const auto & obs_it : tracks[i]->obs)
+      {
+        const auto view_index_it = view_id_to_index.find(obs_it.first);
+        if (view_index_it != view_id_to_index.end())
+          ++local_view_cardinal[view_index_it->second];
+      }
     }
-
-    // The track list that will be colored (point removed during the process)
-    std::set<IndexT> remainingTrackToColor;
-    std::transform(sfm_data.GetLandmarks().begin(), sfm_data.GetLandmarks().end(),
-      std::inserter(remainingTrackToColor, remainingTrackToColor.begin()),
-      stl::RetrieveKey());
-
-    while ( !remainingTrackToColor.empty() )
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
     {
-      // Find the most representative image (for the remaining 3D points)
-      //  a. Count the number of observation per view for each 3Dpoint Index
-      //  b. Sort to find the most representative view index
+      for (IndexT v = 0; v < view_count; ++v)
+        view_cardinal[v] += local_view_cardinal[v];
+    }
+  }
 
-      std::map<IndexT, IndexT> map_IndexCardinal; // ViewId, Cardinal
-      for (const auto & track_to_color_it : remainingTrackToColor)
+  // Assign each track to its max_obs most representative views.
+  // A track owns max_obs slots: slot (i * max_obs + k) stores the k-th view
+  // used to sample the color of the track i.
+  std::vector<IndexT> slot_view(static_cast<size_t>(track_count) * max_obs, UndefinedIndexT);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std::vector<IndexT> candidates;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for (int i = 0; i < track_count; ++i)
+    {
+      candidates.clear();
+      for (const auto & obs_it : tracks[i]->obs)
       {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        for (const auto & obs_it : obs)
-        {
-          const auto viewId = obs_it.first;
-          if (map_IndexCardinal.find(viewId) == map_IndexCardinal.end())
-            map_IndexCardinal[viewId] = 1;
-          else
-            ++map_IndexCardinal[viewId];
-        }
+        const auto view_index_it = view_id_to_index.find(obs_it.first);
+        if (view_index_it != view_id_to_index.end())
+          candidates.push_back(view_index_it->second);
       }
+      // Most observed views first (ties are broken by view index to remain deterministic)
+      const auto more_representative = [&view_cardinal](const IndexT a, const IndexT b)
+      {
+        return view_cardinal[a] > view_cardinal[b]
+          || (view_cardinal[a] == view_cardinal[b] && a < b);
+      };
+      const size_t kept = std::min(candidates.size(), static_cast<size_t>(max_obs));
+      std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(),
+        more_representative);
+      std::copy(candidates.cbegin(), candidates.cbegin() + kept,
+        slot_view.begin() + static_cast<size_t>(i) * max_obs);
+    }
+  }
+
+  // Group the slots per view (compressed row storage)
+  std::vector<size_t> view_offsets(view_count + 1, 0);
+  for (const IndexT view_index : slot_view)
+  {
+    if (view_index != UndefinedIndexT)
+      ++view_offsets[view_index + 1];
+  }
+  std::partial_sum(view_offsets.cbegin(), view_offsets.cend(), view_offsets.begin());
+  std::vector<size_t> view_slots(view_offsets.back());
+  {
+    std::vector<size_t> fill_position(view_offsets.cbegin(), view_offsets.cend() - 1);
+    for (size_t slot = 0; slot < slot_view.size(); ++slot)
+    {
+      if (slot_view[slot] != UndefinedIndexT)
+        view_slots[fill_position[slot_view[slot]]++] = slot;
+    }
+  }
 
-      // Find the View index that is the most represented
-      std::vector<IndexT> vec_cardinal;
-      std::transform(map_IndexCardinal.begin(),
-        map_IndexCardinal.end(),
-        std::back_inserter(vec_cardinal),
-        stl::RetrieveValue());
-      using namespace stl::indexed_sort;
-      std::vector<sort_index_packet_descend<IndexT, IndexT>> packet_vec(vec_cardinal.size());
-      sort_index_helper(packet_vec, &vec_cardinal[0], 1);
-
-      // First image index with the most of occurrence
-      std::map<IndexT, IndexT>::const_iterator iterTT = map_IndexCardinal.begin();
-      std::advance(iterTT, packet_vec[0].index);
-      const size_t view_index = iterTT->first;
-      const View * view = sfm_data.GetViews().at(view_index).get();
+  std::vector<IndexT> views_to_read;
+  for (IndexT v = 0; v < view_count; ++v)
+  {
+    if (view_offsets[v + 1] > view_offsets[v])
+      views_to_read.push_back(v);
+  }
+
+  // Decode the images (a bounded number at a time) and sample the track colors
+  std::vector<image::RGBColor> slot_color(slot_view.size(), image::BLACK);
+  std::vector<unsigned char> slot_valid(slot_view.size(), 0);
+  std::atomic<bool> b_read_error(false);
+  {
+    system::LoggerProgress my_progress_bar(views_to_read.size(), "- Compute scene structure color -" );
+#ifdef OPENMVG_USE_OPENMP
+    const int nb_thread = (options.max_images_in_flight > 0)
+      ? static_cast<int>(options.max_images_in_flight)
+      : omp_get_max_threads();
+    #pragma omp parallel for schedule(dynamic) num_threads(nb_thread)
+#endif
+    for (int i = 0; i < static_cast<int>(views_to_read.size()); ++i)
+    {
+      if (b_read_error)
+        continue;
+
+      const IndexT view_index = views_to_read[i];
+      const IndexT view_id = view_ids[view_index];
+      const View * view = sfm_data.GetViews().at(view_id).get();
       const std::string sView_filename = stlplus::create_filespec(sfm_data.s_root_path,
         view->s_Img_path);
-      image::Image<image::RGBColor> image_rgb;
-      image::Image<unsigned char> image_gray;
-      const bool b_rgb_image = ReadImage(sView_filename.c_str(), &image_rgb);
-      if (!b_rgb_image) //try Gray level
+
+      // Reduced resolution decoding (if the view size is known)
+      image::ImageReadOptions read_options;
+      if (view->ui_width > 0 && view->ui_height > 0)
+        read_options.max_dimension = options.max_image_dimension;
+      const int scale_denominator = image::GetReadScaleDenominator(
+        view->ui_width, view->ui_height, read_options);
+
+      // Read the raw pixel buffer to handle gray, RGB and RGBA images in one decode
+      std::vector<unsigned char> image_buffer;
+      int w, h, depth;
+      if (!image::ReadImage(sView_filename.c_str(), &image_buffer, &w, &h, &depth, read_options)
+          || (depth != 1 && depth != 3 && depth != 4))
       {
-        const bool b_gray_image = ReadImage(sView_filename.c_str(), &image_gray);
-        if (!b_gray_image)
-        {
-          OPENMVG_LOG_ERROR << "Cannot open provided the image.";
-          return false;
-        }
+        OPENMVG_LOG_ERROR << "Cannot open the provided image: " << sView_filename;
+        b_read_error = true;
+        continue;
       }
 
-      // Iterate through the remaining track to color
-      // - look if the current view is present to color the track
-      std::set<IndexT> set_toRemove;
-      for (const auto & track_to_color_it : remainingTrackToColor)
+      for (size_t s = view_offsets[view_index]; s < view_offsets[view_index + 1]; ++s)
       {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        Observations::const_iterator it = obs.find(view_index);
-
-        if (it != obs.end())
-        {
-          // Color the track
-          const Vec2 & pt = it->second.x;
-          const image::RGBColor color =
-            b_rgb_image
-            ? image_rgb(pt.y(), pt.x())
-            : image::RGBColor(image_gray(pt.y(), pt.x()));
-
-          vec_tracksColor[trackIds_to_contiguousIndexes.at(trackId)] =
-            Vec3(color.r(), color.g(), color.b());
-          set_toRemove.insert(trackId);
-          ++my_progress_bar;
-        }
+        const size_t slot = view_slots[s];
+        const Observations & obs = tracks[slot / max_obs]->obs;
+        const Vec2 & pt = obs.at(view_id).x;
+        const int x = static_cast<int>(pt.x() / scale_denominator),
+                  y = static_cast<int>(pt.y() / scale_denominator);
+        if (x < 0 || y < 0 || x >= w || y >= h)
+          continue;
+
+        const unsigned char * pixel =
+          &image_buffer[(static_cast<size_t>(y) * w + x) * depth];
+        slot_color[slot] = (depth == 1)
+          ? image::RGBColor(pixel[0])
+          : image::RGBColor(pixel[0], pixel[1], pixel[2]);
+        slot_valid[slot] = 1;
       }
-      // Remove colored track
-      for (const auto & to_remove_it : set_toRemove)
+      ++my_progress_bar;
+    }
+  }
+  if (b_read_error)
+    return false;
+
+  // Average the sampled colors of each track
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < track_count; ++i)
+  {
+    Vec3 color_sum = Vec3::Zero();
+    int sample_count = 0;
+    for (size_t slot = static_cast<size_t>(i) * max_obs;
+         slot < static_cast<size_t>(i + 1) * max_obs; ++slot)
+    {
+      if (slot_valid[slot])
       {
-        remainingTrackToColor.erase(to_remove_it);
+        const image::RGBColor & color = slot_color[slot];
+        color_sum += Vec3(color.r(), color.g(), color.b());
+        ++sample_count;
       }
     }
+    if (sample_count > 0)
+    {
+      vec_tracksColor[i] = (color_sum / sample_count).array().round();
+    }
   }
   return true;
 }
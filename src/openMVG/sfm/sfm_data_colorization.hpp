@@ -12,15 +12,48 @@
 
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
+#include <vector>
+
 namespace openMVG {
 namespace sfm {
 
 struct SfM_Data;
 
+/// Configure how the landmark colors are computed
+struct Colorization_Options
+{
+  /// Maximal number of observations used to compute a landmark color.
+  /// - 1: the color is sampled in the most representative view only,
+  /// - N: the color is the mean of the color sampled in the N most
+  ///      representative views observing the landmark.
+  unsigned int max_observations_per_track = 1;
+  /// Maximal number of images decoded at the same time
+  /// (0 means one per available thread).
+  unsigned int max_images_in_flight = 0;
+  /// Largest dimension of the decoded images (0 means full resolution).
+  /// The images are decoded at 1/2, 1/4 or 1/8 of their resolution to fit,
+  /// which is enough to colorize a coarse model.
+  unsigned int max_image_dimension = 0;
+};
+
+/**
+* @brief Compute a color for each SfM_Data landmark.
+*
+* The view -> track assignment is computed in a single pass (each track is
+* sampled in the view(s) that observe the most landmarks), then the images
+* are decoded in parallel, with a bounded number of images in memory.
+*
+* @param[in] sfm_data The scene to colorize
+* @param[out] vec_3dPoints The landmark positions (ordered as the structure)
+* @param[out] vec_tracksColor The landmark colors (ordered as vec_3dPoints)
+* @param[in] options Colorization settings
+* @return false if an image cannot be read
+*/
 bool ColorizeTracks(
   const SfM_Data & sfm_data,
   std::vector<Vec3> & vec_3dPoints,
-  std::vector<Vec3> & vec_tracksColor);
+  std::vector<Vec3> & vec_tracksColor,
+  const Colorization_Options & options = Colorization_Options());
 
 } // namespace sfm
 } // namespace openMVG
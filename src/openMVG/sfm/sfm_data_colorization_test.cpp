@@ -0,0 +1,123 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_colorization.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include "testing/testing.h"
+
+#include <sstream>
+
+using namespace openMVG;
+using namespace openMVG::image;
+using namespace openMVG::sfm;
+
+// Create a scene with 3 views. Each view image is filled with a uniform color:
+//  view 0: (30,0,0), view 1: (0,60,0), view 2 (gray): (90,90,90)
+// - Track 0 is seen by views 0,1,2
+// - Track 1 is seen by views 1,2
+// - Track 2 is seen by view 2
+// The images are written in the folder sOutDir (removed by clean_scene).
+const std::string sOutDir = "colorization_test";
+
+bool init_scene(SfM_Data & sfm_data)
+{
+  sfm_data.s_root_path = sOutDir;
+  bool b_write = stlplus::folder_create(sOutDir) || stlplus::is_folder(sOutDir);
+  const RGBColor colors[2] = {RGBColor(30, 0, 0), RGBColor(0, 60, 0)};
+  for (IndexT i = 0; i < 3; ++i)
+  {
+    std::ostringstream os;
+    os << "colorization_" << i << ".png";
+    if (i < 2)
+    {
+      Image<RGBColor> image(8, 8, true, colors[i]);
+      b_write &= WriteImage(stlplus::create_filespec(sOutDir, os.str()).c_str(), image) != 0;
+    }
+    else
+    {
+      Image<unsigned char> image(8, 8, true, 90);
+      b_write &= WriteImage(stlplus::create_filespec(sOutDir, os.str()).c_str(), image) != 0;
+    }
+    sfm_data.views[i] = std::make_shared<View>(os.str(), i, 0, i, 8, 8);
+  }
+
+  for (IndexT i = 0; i < 3; ++i)
+  {
+    Landmark & landmark = sfm_data.structure[i];
+    landmark.X = Vec3(i, i, i);
+    for (IndexT j = i; j < 3; ++j)
+      landmark.obs[j] = Observation(Vec2(1, 2), 0);
+  }
+  return b_write;
+}
+
+bool clean_scene()
+{
+  return stlplus::folder_delete(sOutDir, true);
+}
+
+TEST(SFM_DATA_COLORIZATION, MostRepresentativeView)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+
+  std::vector<Vec3> vec_3dPoints, vec_tracksColor;
+  EXPECT_TRUE(ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor));
+  EXPECT_EQ(3, vec_3dPoints.size());
+  EXPECT_EQ(3, vec_tracksColor.size());
+
+  // View 2 sees all the tracks, so it is used for all of them
+  for (int i = 0; i < 3; ++i)
+  {
+    const Vec3 & X = vec_3dPoints[i];
+    EXPECT_TRUE(X.x() == X.y() && X.x() == X.z());
+    EXPECT_MATRIX_NEAR(Vec3(90, 90, 90), vec_tracksColor[i], 1e-8);
+  }
+  EXPECT_TRUE(clean_scene());
+}
+
+TEST(SFM_DATA_COLORIZATION, AverageObservations)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+
+  Colorization_Options options;
+  options.max_observations_per_track = 3;
+  options.max_images_in_flight = 2;
+
+  std::vector<Vec3> vec_3dPoints, vec_tracksColor;
+  EXPECT_TRUE(ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor, options));
+  EXPECT_EQ(3, vec_tracksColor.size());
+
+  // Expected mean color of the track i (the landmarks are stored at X = (i,i,i))
+  const Vec3 expected_colors[3] = {Vec3(40, 50, 30), Vec3(45, 75, 45), Vec3(90, 90, 90)};
+  for (int i = 0; i < 3; ++i)
+  {
+    const int track_id = static_cast<int>(vec_3dPoints[i].x());
+    EXPECT_MATRIX_NEAR(expected_colors[track_id], vec_tracksColor[i], 1e-8);
+  }
+  EXPECT_TRUE(clean_scene());
+}
+
+TEST(SFM_DATA_COLORIZATION, MissingImage)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+  sfm_data.views[2]->s_Img_path = "colorization_missing.png";
+
+  std::vector<Vec3> vec_3dPoints, vec_tracksColor;
+  EXPECT_FALSE(ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor));
+  EXPECT_TRUE(clean_scene());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
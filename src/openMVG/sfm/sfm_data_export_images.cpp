@@ -0,0 +1,342 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_data_export_images.hpp"
+
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace openMVG {
+namespace sfm {
+
+using namespace openMVG::cameras;
+using namespace openMVG::image;
+
+std::vector<Image_Export_Job> ListViewExportJobs(
+  const SfM_Data & sfm_data,
+  const std::vector<View_Export_Path> & outputs,
+  const bool b_only_reconstructed_views)
+{
+  std::vector<Image_Export_Job> jobs;
+  jobs.reserve(sfm_data.GetViews().size());
+  for (const auto & view_it : sfm_data.GetViews())
+  {
+    const View * view = view_it.second.get();
+    if (b_only_reconstructed_views && !sfm_data.IsPoseAndIntrinsicDefined(view))
+      continue;
+    if (view->id_intrinsic == UndefinedIndexT
+        || sfm_data.GetIntrinsics().count(view->id_intrinsic) == 0)
+      continue;
+
+    Image_Export_Job job;
+    job.source = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
+    job.id_intrinsic = view->id_intrinsic;
+    for (const View_Export_Path & output : outputs)
+    {
+      const std::string destination = output(*view);
+      if (!destination.empty())
+        job.destinations.push_back(destination);
+    }
+    if (!job.destinations.empty())
+      jobs.emplace_back(std::move(job));
+  }
+  return jobs;
+}
+
+/// Temporary file of a destination: the destinations are written through a
+/// temporary file, so that an interrupted export never leaves a truncated
+/// destination that looks up to date.
+std::string TemporaryFilename(const std::string & destination)
+{
+  return stlplus::create_filespec(
+    stlplus::folder_part(destination),
+    stlplus::basename_part(destination) + ".part",
+    stlplus::extension_part(destination));
+}
+
+/// Move a completed temporary file to its destination
+bool ReplaceByTemporary
+(
+  const std::string & tmp_file,
+  const std::string & destination
+)
+{
+  if (stlplus::file_exists(destination))
+    stlplus::file_delete(destination);
+  return stlplus::file_rename(tmp_file, destination);
+}
+
+/// Write an image through a temporary file
+template <typename ImageT>
+bool WriteImageSafely
+(
+  const std::string & destination,
+  const ImageT & image
+)
+{
+  const std::string tmp_file = TemporaryFilename(destination);
+  if (!WriteImage(tmp_file.c_str(), image))
+  {
+    stlplus::file_delete(tmp_file);
+    return false;
+  }
+  return ReplaceByTemporary(tmp_file, destination);
+}
+
+/// Copy a file through a temporary file
+bool CopyFileSafely
+(
+  const std::string & source,
+  const std::string & destination
+)
+{
+  const std::string tmp_file = TemporaryFilename(destination);
+  if (!stlplus::file_copy(source, tmp_file))
+  {
+    stlplus::file_delete(tmp_file);
+    return false;
+  }
+  return ReplaceByTemporary(tmp_file, destination);
+}
+
+/// Undistort a decoded pixel buffer and write it to the destinations
+template <typename PixelT>
+bool UndistortAndWrite
+(
+  std::vector<unsigned char> & buffer,
+  const int w,
+  const int h,
+  const Undistortion_Map * map,
+  const std::vector<std::string> & destinations
+)
+{
+  Image<PixelT> image(w, h, false);
+  std::memcpy(image.data(), buffer.data(), sizeof(PixelT) * w * h);
+  std::vector<unsigned char>().swap(buffer); // release the decoded buffer
+
+  Image<PixelT> image_ud;
+  if (map)
+  {
+    UndistortImage(image, *map, image_ud, PixelT(0));
+    image = Image<PixelT>(); // keep a single image in memory
+  }
+  const Image<PixelT> & image_out = map ? image_ud : image;
+
+  bool b_ok = true;
+  for (const std::string & destination : destinations)
+  {
+    if (!WriteImageSafely(destination, image_out))
+    {
+      OPENMVG_LOG_ERROR << "Cannot write the image: " << destination;
+      b_ok = false;
+    }
+  }
+  return b_ok;
+}
+
+/// Memory size of the undistortion map of an image size
+size_t MapBytes(const int width, const int height)
+{
+  return sizeof(Vec2f) * static_cast<size_t>(width) * height;
+}
+
+Undistorted_Image_Exporter::Undistorted_Image_Exporter(
+  const SfM_Data & sfm_data,
+  const Image_Export_Options & options)
+  : sfm_data_(sfm_data),
+    options_(options)
+{
+}
+
+std::shared_ptr<const Undistortion_Map> Undistorted_Image_Exporter::GetUndistortionMap(
+  const IndexT id_intrinsic,
+  const int width,
+  const int height)
+{
+  const auto intrinsic_it = sfm_data_.GetIntrinsics().find(id_intrinsic);
+  if (intrinsic_it == sfm_data_.GetIntrinsics().end()
+      || !intrinsic_it->second->have_disto())
+    return nullptr;
+
+  std::shared_ptr<Cached_Map> cached_map;
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    const Map_Key key(id_intrinsic, width, height);
+    auto map_it = maps_.find(key);
+    if (map_it != maps_.end())
+    {
+      // Move the map to the front of the use order
+      maps_lru_.splice(maps_lru_.begin(), maps_lru_, map_it->second.second);
+    }
+    else
+    {
+      maps_lru_.push_front(key);
+      map_it = maps_.emplace(key,
+        std::make_pair(std::make_shared<Cached_Map>(), maps_lru_.begin())).first;
+      cached_map_bytes_ += MapBytes(width, height);
+      // Release the least recently used maps beyond the budget
+      // (the images that use them keep their own reference)
+      while (cached_map_bytes_ > options_.max_cached_map_bytes && maps_lru_.size() > 1)
+      {
+        const Map_Key & lru_key = maps_lru_.back();
+        cached_map_bytes_ -= MapBytes(std::get<1>(lru_key), std::get<2>(lru_key));
+        maps_.erase(lru_key);
+        maps_lru_.pop_back();
+      }
+    }
+    cached_map = map_it->second.first;
+  }
+  // The map is computed once, the other threads that need it wait for it
+  std::call_once(cached_map->computed, [&]
+  {
+    auto map = std::make_shared<Undistortion_Map>();
+    ComputeUndistortionMap(intrinsic_it->second.get(), width, height, *map);
+    cached_map->map = map;
+  });
+  return cached_map->map;
+}
+
+bool Undistorted_Image_Exporter::IsUpToDate(const Image_Export_Job & job) const
+{
+  if (!stlplus::file_exists(job.source))
+    return false;
+  const std::time_t min_time =
+    std::max(stlplus::file_modified(job.source), options_.reference_time);
+  for (const std::string & destination : job.destinations)
+  {
+    if (!stlplus::file_exists(destination)
+        || stlplus::file_modified(destination) < min_time)
+      return false;
+  }
+  return true;
+}
+
+bool Undistorted_Image_Exporter::Export(
+  const std::vector<Image_Export_Job> & jobs,
+  system::ProgressInterface * my_progress_bar,
+  Image_Export_Report * report)
+{
+  if (!my_progress_bar)
+    my_progress_bar = &system::ProgressInterface::dummy();
+
+  std::atomic<size_t> nb_undistorted(0), nb_copied(0), nb_skipped(0), nb_failed(0);
+
+  // Process the images of an intrinsic together, so that its undistortion
+  // map is used by all of them while it is cached
+  std::vector<size_t> job_order(jobs.size());
+  std::iota(job_order.begin(), job_order.end(), 0);
+  std::stable_sort(job_order.begin(), job_order.end(),
+    [&jobs](const size_t a, const size_t b)
+    {
+      return jobs[a].id_intrinsic < jobs[b].id_intrinsic;
+    });
+
+#ifdef OPENMVG_USE_OPENMP
+  // One decoded image (and its undistorted version) per thread at most
+  const int nb_thread = (options_.max_images_in_flight > 0)
+    ? static_cast<int>(options_.max_images_in_flight)
+    : omp_get_max_threads();
+  #pragma omp parallel for schedule(dynamic) num_threads(nb_thread)
+#endif
+  for (int i = 0; i < static_cast<int>(jobs.size()); ++i)
+  {
+    const Image_Export_Job & job = jobs[job_order[i]];
+    ++(*my_progress_bar);
+
+    if (options_.skip_up_to_date && IsUpToDate(job))
+    {
+      ++nb_skipped;
+      continue;
+    }
+
+    const auto intrinsic_it = sfm_data_.GetIntrinsics().find(job.id_intrinsic);
+    const bool b_have_disto = intrinsic_it != sfm_data_.GetIntrinsics().end()
+      && intrinsic_it->second->have_disto();
+
+    // Without distortion, the destinations with the source format are copied
+    std::vector<std::string> destinations_to_write;
+    bool b_ok = true;
+    for (const std::string & destination : job.destinations)
+    {
+      if (!b_have_disto
+          && GetFormat(destination.c_str()) == GetFormat(job.source.c_str()))
+      {
+        if (!CopyFileSafely(job.source, destination))
+        {
+          OPENMVG_LOG_ERROR << "Cannot copy the image: " << job.source;
+          b_ok = false;
+        }
+      }
+      else
+      {
+        destinations_to_write.push_back(destination);
+      }
+    }
+
+    if (!destinations_to_write.empty())
+    {
+      try
+      {
+        // Decode the image once, in the color space of the destinations
+        ImageReadOptions read_options;
+        read_options.color_space = job.b_gray ? ColorSpace::Gray : ColorSpace::Rgb;
+        std::vector<unsigned char> buffer;
+        int w, h, depth;
+        if (!ReadImage(job.source.c_str(), &buffer, &w, &h, &depth, read_options))
+        {
+          OPENMVG_LOG_ERROR << "Cannot read the image: " << job.source;
+          b_ok = false;
+        }
+        else
+        {
+          std::shared_ptr<const Undistortion_Map> map;
+          if (b_have_disto)
+            map = GetUndistortionMap(job.id_intrinsic, w, h);
+          b_ok &= job.b_gray
+            ? UndistortAndWrite<unsigned char>(buffer, w, h, map.get(), destinations_to_write)
+            : UndistortAndWrite<RGBColor>(buffer, w, h, map.get(), destinations_to_write);
+        }
+      }
+      catch (const std::bad_alloc &)
+      {
+        OPENMVG_LOG_ERROR << "Memory error in the conversion of the image: " << job.source
+          << ". Please consider to use less images in flight.";
+        b_ok = false;
+      }
+    }
+
+    if (!b_ok)
+      ++nb_failed;
+    else if (destinations_to_write.empty())
+      ++nb_copied;
+    else
+      ++nb_undistorted;
+  }
+
+  if (report)
+  {
+    report->nb_undistorted = nb_undistorted;
+    report->nb_copied = nb_copied;
+    report->nb_skipped = nb_skipped;
+    report->nb_failed = nb_failed;
+  }
+  return nb_failed == 0;
+}
+
+} // namespace sfm
+} // namespace openMVG
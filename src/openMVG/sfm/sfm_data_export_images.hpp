@@ -0,0 +1,151 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_EXPORT_IMAGES_HPP
+#define OPENMVG_SFM_SFM_DATA_EXPORT_IMAGES_HPP
+
+#include "openMVG/cameras/Camera_undistort_image.hpp"
+#include "openMVG/system/progressinterface.hpp"
+#include "openMVG/types.hpp"
+
+#include <ctime>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+struct SfM_Data;
+struct View;
+
+/// An image to export: the source image is decoded and undistorted once,
+/// then written to every destination file.
+struct Image_Export_Job
+{
+  std::string source;
+  /// Intrinsic used to undistort the image (UndefinedIndexT: no undistortion)
+  IndexT id_intrinsic = UndefinedIndexT;
+  std::vector<std::string> destinations;
+  /// Write gray level images (i.e. masks), RGB images otherwise
+  bool b_gray = false;
+};
+
+/// Destination file of a view image (an empty path means the view image
+/// is not written by this output).
+using View_Export_Path = std::function<std::string(const View &)>;
+
+/**
+* @brief List the export jobs of the SfM_Data view images.
+* @param[in] sfm_data The scene
+* @param[in] outputs The output(s) (one destination per output and per view)
+* @param[in] b_only_reconstructed_views Export only the views with a valid pose
+* @return The jobs of the views with a valid intrinsic
+*/
+std::vector<Image_Export_Job> ListViewExportJobs(
+  const SfM_Data & sfm_data,
+  const std::vector<View_Export_Path> & outputs,
+  const bool b_only_reconstructed_views);
+
+/// Configure the undistorted image export
+struct Image_Export_Options
+{
+  /// Maximal number of images decoded at the same time
+  /// (0 means one per available thread).
+  unsigned int max_images_in_flight = 0;
+  /// Do not rewrite the destinations that are newer than their source
+  bool skip_up_to_date = true;
+  /// Destinations older than this time are rewritten, even if they are newer
+  /// than their source (i.e. the modification time of the scene file, since
+  /// a change of the intrinsics changes the undistortion).
+  std::time_t reference_time = 0;
+  /// Memory budget (in bytes) of the cached undistortion maps: the least
+  /// recently used maps are released beyond it (a map of a 24 MP camera
+  /// takes 192 MB). A map is always kept while an image uses it.
+  size_t max_cached_map_bytes = size_t(512) << 20;
+};
+
+/// Statistics of an export
+struct Image_Export_Report
+{
+  size_t nb_undistorted = 0; // images decoded, undistorted and written
+  size_t nb_copied = 0;      // images without distortion copied as is
+  size_t nb_skipped = 0;     // images with up to date destinations
+  size_t nb_failed = 0;      // images that cannot be read or written
+};
+
+/**
+* @brief Export undistorted images in a single streaming pass.
+*
+* The images are decoded in parallel (a bounded number at a time), each one
+* is undistorted once with the lookup table of its intrinsic (shared by the
+* images of the intrinsic, that are processed together), then written to all
+* its destinations. The image format of a destination is given by its extension.
+* The images are written in RGB (gray level for the gray jobs), whatever the
+* number of channels of the source. An image without distortion is copied
+* when a destination has the source file format.
+*/
+class Undistorted_Image_Exporter
+{
+public:
+
+  Undistorted_Image_Exporter(
+    const SfM_Data & sfm_data,
+    const Image_Export_Options & options = Image_Export_Options());
+
+  /**
+  * @brief Run the export jobs
+  * @param[in] jobs Images to export
+  * @param[in] my_progress_bar Optional progress (one step per job)
+  * @param[out] report Optional export statistics
+  * @return false if an image cannot be read or written
+  */
+  bool Export(
+    const std::vector<Image_Export_Job> & jobs,
+    system::ProgressInterface * my_progress_bar = nullptr,
+    Image_Export_Report * report = nullptr);
+
+  /// Undistortion map of an intrinsic for a given image size
+  /// (computed on the first request and cached within the memory budget,
+  /// thread safe).
+  /// Return nullptr if the intrinsic is unknown or has no distortion.
+  std::shared_ptr<const cameras::Undistortion_Map> GetUndistortionMap(
+    const IndexT id_intrinsic,
+    const int width,
+    const int height);
+
+private:
+
+  /// Return true if all the destinations are newer than the source
+  bool IsUpToDate(const Image_Export_Job & job) const;
+
+  const SfM_Data & sfm_data_;
+  const Image_Export_Options options_;
+
+  /// An undistortion map, computed by the first thread that needs it
+  struct Cached_Map
+  {
+    std::once_flag computed;
+    std::shared_ptr<const cameras::Undistortion_Map> map;
+  };
+  // Map key: intrinsic id and image size (width, height)
+  using Map_Key = std::tuple<IndexT, int, int>;
+  std::mutex map_mutex_;
+  // Cached maps, with their position in the use order
+  std::map<Map_Key, std::pair<std::shared_ptr<Cached_Map>, std::list<Map_Key>::iterator>> maps_;
+  std::list<Map_Key> maps_lru_; // most recently used first
+  size_t cached_map_bytes_ = 0;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_EXPORT_IMAGES_HPP
@@ -0,0 +1,252 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/cameras/Camera_Pinhole_Radial.hpp"
+#include "openMVG/cameras/Camera_undistort_image.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_export_images.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include "testing/testing.h"
+
+#include <ctime>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::image;
+using namespace openMVG::sfm;
+
+// A random RGB image
+Image<RGBColor> RandomImage(const int w, const int h)
+{
+  std::mt19937 rng;
+  std::uniform_int_distribution<int> value(0, 255);
+  Image<RGBColor> image(w, h);
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      image(y, x) = RGBColor(value(rng), value(rng), value(rng));
+  return image;
+}
+
+// Create a scene with 2 views:
+//  view 0: a color image with a radially distorted camera,
+//  view 1: a gray image with a camera without distortion.
+bool init_scene(SfM_Data & sfm_data)
+{
+  sfm_data.s_root_path = ".";
+  sfm_data.intrinsics[0] = std::make_shared<Pinhole_Intrinsic_Radial_K1>(40, 30, 50.0, 20.0, 15.0, -0.2);
+  sfm_data.intrinsics[1] = std::make_shared<Pinhole_Intrinsic>(40, 30, 50.0, 20.0, 15.0);
+  sfm_data.views[0] = std::make_shared<View>("export_0.png", 0, 0, 0, 40, 30);
+  sfm_data.views[1] = std::make_shared<View>("export_1.png", 1, 1, 1, 40, 30);
+
+  const Image<unsigned char> gray(40, 30, true, 128);
+  return WriteImage("export_0.png", RandomImage(40, 30))
+    && WriteImage("export_1.png", gray);
+}
+
+TEST(SFM_DATA_EXPORT_IMAGES, UndistortionMap)
+{
+  const Pinhole_Intrinsic_Radial_K1 cam(80, 60, 100.0, 40.0, 30.0, -0.3);
+  const Image<RGBColor> image = RandomImage(80, 60);
+
+  Image<RGBColor> image_ud, image_map_ud;
+  UndistortImage(image, &cam, image_ud);
+
+  Undistortion_Map map;
+  ComputeUndistortionMap(&cam, image.Width(), image.Height(), map);
+  EXPECT_FALSE(map.empty());
+  UndistortImage(image, map, image_map_ud);
+
+  // The lookup table gives the same image as the direct undistortion
+  EXPECT_EQ(image_ud.Width(), image_map_ud.Width());
+  EXPECT_EQ(image_ud.Height(), image_map_ud.Height());
+  EXPECT_TRUE(image_ud.GetMat() == image_map_ud.GetMat());
+
+  // A camera without distortion gives an empty map (direct copy)
+  const Pinhole_Intrinsic pinhole(80, 60, 100.0, 40.0, 30.0);
+  ComputeUndistortionMap(&pinhole, image.Width(), image.Height(), map);
+  EXPECT_TRUE(map.empty());
+  UndistortImage(image, map, image_map_ud);
+  EXPECT_TRUE(image.GetMat() == image_map_ud.GetMat());
+}
+
+TEST(SFM_DATA_EXPORT_IMAGES, UndistortionMapCache)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+
+  // A budget of a single 40x30 map
+  Image_Export_Options options;
+  options.max_cached_map_bytes = sizeof(Vec2f) * 40 * 30;
+  Undistorted_Image_Exporter exporter(sfm_data, options);
+
+  // No map without distortion
+  EXPECT_TRUE(exporter.GetUndistortionMap(1, 40, 30) == nullptr);
+
+  // The map is computed once for an image size
+  const auto map = exporter.GetUndistortionMap(0, 40, 30);
+  EXPECT_TRUE(map != nullptr);
+  EXPECT_EQ(40, map->width);
+  EXPECT_TRUE(map == exporter.GetUndistortionMap(0, 40, 30));
+
+  // Another image size is beyond the budget: the least recently used map is
+  // released, then computed again on request
+  const auto map_small = exporter.GetUndistortionMap(0, 20, 15);
+  EXPECT_EQ(20, map_small->width);
+  const auto map_again = exporter.GetUndistortionMap(0, 40, 30);
+  EXPECT_TRUE(map != map_again);
+  EXPECT_TRUE(map->disto_pix == map_again->disto_pix);
+
+  // Both maps fit in a larger budget
+  options.max_cached_map_bytes = sizeof(Vec2f) * (40 * 30 + 20 * 15);
+  Undistorted_Image_Exporter large_exporter(sfm_data, options);
+  const auto large_map = large_exporter.GetUndistortionMap(0, 40, 30);
+  large_exporter.GetUndistortionMap(0, 20, 15);
+  EXPECT_TRUE(large_map == large_exporter.GetUndistortionMap(0, 40, 30));
+}
+
+TEST(SFM_DATA_EXPORT_IMAGES, FanOutAndSkip)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+  const std::string out_dir = "export_undistorted";
+  stlplus::folder_create(out_dir);
+
+  // Two outputs: the source file format and a conversion to the PPM format
+  const std::vector<View_Export_Path> outputs = {
+    [&](const View & view) {
+      return stlplus::create_filespec(out_dir, view.s_Img_path); },
+    [&](const View & view) {
+      return stlplus::create_filespec(out_dir, stlplus::basename_part(view.s_Img_path), "ppm"); }
+  };
+  const std::vector<Image_Export_Job> jobs = ListViewExportJobs(sfm_data, outputs, false);
+  EXPECT_EQ(2, jobs.size());
+
+  // View 1 is not reconstructed (no pose)
+  sfm_data.poses[0] = geometry::Pose3();
+  EXPECT_EQ(1, ListViewExportJobs(sfm_data, outputs, true).size());
+
+  Image_Export_Options options;
+  options.max_images_in_flight = 2;
+  {
+    // First run: all the images are exported
+    Undistorted_Image_Exporter exporter(sfm_data, options);
+    Image_Export_Report report;
+    EXPECT_TRUE(exporter.Export(jobs, nullptr, &report));
+    EXPECT_EQ(2, report.nb_undistorted);
+    EXPECT_EQ(0, report.nb_skipped);
+    EXPECT_EQ(0, report.nb_failed);
+
+    // The color image is undistorted (the same image in every format)
+    Image<RGBColor> image, image_ud, image_png, image_ppm;
+    EXPECT_TRUE(ReadImage("export_0.png", &image));
+    UndistortImage(image, sfm_data.intrinsics.at(0).get(), image_ud);
+    EXPECT_TRUE(ReadImage(stlplus::create_filespec(out_dir, "export_0.png").c_str(), &image_png));
+    EXPECT_TRUE(ReadImage(stlplus::create_filespec(out_dir, "export_0.ppm").c_str(), &image_ppm));
+    EXPECT_TRUE(image_ud.GetMat() == image_png.GetMat());
+    EXPECT_TRUE(image_ud.GetMat() == image_ppm.GetMat());
+
+    // The gray image is written in RGB (as the other images)
+    std::vector<unsigned char> buffer;
+    int w, h, depth;
+    EXPECT_TRUE(ReadImage(stlplus::create_filespec(out_dir, "export_1.ppm").c_str(), &buffer, &w, &h, &depth));
+    EXPECT_EQ(3, depth);
+    EXPECT_EQ(128, buffer[3 * (10 * w + 10)]);
+  }
+  {
+    // Second run: the destinations are up to date
+    Undistorted_Image_Exporter exporter(sfm_data, options);
+    Image_Export_Report report;
+    EXPECT_TRUE(exporter.Export(jobs, nullptr, &report));
+    EXPECT_EQ(2, report.nb_skipped);
+  }
+  {
+    // A newer scene makes the destinations obsolete
+    options.reference_time = std::time(nullptr) + 60;
+    Undistorted_Image_Exporter exporter(sfm_data, options);
+    Image_Export_Report report;
+    EXPECT_TRUE(exporter.Export(jobs, nullptr, &report));
+    EXPECT_EQ(0, report.nb_skipped);
+    EXPECT_EQ(2, report.nb_undistorted);
+  }
+}
+
+TEST(SFM_DATA_EXPORT_IMAGES, CopyWithoutDistortion)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+  const std::string out_dir = "export_copy";
+  stlplus::folder_create(out_dir);
+
+  const std::vector<View_Export_Path> outputs = {
+    [&](const View & view) {
+      return stlplus::create_filespec(out_dir, view.s_Img_path); }
+  };
+  Image_Export_Options options;
+  options.skip_up_to_date = false;
+  Undistorted_Image_Exporter exporter(sfm_data, options);
+  Image_Export_Report report;
+  EXPECT_TRUE(exporter.Export(ListViewExportJobs(sfm_data, outputs, false), nullptr, &report));
+  EXPECT_EQ(1, report.nb_undistorted);
+  EXPECT_EQ(1, report.nb_copied);
+
+  // The copy is the source file, no temporary file is left
+  EXPECT_EQ(stlplus::file_size("export_1.png"),
+    stlplus::file_size(stlplus::create_filespec(out_dir, "export_1.png")));
+  EXPECT_FALSE(stlplus::file_exists(stlplus::create_filespec(out_dir, "export_1.part.png")));
+}
+
+TEST(SFM_DATA_EXPORT_IMAGES, GrayJob)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+  stlplus::folder_create("export_gray");
+
+  // A color image exported as a gray level image (i.e. a mask)
+  Image_Export_Job job;
+  job.source = "export_0.png";
+  job.id_intrinsic = 0;
+  job.destinations = {stlplus::create_filespec("export_gray", "export_0.ppm")};
+  job.b_gray = true;
+
+  Image_Export_Options options;
+  options.skip_up_to_date = false;
+  Undistorted_Image_Exporter exporter(sfm_data, options);
+  EXPECT_TRUE(exporter.Export({job}));
+
+  std::vector<unsigned char> buffer;
+  int w, h, depth;
+  EXPECT_TRUE(ReadImage(job.destinations[0].c_str(), &buffer, &w, &h, &depth));
+  EXPECT_EQ(1, depth);
+  EXPECT_EQ(40, w);
+  EXPECT_EQ(30, h);
+}
+
+TEST(SFM_DATA_EXPORT_IMAGES, MissingImage)
+{
+  SfM_Data sfm_data;
+  EXPECT_TRUE(init_scene(sfm_data));
+  sfm_data.views[0]->s_Img_path = "export_missing.png";
+  stlplus::folder_create("export_missing");
+
+  const std::vector<View_Export_Path> outputs = {
+    [](const View & view) {
+      return stlplus::create_filespec("export_missing", view.s_Img_path); }
+  };
+  Undistorted_Image_Exporter exporter(sfm_data);
+  Image_Export_Report report;
+  EXPECT_FALSE(exporter.Export(ListViewExportJobs(sfm_data, outputs, false), nullptr, &report));
+  EXPECT_EQ(1, report.nb_failed);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
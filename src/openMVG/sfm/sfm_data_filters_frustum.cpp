@@ -51,10 +51,10 @@ void Frustum_Filter::initFrustum
   const SfM_Data & sfm_data
 )
 {
-  for (NearFarPlanesT::const_iterator it = z_near_z_far_perView.begin();
-      it != z_near_z_far_perView.end(); ++it)
+  for (Views::const_iterator it = sfm_data.GetViews().begin();
+      it != sfm_data.GetViews().end(); ++it)
   {
-    const View * view = sfm_data.GetViews().at(it->first).get();
+    const View * view = it->second.get();
     if (!sfm_data.IsPoseAndIntrinsicDefined(view))
       continue;
     Intrinsics::const_iterator iterIntrinsic = sfm_data.GetIntrinsics().find(view->id_intrinsic);
@@ -67,7 +67,13 @@ void Frustum_Filter::initFrustum
     if (!cam)
       continue;
 
-    if (!_bTruncated) // use infinite frustum
+    // A view without a valid near & far range (i.e. a view that does not
+    // observe the structure) keeps an infinite frustum
+    const NearFarPlanesT::const_iterator itZ = z_near_z_far_perView.find(view->id_view);
+    const bool bValid_Z = itZ != z_near_z_far_perView.end()
+      && itZ->second.first > 0. && itZ->second.first <= itZ->second.second;
+
+    if (!_bTruncated || !bValid_Z) // use infinite frustum
     {
       const Frustum f(
         cam->w(), cam->h(), cam->K(),
@@ -77,7 +83,7 @@ void Frustum_Filter::initFrustum
     else // use truncated frustum with defined Near and Far planes
     {
       const Frustum f(cam->w(), cam->h(), cam->K(),
-        pose.rotation(), pose.center(), it->second.first, it->second.second);
+        pose.rotation(), pose.center(), itZ->second.first, itZ->second.second);
       frustum_perView[view->id_view] = f;
     }
   }
@@ -92,8 +98,8 @@ const
   Pair_Set pairs;
   // List active view Id
   std::vector<IndexT> viewIds;
-  viewIds.reserve(z_near_z_far_perView.size());
-  std::transform(z_near_z_far_perView.cbegin(), z_near_z_far_perView.cend(),
+  viewIds.reserve(frustum_perView.size());
+  std::transform(frustum_perView.cbegin(), frustum_perView.cend(),
     std::back_inserter(viewIds), stl::RetrieveKey());
 
   system::LoggerProgress my_progress_bar(
@@ -40,6 +40,7 @@ public:
   );
 
   // Init a frustum for each valid views of the SfM scene
+  // (truncated for the views with a valid near & far range, infinite otherwise)
   void initFrustum(const SfM_Data & sfm_data);
 
   // Return intersecting View frustum pairs. An optional bounding volume
@@ -49,6 +50,10 @@ public:
     const std::vector<geometry::halfPlane::HalfPlaneObject>& bounding_volume = {}
   ) const;
 
+  // Return the near & far plane distances of the valid views
+  // (when computed from the structure: of the views that observe it)
+  const NearFarPlanesT & getNearFarPlanes() const { return z_near_z_far_perView; }
+
   // Export defined frustum in PLY file for viewing
   bool export_Ply(const std::string & filename, bool colorize = false) const;
 
@@ -0,0 +1,90 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_filters_frustum.hpp"
+
+#include "testing/testing.h"
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::geometry;
+using namespace openMVG::sfm;
+
+// Views looking along the Z axis, with the given camera centers
+void init_scene
+(
+  SfM_Data & sfm_data,
+  const std::vector<Vec3> & centers
+)
+{
+  sfm_data.intrinsics[0] = std::make_shared<Pinhole_Intrinsic>(1000, 1000, 1000.0, 500.0, 500.0);
+  for (IndexT i = 0; i < centers.size(); ++i)
+  {
+    sfm_data.views[i] = std::make_shared<View>("", i, 0, i, 1000, 1000);
+    sfm_data.poses[i] = Pose3(Mat3::Identity(), centers[i]);
+  }
+}
+
+// Add a landmark at X seen by the given views
+void add_landmark
+(
+  SfM_Data & sfm_data,
+  const Vec3 & X,
+  const std::vector<IndexT> & views
+)
+{
+  Landmark & landmark = sfm_data.structure[sfm_data.structure.size()];
+  landmark.X = X;
+  for (const IndexT id_view : views)
+    landmark.obs[id_view] = Observation(Vec2(500, 500), 0);
+}
+
+TEST(FRUSTUM_FILTER, InfiniteFrustumForViewsWithoutDepth)
+{
+  // View 0 & 1 see the structure at a depth of 10,
+  // view 2 does not see any landmark,
+  // view 3 sees a distant part of the structure
+  SfM_Data sfm_data;
+  init_scene(sfm_data, {Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(2, 0, 0), Vec3(100, 0, 0)});
+  add_landmark(sfm_data, Vec3(0.5, 0, 9), {0, 1});
+  add_landmark(sfm_data, Vec3(0.5, 0, 11), {0, 1});
+  add_landmark(sfm_data, Vec3(100, 0, 9), {3});
+  add_landmark(sfm_data, Vec3(100, 0, 11), {3});
+
+  const Frustum_Filter frustum_filter(sfm_data);
+  // Only the views that observe the structure get a depth range
+  EXPECT_EQ(3, frustum_filter.getNearFarPlanes().size());
+  EXPECT_EQ(0, frustum_filter.getNearFarPlanes().count(2));
+
+  // The view 2 keeps an infinite frustum, that intersects the frusta of the
+  // views 0 & 1, but not the truncated frustum of the view 3
+  const Pair_Set pairs = frustum_filter.getFrustumIntersectionPairs();
+  const Pair_Set expected_pairs = {{0, 1}, {0, 2}, {1, 2}};
+  EXPECT_TRUE(expected_pairs == pairs);
+
+  // Same pairs with the depth ranges given per view
+  Frustum_Filter::NearFarPlanesT depth_ranges = frustum_filter.getNearFarPlanes();
+  for (auto & depth_range : depth_ranges)
+    depth_range.second = {depth_range.second.first / 1.25, depth_range.second.second * 1.25};
+  EXPECT_TRUE(expected_pairs ==
+    Frustum_Filter(sfm_data, -1., -1., depth_ranges).getFrustumIntersectionPairs());
+}
+
+TEST(FRUSTUM_FILTER, InfiniteFrustumsWithoutStructure)
+{
+  SfM_Data sfm_data;
+  init_scene(sfm_data, {Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(100, 0, 0)});
+
+  // All the views look in the same direction: their infinite frusta intersect
+  const Frustum_Filter frustum_filter(sfm_data);
+  EXPECT_EQ(3, frustum_filter.getFrustumIntersectionPairs().size());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
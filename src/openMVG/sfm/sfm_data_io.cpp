@@ -18,6 +18,7 @@
 #include "openMVG/sfm/sfm_data_io_ply.hpp"
 #include "openMVG/stl/stlMap.hpp"
 #include "openMVG/system/logger.hpp"
+#include "openMVG/system/profiler.hpp"
 #include "openMVG/types.hpp"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
@@ -70,6 +71,7 @@ bool ValidIds(const SfM_Data & sfm_data, ESfM_Data flags_part)
 
 bool Load(SfM_Data & sfm_data, const std::string & filename, ESfM_Data flags_part)
 {
+  OPENMVG_PROFILE_ZONE("LoadSfM_Data");
   bool bStatus = false;
   const std::string ext = stlplus::extension_part(filename);
   if (ext == "json")
@@ -97,6 +99,7 @@ bool Load(SfM_Data & sfm_data, const std::string & filename, ESfM_Data flags_par
 
 bool Save(const SfM_Data & sfm_data, const std::string & filename, ESfM_Data flags_part)
 {
+  OPENMVG_PROFILE_ZONE("SaveSfM_Data");
   const std::string ext = stlplus::extension_part(filename);
   if (ext == "json")
     return Save_Cereal<cereal::JSONOutputArchive>(sfm_data, filename, flags_part);
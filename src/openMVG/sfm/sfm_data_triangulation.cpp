@@ -18,6 +18,7 @@
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_landmark.hpp"
 #include "openMVG/system/loggerprogress.hpp"
+#include "openMVG/system/profiler.hpp"
 
 namespace openMVG {
 namespace sfm {
@@ -169,6 +170,7 @@ void SfM_Data_Structure_Computation_Blind::triangulate
 )
 const
 {
+  OPENMVG_PROFILE_ZONE("Triangulation");
   std::deque<IndexT> rejectedId;
   std::unique_ptr<system::ProgressInterface> my_progress_bar;
   if (bConsole_verbose_)
@@ -243,6 +245,7 @@ void SfM_Data_Structure_Computation_Robust::triangulate
 )
 const
 {
+  OPENMVG_PROFILE_ZONE("Triangulation");
   robust_triangulation(sfm_data);
 }
 
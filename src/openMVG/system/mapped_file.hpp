@@ -0,0 +1,66 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SYSTEM_MAPPED_FILE_HPP
+#define OPENMVG_SYSTEM_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace openMVG
+{
+namespace system
+{
+
+/**
+* @brief Read-only memory mapping of a whole file.
+* The file content is paged in by the OS on demand and shared between the
+* processes mapping the same file.
+*/
+class MappedFile
+{
+  public:
+
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    /**
+    * @brief Map a file in memory (a previously mapped file is released).
+    * @param filename The file to map
+    * @return True if the file has been mapped
+    */
+    bool open(const std::string & filename);
+
+    /**
+    * @brief Release the mapping.
+    */
+    void close();
+
+    bool is_open() const { return data_ != nullptr; }
+
+    /// First byte of the mapped file (nullptr if no file is mapped)
+    const unsigned char * data() const { return data_; }
+
+    /// Size of the mapped file in bytes
+    std::size_t size() const { return size_; }
+
+  private:
+    const unsigned char * data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void * file_handle_ = nullptr;
+    void * mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace system
+} // namespace openMVG
+
+#endif // OPENMVG_SYSTEM_MAPPED_FILE_HPP
@@ -0,0 +1,338 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/system/profiler.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace openMVG
+{
+namespace system
+{
+
+namespace
+{
+
+/// Escape a string to be used as a JSON value
+std::string JSONEscape( const std::string & str )
+{
+  std::string escaped;
+  escaped.reserve( str.size() );
+  for ( const char c : str )
+  {
+    switch ( c )
+    {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\t': escaped += "\\t"; break;
+      default: escaped += c;
+    }
+  }
+  return escaped;
+}
+
+} // namespace
+
+/// Zone statistics and trace events recorded by a single thread
+struct Profiler::ThreadData
+{
+  struct OpenZone
+  {
+    const char * name;
+    size_t parent_path_length;
+    clock::time_point start;
+  };
+
+  struct ZoneStats
+  {
+    uint64_t call_count = 0;
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+    uint64_t peak_rss_kb = 0;
+  };
+
+  struct TraceEvent
+  {
+    const char * name;
+    double start_us;
+    double duration_us;
+  };
+
+  explicit ThreadData( uint32_t id ) : thread_id( id ) {}
+
+  const uint32_t thread_id;
+  // Protect the recorded data against a concurrent report writing
+  std::mutex mutex;
+  std::string current_path;
+  std::vector<OpenZone> zone_stack;
+  std::unordered_map<std::string, ZoneStats> stats;
+  std::vector<TraceEvent> events;
+};
+
+std::atomic<bool> Profiler::enabled_( false );
+std::atomic<bool> Profiler::configured_( false );
+
+Profiler & Profiler::instance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+  : origin_( clock::now() ),
+    max_trace_events_per_thread_( 1 << 20 )
+{
+}
+
+Profiler::~Profiler()
+{
+  enabled_ = false;
+  if ( !json_report_path_.empty() && writeJSONReport( json_report_path_ ) )
+    OPENMVG_LOG_INFO << "Profiling report written to: " << json_report_path_;
+  if ( !chrome_trace_path_.empty() && writeChromeTrace( chrome_trace_path_ ) )
+    OPENMVG_LOG_INFO << "Profiling trace written to: " << chrome_trace_path_;
+}
+
+void Profiler::enable( bool enabled )
+{
+  enabled_ = enabled;
+}
+
+void Profiler::setReportFiles
+(
+  const std::string & json_report_path,
+  const std::string & chrome_trace_path
+)
+{
+  std::lock_guard<std::mutex> lock( threads_mutex_ );
+  json_report_path_ = json_report_path;
+  chrome_trace_path_ = chrome_trace_path;
+}
+
+void Profiler::setMaxTraceEventsPerThread( size_t max_events )
+{
+  max_trace_events_per_thread_ = max_events;
+}
+
+void Profiler::clear()
+{
+  std::lock_guard<std::mutex> lock( threads_mutex_ );
+  for ( auto & thread_data : threads_ )
+  {
+    std::lock_guard<std::mutex> thread_lock( thread_data->mutex );
+    thread_data->stats.clear();
+    thread_data->events.clear();
+  }
+}
+
+Profiler::ThreadData & Profiler::threadData()
+{
+  thread_local ThreadData * thread_data = nullptr;
+  if ( !thread_data )
+  {
+    std::lock_guard<std::mutex> lock( threads_mutex_ );
+    threads_.emplace_back( std::make_shared<ThreadData>(
+      static_cast<uint32_t>( threads_.size() ) ) );
+    thread_data = threads_.back().get();
+  }
+  return *thread_data;
+}
+
+void Profiler::beginZone( const char * name )
+{
+  ThreadData & thread_data = threadData();
+  const size_t parent_path_length = thread_data.current_path.size();
+  if ( parent_path_length > 0 )
+    thread_data.current_path += '/';
+  thread_data.current_path += name;
+  thread_data.zone_stack.push_back( { name, parent_path_length, clock::now() } );
+}
+
+void Profiler::endZone()
+{
+  const clock::time_point end = clock::now();
+  ThreadData & thread_data = threadData();
+  if ( thread_data.zone_stack.empty() )
+    return;
+  const ThreadData::OpenZone zone = thread_data.zone_stack.back();
+  thread_data.zone_stack.pop_back();
+
+  const double duration_ms =
+    std::chrono::duration<double, std::milli>( end - zone.start ).count();
+  // getrusage is a system call: sample the memory at the top-level zones only
+  const uint64_t peak_rss = thread_data.zone_stack.empty() ? peakRSS_KB() : 0;
+  {
+    std::lock_guard<std::mutex> lock( thread_data.mutex );
+    ThreadData::ZoneStats & stats = thread_data.stats[thread_data.current_path];
+    stats.min_ms = ( stats.call_count == 0 ) ? duration_ms : std::min( stats.min_ms, duration_ms );
+    stats.max_ms = std::max( stats.max_ms, duration_ms );
+    stats.total_ms += duration_ms;
+    stats.peak_rss_kb = std::max( stats.peak_rss_kb, peak_rss );
+    ++stats.call_count;
+
+    if ( thread_data.events.size() < max_trace_events_per_thread_ )
+    {
+      thread_data.events.push_back(
+        { zone.name,
+          std::chrono::duration<double, std::micro>( zone.start - origin_ ).count(),
+          duration_ms * 1000.0 } );
+    }
+  }
+  thread_data.current_path.resize( zone.parent_path_length );
+}
+
+std::vector<ProfileZoneStats> Profiler::zoneStats() const
+{
+  std::map<std::string, ProfileZoneStats> merged_stats;
+  {
+    std::lock_guard<std::mutex> lock( threads_mutex_ );
+    for ( const auto & thread_data : threads_ )
+    {
+      std::lock_guard<std::mutex> thread_lock( thread_data->mutex );
+      for ( const auto & stats_it : thread_data->stats )
+      {
+        const ThreadData::ZoneStats & stats = stats_it.second;
+        ProfileZoneStats & merged = merged_stats[stats_it.first];
+        merged.min_ms = ( merged.call_count == 0 ) ? stats.min_ms : std::min( merged.min_ms, stats.min_ms );
+        merged.max_ms = std::max( merged.max_ms, stats.max_ms );
+        merged.total_ms += stats.total_ms;
+        merged.call_count += stats.call_count;
+        merged.peak_rss_kb = std::max( merged.peak_rss_kb, stats.peak_rss_kb );
+        ++merged.thread_count;
+      }
+    }
+  }
+
+  std::vector<ProfileZoneStats> zone_stats;
+  zone_stats.reserve( merged_stats.size() );
+  for ( auto & merged_it : merged_stats )
+  {
+    merged_it.second.path = merged_it.first;
+    zone_stats.emplace_back( std::move( merged_it.second ) );
+  }
+  return zone_stats;
+}
+
+bool Profiler::writeJSONReport( const std::string & filename ) const
+{
+  std::ofstream stream( filename );
+  if ( !stream )
+  {
+    OPENMVG_LOG_ERROR << "Cannot write the profiling report: " << filename;
+    return false;
+  }
+
+  const std::vector<ProfileZoneStats> zone_stats = zoneStats();
+  stream << std::fixed << std::setprecision( 3 );
+  stream << "{\n  \"peak_rss_kb\": " << peakRSS_KB() << ",\n  \"zones\": [";
+  for ( size_t i = 0; i < zone_stats.size(); ++i )
+  {
+    const ProfileZoneStats & stats = zone_stats[i];
+    stream
+      << ( i == 0 ? "\n" : ",\n" )
+      << "    {\"path\": \"" << JSONEscape( stats.path ) << "\""
+      << ", \"calls\": " << stats.call_count
+      << ", \"threads\": " << stats.thread_count
+      << ", \"total_ms\": " << stats.total_ms
+      << ", \"mean_ms\": " << stats.total_ms / stats.call_count
+      << ", \"min_ms\": " << stats.min_ms
+      << ", \"max_ms\": " << stats.max_ms
+      << ", \"peak_rss_kb\": " << stats.peak_rss_kb << "}";
+  }
+  stream << "\n  ]\n}\n";
+  return stream.good();
+}
+
+bool Profiler::writeChromeTrace( const std::string & filename ) const
+{
+  std::ofstream stream( filename );
+  if ( !stream )
+  {
+    OPENMVG_LOG_ERROR << "Cannot write the profiling trace: " << filename;
+    return false;
+  }
+
+  stream << std::fixed << std::setprecision( 3 );
+  stream << "{\"traceEvents\": [";
+  bool first_event = true;
+  {
+    std::lock_guard<std::mutex> lock( threads_mutex_ );
+    for ( const auto & thread_data : threads_ )
+    {
+      std::lock_guard<std::mutex> thread_lock( thread_data->mutex );
+      for ( const auto & event : thread_data->events )
+      {
+        stream
+          << ( first_event ? "\n" : ",\n" )
+          << "  {\"name\": \"" << JSONEscape( event.name ) << "\""
+          << ", \"ph\": \"X\", \"pid\": 0"
+          << ", \"tid\": " << thread_data->thread_id
+          << ", \"ts\": " << event.start_us
+          << ", \"dur\": " << event.duration_us << "}";
+        first_event = false;
+      }
+    }
+  }
+  stream << "\n],\n\"displayTimeUnit\": \"ms\"}\n";
+  return stream.good();
+}
+
+uint64_t Profiler::peakRSS_KB()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    return static_cast<uint64_t>( counters.PeakWorkingSetSize / 1024 );
+  return 0;
+#else
+  struct rusage usage;
+  if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+    return 0;
+#if defined(__APPLE__)
+  return static_cast<uint64_t>( usage.ru_maxrss / 1024 ); // bytes on macOS
+#else
+  return static_cast<uint64_t>( usage.ru_maxrss );
+#endif
+#endif
+}
+
+bool ScopedProfileZone::initProfiler()
+{
+  // Configure the profiler from the environment on the first zone opening
+  static const bool env_enabled = []
+  {
+    const char * report_path = std::getenv( "OPENMVG_PROFILE_REPORT" );
+    const char * trace_path = std::getenv( "OPENMVG_PROFILE_TRACE" );
+    if ( !report_path && !trace_path )
+      return false;
+    Profiler & profiler = Profiler::instance();
+    profiler.setReportFiles( report_path ? report_path : "",
+                             trace_path ? trace_path : "" );
+    profiler.enable( true );
+    return true;
+  }();
+  Profiler::configured_ = true;
+  return env_enabled && Profiler::enabled();
+}
+
+} // namespace system
+} // namespace openMVG
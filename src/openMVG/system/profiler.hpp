@@ -0,0 +1,184 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SYSTEM_PROFILER_HPP
+#define OPENMVG_SYSTEM_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openMVG
+{
+namespace system
+{
+
+/**
+* @brief Statistics of a profiled zone (aggregated over all the threads).
+* Zones are identified by their hierarchical path ("parent/child").
+*/
+struct ProfileZoneStats
+{
+  std::string path;
+  uint64_t call_count = 0;
+  double total_ms = 0.0;
+  double min_ms = 0.0;
+  double max_ms = 0.0;
+  /// Process peak resident set size observed when the zone ended (in KB).
+  /// It is only sampled at the end of the top-level zones of each thread
+  /// (0 for the nested zones).
+  uint64_t peak_rss_kb = 0;
+  /// Number of threads that entered the zone
+  uint32_t thread_count = 0;
+};
+
+/**
+* @brief Hierarchical scoped-zone profiler.
+*
+* Zones are opened and closed by ScopedProfileZone (see OPENMVG_PROFILE_ZONE).
+* Each thread records its own zone stack, so nested zones are reported with
+* their full path (i.e "SfM/BundleAdjustment"), and zones opened in parallel
+* regions are attributed to the thread running them.
+*
+* The profiler is disabled by default: once the environment has been read, an
+* inactive zone costs two inlined relaxed atomic loads. It is enabled at the
+* first zone opening if one of these environment variables is set, and the
+* reports are written at exit:
+*  - OPENMVG_PROFILE_REPORT: path of a JSON per-zone summary,
+*  - OPENMVG_PROFILE_TRACE: path of a Chrome trace (chrome://tracing, Perfetto).
+*/
+class Profiler
+{
+  public:
+
+    /// Return the process wide profiler
+    static Profiler & instance();
+
+    ~Profiler();
+
+    /// Enable/Disable the zone recording
+    void enable( bool enabled );
+
+    /// Return true if the zones are recorded
+    static bool enabled()
+    {
+      return enabled_.load( std::memory_order_relaxed );
+    }
+
+    /// Return true once the profiler has been configured from the environment
+    static bool configured()
+    {
+      return configured_.load( std::memory_order_relaxed );
+    }
+
+    /**
+    * @brief Set the report files written when the profiler is destroyed.
+    * @param json_report_path JSON per-zone summary path (empty: no report)
+    * @param chrome_trace_path Chrome trace path (empty: no trace)
+    */
+    void setReportFiles
+    (
+      const std::string & json_report_path,
+      const std::string & chrome_trace_path
+    );
+
+    /// Maximal number of trace events stored per thread (the zone statistics
+    ///  keep being accumulated once this limit is reached).
+    void setMaxTraceEventsPerThread( size_t max_events );
+
+    /// Remove all the recorded data
+    void clear();
+
+    /// Open a zone on the calling thread (prefer ScopedProfileZone)
+    void beginZone( const char * name );
+
+    /// Close the last opened zone of the calling thread
+    void endZone();
+
+    /// Return the per zone statistics, sorted by zone path
+    std::vector<ProfileZoneStats> zoneStats() const;
+
+    /// Write the per zone statistics as JSON
+    bool writeJSONReport( const std::string & filename ) const;
+
+    /// Write the recorded zones as a Chrome trace event file
+    bool writeChromeTrace( const std::string & filename ) const;
+
+    /// Return the process peak resident set size (in KB, 0 if unknown)
+    static uint64_t peakRSS_KB();
+
+  private:
+
+    Profiler();
+    Profiler( const Profiler & ) = delete;
+    Profiler & operator=( const Profiler & ) = delete;
+
+    struct ThreadData;
+    ThreadData & threadData();
+
+    static std::atomic<bool> enabled_;
+    static std::atomic<bool> configured_;
+
+    friend class ScopedProfileZone;
+
+    using clock = std::chrono::steady_clock;
+    const clock::time_point origin_;
+
+    mutable std::mutex threads_mutex_;
+    std::vector<std::shared_ptr<ThreadData>> threads_;
+    std::atomic<size_t> max_trace_events_per_thread_;
+
+    std::string json_report_path_;
+    std::string chrome_trace_path_;
+};
+
+/**
+* @brief RAII profiled zone: the zone is opened at construction and closed at
+*  destruction. It does nothing if the profiler is disabled when it is built.
+* @param name Zone name (must outlive the zone, use a string literal).
+*/
+class ScopedProfileZone
+{
+  public:
+    explicit ScopedProfileZone( const char * name )
+      : active_( Profiler::enabled() || ( !Profiler::configured() && initProfiler() ) )
+    {
+      if ( active_ )
+        Profiler::instance().beginZone( name );
+    }
+
+    ~ScopedProfileZone()
+    {
+      if ( active_ )
+        Profiler::instance().endZone();
+    }
+
+    ScopedProfileZone( const ScopedProfileZone & ) = delete;
+    ScopedProfileZone & operator=( const ScopedProfileZone & ) = delete;
+
+  private:
+    /// Configure the profiler from the environment (once), return its state
+    static bool initProfiler();
+
+    const bool active_;
+};
+
+} // namespace system
+} // namespace openMVG
+
+#define OPENMVG_PROFILE_CONCAT_IMPL( a, b ) a##b
+#define OPENMVG_PROFILE_CONCAT( a, b ) OPENMVG_PROFILE_CONCAT_IMPL( a, b )
+
+/// Profile the enclosing scope as a zone named 'name' (a string literal)
+#define OPENMVG_PROFILE_ZONE( name ) \
+  const ::openMVG::system::ScopedProfileZone \
+    OPENMVG_PROFILE_CONCAT( openMVG_profile_zone_, __LINE__ )( name )
+
+#endif // OPENMVG_SYSTEM_PROFILER_HPP
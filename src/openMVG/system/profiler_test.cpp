@@ -0,0 +1,160 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/system/profiler.hpp"
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace openMVG::system;
+
+namespace
+{
+const ProfileZoneStats * FindZone
+(
+  const std::vector<ProfileZoneStats> & zone_stats,
+  const std::string & path
+)
+{
+  for (const auto & stats : zone_stats)
+    if (stats.path == path)
+      return &stats;
+  return nullptr;
+}
+
+// Path of a file in the temporary directory
+std::string TemporaryPath(const std::string & filename)
+{
+#if defined(_WIN32)
+  const char * temp_dir = std::getenv("TEMP");
+  const std::string dir = temp_dir ? temp_dir : ".";
+  return dir + "\\" + filename;
+#else
+  const char * temp_dir = std::getenv("TMPDIR");
+  const std::string dir = temp_dir ? temp_dir : "/tmp";
+  return dir + "/" + filename;
+#endif
+}
+
+std::string ReadFile(const std::string & filename)
+{
+  std::ifstream stream(filename);
+  return std::string((std::istreambuf_iterator<char>(stream)),
+    std::istreambuf_iterator<char>());
+}
+}
+
+TEST(Profiler, Disabled)
+{
+  Profiler & profiler = Profiler::instance();
+  profiler.enable(false);
+  profiler.clear();
+  {
+    OPENMVG_PROFILE_ZONE("Root");
+  }
+  EXPECT_TRUE(profiler.zoneStats().empty());
+}
+
+TEST(Profiler, HierarchicalZones)
+{
+  Profiler & profiler = Profiler::instance();
+  profiler.enable(true);
+  profiler.clear();
+  {
+    OPENMVG_PROFILE_ZONE("Root");
+    for (int i = 0; i < 3; ++i)
+    {
+      OPENMVG_PROFILE_ZONE("Child");
+      OPENMVG_PROFILE_ZONE("GrandChild");
+    }
+  }
+  {
+    OPENMVG_PROFILE_ZONE("Child");
+  }
+  profiler.enable(false);
+
+  const std::vector<ProfileZoneStats> zone_stats = profiler.zoneStats();
+  EXPECT_EQ(4, zone_stats.size());
+  const ProfileZoneStats * root = FindZone(zone_stats, "Root");
+  const ProfileZoneStats * child = FindZone(zone_stats, "Root/Child");
+  const ProfileZoneStats * grand_child = FindZone(zone_stats, "Root/Child/GrandChild");
+  const ProfileZoneStats * top_child = FindZone(zone_stats, "Child");
+  EXPECT_TRUE(root && child && grand_child && top_child);
+  EXPECT_EQ(1, root->call_count);
+  EXPECT_EQ(3, child->call_count);
+  EXPECT_EQ(3, grand_child->call_count);
+  EXPECT_EQ(1, top_child->call_count);
+  EXPECT_TRUE(root->total_ms >= child->total_ms);
+  EXPECT_TRUE(child->min_ms <= child->max_ms);
+  EXPECT_TRUE(child->total_ms >= grand_child->total_ms);
+  // The memory is sampled at the end of the top-level zones only
+  EXPECT_TRUE(root->peak_rss_kb > 0);
+  EXPECT_TRUE(top_child->peak_rss_kb > 0);
+  EXPECT_EQ(0, child->peak_rss_kb);
+  EXPECT_EQ(0, grand_child->peak_rss_kb);
+}
+
+TEST(Profiler, MultiThreaded)
+{
+  Profiler & profiler = Profiler::instance();
+  profiler.enable(true);
+  profiler.clear();
+  const int count = 1000;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for num_threads(4)
+#endif
+  for (int i = 0; i < count; ++i)
+  {
+    OPENMVG_PROFILE_ZONE("Parallel");
+  }
+  profiler.enable(false);
+
+  const std::vector<ProfileZoneStats> zone_stats = profiler.zoneStats();
+  EXPECT_EQ(1, zone_stats.size());
+  EXPECT_EQ("Parallel", zone_stats[0].path);
+  EXPECT_EQ(count, zone_stats[0].call_count);
+  EXPECT_TRUE(zone_stats[0].thread_count >= 1);
+}
+
+TEST(Profiler, Reports)
+{
+  Profiler & profiler = Profiler::instance();
+  profiler.enable(true);
+  profiler.clear();
+  {
+    OPENMVG_PROFILE_ZONE("Stage");
+  }
+  profiler.enable(false);
+
+  const std::string report_path = TemporaryPath("openMVG_profiler_report_test.json");
+  const std::string trace_path = TemporaryPath("openMVG_profiler_trace_test.json");
+  EXPECT_TRUE(profiler.writeJSONReport(report_path));
+  EXPECT_TRUE(profiler.writeChromeTrace(trace_path));
+
+  const std::string report_content = ReadFile(report_path);
+  EXPECT_TRUE(report_content.find("\"path\": \"Stage\"") != std::string::npos);
+  EXPECT_TRUE(report_content.find("\"calls\": 1") != std::string::npos);
+
+  const std::string trace_content = ReadFile(trace_path);
+  EXPECT_TRUE(trace_content.find("\"traceEvents\"") != std::string::npos);
+  EXPECT_TRUE(trace_content.find("\"name\": \"Stage\", \"ph\": \"X\"") != std::string::npos);
+
+  EXPECT_EQ(0, std::remove(report_path.c_str()));
+  EXPECT_EQ(0, std::remove(trace_path.c_str()));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
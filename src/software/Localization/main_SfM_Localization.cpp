@@ -67,6 +67,9 @@ int main(int argc, char **argv)
   bool bUseSingleIntrinsics = false;
   bool bExportStructure = false;
   int resection_method  = static_cast<int>(resection::SolverType::DEFAULT);
+  std::string sDatabase_Filename;
+  unsigned int max_descriptors_per_landmark = 0;
+  unsigned int vocabulary_size = 0;
 
 #ifdef OPENMVG_USE_OPENMP
   int iNumThreads = 0;
@@ -82,6 +85,9 @@ int main(int argc, char **argv)
   cmd.add( make_switch('s', "single_intrinsics"));
   cmd.add( make_switch('e', "export_structure"));
   cmd.add( make_option('R', resection_method, "resection_method"));
+  cmd.add( make_option('d', sDatabase_Filename, "database_file"));
+  cmd.add( make_option('k', max_descriptors_per_landmark, "descriptors_per_landmark"));
+  cmd.add( make_option('V', vocabulary_size, "vocabulary_size"));
 
 #ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
@@ -104,6 +110,14 @@ int main(int argc, char **argv)
     << "\n"
     << "(optional)\n"
     << "[-r|--residual_error] upper bound of the residual error tolerance\n"
+    << "[-d|--database_file] localization database file:\n"
+    << "  loaded if it exists (the scene regions are not read), else built and saved\n"
+    << "[-k|--descriptors_per_landmark] number of descriptors kept per landmark\n"
+    << "  when the database is built (default: 0 -> all the observations)\n"
+    << "[-V|--vocabulary_size] size of the coarse vocabulary used to retrieve the views\n"
+    << "  close to a query: only the landmarks of these views and of their covisible\n"
+    << "  views are matched (default: 0 -> exhaustive search of the landmarks)\n"
+    << "  (with -d, the vocabulary and its inverted file are stored next to the database)\n"
     << "[-s|--single_intrinsics] (switch) when switched on, the program will check if the input sfm_data\n"
     << "  contains a single intrinsics and, if so, take this value as intrinsics for the query images.\n"
     << "  (OFF by default)\n"
@@ -200,16 +214,6 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  // Show the progress on the command line:
-  system::LoggerProgress progress;
-
-  // Load the SfM_Data region's views
-  std::shared_ptr<Regions_Provider> regions_provider = std::make_shared<Regions_Provider>();
-  if (!regions_provider->load(sfm_data, sMatchesDir, regions_type, &progress)) {
-    std::cerr << std::endl << "Invalid regions." << std::endl;
-    return EXIT_FAILURE;
-  }
-
   if ( !stlplus::folder_exists( sQueryDir ) && !stlplus::file_exists( sQueryDir ) )
   {
     std::cerr << "\nThe query directory/file does not exist : " << std::endl;
@@ -240,13 +244,40 @@ int main(int argc, char **argv)
 
   std::vector<Vec3> vec_found_poses;
 
-  sfm::SfM_Localization_Single_3DTrackObservation_Database localizer;
-  if (!localizer.Init(sfm_data, *regions_provider.get()))
+  sfm::SfM_Localization_Single_3DTrackObservation_Database localizer(max_descriptors_per_landmark);
+  if (vocabulary_size > 0)
   {
-    std::cerr << "Cannot initialize the SfM localizer" << std::endl;
+    Covisibility_Landmark_Search::Options search_options;
+    search_options.vocabulary_size = vocabulary_size;
+    localizer.EnableCovisibilitySearch(search_options);
+  }
+  // Restore a previously saved database
+  const bool bDatabase_loaded = !sDatabase_Filename.empty()
+    && stlplus::file_exists(sDatabase_Filename)
+    && localizer.Load(sfm_data, sDatabase_Filename, *regions_type);
+  if (!bDatabase_loaded)
+  {
+    // Show the progress on the command line:
+    system::LoggerProgress progress;
+
+    // Load the SfM_Data region's views
+    std::shared_ptr<Regions_Provider> regions_provider = std::make_shared<Regions_Provider>();
+    if (!regions_provider->load(sfm_data, sMatchesDir, regions_type, &progress)) {
+      std::cerr << std::endl << "Invalid regions." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (!localizer.Init(sfm_data, *regions_provider.get()))
+    {
+      std::cerr << "Cannot initialize the SfM localizer" << std::endl;
+    }
+    else if (!sDatabase_Filename.empty() && !localizer.Save(sDatabase_Filename))
+    {
+      std::cerr << "Cannot save the localization database: " << sDatabase_Filename << std::endl;
+    }
+    // Since we have copied interesting data, release some memory
+    regions_provider.reset();
   }
-  // Since we have copied interesting data, release some memory
-  regions_provider.reset();
 
   // list images from sfm_data in a vector
   std::vector<std::string> vec_image_original (sfm_data.GetViews().size());
@@ -0,0 +1,327 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/json.hpp>
+
+#include <openMVG/cameras/cameras.hpp>
+#include <openMVG/features/image_describer.hpp>
+#include <openMVG/image/image_io.hpp>
+#include <openMVG/sfm/pipelines/localization/SfM_Localization_Service.hpp>
+#include <openMVG/sfm/sfm.hpp>
+#include <openMVG/system/loggerprogress.hpp>
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+#include "nonFree/sift/SIFT_describer_io.hpp"
+#include "openMVG/features/akaze/image_describer_akaze_io.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// Parse a request line:
+//  {"id": "query_0", "image": "/path/to/image.jpg"}
+// or a plain image path (the path is used as the query id).
+bool ParseRequest(const std::string & line, Localization_Query & query)
+{
+  if (line.empty() || line[0] != '{')
+  {
+    query.id = query.image_path = line;
+    return !line.empty();
+  }
+  try
+  {
+    std::istringstream stream(line);
+    cereal::JSONInputArchive archive(stream);
+    archive(cereal::make_nvp("image", query.image_path));
+    try
+    {
+      archive(cereal::make_nvp("id", query.id));
+    }
+    catch (const cereal::Exception &)
+    {
+      query.id = query.image_path;
+    }
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << "Invalid request: " << line << " (" << e.what() << ")" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::string JsonEscape(const std::string & value)
+{
+  std::ostringstream os;
+  for (const char c : value)
+  {
+    switch (c)
+    {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+        else
+          os << c;
+    }
+  }
+  return os.str();
+}
+
+// Write a result as a single JSON line
+void WriteResult(std::ostream & os, const Localization_Result & result)
+{
+  os << std::setprecision(12)
+    << "{\"id\": \"" << JsonEscape(result.id) << "\""
+    << ", \"localized\": " << (result.localized ? "true" : "false")
+    << ", \"width\": " << result.image_size.first
+    << ", \"height\": " << result.image_size.second
+    << ", \"putatives\": " << result.nb_putatives
+    << ", \"inliers\": " << result.nb_inliers;
+  if (result.localized)
+  {
+    const Mat3 & R = result.pose.rotation();
+    const Vec3 & C = result.pose.center();
+    os << ", \"rotation\": [";
+    for (int i = 0; i < 9; ++i)
+      os << (i ? ", " : "") << R(i / 3, i % 3);
+    os << "], \"center\": [" << C(0) << ", " << C(1) << ", " << C(2) << "]";
+  }
+  os << ", \"latency_ms\": " << result.latency * 1000.0 << "}" << std::endl;
+}
+
+// ----------------------------------------------------
+// Localization service:
+// - the database and the matcher are loaded once,
+// - the requests are read from stdin (one per line),
+// - the results are written to stdout (one JSON object per line).
+// ----------------------------------------------------
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  std::string sSfM_Data_Filename;
+  std::string sMatchesDir;
+  std::string sDatabase_Filename;
+  unsigned int max_descriptors_per_landmark = 0;
+  unsigned int vocabulary_size = 0;
+  double dMaxResidualError = std::numeric_limits<double>::infinity();
+  int resection_method  = static_cast<int>(resection::SolverType::DEFAULT);
+  SfM_Localization_Service::Options service_options;
+  service_options.nb_describe_threads =
+    std::max(1u, std::thread::hardware_concurrency() / 2);
+  service_options.nb_resection_threads = service_options.nb_describe_threads;
+
+  cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
+  cmd.add( make_option('m', sMatchesDir, "match_dir") );
+  cmd.add( make_option('d', sDatabase_Filename, "database_file"));
+  cmd.add( make_option('k', max_descriptors_per_landmark, "descriptors_per_landmark"));
+  cmd.add( make_option('V', vocabulary_size, "vocabulary_size"));
+  cmd.add( make_option('r', dMaxResidualError, "residual_error"));
+  cmd.add( make_switch('s', "single_intrinsics"));
+  cmd.add( make_option('R', resection_method, "resection_method"));
+  cmd.add( make_option('b', service_options.max_batch_size, "batch_size"));
+  cmd.add( make_option('w', service_options.max_batch_delay_ms, "batch_delay"));
+  cmd.add( make_option('t', service_options.nb_describe_threads, "describe_threads"));
+  cmd.add( make_option('T', service_options.nb_resection_threads, "resection_threads"));
+
+  try {
+    if (argc == 1) throw std::string("Invalid parameter.");
+    cmd.process(argc, argv);
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+    << "[-i|--input_file] path to a SfM_Data scene\n"
+    << "[-m|--match_dir] path to the directory containing the matches\n"
+    << "  corresponding to the provided SfM_Data scene\n"
+    << "\n"
+    << "Requests are read from stdin, one per line:\n"
+    << "  {\"id\": \"query\", \"image\": \"/path/to/image.jpg\"} or an image path\n"
+    << "Results are written to stdout, one JSON object per line.\n"
+    << "\n"
+    << "(optional)\n"
+    << "[-d|--database_file] localization database file:\n"
+    << "  loaded if it exists (the scene regions are not read), else built and saved\n"
+    << "[-k|--descriptors_per_landmark] number of descriptors kept per landmark\n"
+    << "  when the database is built (default: 0 -> all the observations)\n"
+    << "[-V|--vocabulary_size] size of the coarse vocabulary used to retrieve the views\n"
+    << "  close to a query: only the landmarks of these views and of their covisible\n"
+    << "  views are matched (default: 0 -> exhaustive search of the landmarks)\n"
+    << "  (with -d, the vocabulary and its inverted file are stored next to the database)\n"
+    << "[-r|--residual_error] upper bound of the residual error tolerance\n"
+    << "[-s|--single_intrinsics] (switch) use the single intrinsics of the scene for the queries\n"
+    << "  (OFF by default: unknown intrinsics, DLT resection)\n"
+    << "[-R|--resection_method] resection/pose estimation method (default=" << resection_method << "):\n"
+      << "\t" << static_cast<int>(resection::SolverType::DLT_6POINTS) << ": DIRECT_LINEAR_TRANSFORM 6Points | does not use intrinsic data\n"
+      << "\t" << static_cast<int>(resection::SolverType::P3P_KE_CVPR17) << ": P3P_KE_CVPR17\n"
+      << "\t" << static_cast<int>(resection::SolverType::P3P_KNEIP_CVPR11) << ": P3P_KNEIP_CVPR11\n"
+      << "\t" << static_cast<int>(resection::SolverType::P3P_NORDBERG_ECCV18) << ": P3P_NORDBERG_ECCV18\n"
+      << "\t" << static_cast<int>(resection::SolverType::UP2P_KUKELOVA_ACCV10)  << ": UP2P_KUKELOVA_ACCV10 | 2Points | upright camera\n"
+    << "[-b|--batch_size] maximum number of queries matched together (default=" << service_options.max_batch_size << ")\n"
+    << "[-w|--batch_delay] time (ms) waited for other queries to fill a batch (default=" << service_options.max_batch_delay_ms << ")\n"
+    << "[-t|--describe_threads] number of image decoding/description thread(s)\n"
+    << "[-T|--resection_threads] number of resection thread(s)\n"
+    << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Load input SfM_Data scene
+  SfM_Data sfm_data;
+  if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(ALL))) {
+    std::cerr << std::endl
+      << "The input SfM_Data file \""<< sSfM_Data_Filename << "\" cannot be read." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (sfm_data.GetPoses().empty() || sfm_data.GetLandmarks().empty())
+  {
+    std::cerr << std::endl
+      << "The input SfM_Data file have not 3D content to match with." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::shared_ptr<cameras::IntrinsicBase> single_intrinsic;
+  if (cmd.used('s'))
+  {
+    if (sfm_data.GetIntrinsics().size() != 1)
+    {
+      std::cerr << "You choose the single intrinsic mode but the sfm_data scene,"
+        << " have too few or too much intrinsics." << std::endl;
+      return EXIT_FAILURE;
+    }
+    single_intrinsic = sfm_data.GetIntrinsics().begin()->second;
+  }
+
+  // Init the regions_type and the feature extractor that have been used for the reconstruction
+  using namespace openMVG::features;
+  const std::string sImage_describer = stlplus::create_filespec(sMatchesDir, "image_describer", "json");
+  std::unique_ptr<Regions> regions_type = Init_region_type_from_file(sImage_describer);
+  if (!regions_type)
+  {
+    std::cerr << "Invalid: "
+      << sImage_describer << " regions type file." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<Image_describer> image_describer;
+  {
+    std::ifstream stream(sImage_describer.c_str());
+    if (!stream)
+    {
+      std::cerr << "Expected file image_describer.json cannot be opened." << std::endl;
+      return EXIT_FAILURE;
+    }
+    try
+    {
+      cereal::JSONInputArchive archive(stream);
+      archive(cereal::make_nvp("image_describer", image_describer));
+    }
+    catch (const cereal::Exception & e)
+    {
+      std::cerr << e.what() << std::endl
+        << "Cannot dynamically allocate the Image_describer interface." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Init the resident retrieval database
+  SfM_Localization_Single_3DTrackObservation_Database localizer(max_descriptors_per_landmark);
+  if (vocabulary_size > 0)
+  {
+    Covisibility_Landmark_Search::Options search_options;
+    search_options.vocabulary_size = vocabulary_size;
+    localizer.EnableCovisibilitySearch(search_options);
+  }
+  const bool bDatabase_loaded = !sDatabase_Filename.empty()
+    && stlplus::file_exists(sDatabase_Filename)
+    && localizer.Load(sfm_data, sDatabase_Filename, *regions_type);
+  if (!bDatabase_loaded)
+  {
+    system::LoggerProgress progress;
+    std::shared_ptr<Regions_Provider> regions_provider = std::make_shared<Regions_Provider>();
+    if (!regions_provider->load(sfm_data, sMatchesDir, regions_type, &progress)) {
+      std::cerr << std::endl << "Invalid regions." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!localizer.Init(sfm_data, *regions_provider.get()))
+    {
+      std::cerr << "Cannot initialize the SfM localizer" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!sDatabase_Filename.empty() && !localizer.Save(sDatabase_Filename))
+    {
+      std::cerr << "Cannot save the localization database: " << sDatabase_Filename << std::endl;
+    }
+  }
+
+  // Decode and describe a query image
+  const auto describe = [&](
+    const Localization_Query & query,
+    std::unique_ptr<Regions> & regions,
+    Pair & image_size)
+  {
+    image::Image<unsigned char> imageGray;
+    if (!image::ReadImage(query.image_path.c_str(), &imageGray))
+      return false;
+    image_size = {imageGray.Width(), imageGray.Height()};
+    if (single_intrinsic &&
+        (single_intrinsic->w() != imageGray.Width() || single_intrinsic->h() != imageGray.Height()))
+    {
+      std::cerr << "The image " << query.image_path
+        << " does not have the same size as the camera model." << std::endl;
+      return false;
+    }
+    regions = image_describer->Describe(imageGray);
+    return regions != nullptr;
+  };
+
+  const auto on_result = [](const Localization_Result & result)
+  {
+    WriteResult(std::cout, result);
+  };
+
+  std::cerr << "Localization service ready: "
+    << sfm_data.GetLandmarks().size() << " landmarks." << std::endl;
+
+  SfM_Localization_Service service(localizer, describe, on_result, service_options);
+  service.Start();
+  std::string line;
+  while (std::getline(std::cin, line))
+  {
+    Localization_Query query;
+    if (!ParseRequest(line, query))
+      continue;
+    query.intrinsics = single_intrinsic;
+    query.solver_type = static_cast<resection::SolverType>(resection_method);
+    query.max_residual_error = dMaxResidualError;
+    service.Submit(query);
+  }
+  service.Stop();
+
+  const Localization_Service_Stats stats = service.Stats();
+  std::cerr << "\n#queries: " << stats.nb_queries
+    << "\n#localized: " << stats.nb_localized
+    << "\n#batches: " << stats.nb_batches
+    << "\nthroughput: " << stats.throughput << " queries/s"
+    << "\nlatency (ms): p50 " << stats.latency_p50 * 1000.0
+    << " | p90 " << stats.latency_p90 * 1000.0
+    << " | p99 " << stats.latency_p99 * 1000.0
+    << " | max " << stats.latency_max * 1000.0 << std::endl;
+
+  return EXIT_SUCCESS;
+}
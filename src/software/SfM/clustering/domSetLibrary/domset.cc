@@ -13,8 +13,10 @@
 
 #include <fstream>
 #include <limits>
+#include <queue>
 #include <random>
 #include <set>
+#include <sstream>
 
 #define for_parallel(i, nIters) for (int i = 0; i < static_cast<int>(nIters); ++i)
 
@@ -29,7 +31,6 @@ void Domset::computeInformation()
   OPENMVG_LOG_INFO << "[ Dominant set clustering of views ]";
   normalizePointCloud();
   voxelGridFilter( kVoxelSize, kVoxelSize, kVoxelSize );
-  getAllDistances();
 }
 
 void Domset::normalizePointCloud()
@@ -53,8 +54,9 @@ void Domset::normalizePointCloud()
     const Point &p           = points[ i ];
     const float queryPt[ 3 ] = {p.pos( 0 ), p.pos( 1 ), p.pos( 2 )};
 
-    IndMatches ret_index( 2 );
-    std::vector<float> out_dist_sqr( 2);
+    // the search appends its results (the first neighbor is the point itself)
+    IndMatches ret_index;
+    std::vector<float> out_dist_sqr;
     const int NN = 2;
     matcher.SearchNeighbours(queryPt, 1, &ret_index, &out_dist_sqr, NN);
 
@@ -142,7 +144,7 @@ void Domset::voxelGridFilter( const float &sizeX, const float &sizeY, const floa
   Point maxPt;
   const size_t numP = points.size();
   // finding the min and max values for the 3 dimensions
-  const float mi = std::numeric_limits<float>::min();
+  const float mi = std::numeric_limits<float>::lowest();
   const float ma = std::numeric_limits<float>::max();
   minPt.pos << ma, ma, ma;
   maxPt.pos << mi, mi, mi;
@@ -165,9 +167,8 @@ void Domset::voxelGridFilter( const float &sizeX, const float &sizeY, const floa
   }
 
   // finding the number of voxels reqired
-  //size_t numVoxelX = static_cast<size_t>( ceil( maxPt.pos( 0 ) - minPt.pos( 0 ) ) / sizeX );
-  const size_t numVoxelY = static_cast<size_t>( ceil( maxPt.pos( 1 ) - minPt.pos( 1 ) ) / sizeY );
-  const size_t numVoxelZ = static_cast<size_t>( ceil( maxPt.pos( 2 ) - minPt.pos( 2 ) ) / sizeZ );
+  const size_t numVoxelX = static_cast<size_t>( floor( ( maxPt.pos( 0 ) - minPt.pos( 0 ) ) / sizeX ) ) + 1;
+  const size_t numVoxelY = static_cast<size_t>( floor( ( maxPt.pos( 1 ) - minPt.pos( 1 ) ) / sizeY ) ) + 1;
   /*
   std::cout << "Max = " << maxPt.pos.transpose() << std::endl;
   std::cout << "Min = " << minPt.pos.transpose() << std::endl;
@@ -177,7 +178,6 @@ void Domset::voxelGridFilter( const float &sizeX, const float &sizeY, const floa
   std::cout << "VoxelSize Z = " << sizeZ << std::endl;
   std::cout << "Number Voxel X = " << numVoxelX << std::endl;
   std::cout << "Number Voxel Y = " << numVoxelY << std::endl;
-  std::cout << "Number Voxel Z = " << numVoxelZ << std::endl;
   */
 
   /* adding points to the voxels */
@@ -192,7 +192,8 @@ void Domset::voxelGridFilter( const float &sizeX, const float &sizeY, const floa
     const size_t x  = static_cast<size_t>( floor( ( pt.pos( 0 ) - minPt.pos( 0 ) ) / sizeX ) );
     const size_t y  = static_cast<size_t>( floor( ( pt.pos( 1 ) - minPt.pos( 1 ) ) / sizeY ) );
     const size_t z  = static_cast<size_t>( floor( ( pt.pos( 2 ) - minPt.pos( 2 ) ) / sizeZ ) );
-    const size_t id = ( z * numVoxelZ ) + ( y * numVoxelY ) + x;
+    // unique id of the voxel (no collision between distant voxels)
+    const size_t id = ( z * numVoxelY + y ) * numVoxelX + x;
 #if OPENMVG_USE_OPENMP
 #pragma omp critical( voxelGridUpdate )
 #endif
@@ -219,7 +220,7 @@ void Domset::voxelGridFilter( const float &sizeX, const float &sizeY, const floa
     if ( nPts == 0 )
       continue;
 
-    Eigen::Vector3f pos;
+    Eigen::Vector3f pos = Eigen::Vector3f::Zero();
     std::set<size_t> vl;
     for ( const auto &p : voxels[ vId ] )
     {
@@ -302,7 +303,7 @@ float Domset::computeViewDistance( const size_t &vId1, const size_t &vId2, const
 {
   if ( vId1 == vId2 )
     return 1.f;
-  const float vd = viewDists( vId1, vId2 );
+  const float vd = getViewDistance( vId1, vId2 );
   const float dm = 1.f + exp( -( vd - medianDist ) / medianDist );
   return 1.f / dm;
 }
@@ -329,35 +330,13 @@ float Domset::getDistanceMedian( const std::map<size_t, size_t> &xId2vId ) const
       if ( i == j )
         continue;
       const size_t v2 = xId2vId.at( j );
-      dists.push_back( viewDists( v1, v2 ) );
+      dists.push_back( getViewDistance( v1, v2 ) );
     }
   }
   std::sort( dists.begin(), dists.end() );
   return dists[ dists.size() / 2 ];
 } // getDistanceMedian
 
-void Domset::getAllDistances()
-{
-//  std::cout << "Finding View Distances\n";
-  const size_t numC = views.size();
-  if ( numC == 0 )
-  {
-    OPENMVG_LOG_ERROR << "No Views initialized";
-    exit( 0 );
-  }
-  viewDists.resize( numC, numC );
-  for ( size_t i = 0; i < numC; i++ )
-  {
-    const auto v1 = views[ i ];
-    for ( size_t j = 0; j < numC; j++ )
-    {
-      const auto v2    = views[ j ];
-      const float dist = ( v1.trans - v2.trans ).norm();
-      viewDists( i, j ) = dist;
-    }
-  }
-}
-
 void Domset::findCommonPoints( const View &v1, const View &v2,
                                std::vector<size_t> &commonPoints ) const
 {
@@ -542,9 +521,9 @@ void Domset::computeClustersAP( std::map<size_t, size_t> &xId2vId,
           if ( p1->first == p2->first )
             continue;
           const size_t vId2 = xId2vId.at( p2->first );
-          if ( viewDists( vId1, vId2 ) < minDist && ( p1->second.size() + p2->second.size() ) < kMaxClusterSize )
+          if ( getViewDistance( vId1, vId2 ) < minDist && ( p1->second.size() + p2->second.size() ) < kMaxClusterSize )
           {
-            minDist = viewDists( vId1, vId2 );
+            minDist = getViewDistance( vId1, vId2 );
             minId   = p2->first;
           }
         }
@@ -602,6 +581,384 @@ void Domset::computeClustersAP( std::map<size_t, size_t> &xId2vId,
   }
 }
 
+void Domset::getSimilarityGraph( SimilarityGraph &graph ) const
+{
+  const size_t numC = views.size();
+  if ( numC == 0 || points.empty() )
+  {
+    OPENMVG_LOG_ERROR << "Invalid Data";
+    exit( 0 );
+  }
+
+  // angle similarity of each view with its covisible views
+  std::vector<std::vector<std::pair<size_t, float>>> rows( numC );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel
+#endif
+  {
+    // accumulators of the common points (reset after each view)
+    std::vector<float> weights( numC, 0.f );
+    std::vector<unsigned int> counts( numC, 0 );
+    std::vector<size_t> covisibleViews;
+#if OPENMVG_USE_OPENMP
+#pragma omp for schedule( dynamic )
+#endif
+    for_parallel( vId1, numC )
+    {
+      const View &v1 = views[ vId1 ];
+      for ( const size_t pId : v1.viewPoints )
+      {
+        const Eigen::Vector3f c1 = ( v1.trans - points[ pId ].pos ).normalized();
+        for ( const size_t vId2 : points[ pId ].viewList )
+        {
+          if ( vId2 == static_cast<size_t>( vId1 ) )
+            continue;
+          const Eigen::Vector3f c2 = ( views[ vId2 ].trans - points[ pId ].pos ).normalized();
+          const float angle = acos( std::min( 1.f, std::max( -1.f, c1.dot( c2 ) ) ) );
+          if ( counts[ vId2 ]++ == 0 )
+            covisibleViews.push_back( vId2 );
+          weights[ vId2 ] += exp( -( angle * angle ) / kAngleSigma_2 );
+        }
+      }
+      std::sort( covisibleViews.begin(), covisibleViews.end() );
+      auto &row = rows[ vId1 ];
+      row.reserve( covisibleViews.size() );
+      for ( const size_t vId2 : covisibleViews )
+      {
+        row.emplace_back( vId2, weights[ vId2 ] / counts[ vId2 ] );
+        weights[ vId2 ] = 0.f;
+        counts[ vId2 ]  = 0;
+      }
+      covisibleViews.clear();
+    }
+  }
+
+  // median distance of the covisible views
+  std::vector<float> dists;
+  for ( size_t i = 0; i < numC; i++ )
+    for ( const auto &edge : rows[ i ] )
+      if ( edge.first > i )
+        dists.push_back( getViewDistance( i, edge.first ) );
+  float medianDist = 1.f;
+  if ( !dists.empty() )
+  {
+    std::nth_element( dists.begin(), dists.begin() + dists.size() / 2, dists.end() );
+    medianDist = std::max( dists[ dists.size() / 2 ], std::numeric_limits<float>::epsilon() );
+  }
+
+  // compressed rows, the view itself first (0 similarity as in the dense matrix)
+  graph.offsets.assign( numC + 1, 0 );
+  for ( size_t i = 0; i < numC; i++ )
+    graph.offsets[ i + 1 ] = graph.offsets[ i ] + 1 + rows[ i ].size();
+  const size_t numE = graph.offsets.back();
+  graph.neighbors.resize( numE );
+  graph.reverse.resize( numE );
+  graph.similarities.resize( numE );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
+  for_parallel( i, numC )
+  {
+    size_t e = graph.offsets[ i ];
+    graph.neighbors[ e ]    = i;
+    graph.similarities[ e ] = 0.f;
+    for ( const auto &edge : rows[ i ] )
+    {
+      ++e;
+      graph.neighbors[ e ]    = edge.first;
+      graph.similarities[ e ] = edge.second * computeViewDistance( i, edge.first, medianDist );
+    }
+  }
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
+  for_parallel( i, numC )
+  {
+    graph.reverse[ graph.offsets[ i ] ] = graph.offsets[ i ];
+    for ( size_t e = graph.offsets[ i ] + 1; e < graph.offsets[ i + 1 ]; ++e )
+    {
+      const size_t j = graph.neighbors[ e ];
+      graph.reverse[ e ] = std::lower_bound(
+          graph.neighbors.cbegin() + graph.offsets[ j ] + 1,
+          graph.neighbors.cbegin() + graph.offsets[ j + 1 ], static_cast<size_t>( i ) )
+        - graph.neighbors.cbegin();
+    }
+  }
+
+  OPENMVG_LOG_INFO << "Similarity graph: " << numC << " views, "
+    << ( numE - numC ) / 2 << " covisible view pairs";
+} // getSimilarityGraph
+
+void Domset::computeClustersSparseAP( const SimilarityGraph &graph,
+                                      std::vector<size_t> &labels ) const
+{
+  const size_t numC = graph.offsets.size() - 1;
+  const size_t numE = graph.neighbors.size();
+  const std::vector<size_t> &offsets = graph.offsets;
+  const std::vector<float> &S        = graph.similarities;
+
+  // messages are only exchanged along the graph edges
+  std::vector<float> R( numE, 0.f );
+  std::vector<float> A( numE, 0.f );
+  std::vector<unsigned char> exemplars( numC, 0 );
+
+  const float minFloat = std::numeric_limits<float>::lowest();
+  unsigned int stableIter = 0;
+  for ( size_t m = 0; m < kNumIter && stableIter < kConvergenceIter; m++ )
+  {
+    // compute responsibilities
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+    for_parallel( i, numC )
+    {
+      const size_t begin = offsets[ i ], end = offsets[ i + 1 ];
+      if ( end - begin == 1 ) // isolated view
+        continue;
+      float Y = minFloat, Y2 = minFloat;
+      size_t I = begin;
+      for ( size_t e = begin; e < end; ++e )
+      {
+        const float as = A[ e ] + S[ e ];
+        if ( as > Y )
+        {
+          Y2 = Y;
+          Y  = as;
+          I  = e;
+        }
+        else if ( as > Y2 )
+        {
+          Y2 = as;
+        }
+      }
+      for ( size_t e = begin; e < end; ++e )
+      {
+        const float r = S[ e ] - ( ( e == I ) ? Y2 : Y );
+        R[ e ] = ( ( 1 - lambda ) * r ) + ( lambda * R[ e ] );
+      }
+    }
+
+    // compute availabilities (the graph is symmetric: the column k is read
+    // through the reverse edges of the row k)
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+    for_parallel( k, numC )
+    {
+      const size_t begin = offsets[ k ], end = offsets[ k + 1 ];
+      float sumRp = R[ begin ];
+      for ( size_t e = begin + 1; e < end; ++e )
+        sumRp += std::max( 0.f, R[ graph.reverse[ e ] ] );
+
+      A[ begin ] = ( ( 1 - lambda ) * ( sumRp - R[ begin ] ) ) + ( lambda * A[ begin ] );
+      for ( size_t e = begin + 1; e < end; ++e )
+      {
+        const size_t ik = graph.reverse[ e ];
+        const float a   = std::min( 0.f, sumRp - std::max( 0.f, R[ ik ] ) );
+        A[ ik ] = ( ( 1 - lambda ) * a ) + ( lambda * A[ ik ] );
+      }
+    }
+
+    // stop once the exemplars are stable
+    size_t numChanges = 0, numExemplars = 0;
+    for ( size_t i = 0; i < numC; i++ )
+    {
+      const unsigned char isExemplar = ( A[ offsets[ i ] ] + R[ offsets[ i ] ] ) > 0;
+      numChanges   += ( isExemplar != exemplars[ i ] );
+      numExemplars += isExemplar;
+      exemplars[ i ] = isExemplar;
+    }
+    stableIter = ( numChanges == 0 && numExemplars > 0 ) ? stableIter + 1 : 0;
+  }
+
+  // assign each view to its most similar exemplar
+  // (a view without covisible exemplar is kept alone)
+  labels.resize( numC );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
+  for_parallel( i, numC )
+  {
+    labels[ i ] = i;
+    if ( exemplars[ i ] )
+      continue;
+    float maxSim = minFloat;
+    for ( size_t e = offsets[ i ] + 1; e < offsets[ i + 1 ]; ++e )
+    {
+      const size_t j = graph.neighbors[ e ];
+      if ( exemplars[ j ] && S[ e ] > maxSim )
+      {
+        maxSim      = S[ e ];
+        labels[ i ] = j;
+      }
+    }
+  }
+} // computeClustersSparseAP
+
+void Domset::enforceClusterSizes( const SimilarityGraph &graph,
+                                  std::vector<size_t> &labels ) const
+{
+  const size_t numC = labels.size();
+  std::map<size_t, std::vector<size_t>> clMap;
+  const auto gatherClusters = [&]() {
+    clMap.clear();
+    for ( size_t i = 0; i < numC; i++ )
+      clMap[ labels[ i ] ].push_back( i );
+  };
+
+  // enforcing max size constraints:
+  // the cluster is split in parts grown along the strongest similarities
+  gatherClusters();
+  std::vector<unsigned char> state( numC, 0 ); // 1: to split, 2: assigned
+  for ( const auto &cl : clMap )
+  {
+    if ( cl.second.size() <= kMaxClusterSize )
+      continue;
+    for ( const size_t v : cl.second )
+      state[ v ] = 1;
+    for ( const size_t seed : cl.second )
+    {
+      if ( state[ seed ] != 1 )
+        continue;
+      std::priority_queue<std::pair<float, size_t>> queue;
+      queue.emplace( 0.f, seed );
+      size_t partSize = 0;
+      while ( !queue.empty() && partSize < kMaxClusterSize )
+      {
+        const size_t v = queue.top().second;
+        queue.pop();
+        if ( state[ v ] != 1 )
+          continue;
+        state[ v ]  = 2;
+        labels[ v ] = seed;
+        ++partSize;
+        for ( size_t e = graph.offsets[ v ] + 1; e < graph.offsets[ v + 1 ]; ++e )
+        {
+          if ( state[ graph.neighbors[ e ] ] == 1 )
+            queue.emplace( graph.similarities[ e ], graph.neighbors[ e ] );
+        }
+      }
+    }
+    for ( const size_t v : cl.second )
+      state[ v ] = 0;
+  }
+
+  // enforcing min size constraints:
+  // a small cluster is merged to the cluster it is the most similar to
+  // (or to the closest one if it does not share points with any cluster)
+  bool change = false;
+  do
+  {
+    change = false;
+    gatherClusters();
+
+    std::map<size_t, size_t> sizes;
+    std::map<size_t, Eigen::Vector3f> centers;
+    std::vector<std::pair<size_t, size_t>> smallClusters;
+    for ( const auto &cl : clMap )
+    {
+      sizes[ cl.first ] = cl.second.size();
+      Eigen::Vector3f center = Eigen::Vector3f::Zero();
+      for ( const size_t v : cl.second )
+        center += views[ v ].trans;
+      centers[ cl.first ] = center / cl.second.size();
+      if ( cl.second.size() < kMinClusterSize )
+        smallClusters.emplace_back( cl.second.size(), cl.first );
+    }
+    std::sort( smallClusters.begin(), smallClusters.end() );
+
+    std::set<size_t> modified; // clusters updated during this pass
+    for ( const auto &small : smallClusters )
+    {
+      const size_t c = small.second;
+      if ( modified.count( c ) )
+        continue;
+
+      std::map<size_t, float> strengths;
+      for ( const size_t v : clMap[ c ] )
+      {
+        for ( size_t e = graph.offsets[ v ] + 1; e < graph.offsets[ v + 1 ]; ++e )
+        {
+          const size_t l = labels[ graph.neighbors[ e ] ];
+          if ( l != c )
+            strengths[ l ] += graph.similarities[ e ];
+        }
+      }
+      size_t target = c;
+      float maxStrength = 0.f;
+      for ( const auto &strength : strengths )
+      {
+        if ( !modified.count( strength.first ) && strength.second > maxStrength
+             && sizes[ strength.first ] + sizes[ c ] <= kMaxClusterSize )
+        {
+          maxStrength = strength.second;
+          target      = strength.first;
+        }
+      }
+      if ( target == c )
+      {
+        float minDist = std::numeric_limits<float>::max();
+        for ( const auto &center : centers )
+        {
+          if ( center.first == c || modified.count( center.first )
+               || sizes[ center.first ] + sizes[ c ] > kMaxClusterSize )
+            continue;
+          const float dist = ( center.second - centers[ c ] ).norm();
+          if ( dist < minDist )
+          {
+            minDist = dist;
+            target  = center.first;
+          }
+        }
+      }
+      if ( target != c )
+      {
+        for ( const size_t v : clMap[ c ] )
+          labels[ v ] = target;
+        modified.insert( c );
+        modified.insert( target );
+        change = true;
+      }
+    }
+  } while ( change );
+} // enforceClusterSizes
+
+void Domset::addClusterOverlap( const SimilarityGraph &graph, const float &overlapRatio,
+                                std::vector<std::vector<size_t>> &clusters ) const
+{
+  if ( overlapRatio <= 0.f )
+    return;
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic )
+#endif
+  for_parallel( c, clusters.size() )
+  {
+    std::vector<size_t> &cl = clusters[ c ];
+    std::sort( cl.begin(), cl.end() );
+
+    // similarity of the outside views to the cluster
+    std::map<size_t, float> strengths;
+    for ( const size_t v : cl )
+    {
+      for ( size_t e = graph.offsets[ v ] + 1; e < graph.offsets[ v + 1 ]; ++e )
+      {
+        const size_t j = graph.neighbors[ e ];
+        if ( !std::binary_search( cl.cbegin(), cl.cend(), j ) )
+          strengths[ j ] += graph.similarities[ e ];
+      }
+    }
+    std::vector<std::pair<float, size_t>> candidates;
+    for ( const auto &strength : strengths )
+      candidates.emplace_back( -strength.second, strength.first );
+    std::sort( candidates.begin(), candidates.end() );
+
+    const size_t numOverlap = std::min( candidates.size(),
+        static_cast<size_t>( std::ceil( overlapRatio * cl.size() ) ) );
+    for ( size_t i = 0; i < numOverlap; i++ )
+      cl.push_back( candidates[ i ].second );
+  }
+} // addClusterOverlap
+
 void Domset::clusterViews( std::map<size_t, size_t> &xId2vId, const size_t &minClusterSize,
                            const size_t &maxClusterSize )
 {
@@ -636,6 +993,32 @@ void Domset::clusterViews(
   finalClusters.swap( clusters );
 }
 
+void Domset::clusterViewsSparse( const size_t &minClusterSize, const size_t &maxClusterSize,
+                                 const float &overlapRatio )
+{
+  kMinClusterSize = minClusterSize;
+  kMaxClusterSize = maxClusterSize;
+
+  SimilarityGraph graph;
+  getSimilarityGraph( graph );
+
+  std::vector<size_t> labels;
+  computeClustersSparseAP( graph, labels );
+  enforceClusterSizes( graph, labels );
+
+  std::map<size_t, std::vector<size_t>> clMap;
+  for ( size_t i = 0; i < labels.size(); i++ )
+    clMap[ labels[ i ] ].push_back( i );
+  std::vector<std::vector<size_t>> clusters;
+  clusters.reserve( clMap.size() );
+  for ( auto &cl : clMap )
+    clusters.emplace_back( std::move( cl.second ) );
+  addClusterOverlap( graph, overlapRatio, clusters );
+
+  deNormalizePointCloud();
+  finalClusters.swap( clusters );
+}
+
 void Domset::printClusters()
 {
   std::stringstream ss;
@@ -22,19 +22,42 @@
 namespace nomoko {
   class Domset{
     private:
+      /* brief:
+         Sparse view similarity graph (compressed rows).
+         The neighbors of a view are the views sharing some points with it,
+         the view itself is stored first in its row (AP preference).
+         */
+      struct SimilarityGraph {
+        std::vector<size_t> offsets;      // row start, numViews + 1 values
+        std::vector<size_t> neighbors;    // view index of each edge
+        std::vector<size_t> reverse;      // index of the symmetric edge
+        std::vector<float>  similarities; // similarity of each edge
+      };
+
       // Generic clustering
       void findCommonPoints(const View& v1, const View& v2,
           std::vector<size_t>& commonPts) const;
       // similarity measures
       float computeViewSimilarity(const View&, const View&) const;
       Eigen::MatrixXf getSimilarityMatrix(const std::map<size_t,size_t>&);
+      void getSimilarityGraph(SimilarityGraph& graph) const;
 
       // distance measures
-      void getAllDistances();
+      float getViewDistance(const size_t& vId1, const size_t& vId2) const {
+        return (views[vId1].trans - views[vId2].trans).norm();
+      }
       float getDistanceMedian(const std::map<size_t,size_t> &) const;
       float computeViewDistance(const size_t& vId1, const size_t & vId2,
               const float& medianDist) const;
 
+      // sparse clustering steps
+      void computeClustersSparseAP(const SimilarityGraph& graph,
+          std::vector<size_t>& labels) const;
+      void enforceClusterSizes(const SimilarityGraph& graph,
+          std::vector<size_t>& labels) const;
+      void addClusterOverlap(const SimilarityGraph& graph, const float& overlapRatio,
+          std::vector<std::vector<size_t>>& clusters) const;
+
       void computeInformation();
 
       // subsamples the initial point cloud
@@ -64,6 +87,13 @@ namespace nomoko {
       void clusterViews(const size_t& minClustersize,
           const size_t& maxClusterSize);
 
+      // Sparse AP clustering: only the views sharing points are compared,
+      // the memory and the run time scale with the number of covisible pairs.
+      // overlapRatio extends each cluster by its most similar outside views
+      // (in proportion of the cluster size).
+      void clusterViewsSparse(const size_t& minClustersize,
+          const size_t& maxClusterSize, const float& overlapRatio = 0.f);
+
       // export function
       void exportToPLY(const std::string& plyFile, bool exportPoints = false) const;
 
@@ -83,8 +113,6 @@ namespace nomoko {
       std::vector<Camera> cameras;
       std::vector<View> views;
 
-      Eigen::MatrixXf viewDists;
-
       std::vector<std::vector<size_t >> finalClusters;
 
       const float kAngleSigma = M_PI / 6.f;
@@ -95,6 +123,7 @@ namespace nomoko {
 
       // AP constants
       const unsigned int kNumIter = 100;
+      const unsigned int kConvergenceIter = 10; // stable iterations to stop (sparse AP)
       const float lambda = 0.5f;
 
       // scale normalization
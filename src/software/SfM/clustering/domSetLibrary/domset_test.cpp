@@ -0,0 +1,137 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "domset.h"
+#include "synthetic_scene.h"
+
+#include "CppUnitLite/TestHarness.h"
+#include "testing/testing.h"
+
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace nomoko;
+
+// Cluster a numViewsX x numViewsY grid scene with the sparse clustering
+std::vector<std::vector<size_t>> ClusterGridScene
+(
+  const size_t numViewsX,
+  const size_t numViewsY,
+  const size_t minClusterSize,
+  const size_t maxClusterSize,
+  const float overlapRatio
+)
+{
+  std::vector<Point> points;
+  std::vector<View> views;
+  std::vector<Camera> cameras;
+  makeGridScene(numViewsX, numViewsY, points, views, cameras);
+
+  Domset domset(points, views, cameras, 0.1f);
+  domset.clusterViewsSparse(minClusterSize, maxClusterSize, overlapRatio);
+  return domset.getClusters();
+}
+
+TEST(Domset, Sparse_ClusterSizesAndCoverage)
+{
+  const size_t numViewsX = 12, numViewsY = 10;
+  // The affinity propagation gives clusters of 2 to 8 views on this scene:
+  // the first bounds merge the small clusters, the second ones split the big ones
+  const std::vector<std::pair<size_t, size_t>> size_bounds = {{6, 15}, {2, 4}};
+  for (const auto & bounds : size_bounds)
+  {
+    const size_t minClusterSize = bounds.first, maxClusterSize = bounds.second;
+    const std::vector<std::vector<size_t>> clusters =
+      ClusterGridScene(numViewsX, numViewsY, minClusterSize, maxClusterSize, 0.f);
+
+    // Without overlap every view belongs to exactly one cluster
+    std::vector<int> memberships(numViewsX * numViewsY, 0);
+    for (const auto & cluster : clusters)
+    {
+      EXPECT_TRUE(cluster.size() >= minClusterSize);
+      EXPECT_TRUE(cluster.size() <= maxClusterSize);
+      for (const size_t view : cluster)
+      {
+        CHECK(view < memberships.size());
+        ++memberships[view];
+      }
+    }
+    for (const int membership : memberships)
+      EXPECT_EQ(1, membership);
+  }
+}
+
+TEST(Domset, Sparse_ClusterOverlap)
+{
+  const size_t numViewsX = 12, numViewsY = 10;
+  const size_t minClusterSize = 6, maxClusterSize = 15;
+  const float overlapRatio = 0.25f;
+  const std::vector<std::vector<size_t>> clusters =
+    ClusterGridScene(numViewsX, numViewsY, minClusterSize, maxClusterSize, 0.f);
+  const std::vector<std::vector<size_t>> overlapping_clusters =
+    ClusterGridScene(numViewsX, numViewsY, minClusterSize, maxClusterSize, overlapRatio);
+
+  // The overlap extends each cluster by ceil(overlapRatio * size) distinct
+  // outside views, the views of the cluster are kept first
+  CHECK_EQUAL(clusters.size(), overlapping_clusters.size());
+  std::set<size_t> covered;
+  for (size_t c = 0; c < clusters.size(); ++c)
+  {
+    const std::vector<size_t> & cluster = clusters[c];
+    const std::vector<size_t> & overlapping = overlapping_clusters[c];
+    const size_t numOverlap =
+      static_cast<size_t>(std::ceil(overlapRatio * cluster.size()));
+    CHECK_EQUAL(cluster.size() + numOverlap, overlapping.size());
+
+    const std::set<size_t> inside(cluster.cbegin(), cluster.cend());
+    const std::set<size_t> views(overlapping.cbegin(), overlapping.cend());
+    EXPECT_EQ(overlapping.size(), views.size());
+    for (size_t i = 0; i < overlapping.size(); ++i)
+    {
+      EXPECT_EQ(i < cluster.size(), inside.count(overlapping[i]) == 1);
+    }
+    covered.insert(overlapping.cbegin(), overlapping.cend());
+  }
+  EXPECT_EQ(numViewsX * numViewsY, covered.size());
+}
+
+TEST(Domset, Sparse_DisconnectedViews)
+{
+  // Views sharing no point are clustered alone then merged to the closest
+  // clusters: the coverage and the size bounds still hold
+  std::vector<Point> points;
+  std::vector<View> views;
+  std::vector<Camera> cameras;
+  makeGridScene(8, 8, points, views, cameras);
+  const size_t numGridViews = views.size();
+  for (int i = 0; i < 3; ++i)
+  {
+    View v = views[i];
+    v.trans += Eigen::Vector3f(0.f, -5.f - i, 0.f);
+    views.push_back(v);
+  }
+
+  const size_t minClusterSize = 5, maxClusterSize = 12;
+  Domset domset(points, views, cameras, 0.1f);
+  domset.clusterViewsSparse(minClusterSize, maxClusterSize);
+
+  std::vector<int> memberships(numGridViews + 3, 0);
+  for (const auto & cluster : domset.getClusters())
+  {
+    EXPECT_TRUE(cluster.size() >= minClusterSize);
+    EXPECT_TRUE(cluster.size() <= maxClusterSize);
+    for (const size_t view : cluster)
+      ++memberships[view];
+  }
+  for (const int membership : memberships)
+    EXPECT_EQ(1, membership);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -0,0 +1,68 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _NOMOKO_SYNTHETIC_SCENE_H_
+#define _NOMOKO_SYNTHETIC_SCENE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include "types.h"
+
+namespace nomoko {
+  /* brief:
+     Synthetic aerial like scene:
+     numViewsX x numViewsY nadir views on a regular grid (unit spacing, 2 units
+     above the ground) and ground points on a grid twice denser.
+     Each ground point is seen by the views closer than 1.5 units (horizontally),
+     so the covisibility graph is a local grid graph.
+     */
+  inline void makeGridScene(const size_t numViewsX, const size_t numViewsY,
+      std::vector<Point>& points, std::vector<View>& views,
+      std::vector<Camera>& cameras) {
+    const float kViewHeight = 2.f;
+    const float kPointStep = 0.5f;
+    const float kVisibilityRadius = 1.5f;
+
+    cameras.assign(1, Camera{Eigen::Matrix3f::Identity(), 1, 1});
+
+    views.clear();
+    views.reserve(numViewsX * numViewsY);
+    for (size_t y = 0; y < numViewsY; ++y) {
+      for (size_t x = 0; x < numViewsX; ++x) {
+        View v;
+        v.rot = Eigen::Matrix3f::Identity();
+        v.trans = Eigen::Vector3f(x, y, kViewHeight);
+        v.cameraId = 0;
+        views.push_back(v);
+      }
+    }
+
+    points.clear();
+    const int radius = static_cast<int>(std::ceil(kVisibilityRadius));
+    for (float py = 0.f; py <= numViewsY - 1; py += kPointStep) {
+      for (float px = 0.f; px <= numViewsX - 1; px += kPointStep) {
+        Point p;
+        p.pos = Eigen::Vector3f(px, py, 0.f);
+        const int cx = static_cast<int>(std::round(px));
+        const int cy = static_cast<int>(std::round(py));
+        for (int y = std::max(0, cy - radius);
+             y <= std::min<int>(numViewsY - 1, cy + radius); ++y) {
+          for (int x = std::max(0, cx - radius);
+               x <= std::min<int>(numViewsX - 1, cx + radius); ++x) {
+            if (Eigen::Vector2f(x - px, y - py).norm() <= kVisibilityRadius)
+              p.viewList.push_back(y * numViewsX + x);
+          }
+        }
+        points.push_back(p);
+      }
+    }
+  }
+} // namespace nomoko
+#endif // _NOMOKO_SYNTHETIC_SCENE_H_
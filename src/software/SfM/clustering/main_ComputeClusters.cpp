@@ -161,12 +161,16 @@ int main( int argc, char **argv )
   unsigned int clusterSizeLowerBound = 20;
   unsigned int clusterSizeUpperBound = 30;
   float voxelGridSize                = 10.0f;
+  std::string sClusteringMethod      = "SPARSE";
+  float overlapRatio                 = 0.0f;
 
   cmd.add( make_option( 'i', sSfM_Data_Filename, "input_file" ) );
   cmd.add( make_option( 'o', sOutDir, "outdir" ) );
   cmd.add( make_option( 'l', clusterSizeLowerBound, "cluster_size_lower_bound" ) );
   cmd.add( make_option( 'u', clusterSizeUpperBound, "cluster_size_upper_bound" ) );
   cmd.add( make_option( 'v', voxelGridSize, "voxel_grid_size" ) );
+  cmd.add( make_option( 'c', sClusteringMethod, "clustering_method" ) );
+  cmd.add( make_option( 'r', overlapRatio, "overlap_ratio" ) );
 
   try
   {
@@ -181,7 +185,12 @@ int main( int argc, char **argv )
       << "[-o|--outdir path] path to output directory\n"
       << "[-l|--cluster_size_lower_bound] lower bound to cluster size\n"
       << "[-u|--cluster_size_upper_bound] upper bound to cluster size\n"
-      << "[-v|--voxel_grid_size] voxel grid size";
+      << "[-v|--voxel_grid_size] voxel grid size\n"
+      << "[-c|--clustering_method]\n"
+      << "  SPARSE: (default) affinity propagation on the covisible view pairs only\n"
+      << "  DENSE: affinity propagation on the similarity of all view pairs\n"
+      << "[-r|--overlap_ratio] (SPARSE only) extend each cluster by its most similar\n"
+      << "  outside views, in proportion of its size (default: 0, no overlap)";
 
     OPENMVG_LOG_ERROR << s;
     return EXIT_FAILURE;
@@ -194,7 +203,9 @@ int main( int argc, char **argv )
     << "\n[Cluster size:"
     << "\n    Lower bound   = "   << clusterSizeLowerBound
     << "\n    Upper bound]   = "  << clusterSizeUpperBound
-    << "\n[Voxel grid size]  = "  << voxelGridSize;
+    << "\n[Voxel grid size]  = "  << voxelGridSize
+    << "\n[Clustering method] = " << sClusteringMethod
+    << "\n[Overlap ratio]    = "  << overlapRatio;
 
   if ( sSfM_Data_Filename.empty() )
   {
@@ -202,6 +213,12 @@ int main( int argc, char **argv )
     return EXIT_FAILURE;
   }
 
+  if ( sClusteringMethod != "SPARSE" && sClusteringMethod != "DENSE" )
+  {
+    OPENMVG_LOG_ERROR << "Unknown clustering method: " << sClusteringMethod;
+    return EXIT_FAILURE;
+  }
+
   // Prepare output folder
   if ( !stlplus::folder_exists( sOutDir ) )
     if ( !stlplus::folder_create( sOutDir ))
@@ -235,7 +252,10 @@ int main( int argc, char **argv )
   openMVG::system::Timer clusteringTimer;
 
   nomoko::Domset domset( points, views, cameras, voxelGridSize );
-  domset.clusterViews( clusterSizeLowerBound, clusterSizeUpperBound );
+  if ( sClusteringMethod == "DENSE" )
+    domset.clusterViews( clusterSizeLowerBound, clusterSizeUpperBound );
+  else
+    domset.clusterViewsSparse( clusterSizeLowerBound, clusterSizeUpperBound, overlapRatio );
 
   OPENMVG_LOG_INFO << "Clustering view took (s): " << clusteringTimer.elapsed();
 
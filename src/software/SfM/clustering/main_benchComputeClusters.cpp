@@ -0,0 +1,84 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Benchmark the sparse view clustering on a synthetic grid of nadir views
+// (see nomoko::makeGridScene): the default grid has 100k views.
+
+#include "domSetLibrary/domset.h"
+#include "domSetLibrary/synthetic_scene.h"
+#include "domSetLibrary/types.h"
+
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  int numViewsX = 320;
+  int numViewsY = 320;
+  int clusterSizeLowerBound = 20;
+  int clusterSizeUpperBound = 30;
+  float overlapRatio = 0.1f;
+
+  // optional
+  cmd.add(make_option('x', numViewsX, "numViewsX"));
+  cmd.add(make_option('y', numViewsY, "numViewsY"));
+  cmd.add(make_option('l', clusterSizeLowerBound, "cluster_size_lower_bound"));
+  cmd.add(make_option('u', clusterSizeUpperBound, "cluster_size_upper_bound"));
+  cmd.add(make_option('r', overlapRatio, "overlap_ratio"));
+
+  try
+  {
+    cmd.process(argc, argv);
+  }
+  catch (const std::string &s)
+  {
+    OPENMVG_LOG_ERROR << "Usage: " << argv[0] << '\n'
+              << "--- Optional ---\n"
+              << "[-x|--numViewsX] number of views along x (default 320)\n"
+              << "[-y|--numViewsY] number of views along y (default 320)\n"
+              << "[-l|--cluster_size_lower_bound] (default 20)\n"
+              << "[-u|--cluster_size_upper_bound] (default 30)\n"
+              << "[-r|--overlap_ratio] (default 0.1)";
+    OPENMVG_LOG_ERROR << s;
+    return EXIT_FAILURE;
+  }
+
+  if (numViewsX <= 0 || numViewsY <= 0 || clusterSizeLowerBound <= 0
+      || clusterSizeUpperBound < clusterSizeLowerBound)
+  {
+    OPENMVG_LOG_ERROR << "Invalid grid size or cluster size bounds.";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<nomoko::Point> points;
+  std::vector<nomoko::View> views;
+  std::vector<nomoko::Camera> cameras;
+  nomoko::makeGridScene(numViewsX, numViewsY, points, views, cameras);
+  OPENMVG_LOG_INFO
+    << "Synthetic scene: " << views.size() << " views, " << points.size() << " points";
+
+  openMVG::system::Timer timer;
+  nomoko::Domset domset(points, views, cameras, 0.1f);
+  const double setup_time = timer.elapsedMs();
+  domset.clusterViewsSparse(clusterSizeLowerBound, clusterSizeUpperBound, overlapRatio);
+  const double total_time = timer.elapsedMs();
+
+  OPENMVG_LOG_INFO
+    << "Number of clusters: " << domset.getClusters().size()
+    << "\nPoint cloud normalization and voxel filtering (ms): " << setup_time
+    << "\nSparse clustering (ms): " << total_time - setup_time
+    << "\nTotal (ms): " << total_time;
+
+  return EXIT_SUCCESS;
+}
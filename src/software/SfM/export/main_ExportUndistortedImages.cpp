@@ -6,10 +6,11 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include "openMVG/cameras/Camera_undistort_image.hpp"
 #include "openMVG/image/image_io.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_export_images.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/stl/split.hpp"
 #include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
 #include "openMVG/system/timer.hpp"
@@ -19,10 +20,7 @@
 
 #include <cstdlib>
 #include <string>
-
-#ifdef OPENMVG_USE_OPENMP
-#include <omp.h>
-#endif
+#include <vector>
 
 using namespace openMVG;
 using namespace openMVG::cameras;
@@ -30,16 +28,13 @@ using namespace openMVG::geometry;
 using namespace openMVG::image;
 using namespace openMVG::sfm;
 
-#ifdef OPENMVG_USE_OPENMP
-#include <omp.h>
-#endif
-
 int main(int argc, char *argv[]) {
 
   CmdLine cmd;
   std::string sSfM_Data_Filename;
   std::string sOutDir = "";
   bool bExportOnlyReconstructedViews = false;
+  std::string sFormats = "";
 #ifdef OPENMVG_USE_OPENMP
   int iNumThreads = 0;
 #endif
@@ -47,6 +42,8 @@ int main(int argc, char *argv[]) {
   cmd.add( make_option('i', sSfM_Data_Filename, "sfmdata") );
   cmd.add( make_option('o', sOutDir, "outdir") );
   cmd.add( make_option('r', bExportOnlyReconstructedViews, "exportOnlyReconstructed") );
+  cmd.add( make_option('e', sFormats, "formats") );
+  cmd.add( make_switch('f', "force") );
 
 #ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
@@ -62,8 +59,11 @@ int main(int argc, char *argv[]) {
       << "[-i|--sfmdata] filename, the SfM_Data file to convert\n"
       << "[-o|--outdir] path\n"
       << "[-r|--exportOnlyReconstructed] boolean 1/0 (default = 0)\n"
+      << "[-e|--formats] comma separated list of output image formats (i.e. \"jpg,png\"),\n"
+      << "  all the formats are written in one pass (default: the source image format)\n"
+      << "[-f|--force] rewrite all the images (default: skip the up to date images)\n"
 #ifdef OPENMVG_USE_OPENMP
-      << "[-n|--numThreads] number of thread(s)\n"
+      << "[-n|--numThreads] number of images processed in parallel\n"
 #endif
       ;
 
@@ -81,77 +81,56 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  // Output(s): the source image name, or the image basename in each requested format
+  std::vector<View_Export_Path> outputs;
+  if (sFormats.empty())
+  {
+    outputs.push_back([&](const View & view)
+    {
+      return stlplus::create_filespec(sOutDir, stlplus::filename_part(view.s_Img_path));
+    });
+  }
+  else
+  {
+    std::vector<std::string> formats;
+    stl::split(sFormats, ',', formats);
+    for (const std::string & format : formats)
+    {
+      if (image::GetFormat(("image." + format).c_str()) == image::Unknown)
+      {
+        OPENMVG_LOG_ERROR << "Unsupported image format: " << format;
+        return EXIT_FAILURE;
+      }
+      outputs.push_back([&, format](const View & view)
+      {
+        return stlplus::create_filespec(sOutDir, stlplus::basename_part(view.s_Img_path), format);
+      });
+    }
+  }
+
   bool bOk = true;
   {
     system::Timer timer;
     // Export views as undistorted images (those with valid Intrinsics)
-    Image<RGBColor> image, image_ud;
-    Image<uint8_t> image_gray, image_gray_ud;
-    system::LoggerProgress my_progress_bar( sfm_data.GetViews().size(), "- EXTRACT UNDISTORTED IMAGES -" );
-
-    #ifdef OPENMVG_USE_OPENMP
-    const unsigned int nb_max_thread = omp_get_max_threads();
-    #endif
+    const std::vector<Image_Export_Job> jobs =
+      ListViewExportJobs(sfm_data, outputs, bExportOnlyReconstructedViews);
 
+    Image_Export_Options export_options;
 #ifdef OPENMVG_USE_OPENMP
-    omp_set_num_threads(iNumThreads);
-    #pragma omp parallel for schedule(dynamic) if (iNumThreads > 0) private(image, image_ud, image_gray, image_gray_ud)
+    export_options.max_images_in_flight = iNumThreads;
 #endif
-    for (int i = 0; i < static_cast<int>(sfm_data.views.size()); ++i)
-    {
-#ifdef OPENMVG_USE_OPENMP
-      if (iNumThreads == 0) omp_set_num_threads(nb_max_thread);
-#endif
-      Views::const_iterator iterViews = sfm_data.views.begin();
-      std::advance(iterViews, i);
-
-      const View * view = iterViews->second.get();
-      // Check if the view is in reconstruction
-      if (bExportOnlyReconstructedViews && !sfm_data.IsPoseAndIntrinsicDefined(view))
-        continue;
-
-      const bool bIntrinsicDefined = view->id_intrinsic != UndefinedIndexT &&
-        sfm_data.GetIntrinsics().find(view->id_intrinsic) != sfm_data.GetIntrinsics().end();
-      if (!bIntrinsicDefined)
-        continue;
-
-      Intrinsics::const_iterator iterIntrinsic = sfm_data.GetIntrinsics().find(view->id_intrinsic);
-
-      const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
-      const std::string dstImage = stlplus::create_filespec(
-        sOutDir, stlplus::filename_part(srcImage));
-
-      const IntrinsicBase * cam = iterIntrinsic->second.get();
-      if (cam->have_disto())
-      {
-        // undistort the image and save it
-        if (ReadImage( srcImage.c_str(), &image))
-        {
-          UndistortImage(image, cam, image_ud, BLACK);
-          const bool bRes = WriteImage(dstImage.c_str(), image_ud);
-#ifdef OPENMVG_USE_OPENMP
-          #pragma omp critical
-#endif
-          bOk &= bRes;
-        }
-        else // If RGBColor reading fails, we try to read a gray image
-        if (ReadImage( srcImage.c_str(), &image_gray))
-        {
-          UndistortImage(image_gray, cam, image_gray_ud, BLACK);
-          const bool bRes = WriteImage(dstImage.c_str(), image_gray_ud);
-#ifdef OPENMVG_USE_OPENMP
-          #pragma omp critical
-#endif
-          bOk &= bRes;
-        }
-      }
-      else // (no distortion)
-      {
-        // copy the image since there is no distortion
-        stlplus::file_copy(srcImage, dstImage);
-      }
-      ++my_progress_bar;
-    }
+    export_options.skip_up_to_date = !cmd.used('f');
+    // A scene newer than the images can change their undistortion
+    export_options.reference_time = stlplus::file_modified(sSfM_Data_Filename);
+
+    system::LoggerProgress my_progress_bar( jobs.size(), "- EXTRACT UNDISTORTED IMAGES -" );
+    Undistorted_Image_Exporter image_exporter(sfm_data, export_options);
+    Image_Export_Report report;
+    bOk = image_exporter.Export(jobs, &my_progress_bar, &report);
+    OPENMVG_LOG_INFO
+      << "Undistorted images: " << report.nb_undistorted << " written, "
+      << report.nb_copied << " copied, " << report.nb_skipped << " up to date, "
+      << report.nb_failed << " failed";
     OPENMVG_LOG_INFO << "Task done in (s): " << timer.elapsed();
   }
 
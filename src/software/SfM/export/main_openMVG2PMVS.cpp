@@ -9,9 +9,9 @@
 #include "openMVG/cameras/Camera_Pinhole.hpp"
 #include "openMVG/cameras/Camera_undistort_image.hpp"
 #include "openMVG/geometry/pose3.hpp"
-#include "openMVG/image/image_io.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_export_images.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/sfm/sfm_landmark.hpp"
 #include "openMVG/sfm/sfm_view.hpp"
@@ -41,7 +41,8 @@ bool exportToPMVSFormat(
   const std::string & sOutDirectory,  //Output PMVS files directory
   const int downsampling_factor,
   const int CPU_core_count,
-  const bool b_VisData = true
+  const bool b_VisData = true,
+  const Image_Export_Options & export_options = Image_Export_Options()
   )
 {
   bool bOk = true;
@@ -70,7 +71,7 @@ bool exportToPMVSFormat(
 
   if (bOk)
   {
-    system::LoggerProgress my_progress_bar( sfm_data.GetViews().size()*2 );
+    system::LoggerProgress my_progress_bar( sfm_data.GetViews().size() );
 
     // Since PMVS requires contiguous camera index, and that some views can have some missing poses,
     // we reindex the poses to ensure a contiguous pose list.
@@ -103,50 +104,20 @@ bool exportToPMVSFormat(
     }
 
     // Export (calibrated) views as undistorted images
-    Image<RGBColor> image, image_ud;
-    const Views & views = sfm_data.GetViews();
-    #pragma omp parallel for private(image, image_ud)
-    for (int i = 0; i < static_cast<int>(views.size()); ++i)
+    const std::string sVisualizeDir = stlplus::folder_append_separator(sOutDirectory) + "visualize";
+    const View_Export_Path pmvs_image_path = [&](const View & view)
     {
-      ++my_progress_bar;
-      auto view_it = views.begin();
-      std::advance(view_it, i);
-      const View * view = view_it->second.get();
-      if (!sfm_data.IsPoseAndIntrinsicDefined(view))
-        continue;
-
-      Intrinsics::const_iterator iterIntrinsic = sfm_data.GetIntrinsics().find(view->id_intrinsic);
-
-      // We have a valid view with a corresponding camera & pose
-      const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
       std::ostringstream os;
-      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous[view->id_view];
-      const std::string dstImage = stlplus::create_filespec(
-        stlplus::folder_append_separator(sOutDirectory) + "visualize", os.str(),"jpg");
-
-      const IntrinsicBase * cam = iterIntrinsic->second.get();
-      if (cam->have_disto())
-      {
-        // undistort the image and save it
-        ReadImage( srcImage.c_str(), &image);
-        UndistortImage(image, cam, image_ud, BLACK);
-        WriteImage(dstImage.c_str(), image_ud);
-      }
-      else // (no distortion)
-      {
-        // copy the image if extension match
-        if (stlplus::extension_part(srcImage) == "JPG" ||
-          stlplus::extension_part(srcImage) == "jpg")
-        {
-          stlplus::file_copy(srcImage, dstImage);
-        }
-        else
-        {
-          ReadImage( srcImage.c_str(), &image);
-          WriteImage( dstImage.c_str(), image);
-        }
-      }
-    }
+      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous.at(view.id_view);
+      return stlplus::create_filespec(sVisualizeDir, os.str(), "jpg");
+    };
+    Undistorted_Image_Exporter image_exporter(sfm_data, export_options);
+    Image_Export_Report report;
+    bOk = image_exporter.Export(
+      ListViewExportJobs(sfm_data, {pmvs_image_path}, true), &my_progress_bar, &report);
+    OPENMVG_LOG_INFO
+      << "Undistorted images: " << report.nb_undistorted << " written, "
+      << report.nb_copied << " copied, " << report.nb_skipped << " up to date";
 
     //pmvs_options.txt
     std::ostringstream os;
@@ -335,6 +306,7 @@ int main(int argc, char *argv[]) {
   cmd.add( make_option('r', resolution, "resolution") );
   cmd.add( make_option('c', CPU, "CPU") );
   cmd.add( make_option('v', bVisData, "useVisData") );
+  cmd.add( make_switch('f', "force") );
 
   try {
     if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -345,7 +317,8 @@ int main(int argc, char *argv[]) {
       << "[-o|--outdir path]\n"
       << "[-r|--resolution] divide image coefficient\n"
       << "[-c|--nb core]\n"
-      << "[-v|--useVisData] use visibility information.";
+      << "[-v|--useVisData] use visibility information.\n"
+      << "[-f|--force] rewrite all the undistorted images (default: skip the up to date images)";
 
     OPENMVG_LOG_ERROR << s;
     return EXIT_FAILURE;
@@ -362,11 +335,17 @@ int main(int argc, char *argv[]) {
   }
 
   {
+    Image_Export_Options export_options;
+    export_options.skip_up_to_date = !cmd.used('f');
+    // A scene newer than the images can change their undistortion
+    export_options.reference_time = stlplus::file_modified(sSfM_Data_Filename);
+
     exportToPMVSFormat(sfm_data,
       stlplus::folder_append_separator(sOutDir) + "PMVS",
       resolution,
       CPU,
-      bVisData);
+      bVisData,
+      export_options);
 
     exportToBundlerFormat(sfm_data,
       stlplus::folder_append_separator(sOutDir) +
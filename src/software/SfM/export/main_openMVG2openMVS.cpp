@@ -7,9 +7,9 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "openMVG/cameras/Camera_Pinhole.hpp"
-#include "openMVG/cameras/Camera_undistort_image.hpp"
 #include "openMVG/image/image_io.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_export_images.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
@@ -26,19 +26,15 @@ using namespace openMVG::geometry;
 using namespace openMVG::image;
 using namespace openMVG::sfm;
 
-#include <atomic>
 #include <cstdlib>
 #include <string>
-
-#ifdef OPENMVG_USE_OPENMP
-#include <omp.h>
-#endif
+#include <vector>
 
 bool exportToOpenMVS(
   const SfM_Data & sfm_data,
   const std::string & sOutFile,
   const std::string & sOutDir,
-  const int iNumThreads = 0
+  const Image_Export_Options & export_options = Image_Export_Options()
   )
 {
   // Create undistorted images directory structure
@@ -135,137 +131,79 @@ bool exportToOpenMVS(
     }
   }
 
-  // Export undistorted images
-  system::LoggerProgress my_progress_bar_images(sfm_data.views.size(), "- UNDISTORT IMAGES " );
-  std::atomic<bool> bOk(true); // Use a boolean to track the status of the loop process
-#ifdef OPENMVG_USE_OPENMP
-  const unsigned int nb_max_thread = (iNumThreads > 0)? iNumThreads : omp_get_max_threads();
-
-  #pragma omp parallel for schedule(dynamic) num_threads(nb_max_thread)
-#endif
-  for (int i = 0; i < static_cast<int>(sfm_data.views.size()); ++i)
+  // Export undistorted images (and masks) in one pass:
+  // - the views are undistorted, the views without pose are copied,
+  // - the local masks (<image>_mask.png) and the global mask (mask.png)
+  //   are undistorted with the camera of their image.
+  std::vector<Image_Export_Job> jobs;
+  for (const auto& view_it : sfm_data.GetViews())
   {
-    ++my_progress_bar_images;
-
-    if (!bOk)
-      continue;
-
-    Views::const_iterator iterViews = sfm_data.views.begin();
-    std::advance(iterViews, i);
-    const View * view = iterViews->second.get();
-
-    // Get image paths
+    const View * view = view_it.second.get();
     const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
-    const std::string imageName = stlplus::create_filespec(sOutDir, view->s_Img_path);
     const std::string mask_filename_local = stlplus::create_filespec(sfm_data.s_root_path, stlplus::basename_part(srcImage) + "_mask", "png");
-    const std::string maskName = stlplus::create_filespec(sOutDir, stlplus::basename_part(srcImage) + ".mask.png");
+    const IndexT id_intrinsic = sfm_data.IsPoseAndIntrinsicDefined(view) ? view->id_intrinsic : UndefinedIndexT;
 
+    Image_Export_Job job;
+    job.source = srcImage;
+    job.id_intrinsic = id_intrinsic;
+    job.destinations = {stlplus::create_filespec(sOutDir, view->s_Img_path)};
+    jobs.push_back(job);
 
-    if (sfm_data.IsPoseAndIntrinsicDefined(view))
+    if (stlplus::file_exists(mask_filename_local))
     {
-      // export undistorted images
-      const openMVG::cameras::IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
-      if (cam->have_disto())
-      {
-        // undistort image and save it
-        Image<openMVG::image::RGBColor> imageRGB, imageRGB_ud;
-        Image<uint8_t> image_gray, image_gray_ud;
-        try
-        {
-          if (ReadImage(srcImage.c_str(), &imageRGB))
-          {
-            UndistortImage(imageRGB, cam, imageRGB_ud, BLACK);
-            bOk = bOk & WriteImage(imageName.c_str(), imageRGB_ud);
-          }
-          else // If RGBColor reading fails, try to read as gray image
-          if (ReadImage(srcImage.c_str(), &image_gray))
-          {
-            UndistortImage(image_gray, cam, image_gray_ud, BLACK);
-            const bool bRes = WriteImage(imageName.c_str(), image_gray_ud);
-            bOk = bOk & bRes;
-          }
-          else
-          {
-            bOk = bOk & false;
-          }
-
-          Image<unsigned char> imageMask;
-          // Try to read the local mask
-          if (stlplus::file_exists(mask_filename_local))
-          {
-            if (!ReadImage(mask_filename_local.c_str(), &imageMask)||
-                !(imageMask.Width() == cam->w() && imageMask.Height() == cam->h()))
-            {
-              OPENMVG_LOG_ERROR
-                << "Invalid mask: " << mask_filename_local << ';';
-              bOk = bOk & false;
-              continue;
-            }
-            UndistortImage(imageMask, cam, image_gray_ud, BLACK);
-            const bool bRes = WriteImage(maskName.c_str(), image_gray_ud);
-            bOk = bOk & bRes;
-          }
-        }
-        catch (const std::bad_alloc& e)
-        {
-          bOk = bOk & false;
-        }
-      }
-      else
+      ImageHeader mask_header;
+      if (id_intrinsic != UndefinedIndexT)
       {
-        // just copy image
-        stlplus::file_copy(srcImage, imageName);
-        if (stlplus::file_exists(mask_filename_local))
+        const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(id_intrinsic).get();
+        if (!ReadImageHeader(mask_filename_local.c_str(), &mask_header) ||
+            !(mask_header.width == static_cast<int>(cam->w()) && mask_header.height == static_cast<int>(cam->h())))
         {
-          stlplus::file_copy(mask_filename_local, maskName);
+          OPENMVG_LOG_ERROR
+            << "Invalid mask: " << mask_filename_local << ';';
+          return false;
         }
       }
-    }
-    else
-    {
-      // just copy the image
-      stlplus::file_copy(srcImage, imageName);
-      if (stlplus::file_exists(mask_filename_local))
-      {
-          stlplus::file_copy(mask_filename_local, maskName);
-      }
+      job.source = mask_filename_local;
+      job.b_gray = true;
+      job.destinations = {stlplus::create_filespec(sOutDir, stlplus::basename_part(srcImage) + ".mask.png")};
+      jobs.push_back(job);
     }
   }
   if (stlplus::file_exists(mask_filename_global))
   {
-    for (int i = 0; i < static_cast<int>(sfm_data.GetIntrinsics().size()); i++)
+    ImageHeader mask_header;
+    const bool bMaskHeader = ReadImageHeader(mask_filename_global.c_str(), &mask_header);
+    for (const auto& intrinsic_it : sfm_data.GetIntrinsics())
     {
-      const openMVG::cameras::IntrinsicBase* cam = sfm_data.GetIntrinsics().at(i).get();
-      const std::string maskName = stlplus::create_filespec(sOutDir, "global_mask_" + std::to_string(i), ".png");
-      Image<uint8_t> imageMask;
-      Image<uint8_t> image_gray, image_gray_ud;
-      if (cam->have_disto())
+      const IntrinsicBase * cam = intrinsic_it.second.get();
+      if (!bMaskHeader ||
+          !(mask_header.width == static_cast<int>(cam->w()) && mask_header.height == static_cast<int>(cam->h())))
       {
-        // Try to read the global mask
-        if (!ReadImage(mask_filename_global.c_str(), &imageMask)||
-            !(imageMask.Width() == cam->w() && imageMask.Height() == cam->h()))
-        {
-          OPENMVG_LOG_ERROR
-            << "Invalid global mask: " << mask_filename_global << ';';
-          bOk = bOk & false;
-        }
-          UndistortImage(imageMask, cam, image_gray_ud, BLACK);
-          const bool bRes = WriteImage(maskName.c_str(), image_gray_ud);
-          bOk = bOk & bRes;
-      }
-      else
-      {
-        stlplus::file_copy(mask_filename_global, maskName);
+        OPENMVG_LOG_ERROR
+          << "Invalid global mask: " << mask_filename_global << ';';
+        return false;
       }
+      Image_Export_Job job;
+      job.source = mask_filename_global;
+      job.id_intrinsic = intrinsic_it.first;
+      job.b_gray = true;
+      job.destinations = {stlplus::create_filespec(sOutDir, "global_mask_" + std::to_string(intrinsic_it.first), ".png")};
+      jobs.push_back(job);
     }
   }
 
-  if (!bOk)
+  system::LoggerProgress my_progress_bar_images(jobs.size(), "- UNDISTORT IMAGES " );
+  Undistorted_Image_Exporter image_exporter(sfm_data, export_options);
+  Image_Export_Report report;
+  if (!image_exporter.Export(jobs, &my_progress_bar_images, &report))
   {
-    OPENMVG_LOG_ERROR << "Catched a memory error in the image conversion."
-     << " Please consider to use less threads ([-n|--numThreads])." << std::endl;
+    OPENMVG_LOG_ERROR << "Cannot export the undistorted images."
+     << " In case of memory error, please consider to use less threads ([-n|--numThreads]).";
     return false;
   }
+  OPENMVG_LOG_INFO
+    << "Undistorted images: " << report.nb_undistorted << " written, "
+    << report.nb_copied << " copied, " << report.nb_skipped << " up to date";
 
   // define structure
   scene.vertices.reserve(sfm_data.GetLandmarks().size());
@@ -325,6 +263,7 @@ int main(int argc, char *argv[])
   cmd.add( make_option('i', sSfM_Data_Filename, "sfmdata") );
   cmd.add( make_option('o', sOutFile, "outfile") );
   cmd.add( make_option('d', sOutDir, "outdir") );
+  cmd.add( make_switch('f', "force") );
 #ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
 #endif
@@ -337,6 +276,7 @@ int main(int argc, char *argv[])
       << "[-i|--sfmdata] filename, the SfM_Data file to convert\n"
       << "[-o|--outfile] OpenMVS scene file\n"
       << "[-d|--outdir] undistorted images path\n"
+      << "[-f|--force] rewrite all the undistorted images (default: skip the up to date images)\n"
 #ifdef OPENMVG_USE_OPENMP
       << "[-n|--numThreads] number of thread(s)\n"
 #endif
@@ -360,8 +300,14 @@ int main(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
+  Image_Export_Options export_options;
+  export_options.max_images_in_flight = iNumThreads;
+  export_options.skip_up_to_date = !cmd.used('f');
+  // A scene newer than the images can change their undistortion
+  export_options.reference_time = stlplus::file_modified(sSfM_Data_Filename);
+
   // Export OpenMVS data structure
-  if (!exportToOpenMVS(sfm_data, sOutFile, sOutDir, iNumThreads))
+  if (!exportToOpenMVS(sfm_data, sOutFile, sOutDir, export_options))
   {
     OPENMVG_LOG_ERROR << "The output openMVS scene file cannot be written";
     return EXIT_FAILURE;
@@ -10,6 +10,7 @@
 #include <cereal/archives/json.hpp>
 
 #include "openMVG/features/akaze/image_describer_akaze_io.hpp"
+#include "openMVG/features/image_describer_tiled.hpp"
 
 #include "openMVG/features/sift/SIFT_Anatomy_Image_Describer_io.hpp"
 #include "openMVG/image/image_io.hpp"
@@ -18,6 +19,7 @@
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
+#include "openMVG/system/profiler.hpp"
 #include "openMVG/system/timer.hpp"
 
 #include "third_party/cmdLine/cmdLine.h"
@@ -69,6 +71,9 @@ int main(int argc, char **argv)
   std::string sImage_Describer_Method = "SIFT";
   bool bForce = false;
   std::string sFeaturePreset = "";
+  int iTileSize = 0;
+  int iTileMargin = Tiling_Options().margin;
+  int iFeatureBudget = 0;
 #ifdef OPENMVG_USE_OPENMP
   int iNumThreads = 0;
 #endif
@@ -81,6 +86,9 @@ int main(int argc, char **argv)
   cmd.add( make_option('u', bUpRight, "upright") );
   cmd.add( make_option('f', bForce, "force") );
   cmd.add( make_option('p', sFeaturePreset, "describerPreset") );
+  cmd.add( make_option('t', iTileSize, "tileSize") );
+  cmd.add( make_option('b', iTileMargin, "tileMargin") );
+  cmd.add( make_option('c', iFeatureBudget, "featureBudget") );
 
 #ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
@@ -108,6 +116,12 @@ int main(int argc, char **argv)
         << "   NORMAL (default),\n"
         << "   HIGH,\n"
         << "   ULTRA: !!Can take long time!!\n"
+        << "[-t|--tileSize] Describe the images larger than this size tile by tile\n"
+        << "  (bounds the memory used for very large images, 0 (default) disables tiling)\n"
+        << "[-b|--tileMargin] Border added around each tile\n"
+        << "  (-1 (default): the support radius of the coarsest regions of the describer)\n"
+        << "[-c|--featureBudget] Maximal number of regions per image\n"
+        << "  (the regions are selected spread uniformly over the image, 0 (default) keeps all the regions)\n"
 #ifdef OPENMVG_USE_OPENMP
         << "[-n|--numThreads] number of parallel computations\n"
 #endif
@@ -126,12 +140,21 @@ int main(int argc, char **argv)
     << "--upright " << bUpRight << "\n"
     << "--describerPreset " << (sFeaturePreset.empty() ? "NORMAL" : sFeaturePreset) << "\n"
     << "--force " << bForce << "\n"
+    << "--tileSize " << iTileSize << "\n"
+    << "--tileMargin " << iTileMargin << "\n"
+    << "--featureBudget " << iFeatureBudget << "\n"
 #ifdef OPENMVG_USE_OPENMP
     << "--numThreads " << iNumThreads << "\n"
 #endif
     ;
 
 
+  if (iFeatureBudget < 0)
+  {
+    OPENMVG_LOG_ERROR << "\nThe feature budget must be positive (0 disables it)";
+    return EXIT_FAILURE;
+  }
+
   if (sOutDir.empty())
   {
     OPENMVG_LOG_ERROR << "\nIt is an invalid output directory";
@@ -242,6 +265,9 @@ int main(int argc, char **argv)
     }
   }
 
+  // The budget is a per run setting (it is not saved with the image_describer)
+  image_describer->Set_feature_budget(iFeatureBudget);
+
   // Feature extraction routines
   // For each View of the SfM_Data container:
   // - if regions file exists continue,
@@ -278,8 +304,12 @@ int main(int argc, char **argv)
       // If features or descriptors file are missing, compute them
       if (!preemptive_exit && (bForce || !stlplus::file_exists(sFeat) || !stlplus::file_exists(sDesc)))
       {
-        if (!ReadImage(sView_filename.c_str(), &imageGray))
-          continue;
+        OPENMVG_PROFILE_ZONE("ComputeFeatures");
+        {
+          OPENMVG_PROFILE_ZONE("ReadImage");
+          if (!ReadImage(sView_filename.c_str(), &imageGray))
+            continue;
+        }
 
         //
         // Look if there is an occlusion feature mask
@@ -329,7 +359,20 @@ int main(int argc, char **argv)
         }
 
         // Compute features and descriptors and export them to files
-        auto regions = image_describer->Describe(imageGray, mask);
+        std::unique_ptr<features::Regions> regions;
+        {
+          OPENMVG_PROFILE_ZONE("Describe");
+          if (iTileSize > 0)
+          {
+            Tiling_Options tiling_options;
+            tiling_options.tile_size = iTileSize;
+            tiling_options.margin = iTileMargin;
+            regions = DescribeTiled(*image_describer, imageGray, mask, tiling_options);
+          }
+          else
+            regions = image_describer->Describe(imageGray, mask);
+        }
+        OPENMVG_PROFILE_ZONE("SaveRegions");
         if (regions && !image_describer->Save(regions.get(), sFeat, sDesc)) {
           OPENMVG_LOG_ERROR
             << "Cannot save regions for image: " << sView_filename << ';'
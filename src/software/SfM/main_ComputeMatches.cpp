@@ -14,6 +14,7 @@
 #include "openMVG/matching_image_collection/Cascade_Hashing_Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/Pair_Builder.hpp"
+#include "openMVG/matching_image_collection/Product_Quantization_Matcher_Regions.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_preemptive_regions_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
@@ -49,6 +50,7 @@ int main( int argc, char** argv )
   std::string  sPredefinedPairList    = "";
   std::string  sNearestMatchingMethod = "AUTO";
   bool         bForce                 = false;
+  bool         bSymmetric             = false;
   unsigned int ui_max_cache_size      = 0;
 
   // Pre-emptive matching parameters
@@ -63,6 +65,7 @@ int main( int argc, char** argv )
   cmd.add( make_option( 'r', fDistRatio, "ratio" ) );
   cmd.add( make_option( 'n', sNearestMatchingMethod, "nearest_matching_method" ) );
   cmd.add( make_option( 'f', bForce, "force" ) );
+  cmd.add( make_option( 's', bSymmetric, "symmetric" ) );
   cmd.add( make_option( 'c', ui_max_cache_size, "cache_size" ) );
   // Pre-emptive matching
   cmd.add( make_option( 'P', ui_preemptive_feature_count, "preemptive_feature_count") );
@@ -97,9 +100,18 @@ int main( int argc, char** argv )
       << "    FASTCASCADEHASHINGL2: (default)\n"
       << "      L2 Cascade Hashing with precomputed hashed regions\n"
       << "     (faster than CASCADEHASHINGL2 but use more memory).\n"
+      << "    PQL2: L2 Approximate Matching on product quantized regions\n"
+      << "      (compact codes, the best candidates are re-ranked with the exact distance;\n"
+      << "       the codebook is saved in the matches directory as pq_codebook.bin;\n"
+      << "       the raw regions are read on demand through a regions cache,\n"
+      << "       of " << Product_Quantization_Matcher_Regions::kRegionsCacheSize << " regions if --cache_size is not set).\n"
       << "  For Binary based descriptor:\n"
       << "    BRUTEFORCEHAMMING: BruteForce Hamming matching,\n"
       << "    HNSWHAMMING: Hamming Approximate Matching with Hierarchical Navigable Small World graphs\n"
+      << "    MIHHAMMING: Hamming exact Matching with Multi-Index Hashing\n"
+      << "[-s|--symmetric] Keep only the mutual nearest neighbours\n"
+      << "  (found in the same pass by the BRUTEFORCE and CASCADEHASHING matchers,\n"
+      << "   the other matchers search the pairs in both directions, not used by PQL2)\n"
       << "[-c|--cache_size]\n"
       << "  Use a regions cache (only cache_size regions will be stored in memory)\n"
       << "  If not used, all regions will be load in memory."
@@ -120,6 +132,7 @@ int main( int argc, char** argv )
             << "\n"
             << "--force " << bForce << "\n"
             << "--ratio " << fDistRatio << "\n"
+            << "--symmetric " << bSymmetric << "\n"
             << "--nearest_matching_method " << sNearestMatchingMethod << "\n"
             << "--cache_size " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size)) << "\n"
             << "--preemptive_feature_used/count " << cmd.used('P') << " / " << ui_preemptive_feature_count;
@@ -169,6 +182,11 @@ int main( int argc, char** argv )
   //    - Keep correspondences only if NearestNeighbor ratio is ok
   //---------------------------------------
 
+  // The product quantization matcher keeps the compact codes in memory
+  // and reads the raw regions on demand: use a regions cache by default.
+  if (sNearestMatchingMethod == "PQL2" && ui_max_cache_size == 0)
+    ui_max_cache_size = Product_Quantization_Matcher_Regions::kRegionsCacheSize;
+
   // Load the corresponding view regions
   std::shared_ptr<Regions_Provider> regions_provider;
   if (ui_max_cache_size == 0)
@@ -235,61 +253,78 @@ int main( int argc, char** argv )
       if ( regions_type->IsScalar() )
       {
         OPENMVG_LOG_INFO << "Using FAST_CASCADE_HASHING_L2 matcher";
-        collectionMatcher.reset(new Cascade_Hashing_Matcher_Regions(fDistRatio));
+        collectionMatcher.reset(new Cascade_Hashing_Matcher_Regions(fDistRatio, bSymmetric));
       }
       else
       if (regions_type->IsBinary())
       {
         OPENMVG_LOG_INFO << "Using HNSWHAMMING matcher";
-        collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_HAMMING));
+        collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_HAMMING, bSymmetric));
       }
     }
     else
     if (sNearestMatchingMethod == "BRUTEFORCEL2")
     {
       OPENMVG_LOG_INFO << "Using BRUTE_FORCE_L2 matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, BRUTE_FORCE_L2));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, BRUTE_FORCE_L2, bSymmetric));
     }
     else
     if (sNearestMatchingMethod == "BRUTEFORCEHAMMING")
     {
       OPENMVG_LOG_INFO << "Using BRUTE_FORCE_HAMMING matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, BRUTE_FORCE_HAMMING));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, BRUTE_FORCE_HAMMING, bSymmetric));
     }
     else
     if (sNearestMatchingMethod == "HNSWL2")
     {
       OPENMVG_LOG_INFO << "Using HNSWL2 matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_L2));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_L2, bSymmetric));
     }
     if (sNearestMatchingMethod == "HNSWL1")
     {
       OPENMVG_LOG_INFO << "Using HNSWL1 matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_L1));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_L1, bSymmetric));
     }
     else
     if (sNearestMatchingMethod == "HNSWHAMMING")
     {
       OPENMVG_LOG_INFO << "Using HNSWHAMMING matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_HAMMING));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_HAMMING, bSymmetric));
+    }
+    else
+    if (sNearestMatchingMethod == "MIHHAMMING")
+    {
+      OPENMVG_LOG_INFO << "Using MULTI_INDEX_HASHING_HAMMING matcher";
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, MULTI_INDEX_HASHING_HAMMING, bSymmetric));
     }
     else
     if (sNearestMatchingMethod == "ANNL2")
     {
       OPENMVG_LOG_INFO << "Using ANN_L2 matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, ANN_L2));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, ANN_L2, bSymmetric));
     }
     else
     if (sNearestMatchingMethod == "CASCADEHASHINGL2")
     {
       OPENMVG_LOG_INFO << "Using CASCADE_HASHING_L2 matcher";
-      collectionMatcher.reset(new Matcher_Regions(fDistRatio, CASCADE_HASHING_L2));
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, CASCADE_HASHING_L2, bSymmetric));
     }
     else
     if (sNearestMatchingMethod == "FASTCASCADEHASHINGL2")
     {
       OPENMVG_LOG_INFO << "Using FAST_CASCADE_HASHING_L2 matcher";
-      collectionMatcher.reset(new Cascade_Hashing_Matcher_Regions(fDistRatio));
+      collectionMatcher.reset(new Cascade_Hashing_Matcher_Regions(fDistRatio, bSymmetric));
+    }
+    else
+    if (sNearestMatchingMethod == "PQL2")
+    {
+      OPENMVG_LOG_INFO << "Using PRODUCT_QUANTIZATION_L2 matcher";
+      const std::string sCodebookFilename =
+        stlplus::create_filespec(sMatchesDirectory, "pq_codebook", "bin");
+      if (bForce && stlplus::file_exists(sCodebookFilename))
+        stlplus::file_delete(sCodebookFilename);
+      collectionMatcher.reset(new Product_Quantization_Matcher_Regions(
+        fDistRatio, ProductQuantizer::Options(), 16, sCodebookFilename));
     }
     if (!collectionMatcher)
     {
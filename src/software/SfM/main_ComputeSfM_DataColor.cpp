@@ -40,9 +40,13 @@ int main(int argc, char **argv)
   std::string
     sSfM_Data_Filename_In,
     sOutputPLY_Out;
+  Colorization_Options colorization_options;
 
   cmd.add(make_option('i', sSfM_Data_Filename_In, "input_file"));
   cmd.add(make_option('o', sOutputPLY_Out, "output_file"));
+  cmd.add(make_option('a', colorization_options.max_observations_per_track, "average_observations"));
+  cmd.add(make_option('n', colorization_options.max_images_in_flight, "max_images_in_flight"));
+  cmd.add(make_option('s', colorization_options.max_image_dimension, "max_image_size"));
 
   try {
       if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -50,7 +54,13 @@ int main(int argc, char **argv)
   } catch (const std::string& s) {
       OPENMVG_LOG_INFO << "Usage: " << argv[0] << '\n'
         << "[-i|--input_file] path to the input SfM_Data scene\n"
-        << "[-o|--output_file] path to the output PLY file";
+        << "[-o|--output_file] path to the output PLY file\n"
+        << "\n[Optional]\n"
+        << "[-a|--average_observations] number of observations averaged per track (default 1)\n"
+        << "[-n|--max_images_in_flight] maximal number of images decoded at the same time\n"
+        << "  (default 0: one per available thread)\n"
+        << "[-s|--max_image_size] largest dimension of the decoded images\n"
+        << "  (default 0: full resolution, else the images are decoded at 1/2, 1/4 or 1/8)";
 
       OPENMVG_LOG_ERROR << s;
       return EXIT_FAILURE;
@@ -72,7 +82,7 @@ int main(int argc, char **argv)
 
   // Compute the scene structure color
   std::vector<Vec3> vec_3dPoints, vec_tracksColor, vec_camPosition;
-  if (ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor))
+  if (ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor, colorization_options))
   {
     GetCameraPositions(sfm_data, vec_camPosition);
 
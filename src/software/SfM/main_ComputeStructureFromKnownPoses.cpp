@@ -40,14 +40,24 @@ using namespace openMVG;
 using namespace openMVG::matching;
 using namespace openMVG::sfm;
 
-/// Build a list of pair from the camera frusta intersections
-Pair_Set BuildPairsFromFrustumsIntersections(
-  const SfM_Data & sfm_data,
-  const double z_near = -1., // default near plane
-  const double z_far = -1.)  // default far plane
+/// Return the near & far depth planes of the views, computed from the
+/// existing structure and enlarged by a relative margin.
+/// Views that do not observe any landmark get no depth range: they keep an
+/// infinite frustum and search the whole epipolar line.
+Frustum_Filter::NearFarPlanesT ComputeDepthRanges(
+  const Frustum_Filter & frustum_filter,
+  const double margin)
 {
-  const Frustum_Filter frustum_filter(sfm_data, z_near, z_far);
-  return frustum_filter.getFrustumIntersectionPairs();
+  Frustum_Filter::NearFarPlanesT depth_ranges;
+  for (const auto & it : frustum_filter.getNearFarPlanes())
+  {
+    if (it.second.first > 0. && it.second.first <= it.second.second)
+    {
+      depth_ranges[it.first] = {
+        it.second.first / (1. + margin), it.second.second * (1. + margin)};
+    }
+  }
+  return depth_ranges;
 }
 
 /// Compute the structure of a scene according existing camera poses.
@@ -67,6 +77,7 @@ int main(int argc, char **argv)
   std::string sSfm_data_tracks;
   double dMax_reprojection_error = 4.0;
   unsigned int ui_max_cache_size = 0;
+  unsigned int ba_partition_cluster_size = 0;
   int triangulation_method = static_cast<int>(ETriangulationMethod::DEFAULT);
 
   cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
@@ -75,6 +86,7 @@ int main(int argc, char **argv)
   cmd.add( make_option('p', sPairFile, "pair_file") );
   cmd.add( make_option('o', sOutFile, "output_file") );
   cmd.add( make_switch('b', "bundle_adjustment"));
+  cmd.add( make_option('B', ba_partition_cluster_size, "ba_cluster_size"));
   cmd.add( make_option('r', dMax_reprojection_error, "residual_threshold"));
   cmd.add( make_option('c', ui_max_cache_size, "cache_size") );
   cmd.add( make_switch('d', "direct_triangulation"));
@@ -111,6 +123,8 @@ int main(int argc, char **argv)
     << "\t" << static_cast<int>(ETriangulationMethod::INVERSE_DEPTH_WEIGHTED_MIDPOINT) << ": INVERSE_DEPTH_WEIGHTED_MIDPOINT\n"
     << "\n[Optional]\n"
     << "[-b|--bundle_adjustment] (switch) perform a bundle adjustment on the scene (OFF by default)\n"
+    << "[-B|--ba_cluster_size] split the bundle adjustment of scenes larger than N poses\n"
+    << "  into overlapping clusters of N poses (0: refine the whole scene at once, default)\n"
     << "[-r|--residual_threshold] maximal pixels reprojection error that will be considered for triangulations (4.0 by default)\n"
     << "[-c|--cache_size]\n"
     << "  Use a regions cache (only cache_size regions will be stored in memory)\n"
@@ -127,7 +141,8 @@ int main(int argc, char **argv)
 
   // Load input SfM_Data scene
   SfM_Data sfm_data;
-  if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(VIEWS|INTRINSICS|EXTRINSICS))) {
+  // The existing structure (if any) is only used to bound the scene depth
+  if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(VIEWS|INTRINSICS|EXTRINSICS|STRUCTURE))) {
     OPENMVG_LOG_ERROR << "The input SfM_Data file \""<< sSfM_Data_Filename << "\" cannot be read.";
     return EXIT_FAILURE;
   }
@@ -179,6 +194,7 @@ int main(int argc, char **argv)
 
   if (bDirect_triangulation)
   {
+    sfm_data.structure.clear();
     // Load some structure observations to triangulate
     // Either from a sfm_data file (tracks)
     // Or from a match/pair file
@@ -305,11 +321,22 @@ int main(int argc, char **argv)
     //  - putative matches guided (photometric matches)
     //     (keep pairs that have valid Intrinsic & Pose ids).
     //--
+    // Bound the epipolar search by the known scene depth range (if any)
+    const double depth_range_margin = 0.25;
+    const Frustum_Filter::NearFarPlanesT depth_ranges =
+      ComputeDepthRanges(Frustum_Filter(sfm_data), depth_range_margin);
+    OPENMVG_LOG_INFO
+      << "Depth bounded epipolar search for " << depth_ranges.size() << " views.";
+
+    // Camera frusta, truncated by the same depth ranges as the epipolar search
+    // (the views without a depth range keep an infinite frustum)
+    const Frustum_Filter frustum_filter(sfm_data, -1., -1., depth_ranges);
+
     Pair_Set pairs;
     if (sMatchFile.empty() && sPairFile.empty())
     {
       // no provided pair, use camera frustum intersection
-      pairs = BuildPairsFromFrustumsIntersections(sfm_data);
+      pairs = frustum_filter.getFrustumIntersectionPairs();
     }
     else
     {
@@ -345,7 +372,8 @@ int main(int argc, char **argv)
     //------------------------------------------
     // Compute Structure from known camera poses
     //------------------------------------------
-    SfM_Data_Structure_Estimation_From_Known_Poses structure_estimator(dMax_reprojection_error);
+    SfM_Data_Structure_Estimation_From_Known_Poses structure_estimator(
+      dMax_reprojection_error, depth_ranges);
     structure_estimator.run(sfm_data, pairs, regions_provider,
       static_cast<ETriangulationMethod>(triangulation_method));
     OPENMVG_LOG_INFO << "\nStructure estimation took (s): " << timer.elapsed() << ".";
@@ -390,8 +418,18 @@ int main(int argc, char **argv)
     }
 
     OPENMVG_LOG_INFO << "Bundle adjustment...";
-    Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
-    bundle_adjustment_obj.Adjust
+    std::unique_ptr<Bundle_Adjustment> bundle_adjustment_ptr;
+    if (ba_partition_cluster_size > 0
+        && sfm_data.GetPoses().size() > ba_partition_cluster_size)
+    {
+      bundle_adjustment_ptr.reset(new Bundle_Adjustment_Ceres_Partitioned(options,
+        Bundle_Adjustment_Ceres_Partitioned::Partition_options(ba_partition_cluster_size)));
+    }
+    else
+    {
+      bundle_adjustment_ptr.reset(new Bundle_Adjustment_Ceres(options));
+    }
+    bundle_adjustment_ptr->Adjust
       (
         sfm_data,
         Optimize_Options(
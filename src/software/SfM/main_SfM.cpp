@@ -172,6 +172,7 @@ int main(int argc, char **argv)
   std::string sIntrinsic_refinement_options = "ADJUST_ALL";
   std::string sExtrinsic_refinement_options = "ADJUST_ALL";
   bool b_use_motion_priors = false;
+  unsigned int ba_partition_cluster_size = 0;
 
   // Incremental SfM options
   int triangulation_method = static_cast<int>(ETriangulationMethod::DEFAULT);
@@ -200,6 +201,8 @@ int main(int argc, char **argv)
   cmd.add( make_option('f', sIntrinsic_refinement_options, "refine_intrinsic_config") );
   cmd.add( make_option('e', sExtrinsic_refinement_options, "refine_extrinsic_config") );
   cmd.add( make_switch('P', "prior_usage") );
+  cmd.add( make_option('B', ba_partition_cluster_size, "ba_cluster_size") );
+  cmd.add( make_switch('F', "ba_mixed_precision") );
 
   // Incremental SfM pipeline options
   cmd.add( make_option('t', triangulation_method, "triangulation_method"));
@@ -256,6 +259,12 @@ int main(int argc, char **argv)
       << "\t ADJUST_ALL -> refine all existing parameters (default) \n"
       << "\t NONE -> extrinsic parameters are held as constant\n"
       << "[-P|--prior_usage] Enable usage of motion priors (i.e GPS positions) (default: false)\n"
+      << "[-B|--ba_cluster_size] Maximal number of poses per bundle adjustment cluster\n"
+      << "\t 0 -> the whole scene is refined at once (default)\n"
+      << "\t N -> larger scenes are split into overlapping clusters of N poses\n"
+      << "\t      refined in parallel until they agree on their shared parameters\n"
+      << "[-F|--ba_mixed_precision] Use a single precision linear solver for the intermediate\n"
+      << "\t bundle adjustments of the incremental engines (the final one stays in double precision)\n"
       << "\n\n"
       << "[Engine specifics]\n"
       << "\n\n"
@@ -604,6 +613,8 @@ int main(int argc, char **argv)
   sfm_engine->Set_Intrinsics_Refinement_Type(intrinsic_refinement_options);
   sfm_engine->Set_Extrinsics_Refinement_Type(extrinsic_refinement_options);
   sfm_engine->Set_Use_Motion_Prior(b_use_motion_priors);
+  sfm_engine->Set_BA_Partition_Cluster_Size(ba_partition_cluster_size);
+  sfm_engine->Set_BA_Mixed_Precision(cmd.used('F'));
 
   //---------------------------------------
   // Sequential reconstruction process
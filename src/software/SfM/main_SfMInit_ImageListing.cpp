@@ -18,17 +18,23 @@
 #include "openMVG/sfm/sfm_view.hpp"
 #include "openMVG/sfm/sfm_view_priors.hpp"
 #include "openMVG/system/loggerprogress.hpp"
+#include "openMVG/system/timer.hpp"
 #include "openMVG/types.hpp"
 
 #include "third_party/cmdLine/cmdLine.h"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 #include "third_party/TinyEXIF/TinyEXIF.h"
 
+#include <cfloat>
 #include <fstream>
 #include <memory>
 #include <string>
 #include <utility>
 
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
 using namespace openMVG;
 using namespace openMVG::cameras;
 using namespace openMVG::exif;
@@ -65,36 +71,32 @@ bool checkIntrinsicStringValidity(const std::string & Kmatrix, double & focal, d
 
 bool getGPS
 (
-  const std::string & filename,
+  const Exif_IO & exifReader,
   const int & GPS_to_XYZ_method,
   Vec3 & pose_center
 )
 {
-  std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
-  if (exifReader)
+  // Check existence of EXIF data
+  if ( exifReader.doesHaveExifInfo() )
   {
-    // Try to parse EXIF metada & check existence of EXIF data
-    if ( exifReader->open( filename ) && exifReader->doesHaveExifInfo() )
+    // Check existence of GPS coordinates
+    double latitude, longitude, altitude;
+    if ( exifReader.GPSLatitude( &latitude ) &&
+         exifReader.GPSLongitude( &longitude ) &&
+         exifReader.GPSAltitude( &altitude ) )
     {
-      // Check existence of GPS coordinates
-      double latitude, longitude, altitude;
-      if ( exifReader->GPSLatitude( &latitude ) &&
-           exifReader->GPSLongitude( &longitude ) &&
-           exifReader->GPSAltitude( &altitude ) )
+      // Add ECEF or UTM XYZ position to the GPS position array
+      switch (GPS_to_XYZ_method)
       {
-        // Add ECEF or UTM XYZ position to the GPS position array
-        switch (GPS_to_XYZ_method)
-        {
-          case 1:
-            pose_center = lla_to_utm( latitude, longitude, altitude );
-            break;
-          case 0:
-          default:
-            pose_center = lla_to_ecef( latitude, longitude, altitude );
-            break;
-        }
-        return true;
+        case 1:
+          pose_center = lla_to_utm( latitude, longitude, altitude );
+          break;
+        case 0:
+        default:
+          pose_center = lla_to_ecef( latitude, longitude, altitude );
+          break;
       }
+      return true;
     }
   }
   return false;
@@ -102,34 +104,44 @@ bool getGPS
 
 bool getImgDirection
 (
-  const std::string & filename,
+  const Exif_IO & exifReader,
   const int & GPS_to_XYZ_method,
   Mat3 & pose_rotation
 )
 {
   if(GPS_to_XYZ_method != 1){
     //usage of Rotation data as a constrain during BA is only implemented with UTM data yet
-    OPENMVG_LOG_INFO << "Cannot use Rotation data in ECEF coordinate system (yet to be implemented)";
     return(false);
   }
-  std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
-  if (exifReader)
+  // Check existence of EXIF data
+  if ( exifReader.doesHaveExifInfo() )
   {
-    // Try to parse EXIF metada & check existence of EXIF data
-    if ( exifReader->open( filename ) && exifReader->doesHaveExifInfo() )
+    // Check existence of GPS coordinates
+    double direction;
+    if ( exifReader.GPSImgDirection( &direction ))
     {
-      // Check existence of GPS coordinates
-      double direction;
-      if ( exifReader->GPSImgDirection( &direction ))
-      {
-        //need euler to rot matrix conversion
-        pose_rotation(0,0) = direction;
-        // Add rotation to the GPS rotation array
-        return(true);
-      }
+      //need euler to rot matrix conversion
+      pose_rotation(0,0) = direction;
+      // Add rotation to the GPS rotation array
+      return(true);
     }
   }
+  return false;
+}
 
+/// Read the image direction from the XMP metadata (DJI yaw, pitch & roll).
+/// The XMP packet is not part of the EXIF segment: the file is read again.
+bool getXmpImgDirection
+(
+  const std::string & filename,
+  const int & GPS_to_XYZ_method,
+  Mat3 & pose_rotation
+)
+{
+  if(GPS_to_XYZ_method != 1){
+    //usage of Rotation data as a constrain during BA is only implemented with UTM data yet
+    return(false);
+  }
   std::ifstream stream(filename, std::ios::binary);
   if (stream) {
     // parse image EXIF and XMP metadata
@@ -174,6 +186,19 @@ std::pair<bool, Vec3> checkPriorWeightsString
   }
   return val;
 }
+
+/// Metadata retrieved for one listed image
+struct Image_Listing
+{
+  bool b_usable = false;
+  double width = -1, height = -1;
+  std::shared_ptr<IntrinsicBase> intrinsic;
+  bool has_GPS = false, has_ImgDirection = false;
+  Vec3 pose_center;
+  Mat3 pose_rotation;
+  std::string error_report;
+};
+
 //
 // Create the description of an input image dataset for OpenMVG toolsuite
 // - Export a SfM_Data file with View & Intrinsic data
@@ -200,6 +225,9 @@ int main(int argc, char **argv)
   int i_GPS_XYZ_method = 1;
 
   double focal_pixels = -1.0;
+#ifdef OPENMVG_USE_OPENMP
+  int iNumThreads = 0;
+#endif
 
   cmd.add( make_option('i', sImageDir, "imageDirectory") );
   cmd.add( make_option('d', sfileDatabase, "sensorWidthDatabase") );
@@ -212,6 +240,9 @@ int main(int argc, char **argv)
   cmd.add( make_option('w', sPriorPosWeights, "prior_position_weights"));
   cmd.add( make_option('r', sPriorRotWeights, "prior_rotation_weights"));
   cmd.add( make_option('m', i_GPS_XYZ_method, "gps_to_xyz_method") );
+#ifdef OPENMVG_USE_OPENMP
+  cmd.add( make_option('n', iNumThreads, "numThreads") );
+#endif
 
   try {
     if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -239,7 +270,11 @@ int main(int argc, char **argv)
       << "[-r|--prior_rotation_weights] Weights of the rotation prior (default: 1.0)\n"
       << "[-m|--gps_to_xyz_method] XZY Coordinate system:\n"
       << "\t 0: ECEF (default)\n"
-      << "\t 1: UTM";
+      << "\t 1: UTM\n"
+#ifdef OPENMVG_USE_OPENMP
+      << "[-n|--numThreads] number of parallel computations\n"
+#endif
+      ;
 
       OPENMVG_LOG_ERROR << s;
       return EXIT_FAILURE;
@@ -257,12 +292,18 @@ int main(int argc, char **argv)
     << "\n--use_pose_prior " << b_Use_pose_prior
     << "\n--prior_position_weights " << sPriorPosWeights
     << "\n--prior_rotation_weights " << sPriorRotWeights
-    << "\n--gps_to_xyz_method " << i_GPS_XYZ_method;
-
-  // Expected properties for each image
-  double width = -1, height = -1, focal = -1, ppx = -1,  ppy = -1;
+    << "\n--gps_to_xyz_method " << i_GPS_XYZ_method
+#ifdef OPENMVG_USE_OPENMP
+    << "\n--numThreads " << iNumThreads
+#endif
+    ;
 
   const EINTRINSIC e_User_camera_model = EINTRINSIC(i_User_camera_model);
+  if (!isValid(e_User_camera_model))
+  {
+    OPENMVG_LOG_ERROR << "Error: unknown camera model: " << (int) e_User_camera_model;
+    return EXIT_FAILURE;
+  }
 
   if ( !stlplus::folder_exists( sImageDir ) )
   {
@@ -285,8 +326,9 @@ int main(int argc, char **argv)
     }
   }
 
+  double focal_K = -1, ppx_K = -1, ppy_K = -1;
   if (sKmatrix.size() > 0 &&
-    !checkIntrinsicStringValidity(sKmatrix, focal, ppx, ppy) )
+    !checkIntrinsicStringValidity(sKmatrix, focal_K, ppx_K, ppy_K) )
   {
     OPENMVG_LOG_ERROR << "Invalid K matrix input";
     return EXIT_FAILURE;
@@ -309,6 +351,7 @@ int main(int argc, char **argv)
       return EXIT_FAILURE;
     }
   }
+  const Datasheet_Index database_index(vec_database);
 
   // Check if prior weights are given
   if (b_Use_pose_prior)
@@ -325,142 +368,180 @@ int main(int argc, char **argv)
   Views & views = sfm_data.views;
   Intrinsics & intrinsics = sfm_data.intrinsics;
 
-  system::LoggerProgress my_progress_bar(vec_image.size(), "- Listing images -" );
-  std::ostringstream error_report_stream;
-  for ( std::vector<std::string>::const_iterator iter_image = vec_image.begin();
-    iter_image != vec_image.end();
-    ++iter_image, ++my_progress_bar )
-  {
-    // Read meta data to fill camera parameter (w,h,focal,ppx,ppy) fields.
-    width = height = ppx = ppy = focal = -1.0;
-
-    const std::string sImageFilename = stlplus::create_filespec( sImageDir, *iter_image );
-    const std::string sImFilenamePart = stlplus::filename_part(sImageFilename);
+  system::Timer timer;
 
-    // Test if the image format is supported:
-    if (openMVG::image::GetFormat(sImageFilename.c_str()) == openMVG::image::Unknown)
+  // Analyze the images in parallel
+  std::vector<Image_Listing> vec_listing(vec_image.size());
+  {
+    system::LoggerProgress my_progress_bar(vec_image.size(), "- Listing images -" );
+#ifdef OPENMVG_USE_OPENMP
+    if (iNumThreads > 0)
+      omp_set_num_threads(iNumThreads);
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < static_cast<int>(vec_image.size()); ++i)
     {
-      error_report_stream
-          << sImFilenamePart << ": Unkown image file format." << "\n";
-      continue; // image cannot be opened
-    }
+      ++my_progress_bar;
+      Image_Listing & listing = vec_listing[i];
+      std::ostringstream error_report_stream;
 
-    if (sImFilenamePart.find("mask.png") != std::string::npos
-       || sImFilenamePart.find("_mask.png") != std::string::npos)
-    {
-      error_report_stream
-          << sImFilenamePart << " is a mask image" << "\n";
-      continue;
-    }
+      // Read meta data to fill camera parameter (w,h,focal,ppx,ppy) fields.
+      double width = -1, height = -1, focal = -1, ppx = -1,  ppy = -1;
 
-    ImageHeader imgHeader;
-    if (!openMVG::image::ReadImageHeader(sImageFilename.c_str(), &imgHeader))
-      continue; // image cannot be read
+      const std::string sImageFilename = stlplus::create_filespec( sImageDir, vec_image[i] );
+      const std::string sImFilenamePart = stlplus::filename_part(sImageFilename);
 
-    width = imgHeader.width;
-    height = imgHeader.height;
-    ppx = width / 2.0;
-    ppy = height / 2.0;
+      // Test if the image format is supported:
+      if (openMVG::image::GetFormat(sImageFilename.c_str()) == openMVG::image::Unknown)
+      {
+        error_report_stream
+            << sImFilenamePart << ": Unkown image file format." << "\n";
+        listing.error_report = error_report_stream.str();
+        continue; // image cannot be opened
+      }
 
+      if (sImFilenamePart.find("mask.png") != std::string::npos
+         || sImFilenamePart.find("_mask.png") != std::string::npos)
+      {
+        error_report_stream
+            << sImFilenamePart << " is a mask image" << "\n";
+        listing.error_report = error_report_stream.str();
+        continue;
+      }
 
-    // Consider the case where the focal is provided manually
-    if (sKmatrix.size() > 0) // Known user calibration K matrix
-    {
-      if (!checkIntrinsicStringValidity(sKmatrix, focal, ppx, ppy))
-        focal = -1.0;
-    }
-    else // User provided focal length value
-      if (focal_pixels != -1 )
-        focal = focal_pixels;
+      ImageHeader imgHeader;
+      if (!openMVG::image::ReadImageHeader(sImageFilename.c_str(), &imgHeader))
+        continue; // image cannot be read
 
-    // If not manually provided or wrongly provided
-    if (focal == -1)
-    {
+      width = imgHeader.width;
+      height = imgHeader.height;
+      ppx = width / 2.0;
+      ppy = height / 2.0;
+
+      // Read the EXIF metadata once (used for the focal and the pose priors)
       std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
       exifReader->open( sImageFilename );
 
-      const bool bHaveValidExifMetadata =
-        exifReader->doesHaveExifInfo()
-        && !exifReader->getModel().empty()
-        && !exifReader->getBrand().empty();
-
-      if (bHaveValidExifMetadata) // If image contains meta data
+      // Consider the case where the focal is provided manually
+      if (sKmatrix.size() > 0) // Known user calibration K matrix
       {
-        // Handle case where focal length is equal to 0
-        if (exifReader->getFocal() == 0.0f)
-        {
-          error_report_stream
-            << stlplus::basename_part(sImageFilename) << ": Focal length is missing." << "\n";
+        if (!checkIntrinsicStringValidity(sKmatrix, focal, ppx, ppy))
           focal = -1.0;
-        }
-        else
-        // Create the image entry in the list file
-        {
-          const std::string sCamModel = exifReader->getBrand() + " " + exifReader->getModel();
+      }
+      else // User provided focal length value
+        if (focal_pixels != -1 )
+          focal = focal_pixels;
 
-          Datasheet datasheet;
-          if ( getInfo( sCamModel, vec_database, datasheet ))
+      // If not manually provided or wrongly provided
+      if (focal == -1)
+      {
+        const bool bHaveValidExifMetadata =
+          exifReader->doesHaveExifInfo()
+          && !exifReader->getModel().empty()
+          && !exifReader->getBrand().empty();
+
+        if (bHaveValidExifMetadata) // If image contains meta data
+        {
+          // Handle case where focal length is equal to 0
+          if (exifReader->getFocal() == 0.0f)
           {
-            // The camera model was found in the database so we can compute it's approximated focal length
-            const double ccdw = datasheet.sensorSize_;
-            focal = std::max ( width, height ) * exifReader->getFocal() / ccdw;
+            error_report_stream
+              << stlplus::basename_part(sImageFilename) << ": Focal length is missing." << "\n";
+            focal = -1.0;
           }
           else
+          // Create the image entry in the list file
           {
-            error_report_stream
-              << stlplus::basename_part(sImageFilename)
-              << "\" model \"" << sCamModel << "\" doesn't exist in the database" << "\n"
-              << "Please consider add your camera model and sensor width in the database." << "\n";
+            const std::string sCamModel = exifReader->getBrand() + " " + exifReader->getModel();
+
+            Datasheet datasheet;
+            if ( database_index.getInfo( sCamModel, datasheet ))
+            {
+              // The camera model was found in the database so we can compute it's approximated focal length
+              const double ccdw = datasheet.sensorSize_;
+              focal = std::max ( width, height ) * exifReader->getFocal() / ccdw;
+            }
+            else
+            {
+              error_report_stream
+                << stlplus::basename_part(sImageFilename)
+                << "\" model \"" << sCamModel << "\" doesn't exist in the database" << "\n"
+                << "Please consider add your camera model and sensor width in the database." << "\n";
+            }
           }
         }
       }
-    }
-    // Build intrinsic parameter related to the view
-    std::shared_ptr<IntrinsicBase> intrinsic;
-
-    if (focal > 0 && ppx > 0 && ppy > 0 && width > 0 && height > 0)
-    {
-      // Create the desired camera type
-      switch (e_User_camera_model)
+      // Build intrinsic parameter related to the view
+      if (focal > 0 && ppx > 0 && ppy > 0 && width > 0 && height > 0)
       {
-        case PINHOLE_CAMERA:
-          intrinsic = std::make_shared<Pinhole_Intrinsic>
-            (width, height, focal, ppx, ppy);
-        break;
-        case PINHOLE_CAMERA_RADIAL1:
-          intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K1>
-            (width, height, focal, ppx, ppy, 0.0); // setup no distortion as initial guess
-        break;
-        case PINHOLE_CAMERA_RADIAL3:
-          intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K3>
-            (width, height, focal, ppx, ppy, 0.0, 0.0, 0.0);  // setup no distortion as initial guess
-        break;
-        case PINHOLE_CAMERA_BROWN:
-          intrinsic = std::make_shared<Pinhole_Intrinsic_Brown_T2>
-            (width, height, focal, ppx, ppy, 0.0, 0.0, 0.0, 0.0, 0.0); // setup no distortion as initial guess
-        break;
-        case PINHOLE_CAMERA_FISHEYE:
-          intrinsic = std::make_shared<Pinhole_Intrinsic_Fisheye>
-            (width, height, focal, ppx, ppy, 0.0, 0.0, 0.0, 0.0); // setup no distortion as initial guess
-        break;
-        case CAMERA_SPHERICAL:
-           intrinsic = std::make_shared<Intrinsic_Spherical>
-             (width, height);
-        break;
-        default:
-          OPENMVG_LOG_ERROR << "Error: unknown camera model: " << (int) e_User_camera_model;
-          return EXIT_FAILURE;
+        // Create the desired camera type
+        switch (e_User_camera_model)
+        {
+          case PINHOLE_CAMERA:
+            listing.intrinsic = std::make_shared<Pinhole_Intrinsic>
+              (width, height, focal, ppx, ppy);
+          break;
+          case PINHOLE_CAMERA_RADIAL1:
+            listing.intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K1>
+              (width, height, focal, ppx, ppy, 0.0); // setup no distortion as initial guess
+          break;
+          case PINHOLE_CAMERA_RADIAL3:
+            listing.intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K3>
+              (width, height, focal, ppx, ppy, 0.0, 0.0, 0.0);  // setup no distortion as initial guess
+          break;
+          case PINHOLE_CAMERA_BROWN:
+            listing.intrinsic = std::make_shared<Pinhole_Intrinsic_Brown_T2>
+              (width, height, focal, ppx, ppy, 0.0, 0.0, 0.0, 0.0, 0.0); // setup no distortion as initial guess
+          break;
+          case PINHOLE_CAMERA_FISHEYE:
+            listing.intrinsic = std::make_shared<Pinhole_Intrinsic_Fisheye>
+              (width, height, focal, ppx, ppy, 0.0, 0.0, 0.0, 0.0); // setup no distortion as initial guess
+          break;
+          case CAMERA_SPHERICAL:
+             listing.intrinsic = std::make_shared<Intrinsic_Spherical>
+               (width, height);
+          break;
+          default:
+            // The camera model validity is checked before the listing
+          break;
+        }
       }
+
+      // Retrieve the pose priors
+      listing.has_GPS = getGPS(*exifReader, i_GPS_XYZ_method, listing.pose_center);
+      listing.has_ImgDirection =
+        getImgDirection(*exifReader, i_GPS_XYZ_method, listing.pose_rotation)
+        || getXmpImgDirection(sImageFilename, i_GPS_XYZ_method, listing.pose_rotation);
+
+      listing.width = width;
+      listing.height = height;
+      listing.error_report = error_report_stream.str();
+      listing.b_usable = true;
     }
+  }
+
+  if (b_Use_pose_prior && i_GPS_XYZ_method != 1)
+  {
+    //usage of Rotation data as a constrain during BA is only implemented with UTM data yet
+    OPENMVG_LOG_INFO << "Cannot use Rotation data in ECEF coordinate system (yet to be implemented)";
+  }
+
+  // Create the views in the sorted image order (deterministic view ids)
+  std::ostringstream error_report_stream;
+  for (size_t i = 0; i < vec_image.size(); ++i)
+  {
+    const Image_Listing & listing = vec_listing[i];
+    error_report_stream << listing.error_report;
+    if (!listing.b_usable)
+      continue;
+
+    const double width = listing.width, height = listing.height;
+    const std::shared_ptr<IntrinsicBase> & intrinsic = listing.intrinsic;
 
     // Build the view corresponding to the image
-    Vec3 pose_center;
-    Mat3 pose_rotation;
-    bool has_GPS = getGPS(sImageFilename, i_GPS_XYZ_method, pose_center);
-    bool has_ImgDirection = getImgDirection(sImageFilename, i_GPS_XYZ_method, pose_rotation);
-    if ((has_GPS || has_ImgDirection) && b_Use_pose_prior)
+    if ((listing.has_GPS || listing.has_ImgDirection) && b_Use_pose_prior)
     {
-      ViewPriors v(*iter_image, views.size(), views.size(), views.size(), width, height);
+      ViewPriors v(vec_image[i], views.size(), views.size(), views.size(), width, height);
 
       // Add intrinsic related to the image (if any)
       if (!intrinsic)
@@ -475,20 +556,20 @@ int main(int argc, char **argv)
         intrinsics[v.id_intrinsic] = intrinsic;
       }
 
-      if(has_GPS)
+      if(listing.has_GPS)
       {
         v.b_use_pose_center_ = true;
-        v.pose_center_ = pose_center;
+        v.pose_center_ = listing.pose_center;
         // prior weights
         if (prior_w_info.first == true)
         {
           v.center_weight_ = prior_w_info.second;
         }
       }
-      if(has_ImgDirection)
+      if(listing.has_ImgDirection)
       {
         v.b_use_pose_rotation_ = true;
-        v.pose_rotation_ = pose_rotation;
+        v.pose_rotation_ = listing.pose_rotation;
         v.rotation_weight_ = sPriorRotWeights;
       }
       else {
@@ -499,7 +580,7 @@ int main(int argc, char **argv)
     }
     else
     {
-      View v(*iter_image, views.size(), views.size(), views.size(), width, height);
+      View v(vec_image[i], views.size(), views.size(), views.size(), width, height);
 
       // Add intrinsic related to the image (if any)
       if (!intrinsic)
@@ -546,7 +627,8 @@ int main(int argc, char **argv)
     << "SfMInit_ImageListing report:\n"
     << "listed #File(s): " << vec_image.size() << "\n"
     << "usable #File(s) listed in sfm_data: " << sfm_data.GetViews().size() << "\n"
-    << "usable #Intrinsic(s) listed in sfm_data: " << sfm_data.GetIntrinsics().size();
+    << "usable #Intrinsic(s) listed in sfm_data: " << sfm_data.GetIntrinsics().size() << "\n"
+    << "listing time (s): " << timer.elapsed();
 
   return EXIT_SUCCESS;
 }
@@ -135,17 +135,24 @@ int main(int argc, char **argv)
   // Select the pairs
   const Pair_Set pairs = exhaustivePairs(sfm_data.GetViews().size());
 
-  // Compute matches for a reference implementation (Brute Force L2)
+  // Compute matches for a reference implementation (Brute Force L2 or Hamming)
   // - and compare the accuracy and timing of some other method
   // - accuracy is defined as the median percentage of similar index retrieved
-  const std::vector<std::string> matcher_to_evaluate = {
-    "brute_force_l2",
-    "hnsw_l1",
-    "hnsw_l2",
-    "ann_l2",
-    "cascade_l2",
-    "fast_cascade_l2"
-  };
+  const std::vector<std::string> matcher_to_evaluate = regions_type->IsBinary() ?
+    std::vector<std::string>{
+      "brute_force_hamming",
+      "hnsw_hamming",
+      "mih_hamming"
+    }
+    : std::vector<std::string>{
+      "brute_force_l2",
+      "hnsw_l1",
+      "hnsw_l2",
+      "ann_l2",
+      "cascade_l2",
+      "fast_cascade_l2"
+    };
+  const std::string & reference_method = matcher_to_evaluate.front();
 
   OPENMVG_LOG_INFO << "Going to bench: ";
   for (const auto & method : matcher_to_evaluate)
@@ -176,11 +183,17 @@ int main(int argc, char **argv)
       collectionMatcher.reset(new Matcher_Regions(fDistRatio, CASCADE_HASHING_L2));
     else if (method == "fast_cascade_l2")
       collectionMatcher.reset(new Cascade_Hashing_Matcher_Regions(fDistRatio));
+    else if (method == "brute_force_hamming")
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, BRUTE_FORCE_HAMMING));
+    else if (method == "hnsw_hamming")
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_HAMMING));
+    else if (method == "mih_hamming")
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, MULTI_INDEX_HASHING_HAMMING));
     else
       OPENMVG_LOG_ERROR << "Invalid Regions Matcher: " << method;
 
     collected_data data;
-    if (method == "brute_force_l2") // Populate the reference matches
+    if (method == reference_method) // Populate the reference matches
     {
       system::Timer timer;
       collectionMatcher->Match(regions_provider, pairs, reference_matches, &progress);
@@ -225,7 +238,7 @@ int main(int argc, char **argv)
   {
     OPENMVG_LOG_INFO << "Method: " << method << "\n"
       << "time(seconds): " << collected_stats[method].time;
-     if (method != "brute_force_l2")
+     if (method != reference_method)
       OPENMVG_LOG_INFO << "accuracy(percent): " << collected_stats[method].accuracy;
   }
 
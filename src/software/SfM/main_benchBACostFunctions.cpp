@@ -0,0 +1,267 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Benchmark the bundle adjustment cost functions:
+// - throughput of the residual + Jacobian evaluations of the AutoDiff and
+//   the analytic cost functions of every camera model,
+// - optionally, the bundle adjustment of a SfM_Data scene with both of them,
+//   and with the mixed precision solver.
+
+#include "openMVG/cameras/cameras.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_BA.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/sfm/sfm_data_BA_mixed_precision.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::sfm;
+
+namespace
+{
+
+struct Evaluation_Sample
+{
+  Vec2 observation;
+  std::vector<double> pose;
+  std::vector<double> point;
+};
+
+// Random camera poses looking at points in front of them
+std::vector<Evaluation_Sample> RandomSamples
+(
+  const int sample_count
+)
+{
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  std::vector<Evaluation_Sample> samples(sample_count);
+  for (auto & sample : samples)
+  {
+    sample.pose = {0.3 * unit(rng), 0.3 * unit(rng), 0.3 * unit(rng),
+                   unit(rng), unit(rng), unit(rng)};
+    Mat3 R;
+    ceres::AngleAxisToRotationMatrix(sample.pose.data(), R.data());
+    const Vec3 X_cam(0.5 * unit(rng), 0.5 * unit(rng), 4.0 + unit(rng));
+    const Vec3 X = R.transpose() * (X_cam - Eigen::Map<const Vec3>(&sample.pose[3]));
+    sample.point = {X.x(), X.y(), X.z()};
+    sample.observation << 1000.0 + 100.0 * unit(rng), 750.0 + 100.0 * unit(rng);
+  }
+  return samples;
+}
+
+// Return the number of residual + Jacobian evaluations per second
+double EvaluationThroughput
+(
+  IntrinsicBase * intrinsic,
+  const std::vector<Evaluation_Sample> & samples,
+  const int repetitions,
+  const bool use_analytic_jacobian
+)
+{
+  std::vector<std::unique_ptr<ceres::CostFunction>> cost_functions;
+  cost_functions.reserve(samples.size());
+  for (const auto & sample : samples)
+    cost_functions.emplace_back(IntrinsicsToCostFunction(
+      intrinsic, sample.observation, 0.0, use_analytic_jacobian));
+
+  const bool has_intrinsic_block = intrinsic->getType() != CAMERA_SPHERICAL;
+  std::vector<double> intrinsic_params = intrinsic->getParams();
+  std::vector<double> jacobian_intrinsics(2 * std::max<size_t>(1, intrinsic_params.size()));
+  double residuals[2], jacobian_pose[2 * 6], jacobian_point[2 * 3];
+
+  double checksum = 0.0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int repetition = 0; repetition < repetitions; ++repetition)
+  {
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+      const Evaluation_Sample & sample = samples[i];
+      if (has_intrinsic_block)
+      {
+        const double * parameters[] =
+          {intrinsic_params.data(), sample.pose.data(), sample.point.data()};
+        double * jacobians[] =
+          {jacobian_intrinsics.data(), jacobian_pose, jacobian_point};
+        cost_functions[i]->Evaluate(parameters, residuals, jacobians);
+      }
+      else
+      {
+        const double * parameters[] = {sample.pose.data(), sample.point.data()};
+        double * jacobians[] = {jacobian_pose, jacobian_point};
+        cost_functions[i]->Evaluate(parameters, residuals, jacobians);
+      }
+      checksum += residuals[0] + jacobian_point[0];
+    }
+  }
+  const double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  // Use the results to keep the evaluations alive
+  if (checksum == std::numeric_limits<double>::infinity())
+    OPENMVG_LOG_INFO << checksum;
+  return (samples.size() * static_cast<double>(repetitions)) / elapsed;
+}
+
+// Root Mean Square Error of the reprojection residuals
+double RMSE(const SfM_Data & sfm_data)
+{
+  double squared_sum = 0.0;
+  size_t residual_count = 0;
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+  {
+    for (const auto & obs_it : landmark_it.second.obs)
+    {
+      const View * view = sfm_data.GetViews().at(obs_it.first).get();
+      const geometry::Pose3 pose = sfm_data.GetPoseOrDie(view);
+      const IntrinsicBase * intrinsic = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
+      squared_sum +=
+        intrinsic->residual(pose(landmark_it.second.X), obs_it.second.x).squaredNorm();
+      residual_count += 2;
+    }
+  }
+  return residual_count > 0 ? std::sqrt(squared_sum / residual_count) : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  std::string sSfM_Data_Filename;
+  int sample_count = 10000;
+  int repetitions = 100;
+
+  // optional
+  cmd.add(make_option('i', sSfM_Data_Filename, "input_file"));
+  cmd.add(make_option('n', sample_count, "sample_count"));
+  cmd.add(make_option('r', repetitions, "repetitions"));
+
+  try
+  {
+    cmd.process(argc, argv);
+  }
+  catch (const std::string &s)
+  {
+    OPENMVG_LOG_ERROR << "Usage: " << argv[0] << '\n'
+              << "--- Optional ---\n"
+              << "[-n|--sample_count] number of random observations (default 10000)\n"
+              << "[-r|--repetitions] number of evaluations per observation (default 100)\n"
+              << "[-i|--input_file] a SfM_Data scene to bundle adjust with both cost function kinds\n"
+              << "  and with the mixed precision solver.";
+    OPENMVG_LOG_ERROR << s;
+    return EXIT_FAILURE;
+  }
+
+  if (sample_count <= 0 || repetitions <= 0)
+  {
+    OPENMVG_LOG_ERROR << "Invalid sample count or repetitions.";
+    return EXIT_FAILURE;
+  }
+
+  //---------------------------------------
+  // Residual + Jacobian evaluation throughput
+  //---------------------------------------
+  const std::vector<Evaluation_Sample> samples = RandomSamples(sample_count);
+
+  std::vector<std::pair<std::string, std::shared_ptr<IntrinsicBase>>> intrinsics = {
+    {"Pinhole", std::make_shared<Pinhole_Intrinsic>(2000, 1500, 1800.0, 1000.0, 750.0)},
+    {"Pinhole_Radial_K1", std::make_shared<Pinhole_Intrinsic_Radial_K1>(
+      2000, 1500, 1800.0, 1000.0, 750.0, -0.12)},
+    {"Pinhole_Radial_K3", std::make_shared<Pinhole_Intrinsic_Radial_K3>(
+      2000, 1500, 1800.0, 1000.0, 750.0, -0.12, 0.05, -0.01)},
+    {"Pinhole_Brown_T2", std::make_shared<Pinhole_Intrinsic_Brown_T2>(
+      2000, 1500, 1800.0, 1000.0, 750.0, -0.12, 0.05, -0.01, 0.002, -0.003)},
+    {"Pinhole_Fisheye", std::make_shared<Pinhole_Intrinsic_Fisheye>(
+      2000, 1500, 1800.0, 1000.0, 750.0, -0.03, 0.01, -0.005, 0.001)},
+    {"Spherical", std::make_shared<Intrinsic_Spherical>(4000, 2000)}
+  };
+
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(2)
+    << "\nResidual + Jacobian evaluations (millions per second):\n"
+    << std::setw(20) << "Camera model" << std::setw(12) << "AutoDiff"
+    << std::setw(12) << "Analytic" << std::setw(10) << "Speedup" << "\n";
+  for (const auto & intrinsic_it : intrinsics)
+  {
+    const double autodiff_throughput = EvaluationThroughput(
+      intrinsic_it.second.get(), samples, repetitions, false);
+    const double analytic_throughput = EvaluationThroughput(
+      intrinsic_it.second.get(), samples, repetitions, true);
+    os << std::setw(20) << intrinsic_it.first
+      << std::setw(12) << autodiff_throughput / 1e6
+      << std::setw(12) << analytic_throughput / 1e6
+      << std::setw(9) << analytic_throughput / autodiff_throughput << "x\n";
+  }
+  OPENMVG_LOG_INFO << os.str();
+
+  //---------------------------------------
+  // Bundle adjustment of a real scene
+  //---------------------------------------
+  if (!sSfM_Data_Filename.empty())
+  {
+    SfM_Data sfm_data;
+    if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(ALL)))
+    {
+      OPENMVG_LOG_ERROR << "The input SfM_Data file \"" << sSfM_Data_Filename
+        << "\" cannot be read.";
+      return EXIT_FAILURE;
+    }
+
+    const Optimize_Options ba_refine_options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL);
+    OPENMVG_LOG_INFO << "Initial RMSE: " << RMSE(sfm_data);
+    for (const bool use_analytic_jacobian : {false, true})
+    {
+      SfM_Data sfm_data_to_refine = sfm_data;
+      Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options(false);
+      ceres_options.bUse_analytic_jacobians_ = use_analytic_jacobian;
+      Bundle_Adjustment_Ceres bundle_adjustment_obj(ceres_options);
+      system::Timer timer;
+      const bool b_refined =
+        bundle_adjustment_obj.Adjust(sfm_data_to_refine, ba_refine_options);
+      OPENMVG_LOG_INFO
+        << (use_analytic_jacobian ? "Analytic" : "AutoDiff")
+        << " bundle adjustment: " << (b_refined ? "converged" : "failed")
+        << " in " << timer.elapsedMs() << " ms, RMSE: " << RMSE(sfm_data_to_refine);
+    }
+    {
+      SfM_Data sfm_data_to_refine = sfm_data;
+      Bundle_Adjustment_Mixed_Precision bundle_adjustment_obj(
+        Bundle_Adjustment_Ceres::BA_Ceres_options(false));
+      system::Timer timer;
+      const bool b_refined =
+        bundle_adjustment_obj.Adjust(sfm_data_to_refine, ba_refine_options);
+      OPENMVG_LOG_INFO
+        << "Mixed precision bundle adjustment: " << (b_refined ? "converged" : "failed")
+        << " in " << timer.elapsedMs() << " ms, RMSE: " << RMSE(sfm_data_to_refine);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
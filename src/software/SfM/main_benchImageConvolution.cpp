@@ -0,0 +1,153 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Benchmark the image convolutions:
+// - Gaussian blur of a float image at the common SIFT & AKAZE sigmas with the
+//   strip based separable convolution and with the generic two pass one,
+// - construction time of the SIFT Gaussian scale space.
+
+#include "openMVG/features/sift/hierarchical_gaussian_scale_space.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_filtering.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::image;
+using namespace openMVG::features;
+
+namespace
+{
+
+// Return the best time (ms) of the given repetitions of a function
+template <typename FunctorT>
+double BestTime
+(
+  const int repetitions,
+  FunctorT && functor
+)
+{
+  double best = std::numeric_limits<double>::max();
+  for (int repetition = 0; repetition < repetitions; ++repetition)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    functor();
+    best = std::min(best, std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  int width = 5472;
+  int height = 3648;
+  int repetitions = 5;
+
+  // optional
+  cmd.add(make_option('w', width, "width"));
+  cmd.add(make_option('h', height, "height"));
+  cmd.add(make_option('r', repetitions, "repetitions"));
+
+  try
+  {
+    cmd.process(argc, argv);
+  }
+  catch (const std::string &s)
+  {
+    OPENMVG_LOG_ERROR << "Usage: " << argv[0] << '\n'
+              << "--- Optional ---\n"
+              << "[-w|--width] width of the random test image (default 5472)\n"
+              << "[-h|--height] height of the random test image (default 3648)\n"
+              << "[-r|--repetitions] number of runs per measure, the best one is kept (default 5)";
+    OPENMVG_LOG_ERROR << s;
+    return EXIT_FAILURE;
+  }
+
+  if (width <= 0 || height <= 0 || repetitions <= 0)
+  {
+    OPENMVG_LOG_ERROR << "Invalid image size or repetitions.";
+    return EXIT_FAILURE;
+  }
+
+  Image<float> image(width, height, false);
+  {
+    std::mt19937 rng(std::mt19937::default_seed);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    for (int i = 0; i < image.size(); ++i)
+      image.data()[i] = dist(rng);
+  }
+
+  //---------------------------------------
+  // Per kernel Gaussian blur
+  //---------------------------------------
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(2)
+    << "\nGaussian blur of a " << width << "x" << height << " float image (ms):\n"
+    << std::setw(8) << "Sigma" << std::setw(8) << "Kernel"
+    << std::setw(12) << "Strips" << std::setw(12) << "Two pass" << std::setw(10) << "Speedup" << "\n";
+
+  Image<float> blurred, tmp;
+  for (const double sigma : {0.8, 1.2, 1.6, 2.0, 3.2, 5.0})
+  {
+    // Same kernel as ImageGaussianFilter
+    const int kernel_size = static_cast<int>(2 * 3 * sigma + 1);
+    const Vec kernel = ComputeGaussianKernel(kernel_size, sigma);
+
+    const double strips_time = BestTime(repetitions, [&]()
+    {
+      ImageSeparableConvolution(image, kernel, kernel, blurred);
+    });
+    const double two_pass_time = BestTime(repetitions, [&]()
+    {
+      ImageHorizontalConvolution(image, kernel, tmp);
+      ImageVerticalConvolution(tmp, kernel, blurred);
+    });
+    os << std::setw(8) << sigma << std::setw(8) << kernel_size
+      << std::setw(12) << strips_time << std::setw(12) << two_pass_time
+      << std::setw(9) << two_pass_time / strips_time << "x\n";
+  }
+  OPENMVG_LOG_INFO << os.str();
+
+  //---------------------------------------
+  // SIFT Gaussian scale space construction
+  //---------------------------------------
+  for (const int first_octave : {0, -1})
+  {
+    const double scale_space_time = BestTime(repetitions, [&]()
+    {
+      HierarchicalGaussianScaleSpace octave_gen(
+        6, 3,
+        (first_octave == -1)
+        ? GaussianScaleSpaceParams(1.6f/2.0f, 1.0f/2.0f, 0.5f, 3)
+        : GaussianScaleSpaceParams(1.6f, 1.0f, 0.5f, 3));
+      octave_gen.SetImage(image);
+      Octave octave;
+      while (octave_gen.NextOctave(octave))
+      {
+      }
+    });
+    OPENMVG_LOG_INFO
+      << "SIFT Gaussian scale space (first octave " << first_octave << "): "
+      << std::fixed << std::setprecision(2) << scale_space_time << " ms";
+  }
+
+  return EXIT_SUCCESS;
+}
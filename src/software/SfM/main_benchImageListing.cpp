@@ -0,0 +1,416 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Benchmark the image metadata analysis of openMVG_main_SfMInit_ImageListing
+// on a generated folder of JPEG images with EXIF metadata:
+// - previous path: serial loop, the whole image file is read to parse the
+//   EXIF data and the sensor width database is scanned linearly,
+// - current path: parallel loop, only the EXIF segment is read
+//   (Exif_IO_EasyExif) and the sensor width database is hashed
+//   (Datasheet_Index).
+// Both paths must retrieve the same metadata.
+// Note: after the first run the images are in the OS file cache, so the I/O
+//  saving is larger on cold caches and network storage than measured here.
+
+#include "openMVG/exif/exif_IO_EasyExif.hpp"
+#include "openMVG/exif/sensor_width_database/ParseDatabase.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+#include "third_party/easyexif/exif.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace openMVG;
+using namespace openMVG::exif;
+using namespace openMVG::image;
+
+namespace
+{
+
+// Return the best time (ms) of the given repetitions of a function
+template <typename FunctorT>
+double BestTime
+(
+  const int repetitions,
+  FunctorT && functor
+)
+{
+  double best = std::numeric_limits<double>::max();
+  for (int repetition = 0; repetition < repetitions; ++repetition)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    functor();
+    best = std::min(best, std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+// Metadata retrieved for one image
+struct Image_Metadata
+{
+  int width = -1, height = -1;
+  float focal_mm = -1.f;
+  double sensor_width = -1.;
+
+  bool operator==(const Image_Metadata & rhs) const
+  {
+    return width == rhs.width && height == rhs.height
+      && focal_mm == rhs.focal_mm && sensor_width == rhs.sensor_width;
+  }
+};
+
+// Append a little endian value to a buffer
+template <typename T>
+void Append(std::vector<unsigned char> & buffer, const T value)
+{
+  for (size_t i = 0; i < sizeof(T); ++i)
+    buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+// Build an EXIF APP1 segment payload with the Make, Model and FocalLength tags
+std::vector<unsigned char> ExifSegment
+(
+  const std::string & make,
+  const std::string & model,
+  const uint32_t focal_mm_x10
+)
+{
+  // TIFF header (offsets are relative to it) and IFD0 with 3 entries
+  const uint32_t ifd0_size = 2 + 3 * 12 + 4;
+  const uint32_t sub_ifd_offset = 8 + ifd0_size;
+  const uint32_t sub_ifd_size = 2 + 1 * 12 + 4;
+  const uint32_t make_offset = sub_ifd_offset + sub_ifd_size;
+  const uint32_t model_offset = make_offset + make.size() + 1;
+  const uint32_t focal_offset = model_offset + model.size() + 1;
+
+  std::vector<unsigned char> segment = {'E', 'x', 'i', 'f', 0, 0, 'I', 'I'};
+  Append<uint16_t>(segment, 42);
+  Append<uint32_t>(segment, 8);
+  // IFD0: entries are (tag, type, count, value or offset)
+  Append<uint16_t>(segment, 3);
+  Append<uint16_t>(segment, 0x010F); Append<uint16_t>(segment, 2); // Make (ASCII)
+  Append<uint32_t>(segment, make.size() + 1); Append<uint32_t>(segment, make_offset);
+  Append<uint16_t>(segment, 0x0110); Append<uint16_t>(segment, 2); // Model (ASCII)
+  Append<uint32_t>(segment, model.size() + 1); Append<uint32_t>(segment, model_offset);
+  Append<uint16_t>(segment, 0x8769); Append<uint16_t>(segment, 4); // EXIF sub IFD (LONG)
+  Append<uint32_t>(segment, 1); Append<uint32_t>(segment, sub_ifd_offset);
+  Append<uint32_t>(segment, 0);
+  // EXIF sub IFD
+  Append<uint16_t>(segment, 1);
+  Append<uint16_t>(segment, 0x920A); Append<uint16_t>(segment, 5); // FocalLength (RATIONAL)
+  Append<uint32_t>(segment, 1); Append<uint32_t>(segment, focal_offset);
+  Append<uint32_t>(segment, 0);
+  // Data
+  segment.insert(segment.end(), make.begin(), make.end());
+  segment.push_back(0);
+  segment.insert(segment.end(), model.begin(), model.end());
+  segment.push_back(0);
+  Append<uint32_t>(segment, focal_mm_x10);
+  Append<uint32_t>(segment, 10);
+  return segment;
+}
+
+// Insert an EXIF APP1 segment right after the SOI marker of a JPEG file
+bool InsertExifSegment
+(
+  const std::string & filename,
+  const std::vector<unsigned char> & segment
+)
+{
+  std::vector<unsigned char> jpeg;
+  {
+    FILE * fp = fopen(filename.c_str(), "rb");
+    if (!fp)
+      return false;
+    unsigned char buffer[1 << 16];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+      jpeg.insert(jpeg.end(), buffer, buffer + read);
+    fclose(fp);
+  }
+  if (jpeg.size() < 2 || jpeg[0] != 0xFF || jpeg[1] != 0xD8)
+    return false;
+
+  // The segment length counts itself (Motorola byte order)
+  const size_t segment_length = segment.size() + 2;
+  const unsigned char header[4] = {0xFF, 0xE1,
+    static_cast<unsigned char>(segment_length >> 8),
+    static_cast<unsigned char>(segment_length & 0xFF)};
+  jpeg.insert(jpeg.begin() + 2, segment.begin(), segment.end());
+  jpeg.insert(jpeg.begin() + 2, header, header + 4);
+
+  FILE * fp = fopen(filename.c_str(), "wb");
+  if (!fp)
+    return false;
+  const bool bOk = fwrite(jpeg.data(), 1, jpeg.size(), fp) == jpeg.size();
+  return (fclose(fp) == 0) && bOk;
+}
+
+// Previous listing path: read the whole file for EXIF, linear database scan
+Image_Metadata AnalyzeImageWholeFile
+(
+  const std::string & filename,
+  const std::vector<Datasheet> & vec_database
+)
+{
+  Image_Metadata metadata;
+  ImageHeader imgHeader;
+  if (!ReadImageHeader(filename.c_str(), &imgHeader))
+    return metadata;
+  metadata.width = imgHeader.width;
+  metadata.height = imgHeader.height;
+
+  FILE * fp = fopen(filename.c_str(), "rb");
+  if (!fp)
+    return metadata;
+  fseek(fp, 0, SEEK_END);
+  const unsigned long fsize = ftell(fp);
+  rewind(fp);
+  std::vector<unsigned char> buf(fsize);
+  const bool bRead = fread(buf.data(), 1, fsize, fp) == fsize;
+  fclose(fp);
+
+  easyexif::EXIFInfo exif_info;
+  if (!bRead || exif_info.parseFrom(buf.data(), fsize) != PARSE_EXIF_SUCCESS)
+    return metadata;
+  metadata.focal_mm = static_cast<float>(exif_info.FocalLength);
+
+  Datasheet datasheet;
+  if (getInfo(exif_info.Make + " " + exif_info.Model, vec_database, datasheet))
+    metadata.sensor_width = datasheet.sensorSize_;
+  return metadata;
+}
+
+// Current listing path: read the EXIF segment only, hashed database lookup
+Image_Metadata AnalyzeImageExifSegment
+(
+  const std::string & filename,
+  const Datasheet_Index & database_index
+)
+{
+  Image_Metadata metadata;
+  ImageHeader imgHeader;
+  if (!ReadImageHeader(filename.c_str(), &imgHeader))
+    return metadata;
+  metadata.width = imgHeader.width;
+  metadata.height = imgHeader.height;
+
+  std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
+  if (!exifReader->open(filename))
+    return metadata;
+  metadata.focal_mm = exifReader->getFocal();
+
+  Datasheet datasheet;
+  if (database_index.getInfo(exifReader->getBrand() + " " + exifReader->getModel(), datasheet))
+    metadata.sensor_width = datasheet.sensorSize_;
+  return metadata;
+}
+
+// Remove the generated images, and their folder if it was created by the
+// benchmark, when the run ends (whatever the exit path)
+struct Generated_Images_Cleaner
+{
+  std::string folder;
+  bool b_remove_folder = false;
+  std::vector<std::string> images;
+
+  ~Generated_Images_Cleaner()
+  {
+    for (const std::string & sImage : images)
+      stlplus::file_delete(sImage);
+    if (b_remove_folder)
+      stlplus::folder_delete(folder, true);
+  }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  std::string sOutDir = "bench_image_listing";
+  std::string sfileDatabase = "";
+  int image_count = 200;
+  int width = 2000;
+  int height = 1500;
+  int repetitions = 3;
+#ifdef OPENMVG_USE_OPENMP
+  int iNumThreads = 0;
+#endif
+
+  // optional
+  cmd.add(make_option('o', sOutDir, "outdir"));
+  cmd.add(make_option('d', sfileDatabase, "sensorWidthDatabase"));
+  cmd.add(make_option('c', image_count, "count"));
+  cmd.add(make_option('w', width, "width"));
+  cmd.add(make_option('h', height, "height"));
+  cmd.add(make_option('r', repetitions, "repetitions"));
+#ifdef OPENMVG_USE_OPENMP
+  cmd.add(make_option('n', iNumThreads, "numThreads"));
+#endif
+
+  try
+  {
+    cmd.process(argc, argv);
+  }
+  catch (const std::string &s)
+  {
+    OPENMVG_LOG_ERROR << "Usage: " << argv[0] << '\n'
+              << "--- Optional ---\n"
+              << "[-o|--outdir] folder of the generated images (removed after the run, default bench_image_listing)\n"
+              << "[-d|--sensorWidthDatabase] sensor width database (default: a generated one)\n"
+              << "[-c|--count] number of generated images (default 200)\n"
+              << "[-w|--width] width of the generated images (default 2000)\n"
+              << "[-h|--height] height of the generated images (default 1500)\n"
+              << "[-r|--repetitions] number of runs per measure, the best one is kept (default 3)\n"
+#ifdef OPENMVG_USE_OPENMP
+              << "[-n|--numThreads] number of parallel computations (default: all the cores)"
+#endif
+              ;
+    OPENMVG_LOG_ERROR << s;
+    return EXIT_FAILURE;
+  }
+
+  if (image_count <= 0 || width <= 0 || height <= 0 || repetitions <= 0)
+  {
+    OPENMVG_LOG_ERROR << "Invalid image count, image size or repetitions.";
+    return EXIT_FAILURE;
+  }
+
+#ifdef OPENMVG_USE_OPENMP
+  if (iNumThreads > 0)
+    omp_set_num_threads(iNumThreads);
+#endif
+
+  //---------------------------------------
+  // Sensor width database
+  //---------------------------------------
+  std::vector<Datasheet> vec_database;
+  if (!sfileDatabase.empty())
+  {
+    if (!parseDatabase(sfileDatabase, vec_database) || vec_database.empty())
+    {
+      OPENMVG_LOG_ERROR << "Invalid input database: " << sfileDatabase;
+      return EXIT_FAILURE;
+    }
+  }
+  else
+  {
+    // About the size of the database shipped with openMVG
+    for (int i = 0; i < 7000; ++i)
+    {
+      std::ostringstream os;
+      os << "Maker" << i % 40 << " Cam-" << i;
+      vec_database.emplace_back(os.str(), 4.0 + (i % 300) * 0.1);
+    }
+  }
+  const Datasheet_Index database_index(vec_database);
+
+  //---------------------------------------
+  // Generate the images (random content, so the files have a realistic size)
+  //---------------------------------------
+  Generated_Images_Cleaner cleaner;
+  cleaner.folder = sOutDir;
+  if (!stlplus::folder_exists(sOutDir))
+  {
+    if (!stlplus::folder_create(sOutDir))
+    {
+      OPENMVG_LOG_ERROR << "Cannot create the output folder: " << sOutDir;
+      return EXIT_FAILURE;
+    }
+    cleaner.b_remove_folder = true;
+  }
+  std::vector<std::string> & vec_image = cleaner.images;
+  vec_image.resize(image_count);
+  {
+    std::mt19937 rng(std::mt19937::default_seed);
+    std::uniform_int_distribution<int> pixel_dist(0, 255);
+    Image<RGBColor> image(width, height, false);
+    for (int i = 0; i < image.size(); ++i)
+      image.data()[i] = RGBColor(pixel_dist(rng), pixel_dist(rng), pixel_dist(rng));
+
+    std::uniform_int_distribution<size_t> model_dist(0, vec_database.size() - 1);
+    for (int i = 0; i < image_count; ++i)
+    {
+      std::ostringstream os;
+      os << "image_" << std::setw(6) << std::setfill('0') << i << ".jpg";
+      vec_image[i] = stlplus::create_filespec(sOutDir, os.str());
+
+      // Use the maker & model of a random database entry
+      const std::string & camera = vec_database[model_dist(rng)].model_;
+      const size_t space = camera.find(' ');
+      const std::string make = camera.substr(0, space);
+      const std::string model = (space == std::string::npos) ? "" : camera.substr(space + 1);
+      if (!WriteImage(vec_image[i].c_str(), image)
+          || !InsertExifSegment(vec_image[i], ExifSegment(make, model, 100 + i % 400)))
+      {
+        OPENMVG_LOG_ERROR << "Cannot write the image: " << vec_image[i];
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  //---------------------------------------
+  // Metadata analysis
+  //---------------------------------------
+  std::vector<Image_Metadata> whole_file_metadata(vec_image.size());
+  const double whole_file_time = BestTime(repetitions, [&]()
+  {
+    for (size_t i = 0; i < vec_image.size(); ++i)
+      whole_file_metadata[i] = AnalyzeImageWholeFile(vec_image[i], vec_database);
+  });
+
+  std::vector<Image_Metadata> exif_segment_metadata(vec_image.size());
+  const double exif_segment_time = BestTime(repetitions, [&]()
+  {
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < static_cast<int>(vec_image.size()); ++i)
+      exif_segment_metadata[i] = AnalyzeImageExifSegment(vec_image[i], database_index);
+  });
+
+  const auto nb_found = std::count_if(exif_segment_metadata.cbegin(), exif_segment_metadata.cend(),
+    [](const Image_Metadata & metadata) { return metadata.sensor_width > 0; });
+  if (whole_file_metadata != exif_segment_metadata)
+  {
+    OPENMVG_LOG_ERROR << "The listing paths do not retrieve the same metadata.";
+    return EXIT_FAILURE;
+  }
+
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(2)
+    << "\nMetadata analysis of " << vec_image.size() << " " << width << "x" << height
+    << " JPEG images (" << nb_found << " cameras found in a database of "
+    << vec_database.size() << " entries):\n"
+    << std::setw(40) << "Whole file, linear database (ms): " << whole_file_time << "\n"
+    << std::setw(40) << "EXIF segment, hashed database (ms): " << exif_segment_time << "\n"
+    << std::setw(40) << "Speedup: " << whole_file_time / exif_segment_time << "x";
+  OPENMVG_LOG_INFO << os.str();
+
+  return EXIT_SUCCESS;
+}
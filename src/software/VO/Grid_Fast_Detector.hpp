@@ -0,0 +1,89 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef GRID_FAST_DETECTOR_VO_HPP
+#define GRID_FAST_DETECTOR_VO_HPP
+
+#include <openMVG/features/fast/fast_detector.hpp>
+#include <openMVG/features/feature.hpp>
+#include <openMVG/features/feature_container.hpp>
+#include <openMVG/image/image_container.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace openMVG  {
+namespace VO  {
+
+/// Grid bucketed FAST detection, done in a single detection pass:
+///  - the corners are detected once with a low barrier (robust to lighting change),
+///  - the image is split in cells (as many cells as requested points),
+///  - the corners are selected cell by cell by decreasing score: first the best
+///    corner of every cell, then the second best ones, ...
+/// so that the suggested points are spread over the whole image.
+inline bool DetectGridFast
+(
+  const image::Image<unsigned char> & ima,
+  std::vector<features::PointFeature> & pt_to_track,
+  const size_t count,
+  const int fast_threshold = 5
+)
+{
+  pt_to_track.clear();
+  if (count == 0)
+    return false;
+
+  features::PointFeatures feats;
+  std::vector<int> scores;
+  features::FastCornerDetector fastCornerDetector(9, fast_threshold);
+  fastCornerDetector.detect(ima, feats, scores);
+  if (feats.empty())
+    return false;
+
+  // Square cells, sized to get about one cell per requested point
+  const float cell_size = std::max(8.f,
+    std::sqrt(static_cast<float>(ima.Width()) * ima.Height() / count));
+  const int grid_width = static_cast<int>(std::ceil(ima.Width() / cell_size));
+  const auto cell_index = [&](const features::PointFeature & feat)
+  {
+    return static_cast<int>(feat.y() / cell_size) * grid_width
+      + static_cast<int>(feat.x() / cell_size);
+  };
+
+  // Rank the corners inside their cell (by decreasing score)
+  std::vector<uint32_t> order(feats.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+  {
+    const int cell_a = cell_index(feats[a]), cell_b = cell_index(feats[b]);
+    return (cell_a != cell_b) ? cell_a < cell_b : scores[a] > scores[b];
+  });
+  std::vector<uint32_t> rank(feats.size(), 0);
+  for (size_t i = 1; i < order.size(); ++i)
+  {
+    if (cell_index(feats[order[i]]) == cell_index(feats[order[i-1]]))
+      rank[order[i]] = rank[order[i-1]] + 1;
+  }
+
+  // Keep the best ranked corners, the strongest first for a given rank
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+  {
+    return (rank[a] != rank[b]) ? rank[a] < rank[b] : scores[a] > scores[b];
+  });
+  order.resize(std::min(order.size(), count));
+
+  pt_to_track.reserve(order.size());
+  for (const uint32_t i : order)
+    pt_to_track.push_back(feats[i]);
+  return pt_to_track.size() == count;
+}
+
+} // namespace VO
+} // namespace openMVG
+
+#endif // GRID_FAST_DETECTOR_VO_HPP
@@ -0,0 +1,157 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "software/VO/Grid_Fast_Detector.hpp"
+
+#include "testing/testing.h"
+
+#include <map>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+using namespace openMVG::VO;
+
+// Add a small noise (as in real images, the corner scores of the flat
+// synthetic shapes would else be equal and suppress each other)
+static void AddNoise(Image<unsigned char> & image, std::mt19937 & rng)
+{
+  std::uniform_int_distribution<int> noise_dist(-2, 2);
+  for (int i = 0; i < image.size(); ++i)
+    image.data()[i] = static_cast<unsigned char>(
+      std::min(255, std::max(0, image.data()[i] + noise_dist(rng))));
+}
+
+// Random squares on a gray background: many small squares in the left half
+// of the image (dense corners), a few large ones in the right half
+static Image<unsigned char> UnevenSquaresImage(const int width, const int height)
+{
+  Image<unsigned char> image(width, height, true, 128);
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> color_dist(0, 255);
+  const auto draw_squares = [&](const int x_min, const int x_max, const int count, const int size)
+  {
+    std::uniform_int_distribution<int> x_dist(x_min, x_max - size), y_dist(0, height - size);
+    for (int i = 0; i < count; ++i)
+    {
+      const int x0 = x_dist(rng), y0 = y_dist(rng);
+      const unsigned char color = static_cast<unsigned char>(color_dist(rng));
+      for (int y = y0; y < y0 + size; ++y)
+        for (int x = x0; x < x0 + size; ++x)
+          image(y, x) = color;
+    }
+  };
+  draw_squares(0, width / 2, 600, 5);
+  draw_squares(width / 2, width, 12, 24);
+  AddNoise(image, rng);
+  return image;
+}
+
+// Cell of a point in the grid used by DetectGridFast
+static int CellIndex
+(
+  const PointFeature & feat,
+  const Image<unsigned char> & image,
+  const size_t count
+)
+{
+  const float cell_size = std::max(8.f,
+    std::sqrt(static_cast<float>(image.Width()) * image.Height() / count));
+  const int grid_width = static_cast<int>(std::ceil(image.Width() / cell_size));
+  return static_cast<int>(feat.y() / cell_size) * grid_width
+    + static_cast<int>(feat.x() / cell_size);
+}
+
+TEST(DetectGridFast, CoverageAndCellCaps)
+{
+  const Image<unsigned char> image = UnevenSquaresImage(320, 240);
+  const size_t count = 100;
+  const int fast_threshold = 5;
+
+  // All the corners of the image
+  PointFeatures all_corners;
+  std::vector<int> scores;
+  FastCornerDetector(9, fast_threshold).detect(image, all_corners, scores);
+  EXPECT_TRUE(all_corners.size() > 2 * count);
+  std::map<int, size_t> cell_corner_count;
+  for (const auto & corner : all_corners)
+    ++cell_corner_count[CellIndex(corner, image, count)];
+  // The corners are unevenly spread (denser in the left half)
+  const auto left_count = std::count_if(all_corners.cbegin(), all_corners.cend(),
+    [&](const PointFeature & corner) { return corner.x() < image.Width() / 2; });
+  EXPECT_TRUE(left_count > 3 * (static_cast<long>(all_corners.size()) - left_count));
+
+  std::vector<PointFeature> points;
+  EXPECT_TRUE(DetectGridFast(image, points, count, fast_threshold));
+  CHECK_EQUAL(count, points.size());
+
+  std::map<int, size_t> cell_point_count;
+  for (const auto & point : points)
+    ++cell_point_count[CellIndex(point, image, count)];
+
+  // Every cell with a corner is covered before any cell gets a second point
+  const size_t max_points_per_cell = std::max_element(cell_point_count.cbegin(),
+    cell_point_count.cend(), [](const std::pair<const int, size_t> & a,
+      const std::pair<const int, size_t> & b) { return a.second < b.second; })->second;
+  for (const auto & cell : cell_corner_count)
+  {
+    const size_t nb_points = cell_point_count.count(cell.first) ? cell_point_count[cell.first] : 0;
+    EXPECT_TRUE(nb_points >= std::min(cell.second, max_points_per_cell - 1));
+  }
+  // A cell holds at most one point more than any other cell (unless it runs out of corners)
+  EXPECT_TRUE(max_points_per_cell <= count / cell_corner_count.size() + 1);
+
+  // The right half gets its share of the points, more than with the strongest corners only
+  const auto right_points = std::count_if(points.cbegin(), points.cend(),
+    [&](const PointFeature & point) { return point.x() >= image.Width() / 2; });
+  EXPECT_TRUE(right_points > 0);
+  std::vector<int> sorted_scores = scores;
+  std::sort(sorted_scores.begin(), sorted_scores.end(), std::greater<int>());
+  long right_strongest = 0;
+  for (size_t i = 0; i < all_corners.size(); ++i)
+    right_strongest += (all_corners[i].x() >= image.Width() / 2 && scores[i] > sorted_scores[count]);
+  EXPECT_TRUE(right_points >= right_strongest);
+
+  // In a cell, the points are the strongest corners of the cell
+  for (const auto & point : points)
+  {
+    const int cell = CellIndex(point, image, count);
+    int point_score = 0;
+    std::vector<int> cell_scores;
+    for (size_t i = 0; i < all_corners.size(); ++i)
+    {
+      if (CellIndex(all_corners[i], image, count) != cell)
+        continue;
+      cell_scores.push_back(scores[i]);
+      if (all_corners[i].coords() == point.coords())
+        point_score = scores[i];
+    }
+    std::sort(cell_scores.begin(), cell_scores.end(), std::greater<int>());
+    EXPECT_TRUE(point_score >= cell_scores[cell_point_count[cell] - 1]);
+  }
+}
+
+TEST(DetectGridFast, NotEnoughCorners)
+{
+  // A single square: its corners are returned, but less than requested
+  Image<unsigned char> image(64, 64, true, 50);
+  for (int y = 20; y < 40; ++y)
+    for (int x = 20; x < 40; ++x)
+      image(y, x) = 200;
+  std::mt19937 rng(0);
+  AddNoise(image, rng);
+  std::vector<PointFeature> points;
+  EXPECT_FALSE(DetectGridFast(image, points, 100));
+  EXPECT_TRUE(!points.empty() && points.size() < 100);
+
+  EXPECT_FALSE(DetectGridFast(image, points, 0));
+  EXPECT_TRUE(points.empty());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
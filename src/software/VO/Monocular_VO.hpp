@@ -87,14 +87,19 @@ struct VO_Monocular
   std::vector<features::PointFeature> pt_to_track_, pt_tracked_;
   std::vector<bool> tracking_status_;
 
+  // Log the tracking statistics of each frame
+  bool verbose_;
+
   VO_Monocular
   (
     Abstract_Tracker * tracker,
-    const uint32_t maxTrackedFeatures = 1500
+    const uint32_t maxTrackedFeatures = 1500,
+    const bool verbose = true
     // Add an abstract camera model here
   )
   : tracker_(tracker),
-  maxTrackedFeatures_(maxTrackedFeatures)
+  maxTrackedFeatures_(maxTrackedFeatures),
+  verbose_(verbose)
   {
   }
 
@@ -105,7 +110,8 @@ struct VO_Monocular
   )
   {
     const bool bTrackerStatus = tracker_->track(ima, pt_to_track_, pt_tracked_, tracking_status_);
-    std::cout << (int) bTrackerStatus  << " : tracker status" << std::endl;
+    if (verbose_)
+      std::cout << (int) bTrackerStatus  << " : tracker status" << std::endl;
     landmarkListPerFrame_.emplace_back(std::set<uint32_t>());
     if (landmarkListPerFrame_.size()==1 || bTrackerStatus)
     {
@@ -150,7 +156,8 @@ struct VO_Monocular
 
       // Count the number of tracked features
       const size_t countTracked = std::accumulate(tracking_status_.cbegin(), tracking_status_.cend(), 0);
-      std::cout << "#tracked: " << countTracked << std::endl;
+      if (verbose_)
+        std::cout << "#tracked: " << countTracked << std::endl;
 
       // try compute pose and decide if it's a Keyframe
       if (frameId > 0 && landmarkListPerFrame_.size() > 1)
@@ -162,7 +169,8 @@ struct VO_Monocular
           landmarkListPerFrame_[lastKf].cbegin(), landmarkListPerFrame_[lastKf].cend(),
           landmarkListPerFrame_[frameId].cbegin(), landmarkListPerFrame_[frameId].cend(),
           std::back_inserter(ids));
-        std::cout << "Track in common with the last Keyframe: " << ids.size() << std::endl;
+        if (verbose_)
+          std::cout << "Track in common with the last Keyframe: " << ids.size() << std::endl;
       }
 
       // Update tracking point set (if necessary)
@@ -183,7 +191,8 @@ struct VO_Monocular
         new_pt.reserve(maxTrackedFeatures_);
         if (tracker_->detect(ima, new_pt, count))
         {
-          std::cout << "#features added: " << new_pt.size() << std::endl;
+          if (verbose_)
+            std::cout << "#features added: " << new_pt.size() << std::endl;
           size_t j = 0;
           for (size_t i = 0; i < tracking_status_.size(); ++i)
           {
@@ -202,7 +211,8 @@ struct VO_Monocular
               ++j;
             }
           }
-          std::cout << "_landmark.size() " << landmark_.size() << std::endl;
+          if (verbose_)
+            std::cout << "_landmark.size() " << landmark_.size() << std::endl;
         }
       }
     }
@@ -9,6 +9,7 @@
 #ifndef TRACKER_VO_HPP
 #define TRACKER_VO_HPP
 #include <software/VO/Abstract_Tracker.hpp>
+#include <software/VO/Grid_Fast_Detector.hpp>
 #include <openMVG/features/dipole/dipole_descriptor.hpp>
 
 #include <openMVG/features/fast/fast_detector.hpp>
@@ -16,7 +17,9 @@
 #include <openMVG/features/feature_container.hpp>
 #include "openMVG/matching/metric.hpp"
 
-#include <random>
+#include <algorithm>
+#include <limits>
+#include <numeric>
 #include <vector>
 
 namespace openMVG  {
@@ -24,10 +27,13 @@ namespace VO  {
 
 // Implement tracking by description:
 //  - Each tracked point uses a local description and is tracked thanks to descriptor matching
+//    (the matching is restricted to the corners found in the point neighborhood)
 struct Tracker_fast_dipole final: public Abstract_Tracker
 {
   // data for tracking
   image::Image<unsigned char> _prev_img;
+  // maximal displacement (in pixel) of a feature between two frames
+  float search_radius_ = 50.f;
 
   /// Try to track current point set in the provided image
   /// return false when tracking failed (=> to send frame to relocalization)
@@ -59,41 +65,60 @@ struct Tracker_fast_dipole final: public Abstract_Tracker
         features::PickASDipole(ima, current_feats[i].x(), current_feats[i].y(), 10.5f, 0.0f, &current_descriptors[i*20]);
       }
 
+      // Bucket the current corners in a grid of search_radius_ sized cells,
+      // so that each tracked point is only compared to its spatial neighbors
+      const int grid_width = static_cast<int>(ima.Width() / search_radius_) + 1;
+      const int grid_height = static_cast<int>(ima.Height() / search_radius_) + 1;
+      std::vector<std::vector<uint32_t>> grid(grid_width * grid_height);
+      for (size_t j = 0; j < current_feats.size(); ++j)
+      {
+        grid[static_cast<int>(current_feats[j].y() / search_radius_) * grid_width
+          + static_cast<int>(current_feats[j].x() / search_radius_)].push_back(j);
+      }
+
       // Compute the matches
       {
+        // std::vector<bool> cannot be written concurrently
+        std::vector<unsigned char> tracked(pt_to_track.size(), 0);
+
         #ifdef OPENMVG_USE_OPENMP
         #pragma omp parallel for schedule(dynamic)
         #endif
         for (int i=0; i < (int)pt_to_track.size(); ++i)
         {
-          size_t best_idx = std::numeric_limits<size_t>::infinity();
+          size_t best_idx = std::numeric_limits<size_t>::max();
 
           typedef openMVG::matching::L2<float> metricT;
           metricT metric;
           metricT::ResultType best_distance = 30;//std::numeric_limits<double>::infinity();
-          for (size_t j=0; j < current_feats.size(); ++j)
+          const int cell_x = static_cast<int>(pt_to_track[i].x() / search_radius_);
+          const int cell_y = static_cast<int>(pt_to_track[i].y() / search_radius_);
+          for (int y = std::max(0, cell_y - 1); y <= std::min(grid_height - 1, cell_y + 1); ++y)
           {
-            // Spatial filter
-            //if ((pt_to_track[i].coords() - current_feats[j].coords()).norm() > 50)
-            //  continue; // Too much distance between the feat, it is not necessary to compute the descriptor distance
-
-            metricT::ResultType distance = metric(&prev_descriptors[i*20], &current_descriptors[j*20], 20);
-            if (distance < best_distance)
+            for (int x = std::max(0, cell_x - 1); x <= std::min(grid_width - 1, cell_x + 1); ++x)
             {
-              best_idx = j;
-              best_distance = distance;
+              for (const uint32_t j : grid[y * grid_width + x])
+              {
+                // Spatial filter
+                if ((pt_to_track[i].coords() - current_feats[j].coords()).norm() > search_radius_)
+                  continue; // Too much distance between the feat, it is not necessary to compute the descriptor distance
+
+                metricT::ResultType distance = metric(&prev_descriptors[i*20], &current_descriptors[j*20], 20);
+                if (distance < best_distance)
+                {
+                  best_idx = j;
+                  best_distance = distance;
+                }
+              }
             }
           }
-          if (best_idx != std::numeric_limits<size_t>::infinity())
+          if (best_idx != std::numeric_limits<size_t>::max())
           {
             pt_tracked[i].coords() << current_feats[best_idx].x(), current_feats[best_idx].y();
-            status[i] = true;
-          }
-          else
-          {
-            status[i] = false;
+            tracked[i] = 1;
           }
         }
+        status.assign(tracked.cbegin(), tracked.cend());
       }
     }
     // swap frame for the next tracking iteration
@@ -111,27 +136,8 @@ struct Tracker_fast_dipole final: public Abstract_Tracker
     const size_t count
   ) const override
   {
-    std::mt19937 gen(std::mt19937::default_seed);
-    const std::vector<unsigned char> scores = {30, 20, 10, 5};
-    // use a sequence of scores 'in order to deal with lighting change'
-    features::PointFeatures feats;
-    for (const unsigned char fast_score : scores)
-    {
-      features::FastCornerDetector fastCornerDetector(9, fast_score);
-      fastCornerDetector.detect(ima, feats);
-
-      if (feats.size() > count)
-      {
-        // shuffle to avoid to sample only in one bucket
-        std::shuffle(feats.begin(), feats.end(), gen);
-        feats.resize(count); // cut the array to keep only a given count of features
-        pt_to_track.swap(feats);
-
-        return true;
-      }
-      feats.clear();
-    }
-    return false; // Cannot compute a sufficient number of points for the given image
+    // single pass detection, spread over the image
+    return DetectGridFast(ima, pt_to_track, count);
   }
 };
 
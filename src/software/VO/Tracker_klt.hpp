@@ -0,0 +1,244 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TRACKER_KLT_VO_HPP
+#define TRACKER_KLT_VO_HPP
+
+#include <openMVG/features/feature.hpp>
+#include <openMVG/image/image_container.hpp>
+#include <openMVG/numeric/eigen_alias_definition.hpp>
+
+#include <software/VO/Abstract_Tracker.hpp>
+#include <software/VO/Grid_Fast_Detector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+//
+// Bibliography
+//
+// [1] Pyramidal Implementation of the Lucas Kanade Feature Tracker.
+// Author: Jean-Yves Bouguet. Intel Corporation, 2000.
+//
+
+namespace openMVG  {
+namespace VO  {
+
+/// Native pyramidal Lucas-Kanade tracker [1] (no OpenCV dependency):
+///  - each frame is stored as an image pyramid (2x2 box downsampling),
+///  - each point is tracked from the coarsest level to the finest one by
+///    iterative minimization of the window intensity difference.
+/// New points are suggested by a grid bucketed FAST detection.
+struct Tracker_KLT final : public Abstract_Tracker
+{
+  struct Options
+  {
+    int nb_levels = 3;           // Number of pyramid levels
+    int window_radius = 7;       // Tracking window is (2*radius+1)^2 pixels
+    int max_iterations = 20;     // Maximal number of iterations per level
+    float epsilon = 0.03f;       // Stop when the update is lower (in pixel)
+    float min_eigen_value = 1.f; // Minimal window texture (per pixel)
+    float max_residual = 15.f;   // Maximal mean absolute intensity residual
+    int fast_threshold = 5;      // FAST barrier used for point detection
+  };
+
+  Options options_;
+
+  // data for tracking
+  std::vector<image::Image<float>> prev_pyramid_, current_pyramid_;
+
+  Tracker_KLT() = default;
+  explicit Tracker_KLT(const Options & options): options_(options) {}
+
+  /// Try to track current point set in the provided image
+  /// return false when tracking failed (=> to send frame to relocalization)
+  bool track
+  (
+    const image::Image<unsigned char> & ima,
+    const std::vector<features::PointFeature> & pt_to_track,
+    std::vector<features::PointFeature> & pt_tracked,
+    std::vector<bool> & status
+  ) override
+  {
+    BuildPyramid(ima, current_pyramid_);
+    if (!pt_to_track.empty() && !prev_pyramid_.empty())
+    {
+      // std::vector<bool> cannot be written concurrently
+      std::vector<unsigned char> tracked(pt_to_track.size(), 0);
+
+      #ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic)
+      #endif
+      for (int i = 0; i < static_cast<int>(pt_to_track.size()); ++i)
+      {
+        Vec2f tracked_pt;
+        if (TrackPoint(pt_to_track[i].coords(), tracked_pt))
+        {
+          pt_tracked[i].coords() = tracked_pt;
+          tracked[i] = 1;
+        }
+      }
+      status.assign(tracked.cbegin(), tracked.cend());
+    }
+    // swap frame for the next tracking iteration
+    std::swap(prev_pyramid_, current_pyramid_);
+
+    const size_t tracked_point_count = std::accumulate(status.begin(), status.end(), 0);
+    return (tracked_point_count != 0);
+  }
+
+  // suggest new feature point for tracking (count point are kept)
+  bool detect
+  (
+    const image::Image<unsigned char> & ima,
+    std::vector<features::PointFeature> & pt_to_track,
+    const size_t count
+  ) const override
+  {
+    return DetectGridFast(ima, pt_to_track, count, options_.fast_threshold);
+  }
+
+private:
+
+  void BuildPyramid
+  (
+    const image::Image<unsigned char> & ima,
+    std::vector<image::Image<float>> & pyramid
+  ) const
+  {
+    const int min_size = 2 * options_.window_radius + 3;
+    pyramid.resize(1);
+    pyramid[0] = ima.GetMat().cast<float>();
+    for (int level = 1; level < options_.nb_levels; ++level)
+    {
+      const image::Image<float> & src = pyramid.back();
+      const int width = src.Width() / 2, height = src.Height() / 2;
+      if (width < min_size || height < min_size)
+        break;
+      image::Image<float> dst(width, height, false);
+      for (int y = 0; y < height; ++y)
+      {
+        const float * row0 = src.data() + (2 * y) * src.Width();
+        const float * row1 = row0 + src.Width();
+        for (int x = 0; x < width; ++x)
+        {
+          dst(y, x) = 0.25f * (row0[2*x] + row0[2*x+1] + row1[2*x] + row1[2*x+1]);
+        }
+      }
+      pyramid.emplace_back(std::move(dst));
+    }
+  }
+
+  /// Bilinear interpolation (border pixels are replicated)
+  static inline float Sample
+  (
+    const image::Image<float> & img,
+    float x,
+    float y
+  )
+  {
+    x = std::min(std::max(x, 0.f), img.Width() - 1.001f);
+    y = std::min(std::max(y, 0.f), img.Height() - 1.001f);
+    const int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    const float ax = x - x0, ay = y - y0;
+    const float * row0 = img.data() + y0 * img.Width() + x0;
+    const float * row1 = row0 + img.Width();
+    return (1.f - ay) * ((1.f - ax) * row0[0] + ax * row0[1])
+      + ay * ((1.f - ax) * row1[0] + ax * row1[1]);
+  }
+
+  /// Track a point from the previous pyramid to the current one
+  bool TrackPoint
+  (
+    const Vec2f & prev_pt,
+    Vec2f & current_pt
+  ) const
+  {
+    const int nb_levels = static_cast<int>(
+      std::min(prev_pyramid_.size(), current_pyramid_.size()));
+    const int radius = options_.window_radius;
+    const int patch_width = 2 * radius + 3; // window + a one pixel border
+    const int window_area = (2 * radius + 1) * (2 * radius + 1);
+
+    std::vector<float> patch(patch_width * patch_width);
+    std::vector<float> grad_x(window_area), grad_y(window_area);
+
+    Vec2f guess(0.f, 0.f), displacement(0.f, 0.f);
+    float residual = 0.f;
+    for (int level = nb_levels - 1; level >= 0; --level)
+    {
+      const image::Image<float> & prev = prev_pyramid_[level];
+      const image::Image<float> & current = current_pyramid_[level];
+      const Vec2f pt = prev_pt / static_cast<float>(1 << level);
+
+      // Template window and its spatial gradient
+      for (int v = 0; v < patch_width; ++v)
+        for (int u = 0; u < patch_width; ++u)
+          patch[v * patch_width + u] =
+            Sample(prev, pt(0) + u - radius - 1, pt(1) + v - radius - 1);
+
+      float gxx = 0.f, gxy = 0.f, gyy = 0.f;
+      for (int v = 1, k = 0; v < patch_width - 1; ++v)
+      {
+        for (int u = 1; u < patch_width - 1; ++u, ++k)
+        {
+          const float * p = &patch[v * patch_width + u];
+          grad_x[k] = 0.5f * (p[1] - p[-1]);
+          grad_y[k] = 0.5f * (p[patch_width] - p[-patch_width]);
+          gxx += grad_x[k] * grad_x[k];
+          gxy += grad_x[k] * grad_y[k];
+          gyy += grad_y[k] * grad_y[k];
+        }
+      }
+      const float det = gxx * gyy - gxy * gxy;
+      const float min_eigen_value =
+        (gxx + gyy - std::sqrt((gxx - gyy) * (gxx - gyy) + 4.f * gxy * gxy)) / 2.f;
+      if (min_eigen_value / window_area < options_.min_eigen_value || det <= 0.f)
+        return false;
+
+      // Iterative Lucas-Kanade refinement
+      displacement.setZero();
+      for (int iteration = 0; iteration < options_.max_iterations; ++iteration)
+      {
+        const Vec2f q = pt + guess + displacement;
+        float bx = 0.f, by = 0.f;
+        residual = 0.f;
+        for (int v = -radius, k = 0; v <= radius; ++v)
+        {
+          for (int u = -radius; u <= radius; ++u, ++k)
+          {
+            const float diff =
+              patch[(v + radius + 1) * patch_width + (u + radius + 1)]
+              - Sample(current, q(0) + u, q(1) + v);
+            bx += diff * grad_x[k];
+            by += diff * grad_y[k];
+            residual += std::abs(diff);
+          }
+        }
+        const Vec2f delta((gyy * bx - gxy * by) / det, (gxx * by - gxy * bx) / det);
+        displacement += delta;
+        if (delta.squaredNorm() < options_.epsilon * options_.epsilon)
+          break;
+      }
+      if (level > 0)
+        guess = 2.f * (guess + displacement);
+    }
+
+    current_pt = prev_pt + guess + displacement;
+    const image::Image<float> & current = current_pyramid_[0];
+    return current_pt(0) >= 0.f && current_pt(1) >= 0.f
+      && current_pt(0) <= current.Width() - 1
+      && current_pt(1) <= current.Height() - 1
+      && residual / window_area < options_.max_residual;
+  }
+};
+
+} // namespace VO
+} // namespace openMVG
+
+#endif // TRACKER_KLT_VO_HPP
@@ -0,0 +1,134 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "software/VO/Tracker_klt.hpp"
+
+#include "testing/testing.h"
+
+#include <cmath>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::VO;
+
+// Smooth random texture (sum of Gaussian blobs): it can be sampled at any
+// sub-pixel translation and it has no repetitive pattern
+struct Blob_Texture
+{
+  std::vector<Vec3> blobs; // x, y, amplitude
+
+  Blob_Texture(const int width, const int height)
+  {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> x_dist(-20.0, width + 20.0),
+      y_dist(-20.0, height + 20.0), amplitude_dist(-60.0, 60.0);
+    for (int i = 0; i < width * height / 40; ++i)
+      blobs.emplace_back(x_dist(rng), y_dist(rng), amplitude_dist(rng));
+  }
+
+  double operator()(const double x, const double y) const
+  {
+    double value = 128.0;
+    for (const Vec3 & blob : blobs)
+    {
+      const double d2 = (x - blob(0)) * (x - blob(0)) + (y - blob(1)) * (y - blob(1));
+      if (d2 < 400.0)
+        value += blob(2) * std::exp(-d2 / 32.0);
+    }
+    return value;
+  }
+};
+
+// Image of the texture translated by (tx, ty)
+static image::Image<unsigned char> TranslatedImage
+(
+  const int width,
+  const int height,
+  const double tx,
+  const double ty
+)
+{
+  const Blob_Texture texture(width, height);
+  image::Image<unsigned char> image(width, height, false);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+      image(y, x) = static_cast<unsigned char>(
+        std::min(255.0, std::max(0.0, std::round(texture(x - tx, y - ty)))));
+  return image;
+}
+
+TEST(Tracker_KLT, TranslatedImage)
+{
+  const int width = 256, height = 192;
+  // The translation is larger than the tracking window radius:
+  // it must be recovered through the pyramid levels
+  const double tx = 9.4, ty = -6.7;
+
+  std::vector<PointFeature> pt_to_track;
+  for (int y = 40; y < height - 40; y += 16)
+    for (int x = 40; x < width - 40; x += 16)
+      pt_to_track.emplace_back(x, y);
+
+  Tracker_KLT tracker;
+  std::vector<PointFeature> pt_tracked;
+  std::vector<bool> status;
+  // The first frame has no previous frame: nothing is tracked
+  EXPECT_FALSE(tracker.track(TranslatedImage(width, height, 0.0, 0.0),
+    pt_to_track, pt_tracked, status));
+
+  pt_tracked = pt_to_track;
+  EXPECT_TRUE(tracker.track(TranslatedImage(width, height, tx, ty),
+    pt_to_track, pt_tracked, status));
+  CHECK_EQUAL(pt_to_track.size(), status.size());
+  size_t nb_tracked = 0;
+  for (size_t i = 0; i < pt_to_track.size(); ++i)
+  {
+    if (!status[i])
+      continue;
+    ++nb_tracked;
+    EXPECT_NEAR(pt_to_track[i].x() + tx, pt_tracked[i].x(), 0.1);
+    EXPECT_NEAR(pt_to_track[i].y() + ty, pt_tracked[i].y(), 0.1);
+  }
+  // The texture is everywhere: (almost) every point is tracked
+  EXPECT_TRUE(nb_tracked >= 0.9 * pt_to_track.size());
+}
+
+TEST(Tracker_KLT, FlatImage)
+{
+  // A flat window cannot be tracked
+  const image::Image<unsigned char> image(128, 128, true, 100);
+  const std::vector<PointFeature> pt_to_track = {PointFeature(64.f, 64.f)};
+  std::vector<PointFeature> pt_tracked = pt_to_track;
+  std::vector<bool> status;
+  Tracker_KLT tracker;
+  tracker.track(image, pt_to_track, pt_tracked, status);
+  EXPECT_FALSE(tracker.track(image, pt_to_track, pt_tracked, status));
+  CHECK_EQUAL(1, status.size());
+  EXPECT_FALSE(status[0]);
+}
+
+TEST(Tracker_KLT, Detect)
+{
+  // The suggested points are the grid bucketed FAST corners
+  image::Image<unsigned char> image(128, 128, true, 40);
+  for (int y = 0; y < 128; ++y)
+    for (int x = 0; x < 128; ++x)
+      if (((x / 16) + (y / 16)) % 2 == 0)
+        image(y, x) = 200 + (x * 7 + y * 13) % 9;
+  Tracker_KLT tracker;
+  std::vector<PointFeature> points, grid_points;
+  tracker.detect(image, points, 20);
+  DetectGridFast(image, grid_points, 20, tracker.options_.fast_threshold);
+  EXPECT_TRUE(!points.empty());
+  CHECK_EQUAL(grid_points.size(), points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+    EXPECT_EQ(grid_points[i].coords(), points[i].coords());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -14,6 +14,7 @@
 #endif
 #include "software/VO/Monocular_VO.hpp"
 #include "software/VO/Tracker.hpp"
+#include "software/VO/Tracker_klt.hpp"
 #if defined HAVE_OPENCV
 #include "software/VO/Tracker_opencv_klt.hpp"
 #endif
@@ -58,6 +59,7 @@ int main(int argc, char **argv)
 #if defined HAVE_OPENCV
     << "\t 1: Feature tracking based tracking; Fast + KLT pyramidal tracking. \n"
 #endif
+    << "\t 2: Feature tracking based tracking; Grid Fast + native KLT pyramidal tracking. \n"
     << "[-p|--point_count] Number of points to track. (default: " << uTrackerPointCount << ")\n"
     << "[-d|--disable_tracking_display] Disable tracking display \n"
     << std::endl;
@@ -138,6 +140,9 @@ int main(int argc, char **argv)
       tracker_ptr.reset(new Tracker_opencv_KLT);
     break;
 #endif
+    case 2:
+      tracker_ptr.reset(new Tracker_KLT);
+    break;
     default:
     std::cerr << "Unknow tracking method" << std::endl;
     return EXIT_FAILURE;
@@ -0,0 +1,174 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "software/VO/Monocular_VO.hpp"
+#include "software/VO/Tracker.hpp"
+#include "software/VO/Tracker_klt.hpp"
+#if defined HAVE_OPENCV
+#include "software/VO/Tracker_opencv_klt.hpp"
+#endif
+
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+using namespace openMVG;
+
+// Headless visual odometry: track an image sequence without any display
+// and report the tracking frame rate.
+int main(int argc, char **argv)
+{
+  std::cout << "VISUAL ODOMETRY -- Headless tracking --" << std::endl;
+
+  CmdLine cmd;
+
+  std::string sImaDirectory = "";
+  std::string sOutFile = "";
+  unsigned int uTracker = 2;
+  unsigned int uTrackerPointCount = 1500;
+  unsigned int uMaxFrameCount = 0;
+
+  cmd.add( make_option('i', sImaDirectory, "imadir") );
+  cmd.add( make_option('t', uTracker, "tracker") );
+  cmd.add( make_option('o', sOutFile, "output_file") );
+  cmd.add( make_option('p', uTrackerPointCount, "point_count") );
+  cmd.add( make_option('n', uMaxFrameCount, "max_frame_count") );
+  cmd.add( make_switch('v', "verbose") );
+
+  try {
+    if (argc == 1) throw std::string("Invalid command line parameter.");
+    cmd.process(argc, argv);
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+    << "[-i|--imadir path] \n"
+    << "[-o|--output_file path] (optional) The output tracking saved as a sfm_data file (landmark observations).\n"
+    << "[-t|--tracker Used tracking interface] \n"
+    << "\t 0: Feature matching based tracking; Fast detector + Dipole descriptor, \n"
+#if defined HAVE_OPENCV
+    << "\t 1: Feature tracking based tracking; Fast + KLT pyramidal tracking. \n"
+#endif
+    << "\t 2: Feature tracking based tracking; Grid Fast + native KLT pyramidal tracking (default). \n"
+    << "[-p|--point_count] Number of points to track. (default: " << uTrackerPointCount << ")\n"
+    << "[-n|--max_frame_count] Number of processed frames (default: 0, all the frames)\n"
+    << "[-v|--verbose] Log the tracking statistics of each frame \n"
+    << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << " You called : " << std::endl
+            << argv[0] << std::endl
+            << "--imageDirectory " << sImaDirectory << std::endl
+            << "--output_file " << sOutFile << std::endl
+            << "--point_count " << uTrackerPointCount << std::endl
+            << "--tracker " << uTracker << std::endl
+            << "--max_frame_count " << uMaxFrameCount << std::endl
+            << "--verbose " << static_cast<int>(cmd.used('v')) << std::endl;
+
+  if (sImaDirectory.empty() || !stlplus::is_folder(sImaDirectory))
+  {
+    std::cerr << "\nIt is an invalid input directory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> vec_image = stlplus::folder_files(sImaDirectory);
+  // clean invalid image file
+  {
+    std::vector<std::string> vec_image_;
+    for (size_t i = 0; i < vec_image.size(); ++i)
+    {
+      if (openMVG::image::GetFormat(vec_image[i].c_str()) != openMVG::image::Unknown)
+        vec_image_.emplace_back(vec_image[i]);
+    }
+    vec_image_.swap(vec_image);
+  }
+  std::sort(vec_image.begin(), vec_image.end());
+  if (uMaxFrameCount > 0 && vec_image.size() > uMaxFrameCount)
+    vec_image.resize(uMaxFrameCount);
+
+  using namespace openMVG::VO;
+
+  // Initialize the tracker interface
+  std::unique_ptr<Abstract_Tracker> tracker_ptr;
+  switch (uTracker)
+  {
+    case 0:
+      tracker_ptr.reset(new Tracker_fast_dipole);
+    break;
+#if defined HAVE_OPENCV
+    case 1:
+      tracker_ptr.reset(new Tracker_opencv_KLT);
+    break;
+#endif
+    case 2:
+      tracker_ptr.reset(new Tracker_KLT);
+    break;
+    default:
+    std::cerr << "Unknow tracking method" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Initialize the monocular tracking framework
+  VO_Monocular monocular_vo(tracker_ptr.get(), uTrackerPointCount, cmd.used('v'));
+
+  image::Image<unsigned char> currentImage;
+  double reading_time_ms = 0.0, tracking_time_ms = 0.0;
+  size_t frame_count = 0, tracked_count = 0;
+
+  size_t frameId = 0;
+  for (std::vector<std::string>::const_iterator iterFile = vec_image.begin();
+    iterFile != vec_image.end(); ++iterFile, ++frameId)
+  {
+    const std::string sImageFilename = stlplus::create_filespec( sImaDirectory, *iterFile );
+    system::Timer timer;
+    if (!openMVG::image::ReadImage( sImageFilename.c_str(), &currentImage))
+      continue;
+    reading_time_ms += timer.elapsedMs();
+
+    timer.reset();
+    monocular_vo.nextFrame(currentImage, frameId);
+    tracking_time_ms += timer.elapsedMs();
+
+    ++frame_count;
+    tracked_count += std::accumulate(monocular_vo.tracking_status_.cbegin(),
+      monocular_vo.tracking_status_.cend(), 0);
+  }
+
+  if (frame_count == 0)
+  {
+    std::cerr << "\nNo image can be read from the input directory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "\n#frames: " << frame_count << "\n"
+    << "#landmarks: " << monocular_vo.landmark_.size() << "\n"
+    << "Mean #tracked points per frame: " << tracked_count / frame_count << "\n"
+    << "Image reading: " << reading_time_ms / frame_count << " ms/frame\n"
+    << "Tracking: " << tracking_time_ms / frame_count << " ms/frame\n"
+    << "Tracking FPS: " << 1000.0 * frame_count / tracking_time_ms << "\n"
+    << "Overall FPS (with image reading): "
+    << 1000.0 * frame_count / (tracking_time_ms + reading_time_ms) << std::endl;
+
+  if (!sOutFile.empty())
+  {
+    openMVG::sfm::SfM_Data sfm_data;
+    ConvertVOLandmarkToSfMDataLandmark(monocular_vo.landmark_, sfm_data.structure);
+    std::cout << "Found SFM #landmarks: " << sfm_data.structure.size() << std::endl;
+    if (!Save(sfm_data, sOutFile, openMVG::sfm::ESfM_Data(openMVG::sfm::ALL)))
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}